@@ -77,11 +77,205 @@
 #ifndef MCC_ENDPOINT_M4_PORT
 # define MCC_ENDPOINT_M4_PORT           (3)
 #endif
+/** @def MCC_ENDPOINT_M4_BULK_PORT
+ * @brief M4 port ID of the bulk channel (see MCC_MSG_IS_BULK). Must differ
+ *        from MCC_ENDPOINT_M4_PORT and ESL_MCFS_ENDPOINT_M4_PORT. */
+#ifndef MCC_ENDPOINT_M4_BULK_PORT
+# define MCC_ENDPOINT_M4_BULK_PORT      (4)
+#endif
+
+/** @def MCC_SIM_SOCKET_PATH
+ * @brief UNIX socket path of an endpoint (printf format of node and port)
+ *        when the M4 is simulated on a Linux host (see sim/). */
+#ifndef MCC_SIM_SOCKET_PATH
+# define MCC_SIM_SOCKET_PATH            "/tmp/easyduo_mcc_%u_%u"
+#endif
+
+//******************************************************************************
+// Framing
+//******************************************************************************
+
+#define MCC_PROTOCOL_LEGACY             (1)                                     //!< Bare messages (TMccMsg, TMccAccelStreamMsg), no header.
+#define MCC_PROTOCOL_FRAMED             (2)                                     //!< Messages prefixed by the TMccHdr fields.
+#define MCC_PROTOCOL_CHANNELS           (3)                                     //!< Framed, bulk messages sent to MCC_ENDPOINT_M4_BULK_PORT.
+#define MCC_PROTOCOL_TIMESTAMPS         (4)                                     //!< Channels, M4 capture times of the samples (see MCC_ACCEL_STREAM_TIMES).
+#define MCC_PROTOCOL_CRC                (5)                                     //!< Timestamps, optional CRC trailer (see MCC_HDR_FLAG_CRC).
+#define MCC_PROTOCOL_CREDITS            (6)                                     //!< CRC, credit-based flow control (see MCC_CREDITS_A5).
+#define MCC_PROTOCOL_HEARTBEAT          (7)                                     //!< Credits, link supervision by MCCMSG_HEARTBEAT.
+#define MCC_PROTOCOL_RAW                (8)                                     //!< Heartbeat, raw accelerometer counts (see TMccAccelRawMsg).
+#define MCC_PROTOCOL_STATS              (9)                                     //!< Raw, link statistics of the M4 (see TMccStatsMsg).
+#define MCC_PROTOCOL_READY              (10)                                    //!< Stats, MCCMSG_READY announced once the M4 tasks are initialized.
+#define MCC_PROTOCOL_ACCEL_CONFIG       (11)                                    //!< Ready, runtime accelerometer settings (MCCMSG_ACCEL_CONFIG).
+#define MCC_PROTOCOL_FILTER             (12)                                    //!< Accel config, filter chain of the subscription pushes (MCCMSG_ACCEL_FILTER).
+#define MCC_PROTOCOL_FEATURES           (13)                                    //!< Filter, vibration features computed by the M4 (MCCMSG_ACCEL_FEATURES).
+#define MCC_PROTOCOL_EVENTS             (14)                                    //!< Features, motion, freefall, transient and tap events of the sensor (MCCMSG_ACCEL_EVENTS).
+#define MCC_PROTOCOL_VERSION            MCC_PROTOCOL_EVENTS                     //!< Highest protocol version supported by this build.
+
+#define MCC_HDR_MAGIC                   (0xEDD0)                                //!< Marks a framed message (never the low half of a message type).
+#define MCC_HDR_FLAG_REPLY              (0x01)                                  //!< TMccHdr::u32Ref holds the sequence number of the request answered.
+#define MCC_HDR_FLAG_BULK               (0x02)                                  //!< Sent by the M4 bulk channel (own sequence numbering).
+#define MCC_HDR_FLAG_CRC                (0x04)                                  //!< The payload is followed by a MCC_CRC_SIZE CRC trailer (see MCC_CRC_POLYNOMIAL).
+
+/** @def MCC_HDR_PREFIX_SIZE
+ * @brief Size of the TMccHdr fields preceding the message type, i.e. the
+ *        number of bytes a framed message is longer than the bare one. */
+#define MCC_HDR_PREFIX_SIZE             (4 * sizeof(uint32_t))
+
+/** @def MCC_PREFIX_SIZE
+ * @brief Size of the header prefix used by given protocol version. */
+#define MCC_PREFIX_SIZE(ver)            (((ver) >= MCC_PROTOCOL_FRAMED) ? MCC_HDR_PREFIX_SIZE : 0)
+
+/** @def MCC_CRC_SIZE
+ * @brief Size of the CRC trailer of a framed message with MCC_HDR_FLAG_CRC
+ *        (not included in TMccHdr::u16Length). Every message body leaves
+ *        room for it in the MCC buffer. */
+#define MCC_CRC_SIZE                    (sizeof(uint32_t))
+
+/** @def MCC_CRC_POLYNOMIAL
+ * @brief The trailer is the CRC-32/MPEG-2 of the whole frame from u16Magic to
+ *        the end of the payload: this polynomial, seed 0xFFFFFFFF, bytes fed
+ *        MSB first, no reflection, no final XOR (what the Vybrid CRC engine
+ *        computes without the transposition it lacks). Stored little endian.
+ *        CRC of "123456789" is 0x0376E6E7. */
+#define MCC_CRC_POLYNOMIAL              (0x04C11DB7)
+#define MCC_CRC_SEED                    (0xFFFFFFFF)                            //!< Initial CRC value (see MCC_CRC_POLYNOMIAL).
+
+/** Header of a framed message (protocol version 2 and higher). The message
+ *  body (TMccMsg, TMccAccelStreamMsg) starts at the type member, so a framed
+ *  message is a bare one prefixed by MCC_HDR_PREFIX_SIZE bytes. The receiver
+ *  recognizes the framing by u16Magic and its payload by type; payload bytes
+ *  beyond the ones it knows are ignored, missing ones read as zero. */
+typedef struct mcc_hdr_struct {
+  uint16_t          u16Magic;                                                   //!< MCC_HDR_MAGIC.
+  uint8_t           u8Version;                                                  //!< Protocol version of the sender.
+  uint8_t           u8Flags;                                                    //!< MCC_HDR_FLAG_* bits.
+  uint16_t          u16Length;                                                  //!< Payload length in bytes (the body without type).
+  uint16_t          u16Ack;                                                     //!< Low half of u32Seq of the last message consumed from the peer on this channel (MCC_PROTOCOL_CREDITS), zero before.
+  uint32_t          u32Seq;                                                     //!< Sender sequence number, incremented by 1 per message, skipping 0.
+  uint32_t          u32Ref;                                                     //!< Sequence number of the answered request, 0 if not a reply.
+  int32_t           type;                                                       //!< Message type, the first member of the message body.
+} TMccHdr;
+
+//******************************************************************************
+// Flow control
+//******************************************************************************
+
+/** @def MCC_CREDITS_A5
+ * @brief Credit window of the A5 on each M4 channel (protocol version
+ *        MCC_PROTOCOL_CREDITS): the A5 never has more of its messages not
+ *        yet consumed by the channel task, i.e. sequence numbers beyond the
+ *        TMccHdr::u16Ack received last. Two receive buffers stay free for the
+ *        MCCMSG_CREDIT frames, which may exceed the window. The M4 gets its
+ *        push window from the MCCMSG_ACCEL_SUBSCRIBE request. */
+#define MCC_CREDITS_A5                  ((MCC_ATTR_NUM_RECEIVE_BUFFERS - 2) / 2)
+
+/** @def MCC_CREDIT_BATCH
+ * @brief Number of consumed messages a receiver acknowledges by a
+ *        MCCMSG_CREDIT frame at the latest (if it has nothing else to send
+ *        on the channel), half of given window. */
+#define MCC_CREDIT_BATCH(window)        (((window) + 1) / 2)
+
+/** @def MCC_CREDIT_IN_FLIGHT
+ * @brief Number of messages up to sequence number seq not acknowledged by
+ *        the u16Ack received last. */
+#define MCC_CREDIT_IN_FLIGHT(seq, ack)  ((uint16_t)((uint16_t)(seq) - (uint16_t)(ack)))
 
 //******************************************************************************
 // Message structure
 //******************************************************************************
 
+#define MCC_ACCEL_RATE_MIN_MHZ          (1563)                                  //!< Lowest output data rate in millihertz (1.5625 Hz).
+#define MCC_ACCEL_RATE_MAX_MHZ          (800000)                                //!< Highest output data rate in millihertz (800 Hz).
+
+#define MCC_ACCEL_OS_NORMAL             (0)                                     //!< Oversampling mode: normal (CTRL_REG2 MODS).
+#define MCC_ACCEL_OS_LNLP               (1)                                     //!< Oversampling mode: low noise low power.
+#define MCC_ACCEL_OS_HIGH_RES           (2)                                     //!< Oversampling mode: high resolution.
+#define MCC_ACCEL_OS_LOW_POWER          (3)                                     //!< Oversampling mode: low power.
+
+#define MCC_ACCEL_SET_RATE              (0x01)                                  //!< MCCMSG_ACCEL_CONFIG: change the output data rate.
+#define MCC_ACCEL_SET_RANGE             (0x02)                                  //!< MCCMSG_ACCEL_CONFIG: change the full-scale range.
+#define MCC_ACCEL_SET_OVERSAMPLING      (0x04)                                  //!< MCCMSG_ACCEL_CONFIG: change the oversampling mode.
+#define MCC_ACCEL_SET_LOW_NOISE         (0x08)                                  //!< MCCMSG_ACCEL_CONFIG: change the low noise mode.
+
+#define MCC_ACCEL_FILTER_MAX_AVERAGE    (32)                                    //!< Longest moving average of TMccAccelFilter in samples.
+
+#define MCC_ACCEL_FEATURES_MIN_LENGTH   (32)                                    //!< Shortest window of TMccAccelFeatures in samples.
+#define MCC_ACCEL_FEATURES_MAX_LENGTH   (512)                                   //!< Longest window of TMccAccelFeatures in samples.
+#define MCC_ACCEL_FEATURES_MAX_BANDS    (16)                                    //!< Most spectrum bands of TMccAccelFeatures.
+
+#define MCC_ACCEL_EVENTS_THS_MG         (63)                                    //!< Threshold step of TMccAccelEvents in milli-g (0.063 g, whatever the range).
+#define MCC_ACCEL_EVENTS_MAX_THS        (127)                                   //!< Highest threshold of TMccAccelEvents in MCC_ACCEL_EVENTS_THS_MG steps.
+
+#define MCC_ACCEL_AXIS_X                (0x01)                                  //!< TMccAccelEvents and TMccAccelEvent axis bit: X.
+#define MCC_ACCEL_AXIS_Y                (0x02)                                  //!< TMccAccelEvents and TMccAccelEvent axis bit: Y.
+#define MCC_ACCEL_AXIS_Z                (0x04)                                  //!< TMccAccelEvents and TMccAccelEvent axis bit: Z.
+#define MCC_ACCEL_AXIS_ALL              (0x07)                                  //!< All the TMccAccelEvents and TMccAccelEvent axis bits.
+
+/** Accelerometer settings changeable at runtime (MCCMSG_ACCEL_CONFIG,
+ *  protocol version MCC_PROTOCOL_ACCEL_CONFIG). A requested rate is rounded
+ *  to the nearest one of the sensor (800, 400, 200, 100, 50, 12.5, 6.25 or
+ *  1.5625 Hz), a range up to the next one of 2, 4 and 8 g. */
+typedef struct mcc_accel_config_struct {
+  uint32_t          u32RateMilliHz;                                             //!< Output data rate in millihertz (MCC_ACCEL_RATE_MIN_MHZ to MCC_ACCEL_RATE_MAX_MHZ).
+  uint8_t           u8RangeG;                                                   //!< Full-scale range in g (XYZ_DATA_CFG), replied as the one in effect (at most 4 g in the low noise mode).
+  uint8_t           u8Oversampling;                                             //!< MCC_ACCEL_OS_* oversampling mode of the ACTIVE mode.
+  uint8_t           u8LowNoise;                                                 //!< 1 for the low noise mode, which limits the usable range to 4 g.
+  uint8_t           u8Reserved;                                                 //!< Zero.
+} TMccAccelConfig;
+
+/** Filter chain of the subscription pushes (MCCMSG_ACCEL_FILTER, protocol
+ *  version MCC_PROTOCOL_FILTER). The M4 runs the raw counts of each axis
+ *  through the stages set, in this order: a 2nd order Butterworth high-pass
+ *  removing the gravity, a 2nd order Butterworth low-pass, a moving average
+ *  and the decimation; zero (or one) leaves a stage out. The biquads work in
+ *  fixed point (Q30 coefficients, 64-bit accumulator), the cutoffs are
+ *  limited to 0.45 times the output data rate. The samples pushed keep the
+ *  timestamp and time of the input sample they were computed at, the filter
+ *  delay is not compensated. */
+typedef struct mcc_accel_filter_struct {
+  uint16_t          u16HighPassCentiHz;                                         //!< High-pass cutoff in 0.01 Hz, 0 for none.
+  uint16_t          u16LowPassDeciHz;                                           //!< Low-pass cutoff in 0.1 Hz, 0 for none.
+  uint8_t           u8Average;                                                  //!< Moving average length in samples (up to MCC_ACCEL_FILTER_MAX_AVERAGE), 0 or 1 for none.
+  uint8_t           u8Decimation;                                               //!< Push every n-th filtered sample only, 0 or 1 for all.
+  uint8_t           au8Reserved[2];                                             //!< Zero.
+} TMccAccelFilter;
+
+/** Vibration features computed by the M4 (MCCMSG_ACCEL_FEATURES, protocol
+ *  version MCC_PROTOCOL_FEATURES). The accelerometer task collects the raw
+ *  counts of consecutive windows of u16Length samples and summarizes each
+ *  one per axis (see TMccAccelAxisFeatures); the M4 pushes one
+ *  MCCMSG_ACCEL_SUMMARY per window on the bulk channel instead of the
+ *  samples. The spectrum comes from a radix-2 fixed-point FFT of the Hann
+ *  windowed samples less their mean, split into u8Bands bands of equal
+ *  width from 0 to half the output data rate. A settings change, a range
+ *  change and the standby restart the window. */
+typedef struct mcc_accel_features_struct {
+  uint16_t          u16Length;                                                  //!< Window length in samples, a power of 2 from MCC_ACCEL_FEATURES_MIN_LENGTH to MCC_ACCEL_FEATURES_MAX_LENGTH, 0 for none.
+  uint8_t           u8Bands;                                                    //!< Number of spectrum bands, 1 to MCC_ACCEL_FEATURES_MAX_BANDS.
+  uint8_t           u8Reserved;                                                 //!< Zero.
+} TMccAccelFeatures;
+
+/** Motion, freefall, transient and tap detection by the embedded functions of
+ *  the sensor (MCCMSG_ACCEL_EVENTS, protocol version MCC_PROTOCOL_EVENTS).
+ *  The sensor checks every sample against the thresholds and interrupts the
+ *  accelerometer task, which reads the event sources and timestamps them;
+ *  the M4 pushes them as MCCMSG_ACCEL_EVENT on the bulk channel. Zero turns
+ *  a function off; motion and freefall share one engine, only one of them
+ *  can be set. The transient function compares the acceleration less the
+ *  gravity (the high-pass filter of the sensor), a tap is a short pulse
+ *  above the threshold (time limit, latency and window of mma845x_events.h).
+ *  The debounce is rounded to the time step of the output data rate and
+ *  oversampling mode in effect. */
+typedef struct mcc_accel_events_struct {
+  uint8_t           u8MotionThs;                                                //!< Motion: an axis of u8Axes above, in MCC_ACCEL_EVENTS_THS_MG steps (up to MCC_ACCEL_EVENTS_MAX_THS), 0 for none.
+  uint8_t           u8FreefallThs;                                              //!< Freefall: all the axes of u8Axes below, in MCC_ACCEL_EVENTS_THS_MG steps, 0 for none.
+  uint8_t           u8TransientThs;                                             //!< Transient: an axis of u8Axes less the gravity above, in MCC_ACCEL_EVENTS_THS_MG steps, 0 for none.
+  uint8_t           u8TapThs;                                                   //!< Tap: a pulse of an axis of u8Axes above, in MCC_ACCEL_EVENTS_THS_MG steps, 0 for none.
+  uint16_t          u16DebounceMs;                                              //!< Time the motion, freefall or transient condition lasts before the event, in milliseconds.
+  uint8_t           u8Axes;                                                     //!< MCC_ACCEL_AXIS_* bits of the axes watched, 0 for all.
+  uint8_t           u8DoubleTap;                                                //!< 1 to detect double taps too (u8TapThs set).
+} TMccAccelEvents;
+
 /** Multi-core communication message structure. */
 typedef struct mcc_msg_struct {
   int32_t           type;                                                       //!< Message type.
@@ -94,23 +288,520 @@ typedef struct mcc_msg_struct {
     struct {
       int32_t       iAccelType;                                                 //!< Accelerometer type ID.
     };
+    struct {
+      uint32_t      u32Since;                                                   //!< Request samples newer than this timestamp only (0 for all available).
+      uint32_t      u32MaxCount;                                                //!< Maximum number of samples to be sent back.
+    };
+    struct {
+      uint32_t      u32PeriodMs;                                                //!< Requested/granted push period in milliseconds.
+      uint32_t      u32Credits;                                                 //!< Push window granted by the subscriber (MCC_PROTOCOL_CREDITS), 0 for no limit.
+      uint32_t      u32Format;                                                  //!< Requested/granted push format (MCC_ACCEL_FORMAT_*, MCC_PROTOCOL_RAW).
+    };
+    struct {
+      uint32_t      u32Version;                                                 //!< Highest supported (request) or agreed (reply) protocol version.
+    };
+    struct {
+      uint32_t      u32PingTimeUs;                                              //!< A5 send time of the MCCMSG_PING (see TMccPingMsg).
+    };
+    struct {
+      uint32_t      u32UptimeMs;                                                //!< M4 time since its boot in milliseconds (MCCMSG_HEARTBEAT reply, MCCMSG_READY), going back means a reboot.
+    };
+    struct {
+      uint32_t      u32Channel;                                                 //!< M4 channel of the MCCMSG_STATS request (MCC_MSG_CHANNEL_*).
+    };
+    struct {
+      uint32_t      u32AccelSet;                                                //!< MCC_ACCEL_SET_* bits of the oAccelConfig settings to change, 0 to query them only.
+      TMccAccelConfig oAccelConfig;                                             //!< Requested accelerometer settings (MCCMSG_ACCEL_CONFIG).
+    };
+    struct {
+      uint32_t      u32FilterSet;                                               //!< Nonzero to replace the filter chain by oAccelFilter, 0 to query it only.
+      TMccAccelFilter oAccelFilter;                                             //!< Requested filter chain of the pushes (MCCMSG_ACCEL_FILTER).
+    };
+    struct {
+      uint32_t      u32FeaturesSet;                                             //!< Nonzero to replace the features by oAccelFeatures, 0 to query them only.
+      TMccAccelFeatures oAccelFeatures;                                         //!< Requested vibration features (MCCMSG_ACCEL_FEATURES).
+    };
+    struct {
+      uint32_t      u32EventsSet;                                               //!< Nonzero to replace the event detection by oAccelEvents, 0 to query it only.
+      TMccAccelEvents oAccelEvents;                                             //!< Requested event detection (MCCMSG_ACCEL_EVENTS).
+    };
   };
 } TMccMsg;
 
+/** @def MCC_MSG_PAYLOAD_SIZE
+ * @brief Payload size of the TMccMsg based messages. */
+#define MCC_MSG_PAYLOAD_SIZE            (sizeof(TMccMsg) - sizeof(int32_t))
+
+/** Accelerometer sample as transferred by the MCCMSG_ACCEL_STREAM message. */
+typedef struct mcc_accel_sample_struct {
+  uint32_t          u32Timestamp;                                               //!< Sample timestamp (simple increasing integer, starting from 1).
+  float             afData[3];                                                  //!< X, Y, Z-axis accelerometer data in g-force.
+} TMccAccelSample;
+
+/** @def MCC_ACCEL_STREAM_HEADER_SIZE
+ * @brief Size of the TMccAccelStreamMsg fields preceding the sample array. */
+#define MCC_ACCEL_STREAM_HEADER_SIZE    (3 * sizeof(int32_t))
+
+/** @def MCC_ACCEL_STREAM_MAX_SAMPLES
+ * @brief Number of samples fitting in one MCC buffer (framed or not). */
+#define MCC_ACCEL_STREAM_MAX_SAMPLES    ((MCC_ATTR_BUFFER_SIZE_IN_BYTES - MCC_HDR_PREFIX_SIZE - MCC_CRC_SIZE - MCC_ACCEL_STREAM_HEADER_SIZE) / sizeof(TMccAccelSample))
+
+/** @def MCC_ACCEL_STREAM_MAX_TIMED_SAMPLES
+ * @brief Number of samples fitting in one framed MCC buffer together with
+ *        their M4 times (protocol version MCC_PROTOCOL_TIMESTAMPS). */
+#define MCC_ACCEL_STREAM_MAX_TIMED_SAMPLES  ((MCC_ATTR_BUFFER_SIZE_IN_BYTES - MCC_HDR_PREFIX_SIZE - MCC_CRC_SIZE - MCC_ACCEL_STREAM_HEADER_SIZE) / (sizeof(TMccAccelSample) + sizeof(uint32_t)))
+
+/** @def MCC_ACCEL_STREAM_TIMES
+ * @brief M4 times of the samples of a TMccAccelStreamMsg in microseconds
+ *        (the TMccPingMsg time base), one uint32_t per sample following the
+ *        u32Count samples. Sent to peers of protocol version
+ *        MCC_PROTOCOL_TIMESTAMPS and higher only. */
+#define MCC_ACCEL_STREAM_TIMES(msg)     ((uint32_t*)&(msg)->aoSamples[(msg)->u32Count])
+
+/** Multi-sample accelerometer message (MCCMSG_ACCEL_STREAM reply or
+ *  MCCMSG_ACCEL_PUSH). Only
+ *  MCC_ACCEL_STREAM_HEADER_SIZE + u32Count * sizeof(TMccAccelSample) bytes
+ *  are transferred, followed by u32Count sample times for the peers knowing
+ *  them (see MCC_ACCEL_STREAM_TIMES). */
+typedef struct mcc_accel_stream_msg_struct {
+  int32_t           type;                                                       //!< Message type (MCCMSG_ACCEL_STREAM or MCCMSG_ACCEL_PUSH).
+  uint32_t          u32Count;                                                   //!< Number of valid samples in aoSamples.
+  uint32_t          u32Lost;                                                    //!< Number of requested samples already overwritten in the M4 history.
+  TMccAccelSample   aoSamples[MCC_ACCEL_STREAM_MAX_SAMPLES];                    //!< Samples, the oldest first.
+} TMccAccelStreamMsg;
+
+/** MCCMSG_ACCEL_DATA reply sent to peers of protocol version
+ *  MCC_PROTOCOL_TIMESTAMPS and higher, the older ones get the TMccMsg the
+ *  message starts with. */
+typedef struct mcc_accel_data_msg_struct {
+  int32_t           type;                                                       //!< Message type (MCCMSG_ACCEL_DATA).
+  float             afData[3];                                                  //!< X, Y, Z-axis accelerometer data in g-force (TMccMsg::fDataX...).
+  uint32_t          u32Timestamp;                                               //!< Sample timestamp (as in TMccAccelSample).
+  uint32_t          u32TimeUs;                                                  //!< M4 time of the sample in microseconds (see MCC_ACCEL_STREAM_TIMES).
+} TMccAccelDataMsg;
+
+#define MCC_ACCEL_FORMAT_FLOAT          (0)                                     //!< Pushes are MCCMSG_ACCEL_PUSH (TMccAccelStreamMsg).
+#define MCC_ACCEL_FORMAT_RAW            (1)                                     //!< Pushes are MCCMSG_ACCEL_RAW_PUSH (TMccAccelRawMsg).
+
+/** Conversion of the raw accelerometer counts of a TMccAccelRawMsg to g:
+ *  g = count / u16CountsPerG. The counts are left-justified 16-bit values as
+ *  read from the OUT_X_MSB...OUT_Z_LSB registers, the low 16 - u8Bits bits
+ *  are zero. */
+typedef struct mcc_accel_scale_struct {
+  uint16_t          u16CountsPerG;                                              //!< Counts per g (16384, 8192 or 4096 for the 2, 4 or 8 g XYZ_DATA_CFG range).
+  uint8_t           u8Bits;                                                     //!< Resolution of the counts in bits (14, 12 or 10 by the device type).
+  uint8_t           u8RangeG;                                                   //!< Usable range in g (the XYZ_DATA_CFG one, at most 4 g in the low noise mode).
+} TMccAccelScale;
+
+/** @def MCC_ACCEL_RAW_HEADER_SIZE
+ * @brief Size of the TMccAccelRawMsg fields preceding the count array. */
+#define MCC_ACCEL_RAW_HEADER_SIZE       (4 * sizeof(uint32_t) + sizeof(TMccAccelScale))
+
+/** @def MCC_ACCEL_RAW_DATA_SIZE
+ * @brief Size of count samples of TMccAccelRawMsg::ai16Data, padded to
+ *        whole uint32_t. */
+#define MCC_ACCEL_RAW_DATA_SIZE(count)  (((count) * 3 * sizeof(int16_t) + 3) & ~(size_t)3)
+
+/** @def MCC_ACCEL_RAW_SIZE
+ * @brief Size of a TMccAccelRawMsg of count samples including their times. */
+#define MCC_ACCEL_RAW_SIZE(count)       (MCC_ACCEL_RAW_HEADER_SIZE + MCC_ACCEL_RAW_DATA_SIZE(count) + (count) * sizeof(uint32_t))
+
+/** @def MCC_ACCEL_RAW_MAX_SAMPLES
+ * @brief Number of raw samples fitting in one framed MCC buffer together with
+ *        their M4 times (two bytes kept for the padding). */
+#define MCC_ACCEL_RAW_MAX_SAMPLES       ((MCC_ATTR_BUFFER_SIZE_IN_BYTES - MCC_HDR_PREFIX_SIZE - MCC_CRC_SIZE - MCC_ACCEL_RAW_HEADER_SIZE - 2) / (3 * sizeof(int16_t) + sizeof(uint32_t)))
+
+/** @def MCC_ACCEL_RAW_TIMES
+ * @brief M4 times of the samples of a TMccAccelRawMsg in microseconds (as in
+ *        MCC_ACCEL_STREAM_TIMES), one uint32_t per sample following the
+ *        padded count array. */
+#define MCC_ACCEL_RAW_TIMES(msg)        ((uint32_t*)((uint8_t*)(msg)->ai16Data + MCC_ACCEL_RAW_DATA_SIZE((msg)->u32Count)))
+
+/** Multi-sample accelerometer message carrying the raw counts
+ *  (MCCMSG_ACCEL_RAW_STREAM reply or MCCMSG_ACCEL_RAW_PUSH, protocol version
+ *  MCC_PROTOCOL_RAW), half the size of a TMccAccelStreamMsg per sample. The
+ *  samples have consecutive timestamps starting from u32First, pushes
+ *  decimated by the filter chain timestamps u32First + i * u8Decimation (see
+ *  TMccAccelFilter). Only MCC_ACCEL_RAW_SIZE(u32Count) bytes are
+ *  transferred. */
+typedef struct mcc_accel_raw_msg_struct {
+  int32_t           type;                                                       //!< Message type (MCCMSG_ACCEL_RAW_STREAM or MCCMSG_ACCEL_RAW_PUSH).
+  uint32_t          u32Count;                                                   //!< Number of valid samples in ai16Data.
+  uint32_t          u32Lost;                                                    //!< Number of requested samples already overwritten in the M4 history.
+  uint32_t          u32First;                                                   //!< Timestamp of the first sample (as in TMccAccelSample).
+  TMccAccelScale    oScale;                                                     //!< Conversion of the counts to g.
+  int16_t           ai16Data[MCC_ACCEL_RAW_MAX_SAMPLES][3];                     //!< X, Y, Z-axis counts, the oldest sample first.
+} TMccAccelRawMsg;
+
+/** @def MCC_PING_HEADER_SIZE
+ * @brief Size of the TMccPingMsg fields preceding the payload. */
+#define MCC_PING_HEADER_SIZE            (4 * sizeof(uint32_t))
+
+/** @def MCC_PING_MAX_PAYLOAD
+ * @brief Largest TMccPingMsg payload fitting in one framed MCC buffer. */
+#define MCC_PING_MAX_PAYLOAD            (MCC_ATTR_BUFFER_SIZE_IN_BYTES - MCC_HDR_PREFIX_SIZE - MCC_CRC_SIZE - MCC_PING_HEADER_SIZE)
+
+/** Link test message (MCCMSG_PING request, MCCMSG_PONG reply), framed
+ *  protocol only. The M4 replies with a message of the same size, the
+ *  payload content is not echoed. Only MCC_PING_HEADER_SIZE + payload size
+ *  bytes are transferred. The four times of an exchange let the A5 relate
+ *  the M4 time base (the one of the sample times) to its own clock. */
+typedef struct mcc_ping_msg_struct {
+  int32_t           type;                                                       //!< Message type (MCCMSG_PING or MCCMSG_PONG).
+  uint32_t          u32A5TimeUs;                                                //!< A5 time of sending the PING in microseconds, echoed in the PONG.
+  uint32_t          u32M4RxTimeUs;                                              //!< M4 time of receiving the PING in microseconds (PONG only).
+  uint32_t          u32M4TxTimeUs;                                              //!< M4 time of sending the PONG in microseconds (PONG only).
+  uint8_t           au8Payload[MCC_PING_MAX_PAYLOAD];                           //!< Arbitrary data setting the message size.
+} TMccPingMsg;
+
+#define MCC_STATS_TYPES                 (32)                                    //!< Number of per-type counters of TMccStats (MCCMSG_COUNT at most).
+#define MCC_STATS_LATENCY_BINS          (16)                                    //!< Number of bins of the TMccStats latency histogram.
+#define MCC_STATS_LATENCY_MIN_US        (8)                                     //!< Upper bound of the first latency bin in microseconds.
+
+/** Link statistics of one side, counted since its start (the M4 keeps them
+ *  per channel task). Latency bin i holds the times below
+ *  MCC_STATS_LATENCY_MIN_US << i not counted by the previous bin, the last
+ *  bin all the longer ones. All members are uint32_t. */
+typedef struct mcc_stats_struct {
+  uint32_t          au32Rx[MCC_STATS_TYPES];                                    //!< Messages received per type, unknown types counted as MCCMSG_RESERVED.
+  uint32_t          au32Tx[MCC_STATS_TYPES];                                    //!< Messages sent per type.
+  uint32_t          u32TxFailures;                                              //!< Messages the MCC library failed to send.
+  uint32_t          u32TxNoBuffer;                                              //!< Messages not sent for lack of a free MCC buffer.
+  uint32_t          u32TxNoCredit;                                              //!< Messages not sent for lack of credit (MCC_PROTOCOL_CREDITS), held back pushes on the M4.
+  uint32_t          u32RxErrors;                                                //!< Receive failures and malformed messages (but CRC mismatches).
+  uint32_t          u32RxLost;                                                  //!< Framed messages from the peer detected as lost.
+  uint32_t          u32RxReordered;                                             //!< Framed messages from the peer received out of order.
+  uint32_t          u32RxCrcErrors;                                             //!< Messages from the peer dropped for a wrong CRC.
+  uint32_t          u32ReqTimeouts;                                             //!< Requests not answered in time (A5 only).
+  uint32_t          u32QueueDepth;                                              //!< Messages waiting to be served (M4: received, A5: requests waiting for the reply), the last seen.
+  uint32_t          u32QueueMax;                                                //!< Highest u32QueueDepth.
+  uint32_t          au32Latency[MCC_STATS_LATENCY_BINS];                        //!< Histogram of the request service times (M4: reception to handler return, A5: request sent to reply received).
+} TMccStats;
+
+/** MCCMSG_STATS reply (protocol version MCC_PROTOCOL_STATS). Counters of
+ *  the channel asked for, copied while its task runs (not a consistent
+ *  snapshot). */
+typedef struct mcc_stats_msg_struct {
+  int32_t           type;                                                       //!< Message type (MCCMSG_STATS).
+  uint32_t          u32Channel;                                                 //!< M4 channel of the counters (MCC_MSG_CHANNEL_*).
+  TMccStats         oStats;                                                     //!< Counters of the channel task.
+} TMccStatsMsg;
+
+/** MCCMSG_ACCEL_CONFIG status (TMccAccelConfigMsg::i32Status). */
+enum {
+  MCC_ACCEL_CONFIG_OK             = 0,
+  MCC_ACCEL_CONFIG_INVALID,                                                     //!< A requested setting out of range, nothing changed.
+  MCC_ACCEL_CONFIG_FAILED,                                                      //!< The sensor could not be reconfigured.
+  MCC_ACCEL_CONFIG_TIMEOUT,                                                     //!< The accelerometer task did not answer in time, the change may still apply.
+};
+
+/** MCCMSG_ACCEL_CONFIG reply (protocol version MCC_PROTOCOL_ACCEL_CONFIG).
+ *  The settings in effect after the request, whether it succeeded or not. */
+typedef struct mcc_accel_config_msg_struct {
+  int32_t           type;                                                       //!< Message type (MCCMSG_ACCEL_CONFIG).
+  int32_t           i32Status;                                                  //!< MCC_ACCEL_CONFIG_OK or MCC_ACCEL_CONFIG_*.
+  TMccAccelConfig   oConfig;                                                    //!< Effective settings.
+  uint32_t          u32PeriodUs;                                                //!< Output data period in microseconds.
+  TMccAccelScale    oScale;                                                     //!< Conversion of the raw counts of the settings.
+} TMccAccelConfigMsg;
+
+/** MCCMSG_ACCEL_FILTER status (TMccAccelFilterMsg::i32Status). */
+enum {
+  MCC_ACCEL_FILTER_OK             = 0,
+  MCC_ACCEL_FILTER_INVALID,                                                     //!< A requested setting out of range, nothing changed.
+};
+
+/** MCCMSG_ACCEL_FILTER reply (protocol version MCC_PROTOCOL_FILTER). The
+ *  filter chain in effect after the request; the pushes following the reply
+ *  on the bulk channel are filtered by it. */
+typedef struct mcc_accel_filter_msg_struct {
+  int32_t           type;                                                       //!< Message type (MCCMSG_ACCEL_FILTER).
+  int32_t           i32Status;                                                  //!< MCC_ACCEL_FILTER_OK or MCC_ACCEL_FILTER_*.
+  TMccAccelFilter   oFilter;                                                    //!< Effective filter chain.
+} TMccAccelFilterMsg;
+
+/** MCCMSG_ACCEL_FEATURES status (TMccAccelFeaturesMsg::i32Status). */
+enum {
+  MCC_ACCEL_FEATURES_OK           = 0,
+  MCC_ACCEL_FEATURES_INVALID,                                                   //!< A requested setting out of range, nothing changed.
+  MCC_ACCEL_FEATURES_TIMEOUT,                                                   //!< Another change kept the accelerometer task busy, nothing changed.
+};
+
+/** MCCMSG_ACCEL_FEATURES reply (protocol version MCC_PROTOCOL_FEATURES). The
+ *  features in effect after the request, the summaries of the windows
+ *  starting after it follow them. */
+typedef struct mcc_accel_features_msg_struct {
+  int32_t           type;                                                       //!< Message type (MCCMSG_ACCEL_FEATURES).
+  int32_t           i32Status;                                                  //!< MCC_ACCEL_FEATURES_OK or MCC_ACCEL_FEATURES_*.
+  TMccAccelFeatures oFeatures;                                                  //!< Effective features.
+  uint32_t          u32PeriodUs;                                                //!< Output data period in microseconds (the window lasts u16Length periods).
+} TMccAccelFeaturesMsg;
+
+/** Features of one axis over a window, in g. Band b holds the bins of
+ *  frequencies above b and up to b + 1 times the output data rate over
+ *  2 * u8Bands; the bands are scaled for the Hann window, so that they sum
+ *  up to about fRms^2. */
+typedef struct mcc_accel_axis_features_struct {
+  float             fMean;                                                      //!< Mean of the samples (the gravity and the offset).
+  float             fRms;                                                       //!< RMS of the samples less fMean.
+  float             fPeakToPeak;                                                //!< Highest less lowest sample.
+  float             fCrest;                                                     //!< Crest factor: the largest distance of a sample from fMean over fRms, 0 if fRms is 0.
+  float             afBands[MCC_ACCEL_FEATURES_MAX_BANDS];                      //!< Mean square per band in g^2, the ones past TMccAccelFeatures::u8Bands 0.
+} TMccAccelAxisFeatures;
+
+/** Summary of one window of samples (MCCMSG_ACCEL_SUMMARY, protocol version
+ *  MCC_PROTOCOL_FEATURES), pushed while the features are set. */
+typedef struct mcc_accel_summary_msg_struct {
+  int32_t           type;                                                       //!< Message type (MCCMSG_ACCEL_SUMMARY).
+  uint32_t          u32Window;                                                  //!< Number of the window, counted by the M4 from its boot starting from 1.
+  uint32_t          u32Lost;                                                    //!< Summaries computed since the previous one sent and lost before sending.
+  uint32_t          u32First;                                                   //!< Timestamp of the first sample of the window (as in TMccAccelSample).
+  uint32_t          u32TimeUs;                                                  //!< M4 time of the first sample in microseconds (as in MCC_ACCEL_STREAM_TIMES).
+  uint32_t          u32PeriodUs;                                                //!< Output data period of the samples in microseconds.
+  TMccAccelFeatures oFeatures;                                                  //!< Window length and bands of the summary.
+  TMccAccelAxisFeatures aoAxes[3];                                              //!< X, Y, Z-axis features.
+} TMccAccelSummaryMsg;
+
+/** MCCMSG_ACCEL_EVENTS status (TMccAccelEventsMsg::i32Status). */
+enum {
+  MCC_ACCEL_EVENTS_OK             = 0,
+  MCC_ACCEL_EVENTS_INVALID,                                                     //!< A requested setting out of range, nothing changed.
+  MCC_ACCEL_EVENTS_FAILED,                                                      //!< The sensor could not be reconfigured.
+  MCC_ACCEL_EVENTS_TIMEOUT,                                                     //!< The accelerometer task did not answer in time, the change may still apply.
+};
+
+/** MCCMSG_ACCEL_EVENTS reply (protocol version MCC_PROTOCOL_EVENTS). The
+ *  detection in effect after the request (u8Axes resolved, u16DebounceMs
+ *  rounded), the events detected by it follow the reply. */
+typedef struct mcc_accel_events_msg_struct {
+  int32_t           type;                                                       //!< Message type (MCCMSG_ACCEL_EVENTS).
+  int32_t           i32Status;                                                  //!< MCC_ACCEL_EVENTS_OK or MCC_ACCEL_EVENTS_*.
+  TMccAccelEvents   oEvents;                                                    //!< Effective detection.
+} TMccAccelEventsMsg;
+
+/** Type of an event (TMccAccelEvent::u8Type). */
+enum {
+  MCC_ACCEL_EVENT_MOTION          = 1,                                          //!< An axis above the motion threshold.
+  MCC_ACCEL_EVENT_FREEFALL,                                                     //!< All the axes below the freefall threshold.
+  MCC_ACCEL_EVENT_TRANSIENT,                                                    //!< An axis less the gravity above the transient threshold.
+  MCC_ACCEL_EVENT_TAP,                                                          //!< Single tap.
+  MCC_ACCEL_EVENT_DOUBLE_TAP,                                                   //!< Double tap.
+};
+
+/** One event detected by the sensor. Its timestamp is the one of the newest
+ *  sample when the accelerometer task took the interrupt, exact to one
+ *  output data period; without the interrupt, the events are found by the
+ *  readouts and are late by up to a readout period. */
+typedef struct mcc_accel_event_struct {
+  uint32_t          u32Timestamp;                                               //!< Timestamp of the sample of the event (as in TMccAccelSample).
+  uint32_t          u32TimeUs;                                                  //!< M4 time of that sample in microseconds (as in MCC_ACCEL_STREAM_TIMES).
+  uint8_t           u8Type;                                                     //!< MCC_ACCEL_EVENT_* type.
+  uint8_t           u8Axes;                                                     //!< MCC_ACCEL_AXIS_* bits of the axes that triggered it (the ones watched for a freefall).
+  uint8_t           u8Negative;                                                 //!< MCC_ACCEL_AXIS_* bits of u8Axes in the negative direction.
+  uint8_t           u8Source;                                                   //!< Source register it was decoded from (FF_MT_SRC, TRANSIENT_SRC or PULSE_SRC).
+} TMccAccelEvent;
+
+/** @def MCC_ACCEL_EVENT_HEADER_SIZE
+ * @brief Size of the TMccAccelEventMsg fields preceding the event array. */
+#define MCC_ACCEL_EVENT_HEADER_SIZE     (4 * sizeof(int32_t))
+
+#define MCC_ACCEL_EVENT_MAX             (16)                                    //!< Most events of one MCCMSG_ACCEL_EVENT.
+
+/** Events detected (MCCMSG_ACCEL_EVENT, protocol version MCC_PROTOCOL_EVENTS),
+ *  pushed while the detection is set. Only MCC_ACCEL_EVENT_HEADER_SIZE +
+ *  u32Count * sizeof(TMccAccelEvent) bytes are transferred. */
+typedef struct mcc_accel_event_msg_struct {
+  int32_t           type;                                                       //!< Message type (MCCMSG_ACCEL_EVENT).
+  uint32_t          u32First;                                                   //!< Number of the first event, counted by the M4 from its boot starting from 1.
+  uint32_t          u32Count;                                                   //!< Number of valid events in aoEvents, numbered consecutively.
+  uint32_t          u32Lost;                                                    //!< Events detected since the previous ones sent and lost before sending.
+  TMccAccelEvent    aoEvents[MCC_ACCEL_EVENT_MAX];                              //!< Events, the oldest first.
+} TMccAccelEventMsg;
+
+/** Body of the messages without payload (MCCMSG_CREDIT, the missing reply of
+ *  the LED messages in MCC_MSG_TABLE). */
+typedef struct mcc_empty_msg_struct {
+  int32_t           type;                                                       //!< Message type.
+} TMccEmptyMsg;
+
 //******************************************************************************
-// Message values
+// Message table
 //******************************************************************************
 
-/** Multi-core communication message type. */
+/** @def MCC_MSG_TABLE
+ * @brief The messages, one X(ID, Name, channel, sender, TRequest, TReply) per
+ *        type: MCCMSG_<ID> value (the order of the rows, never to be changed),
+ *        handler name, CONTROL or BULK channel (see MCC_MSG_IS_BULK), A5 for
+ *        the requests the M4 serves or M4 for the unsolicited M4 messages,
+ *        and the bodies of the request and of the reply (TMccEmptyMsg if
+ *        none; the M4 messages have the reply only). The table generates the
+ *        message type enum, the layout checks below, the M4 dispatch table
+ *        (mcc_on<Name>) and the A5 typed messages (CMccMsgTraits); a new
+ *        message needs a row and its M4 handler. */
+#define MCC_MSG_TABLE(X)                                                                                  \
+  /* Set LED ON. */                                                                                       \
+  X(LED_ON,             LedOn,             CONTROL,  A5,  TMccMsg,      TMccEmptyMsg)                     \
+  /* Set LED OFF. */                                                                                      \
+  X(LED_OFF,            LedOff,            CONTROL,  A5,  TMccMsg,      TMccEmptyMsg)                     \
+  /* Drive LED automatically by M4. */                                                                    \
+  X(LED_AUTO,           LedAuto,           CONTROL,  A5,  TMccMsg,      TMccEmptyMsg)                     \
+  /* Request/send accelerometer identification. */                                                        \
+  X(ACCEL_INFO,         AccelInfo,         CONTROL,  A5,  TMccMsg,      TMccMsg)                          \
+  /* Request/send accelerometer data. */                                                                  \
+  X(ACCEL_DATA,         AccelData,         CONTROL,  A5,  TMccMsg,      TMccAccelDataMsg)                 \
+  /* Request/send multiple timestamped accelerometer samples. */                                          \
+  X(ACCEL_STREAM,       AccelStream,       BULK,     A5,  TMccMsg,      TMccAccelStreamMsg)               \
+  /* Request/confirm periodic pushing of accelerometer samples. */                                        \
+  X(ACCEL_SUBSCRIBE,    AccelSubscribe,    BULK,     A5,  TMccMsg,      TMccMsg)                          \
+  /* Request/confirm end of the periodic pushing. */                                                      \
+  X(ACCEL_UNSUBSCRIBE,  AccelUnsubscribe,  BULK,     A5,  TMccMsg,      TMccMsg)                          \
+  /* Unsolicited accelerometer samples sent while subscribed. */                                          \
+  X(ACCEL_PUSH,         AccelPush,         BULK,     M4,  TMccEmptyMsg, TMccAccelStreamMsg)               \
+  /* Request/confirm the protocol version (always framed). */                                             \
+  X(HELLO,              Hello,             CONTROL,  A5,  TMccMsg,      TMccMsg)                          \
+  /* Link test request, answered by MCCMSG_PONG. */                                                       \
+  X(PING,               Ping,              CONTROL,  A5,  TMccPingMsg,  TMccPingMsg)                      \
+  /* Link test reply. */                                                                                  \
+  X(PONG,               Pong,              CONTROL,  M4,  TMccEmptyMsg, TMccPingMsg)                      \
+  /* Acknowledgement only (TMccHdr::u16Ack), both ways, no reply. */                                      \
+  X(CREDIT,             Credit,            CONTROL,  A5,  TMccEmptyMsg, TMccEmptyMsg)                     \
+  /* Request/send the M4 uptime, keeps the link supervised. */                                            \
+  X(HEARTBEAT,          Heartbeat,         CONTROL,  A5,  TMccMsg,      TMccMsg)                          \
+  /* Request/send multiple accelerometer samples as raw counts. */                                        \
+  X(ACCEL_RAW_STREAM,   AccelRawStream,    BULK,     A5,  TMccMsg,      TMccAccelRawMsg)                  \
+  /* Unsolicited raw samples sent while subscribed with MCC_ACCEL_FORMAT_RAW. */                          \
+  X(ACCEL_RAW_PUSH,     AccelRawPush,      BULK,     M4,  TMccEmptyMsg, TMccAccelRawMsg)                  \
+  /* Request/send the link statistics of a M4 channel. */                                                 \
+  X(STATS,              Stats,             CONTROL,  A5,  TMccMsg,      TMccStatsMsg)                     \
+  /* Unsolicited announcement of the M4 tasks initialized, once per boot. */                              \
+  X(READY,              Ready,             CONTROL,  M4,  TMccEmptyMsg, TMccMsg)                          \
+  /* Change/read the accelerometer settings. */                                                           \
+  X(ACCEL_CONFIG,       AccelConfig,       BULK,     A5,  TMccMsg,      TMccAccelConfigMsg)               \
+  /* Change/read the filter chain of the subscription pushes. */                                          \
+  X(ACCEL_FILTER,       AccelFilter,       BULK,     A5,  TMccMsg,      TMccAccelFilterMsg)               \
+  /* Change/read the vibration features summarized by the M4. */                                          \
+  X(ACCEL_FEATURES,     AccelFeatures,     BULK,     A5,  TMccMsg,      TMccAccelFeaturesMsg)             \
+  /* Unsolicited summary of a window of samples sent while the features are set. */                       \
+  X(ACCEL_SUMMARY,      AccelSummary,      BULK,     M4,  TMccEmptyMsg, TMccAccelSummaryMsg)              \
+  /* Change/read the motion, freefall, transient and tap detection of the sensor. */                      \
+  X(ACCEL_EVENTS,       AccelEvents,       BULK,     A5,  TMccMsg,      TMccAccelEventsMsg)               \
+  /* Unsolicited events detected while the detection is set. */                                           \
+  X(ACCEL_EVENT,        AccelEvent,        BULK,     M4,  TMccEmptyMsg, TMccAccelEventMsg)
+
+#define MCC_MSG_ENUM(id, name, channel, sender, req, rep)          MCCMSG_##id,
+#define MCC_MSG_CHANNEL_CONTROL         (0)                                     //!< MCC_MSG_TABLE channel: MCC_ENDPOINT_M4_PORT.
+#define MCC_MSG_CHANNEL_BULK            (1)                                     //!< MCC_MSG_TABLE channel: MCC_ENDPOINT_M4_BULK_PORT.
+#define MCC_MSG_BULK_BIT(id, name, channel, sender, req, rep)      | ((uint32_t)MCC_MSG_CHANNEL_##channel << MCCMSG_##id)
+
+/** Multi-core communication message type (see MCC_MSG_TABLE). */
 enum {
   MCCMSG_RESERVED = 0,                                                          //!< Reserved value not to be used.
-  MCCMSG_LED_ON,                                                                //!< Set LED ON.
-  MCCMSG_LED_OFF,                                                               //!< Set LED OFF.
-  MCCMSG_LED_AUTO,                                                              //!< Drive LED automatically by M4.
-  MCCMSG_ACCEL_INFO,                                                            //!< Request/send accelerometer identification.
-  MCCMSG_ACCEL_DATA,                                                            //!< Request/send accelerometer data.
+  MCC_MSG_TABLE(MCC_MSG_ENUM)
+  MCCMSG_COUNT                                                                  //!< Number of message types (not a message).
 };
 
+/** @def MCC_MSG_BULK_MASK
+ * @brief Bit per message type set if it goes through the bulk channel. */
+#define MCC_MSG_BULK_MASK               (0 MCC_MSG_TABLE(MCC_MSG_BULK_BIT))
+
+/** @def MCC_MSG_IS_BULK
+ * @brief Nonzero if messages of given type go through the bulk channel
+ *        (protocol version MCC_PROTOCOL_CHANNELS and higher). Subscription
+ *        and pushes share the channel so that the confirmation precedes the
+ *        first push. All the other messages use the control channel, but
+ *        MCCMSG_CREDIT, which goes to the channel it acknowledges. */
+#define MCC_MSG_IS_BULK(type)           (((uint32_t)(type) < MCCMSG_COUNT) && ((MCC_MSG_BULK_MASK >> (type)) & 1))
+
+//******************************************************************************
+// Layout checks
+//******************************************************************************
+
+/** @def MCC_STATIC_ASSERT
+ * @brief Compile-time check, fails the build with an array of negative size
+ *        named after the check otherwise (C89, IAR and both compilers of the
+ *        A5 side alike). */
+#define MCC_STATIC_ASSERT(cond, name)   typedef char mcc_static_assert_##name[(cond) ? 1 : -1]
+
+/** @def MCC_MSG_MAX_BODY_SIZE
+ * @brief Largest message body (type and payload) fitting in one framed MCC
+ *        buffer with the CRC trailer. */
+#define MCC_MSG_MAX_BODY_SIZE           (MCC_ATTR_BUFFER_SIZE_IN_BYTES - MCC_HDR_PREFIX_SIZE - MCC_CRC_SIZE)
+
+#define MCC_MSG_CHECK(id, name, channel, sender, req, rep)                     \
+  MCC_STATIC_ASSERT(offsetof(req, type) == 0, id##_request_type);              \
+  MCC_STATIC_ASSERT(offsetof(rep, type) == 0, id##_reply_type);                \
+  MCC_STATIC_ASSERT(sizeof(req) <= MCC_MSG_MAX_BODY_SIZE, id##_request_size);  \
+  MCC_STATIC_ASSERT(sizeof(rep) <= MCC_MSG_MAX_BODY_SIZE, id##_reply_size);
+
+MCC_MSG_TABLE(MCC_MSG_CHECK)
+MCC_STATIC_ASSERT(MCCMSG_COUNT <= 32, msg_bulk_mask);                           // one bit each in MCC_MSG_BULK_MASK
+MCC_STATIC_ASSERT(MCCMSG_COUNT <= MCC_STATS_TYPES, stats_types);
+MCC_STATIC_ASSERT(sizeof(TMccStats) % sizeof(uint32_t) == 0, stats_words);
+MCC_STATIC_ASSERT(offsetof(TMccHdr, type) == MCC_HDR_PREFIX_SIZE, hdr_prefix);
+MCC_STATIC_ASSERT(sizeof(TMccMsg) == sizeof(int32_t) + MCC_MSG_PAYLOAD_SIZE, msg_payload);
+MCC_STATIC_ASSERT(sizeof(TMccAccelSample) == 4 * sizeof(uint32_t), accel_sample);
+MCC_STATIC_ASSERT(offsetof(TMccAccelStreamMsg, aoSamples) == MCC_ACCEL_STREAM_HEADER_SIZE, accel_stream_header);
+MCC_STATIC_ASSERT(offsetof(TMccAccelRawMsg, ai16Data) == MCC_ACCEL_RAW_HEADER_SIZE, accel_raw_header);
+MCC_STATIC_ASSERT(offsetof(TMccPingMsg, au8Payload) == MCC_PING_HEADER_SIZE, ping_header);
+MCC_STATIC_ASSERT(sizeof(TMccAccelConfig) == 2 * sizeof(uint32_t), accel_config);
+MCC_STATIC_ASSERT(sizeof(TMccAccelFilter) == 2 * sizeof(uint32_t), accel_filter);
+MCC_STATIC_ASSERT(sizeof(TMccAccelFeatures) == sizeof(uint32_t), accel_features);
+MCC_STATIC_ASSERT(sizeof(TMccAccelAxisFeatures) == (4 + MCC_ACCEL_FEATURES_MAX_BANDS) * sizeof(float), accel_axis_features);
+MCC_STATIC_ASSERT(sizeof(TMccAccelEvents) == 2 * sizeof(uint32_t), accel_events);
+MCC_STATIC_ASSERT(sizeof(TMccAccelEvent) == 3 * sizeof(uint32_t), accel_event);
+MCC_STATIC_ASSERT(offsetof(TMccAccelEventMsg, aoEvents) == MCC_ACCEL_EVENT_HEADER_SIZE, accel_event_header);
+
+//******************************************************************************
+// Shared snapshot
+//******************************************************************************
+
+/** @def MCC_SNAPSHOT_ADDRESS
+ * @brief Physical address of the TMccAccelSnapshot region. On-chip SysRAM1
+ *        right behind the 64 kB used by MCC; must stay out of both the Linux
+ *        and the M4 memory maps, and must not be cached by the M4. */
+#ifndef MCC_SNAPSHOT_ADDRESS
+# define MCC_SNAPSHOT_ADDRESS           (0x3F050000)
+#endif
+/** @def MCC_SNAPSHOT_SIZE
+ * @brief Size of the region reserved at MCC_SNAPSHOT_ADDRESS. */
+#define MCC_SNAPSHOT_SIZE               (256)
+
+/** @def MCC_SIM_SNAPSHOT_NAME
+ * @brief POSIX shared memory object standing in for the MCC_SNAPSHOT_ADDRESS
+ *        region when the M4 is simulated on a Linux host (see sim/). */
+#ifndef MCC_SIM_SNAPSHOT_NAME
+# define MCC_SIM_SNAPSHOT_NAME          "/easyduo_mcc_snapshot"
+#endif
+
+#define MCC_SNAPSHOT_MAGIC              (0xEDD05A41)                            //!< Set by the M4 once the region is initialized (changes with the layout).
+#define MCC_SNAPSHOT_FLAG_STANDBY       (0x01)                                  //!< The M4 stopped the periodic readouts (see TMccAccelSnapshot).
+
+/** @def MCC_SNAPSHOT_BARRIER
+ * @brief Memory barrier ordering the seqlock accesses to the snapshot. */
+#if defined(__ICCARM__)
+# include <intrinsics.h>
+# define MCC_SNAPSHOT_BARRIER()         __DMB()
+#else
+# define MCC_SNAPSHOT_BARRIER()         __sync_synchronize()
+#endif
+
+/** Latest accelerometer sample, written by the M4 accel_task after every
+ *  readout and read by the A5 without any message exchange. Seqlock: the M4
+ *  (the only writer) makes u32Seq odd, updates the data and makes u32Seq even
+ *  again; a reader copies the data between two reads of the same even u32Seq.
+ *  The M4 stops reading the accelerometer when nobody asks for the data (see
+ *  MCC_SNAPSHOT_FLAG_STANDBY); readers therefore increment u32ReadCnt, which
+ *  the M4 checks even in standby. */
+typedef struct mcc_accel_snapshot_struct {
+  uint32_t          u32Magic;                                                   //!< MCC_SNAPSHOT_MAGIC, anything else if the region is not valid.
+  uint32_t          u32Seq;                                                     //!< Odd while the M4 is updating the fields below.
+  uint32_t          u32Timestamp;                                               //!< Sample timestamp (as in TMccAccelSample), 0 before the first readout.
+  float             afData[3];                                                  //!< X, Y, Z-axis accelerometer data in g-force.
+  uint32_t          u32TimeUs;                                                  //!< M4 time of the sample in microseconds (see MCC_ACCEL_STREAM_TIMES).
+  uint32_t          u32Flags;                                                   //!< MCC_SNAPSHOT_FLAG_* bits.
+  uint32_t          u32ReadCnt;                                                 //!< Changed by the readers (A5 side, not seqlock protected).
+} TMccAccelSnapshot;
+
 //******************************************************************************
 // Other definitions
 //******************************************************************************
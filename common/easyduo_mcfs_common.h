@@ -0,0 +1,145 @@
+/** ****************************************************************************
+ *
+ *  @file       easyduo_mcfs_common.h
+ *  @brief      MCC filesystem protocol of the EasyDuo Linux/MQX applications.
+ *
+ *  The M4 (mqx/mcfs.c) reads and writes files of a Linux directory served by
+ *  mcfsd (linux/CMcfsServer.cpp) over its own pair of MCC endpoints
+ *  (ESL_MCFS_ENDPOINT_*, see esl_mcfs_config.h). Every message is a TMcfsMsg:
+ *  the M4 sends tagged requests and keeps several of them in flight, the
+ *  server processes them in the order received and answers each with one or
+ *  more replies carrying the same tag. A READ of up to MCFS_MAX_READ bytes is
+ *  answered by as many replies as the data takes, each filling one MCC
+ *  buffer. WRITE data is acknowledged once the server buffered it, an error
+ *  writing it to the disk later on is reported by a following WRITE, SYNC or
+ *  CLOSE reply of the same file.
+ *
+ *  @copyright  Elnico Ltd. All rights reserved.
+ *
+ ******************************************************************************/
+/*
+ *  THIS SOFTWARE IS PROVIDED BY ELNICO "AS IS" AND ANY EXPRESSED OR
+ *  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ *  OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ *  IN NO EVENT SHALL ELNICO OR ITS CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ *  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ *  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ *  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ *  IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ *  THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************/
+
+#ifndef EASYDUO_MCFS_COMMON_H_618230957164023985710236498
+#define EASYDUO_MCFS_COMMON_H_618230957164023985710236498
+//******************************************************************************
+
+#include "easyduo_mcc_common.h"
+#include "../mqx/libesl/esl_mcfs_config.h"                                      // endpoints, also shared with Linux
+
+//******************************************************************************
+// Protocol settings
+//******************************************************************************
+
+#define MCFS_PROTOCOL_VERSION           (1)                                     //!< Version exchanged by MCFS_OP_HELLO.
+#define MCFS_MAGIC                      (0xEDF5)                                //!< TMcfsHdr::u16Magic of every message.
+
+/** @def MCFS_WINDOW
+ * @brief Maximum number of requests the M4 keeps in flight. The server
+ *        answers each WRITE by one short reply, so that the window leaves
+ *        enough of the MCC_ATTR_NUM_RECEIVE_BUFFERS for the other channels. */
+#ifndef MCFS_WINDOW
+# define MCFS_WINDOW                    (4)
+#endif
+
+/** @def MCFS_MAX_READ
+ * @brief Maximum number of bytes requested by one MCFS_OP_READ. */
+#ifndef MCFS_MAX_READ
+# define MCFS_MAX_READ                  (32 * 1024)
+#endif
+
+/** @def MCFS_READ_WINDOW
+ * @brief Maximum number of bytes the M4 requested and did not receive yet.
+ *        Bounds the replies queued for the M4 when it takes them slower
+ *        than the server sends them. */
+#ifndef MCFS_READ_WINDOW
+# define MCFS_READ_WINDOW               (2 * MCFS_MAX_READ)
+#endif
+
+/** @def MCFS_MAX_FILES
+ * @brief Maximum number of files open at the same time. */
+#ifndef MCFS_MAX_FILES
+# define MCFS_MAX_FILES                 (8)
+#endif
+
+//******************************************************************************
+// Message structure
+//******************************************************************************
+
+/** Request types, echoed in the replies. */
+enum {
+  MCFS_OP_HELLO                   = 1,                                          //!< u32Count: protocol version; reply u32Count: server version, u32Offset: MCFS_MAX_READ. Closes every file left open.
+  MCFS_OP_OPEN,                                                                 //!< u32Count: MCFS_OPEN_* flags, au8Data: path relative to the served directory; reply u16Handle, u32Count: file size.
+  MCFS_OP_CLOSE,                                                                //!< u16Handle; writes the buffered data first.
+  MCFS_OP_READ,                                                                 //!< u16Handle, u32Offset, u32Count; replies: data at u32Offset, u32Count bytes read in total by the last one.
+  MCFS_OP_WRITE,                                                                //!< u16Handle, u32Offset, au8Data; reply u32Count: bytes taken.
+  MCFS_OP_SYNC,                                                                 //!< u16Handle; writes the buffered data and flushes the file to the disk.
+};
+
+#define MCFS_OPEN_READ                  (0x01)                                  //!< Open for reading.
+#define MCFS_OPEN_WRITE                 (0x02)                                  //!< Open for writing.
+#define MCFS_OPEN_CREATE                (0x04)                                  //!< Create the file if it does not exist.
+#define MCFS_OPEN_TRUNCATE              (0x08)                                  //!< Truncate an existing file to zero length.
+
+#define MCFS_FLAG_REPLY                 (0x01)                                  //!< Sent by the server.
+#define MCFS_FLAG_LAST                  (0x02)                                  //!< Last reply to the request of the tag.
+
+/** Reply status (TMcfsHdr::i32Status). */
+enum {
+  MCFS_OK                         = 0,
+  MCFS_ERR_NOT_FOUND,                                                           //!< No such file or directory.
+  MCFS_ERR_ACCESS,                                                              //!< Permission denied or path outside the served directory.
+  MCFS_ERR_HANDLE,                                                              //!< File not open, or not open for the operation.
+  MCFS_ERR_TOO_MANY,                                                            //!< MCFS_MAX_FILES files open already.
+  MCFS_ERR_INVALID,                                                             //!< Malformed request.
+  MCFS_ERR_NO_SPACE,                                                            //!< Disk full.
+  MCFS_ERR_IO,                                                                  //!< Other failure of the file operation.
+};
+
+/** Header of every MCFS message. */
+typedef struct mcfs_hdr_struct {
+  uint16_t          u16Magic;                                                   //!< MCFS_MAGIC.
+  uint8_t           u8Op;                                                       //!< MCFS_OP_* of the request.
+  uint8_t           u8Flags;                                                    //!< MCFS_FLAG_* bits.
+  uint32_t          u32Tag;                                                     //!< Request tag chosen by the M4, echoed in its replies.
+  uint16_t          u16Handle;                                                  //!< File handle returned by MCFS_OP_OPEN, 0 for none.
+  uint16_t          u16Length;                                                  //!< Number of valid bytes in TMcfsMsg::au8Data.
+  int32_t           i32Status;                                                  //!< MCFS_OK or MCFS_ERR_* (replies only).
+  uint32_t          u32Offset;                                                  //!< File offset of the data (see MCFS_OP_*).
+  uint32_t          u32Count;                                                   //!< Operation argument or result (see MCFS_OP_*).
+} TMcfsHdr;
+
+/** @def MCFS_MAX_DATA
+ * @brief Largest data part of a message fitting in one MCC buffer. */
+#define MCFS_MAX_DATA                   (MCC_ATTR_BUFFER_SIZE_IN_BYTES - sizeof(TMcfsHdr))
+
+/** MCFS message. Only sizeof(TMcfsHdr) + oHdr.u16Length bytes are
+ *  transferred. */
+typedef struct mcfs_msg_struct {
+  TMcfsHdr          oHdr;
+  uint8_t           au8Data[MCFS_MAX_DATA];                                     //!< File data, or the path of MCFS_OP_OPEN (not terminated).
+} TMcfsMsg;
+
+//******************************************************************************
+// Layout checks
+//******************************************************************************
+
+MCC_STATIC_ASSERT(sizeof(TMcfsHdr) == 24, mcfs_hdr);
+MCC_STATIC_ASSERT(sizeof(TMcfsMsg) == MCC_ATTR_BUFFER_SIZE_IN_BYTES, mcfs_msg);
+MCC_STATIC_ASSERT(MCFS_MAX_DATA >= ESL_MCFS_FILENAME_MAXLEN, mcfs_path);
+MCC_STATIC_ASSERT(ESL_MCFS_ENDPOINT_M4_PORT != MCC_ENDPOINT_M4_PORT, mcfs_port);
+
+//******************************************************************************
+#endif // EASYDUO_MCFS_COMMON_H_618230957164023985710236498 //
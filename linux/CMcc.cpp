@@ -6,181 +6,2099 @@
  */
 
 #include "CMcc.h"
+#include "CMccCrc.h"
+#include "CMccRaw.h"
 
+#include <errno.h>
+#include <sched.h>
 #include <stdio.h>
 #include <string.h>
+#include <unistd.h>
 
 //******************************************************************************
 // Local definitions
 //******************************************************************************
 
-//#define MCC_WAIT_RECV                   (10*1000)                               //!< MCC Send timeout (in microseconds) - causes serious crashes! (?)
-#define MCC_WAIT_RECV                   (MCC_WAIT_INF)                          //!< MCC Send timeout (in microseconds)
+#define CMCC_MSGTYPE_QUIT               (-1)                                    //!< Message sent to the local endpoint to stop the receiver thread.
+#define CMCC_MSGTYPE_WAKE               (-2)                                    //!< Message sent to the local endpoint to have a recovery attempt done at once.
+
+/** @def CMCC_REQUEST_ID
+ * @brief Request identifier made of the request sequence number and channel
+ *        (the channels are numbered independently). Never 0. */
+#define CMCC_REQUEST_ID(seq, ch)        (((seq) << 1) | (ch))
+
+/** Blocking call state shared with CMcc::transactReply. */
+typedef struct t_mcc_transact_struct {
+  pthread_mutex_t   mtx;
+  pthread_cond_t    cond;
+  bool              bDone;
+  int               iStatus;
+  void            * pvReply;                                                    //!< Reply buffer of the caller.
+  MCC_MEM_SIZE      maxSize;                                                    //!< Size of pvReply.
+  MCC_MEM_SIZE      size;                                                       //!< Number of bytes stored to pvReply.
+} TMccTransact;
+
+//******************************************************************************
+// Local functions
+//******************************************************************************
+
+/** Computes the CLOCK_MONOTONIC time u32Ms milliseconds from now. */
+static void timespec_fromNow (struct timespec * poTime, uint32_t u32Ms)
+{
+  clock_gettime(CLOCK_MONOTONIC, poTime);
+  poTime->tv_sec  += u32Ms / 1000;
+  poTime->tv_nsec += (u32Ms % 1000) * 1000000L;
+  if (poTime->tv_nsec >= 1000000000L) {
+    poTime->tv_sec  += 1;
+    poTime->tv_nsec -= 1000000000L;
+  }
+}
+
+/** Returns true if time A precedes time B. */
+static bool timespec_before (const struct timespec & oA, const struct timespec & oB)
+{
+  return (oA.tv_sec < oB.tv_sec) || ((oA.tv_sec == oB.tv_sec) && (oA.tv_nsec < oB.tv_nsec));
+}
+
+/** Computes the pause before the next connection attempt, u32BackoffMs but
+ *  not past the deadline, and doubles u32BackoffMs up to
+ *  CMCC_CONNECT_BACKOFF_MAX for the attempt after. */
+static uint32_t connect_pause (uint32_t * pu32BackoffMs, uint64_t u64DeadlineUs, uint64_t u64NowUs)
+{
+  uint32_t u32PauseMs = *pu32BackoffMs;
+
+  if (u32PauseMs > (u64DeadlineUs - u64NowUs) / 1000) u32PauseMs = (uint32_t)((u64DeadlineUs - u64NowUs) / 1000) + 1;
+  *pu32BackoffMs = (2 * *pu32BackoffMs < CMCC_CONNECT_BACKOFF_MAX) ? 2 * *pu32BackoffMs : CMCC_CONNECT_BACKOFF_MAX;
+  return u32PauseMs;
+}
 
 //******************************************************************************
-// Static initializers
+//******************************************************************************
+//******************************************************************************
+
+CMcc::CMcc (MCC_NODE iNode, MCC_PORT iPort, uint32_t u32ConnectMs)
+  : m_poTransport(NULL)
+{
+  uint64_t u64DeadlineUs = CMccClock::nowUs() + u32ConnectMs * 1000ull;
+
+  m_poTransport = CMcc::openTransport(iNode, iPort, u64DeadlineUs);
+  this->start(u64DeadlineUs);
+}
+
 //******************************************************************************
 
-MCC_ENDPOINT CMcc::s_mccEndpointLocal;                                          //!< Local EasyDuo MCC endpoint.
-MCC_ENDPOINT CMcc::s_mccEndpointRemote = { MCC_ENDPOINT_M4_CORE,
-                                           MCC_ENDPOINT_M4_NODE,
-                                           MCC_ENDPOINT_M4_PORT };              //!< Remote EasyDuo MCC endpoint.
+CMcc::CMcc (CMccTransport * poTransport, uint32_t u32ConnectMs)
+  : m_poTransport(poTransport)
+{
+  this->start(CMccClock::nowUs() + u32ConnectMs * 1000ull);
+}
 
 //******************************************************************************
+
+CMccTransport * CMcc::openTransport (MCC_NODE iNode, MCC_PORT iPort, uint64_t u64DeadlineUs)
+{
+  uint32_t  u32BackoffMs = CMCC_CONNECT_BACKOFF_MIN;
+  uint32_t  u32PauseMs;
+  uint64_t  u64NowUs;
+
+  // the MCC driver may still be loading while the M4 boots
+  while (true) {
+    try {
+      return CMccTransport::create(iNode, iPort);
+    } catch (int ret) {
+      u64NowUs = CMccClock::nowUs();
+      if (u64NowUs >= u64DeadlineUs) throw;
+      u32PauseMs = connect_pause(&u32BackoffMs, u64DeadlineUs, u64NowUs);
+      printf("MCC endpoint not available (%d), retrying in %u ms\n", ret, u32PauseMs);
+      usleep(u32PauseMs * 1000);
+    }
+  }
+}
+
 //******************************************************************************
+
+void CMcc::start (uint64_t u64DeadlineUs)
+{
+  pthread_condattr_t  condAttr;
+  TMccMsg             oMsg;
+  int                 ret;
+
+  m_u32StreamSince  = 0;
+  m_u32Timeout      = CMCC_TIMEOUT_DEFAULT;
+  m_bSubscribed     = false;
+  m_u32PushPeriod   = 0;
+  memset(&m_oAccelConfig, 0, sizeof(m_oAccelConfig));
+  m_u32AccelSet     = 0;
+  memset(&m_oAccelFilter, 0, sizeof(m_oAccelFilter));
+  memset(&m_oAccelFeatures, 0, sizeof(m_oAccelFeatures));
+  memset(&m_oAccelEvents, 0, sizeof(m_oAccelEvents));
+  m_pfnAccelEvent   = NULL;
+  m_pvAccelEventCtx = NULL;
+  m_u32PushStride   = 1;
+  m_u8Version       = MCC_PROTOCOL_VERSION;
+  m_bCrc            = false;
+  m_bRaw            = true;
+  m_u32PushUnacked  = 0;
+  m_bQuit           = false;
+  m_bM4Ready        = false;
+  m_u32PushLost     = 0;
+  m_u32SummaryLost  = 0;
+  m_u32EventLost    = 0;
+  m_bClockSync      = false;
+  m_u32ClockCount   = 0;
+  m_bLinkUp         = true;
+  m_bHeartbeat      = false;
+  m_bReopen         = false;
+  m_u64RxUs         = CMccClock::nowUs();
+  m_u64LostUs       = 0;
+  m_u32M4UptimeMs   = 0;
+  m_poSnapshot      = (volatile TMccAccelSnapshot*)m_poTransport->getSnapshot();
+
+  memset(m_au32TxSeq, 0, sizeof(m_au32TxSeq));
+  memset(m_au16TxAck, 0, sizeof(m_au16TxAck));
+  memset(m_au32RxSeqLast, 0, sizeof(m_au32RxSeqLast));
+  memset(m_au32RxSeqNext, 0, sizeof(m_au32RxSeqNext));
+  memset(m_aoPending, 0, sizeof(m_aoPending));
+  memset(&m_oLinkStats, 0, sizeof(m_oLinkStats));
+  memset(&m_oStats, 0, sizeof(m_oStats));
+  pthread_mutex_init(&m_mtxTx, NULL);
+  pthread_mutex_init(&m_mtxPending, NULL);
+  pthread_condattr_init(&condAttr);
+  pthread_condattr_setclock(&condAttr, CLOCK_MONOTONIC);                        // deadlines must not jump with the wall clock
+  pthread_cond_init(&m_condPending, &condAttr);
+  pthread_cond_init(&m_condTx, &condAttr);
+  pthread_condattr_destroy(&condAttr);
+
+  ret = pthread_create(&m_thrReceiver, NULL, CMcc::receiverThread, this);
+  if (0 != ret) {
+    printf("pthread_create failed: %d\n", ret);
+    delete m_poTransport;
+    throw MCC_THREAD_FAILURE;
+  }
+
+  ret = pthread_create(&m_thrTimer, NULL, CMcc::timerThread, this);
+  if (0 != ret) {
+    printf("pthread_create failed: %d\n", ret);
+    m_bQuit   = true;
+    oMsg.type = CMCC_MSGTYPE_QUIT;
+    m_poTransport->sendLocalMsg(&oMsg, sizeof(oMsg));                           // the receive timeout stops it otherwise
+    pthread_join(m_thrReceiver, NULL);
+    delete m_poTransport;
+    throw MCC_THREAD_FAILURE;
+  }
+
+  this->negotiate(u64DeadlineUs);
+
+  // the timer thread keeps the M4 clock estimate up to date and watches the
+  // link
+  pthread_mutex_lock(&m_mtxPending);
+  m_bClockSync = (m_u8Version >= MCC_PROTOCOL_TIMESTAMPS);
+  m_bHeartbeat = (m_u8Version >= MCC_PROTOCOL_HEARTBEAT);
+  clock_gettime(CLOCK_MONOTONIC, &m_oClockNext);
+  timespec_fromNow(&m_oHeartbeatNext, CMCC_HEARTBEAT_PERIOD);
+  __atomic_store_n(&m_u64RxUs, CMccClock::nowUs(), __ATOMIC_RELAXED);
+  pthread_cond_signal(&m_condPending);
+  pthread_mutex_unlock(&m_mtxPending);
+}
+
 //******************************************************************************
 
-CMcc::CMcc (MCC_NODE iNode, MCC_PORT iPort)
+void CMcc::negotiate (uint64_t u64DeadlineUs)
 {
-  MCC_INFO_STRUCT   mccInfo;
-  int               ret;
+  TMccMsg   * poMsg;
+  TMccMsg     oReply;
+  uint32_t    u32BackoffMs = CMCC_CONNECT_BACKOFF_MIN;
+  uint32_t    u32PauseMs;
+  uint64_t    u64NowUs;
+  int         ret;
 
-  ret = mcc_initialize(iNode);
-  if (MCC_SUCCESS != ret) {
-    printf("mcc_initialize failed: %d\n", ret);
-    throw MCC_INIT_FAILURE;
+  // the HELLO is framed, an M4 knowing the bare messages only drops it; a M4
+  // still booting has no endpoint to send it to yet, or answers it once its
+  // tasks are initialized
+  m_u8Version = MCC_PROTOCOL_VERSION;
+  while (true) {
+    this->forgetInFlight();                                                     // unanswered HELLOs hold no credit
+    ret   = MCC_SEND_FAILURE;
+    poMsg = this->allocMsg();
+    if (poMsg) {
+      poMsg->type       = MCCMSG_HELLO;
+      poMsg->u32Version = MCC_PROTOCOL_VERSION;
+      ret = this->transact(poMsg, u32BackoffMs, &oReply, sizeof(oReply));
+    }
+    if (MCC_OK == ret) break;
+
+    u64NowUs = CMccClock::nowUs();
+    if (u64NowUs >= u64DeadlineUs) break;
+    u32PauseMs = connect_pause(&u32BackoffMs, u64DeadlineUs, u64NowUs);
+    if (MCC_TIMEOUT != ret) this->waitReady(u32PauseMs);                        // not sent, no M4 endpoint yet
   }
 
-  ret = mcc_get_info(iNode, &mccInfo);
-  if (MCC_SUCCESS != ret) {
-    printf("mcc_get_info failed: %d\n", ret);
-    mcc_destroy(iNode);
-    throw MCC_INFO_FAILURE;
-  } else if (strncmp(mccInfo.version_string, MCC_VERSION_STRING, 3) != 0) {     // compare first 3 bytes (major number)
-    printf("MCC Library versions do not match ('%s' vs '%s')\n",
-           mccInfo.version_string, MCC_VERSION_STRING);
-    mcc_destroy(iNode);
-    throw MCC_VERSION_FAILURE;
+  if ((MCC_OK == ret) && (oReply.u32Version >= MCC_PROTOCOL_FRAMED)) {
+    m_u8Version = (oReply.u32Version < MCC_PROTOCOL_VERSION) ? oReply.u32Version : MCC_PROTOCOL_VERSION;
   } else {
-    printf("MCC version %s loaded\n", mccInfo.version_string);
+    m_u8Version = MCC_PROTOCOL_LEGACY;
   }
+  printf("MCC protocol version %d\n", m_u8Version);
+}
+
+//******************************************************************************
 
-  ret = mcc_create_endpoint(&CMcc::s_mccEndpointLocal, iPort);
-  if (MCC_SUCCESS != ret) {
-    printf("mcc_create_endpoint() failed: %d, node,port: %d, %d\n",
-           ret, iNode, iPort);
-    throw MCC_ENDPOINT_FAILURE;
+void CMcc::waitReady (uint32_t u32TimeoutMs)
+{
+  struct timespec oDeadline;
+
+  timespec_fromNow(&oDeadline, u32TimeoutMs);
+  pthread_mutex_lock(&m_mtxPending);
+  while (!m_bM4Ready && !m_bQuit) {
+    if (ETIMEDOUT == pthread_cond_timedwait(&m_condPending, &m_mtxPending, &oDeadline)) break;
   }
+  m_bM4Ready = false;                                                           // one attempt at once per announcement
+  pthread_mutex_unlock(&m_mtxPending);
+}
+
+//******************************************************************************
+
+void CMcc::m4Ready (uint32_t u32UptimeMs)
+{
+  bool bHeartbeat;
+
+  printf("M4 ready %u ms after its boot\n", u32UptimeMs);
+  pthread_mutex_lock(&m_mtxPending);
+  m_bM4Ready = true;
+  bHeartbeat = m_bHeartbeat;
+  pthread_cond_broadcast(&m_condPending);                                       // the timer thread just looks at its schedule again
+  pthread_mutex_unlock(&m_mtxPending);
+  if (!bHeartbeat) return;                                                      // still negotiating
+
+  // a reboot the heartbeats have not noticed yet, recover at once
+  this->linkLost(true, u32UptimeMs);
+  __atomic_store_n(&m_bReopen, true, __ATOMIC_RELAXED);                         // taken by the receiver loop, this thread
 }
 
 //******************************************************************************
 
-int CMcc::sendMsg (TMccMsg & oMsg)
+CMcc::~CMcc ()
 {
-  int ret;
+  TMccPending   oPending;
+  TMccMsg       oMsg;
+  int           i;
+
+  if (__atomic_load_n(&m_bSubscribed, __ATOMIC_RELAXED)) {                      // fails at once if the link is down
+    this->unsubscribeAccel();
+  }
+
+  // stop the timer thread
+  pthread_mutex_lock(&m_mtxPending);
+  m_bQuit = true;
+  pthread_cond_signal(&m_condPending);
+  pthread_mutex_unlock(&m_mtxPending);
+  pthread_join(m_thrTimer, NULL);
 
-  ret = mcc_send(&CMcc::s_mccEndpointRemote, &oMsg, sizeof(oMsg), 0);           // non-blocking call
-  if (MCC_SUCCESS != ret) {
-    printf("mcc_send failed: %d\n", ret);
-    return MCC_SEND_FAILURE;
+  // stop the receiver thread, woken up by the message or its receive timeout
+  oMsg.type = CMCC_MSGTYPE_QUIT;
+  m_poTransport->sendLocalMsg(&oMsg, sizeof(oMsg));
+  pthread_join(m_thrReceiver, NULL);
+  delete m_poTransport;
+
+  // nobody will reply anymore
+  for (i = 0; i < CMCC_PENDING_MAX; ++i) {
+    if (this->takePending(m_aoPending[i].u32Id, 0, &oPending)) {
+      oPending.pfnReply(oPending.pvCtx, oPending.u32Id, MCC_CANCELLED, NULL, 0);
+    }
   }
+
+  pthread_cond_destroy(&m_condPending);
+  pthread_mutex_destroy(&m_mtxPending);
+  pthread_cond_destroy(&m_condTx);
+  pthread_mutex_destroy(&m_mtxTx);
+}
+
+//******************************************************************************
+
+void CMcc::setTimeout (uint32_t u32TimeoutMs)
+{
+  m_u32Timeout = u32TimeoutMs;
+}
+
+//******************************************************************************
+
+uint8_t CMcc::getProtocolVersion (void) const
+{
+  return m_u8Version;
+}
+
+//******************************************************************************
+
+void CMcc::getSeqErrors (uint32_t * pu32Lost, uint32_t * pu32Reordered)
+{
+  if (pu32Lost)       *pu32Lost       = __atomic_load_n(&m_oStats.u32RxLost, __ATOMIC_RELAXED);
+  if (pu32Reordered)  *pu32Reordered  = __atomic_load_n(&m_oStats.u32RxReordered, __ATOMIC_RELAXED);
+}
+
+//******************************************************************************
+
+int CMcc::setCrc (bool bEnable)
+{
+  if (bEnable && (m_u8Version < MCC_PROTOCOL_CRC)) return MCC_VERSION_FAILURE;
+  __atomic_store_n(&m_bCrc, bEnable, __ATOMIC_RELAXED);
+  return MCC_OK;
+}
+
+//******************************************************************************
+
+bool CMcc::getCrc (void) const
+{
+  return __atomic_load_n(&m_bCrc, __ATOMIC_RELAXED);
+}
+
+//******************************************************************************
+
+int CMcc::setAccelRaw (bool bEnable)
+{
+  if (bEnable && (m_u8Version < MCC_PROTOCOL_RAW)) return MCC_VERSION_FAILURE;
+  __atomic_store_n(&m_bRaw, bEnable, __ATOMIC_RELAXED);
   return MCC_OK;
 }
 
 //******************************************************************************
 
-int CMcc::recvMsg (TMccMsg ** ppoMsg)
+bool CMcc::getAccelRaw (void) const
+{
+  return __atomic_load_n(&m_bRaw, __ATOMIC_RELAXED) && (m_u8Version >= MCC_PROTOCOL_RAW);
+}
+
+//******************************************************************************
+
+uint32_t CMcc::getCrcErrors (void)
+{
+  return __atomic_load_n(&m_oStats.u32RxCrcErrors, __ATOMIC_RELAXED);
+}
+
+//******************************************************************************
+
+uint32_t CMcc::getTxDropped (void)
+{
+  return __atomic_load_n(&m_oStats.u32TxNoCredit, __ATOMIC_RELAXED)
+         + __atomic_load_n(&m_oStats.u32TxFailures, __ATOMIC_RELAXED);
+}
+
+//******************************************************************************
+
+bool CMcc::isLinkUp (void) const
+{
+  return __atomic_load_n(&m_bLinkUp, __ATOMIC_RELAXED);
+}
+
+//******************************************************************************
+
+void CMcc::getLinkStats (TMccLinkStats * poStats)
+{
+  if (!poStats) return;
+  pthread_mutex_lock(&m_mtxPending);
+  *poStats = m_oLinkStats;
+  pthread_mutex_unlock(&m_mtxPending);
+}
+
+//******************************************************************************
+
+void CMcc::getStats (TMccStats * poStats)
+{
+  const uint32_t  * pu32Src = (const uint32_t*)&m_oStats;                       // all uint32_t
+  uint32_t        * pu32Dst = (uint32_t*)poStats;
+  size_t            i;
+
+  if (!poStats) return;
+  for (i = 0; i < sizeof(TMccStats) / sizeof(uint32_t); ++i) {
+    pu32Dst[i] = __atomic_load_n(&pu32Src[i], __ATOMIC_RELAXED);
+  }
+}
+
+//******************************************************************************
+
+int CMcc::getM4Stats (int iChannel, TMccStats * poStats)
 {
+  TMccStatsMsg    oReply;
+  TMccMsg       * poMsg;
   MCC_MEM_SIZE    size;
   int             ret;
 
-  ret = mcc_recv_nocopy(&CMcc::s_mccEndpointLocal, (void**)ppoMsg, &size, MCC_WAIT_RECV);  // blocking call
-  if (MCC_SUCCESS != ret) {
-    printf("mcc_recv_nocopy failed: %d\n", ret);
-    return MCC_RECV_FAILURE;
-  }
+  if (!poStats || (iChannel < 0) || (iChannel >= CMCC_CHANNEL_COUNT)) return MCC_INVALID_ARGUMENT;
+  if (m_u8Version < MCC_PROTOCOL_STATS) return MCC_VERSION_FAILURE;
+
+  poMsg = this->alloc<MCCMSG_STATS>();
+  if (poMsg) poMsg->u32Channel = (CMCC_CHANNEL_BULK == iChannel) ? MCC_MSG_CHANNEL_BULK : MCC_MSG_CHANNEL_CONTROL;
+  ret = this->send<MCCMSG_STATS>(poMsg, &oReply, &size);
+  if (MCC_OK != ret) return ret;
+  if (size < sizeof(TMccStatsMsg)) return MCC_RECV_FAILURE;
+  *poStats = oReply.oStats;
   return MCC_OK;
 }
 
 //******************************************************************************
 
-int CMcc::freeMsg (TMccMsg * poMsg)
+const CMccClock & CMcc::getClock (void) const
+{
+  return m_oClock;
+}
+
+//******************************************************************************
+
+TMccMsg * CMcc::allocMsg (void)
 {
-  int ret;
-  ret = mcc_free_buffer(poMsg);
-  if (MCC_SUCCESS != ret) {
-    printf("mcc_free_buffer failed: %d\n", ret);
-    return MCC_FREE_FAILURE;
+  uint8_t * pu8Buf = (uint8_t*)m_poTransport->getTxBuffer();
+
+  if (!pu8Buf) {
+    printf("allocMsg no free buffer (%u total)\n",
+           __atomic_add_fetch(&m_oStats.u32TxNoBuffer, 1, __ATOMIC_RELAXED));
+    return NULL;
   }
-  return MCC_OK;
+  return (TMccMsg*)(pu8Buf + MCC_PREFIX_SIZE(m_u8Version));                     // room for the header
 }
 
 //******************************************************************************
 
-int CMcc::setLedOn (void)
+TMccMsg * CMcc::allocAccelConfig (const TMccAccelConfig * poReq, uint32_t u32Set)
 {
-  TMccMsg oMsg;
+  TMccMsg * poMsg;
+
+  if (u32Set && !poReq) return NULL;
+  poMsg = this->alloc<MCCMSG_ACCEL_CONFIG>();
+  if (!poMsg) return NULL;
 
-  oMsg.type = MCCMSG_LED_ON;
-  return this->sendMsg(oMsg);
+  memset(&poMsg->oAccelConfig, 0, sizeof(poMsg->oAccelConfig));
+  poMsg->u32AccelSet = u32Set;
+  if (!u32Set) return poMsg;                                                    // query only
+
+  // kept for a rebooted M4, the settings changed by the earlier calls too
+  pthread_mutex_lock(&m_mtxPending);
+  if (u32Set & MCC_ACCEL_SET_RATE)          m_oAccelConfig.u32RateMilliHz = poReq->u32RateMilliHz;
+  if (u32Set & MCC_ACCEL_SET_RANGE)         m_oAccelConfig.u8RangeG       = poReq->u8RangeG;
+  if (u32Set & MCC_ACCEL_SET_OVERSAMPLING)  m_oAccelConfig.u8Oversampling = poReq->u8Oversampling;
+  if (u32Set & MCC_ACCEL_SET_LOW_NOISE)     m_oAccelConfig.u8LowNoise     = poReq->u8LowNoise;
+  m_u32AccelSet |= u32Set;
+  pthread_mutex_unlock(&m_mtxPending);
+  poMsg->oAccelConfig = *poReq;
+  return poMsg;
 }
 
 //******************************************************************************
 
-int CMcc::setLedOff (void)
+TMccMsg * CMcc::allocAccelFilter (const TMccAccelFilter * poReq)
 {
-  TMccMsg oMsg;
+  TMccMsg * poMsg;
 
-  oMsg.type = MCCMSG_LED_OFF;
-  return this->sendMsg(oMsg);
+  poMsg = this->alloc<MCCMSG_ACCEL_FILTER>();
+  if (!poMsg) return NULL;
+
+  memset(&poMsg->oAccelFilter, 0, sizeof(poMsg->oAccelFilter));
+  poMsg->u32FilterSet = poReq ? 1 : 0;
+  if (!poReq) return poMsg;                                                     // query only
+
+  // kept for the next subscriptions and a rebooted M4
+  pthread_mutex_lock(&m_mtxPending);
+  m_oAccelFilter = *poReq;
+  pthread_mutex_unlock(&m_mtxPending);
+  poMsg->oAccelFilter = *poReq;
+  return poMsg;
 }
 
 //******************************************************************************
 
-int CMcc::setLedAuto (void)
+TMccMsg * CMcc::allocAccelFilterRenewal (void)
+{
+  TMccMsg * poMsg;
+
+  poMsg = this->alloc<MCCMSG_ACCEL_FILTER>();
+  if (!poMsg) return NULL;
+
+  poMsg->u32FilterSet = 1;                                                      // zeros clear the chain of an earlier subscriber
+  pthread_mutex_lock(&m_mtxPending);
+  poMsg->oAccelFilter = m_oAccelFilter;
+  pthread_mutex_unlock(&m_mtxPending);
+  return poMsg;
+}
+
+//******************************************************************************
+
+TMccMsg * CMcc::allocAccelFeatures (const TMccAccelFeatures * poReq)
 {
-  TMccMsg oMsg;
+  TMccMsg * poMsg;
+
+  poMsg = this->alloc<MCCMSG_ACCEL_FEATURES>();
+  if (!poMsg) return NULL;
+
+  memset(&poMsg->oAccelFeatures, 0, sizeof(poMsg->oAccelFeatures));
+  poMsg->u32FeaturesSet = poReq ? 1 : 0;
+  if (!poReq) return poMsg;                                                     // query only
 
-  oMsg.type = MCCMSG_LED_AUTO;
-  return this->sendMsg(oMsg);
+  // kept for a rebooted M4
+  pthread_mutex_lock(&m_mtxPending);
+  m_oAccelFeatures = *poReq;
+  pthread_mutex_unlock(&m_mtxPending);
+  poMsg->oAccelFeatures = *poReq;
+  return poMsg;
 }
 
 //******************************************************************************
 
-int CMcc::getAccelType (int32_t * pi32Type)
+TMccMsg * CMcc::allocAccelEvents (const TMccAccelEvents * poReq)
 {
-  TMccMsg     oMsg;
-  TMccMsg   * pMsg;
-  int         ret;
+  TMccMsg * poMsg;
 
-  if (!pi32Type) return MCC_INVALID_ARGUMENT;
+  poMsg = this->alloc<MCCMSG_ACCEL_EVENTS>();
+  if (!poMsg) return NULL;
 
-  oMsg.type = MCCMSG_ACCEL_INFO;
-  ret = this->sendMsg(oMsg);
-  if (MCC_OK != ret) return ret;
+  memset(&poMsg->oAccelEvents, 0, sizeof(poMsg->oAccelEvents));
+  poMsg->u32EventsSet = poReq ? 1 : 0;
+  if (!poReq) return poMsg;                                                     // query only
 
-  this->recvMsg(&pMsg);
-  if (MCC_OK != ret) return ret;
+  // kept for a rebooted M4
+  pthread_mutex_lock(&m_mtxPending);
+  m_oAccelEvents = *poReq;
+  pthread_mutex_unlock(&m_mtxPending);
+  poMsg->oAccelEvents = *poReq;
+  return poMsg;
+}
+
+//******************************************************************************
 
-  *pi32Type = pMsg->iAccelType;
+void CMcc::discardMsg (TMccMsg * poMsg)
+{
+  m_poTransport->freeTxBuffer((uint8_t*)poMsg - MCC_PREFIX_SIZE(m_u8Version));
+}
+
+//******************************************************************************
+
+int CMcc::channelOf (int32_t i32Type) const
+{
+  if ((m_u8Version >= MCC_PROTOCOL_CHANNELS) && MCC_MSG_IS_BULK(i32Type)) {
+    return CMCC_CHANNEL_BULK;
+  }
+  return CMCC_CHANNEL_CONTROL;
+}
 
-  this->freeMsg(pMsg);
+//******************************************************************************
+
+int CMcc::sendMsg (TMccMsg * poMsg, MCC_MEM_SIZE size, bool bWait)
+{
+  int       iChannel = this->channelOf(poMsg->type);
+  uint32_t  u32Seq;
+  int       ret;
+
+  if (!this->isLinkUp()) {
+    this->discardMsg(poMsg);
+    return MCC_LINK_DOWN;
+  }
+
+  pthread_mutex_lock(&m_mtxTx);
+  ret = this->waitCredit(iChannel, bWait);
+  if (MCC_OK != ret) {
+    pthread_mutex_unlock(&m_mtxTx);
+    this->discardMsg(poMsg);
+    return ret;
+  }
+  u32Seq = m_au32TxSeq[iChannel] + 1;
+  if (!u32Seq) u32Seq = 1;                                                      // 0 is never used
+  ret = this->sendFrame(poMsg, size, iChannel, u32Seq);
+  pthread_mutex_unlock(&m_mtxTx);
   return ret;
 }
 
 //******************************************************************************
 
-int CMcc::getAccelData (TAccelData * poData)
+int CMcc::waitCredit (int iChannel, bool bWait)
 {
-  TMccMsg     oMsg;
-  TMccMsg   * pMsg;
-  int         ret;
+  struct timespec oDeadline;
+  bool            bTimed = (CMCC_TIMEOUT_INF != m_u32Timeout);
 
-  if (!poData) return MCC_INVALID_ARGUMENT;
+  if (m_u8Version < MCC_PROTOCOL_CREDITS) return MCC_OK;
+  if (MCC_CREDIT_IN_FLIGHT(m_au32TxSeq[iChannel], m_au16TxAck[iChannel]) < MCC_CREDITS_A5) return MCC_OK;
 
-  oMsg.type = MCCMSG_ACCEL_DATA;
-  ret = this->sendMsg(oMsg);
-  if (MCC_OK != ret) return ret;
+  // the acknowledgements come through the receiver thread, it must not wait
+  // (nor the timer thread expiring the requests)
+  if (bWait && !pthread_equal(pthread_self(), m_thrReceiver) && !pthread_equal(pthread_self(), m_thrTimer)) {
+    if (bTimed) timespec_fromNow(&oDeadline, m_u32Timeout);
+    while ((MCC_CREDIT_IN_FLIGHT(m_au32TxSeq[iChannel], m_au16TxAck[iChannel]) >= MCC_CREDITS_A5) && this->isLinkUp()) {
+      if (!bTimed) {
+        pthread_cond_wait(&m_condTx, &m_mtxTx);
+      } else if (ETIMEDOUT == pthread_cond_timedwait(&m_condTx, &m_mtxTx, &oDeadline)) {
+        break;
+      }
+    }
+  }
 
-  this->recvMsg(&pMsg);
-  if (MCC_OK != ret) return ret;
+  if (!this->isLinkUp()) return MCC_LINK_DOWN;
+  if (MCC_CREDIT_IN_FLIGHT(m_au32TxSeq[iChannel], m_au16TxAck[iChannel]) >= MCC_CREDITS_A5) {
+    printf("channel %d no credit, message dropped (%u total)\n", iChannel,
+           __atomic_add_fetch(&m_oStats.u32TxNoCredit, 1, __ATOMIC_RELAXED));
+    return MCC_BUSY;
+  }
+  return MCC_OK;
+}
+
+//******************************************************************************
+
+void CMcc::takeAck (int iChannel, const TMccHdr * poHdr)
+{
+  __atomic_store_n(&m_au32RxSeqLast[iChannel], poHdr->u32Seq, __ATOMIC_RELAXED);
+
+  pthread_mutex_lock(&m_mtxTx);
+  if (MCC_CREDIT_IN_FLIGHT(m_au32TxSeq[iChannel], poHdr->u16Ack)
+      < MCC_CREDIT_IN_FLIGHT(m_au32TxSeq[iChannel], m_au16TxAck[iChannel])) {   // older ones (reordered, previous session) ignored
+    m_au16TxAck[iChannel] = poHdr->u16Ack;
+    pthread_cond_broadcast(&m_condTx);
+  }
+  pthread_mutex_unlock(&m_mtxTx);
+}
+
+//******************************************************************************
+
+void CMcc::ackPushes (uint32_t u32Min)
+{
+  TMccMsg   * poMsg;
+  uint32_t    u32Seq;
+
+  if ((m_u8Version < MCC_PROTOCOL_CREDITS)
+      || (__atomic_load_n(&m_u32PushUnacked, __ATOMIC_RELAXED) < u32Min)) {
+    return;
+  }
+
+  poMsg = this->allocMsg();
+  if (!poMsg) return;                                                           // the timer thread retries
+  poMsg->type = MCCMSG_CREDIT;                                                  // outside the window, never waits
+  pthread_mutex_lock(&m_mtxTx);
+  u32Seq = m_au32TxSeq[CMCC_CHANNEL_BULK] + 1;
+  if (!u32Seq) u32Seq = 1;
+  this->sendFrame(poMsg, sizeof(int32_t), CMCC_CHANNEL_BULK, u32Seq);
+  pthread_mutex_unlock(&m_mtxTx);
+}
+
+//******************************************************************************
+
+int CMcc::sendFrame (TMccMsg * poMsg, MCC_MEM_SIZE size, int iChannel, uint32_t u32Seq)
+{
+  TMccHdr * poHdr = (TMccHdr*)((uint8_t*)poMsg - MCC_PREFIX_SIZE(m_u8Version));
+  bool      bCrc  = this->getCrc();
+  int32_t   i32Type = poMsg->type;
+  uint32_t  u32Unacked = 0;
+  uint32_t  u32Crc;
+  int       ret;
+
+  if (m_u8Version >= MCC_PROTOCOL_FRAMED) {                                     // the type is already in place
+    poHdr->u16Magic     = MCC_HDR_MAGIC;
+    poHdr->u8Version    = MCC_PROTOCOL_VERSION;
+    poHdr->u8Flags      = bCrc ? MCC_HDR_FLAG_CRC : 0;
+    poHdr->u16Length    = size - sizeof(int32_t);
+    poHdr->u16Ack       = 0;
+    if (m_u8Version >= MCC_PROTOCOL_CREDITS) {
+      poHdr->u16Ack     = (uint16_t)__atomic_load_n(&m_au32RxSeqLast[iChannel], __ATOMIC_RELAXED);
+      if (CMCC_CHANNEL_BULK == iChannel) u32Unacked = __atomic_exchange_n(&m_u32PushUnacked, 0, __ATOMIC_RELAXED);
+    }
+    poHdr->u32Seq       = u32Seq;
+    poHdr->u32Ref       = 0;
+    size += MCC_HDR_PREFIX_SIZE;
+    if (bCrc) {                                                                 // room left by allocMsg
+      u32Crc = CMccCrc::calc(poHdr, size);
+      memcpy((uint8_t*)poHdr + size, &u32Crc, MCC_CRC_SIZE);
+      size += MCC_CRC_SIZE;
+    }
+  }
+  m_au32TxSeq[iChannel] = u32Seq;                                               // used even if the send fails, the M4 sees it lost
+  ret = m_poTransport->sendTxBuffer(poHdr, size,                                // no copy, the transport owns the buffer now
+                                    (CMCC_CHANNEL_BULK == iChannel) ? MCC_ENDPOINT_M4_BULK_PORT : MCC_ENDPOINT_M4_PORT);
+  if (MCC_OK != ret) {
+    if (u32Unacked) __atomic_add_fetch(&m_u32PushUnacked, u32Unacked, __ATOMIC_RELAXED);
+    printf("sendFrame type %d dropped: %d (%u total)\n", i32Type, ret,
+           __atomic_add_fetch(&m_oStats.u32TxFailures, 1, __ATOMIC_RELAXED));
+  } else if ((uint32_t)i32Type < MCC_STATS_TYPES) {
+    __atomic_add_fetch(&m_oStats.au32Tx[i32Type], 1, __ATOMIC_RELAXED);
+  }
+  return ret;
+}
+
+//******************************************************************************
+
+int CMcc::freeMsg (void * pvMsg)
+{
+  return m_poTransport->freeMsg(pvMsg);
+}
+
+//******************************************************************************
+
+int CMcc::sendRequest (TMccMsg        * poMsg,
+                       uint32_t         u32TimeoutMs,
+                       TMccReplyFn      pfnReply,
+                       void           * pvCtx,
+                       uint32_t       * pu32Id,
+                       MCC_MEM_SIZE     size)
+{
+  return this->postRequest(poMsg, u32TimeoutMs, pfnReply, pvCtx, pu32Id, size, true);
+}
+
+//******************************************************************************
+
+int CMcc::trySendRequest (TMccMsg        * poMsg,
+                          uint32_t         u32TimeoutMs,
+                          TMccReplyFn      pfnReply,
+                          void           * pvCtx,
+                          uint32_t       * pu32Id,
+                          MCC_MEM_SIZE     size)
+{
+  return this->postRequest(poMsg, u32TimeoutMs, pfnReply, pvCtx, pu32Id, size, false);
+}
+
+//******************************************************************************
+
+int CMcc::trySend (TMccMsg * poMsg, MCC_MEM_SIZE size)
+{
+  if (!poMsg) return MCC_INVALID_ARGUMENT;
+  if ((size < sizeof(int32_t))
+      || (size > MCC_ATTR_BUFFER_SIZE_IN_BYTES - MCC_PREFIX_SIZE(m_u8Version) - MCC_CRC_SIZE)) {
+    this->discardMsg(poMsg);
+    return MCC_INVALID_ARGUMENT;
+  }
+  return this->sendMsg(poMsg, size, false);
+}
+
+//******************************************************************************
+
+int CMcc::postRequest (TMccMsg        * poMsg,
+                       uint32_t         u32TimeoutMs,
+                       TMccReplyFn      pfnReply,
+                       void           * pvCtx,
+                       uint32_t       * pu32Id,
+                       MCC_MEM_SIZE     size,
+                       bool             bWait)
+{
+  TMccPending   oPending;
+  int           iChannel;
+  uint32_t      u32Seq;
+  uint32_t      u32Id = 0;
+  int           i;
+  int           ret = MCC_OK;
+
+  if (!poMsg) return MCC_INVALID_ARGUMENT;
+  if (!pfnReply || (size < sizeof(int32_t))
+      || (size > MCC_ATTR_BUFFER_SIZE_IN_BYTES - MCC_PREFIX_SIZE(m_u8Version) - MCC_CRC_SIZE)) {
+    this->discardMsg(poMsg);
+    return MCC_INVALID_ARGUMENT;
+  }
+  if (!this->isLinkUp() && (MCCMSG_HELLO != poMsg->type)) {                     // the recovery says HELLO
+    this->discardMsg(poMsg);
+    return MCC_LINK_DOWN;
+  }
+
+  // the sequence number identifies the request
+  iChannel = this->channelOf(poMsg->type);
+  pthread_mutex_lock(&m_mtxTx);
+  ret = this->waitCredit(iChannel, bWait);
+  if (MCC_OK != ret) {
+    pthread_mutex_unlock(&m_mtxTx);
+    this->discardMsg(poMsg);
+    return ret;
+  }
+  u32Seq = m_au32TxSeq[iChannel] + 1;
+  if (!u32Seq) u32Seq = 1;                                                      // 0 is never used
+
+  // register the request before sending it, the reply may come immediately
+  pthread_mutex_lock(&m_mtxPending);
+  for (i = 0; i < CMCC_PENDING_MAX; ++i) {
+    if (!m_aoPending[i].u32Id) {
+      u32Id = CMCC_REQUEST_ID(u32Seq, iChannel);
+      m_aoPending[i].u32Id    = u32Id;
+      m_aoPending[i].i32Type  = poMsg->type;
+      m_aoPending[i].bTimed   = (CMCC_TIMEOUT_INF != u32TimeoutMs);
+      m_aoPending[i].u64SentUs = CMccClock::nowUs();
+      m_aoPending[i].pfnReply = pfnReply;
+      m_aoPending[i].pvCtx    = pvCtx;
+      if (m_aoPending[i].bTimed) {
+        timespec_fromNow(&m_aoPending[i].oDeadline, u32TimeoutMs);
+        pthread_cond_signal(&m_condPending);
+      }
+      this->countPending();
+      break;
+    }
+  }
+  pthread_mutex_unlock(&m_mtxPending);
 
-  poData->x = pMsg->fDataX;
-  poData->y = pMsg->fDataY;
-  poData->z = pMsg->fDataZ;
+  if (u32Id) ret = this->sendFrame(poMsg, size, iChannel, u32Seq);
+  pthread_mutex_unlock(&m_mtxTx);
 
-  this->freeMsg(pMsg);
+  if (!u32Id) {
+    printf("sendRequest too many pending requests\n");
+    this->discardMsg(poMsg);
+    return MCC_BUSY;
+  }
+  if (pu32Id) *pu32Id = u32Id;
+
+  if (MCC_OK != ret) {
+    if (!this->takePending(u32Id, 0, &oPending)) return MCC_OK;                 // already timed out or cancelled, the callback has been called
+  }
   return ret;
 }
 
 //******************************************************************************
+
+bool CMcc::cancelRequest (uint32_t u32Id)
+{
+  TMccPending oPending;
+
+  if (!this->takePending(u32Id, 0, &oPending)) return false;
+  oPending.pfnReply(oPending.pvCtx, oPending.u32Id, MCC_CANCELLED, NULL, 0);
+  return true;
+}
+
+//******************************************************************************
+
+bool CMcc::takePending (uint32_t u32Id, int32_t i32Type, TMccPending * poPending)
+{
+  int iFound = -1;
+  int i;
+
+  pthread_mutex_lock(&m_mtxPending);
+  for (i = 0; i < CMCC_PENDING_MAX; ++i) {
+    if (!m_aoPending[i].u32Id) continue;
+    if (u32Id) {                                                                // by identifier
+      if (m_aoPending[i].u32Id == u32Id) {
+        iFound = i;
+        break;
+      }
+    } else if (m_aoPending[i].i32Type == i32Type) {                             // by reply type, the oldest request first
+      if ((iFound < 0) || ((int32_t)(m_aoPending[i].u32Id - m_aoPending[iFound].u32Id) < 0)) {
+        iFound = i;
+      }
+    }
+  }
+  if (iFound >= 0) {
+    *poPending = m_aoPending[iFound];
+    m_aoPending[iFound].u32Id = 0;
+    this->countPending();
+  }
+  pthread_mutex_unlock(&m_mtxPending);
+
+  return (iFound >= 0);
+}
+
+//******************************************************************************
+
+void CMcc::checkSeq (const TMccHdr * poHdr)
+{
+  uint32_t  * pu32Next = &m_au32RxSeqNext[(poHdr->u8Flags & MCC_HDR_FLAG_BULK) ? CMCC_CHANNEL_BULK : CMCC_CHANNEL_CONTROL];
+  int32_t     i32Diff  = 0;
+
+  if (!poHdr->u32Seq) return;                                                   // not numbered
+
+  if ((MCCMSG_HELLO == poHdr->type) || (MCCMSG_READY == poHdr->type)) {         // HELLO and READY start a new session
+    memset(m_au32RxSeqNext, 0, sizeof(m_au32RxSeqNext));
+  } else if (*pu32Next) {
+    i32Diff = (int32_t)(poHdr->u32Seq - *pu32Next);
+  }
+
+  if (i32Diff > 0) {
+    __atomic_add_fetch(&m_oStats.u32RxLost, i32Diff, __ATOMIC_RELAXED);
+    printf("receiver %d message(s) lost before seq %u\n", i32Diff, poHdr->u32Seq);
+  } else if (i32Diff < 0) {
+    __atomic_add_fetch(&m_oStats.u32RxReordered, 1, __ATOMIC_RELAXED);
+    printf("receiver message seq %u out of order\n", poHdr->u32Seq);
+    return;                                                                     // keep expecting the newer one
+  }
+  *pu32Next = poHdr->u32Seq + 1;
+  if (!*pu32Next) *pu32Next = 1;
+}
+
+//******************************************************************************
+
+int CMcc::transact (TMccMsg         * poMsg,
+                    uint32_t          u32TimeoutMs,
+                    void            * pvReply,
+                    MCC_MEM_SIZE      maxSize,
+                    MCC_MEM_SIZE    * pSize,
+                    MCC_MEM_SIZE      size)
+{
+  TMccTransact  oTransact;
+  int32_t       i32Type;
+  int           ret;
+
+  i32Type = poMsg->type;                                                        // the buffer is gone after sendRequest
+
+  pthread_mutex_init(&oTransact.mtx, NULL);
+  pthread_cond_init(&oTransact.cond, NULL);
+  oTransact.bDone   = false;
+  oTransact.iStatus = MCC_OK;
+  oTransact.pvReply = pvReply;
+  oTransact.maxSize = maxSize;
+  oTransact.size    = 0;
+
+  ret = this->sendRequest(poMsg, u32TimeoutMs, CMcc::transactReply, &oTransact,
+                          NULL, size);
+  if (MCC_OK == ret) {
+    pthread_mutex_lock(&oTransact.mtx);
+    while (!oTransact.bDone) pthread_cond_wait(&oTransact.cond, &oTransact.mtx);
+    pthread_mutex_unlock(&oTransact.mtx);
+    ret = oTransact.iStatus;
+    if (MCC_TIMEOUT == ret) printf("transact timeout: type %d\n", i32Type);
+    if (pSize) *pSize = oTransact.size;
+  }
+
+  pthread_cond_destroy(&oTransact.cond);
+  pthread_mutex_destroy(&oTransact.mtx);
+  return ret;
+}
+
+//******************************************************************************
+
+void CMcc::transactReply (void            * pvCtx,
+                          uint32_t          u32Id,
+                          int               iStatus,
+                          const TMccMsg   * poReply,
+                          MCC_MEM_SIZE      size)
+{
+  TMccTransact * poTransact = (TMccTransact*)pvCtx;
+
+  (void)u32Id;
+  pthread_mutex_lock(&poTransact->mtx);
+  if (poReply) {
+    poTransact->size = (size < poTransact->maxSize) ? size : poTransact->maxSize;
+    memcpy(poTransact->pvReply, poReply, poTransact->size);
+  }
+  poTransact->iStatus = iStatus;
+  poTransact->bDone   = true;
+  pthread_cond_signal(&poTransact->cond);
+  pthread_mutex_unlock(&poTransact->mtx);
+}
+
+//******************************************************************************
+
+int CMcc::setLedOn (void)
+{
+  return this->send<MCCMSG_LED_ON>(this->alloc<MCCMSG_LED_ON>());
+}
+
+//******************************************************************************
+
+int CMcc::setLedOff (void)
+{
+  return this->send<MCCMSG_LED_OFF>(this->alloc<MCCMSG_LED_OFF>());
+}
+
+//******************************************************************************
+
+int CMcc::setLedAuto (void)
+{
+  return this->send<MCCMSG_LED_AUTO>(this->alloc<MCCMSG_LED_AUTO>());
+}
+
+//******************************************************************************
+
+int CMcc::getAccelType (int32_t * pi32Type)
+{
+  TMccMsg     oReply;
+  int         ret;
+
+  if (!pi32Type) return MCC_INVALID_ARGUMENT;
+
+  ret = this->send<MCCMSG_ACCEL_INFO>(this->alloc<MCCMSG_ACCEL_INFO>(), &oReply);
+  if (MCC_OK != ret) return ret;
+
+  *pi32Type = oReply.iAccelType;
+  return MCC_OK;
+}
+
+//******************************************************************************
+
+int CMcc::getAccelData (TAccelData * poData)
+{
+  TMccAccelDataMsg    oReply;
+  MCC_MEM_SIZE        size;
+  int                 ret;
+
+  if (!poData) return MCC_INVALID_ARGUMENT;
+
+  ret = this->send<MCCMSG_ACCEL_DATA>(this->alloc<MCCMSG_ACCEL_DATA>(), &oReply, &size);
+  if (MCC_OK != ret) return ret;
+
+  return CMcc::decodeAccelData((TMccMsg*)&oReply, size, poData, &m_oClock);
+}
+
+//******************************************************************************
+
+int CMcc::setAccelConfig (const TMccAccelConfig   * poReq,
+                          uint32_t                  u32Set,
+                          TMccAccelConfigMsg      * poReply)
+{
+  MCC_MEM_SIZE    size;
+  int             ret;
+
+  if (!poReply || (u32Set && !poReq)) return MCC_INVALID_ARGUMENT;
+  if (m_u8Version < MCC_PROTOCOL_ACCEL_CONFIG) return MCC_VERSION_FAILURE;
+
+  ret = this->send<MCCMSG_ACCEL_CONFIG>(this->allocAccelConfig(poReq, u32Set), poReply, &size);
+  if (MCC_OK != ret) return ret;
+  if (size < sizeof(TMccAccelConfigMsg)) return MCC_RECV_FAILURE;
+  return MCC_OK;
+}
+
+//******************************************************************************
+
+int CMcc::getAccelConfig (TMccAccelConfigMsg * poReply)
+{
+  return this->setAccelConfig(NULL, 0, poReply);
+}
+
+//******************************************************************************
+
+int CMcc::setAccelFilter (const TMccAccelFilter   * poReq,
+                          TMccAccelFilterMsg      * poReply)
+{
+  MCC_MEM_SIZE    size;
+  int             ret;
+
+  if (!poReply) return MCC_INVALID_ARGUMENT;
+  if (m_u8Version < MCC_PROTOCOL_FILTER) return MCC_VERSION_FAILURE;
+
+  ret = this->send<MCCMSG_ACCEL_FILTER>(this->allocAccelFilter(poReq), poReply, &size);
+  if (MCC_OK != ret) return ret;
+  if (size < sizeof(TMccAccelFilterMsg)) return MCC_RECV_FAILURE;
+  return MCC_OK;
+}
+
+//******************************************************************************
+
+int CMcc::getAccelFilter (TMccAccelFilterMsg * poReply)
+{
+  return this->setAccelFilter(NULL, poReply);
+}
+
+//******************************************************************************
+
+int CMcc::setAccelFeatures (const TMccAccelFeatures * poReq,
+                            TMccAccelFeaturesMsg    * poReply)
+{
+  MCC_MEM_SIZE    size;
+  int             ret;
+
+  if (!poReply) return MCC_INVALID_ARGUMENT;
+  if (m_u8Version < MCC_PROTOCOL_FEATURES) return MCC_VERSION_FAILURE;
+
+  ret = this->send<MCCMSG_ACCEL_FEATURES>(this->allocAccelFeatures(poReq), poReply, &size);
+  if (MCC_OK != ret) return ret;
+  if (size < sizeof(TMccAccelFeaturesMsg)) return MCC_RECV_FAILURE;
+  return MCC_OK;
+}
+
+//******************************************************************************
+
+int CMcc::getAccelFeatures (TMccAccelFeaturesMsg * poReply)
+{
+  return this->setAccelFeatures(NULL, poReply);
+}
+
+//******************************************************************************
+
+int CMcc::setAccelEvents (const TMccAccelEvents * poReq,
+                          TMccAccelEventsMsg    * poReply)
+{
+  MCC_MEM_SIZE    size;
+  int             ret;
+
+  if (!poReply) return MCC_INVALID_ARGUMENT;
+  if (m_u8Version < MCC_PROTOCOL_EVENTS) return MCC_VERSION_FAILURE;
+
+  ret = this->send<MCCMSG_ACCEL_EVENTS>(this->allocAccelEvents(poReq), poReply, &size);
+  if (MCC_OK != ret) return ret;
+  if (size < sizeof(TMccAccelEventsMsg)) return MCC_RECV_FAILURE;
+  return MCC_OK;
+}
+
+//******************************************************************************
+
+int CMcc::getAccelEvents (TMccAccelEventsMsg * poReply)
+{
+  return this->setAccelEvents(NULL, poReply);
+}
+
+//******************************************************************************
+
+int CMcc::decodeAccelData (const TMccMsg    * poReply,
+                           MCC_MEM_SIZE       size,
+                           TAccelData       * poData,
+                           const CMccClock  * poClock)
+{
+  const TMccAccelDataMsg * pMsg = (const TMccAccelDataMsg*)poReply;
+
+  if ((size < sizeof(TMccMsg)) || (MCCMSG_ACCEL_DATA != pMsg->type)) {
+    printf("decodeAccelData invalid message: type %d, size %d\n", pMsg->type, size);
+    return MCC_RECV_FAILURE;
+  }
+
+  poData->x = pMsg->afData[0];
+  poData->y = pMsg->afData[1];
+  poData->z = pMsg->afData[2];
+  if (size >= sizeof(TMccAccelDataMsg)) {                                       // MCC_PROTOCOL_TIMESTAMPS and higher
+    poData->timestamp = pMsg->u32Timestamp;
+    poData->timeUs    = poClock ? poClock->toA5Us(pMsg->u32TimeUs) : 0;
+  } else {
+    poData->timestamp = 0;
+    poData->timeUs    = 0;
+  }
+  return MCC_OK;
+}
+
+//******************************************************************************
+
+int CMcc::getAccelStream (TAccelData  * paoData,
+                          uint32_t      u32Size,
+                          uint32_t    * pu32Count,
+                          uint32_t    * pu32Lost)
+{
+  TMccMsg             * poMsg;
+  union {
+    TMccAccelStreamMsg  oStream;
+    TMccAccelRawMsg     oRaw;
+  }                     oReply;
+  MCC_MEM_SIZE          size;
+  bool                  bRaw = this->getAccelRaw();
+  int                   ret;
+
+  if (!paoData || !pu32Count) return MCC_INVALID_ARGUMENT;
+
+  poMsg = this->allocMsg();
+  if (!poMsg) return MCC_SEND_FAILURE;
+  poMsg->type         = bRaw ? MCCMSG_ACCEL_RAW_STREAM : MCCMSG_ACCEL_STREAM;
+  poMsg->u32Since     = __atomic_load_n(&m_u32StreamSince, __ATOMIC_RELAXED);
+  poMsg->u32MaxCount  = u32Size;
+  ret = this->transact(poMsg, m_u32Timeout, &oReply, sizeof(oReply), &size);
+  if (MCC_OK != ret) return ret;
+
+  if (bRaw) {
+    ret = CMcc::decodeAccelRaw((TMccMsg*)&oReply, size, MCCMSG_ACCEL_RAW_STREAM,
+                               paoData, u32Size, pu32Count, pu32Lost, &m_oClock);
+  } else {
+    ret = CMcc::decodeAccelStream((TMccMsg*)&oReply, size, MCCMSG_ACCEL_STREAM,
+                                  paoData, u32Size, pu32Count, pu32Lost, &m_oClock);
+  }
+  if ((MCC_OK == ret) && *pu32Count) {
+    __atomic_store_n(&m_u32StreamSince, paoData[*pu32Count-1].timestamp, __ATOMIC_RELAXED);
+  }
+  return ret;
+}
+
+//******************************************************************************
+
+int CMcc::decodeAccelStream (const TMccMsg  * poReply,
+                             MCC_MEM_SIZE     size,
+                             int32_t          i32Type,
+                             TAccelData     * paoData,
+                             uint32_t         u32Size,
+                             uint32_t       * pu32Count,
+                             uint32_t       * pu32Lost,
+                             const CMccClock  * poClock)
+{
+  const TMccAccelStreamMsg * pMsg = (const TMccAccelStreamMsg*)poReply;
+  const uint32_t           * pu32TimeUs = NULL;
+  uint32_t                   i;
+
+  if (   (size < MCC_ACCEL_STREAM_HEADER_SIZE)
+      || (i32Type != pMsg->type)
+      || (pMsg->u32Count > u32Size)
+      || (size < MCC_ACCEL_STREAM_HEADER_SIZE + pMsg->u32Count * sizeof(TMccAccelSample))) {
+    printf("decodeAccelStream invalid message: type %d, size %d\n", pMsg->type, size);
+    return MCC_RECV_FAILURE;
+  }
+
+  // the times follow the samples if the M4 knows them
+  if (poClock && (size >= MCC_ACCEL_STREAM_HEADER_SIZE + pMsg->u32Count * (sizeof(TMccAccelSample) + sizeof(uint32_t)))) {
+    pu32TimeUs = MCC_ACCEL_STREAM_TIMES(pMsg);
+  }
+
+  for (i = 0; i < pMsg->u32Count; ++i) {
+    paoData[i].x          = pMsg->aoSamples[i].afData[0];
+    paoData[i].y          = pMsg->aoSamples[i].afData[1];
+    paoData[i].z          = pMsg->aoSamples[i].afData[2];
+    paoData[i].timestamp  = pMsg->aoSamples[i].u32Timestamp;
+    paoData[i].timeUs     = pu32TimeUs ? poClock->toA5Us(pu32TimeUs[i]) : 0;
+  }
+  *pu32Count = pMsg->u32Count;
+  if (pu32Lost) *pu32Lost = pMsg->u32Lost;
+  return MCC_OK;
+}
+
+//******************************************************************************
+
+int CMcc::decodeAccelRaw (const TMccMsg  * poReply,
+                          MCC_MEM_SIZE     size,
+                          int32_t          i32Type,
+                          TAccelData     * paoData,
+                          uint32_t         u32Size,
+                          uint32_t       * pu32Count,
+                          uint32_t       * pu32Lost,
+                          const CMccClock  * poClock,
+                          uint32_t         u32Stride)
+{
+  const TMccAccelRawMsg * pMsg = (const TMccAccelRawMsg*)poReply;
+  const uint32_t        * pu32TimeUs;
+  float                   afData[3 * MCC_ACCEL_RAW_MAX_SAMPLES];
+  uint32_t                i;
+
+  if (   (size < MCC_ACCEL_RAW_HEADER_SIZE)
+      || (i32Type != pMsg->type)
+      || (pMsg->u32Count > u32Size)
+      || (pMsg->u32Count > MCC_ACCEL_RAW_MAX_SAMPLES)
+      || (size < MCC_ACCEL_RAW_SIZE(pMsg->u32Count))
+      || !pMsg->oScale.u16CountsPerG) {
+    printf("decodeAccelRaw invalid message: type %d, size %d\n", pMsg->type, size);
+    return MCC_RECV_FAILURE;
+  }
+
+  // the whole batch at once, then spread to the samples
+  CMccRaw::toG(&pMsg->ai16Data[0][0], afData, 3 * pMsg->u32Count,
+               1.0f / pMsg->oScale.u16CountsPerG);
+  pu32TimeUs = MCC_ACCEL_RAW_TIMES(pMsg);
+  for (i = 0; i < pMsg->u32Count; ++i) {
+    paoData[i].x          = afData[3*i];
+    paoData[i].y          = afData[3*i + 1];
+    paoData[i].z          = afData[3*i + 2];
+    paoData[i].timestamp  = pMsg->u32First + i * u32Stride;
+    paoData[i].timeUs     = poClock ? poClock->toA5Us(pu32TimeUs[i]) : 0;
+  }
+  *pu32Count = pMsg->u32Count;
+  if (pu32Lost) *pu32Lost = pMsg->u32Lost;
+  return MCC_OK;
+}
+
+//******************************************************************************
+
+int CMcc::decodeAccelSummary (const TMccMsg    * poMsg,
+                              MCC_MEM_SIZE       size,
+                              TAccelSummary    * poSummary,
+                              const CMccClock  * poClock)
+{
+  const TMccAccelSummaryMsg * pMsg = (const TMccAccelSummaryMsg*)poMsg;
+
+  if (   (size < sizeof(TMccAccelSummaryMsg))
+      || (MCCMSG_ACCEL_SUMMARY != pMsg->type)
+      || (pMsg->oFeatures.u8Bands > MCC_ACCEL_FEATURES_MAX_BANDS)) {
+    printf("decodeAccelSummary invalid message: type %d, size %d\n", pMsg->type, size);
+    return MCC_RECV_FAILURE;
+  }
+
+  poSummary->window     = pMsg->u32Window;
+  poSummary->timestamp  = pMsg->u32First;
+  poSummary->timeUs     = poClock ? poClock->toA5Us(pMsg->u32TimeUs) : 0;
+  poSummary->periodUs   = pMsg->u32PeriodUs;
+  poSummary->features   = pMsg->oFeatures;
+  memcpy(poSummary->axes, pMsg->aoAxes, sizeof(poSummary->axes));
+  return MCC_OK;
+}
+
+//******************************************************************************
+
+int CMcc::decodeAccelEvents (const TMccMsg    * poMsg,
+                             MCC_MEM_SIZE       size,
+                             TAccelEvent      * paoEvents,
+                             uint32_t           u32Size,
+                             uint32_t         * pu32Count,
+                             uint32_t         * pu32Lost,
+                             const CMccClock  * poClock)
+{
+  const TMccAccelEventMsg * pMsg = (const TMccAccelEventMsg*)poMsg;
+  const TMccAccelEvent    * poEvent;
+  uint32_t                  i;
+
+  if (   (size < MCC_ACCEL_EVENT_HEADER_SIZE)
+      || (MCCMSG_ACCEL_EVENT != pMsg->type)
+      || (pMsg->u32Count > u32Size)
+      || (pMsg->u32Count > MCC_ACCEL_EVENT_MAX)
+      || (size < MCC_ACCEL_EVENT_HEADER_SIZE + pMsg->u32Count * sizeof(TMccAccelEvent))) {
+    printf("decodeAccelEvents invalid message: type %d, size %d\n", pMsg->type, size);
+    return MCC_RECV_FAILURE;
+  }
+
+  for (i = 0; i < pMsg->u32Count; ++i) {
+    poEvent                 = &pMsg->aoEvents[i];
+    paoEvents[i].number     = pMsg->u32First + i;
+    paoEvents[i].timestamp  = poEvent->u32Timestamp;
+    paoEvents[i].timeUs     = poClock ? poClock->toA5Us(poEvent->u32TimeUs) : 0;
+    paoEvents[i].type       = poEvent->u8Type;
+    paoEvents[i].axes       = poEvent->u8Axes;
+    paoEvents[i].negative   = poEvent->u8Negative;
+  }
+  *pu32Count = pMsg->u32Count;
+  if (pu32Lost) *pu32Lost = pMsg->u32Lost;
+  return MCC_OK;
+}
+
+//******************************************************************************
+
+int CMcc::subscribeAccel (uint32_t u32PeriodMs, uint32_t * pu32GrantedMs)
+{
+  TMccMsg             * poMsg;
+  TMccMsg               oReply;
+  TMccAccelFilterMsg    oFilterReply;
+  int                   ret;
+
+  // the M4 keeps the chain of the previous subscriber, perhaps another process
+  if (m_u8Version >= MCC_PROTOCOL_FILTER) {
+    ret = this->send<MCCMSG_ACCEL_FILTER>(this->allocAccelFilterRenewal(), &oFilterReply);
+    if (MCC_OK != ret) return ret;
+  }
+
+  poMsg = this->alloc<MCCMSG_ACCEL_SUBSCRIBE>();
+  if (!poMsg) return MCC_SEND_FAILURE;
+  poMsg->u32PeriodMs  = u32PeriodMs;
+  poMsg->u32Credits   = CMCC_PUSH_CREDITS;                                      // ignored by the M4 before MCC_PROTOCOL_CREDITS
+  poMsg->u32Format    = this->getAccelRaw() ? MCC_ACCEL_FORMAT_RAW : MCC_ACCEL_FORMAT_FLOAT;
+  ret = this->send<MCCMSG_ACCEL_SUBSCRIBE>(poMsg, &oReply);
+  if (MCC_OK != ret) return ret;
+
+  m_u32PushPeriod = u32PeriodMs;
+  __atomic_store_n(&m_bSubscribed, true, __ATOMIC_RELAXED);
+  if (pu32GrantedMs) *pu32GrantedMs = oReply.u32PeriodMs;
+  return MCC_OK;
+}
+
+//******************************************************************************
+
+int CMcc::unsubscribeAccel (void)
+{
+  TMccMsg   * poMsg;
+  TMccMsg     oReply;
+  int         ret;
+
+  poMsg = this->alloc<MCCMSG_ACCEL_UNSUBSCRIBE>();
+  if (!poMsg) return MCC_SEND_FAILURE;
+  poMsg->u32PeriodMs  = 0;
+  ret = this->send<MCCMSG_ACCEL_UNSUBSCRIBE>(poMsg, &oReply);
+  if (MCC_OK != ret) return ret;
+
+  __atomic_store_n(&m_bSubscribed, false, __ATOMIC_RELAXED);
+  return MCC_OK;
+}
+
+//******************************************************************************
+
+uint32_t CMcc::readAccelSamples (TAccelData  * paoData,
+                                 uint32_t      u32Size,
+                                 uint32_t    * pu32Lost)
+{
+  if (pu32Lost) {
+    *pu32Lost = __atomic_exchange_n(&m_u32PushLost, 0, __ATOMIC_RELAXED)
+              + m_oAccelRing.takeDropped();
+  }
+  return m_oAccelRing.pop(paoData, u32Size);
+}
+
+//******************************************************************************
+
+uint32_t CMcc::readAccelSummaries (TAccelSummary  * paoSummaries,
+                                   uint32_t         u32Size,
+                                   uint32_t       * pu32Lost)
+{
+  if (pu32Lost) {
+    *pu32Lost = __atomic_exchange_n(&m_u32SummaryLost, 0, __ATOMIC_RELAXED)
+              + m_oSummaryRing.takeDropped();
+  }
+  return m_oSummaryRing.pop(paoSummaries, u32Size);
+}
+
+//******************************************************************************
+
+uint32_t CMcc::readAccelEvents (TAccelEvent  * paoEvents,
+                                uint32_t       u32Size,
+                                uint32_t     * pu32Lost)
+{
+  if (pu32Lost) {
+    *pu32Lost = __atomic_exchange_n(&m_u32EventLost, 0, __ATOMIC_RELAXED)
+              + m_oEventRing.takeDropped();
+  }
+  return m_oEventRing.pop(paoEvents, u32Size);
+}
+
+//******************************************************************************
+
+void CMcc::setAccelEventHandler (TAccelEventFn pfnHandler, void * pvCtx)
+{
+  pthread_mutex_lock(&m_mtxPending);
+  m_pfnAccelEvent   = pfnHandler;
+  m_pvAccelEventCtx = pvCtx;
+  pthread_mutex_unlock(&m_mtxPending);
+}
+
+//******************************************************************************
+
+int CMcc::readAccelSnapshot (TAccelData * poData)
+{
+  volatile TMccAccelSnapshot  * poSnapshot = m_poSnapshot;
+  uint32_t                      u32Seq;
+  uint32_t                      u32TimeUs;
+  int                           i;
+
+  if (!poData) return MCC_INVALID_ARGUMENT;
+  if (!poSnapshot || (MCC_SNAPSHOT_MAGIC != poSnapshot->u32Magic)) return MCC_INIT_FAILURE;  // M4 not running (or without the snapshot)
+
+  for (i = 0; i < CMCC_SNAPSHOT_RETRIES; ++i) {
+    u32Seq = poSnapshot->u32Seq;
+    if (u32Seq & 1) {
+      sched_yield();                                                            // the M4 is just updating it
+      continue;
+    }
+    MCC_SNAPSHOT_BARRIER();
+    poData->x         = poSnapshot->afData[0];
+    poData->y         = poSnapshot->afData[1];
+    poData->z         = poSnapshot->afData[2];
+    poData->timestamp = poSnapshot->u32Timestamp;
+    u32TimeUs         = poSnapshot->u32TimeUs;
+    MCC_SNAPSHOT_BARRIER();
+    if (poSnapshot->u32Seq == u32Seq) {
+      poData->timeUs  = m_oClock.toA5Us(u32TimeUs);
+      ++poSnapshot->u32ReadCnt;                                                 // keeps the M4 reading, only the change matters
+      return MCC_OK;
+    }
+  }
+  return MCC_BUSY;
+}
+
+//******************************************************************************
+
+bool CMcc::hasCredit (int iChannel)
+{
+  bool bCredit;
+
+  pthread_mutex_lock(&m_mtxTx);
+  bCredit = (m_u8Version < MCC_PROTOCOL_CREDITS)
+         || (MCC_CREDIT_IN_FLIGHT(m_au32TxSeq[iChannel], m_au16TxAck[iChannel]) < MCC_CREDITS_A5);
+  pthread_mutex_unlock(&m_mtxTx);
+  return bCredit;
+}
+
+//******************************************************************************
+
+void CMcc::syncClock (void)
+{
+  TMccPingMsg * poPing;
+
+  // skip the exchange rather than drop it if the channel is busy
+  if (!this->hasCredit(CMCC_CHANNEL_CONTROL)) return;
+
+  poPing = this->alloc<MCCMSG_PING>();
+  if (!poPing) return;
+  poPing->u32A5TimeUs   = (uint32_t)CMccClock::nowUs();
+  poPing->u32M4RxTimeUs = 0;
+  poPing->u32M4TxTimeUs = 0;
+  this->sendRequest((TMccMsg*)poPing, CMCC_CLOCK_PERIOD, CMcc::clockReply, this,
+                    NULL, MCC_PING_HEADER_SIZE);
+}
+
+//******************************************************************************
+
+void CMcc::clockReply (void            * pvCtx,
+                       uint32_t          u32Id,
+                       int               iStatus,
+                       const TMccMsg   * poReply,
+                       MCC_MEM_SIZE      size)
+{
+  const TMccPingMsg * poPong = CMcc::recv<MCCMSG_PONG>(poReply, size);
+  uint64_t            u64NowUs = CMccClock::nowUs();
+
+  (void)u32Id;
+  if ((MCC_OK != iStatus) || !poPong || (size < MCC_PING_HEADER_SIZE)) return;
+
+  // the echoed send time has 32 bits only, it is a recent one
+  ((CMcc*)pvCtx)->m_oClock.addExchange(u64NowUs - (uint32_t)((uint32_t)u64NowUs - poPong->u32A5TimeUs),
+                                       poPong->u32M4RxTimeUs, poPong->u32M4TxTimeUs,
+                                       u64NowUs);
+}
+
+//******************************************************************************
+
+void CMcc::heartbeat (void)
+{
+  TMccMsg   * poMsg;
+  TMccMsg     oWake;
+  uint64_t    u64SilentUs;
+
+  if (!this->isLinkUp()) {                                                      // next recovery attempt, by the receiver thread
+    __atomic_store_n(&m_bReopen, true, __ATOMIC_RELAXED);
+    oWake.type = CMCC_MSGTYPE_WAKE;
+    m_poTransport->sendLocalMsg(&oWake, sizeof(oWake));                         // its receive timeout wakes it up otherwise
+    return;
+  }
+
+  // any message from the M4 proves it alive, the heartbeat makes sure there is one
+  u64SilentUs = CMccClock::nowUs() - __atomic_load_n(&m_u64RxUs, __ATOMIC_RELAXED);
+  if (u64SilentUs >= CMCC_LINK_TIMEOUT * 1000ull) {
+    this->linkLost(false, (uint32_t)(u64SilentUs / 1000));
+    return;
+  }
+  if (!this->hasCredit(CMCC_CHANNEL_CONTROL)) return;                           // busy, the replies to come will do
+
+  poMsg = this->alloc<MCCMSG_HEARTBEAT>();
+  if (!poMsg) return;
+  poMsg->u32UptimeMs  = 0;
+  this->sendRequest(poMsg, CMCC_LINK_TIMEOUT, CMcc::heartbeatReply, this);
+}
+
+//******************************************************************************
+
+void CMcc::heartbeatReply (void            * pvCtx,
+                           uint32_t          u32Id,
+                           int               iStatus,
+                           const TMccMsg   * poReply,
+                           MCC_MEM_SIZE      size)
+{
+  CMcc          * poThis = (CMcc*)pvCtx;
+  const TMccMsg * poBeat = CMcc::recv<MCCMSG_HEARTBEAT>(poReply, size);
+  uint32_t        u32PrevMs;
+
+  (void)u32Id;
+  if ((MCC_OK != iStatus) || !poBeat || (size < sizeof(TMccMsg))) {
+    return;                                                                     // the silence counts, not the timeouts
+  }
+
+  u32PrevMs = poThis->m_u32M4UptimeMs;
+  poThis->m_u32M4UptimeMs = poBeat->u32UptimeMs;
+  if (poBeat->u32UptimeMs < u32PrevMs) {                                        // lost everything the previous boot knew
+    poThis->linkLost(true, poBeat->u32UptimeMs);
+  }
+}
+
+//******************************************************************************
+
+void CMcc::linkLost (bool bReboot, uint32_t u32DetectMs)
+{
+  TMccPending   oPending;
+  uint32_t      au32Ids[CMCC_PENDING_MAX];
+  int           i;
+
+  pthread_mutex_lock(&m_mtxPending);
+  if (!m_bLinkUp) {
+    pthread_mutex_unlock(&m_mtxPending);
+    return;
+  }
+  __atomic_store_n(&m_bLinkUp, false, __ATOMIC_RELAXED);
+  m_u64LostUs   = CMccClock::nowUs();
+  m_bClockSync  = false;                                                        // until the new session
+  ++m_oLinkStats.u32Losses;
+  if (bReboot) ++m_oLinkStats.u32Reboots;
+  m_oLinkStats.u32LastDetectMs = u32DetectMs;
+  if (u32DetectMs > m_oLinkStats.u32MaxDetectMs) m_oLinkStats.u32MaxDetectMs = u32DetectMs;
+  clock_gettime(CLOCK_MONOTONIC, &m_oHeartbeatNext);                            // first recovery attempt at once
+  pthread_cond_signal(&m_condPending);
+  for (i = 0; i < CMCC_PENDING_MAX; ++i) au32Ids[i] = m_aoPending[i].u32Id;
+  pthread_mutex_unlock(&m_mtxPending);
+
+  printf("MCC link lost: %s %u ms ago\n", bReboot ? "M4 rebooted" : "last M4 message", u32DetectMs);
+
+  this->forgetInFlight();                                                       // the senders waiting for credit fail now
+
+  // the replies are not coming, fail the requests now rather than at their timeouts
+  for (i = 0; i < CMCC_PENDING_MAX; ++i) {
+    if (au32Ids[i] && this->takePending(au32Ids[i], 0, &oPending)) {
+      __atomic_add_fetch(&m_oStats.u32ReqTimeouts, 1, __ATOMIC_RELAXED);
+      oPending.pfnReply(oPending.pvCtx, oPending.u32Id, MCC_TIMEOUT, NULL, 0);
+    }
+  }
+}
+
+//******************************************************************************
+
+void CMcc::forgetInFlight (void)
+{
+  int i;
+
+  pthread_mutex_lock(&m_mtxTx);
+  for (i = 0; i < CMCC_CHANNEL_COUNT; ++i) m_au16TxAck[i] = (uint16_t)m_au32TxSeq[i];
+  pthread_cond_broadcast(&m_condTx);
+  pthread_mutex_unlock(&m_mtxTx);
+}
+
+//******************************************************************************
+
+void CMcc::recover (void)
+{
+  TMccMsg * poMsg;
+
+  if (MCC_OK != m_poTransport->reopen()) return;                                // the timer thread tries again
+  this->forgetInFlight();                                                       // the previous attempts got no answer
+
+  poMsg = this->alloc<MCCMSG_HELLO>();
+  if (!poMsg) return;
+  poMsg->u32Version = MCC_PROTOCOL_VERSION;
+  this->sendRequest(poMsg, CMCC_HEARTBEAT_PERIOD, CMcc::helloReply, this);
+}
+
+//******************************************************************************
+
+void CMcc::helloReply (void            * pvCtx,
+                       uint32_t          u32Id,
+                       int               iStatus,
+                       const TMccMsg   * poReply,
+                       MCC_MEM_SIZE      size)
+{
+  (void)u32Id;
+  if (   (MCC_OK != iStatus) || (size < sizeof(TMccMsg)) || (MCCMSG_HELLO != poReply->type)
+      || (poReply->u32Version < MCC_PROTOCOL_FRAMED)) {
+    return;                                                                     // the timer thread tries again
+  }
+  ((CMcc*)pvCtx)->relink(poReply->u32Version);
+}
+
+//******************************************************************************
+
+void CMcc::relink (uint32_t u32Version)
+{
+  TMccMsg         * poMsg;
+  TMccAccelConfig   oAccelConfig;
+  uint32_t          u32AccelSet;
+  TMccAccelFeatures oAccelFeatures;
+  TMccAccelEvents   oAccelEvents;
+  uint64_t          u64NowUs = CMccClock::nowUs();
+  uint32_t          u32RecoverMs;
+  int               i;
+
+  pthread_mutex_lock(&m_mtxPending);
+  if (m_bLinkUp) {                                                              // late reply to an earlier attempt
+    pthread_mutex_unlock(&m_mtxPending);
+    return;
+  }
+
+  // a new session, perhaps with another M4 build (the framed versions have
+  // the same prefix, the buffers allocated meanwhile stay valid)
+  m_u8Version     = (u32Version < MCC_PROTOCOL_VERSION) ? u32Version : MCC_PROTOCOL_VERSION;
+  m_u32M4UptimeMs = 0;
+  __atomic_store_n(&m_u32StreamSince, 0, __ATOMIC_RELAXED);                     // a rebooted M4 numbers the samples from the start
+  __atomic_store_n(&m_u32PushUnacked, 0, __ATOMIC_RELAXED);
+  for (i = 0; i < CMCC_CHANNEL_COUNT; ++i) __atomic_store_n(&m_au32RxSeqLast[i], 0, __ATOMIC_RELAXED);
+  m_oClock.reset();
+  m_bClockSync    = (m_u8Version >= MCC_PROTOCOL_TIMESTAMPS);
+  m_u32ClockCount = 0;
+  clock_gettime(CLOCK_MONOTONIC, &m_oClockNext);
+  m_bHeartbeat    = (m_u8Version >= MCC_PROTOCOL_HEARTBEAT);
+  timespec_fromNow(&m_oHeartbeatNext, CMCC_HEARTBEAT_PERIOD);
+  __atomic_store_n(&m_u64RxUs, u64NowUs, __ATOMIC_RELAXED);
+
+  u32RecoverMs = (uint32_t)((u64NowUs - m_u64LostUs) / 1000);
+  ++m_oLinkStats.u32Recoveries;
+  m_oLinkStats.u32LastRecoverMs = u32RecoverMs;
+  if (u32RecoverMs > m_oLinkStats.u32MaxRecoverMs) m_oLinkStats.u32MaxRecoverMs = u32RecoverMs;
+  __atomic_store_n(&m_bLinkUp, true, __ATOMIC_RELAXED);
+  oAccelConfig    = m_oAccelConfig;
+  u32AccelSet     = m_u32AccelSet;
+  oAccelFeatures  = m_oAccelFeatures;
+  oAccelEvents    = m_oAccelEvents;
+  pthread_cond_signal(&m_condPending);
+  pthread_mutex_unlock(&m_mtxPending);
+
+  this->forgetInFlight();
+  printf("MCC link recovered in %u ms, protocol version %d\n", u32RecoverMs, m_u8Version);
+
+  // a rebooted M4 starts with its default settings
+  if (u32AccelSet && (m_u8Version >= MCC_PROTOCOL_ACCEL_CONFIG)) {
+    poMsg = this->alloc<MCCMSG_ACCEL_CONFIG>();
+    if (poMsg) {
+      poMsg->u32AccelSet  = u32AccelSet;
+      poMsg->oAccelConfig = oAccelConfig;
+      this->sendRequest(poMsg, m_u32Timeout, CMcc::accelConfigReply, this);
+    }
+  }
+
+  if (oAccelFeatures.u16Length && (m_u8Version >= MCC_PROTOCOL_FEATURES)) {
+    poMsg = this->alloc<MCCMSG_ACCEL_FEATURES>();
+    if (poMsg) {
+      poMsg->u32FeaturesSet = 1;
+      poMsg->oAccelFeatures = oAccelFeatures;
+      this->sendRequest(poMsg, m_u32Timeout, CMcc::accelFeaturesReply, this);
+    }
+  }
+
+  if (   (oAccelEvents.u8MotionThs || oAccelEvents.u8FreefallThs || oAccelEvents.u8TransientThs || oAccelEvents.u8TapThs)
+      && (m_u8Version >= MCC_PROTOCOL_EVENTS)) {
+    poMsg = this->alloc<MCCMSG_ACCEL_EVENTS>();
+    if (poMsg) {
+      poMsg->u32EventsSet = 1;
+      poMsg->oAccelEvents = oAccelEvents;
+      this->sendRequest(poMsg, m_u32Timeout, CMcc::accelEventsReply, this);
+    }
+  }
+
+  // the M4 may have forgotten the subscription
+  if (!__atomic_load_n(&m_bSubscribed, __ATOMIC_RELAXED)) return;
+  if (m_u8Version >= MCC_PROTOCOL_FILTER) {                                     // its filter chain first
+    poMsg = this->allocAccelFilterRenewal();
+    if (poMsg) this->sendRequest(poMsg, m_u32Timeout, CMcc::accelFilterReply, this);
+  }
+  poMsg = this->allocMsg();
+  if (!poMsg) return;
+  poMsg->type         = MCCMSG_ACCEL_SUBSCRIBE;
+  poMsg->u32PeriodMs  = m_u32PushPeriod;
+  poMsg->u32Credits   = CMCC_PUSH_CREDITS;
+  poMsg->u32Format    = this->getAccelRaw() ? MCC_ACCEL_FORMAT_RAW : MCC_ACCEL_FORMAT_FLOAT;
+  this->sendRequest(poMsg, m_u32Timeout, CMcc::subscribeReply, this);
+}
+
+//******************************************************************************
+
+void CMcc::accelConfigReply (void            * pvCtx,
+                             uint32_t          u32Id,
+                             int               iStatus,
+                             const TMccMsg   * poReply,
+                             MCC_MEM_SIZE      size)
+{
+  const TMccAccelConfigMsg * poConfig = CMcc::recv<MCCMSG_ACCEL_CONFIG>(poReply, size);
+
+  (void)pvCtx;
+  (void)u32Id;
+  if ((MCC_OK == iStatus) && (!poConfig || (size < sizeof(TMccAccelConfigMsg)))) iStatus = MCC_RECV_FAILURE;
+  if (MCC_OK != iStatus) {
+    printf("accelerometer settings renewal failed: %d\n", iStatus);
+  } else if (MCC_ACCEL_CONFIG_OK != poConfig->i32Status) {
+    printf("accelerometer settings renewal failed: M4 status %d\n", poConfig->i32Status);
+  }
+}
+
+//******************************************************************************
+
+void CMcc::accelFilterReply (void            * pvCtx,
+                             uint32_t          u32Id,
+                             int               iStatus,
+                             const TMccMsg   * poReply,
+                             MCC_MEM_SIZE      size)
+{
+  const TMccAccelFilterMsg * poFilter = CMcc::recv<MCCMSG_ACCEL_FILTER>(poReply, size);
+
+  (void)pvCtx;
+  (void)u32Id;
+  if ((MCC_OK == iStatus) && (!poFilter || (size < sizeof(TMccAccelFilterMsg)))) iStatus = MCC_RECV_FAILURE;
+  if (MCC_OK != iStatus) {
+    printf("filter chain renewal failed: %d\n", iStatus);
+  } else if (MCC_ACCEL_FILTER_OK != poFilter->i32Status) {
+    printf("filter chain renewal failed: M4 status %d\n", poFilter->i32Status);
+  }
+}
+
+//******************************************************************************
+
+void CMcc::accelFeaturesReply (void            * pvCtx,
+                               uint32_t          u32Id,
+                               int               iStatus,
+                               const TMccMsg   * poReply,
+                               MCC_MEM_SIZE      size)
+{
+  const TMccAccelFeaturesMsg * poFeatures = CMcc::recv<MCCMSG_ACCEL_FEATURES>(poReply, size);
+
+  (void)pvCtx;
+  (void)u32Id;
+  if ((MCC_OK == iStatus) && (!poFeatures || (size < sizeof(TMccAccelFeaturesMsg)))) iStatus = MCC_RECV_FAILURE;
+  if (MCC_OK != iStatus) {
+    printf("vibration features renewal failed: %d\n", iStatus);
+  } else if (MCC_ACCEL_FEATURES_OK != poFeatures->i32Status) {
+    printf("vibration features renewal failed: M4 status %d\n", poFeatures->i32Status);
+  }
+}
+
+//******************************************************************************
+
+void CMcc::accelEventsReply (void            * pvCtx,
+                             uint32_t          u32Id,
+                             int               iStatus,
+                             const TMccMsg   * poReply,
+                             MCC_MEM_SIZE      size)
+{
+  const TMccAccelEventsMsg * poEvents = CMcc::recv<MCCMSG_ACCEL_EVENTS>(poReply, size);
+
+  (void)pvCtx;
+  (void)u32Id;
+  if ((MCC_OK == iStatus) && (!poEvents || (size < sizeof(TMccAccelEventsMsg)))) iStatus = MCC_RECV_FAILURE;
+  if (MCC_OK != iStatus) {
+    printf("event detection renewal failed: %d\n", iStatus);
+  } else if (MCC_ACCEL_EVENTS_OK != poEvents->i32Status) {
+    printf("event detection renewal failed: M4 status %d\n", poEvents->i32Status);
+  }
+}
+
+//******************************************************************************
+
+void CMcc::subscribeReply (void            * pvCtx,
+                           uint32_t          u32Id,
+                           int               iStatus,
+                           const TMccMsg   * poReply,
+                           MCC_MEM_SIZE      size)
+{
+  (void)pvCtx;
+  (void)u32Id;
+  (void)poReply;
+  (void)size;
+  if (MCC_OK != iStatus) printf("subscription renewal failed: %d\n", iStatus);
+}
+
+//******************************************************************************
+
+void * CMcc::receiverThread (void * pvThis)
+{
+  ((CMcc*)pvThis)->receiverLoop();
+  return NULL;
+}
+
+//******************************************************************************
+
+void * CMcc::timerThread (void * pvThis)
+{
+  ((CMcc*)pvThis)->timerLoop();
+  return NULL;
+}
+
+//******************************************************************************
+
+void CMcc::receiverLoop (void)
+{
+  void          * pvMsg;
+  TMccHdr       * poHdr;
+  TMccMsg       * pMsg;
+  MCC_MEM_SIZE    size;
+  TAccelData      aoData[MCC_ACCEL_RAW_MAX_SAMPLES];                            // the most samples of a push
+  TAccelSummary   oSummary;
+  TAccelEvent     aoEvents[MCC_ACCEL_EVENT_MAX];
+  TMccPending     oPending;
+  MCC_MEM_SIZE    crcSize;
+  uint32_t        u32Crc;
+  int             iChannel;
+  uint32_t        u32Id;
+  uint32_t        u32Count;
+  uint32_t        u32Lost;
+  uint32_t        i;
+  bool            bQuit;
+  int             ret;
+
+  while (1) {
+    if (__atomic_exchange_n(&m_bReopen, false, __ATOMIC_RELAXED)) this->recover();
+
+    ret = m_poTransport->recvMsg(&pvMsg, &size, CMCC_RECV_TIMEOUT);             // blocking call
+    if (MCC_OK != ret) {
+      pthread_mutex_lock(&m_mtxPending);
+      bQuit = m_bQuit;
+      pthread_mutex_unlock(&m_mtxPending);
+      if (bQuit) break;
+      if (MCC_TIMEOUT == ret) continue;                                         // idle, the requests time out by the timer thread
+      __atomic_add_fetch(&m_oStats.u32RxErrors, 1, __ATOMIC_RELAXED);
+      usleep(CMCC_RECV_RETRY * 1000);                                           // endpoint broken, re-created once the link is lost
+      continue;
+    }
+
+    // strip the header of a framed message
+    poHdr = (TMccHdr*)pvMsg;
+    if ((size >= sizeof(TMccHdr)) && (MCC_HDR_MAGIC == poHdr->u16Magic)) {
+      crcSize = (poHdr->u8Flags & MCC_HDR_FLAG_CRC) ? MCC_CRC_SIZE : 0;
+      if (size != MCC_HDR_PREFIX_SIZE + sizeof(int32_t) + poHdr->u16Length + crcSize) {
+        __atomic_add_fetch(&m_oStats.u32RxErrors, 1, __ATOMIC_RELAXED);
+        printf("receiver invalid frame: size %d, length %d\n", size, poHdr->u16Length);
+        this->freeMsg(pvMsg);
+        continue;
+      }
+      if (crcSize) {
+        memcpy(&u32Crc, (uint8_t*)pvMsg + size - MCC_CRC_SIZE, MCC_CRC_SIZE);
+        if (CMccCrc::calc(pvMsg, size - MCC_CRC_SIZE) != u32Crc) {              // a lost message for the sequence check
+          __atomic_add_fetch(&m_oStats.u32RxCrcErrors, 1, __ATOMIC_RELAXED);
+          printf("receiver message seq %u CRC mismatch\n", poHdr->u32Seq);
+          this->freeMsg(pvMsg);
+          continue;
+        }
+      }
+      this->checkSeq(poHdr);
+      __atomic_store_n(&m_u64RxUs, CMccClock::nowUs(), __ATOMIC_RELAXED);       // the link is alive
+      iChannel  = (poHdr->u8Flags & MCC_HDR_FLAG_BULK) ? CMCC_CHANNEL_BULK : CMCC_CHANNEL_CONTROL;
+      if (m_u8Version >= MCC_PROTOCOL_CREDITS) this->takeAck(iChannel, poHdr);
+      u32Id     = (poHdr->u8Flags & MCC_HDR_FLAG_REPLY) ? CMCC_REQUEST_ID(poHdr->u32Ref, iChannel) : 0;
+      pMsg      = (TMccMsg*)&poHdr->type;
+      size     -= MCC_HDR_PREFIX_SIZE + crcSize;
+    } else {
+      u32Id     = 0;
+      pMsg      = (TMccMsg*)pvMsg;
+    }
+
+    if (CMCC_MSGTYPE_QUIT == pMsg->type) {
+      this->freeMsg(pvMsg);
+      break;
+    }
+    if (CMCC_MSGTYPE_WAKE == pMsg->type) {                                      // m_bReopen checked above
+      this->freeMsg(pvMsg);
+      continue;
+    }
+    __atomic_add_fetch(&m_oStats.au32Rx[((uint32_t)pMsg->type < MCCMSG_COUNT) ? pMsg->type : MCCMSG_RESERVED],
+                       1, __ATOMIC_RELAXED);
+
+    // acknowledgement only, taken above
+    if (MCCMSG_CREDIT == pMsg->type) {
+      this->freeMsg(pvMsg);
+      continue;
+    }
+
+    // pushed samples go to the ring
+    if ((MCCMSG_ACCEL_PUSH == pMsg->type) || (MCCMSG_ACCEL_RAW_PUSH == pMsg->type)) {
+      if (MCCMSG_ACCEL_RAW_PUSH == pMsg->type) {
+        ret = CMcc::decodeAccelRaw(pMsg, size, MCCMSG_ACCEL_RAW_PUSH, aoData,
+                                   MCC_ACCEL_RAW_MAX_SAMPLES, &u32Count, &u32Lost,
+                                   &m_oClock, __atomic_load_n(&m_u32PushStride, __ATOMIC_RELAXED));
+      } else {
+        ret = CMcc::decodeAccelStream(pMsg, size, MCCMSG_ACCEL_PUSH, aoData,
+                                      MCC_ACCEL_STREAM_MAX_SAMPLES, &u32Count, &u32Lost,
+                                      &m_oClock);
+      }
+      this->freeMsg(pvMsg);
+      __atomic_add_fetch(&m_u32PushUnacked, 1, __ATOMIC_RELAXED);
+      this->ackPushes(MCC_CREDIT_BATCH(CMCC_PUSH_CREDITS));                     // unless a request carried the acknowledgement
+      if (MCC_OK != ret) continue;
+      for (i = 0; i < u32Count; ++i) m_oAccelRing.push(aoData[i]);
+      if (u32Count) __atomic_store_n(&m_u32StreamSince, aoData[u32Count-1].timestamp, __ATOMIC_RELAXED);
+      __atomic_add_fetch(&m_u32PushLost, u32Lost, __ATOMIC_RELAXED);
+      continue;
+    }
+
+    // so do the summaries, in the same push window
+    if (MCCMSG_ACCEL_SUMMARY == pMsg->type) {
+      ret = CMcc::decodeAccelSummary(pMsg, size, &oSummary, &m_oClock);
+      u32Lost = (MCC_OK == ret) ? CMcc::recv<MCCMSG_ACCEL_SUMMARY>(pMsg, size)->u32Lost : 0;
+      this->freeMsg(pvMsg);
+      __atomic_add_fetch(&m_u32PushUnacked, 1, __ATOMIC_RELAXED);
+      this->ackPushes(MCC_CREDIT_BATCH(CMCC_PUSH_CREDITS));
+      if (MCC_OK != ret) continue;
+      m_oSummaryRing.push(oSummary);
+      __atomic_add_fetch(&m_u32SummaryLost, u32Lost, __ATOMIC_RELAXED);
+      continue;
+    }
+
+    // and the events, whose handler is told at once
+    if (MCCMSG_ACCEL_EVENT == pMsg->type) {
+      ret = CMcc::decodeAccelEvents(pMsg, size, aoEvents, MCC_ACCEL_EVENT_MAX,
+                                    &u32Count, &u32Lost, &m_oClock);
+      this->freeMsg(pvMsg);
+      __atomic_add_fetch(&m_u32PushUnacked, 1, __ATOMIC_RELAXED);
+      this->ackPushes(MCC_CREDIT_BATCH(CMCC_PUSH_CREDITS));
+      if (MCC_OK != ret) continue;
+      for (i = 0; i < u32Count; ++i) m_oEventRing.push(aoEvents[i]);
+      __atomic_add_fetch(&m_u32EventLost, u32Lost, __ATOMIC_RELAXED);
+      pthread_mutex_lock(&m_mtxPending);
+      if (m_pfnAccelEvent) m_pfnAccelEvent(m_pvAccelEventCtx);
+      pthread_mutex_unlock(&m_mtxPending);
+      continue;
+    }
+
+    // the M4 announces its tasks initialized after every boot
+    if (MCCMSG_READY == pMsg->type) {
+      if (size >= sizeof(TMccMsg)) this->m4Ready(CMcc::recv<MCCMSG_READY>(pMsg, size)->u32UptimeMs);
+      this->freeMsg(pvMsg);
+      continue;
+    }
+
+    // the pushes following a filter chain reply are decimated by it
+    if ((MCCMSG_ACCEL_FILTER == pMsg->type) && (size >= sizeof(TMccAccelFilterMsg))) {
+      const TMccAccelFilterMsg * poFilter = CMcc::recv<MCCMSG_ACCEL_FILTER>(pMsg, size);
+      __atomic_store_n(&m_u32PushStride, poFilter->oFilter.u8Decimation ? poFilter->oFilter.u8Decimation : 1,
+                       __ATOMIC_RELAXED);
+    }
+
+    // anything else completes the request it refers to, bare replies the
+    // oldest request of the same type
+    if (this->takePending(u32Id, pMsg->type, &oPending)) {
+      this->countLatency(CMccClock::nowUs() - oPending.u64SentUs);
+      oPending.pfnReply(oPending.pvCtx, oPending.u32Id, MCC_OK, pMsg, size);
+    } else {
+      printf("receiver unexpected reply: type %d\n", pMsg->type);               // late reply of a timed out or cancelled request
+    }
+    this->freeMsg(pvMsg);
+  }
+}
+
+//******************************************************************************
+
+void CMcc::timerLoop (void)
+{
+  struct timespec   oNow;
+  struct timespec   oWake;
+  TMccPending       oPending;
+  uint32_t          u32Expired;
+  bool              bWake;
+  int               i;
+
+  pthread_mutex_lock(&m_mtxPending);
+  while (!m_bQuit) {
+    clock_gettime(CLOCK_MONOTONIC, &oNow);
+    u32Expired = 0;
+    bWake      = m_bClockSync;
+    if (bWake) {
+      if (!timespec_before(oNow, m_oClockNext)) {                               // often at first, then just to follow the drift
+        ++m_u32ClockCount;
+        timespec_fromNow(&m_oClockNext, (m_u32ClockCount < CMCC_CLOCK_FAST_COUNT) ? CMCC_CLOCK_FAST_PERIOD : CMCC_CLOCK_PERIOD);
+        pthread_mutex_unlock(&m_mtxPending);
+        this->syncClock();
+        this->ackPushes(1);                                                     // pushes stopped with a few unacknowledged, or a MCCMSG_CREDIT failed
+        pthread_mutex_lock(&m_mtxPending);
+        continue;
+      }
+      oWake = m_oClockNext;
+    }
+    if (m_bHeartbeat) {
+      if (!timespec_before(oNow, m_oHeartbeatNext)) {
+        timespec_fromNow(&m_oHeartbeatNext, CMCC_HEARTBEAT_PERIOD);
+        pthread_mutex_unlock(&m_mtxPending);
+        this->heartbeat();
+        pthread_mutex_lock(&m_mtxPending);
+        continue;
+      }
+      if (!bWake || timespec_before(m_oHeartbeatNext, oWake)) {
+        oWake = m_oHeartbeatNext;
+        bWake = true;
+      }
+    }
+    for (i = 0; i < CMCC_PENDING_MAX; ++i) {
+      if (!m_aoPending[i].u32Id || !m_aoPending[i].bTimed) continue;
+      if (!timespec_before(oNow, m_aoPending[i].oDeadline)) {
+        u32Expired = m_aoPending[i].u32Id;
+        break;
+      }
+      if (!bWake || timespec_before(m_aoPending[i].oDeadline, oWake)) {
+        oWake = m_aoPending[i].oDeadline;
+        bWake = true;
+      }
+    }
+
+    if (u32Expired) {                                                           // call back without holding the lock
+      pthread_mutex_unlock(&m_mtxPending);
+      if (this->takePending(u32Expired, 0, &oPending)) {
+        __atomic_add_fetch(&m_oStats.u32ReqTimeouts, 1, __ATOMIC_RELAXED);
+        oPending.pfnReply(oPending.pvCtx, oPending.u32Id, MCC_TIMEOUT, NULL, 0);
+      }
+      pthread_mutex_lock(&m_mtxPending);
+    } else if (bWake) {
+      pthread_cond_timedwait(&m_condPending, &m_mtxPending, &oWake);
+    } else {
+      pthread_cond_wait(&m_condPending, &m_mtxPending);
+    }
+  }
+  pthread_mutex_unlock(&m_mtxPending);
+}
+
+//******************************************************************************
+
+void CMcc::countPending (void)
+{
+  uint32_t  u32Depth = 0;
+  int       i;
+
+  for (i = 0; i < CMCC_PENDING_MAX; ++i) {                                      // called under m_mtxPending
+    if (m_aoPending[i].u32Id) ++u32Depth;
+  }
+  __atomic_store_n(&m_oStats.u32QueueDepth, u32Depth, __ATOMIC_RELAXED);
+  if (u32Depth > m_oStats.u32QueueMax) __atomic_store_n(&m_oStats.u32QueueMax, u32Depth, __ATOMIC_RELAXED);
+}
+
+//******************************************************************************
+
+void CMcc::countLatency (uint64_t u64Us)
+{
+  int i = 0;
+
+  while ((i < MCC_STATS_LATENCY_BINS - 1) && (u64Us >= ((uint64_t)MCC_STATS_LATENCY_MIN_US << i))) ++i;
+  __atomic_add_fetch(&m_oStats.au32Latency[i], 1, __ATOMIC_RELAXED);
+}
+
+//******************************************************************************
@@ -9,28 +9,41 @@
 #define CMCC_H_
 //******************************************************************************
 
-extern "C"
-{
-#include <linux/mcc_config.h>
-#include <linux/mcc_common.h>
-#include <mcc_api.h>
-}
+#include "CMccTransport.h"
+#include "CMccMsg.h"
 #include "../common/easyduo_mcc_common.h"
+#include "CSpscRing.h"
+#include "CMccClock.h"
+
+#include <pthread.h>
+#include <time.h>
 
-//******************************************************************************
-// Return values
 //******************************************************************************
 
+#define CMCC_ACCEL_RING_SIZE            (256)                                   //!< Capacity of the ring of pushed samples (power of 2).
+#define CMCC_SUMMARY_RING_SIZE          (16)                                    //!< Capacity of the ring of pushed summaries (power of 2).
+#define CMCC_EVENT_RING_SIZE            (64)                                    //!< Capacity of the ring of pushed events (power of 2).
+#define CMCC_PENDING_MAX                (16)                                    //!< Maximum number of requests waiting for a reply.
+#define CMCC_TIMEOUT_INF                (0xFFFFFFFF)                            //!< Wait for the reply forever.
+#define CMCC_TIMEOUT_DEFAULT            (1000)                                  //!< Default timeout of the blocking calls in milliseconds.
+#define CMCC_CONNECT_TIMEOUT            (10000)                                 //!< Time the constructor waits for the endpoint and the M4 in milliseconds, a M4 still silent then is taken for a legacy one.
+#define CMCC_CONNECT_BACKOFF_MIN        (10)                                    //!< First pause between the connection attempts in milliseconds, doubled after each one.
+#define CMCC_CONNECT_BACKOFF_MAX        (1000)                                  //!< Longest pause between the connection attempts in milliseconds.
+#define CMCC_SNAPSHOT_RETRIES           (100)                                   //!< Attempts to read a consistent snapshot before giving up.
+#define CMCC_CLOCK_FAST_COUNT           (8)                                     //!< Number of clock exchanges done quickly after the start.
+#define CMCC_CLOCK_FAST_PERIOD          (50)                                    //!< Period of the first clock exchanges in milliseconds.
+#define CMCC_CLOCK_PERIOD               (1000)                                  //!< Period of the clock exchanges in milliseconds.
+#define CMCC_PUSH_CREDITS               (MCC_CREDITS_A5)                        //!< Push window granted to the M4 (MCC_PROTOCOL_CREDITS), as many as it grants us.
+#define CMCC_HEARTBEAT_PERIOD           (100)                                   //!< Period of the heartbeats (and of the recovery attempts) in milliseconds.
+#define CMCC_LINK_TIMEOUT               (3 * CMCC_HEARTBEAT_PERIOD)             //!< Time without any message from the M4 the link is lost after.
+#define CMCC_RECV_TIMEOUT               (CMCC_HEARTBEAT_PERIOD)                 //!< Longest receive wait of the receiver thread in milliseconds.
+#define CMCC_RECV_RETRY                 (10)                                    //!< Pause of the receiver thread after a failed receive in milliseconds.
+
+/** Channels to the M4, each served by its own M4 task (see MCC_MSG_IS_BULK). */
 enum {
-  MCC_OK                          = 0,
-  MCC_INIT_FAILURE,
-  MCC_INFO_FAILURE,
-  MCC_VERSION_FAILURE,
-  MCC_ENDPOINT_FAILURE,
-  MCC_SEND_FAILURE,
-  MCC_RECV_FAILURE,
-  MCC_FREE_FAILURE,
-  MCC_INVALID_ARGUMENT,
+  CMCC_CHANNEL_CONTROL = 0,                                                     //!< MCC_ENDPOINT_M4_PORT, LED and information requests.
+  CMCC_CHANNEL_BULK,                                                            //!< MCC_ENDPOINT_M4_BULK_PORT, sample transfers.
+  CMCC_CHANNEL_COUNT
 };
 
 //******************************************************************************
@@ -38,28 +51,397 @@ typedef struct t_accel_data_struct {
   float x;
   float y;
   float z;
+  uint32_t timestamp;                                                           //!< M4 sample timestamp (not filled by getAccelData with protocol version < MCC_PROTOCOL_TIMESTAMPS).
+  uint64_t timeUs;                                                              //!< A5 CLOCK_MONOTONIC time of the sample in microseconds (CMccClock::nowUs), 0 if not known.
 } TAccelData;
 
 //******************************************************************************
 
+/** Vibration features of one window of samples (MCC_PROTOCOL_FEATURES and
+ *  higher), see TMccAccelSummaryMsg. */
+typedef struct t_accel_summary_struct {
+  uint32_t window;                                                              //!< Number of the window counted by the M4.
+  uint32_t timestamp;                                                           //!< M4 timestamp of the first sample of the window.
+  uint64_t timeUs;                                                              //!< A5 CLOCK_MONOTONIC time of the first sample in microseconds, 0 if not known.
+  uint32_t periodUs;                                                            //!< Output data period of the samples in microseconds.
+  TMccAccelFeatures features;                                                   //!< Window length and bands.
+  TMccAccelAxisFeatures axes[3];                                                //!< X, Y, Z-axis features in g.
+} TAccelSummary;
+
+//******************************************************************************
+
+/** Motion, freefall, transient or tap detected by the sensor
+ *  (MCC_PROTOCOL_EVENTS and higher), see TMccAccelEvent. */
+typedef struct t_accel_event_struct {
+  uint32_t number;                                                              //!< Number of the event counted by the M4.
+  uint32_t timestamp;                                                           //!< M4 timestamp of the sample of the event.
+  uint64_t timeUs;                                                              //!< A5 CLOCK_MONOTONIC time of that sample in microseconds, 0 if not known.
+  uint8_t  type;                                                                //!< MCC_ACCEL_EVENT_* type.
+  uint8_t  axes;                                                                //!< MCC_ACCEL_AXIS_* bits of the axes that triggered it.
+  uint8_t  negative;                                                            //!< MCC_ACCEL_AXIS_* bits of the axes in the negative direction.
+} TAccelEvent;
+
+/** Told by the receiver thread that events arrived (readAccelEvents takes
+ *  them), with an internal lock held: it must not call back into CMcc. */
+typedef void (*TAccelEventFn) (void * pvCtx);
+
+//******************************************************************************
+
+/** Link supervision counters (MCC_PROTOCOL_HEARTBEAT and higher). */
+typedef struct t_mcc_link_stats_struct {
+  uint32_t u32Losses;                                                           //!< Number of times the link was lost (M4 silent or rebooted).
+  uint32_t u32Reboots;                                                          //!< Number of M4 reboots seen by the heartbeat.
+  uint32_t u32Recoveries;                                                       //!< Number of times the protocol was negotiated again.
+  uint32_t u32LastDetectMs;                                                     //!< Time from the last M4 message (or from the M4 boot) to the loss.
+  uint32_t u32MaxDetectMs;                                                      //!< Longest u32LastDetectMs.
+  uint32_t u32LastRecoverMs;                                                    //!< Time from the loss to the new negotiation.
+  uint32_t u32MaxRecoverMs;                                                     //!< Longest u32LastRecoverMs.
+} TMccLinkStats;
+
+//******************************************************************************
+
+/** Completion callback of an asynchronous request. Called exactly once, from
+ *  the CMcc receiver thread (reply), the CMcc timer thread (MCC_TIMEOUT, also
+ *  the receiver thread once the link is lost) or the thread calling
+ *  cancelRequest (MCC_CANCELLED). Must not block and must
+ *  not call the blocking CMcc methods.
+ * @param[in] pvCtx     Context passed to sendRequest.
+ * @param[in] u32Id     Request identifier returned by sendRequest.
+ * @param[in] iStatus   MCC_OK, MCC_TIMEOUT or MCC_CANCELLED.
+ * @param[in] poReply   Reply message (valid during the call only), NULL unless MCC_OK.
+ * @param[in] size      Size of the reply message in bytes. */
+typedef void (*TMccReplyFn) (void * pvCtx, uint32_t u32Id, int iStatus,
+                             const TMccMsg * poReply, MCC_MEM_SIZE size);
+
+//******************************************************************************
+
 class CMcc {
 public:
-  CMcc (MCC_NODE iNode, MCC_PORT iPort);
+  // The constructors retry creating the endpoint and saying HELLO with
+  // exponential backoff until the M4 answers, MCCMSG_READY cutting the wait
+  // short, for u32ConnectMs at most; they throw MCC_* if the endpoint cannot
+  // be created within that time
+  CMcc (MCC_NODE iNode, MCC_PORT iPort, uint32_t u32ConnectMs = CMCC_CONNECT_TIMEOUT);
+  CMcc (CMccTransport * poTransport, uint32_t u32ConnectMs = CMCC_CONNECT_TIMEOUT);
+  ~CMcc ();
+
+  void setTimeout (uint32_t u32TimeoutMs);
+  uint8_t getProtocolVersion (void) const;
+  void getSeqErrors (uint32_t * pu32Lost, uint32_t * pu32Reordered);
+
+  // CRC trailer of the messages sent (MCC_HDR_FLAG_CRC, the M4 protects its
+  // replies and pushes the same way), off by default
+  int setCrc (bool bEnable);
+  bool getCrc (void) const;
+  uint32_t getCrcErrors (void);
+
+  // Samples transferred as raw counts converted here (MCC_PROTOCOL_RAW and
+  // higher, half the message size), on by default; a change applies to the
+  // following getAccelStream calls and subscriptions
+  int setAccelRaw (bool bEnable);
+  bool getAccelRaw (void) const;
+
+  // Messages not sent: no credit left on the channel within the timeout
+  // (MCC_PROTOCOL_CREDITS, the M4 has not consumed the previous ones) or no
+  // MCC buffer
+  uint32_t getTxDropped (void);
+
+  // Link supervision (MCC_PROTOCOL_HEARTBEAT and higher): the link is lost
+  // after CMCC_LINK_TIMEOUT without a message from the M4 or once it reboots,
+  // the calls fail with MCC_LINK_DOWN then until the endpoint is re-created,
+  // the protocol negotiated again and the subscription renewed
+  bool isLinkUp (void) const;
+  void getLinkStats (TMccLinkStats * poStats);
+
+  // Message statistics (TMccStats) of this side since the start, and of a M4
+  // channel task (CMCC_CHANNEL_*, MCC_PROTOCOL_STATS and higher); every
+  // counter is read atomically, the whole set is not a consistent snapshot
+  void getStats (TMccStats * poStats);
+  int getM4Stats (int iChannel, TMccStats * poStats);
+
+  const CMccClock & getClock (void) const;
 
   int setLedOn (void);
   int setLedOff (void);
   int setLedAuto (void);
   int getAccelType (int32_t * pi32Type);
   int getAccelData (TAccelData * poData);
+  int getAccelStream (TAccelData * paoData, uint32_t u32Size,
+                      uint32_t * pu32Count, uint32_t * pu32Lost = NULL);
+
+  int subscribeAccel (uint32_t u32PeriodMs, uint32_t * pu32GrantedMs = NULL);
+
+  // Accelerometer settings (MCC_PROTOCOL_ACCEL_CONFIG and higher): the M4
+  // changes the ones of poReq selected by the MCC_ACCEL_SET_* bits of u32Set
+  // and replies the settings in effect, its MCC_ACCEL_CONFIG_* status in
+  // poReply->i32Status; samples of a new range come with a new scale. The
+  // settings changed are applied again after a link recovery.
+  int setAccelConfig (const TMccAccelConfig * poReq, uint32_t u32Set,
+                      TMccAccelConfigMsg * poReply);
+  int getAccelConfig (TMccAccelConfigMsg * poReply);
+
+  // Filter chain of the subscription pushes (MCC_PROTOCOL_FILTER and higher):
+  // the M4 filters and decimates the pushed samples by poReq (NULL to query
+  // only) and replies the chain in effect, its MCC_ACCEL_FILTER_* status in
+  // poReply->i32Status. The chain is applied again before every subscription
+  // and after a link recovery, one left by an earlier process never applies.
+  int setAccelFilter (const TMccAccelFilter * poReq, TMccAccelFilterMsg * poReply);
+  int getAccelFilter (TMccAccelFilterMsg * poReply);
+
+  // Vibration features (MCC_PROTOCOL_FEATURES and higher): the M4 summarizes
+  // consecutive windows of samples by poReq (NULL to query only, a zero
+  // u16Length for none) and replies the features in effect, its
+  // MCC_ACCEL_FEATURES_* status in poReply->i32Status. The summaries are
+  // pushed independently of the subscription, readAccelSummaries takes them.
+  // The features are applied again after a link recovery.
+  int setAccelFeatures (const TMccAccelFeatures * poReq, TMccAccelFeaturesMsg * poReply);
+  int getAccelFeatures (TMccAccelFeaturesMsg * poReply);
+  uint32_t readAccelSummaries (TAccelSummary * paoSummaries, uint32_t u32Size,
+                               uint32_t * pu32Lost = NULL);
+
+  // Event detection (MCC_PROTOCOL_EVENTS and higher): the sensor watches
+  // every sample for motion, freefall, transients and taps by poReq (NULL to
+  // query only, zero thresholds for none), the M4 replies the detection in
+  // effect, its MCC_ACCEL_EVENTS_* status in poReply->i32Status, and pushes
+  // the events as they come. readAccelEvents takes them, the handler set by
+  // setAccelEventHandler is told of every push so that nobody needs to poll.
+  // The detection is applied again after a link recovery.
+  int setAccelEvents (const TMccAccelEvents * poReq, TMccAccelEventsMsg * poReply);
+  int getAccelEvents (TMccAccelEventsMsg * poReply);
+  uint32_t readAccelEvents (TAccelEvent * paoEvents, uint32_t u32Size,
+                            uint32_t * pu32Lost = NULL);
+  void setAccelEventHandler (TAccelEventFn pfnHandler, void * pvCtx);
+  int unsubscribeAccel (void);
+  uint32_t readAccelSamples (TAccelData * paoData, uint32_t u32Size,
+                             uint32_t * pu32Lost = NULL);
+
+  // Latest sample straight from the memory shared with the M4, no message
+  // sent (may be stale for up to half a second after the M4 went to standby)
+  int readAccelSnapshot (TAccelData * poData);
+
+  // Asynchronous requests, composed in place in an allocMsg buffer (room for
+  // MCC_ATTR_BUFFER_SIZE_IN_BYTES - MCC_HDR_PREFIX_SIZE - MCC_CRC_SIZE bytes)
+  // and handed over to sendRequest (released by it even on failure)
+  TMccMsg * allocMsg (void);
+  TMccMsg * allocAccelConfig (const TMccAccelConfig * poReq, uint32_t u32Set);
+  TMccMsg * allocAccelFilter (const TMccAccelFilter * poReq);
+  TMccMsg * allocAccelFilterRenewal (void);
+  TMccMsg * allocAccelFeatures (const TMccAccelFeatures * poReq);
+  TMccMsg * allocAccelEvents (const TMccAccelEvents * poReq);
+  int sendRequest (TMccMsg * poMsg, uint32_t u32TimeoutMs,
+                   TMccReplyFn pfnReply, void * pvCtx, uint32_t * pu32Id = NULL,
+                   MCC_MEM_SIZE size = sizeof(TMccMsg));
+  bool cancelRequest (uint32_t u32Id);
+
+  // For the threads that must not block (a GUI one): fail with MCC_BUSY at
+  // once instead of waiting for a credit, trySend for a message without reply
+  int trySendRequest (TMccMsg * poMsg, uint32_t u32TimeoutMs,
+                      TMccReplyFn pfnReply, void * pvCtx, uint32_t * pu32Id = NULL,
+                      MCC_MEM_SIZE size = sizeof(TMccMsg));
+  int trySend (TMccMsg * poMsg, MCC_MEM_SIZE size = sizeof(TMccMsg));
+
+  // Typed messages (MCC_MSG_TABLE): alloc composes a request of given type in
+  // place, send hands it over (released even on failure) and waits for the
+  // reply body if the message has one, recv checks the type of a message
+  // passed to a TMccReplyFn (the size of a variable one is up to the caller)
+  template <int32_t TYPE> typename CMccMsgTraits<TYPE>::TRequest * alloc (void);
+  template <int32_t TYPE> int send (typename CMccMsgTraits<TYPE>::TRequest * poMsg,
+                                    typename CMccMsgTraits<TYPE>::TReply * poReply = NULL,
+                                    MCC_MEM_SIZE * pSize = NULL);
+  template <int32_t TYPE> static const typename CMccMsgTraits<TYPE>::TReply * recv (
+      const TMccMsg * poMsg, MCC_MEM_SIZE size);
+
+  // Reply decoders, the M4 times are converted by poClock if given
+  static int decodeAccelData (const TMccMsg * poReply, MCC_MEM_SIZE size,
+                              TAccelData * poData,
+                              const CMccClock * poClock = NULL);
+  static int decodeAccelStream (const TMccMsg * poReply, MCC_MEM_SIZE size,
+                                int32_t i32Type, TAccelData * paoData,
+                                uint32_t u32Size, uint32_t * pu32Count,
+                                uint32_t * pu32Lost = NULL,
+                                const CMccClock * poClock = NULL);
+  static int decodeAccelRaw (const TMccMsg * poReply, MCC_MEM_SIZE size,
+                             int32_t i32Type, TAccelData * paoData,
+                             uint32_t u32Size, uint32_t * pu32Count,
+                             uint32_t * pu32Lost = NULL,
+                             const CMccClock * poClock = NULL,
+                             uint32_t u32Stride = 1);
+  static int decodeAccelSummary (const TMccMsg * poMsg, MCC_MEM_SIZE size,
+                                 TAccelSummary * poSummary,
+                                 const CMccClock * poClock = NULL);
+  static int decodeAccelEvents (const TMccMsg * poMsg, MCC_MEM_SIZE size,
+                                TAccelEvent * paoEvents, uint32_t u32Size,
+                                uint32_t * pu32Count, uint32_t * pu32Lost = NULL,
+                                const CMccClock * poClock = NULL);
 
 protected:
-  static MCC_ENDPOINT s_mccEndpointLocal;
-  static MCC_ENDPOINT s_mccEndpointRemote;
+  typedef struct t_mcc_pending_struct {
+    uint32_t          u32Id;                                                    //!< Request identifier (CMCC_REQUEST_ID), 0 if the slot is free.
+    int32_t           i32Type;                                                  //!< Expected reply type (bare replies are matched by type).
+    bool              bTimed;                                                   //!< False for CMCC_TIMEOUT_INF.
+    struct timespec   oDeadline;                                                //!< CLOCK_MONOTONIC expiration time.
+    uint64_t          u64SentUs;                                                //!< CMccClock::nowUs of the sending (latency statistics).
+    TMccReplyFn       pfnReply;
+    void            * pvCtx;
+  } TMccPending;
+
+  CMccTransport     * m_poTransport;                                            //!< Owned by CMcc.
+  volatile TMccAccelSnapshot * m_poSnapshot;                                    //!< Region shared with the M4 (m_poTransport), NULL if not available.
+
+  uint32_t m_u32StreamSince;                                                    //!< Timestamp of the last sample received by getAccelStream or the receiver (atomic access).
+  uint32_t m_u32Timeout;                                                        //!< Timeout of the blocking calls in milliseconds.
+  bool     m_bSubscribed;                                                       //!< Renewed after a link recovery (atomic access).
+  uint32_t m_u32PushPeriod;                                                     //!< Push period requested by subscribeAccel.
+  TMccAccelConfig m_oAccelConfig;                                               //!< Accelerometer settings changed, renewed after a link recovery (guarded by m_mtxPending).
+  uint32_t m_u32AccelSet;                                                       //!< MCC_ACCEL_SET_* bits of the m_oAccelConfig settings changed (guarded by m_mtxPending).
+  TMccAccelFilter m_oAccelFilter;                                               //!< Filter chain of the pushes, renewed before a subscription (guarded by m_mtxPending).
+  TMccAccelFeatures m_oAccelFeatures;                                           //!< Vibration features requested, renewed after a link recovery (guarded by m_mtxPending).
+  TMccAccelEvents m_oAccelEvents;                                               //!< Event detection requested, renewed after a link recovery (guarded by m_mtxPending).
+  TAccelEventFn m_pfnAccelEvent;                                                //!< Told of the pushed events (guarded by m_mtxPending).
+  void   * m_pvAccelEventCtx;                                                   //!< Context of m_pfnAccelEvent (guarded by m_mtxPending).
+  uint32_t m_u32PushStride;                                                     //!< Timestamp step of the raw pushes, the decimation of the M4 filter chain (atomic access).
+  uint8_t  m_u8Version;                                                         //!< Negotiated protocol version (MCC_PROTOCOL_*).
+  bool     m_bCrc;                                                              //!< Append the CRC trailer to the messages sent (atomic access).
+  bool     m_bRaw;                                                              //!< Request the samples as raw counts if the M4 knows them (atomic access).
+
+  // Sequence numbering
+  pthread_mutex_t     m_mtxTx;                                                  //!< Guards m_au32TxSeq and m_au16TxAck, messages leave in the order of their numbers.
+  pthread_cond_t      m_condTx;                                                 //!< Signalled when the M4 acknowledges messages (credits returned).
+  uint32_t            m_au32TxSeq[CMCC_CHANNEL_COUNT];                          //!< Sequence number of the last message sent per channel.
+  uint16_t            m_au16TxAck[CMCC_CHANNEL_COUNT];                          //!< Last m_au32TxSeq acknowledged by the M4 per channel (low half).
+  uint32_t            m_au32RxSeqLast[CMCC_CHANNEL_COUNT];                      //!< Sequence number of the last M4 message consumed per channel, acknowledged by TMccHdr::u16Ack (atomic access).
+  uint32_t            m_u32PushUnacked;                                         //!< Pushes consumed since the last acknowledgement sent (atomic access).
+  uint32_t            m_au32RxSeqNext[CMCC_CHANNEL_COUNT];                      //!< Expected sequence number of the next framed message per channel, 0 if unknown (receiver thread only).
+  TMccStats           m_oStats;                                                 //!< Message statistics (atomic access per counter).
 
-  int sendMsg (TMccMsg & oMsg);
-  int recvMsg (TMccMsg ** ppoMsg);
-  int freeMsg (TMccMsg * poMsg);
+  // Pending requests
+  pthread_mutex_t     m_mtxPending;                                             //!< Guards m_aoPending, m_bQuit and the clock exchange and heartbeat schedules.
+  pthread_cond_t      m_condPending;                                            //!< Signalled when a timed request is added, on quit or on MCCMSG_READY (broadcast).
+  TMccPending         m_aoPending[CMCC_PENDING_MAX];
+  bool                m_bQuit;
+  bool                m_bM4Ready;                                               //!< MCCMSG_READY received (the M4 endpoints exist).
+
+  // Receiver and timer threads (running for the whole object lifetime)
+  pthread_t           m_thrReceiver;
+  pthread_t           m_thrTimer;
+  uint32_t            m_u32PushLost;                                            //!< Samples lost on the M4 side since the last readAccelSamples (atomic access).
+  CSpscRing<TAccelData, CMCC_ACCEL_RING_SIZE> m_oAccelRing;                     //!< Pushed samples waiting for readAccelSamples.
+  uint32_t            m_u32SummaryLost;                                         //!< Summaries lost on the M4 side since the last readAccelSummaries (atomic access).
+  CSpscRing<TAccelSummary, CMCC_SUMMARY_RING_SIZE> m_oSummaryRing;              //!< Pushed summaries waiting for readAccelSummaries.
+  uint32_t            m_u32EventLost;                                           //!< Events lost on the M4 side since the last readAccelEvents (atomic access).
+  CSpscRing<TAccelEvent, CMCC_EVENT_RING_SIZE> m_oEventRing;                    //!< Pushed events waiting for readAccelEvents.
+
+  // M4 clock (MCC_PROTOCOL_TIMESTAMPS and higher), PINGs sent by the timer thread
+  CMccClock           m_oClock;
+  bool                m_bClockSync;                                             //!< Clock exchanges enabled.
+  struct timespec     m_oClockNext;                                             //!< CLOCK_MONOTONIC time of the next clock exchange.
+  uint32_t            m_u32ClockCount;                                          //!< Number of clock exchanges sent.
+
+  // Link supervision (MCC_PROTOCOL_HEARTBEAT and higher), heartbeats and
+  // recovery attempts scheduled by the timer thread
+  bool                m_bLinkUp;                                                //!< The M4 is answering (atomic access, changed under m_mtxPending).
+  bool                m_bHeartbeat;                                             //!< Heartbeats enabled.
+  bool                m_bReopen;                                                //!< The receiver thread is to re-create the endpoint and say HELLO (atomic access).
+  struct timespec     m_oHeartbeatNext;                                         //!< CLOCK_MONOTONIC time of the next heartbeat or recovery attempt.
+  uint64_t            m_u64RxUs;                                                //!< CMccClock::nowUs of the last message from the M4 (atomic access).
+  uint64_t            m_u64LostUs;                                              //!< CMccClock::nowUs of the link loss.
+  uint32_t            m_u32M4UptimeMs;                                          //!< M4 uptime of the last heartbeat, 0 if not known (receiver thread only).
+  TMccLinkStats       m_oLinkStats;                                             //!< Guarded by m_mtxPending.
+
+  static CMccTransport * openTransport (MCC_NODE iNode, MCC_PORT iPort, uint64_t u64DeadlineUs);
+  void start (uint64_t u64DeadlineUs);
+  void negotiate (uint64_t u64DeadlineUs);
+  void waitReady (uint32_t u32TimeoutMs);
+  void m4Ready (uint32_t u32UptimeMs);
+  int sendMsg (TMccMsg * poMsg, MCC_MEM_SIZE size = sizeof(TMccMsg), bool bWait = true);
+  int channelOf (int32_t i32Type) const;
+  int sendFrame (TMccMsg * poMsg, MCC_MEM_SIZE size, int iChannel, uint32_t u32Seq);
+  int waitCredit (int iChannel, bool bWait);
+  int postRequest (TMccMsg * poMsg, uint32_t u32TimeoutMs, TMccReplyFn pfnReply,
+                   void * pvCtx, uint32_t * pu32Id, MCC_MEM_SIZE size, bool bWait);
+  void takeAck (int iChannel, const TMccHdr * poHdr);
+  void ackPushes (uint32_t u32Min);
+  void discardMsg (TMccMsg * poMsg);
+  int freeMsg (void * pvMsg);
+  int transact (TMccMsg * poMsg, uint32_t u32TimeoutMs, void * pvReply, MCC_MEM_SIZE maxSize,
+                MCC_MEM_SIZE * pSize = NULL, MCC_MEM_SIZE size = sizeof(TMccMsg));
+  bool takePending (uint32_t u32Id, int32_t i32Type, TMccPending * poPending);
+  void checkSeq (const TMccHdr * poHdr);
+  bool hasCredit (int iChannel);
+  void syncClock (void);
+  void heartbeat (void);
+  void linkLost (bool bReboot, uint32_t u32DetectMs);
+  void forgetInFlight (void);
+  void recover (void);
+  void relink (uint32_t u32Version);
+
+  static void * receiverThread (void * pvThis);
+  static void * timerThread (void * pvThis);
+  static void transactReply (void * pvCtx, uint32_t u32Id, int iStatus,
+                             const TMccMsg * poReply, MCC_MEM_SIZE size);
+  static void clockReply (void * pvCtx, uint32_t u32Id, int iStatus,
+                          const TMccMsg * poReply, MCC_MEM_SIZE size);
+  static void heartbeatReply (void * pvCtx, uint32_t u32Id, int iStatus,
+                              const TMccMsg * poReply, MCC_MEM_SIZE size);
+  static void helloReply (void * pvCtx, uint32_t u32Id, int iStatus,
+                          const TMccMsg * poReply, MCC_MEM_SIZE size);
+  static void accelConfigReply (void * pvCtx, uint32_t u32Id, int iStatus,
+                                const TMccMsg * poReply, MCC_MEM_SIZE size);
+  static void accelFilterReply (void * pvCtx, uint32_t u32Id, int iStatus,
+                                const TMccMsg * poReply, MCC_MEM_SIZE size);
+  static void accelFeaturesReply (void * pvCtx, uint32_t u32Id, int iStatus,
+                                  const TMccMsg * poReply, MCC_MEM_SIZE size);
+  static void accelEventsReply (void * pvCtx, uint32_t u32Id, int iStatus,
+                                const TMccMsg * poReply, MCC_MEM_SIZE size);
+  static void subscribeReply (void * pvCtx, uint32_t u32Id, int iStatus,
+                              const TMccMsg * poReply, MCC_MEM_SIZE size);
+  void receiverLoop (void);
+  void timerLoop (void);
+  void countPending (void);
+  void countLatency (uint64_t u64Us);
 };
 
+//******************************************************************************
+// Typed messages
+//******************************************************************************
+
+template <int32_t TYPE>
+typename CMccMsgTraits<TYPE>::TRequest * CMcc::alloc (void)
+{
+  typename CMccMsgTraits<TYPE>::TRequest * poMsg;
+
+  poMsg = (typename CMccMsgTraits<TYPE>::TRequest*)this->allocMsg();
+  if (poMsg) poMsg->type = TYPE;
+  return poMsg;
+}
+
+//******************************************************************************
+
+template <int32_t TYPE>
+int CMcc::send (typename CMccMsgTraits<TYPE>::TRequest  * poMsg,
+                typename CMccMsgTraits<TYPE>::TReply    * poReply,
+                MCC_MEM_SIZE                            * pSize)
+{
+  if (!poMsg) return MCC_SEND_FAILURE;                                          // alloc failed
+  if (!CMccMsgTraits<TYPE>::bReply) {
+    return this->sendMsg((TMccMsg*)poMsg, sizeof(*poMsg));
+  }
+  if (!poReply) {
+    this->discardMsg((TMccMsg*)poMsg);
+    return MCC_INVALID_ARGUMENT;
+  }
+  return this->transact((TMccMsg*)poMsg, m_u32Timeout, poReply, sizeof(*poReply), pSize, sizeof(*poMsg));
+}
+
+//******************************************************************************
+
+template <int32_t TYPE>
+const typename CMccMsgTraits<TYPE>::TReply * CMcc::recv (const TMccMsg * poMsg,
+                                                          MCC_MEM_SIZE    size)
+{
+  if (!poMsg || (size < sizeof(int32_t)) || (TYPE != poMsg->type)) return NULL;
+  return (const typename CMccMsgTraits<TYPE>::TReply*)poMsg;
+}
+
 //******************************************************************************
 #endif /* CMCC_H_ */
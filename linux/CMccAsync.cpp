@@ -0,0 +1,390 @@
+/*
+ * CMccAsync.cpp
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#include "CMccAsync.h"
+
+#include <QMutexLocker>
+#include <stdio.h>
+#include <string.h>
+
+//******************************************************************************
+//******************************************************************************
+//******************************************************************************
+
+CMccAsync::CMccAsync (CMcc & oMcc, QObject * parent)
+  : QObject(parent), m_oMcc(oMcc), m_uSending(0), m_u32StreamSince(0)
+{
+  qRegisterMetaType<TAccelData>("TAccelData");
+  qRegisterMetaType< QVector<TAccelData> >("QVector<TAccelData>");
+  qRegisterMetaType<TMccStats>("TMccStats");
+  qRegisterMetaType<TMccAccelConfigMsg>("TMccAccelConfigMsg");
+  qRegisterMetaType<TMccAccelFilterMsg>("TMccAccelFilterMsg");
+  qRegisterMetaType<TMccAccelFeaturesMsg>("TMccAccelFeaturesMsg");
+  qRegisterMetaType<TMccAccelEventsMsg>("TMccAccelEventsMsg");
+  m_oMcc.setAccelEventHandler(CMccAsync::onAccelEvent, this);
+}
+
+//******************************************************************************
+
+CMccAsync::~CMccAsync ()
+{
+  QList<uint> qIds;
+
+  this->disconnect();                                                           // nobody wants the cancellations below
+  m_oMcc.setAccelEventHandler(NULL, NULL);                                      // returns once a running handler is done
+  m_qMutex.lock();
+  qIds = m_qPending.keys();
+  m_qMutex.unlock();
+
+  foreach (uint uId, qIds) m_oMcc.cancelRequest(uId);
+
+  // replies being delivered by the CMcc threads right now cannot be cancelled
+  m_qMutex.lock();
+  while (!m_qPending.isEmpty() || m_uSending) m_qCondIdle.wait(&m_qMutex);
+  m_qMutex.unlock();
+}
+
+//******************************************************************************
+
+uint CMccAsync::request (TMccMsg * poMsg, uint uTimeoutMs)
+{
+  int32_t       i32Type = poMsg->type;                                          // the buffer is gone after trySendRequest
+  uint32_t      u32Id;
+  TEarly        oEarly;
+  int           ret;
+
+  // sent unlocked, onReply keeps a reply coming before the registration
+  m_qMutex.lock();
+  ++m_uSending;
+  m_qMutex.unlock();
+  ret = m_oMcc.trySendRequest(poMsg, uTimeoutMs, CMccAsync::onReply, this, &u32Id);
+
+  QMutexLocker  qLock(&m_qMutex);
+  --m_uSending;
+  if (MCC_OK != ret) {
+    m_qCondIdle.wakeAll();
+    printf("CMccAsync request failed: type %d, %d\n", i32Type, ret);
+    return 0;
+  }
+  if (m_qEarly.contains(u32Id)) {
+    oEarly = m_qEarly.take(u32Id);
+    this->deliver(u32Id, i32Type, oEarly.iStatus,
+                  oEarly.qReply.isEmpty() ? NULL : (const TMccMsg*)oEarly.qReply.constData(),
+                  oEarly.qReply.size());
+    m_qCondIdle.wakeAll();
+  } else {
+    m_qPending.insert(u32Id, i32Type);
+  }
+  return u32Id;
+}
+
+//******************************************************************************
+
+bool CMccAsync::post (TMccMsg * poMsg)
+{
+  int32_t       i32Type;
+  int           ret;
+
+  if (!poMsg) return false;
+  i32Type = poMsg->type;                                                        // the buffer is gone after trySend
+  ret = m_oMcc.trySend(poMsg);
+  if (MCC_OK != ret) {
+    printf("CMccAsync post failed: type %d, %d\n", i32Type, ret);
+    return false;
+  }
+  return true;
+}
+
+//******************************************************************************
+
+uint CMccAsync::requestAccelType (uint uTimeoutMs)
+{
+  TMccMsg * poMsg = m_oMcc.allocMsg();
+
+  if (!poMsg) return 0;
+  poMsg->type = MCCMSG_ACCEL_INFO;
+  return this->request(poMsg, uTimeoutMs);
+}
+
+//******************************************************************************
+
+uint CMccAsync::requestAccelData (uint uTimeoutMs)
+{
+  TMccMsg * poMsg = m_oMcc.allocMsg();
+
+  if (!poMsg) return 0;
+  poMsg->type = MCCMSG_ACCEL_DATA;
+  return this->request(poMsg, uTimeoutMs);
+}
+
+//******************************************************************************
+
+uint CMccAsync::requestAccelStream (uint uMaxCount, uint uTimeoutMs)
+{
+  TMccMsg * poMsg = m_oMcc.allocMsg();
+
+  if (!poMsg) return 0;
+  if (m_oMcc.getAccelRaw()) {
+    poMsg->type         = MCCMSG_ACCEL_RAW_STREAM;
+    poMsg->u32MaxCount  = qMin(uMaxCount, (uint)MCC_ACCEL_RAW_MAX_SAMPLES);
+  } else {
+    poMsg->type         = MCCMSG_ACCEL_STREAM;
+    poMsg->u32MaxCount  = qMin(uMaxCount, (uint)MCC_ACCEL_STREAM_MAX_SAMPLES);
+  }
+  m_qMutex.lock();
+  poMsg->u32Since     = m_u32StreamSince;
+  m_qMutex.unlock();
+  return this->request(poMsg, uTimeoutMs);
+}
+
+//******************************************************************************
+
+uint CMccAsync::requestSubscribe (uint uPeriodMs, uint uTimeoutMs)
+{
+  TMccMsg * poMsg;
+
+  if (m_oMcc.getProtocolVersion() >= MCC_PROTOCOL_FILTER) {                     // the M4 keeps the chain of an earlier subscriber
+    poMsg = m_oMcc.allocAccelFilterRenewal();
+    if (!poMsg || !this->request(poMsg, uTimeoutMs)) return 0;
+  }
+  poMsg = m_oMcc.allocMsg();
+  if (!poMsg) return 0;
+  poMsg->type         = MCCMSG_ACCEL_SUBSCRIBE;
+  poMsg->u32PeriodMs  = uPeriodMs;
+  poMsg->u32Format    = m_oMcc.getAccelRaw() ? MCC_ACCEL_FORMAT_RAW : MCC_ACCEL_FORMAT_FLOAT;
+  return this->request(poMsg, uTimeoutMs);
+}
+
+//******************************************************************************
+
+uint CMccAsync::requestStats (int iChannel, uint uTimeoutMs)
+{
+  TMccMsg * poMsg;
+
+  if (m_oMcc.getProtocolVersion() < MCC_PROTOCOL_STATS) return 0;
+  poMsg = m_oMcc.alloc<MCCMSG_STATS>();
+  if (!poMsg) return 0;
+  poMsg->u32Channel = (CMCC_CHANNEL_BULK == iChannel) ? MCC_MSG_CHANNEL_BULK : MCC_MSG_CHANNEL_CONTROL;
+  return this->request(poMsg, uTimeoutMs);
+}
+
+//******************************************************************************
+
+uint CMccAsync::requestAccelConfig (const TMccAccelConfig & oReq, uint uSet, uint uTimeoutMs)
+{
+  TMccMsg * poMsg;
+
+  if (m_oMcc.getProtocolVersion() < MCC_PROTOCOL_ACCEL_CONFIG) return 0;
+  poMsg = m_oMcc.allocAccelConfig(&oReq, uSet);                                 // renewed by m_oMcc after a link recovery
+  if (!poMsg) return 0;
+  return this->request(poMsg, uTimeoutMs);
+}
+
+//******************************************************************************
+
+uint CMccAsync::requestAccelFilter (const TMccAccelFilter & oReq, uint uTimeoutMs)
+{
+  TMccMsg * poMsg;
+
+  if (m_oMcc.getProtocolVersion() < MCC_PROTOCOL_FILTER) return 0;
+  poMsg = m_oMcc.allocAccelFilter(&oReq);                                       // renewed by m_oMcc for every subscription
+  if (!poMsg) return 0;
+  return this->request(poMsg, uTimeoutMs);
+}
+
+//******************************************************************************
+
+uint CMccAsync::requestAccelFeatures (const TMccAccelFeatures & oReq, uint uTimeoutMs)
+{
+  TMccMsg * poMsg;
+
+  if (m_oMcc.getProtocolVersion() < MCC_PROTOCOL_FEATURES) return 0;
+  poMsg = m_oMcc.allocAccelFeatures(&oReq);                                     // renewed by m_oMcc after a link recovery
+  if (!poMsg) return 0;
+  return this->request(poMsg, uTimeoutMs);
+}
+
+//******************************************************************************
+
+uint CMccAsync::requestAccelEvents (const TMccAccelEvents & oReq, uint uTimeoutMs)
+{
+  TMccMsg * poMsg;
+
+  if (m_oMcc.getProtocolVersion() < MCC_PROTOCOL_EVENTS) return 0;
+  poMsg = m_oMcc.allocAccelEvents(&oReq);                                       // renewed by m_oMcc after a link recovery
+  if (!poMsg) return 0;
+  return this->request(poMsg, uTimeoutMs);
+}
+
+//******************************************************************************
+
+bool CMccAsync::cancel (uint uId)
+{
+  return m_oMcc.cancelRequest(uId);                                             // MCC_CANCELLED is delivered by a signal too
+}
+
+//******************************************************************************
+
+bool CMccAsync::setLedOn ()
+{
+  return this->post(m_oMcc.alloc<MCCMSG_LED_ON>());
+}
+
+//******************************************************************************
+
+bool CMccAsync::setLedOff ()
+{
+  return this->post(m_oMcc.alloc<MCCMSG_LED_OFF>());
+}
+
+//******************************************************************************
+
+bool CMccAsync::setLedAuto ()
+{
+  return this->post(m_oMcc.alloc<MCCMSG_LED_AUTO>());
+}
+
+//******************************************************************************
+
+void CMccAsync::onReply (void            * pvCtx,
+                         uint32_t          u32Id,
+                         int               iStatus,
+                         const TMccMsg   * poReply,
+                         MCC_MEM_SIZE      size)
+{
+  CMccAsync     * poThis = (CMccAsync*)pvCtx;
+  QMutexLocker    qLock(&poThis->m_qMutex);
+  TEarly          oEarly;
+
+  if (!poThis->m_qPending.contains(u32Id)) {
+    if (!poThis->m_uSending) return;
+    oEarly.iStatus = iStatus;                                                   // request delivers it once registered
+    if (poReply) oEarly.qReply = QByteArray((const char*)poReply, size);
+    poThis->m_qEarly.insert(u32Id, oEarly);
+    return;
+  }
+
+  poThis->deliver(u32Id, poThis->m_qPending.take(u32Id), iStatus, poReply, size);
+  poThis->m_qCondIdle.wakeAll();
+}
+
+//******************************************************************************
+
+void CMccAsync::deliver (uint32_t          u32Id,
+                         int32_t           i32Type,
+                         int               iStatus,
+                         const TMccMsg   * poReply,
+                         MCC_MEM_SIZE      size)
+{
+  QVector<TAccelData>         qSamples;
+  TAccelData                  oData;
+  TMccStats                   oStats;
+  const TMccStatsMsg        * poStats;
+  TMccAccelConfigMsg          oConfig;
+  const TMccAccelConfigMsg  * poConfig;
+  TMccAccelFilterMsg          oFilter;
+  const TMccAccelFilterMsg  * poFilter;
+  TMccAccelFeaturesMsg        oFeatures;
+  const TMccAccelFeaturesMsg * poFeatures;
+  TMccAccelEventsMsg          oEvents;
+  const TMccAccelEventsMsg  * poEvents;
+  uint32_t                    u32Count = 0;
+  uint32_t                    u32Lost  = 0;
+
+  switch (i32Type) {
+  case MCCMSG_ACCEL_INFO:
+    emit accelTypeReceived(u32Id, iStatus, poReply ? poReply->iAccelType : 0);
+    break;
+
+  case MCCMSG_ACCEL_DATA:
+    memset(&oData, 0, sizeof(oData));
+    if (poReply) {
+      iStatus = CMcc::decodeAccelData(poReply, size, &oData,
+                                      &m_oMcc.getClock());
+    }
+    emit accelDataReceived(u32Id, iStatus, oData);
+    break;
+
+  case MCCMSG_ACCEL_STREAM:
+    if (poReply) {
+      qSamples.resize(MCC_ACCEL_STREAM_MAX_SAMPLES);
+      iStatus = CMcc::decodeAccelStream(poReply, size, MCCMSG_ACCEL_STREAM,
+                                        qSamples.data(), qSamples.size(),
+                                        &u32Count, &u32Lost,
+                                        &m_oMcc.getClock());
+      qSamples.resize(u32Count);
+      if (u32Count) m_u32StreamSince = qSamples.last().timestamp;
+    }
+    emit accelStreamReceived(u32Id, iStatus, qSamples, u32Lost);
+    break;
+
+  case MCCMSG_ACCEL_RAW_STREAM:
+    if (poReply) {
+      qSamples.resize(MCC_ACCEL_RAW_MAX_SAMPLES);
+      iStatus = CMcc::decodeAccelRaw(poReply, size, MCCMSG_ACCEL_RAW_STREAM,
+                                     qSamples.data(), qSamples.size(),
+                                     &u32Count, &u32Lost,
+                                     &m_oMcc.getClock());
+      qSamples.resize(u32Count);
+      if (u32Count) m_u32StreamSince = qSamples.last().timestamp;
+    }
+    emit accelStreamReceived(u32Id, iStatus, qSamples, u32Lost);
+    break;
+
+  case MCCMSG_ACCEL_SUBSCRIBE:
+    emit subscribeReceived(u32Id, iStatus, poReply ? poReply->u32PeriodMs : 0);
+    break;
+
+  case MCCMSG_STATS:
+    memset(&oStats, 0, sizeof(oStats));
+    poStats = CMcc::recv<MCCMSG_STATS>(poReply, size);
+    if (poReply && (!poStats || (size < sizeof(TMccStatsMsg)))) iStatus = MCC_RECV_FAILURE;
+    if (poStats && (MCC_OK == iStatus)) oStats = poStats->oStats;
+    emit statsReceived(u32Id, iStatus, oStats);
+    break;
+
+  case MCCMSG_ACCEL_CONFIG:
+    memset(&oConfig, 0, sizeof(oConfig));
+    poConfig = CMcc::recv<MCCMSG_ACCEL_CONFIG>(poReply, size);
+    if (poReply && (!poConfig || (size < sizeof(TMccAccelConfigMsg)))) iStatus = MCC_RECV_FAILURE;
+    if (poConfig && (MCC_OK == iStatus)) oConfig = *poConfig;
+    emit accelConfigReceived(u32Id, iStatus, oConfig);
+    break;
+
+  case MCCMSG_ACCEL_FILTER:
+    memset(&oFilter, 0, sizeof(oFilter));
+    poFilter = CMcc::recv<MCCMSG_ACCEL_FILTER>(poReply, size);
+    if (poReply && (!poFilter || (size < sizeof(TMccAccelFilterMsg)))) iStatus = MCC_RECV_FAILURE;
+    if (poFilter && (MCC_OK == iStatus)) oFilter = *poFilter;
+    emit accelFilterReceived(u32Id, iStatus, oFilter);
+    break;
+
+  case MCCMSG_ACCEL_FEATURES:
+    memset(&oFeatures, 0, sizeof(oFeatures));
+    poFeatures = CMcc::recv<MCCMSG_ACCEL_FEATURES>(poReply, size);
+    if (poReply && (!poFeatures || (size < sizeof(TMccAccelFeaturesMsg)))) iStatus = MCC_RECV_FAILURE;
+    if (poFeatures && (MCC_OK == iStatus)) oFeatures = *poFeatures;
+    emit accelFeaturesReceived(u32Id, iStatus, oFeatures);
+    break;
+
+  case MCCMSG_ACCEL_EVENTS:
+    memset(&oEvents, 0, sizeof(oEvents));
+    poEvents = CMcc::recv<MCCMSG_ACCEL_EVENTS>(poReply, size);
+    if (poReply && (!poEvents || (size < sizeof(TMccAccelEventsMsg)))) iStatus = MCC_RECV_FAILURE;
+    if (poEvents && (MCC_OK == iStatus)) oEvents = *poEvents;
+    emit accelEventsReceived(u32Id, iStatus, oEvents);
+    break;
+  }
+}
+
+//******************************************************************************
+
+void CMccAsync::onAccelEvent (void * pvCtx)
+{
+  emit ((CMccAsync*)pvCtx)->accelEventsReady();                                 // queued to the receivers, CMcc is not called back
+}
+
+//******************************************************************************
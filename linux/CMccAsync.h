@@ -0,0 +1,100 @@
+/*
+ * CMccAsync.h
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#ifndef CMCCASYNC_H_
+#define CMCCASYNC_H_
+//******************************************************************************
+
+#include <QObject>
+#include <QHash>
+#include <QByteArray>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QVector>
+#include <QMetaType>
+
+#include "CMcc.h"
+
+//******************************************************************************
+
+Q_DECLARE_METATYPE(TAccelData)
+Q_DECLARE_METATYPE(QVector<TAccelData>)
+Q_DECLARE_METATYPE(TMccStats)
+Q_DECLARE_METATYPE(TMccAccelConfigMsg)
+Q_DECLARE_METATYPE(TMccAccelFilterMsg)
+Q_DECLARE_METATYPE(TMccAccelFeaturesMsg)
+Q_DECLARE_METATYPE(TMccAccelEventsMsg)
+
+//******************************************************************************
+
+/** Non-blocking front-end of CMcc for the Qt GUI thread. Every request
+ *  returns immediately with an identifier (0 on failure, also when the
+ *  channel has no credit left) and its result is delivered by a signal,
+ *  queued to the thread of the connected receiver. Status is MCC_OK,
+ *  MCC_TIMEOUT or MCC_CANCELLED. The LED commands have no reply, they return
+ *  false if not sent. requestSubscribe renews
+ *  the filter chain of the pushes first, reported by accelFilterReceived.
+ *  accelEventsReady tells that pushed events wait in CMcc::readAccelEvents. */
+class CMccAsync : public QObject
+{
+    Q_OBJECT
+
+public:
+    CMccAsync(CMcc & oMcc, QObject * parent = 0);
+    ~CMccAsync();
+
+    uint requestAccelType (uint uTimeoutMs);
+    uint requestAccelData (uint uTimeoutMs);
+    uint requestAccelStream (uint uMaxCount, uint uTimeoutMs);
+    uint requestSubscribe (uint uPeriodMs, uint uTimeoutMs);
+    uint requestStats (int iChannel, uint uTimeoutMs);
+    uint requestAccelConfig (const TMccAccelConfig & oReq, uint uSet, uint uTimeoutMs);
+    uint requestAccelFilter (const TMccAccelFilter & oReq, uint uTimeoutMs);
+    uint requestAccelFeatures (const TMccAccelFeatures & oReq, uint uTimeoutMs);
+    uint requestAccelEvents (const TMccAccelEvents & oReq, uint uTimeoutMs);
+    bool cancel (uint uId);
+    bool setLedOn ();
+    bool setLedOff ();
+    bool setLedAuto ();
+
+signals:
+    void accelTypeReceived (uint uId, int iStatus, int iType);
+    void accelDataReceived (uint uId, int iStatus, TAccelData oData);
+    void accelStreamReceived (uint uId, int iStatus, QVector<TAccelData> qSamples, uint uLost);
+    void subscribeReceived (uint uId, int iStatus, uint uPeriodMs);
+    void statsReceived (uint uId, int iStatus, TMccStats oStats);
+    void accelConfigReceived (uint uId, int iStatus, TMccAccelConfigMsg oConfig);
+    void accelFilterReceived (uint uId, int iStatus, TMccAccelFilterMsg oFilter);
+    void accelFeaturesReceived (uint uId, int iStatus, TMccAccelFeaturesMsg oFeatures);
+    void accelEventsReceived (uint uId, int iStatus, TMccAccelEventsMsg oEvents);
+    void accelEventsReady ();
+
+protected:
+    typedef struct {
+      int                 iStatus;                                              //!< Status of the reply.
+      QByteArray          qReply;                                               //!< Copy of the reply message, empty unless MCC_OK.
+    } TEarly;
+
+    CMcc                & m_oMcc;
+    QMutex                m_qMutex;                                             //!< Guards all the members below.
+    QWaitCondition        m_qCondIdle;                                          //!< Signalled when a request completes.
+    QHash<uint, int32_t>  m_qPending;                                           //!< Request type of the pending identifiers.
+    QHash<uint, TEarly>   m_qEarly;                                             //!< Replies that came before their request was registered.
+    uint                  m_uSending;                                           //!< Requests being sent, not registered yet.
+    uint32_t              m_u32StreamSince;                                     //!< Timestamp of the last sample received by requestAccelStream.
+
+    uint request (TMccMsg * poMsg, uint uTimeoutMs);
+    bool post (TMccMsg * poMsg);
+    void deliver (uint32_t u32Id, int32_t i32Type, int iStatus,
+                  const TMccMsg * poReply, MCC_MEM_SIZE size);
+
+    static void onReply (void * pvCtx, uint32_t u32Id, int iStatus,
+                         const TMccMsg * poReply, MCC_MEM_SIZE size);
+    static void onAccelEvent (void * pvCtx);
+};
+
+//******************************************************************************
+#endif /* CMCCASYNC_H_ */
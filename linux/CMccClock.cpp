@@ -0,0 +1,191 @@
+/*
+ * CMccClock.cpp
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#include "CMccClock.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <time.h>
+
+//******************************************************************************
+//******************************************************************************
+//******************************************************************************
+
+CMccClock::CMccClock ()
+{
+  pthread_mutex_init(&m_mtx, NULL);
+  this->reset();
+}
+
+//******************************************************************************
+
+CMccClock::~CMccClock ()
+{
+  pthread_mutex_destroy(&m_mtx);
+}
+
+//******************************************************************************
+
+uint64_t CMccClock::nowUs (void)
+{
+  struct timespec oNow;
+
+  clock_gettime(CLOCK_MONOTONIC, &oNow);
+  return (uint64_t)oNow.tv_sec * 1000000u + oNow.tv_nsec / 1000;
+}
+
+//******************************************************************************
+
+void CMccClock::reset (void)
+{
+  pthread_mutex_lock(&m_mtx);
+  m_u32Count    = 0;
+  m_u32Next     = 0;
+  m_bValid      = false;
+  m_u64RefM4Us  = 0;
+  m_dOffsetUs   = 0.0;
+  m_dDrift      = 0.0;
+  m_u32RttUs    = 0;
+  pthread_mutex_unlock(&m_mtx);
+}
+
+//******************************************************************************
+
+uint64_t CMccClock::unwrap (uint32_t u32M4Us) const
+{
+  return m_u64RefM4Us + (int64_t)(int32_t)(u32M4Us - (uint32_t)m_u64RefM4Us);
+}
+
+//******************************************************************************
+
+double CMccClock::predict (uint64_t u64M4Us) const
+{
+  double dX = (double)(int64_t)(u64M4Us - m_u64RefM4Us);
+
+  return (double)u64M4Us + m_dOffsetUs + m_dDrift * dX;
+}
+
+//******************************************************************************
+
+void CMccClock::addExchange (uint64_t u64A5TxUs, uint32_t u32M4RxUs,
+                             uint32_t u32M4TxUs, uint64_t u64A5RxUs)
+{
+  uint32_t  u32M4Us = u32M4TxUs - u32M4RxUs;
+  uint64_t  u64A5Us = u64A5RxUs - u64A5TxUs;
+  TPoint    oPoint;
+
+  if (u32M4Us > u64A5Us) return;                                                // impossible, corrupted exchange
+
+  oPoint.u32RttUs = (uint32_t)(u64A5Us - u32M4Us);
+  oPoint.u64A5Us  = u64A5TxUs + u64A5Us / 2;
+
+  pthread_mutex_lock(&m_mtx);
+  if (!m_u32Count) {
+    m_u64RefM4Us = u32M4RxUs;                                                   // the unwrapped time starts at the first exchange
+  }
+  oPoint.u64M4Us = this->unwrap(u32M4RxUs) + u32M4Us / 2;
+
+  // an exchange far from the estimate means a new M4 time base
+  if (m_bValid && (fabs((double)oPoint.u64A5Us - this->predict(oPoint.u64M4Us))
+                   > CMCC_CLOCK_RESET_US + oPoint.u32RttUs)) {
+    printf("CMccClock M4 time jumped, restarting the estimate\n");
+    m_u32Count    = 0;
+    m_u32Next     = 0;
+    m_u64RefM4Us  = u32M4RxUs;
+    oPoint.u64M4Us = m_u64RefM4Us + u32M4Us / 2;
+  }
+
+  m_aoPoints[m_u32Next] = oPoint;
+  m_u32Next = (m_u32Next + 1) % CMCC_CLOCK_POINTS;
+  if (m_u32Count < CMCC_CLOCK_POINTS) ++m_u32Count;
+  m_u64RefM4Us = oPoint.u64M4Us;
+  this->fit();
+  pthread_mutex_unlock(&m_mtx);
+}
+
+//******************************************************************************
+
+void CMccClock::fit (void)
+{
+  uint32_t  u32MinRtt = 0xFFFFFFFF;
+  uint32_t  u32Limit;
+  uint64_t  u64MinM4 = m_u64RefM4Us;
+  double    dN  = 0.0;
+  double    dSx = 0.0;
+  double    dSy = 0.0;
+  double    dSxx = 0.0;
+  double    dSxy = 0.0;
+  double    dX;
+  double    dY;
+  double    dDen;
+  uint32_t  i;
+
+  for (i = 0; i < m_u32Count; ++i) {
+    if (m_aoPoints[i].u32RttUs < u32MinRtt) u32MinRtt = m_aoPoints[i].u32RttUs;
+  }
+  u32Limit = 2 * u32MinRtt + CMCC_CLOCK_RTT_SLACK_US;
+
+  // least squares of the offset over the M4 time, the origin at the newest
+  // exchange keeps the numbers small
+  for (i = 0; i < m_u32Count; ++i) {
+    if (m_aoPoints[i].u32RttUs > u32Limit) continue;
+    dX = (double)(int64_t)(m_aoPoints[i].u64M4Us - m_u64RefM4Us);
+    dY = (double)(int64_t)(m_aoPoints[i].u64A5Us - m_aoPoints[i].u64M4Us);
+    dN   += 1.0;
+    dSx  += dX;
+    dSy  += dY;
+    dSxx += dX * dX;
+    dSxy += dX * dY;
+    if (m_aoPoints[i].u64M4Us < u64MinM4) u64MinM4 = m_aoPoints[i].u64M4Us;
+  }
+
+  dDen = dN * dSxx - dSx * dSx;
+  if ((m_u64RefM4Us - u64MinM4 >= CMCC_CLOCK_MIN_SPAN_US) && (dDen > 0.0)) {
+    m_dDrift = (dN * dSxy - dSx * dSy) / dDen;
+    if (m_dDrift >  CMCC_CLOCK_DRIFT_MAX) m_dDrift =  CMCC_CLOCK_DRIFT_MAX;
+    if (m_dDrift < -CMCC_CLOCK_DRIFT_MAX) m_dDrift = -CMCC_CLOCK_DRIFT_MAX;
+  } else {
+    m_dDrift = 0.0;                                                             // too short to tell
+  }
+  m_dOffsetUs = (dSy - m_dDrift * dSx) / dN;
+  m_u32RttUs  = u32MinRtt;
+  m_bValid    = true;
+}
+
+//******************************************************************************
+
+uint64_t CMccClock::toA5Us (uint32_t u32M4Us) const
+{
+  double dA5Us;
+
+  pthread_mutex_lock(&m_mtx);
+  dA5Us = m_bValid ? this->predict(this->unwrap(u32M4Us)) : 0.0;
+  pthread_mutex_unlock(&m_mtx);
+
+  return (dA5Us > 0.0) ? (uint64_t)(dA5Us + 0.5) : 0;
+}
+
+//******************************************************************************
+
+bool CMccClock::getEstimate (int64_t   * pi64OffsetUs,
+                             double    * pdDriftPpm,
+                             uint32_t  * pu32RttUs) const
+{
+  bool bValid;
+
+  pthread_mutex_lock(&m_mtx);
+  bValid = m_bValid;
+  if (bValid) {
+    if (pi64OffsetUs) *pi64OffsetUs = (int64_t)llround(m_dOffsetUs);
+    if (pdDriftPpm)   *pdDriftPpm   = m_dDrift * 1e6;
+    if (pu32RttUs)    *pu32RttUs    = m_u32RttUs;
+  }
+  pthread_mutex_unlock(&m_mtx);
+
+  return bValid;
+}
+
+//******************************************************************************
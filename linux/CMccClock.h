@@ -0,0 +1,84 @@
+/*
+ * CMccClock.h
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#ifndef CMCCCLOCK_H_
+#define CMCCCLOCK_H_
+//******************************************************************************
+
+#include <pthread.h>
+#include <stdint.h>
+
+//******************************************************************************
+
+#define CMCC_CLOCK_POINTS               (32)                                    //!< Number of recent exchanges the estimate is based on.
+#define CMCC_CLOCK_RTT_SLACK_US         (100)                                   //!< Exchanges slower than twice the fastest one plus this are not used.
+#define CMCC_CLOCK_DRIFT_MAX            (500e-6)                                //!< Largest drift believed (crystal tolerance of both cores).
+#define CMCC_CLOCK_MIN_SPAN_US          (2000000)                               //!< Shortest M4 time span the drift is estimated over.
+#define CMCC_CLOCK_RESET_US             (100000)                                //!< Estimate error considered an M4 restart.
+
+//******************************************************************************
+
+/** Relation of the M4 time base (TMccPingMsg, MCC_ACCEL_STREAM_TIMES) to the
+ *  A5 CLOCK_MONOTONIC, estimated NTP-style from PING/PONG exchanges: each
+ *  exchange gives the offset at its midpoint with an error below half of its
+ *  round trip, the fastest recent exchanges are fitted by a line (offset and
+ *  drift). Thread-safe. */
+class CMccClock {
+public:
+  CMccClock ();
+  ~CMccClock ();
+
+  /** Forgets all the exchanges (the M4 restarted). */
+  void reset (void);
+
+  /** Adds the times of one PING/PONG exchange.
+   * @param[in] u64A5TxUs   A5 time of sending the PING.
+   * @param[in] u32M4RxUs   M4 time of receiving the PING.
+   * @param[in] u32M4TxUs   M4 time of sending the PONG.
+   * @param[in] u64A5RxUs   A5 time of receiving the PONG. */
+  void addExchange (uint64_t u64A5TxUs, uint32_t u32M4RxUs,
+                    uint32_t u32M4TxUs, uint64_t u64A5RxUs);
+
+  /** Converts an M4 time (at most ~35 minutes from the last exchange) to the
+   *  A5 time base.
+   * @return  A5 CLOCK_MONOTONIC time in microseconds, 0 if not known yet. */
+  uint64_t toA5Us (uint32_t u32M4Us) const;
+
+  /** Retrieves the current estimate.
+   * @param[out] pi64OffsetUs   A5 minus M4 time now (NULL if not needed).
+   * @param[out] pdDriftPpm     A5 clock rate relative to the M4 one minus 1, in ppm (NULL if not needed).
+   * @param[out] pu32RttUs      Fastest round trip of the exchanges used (NULL if not needed).
+   * @return  False if there is no estimate yet. */
+  bool getEstimate (int64_t * pi64OffsetUs, double * pdDriftPpm,
+                    uint32_t * pu32RttUs) const;
+
+  /** Returns the A5 CLOCK_MONOTONIC time in microseconds. */
+  static uint64_t nowUs (void);
+
+protected:
+  typedef struct t_clock_point_struct {
+    uint64_t          u64M4Us;                                                  //!< M4 time of the exchange midpoint (unwrapped).
+    uint64_t          u64A5Us;                                                  //!< A5 time of the exchange midpoint.
+    uint32_t          u32RttUs;                                                 //!< Round trip without the M4 processing time.
+  } TPoint;
+
+  mutable pthread_mutex_t m_mtx;                                                //!< Guards all the members below.
+  TPoint              m_aoPoints[CMCC_CLOCK_POINTS];                            //!< Ring of the recent exchanges.
+  uint32_t            m_u32Count;                                               //!< Number of valid m_aoPoints.
+  uint32_t            m_u32Next;                                                //!< Slot of the next exchange.
+  bool                m_bValid;                                                 //!< The fit below is valid.
+  uint64_t            m_u64RefM4Us;                                             //!< M4 time of the newest exchange (unwrapped), the fit origin.
+  double              m_dOffsetUs;                                              //!< A5 minus M4 time at m_u64RefM4Us.
+  double              m_dDrift;                                                 //!< Change of the offset per M4 microsecond.
+  uint32_t            m_u32RttUs;                                               //!< Fastest round trip used by the fit.
+
+  uint64_t unwrap (uint32_t u32M4Us) const;
+  double predict (uint64_t u64M4Us) const;
+  void fit (void);
+};
+
+//******************************************************************************
+#endif /* CMCCCLOCK_H_ */
@@ -0,0 +1,79 @@
+/*
+ * CMccCrc.cpp
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#include "CMccCrc.h"
+#include "../common/easyduo_mcc_common.h"
+
+#include <string.h>
+
+//******************************************************************************
+// Local definitions
+//******************************************************************************
+
+/** Loads a 32-bit word of the data, the first byte in the MSB. */
+static inline uint32_t crc_loadBe32 (const uint8_t * pu8Data)
+{
+  uint32_t u32Word;
+
+  memcpy(&u32Word, pu8Data, sizeof(u32Word));                                   // unaligned access allowed
+  return __builtin_bswap32(u32Word);                                            // both cores are little endian
+}
+
+//******************************************************************************
+//******************************************************************************
+//******************************************************************************
+
+uint32_t CMccCrc::s_aau32Table[8][256];
+
+//******************************************************************************
+
+bool CMccCrc::initTables (void)
+{
+  uint32_t  u32Crc;
+  int       i;
+  int       k;
+
+  for (i = 0; i < 256; ++i) {
+    u32Crc = (uint32_t)i << 24;
+    for (k = 0; k < 8; ++k) {
+      u32Crc = (u32Crc & 0x80000000) ? ((u32Crc << 1) ^ MCC_CRC_POLYNOMIAL) : (u32Crc << 1);
+    }
+    s_aau32Table[0][i] = u32Crc;
+  }
+  for (k = 1; k < 8; ++k) {
+    for (i = 0; i < 256; ++i) {
+      u32Crc = s_aau32Table[k-1][i];
+      s_aau32Table[k][i] = (u32Crc << 8) ^ s_aau32Table[0][u32Crc >> 24];
+    }
+  }
+  return true;
+}
+
+//******************************************************************************
+
+uint32_t CMccCrc::calc (const void * pvBuf, size_t len)
+{
+  static const bool   bInit   = CMccCrc::initTables();                          // thread-safe (C++11 and g++ before)
+  const uint8_t     * pu8Data = (const uint8_t*)pvBuf;
+  uint32_t            u32Crc  = MCC_CRC_SEED;
+  uint32_t            u32Lo;
+
+  (void)bInit;
+  for (; len >= 8; len -= 8, pu8Data += 8) {
+    u32Crc ^= crc_loadBe32(pu8Data);
+    u32Lo   = crc_loadBe32(pu8Data + 4);
+    u32Crc  = s_aau32Table[7][u32Crc >> 24]          ^ s_aau32Table[6][(u32Crc >> 16) & 0xFF]
+            ^ s_aau32Table[5][(u32Crc >> 8) & 0xFF]  ^ s_aau32Table[4][u32Crc & 0xFF]
+            ^ s_aau32Table[3][u32Lo >> 24]           ^ s_aau32Table[2][(u32Lo >> 16) & 0xFF]
+            ^ s_aau32Table[1][(u32Lo >> 8) & 0xFF]   ^ s_aau32Table[0][u32Lo & 0xFF];
+  }
+  for (; len; --len, ++pu8Data) {
+    u32Crc = (u32Crc << 8) ^ s_aau32Table[0][(u32Crc >> 24) ^ *pu8Data];
+  }
+  return u32Crc;
+}
+
+//******************************************************************************
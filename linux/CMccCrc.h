@@ -0,0 +1,34 @@
+/*
+ * CMccCrc.h
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#ifndef CMCCCRC_H_
+#define CMCCCRC_H_
+//******************************************************************************
+
+#include <stddef.h>
+#include <stdint.h>
+
+//******************************************************************************
+
+/** CRC of the MCC frame trailer (see MCC_CRC_POLYNOMIAL) in software,
+ *  slicing-by-8: eight bytes per step through eight lookup tables (8 kB,
+ *  computed by the first call). */
+class CMccCrc {
+public:
+  /** Computes the CRC of a buffer.
+   * @param[in] pvBuf   Data (any alignment).
+   * @param[in] len     Data length in bytes.
+   * @return  CRC value. */
+  static uint32_t calc (const void * pvBuf, size_t len);
+
+protected:
+  static uint32_t     s_aau32Table[8][256];                                     //!< s_aau32Table[k][b]: CRC of byte b followed by k zero bytes.
+
+  static bool initTables (void);
+};
+
+//******************************************************************************
+#endif /* CMCCCRC_H_ */
@@ -0,0 +1,37 @@
+/*
+ * CMccMsg.h
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#ifndef CMCCMSG_H_
+#define CMCCMSG_H_
+//******************************************************************************
+
+#include "CMccTransport.h"
+#include "../common/easyduo_mcc_common.h"
+
+//******************************************************************************
+
+/** Message types known at compile time, one specialization per MCC_MSG_TABLE
+ *  row (see CMcc::alloc, CMcc::send and CMcc::recv). */
+template <int32_t TYPE> struct CMccMsgTraits;
+
+/** Whether a message body carries anything but its type. */
+template <typename T> struct CMccMsgHasBody                 { static const bool value = true; };
+template <>           struct CMccMsgHasBody<TMccEmptyMsg>   { static const bool value = false; };
+
+#define CMCC_MSG_TRAITS(id, name, channel, sender, req, rep)                   \
+  template <> struct CMccMsgTraits<MCCMSG_##id> {                              \
+    typedef req TRequest;                                                      \
+    typedef rep TReply;                                                        \
+    static const bool bReply = CMccMsgHasBody<rep>::value;                     \
+    static const bool bBulk  = MCC_MSG_CHANNEL_##channel;                      \
+  };
+
+MCC_MSG_TABLE(CMCC_MSG_TRAITS)
+
+#undef CMCC_MSG_TRAITS
+
+//******************************************************************************
+#endif /* CMCCMSG_H_ */
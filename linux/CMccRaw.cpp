@@ -0,0 +1,49 @@
+/*
+ * CMccRaw.cpp
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#include "CMccRaw.h"
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+# include <arm_neon.h>
+# define CMCC_RAW_NEON                  1
+#elif defined(__SSE2__)
+# include <emmintrin.h>
+# define CMCC_RAW_SSE2                  1
+#endif
+
+//******************************************************************************
+//******************************************************************************
+//******************************************************************************
+
+void CMccRaw::toG (const int16_t * pi16Src, float * pfDst, size_t count,
+                   float fScale)
+{
+  size_t i = 0;
+
+#if CMCC_RAW_NEON
+  const float32x4_t vScale = vdupq_n_f32(fScale);
+
+  for (; i + 8 <= count; i += 8) {
+    int16x8_t vRaw = vld1q_s16(pi16Src + i);
+    vst1q_f32(pfDst + i,     vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(vRaw))),  vScale));
+    vst1q_f32(pfDst + i + 4, vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(vRaw))), vScale));
+  }
+#elif CMCC_RAW_SSE2
+  const __m128 vScale = _mm_set1_ps(fScale);
+
+  for (; i + 8 <= count; i += 8) {
+    __m128i vRaw = _mm_loadu_si128((const __m128i*)(pi16Src + i));
+    __m128i vLo  = _mm_srai_epi32(_mm_unpacklo_epi16(vRaw, vRaw), 16);         // sign extension to 32 bits
+    __m128i vHi  = _mm_srai_epi32(_mm_unpackhi_epi16(vRaw, vRaw), 16);
+    _mm_storeu_ps(pfDst + i,     _mm_mul_ps(_mm_cvtepi32_ps(vLo), vScale));
+    _mm_storeu_ps(pfDst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(vHi), vScale));
+  }
+#endif
+
+  for (; i < count; ++i) {                                                      // the rest (all without SIMD)
+    pfDst[i] = (float)pi16Src[i] * fScale;
+  }
+}
@@ -0,0 +1,32 @@
+/*
+ * CMccRaw.h
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#ifndef CMCCRAW_H_
+#define CMCCRAW_H_
+//******************************************************************************
+
+#include <stddef.h>
+#include <stdint.h>
+
+//******************************************************************************
+
+/** Conversion of the raw accelerometer counts (TMccAccelRawMsg) to g in
+ *  batches: eight counts per step by NEON on the A5 (-mfpu=neon), by SSE2 on
+ *  the x86 hosts, one by one otherwise. */
+class CMccRaw {
+public:
+  /** Converts counts to g: pfDst[i] = pi16Src[i] * fScale. Exact for the
+   *  power of 2 scales of the MMA845x (the same values the M4 would compute).
+   * @param[in]  pi16Src  Counts (any alignment).
+   * @param[out] pfDst    Destination of the values (any alignment).
+   * @param[in]  count    Number of counts.
+   * @param[in]  fScale   g per count (1 / TMccAccelScale::u16CountsPerG). */
+  static void toG (const int16_t * pi16Src, float * pfDst, size_t count,
+                   float fScale);
+};
+
+//******************************************************************************
+#endif /* CMCCRAW_H_ */
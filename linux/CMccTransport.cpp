@@ -0,0 +1,27 @@
+/*
+ * CMccTransport.cpp
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#include "CMccTransport.h"
+#include "CMccTransportSocket.h"
+#ifndef CMCC_TRANSPORT_SOCKET_ONLY
+# include "CMccTransportMcc.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+
+//******************************************************************************
+
+CMccTransport * CMccTransport::create (MCC_NODE iNode, MCC_PORT iPort)
+{
+#ifndef CMCC_TRANSPORT_SOCKET_ONLY
+  if (!getenv(CMCC_TRANSPORT_SIM_ENV)) return new CMccTransportMcc(iNode, iPort);
+#endif
+  printf("MCC simulator transport\n");
+  return new CMccTransportSocket(iNode, iPort);
+}
+
+//******************************************************************************
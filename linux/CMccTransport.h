@@ -0,0 +1,100 @@
+/*
+ * CMccTransport.h
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#ifndef CMCCTRANSPORT_H_
+#define CMCCTRANSPORT_H_
+//******************************************************************************
+
+extern "C"
+{
+#include <linux/mcc_config.h>
+#include <linux/mcc_common.h>
+}
+
+#include <stddef.h>
+#include <stdint.h>
+
+//******************************************************************************
+// Return values
+//******************************************************************************
+
+enum {
+  MCC_OK                          = 0,
+  MCC_INIT_FAILURE,
+  MCC_INFO_FAILURE,
+  MCC_VERSION_FAILURE,
+  MCC_ENDPOINT_FAILURE,
+  MCC_SEND_FAILURE,
+  MCC_RECV_FAILURE,
+  MCC_FREE_FAILURE,
+  MCC_INVALID_ARGUMENT,
+  MCC_THREAD_FAILURE,
+  MCC_TIMEOUT,
+  MCC_CANCELLED,
+  MCC_BUSY,
+  MCC_LINK_DOWN,
+};
+
+//******************************************************************************
+
+#define CMCC_TRANSPORT_SIM_ENV          "EASYDUO_MCC_SIM"                       //!< Environment variable selecting the simulator transport.
+#define CMCC_TRANSPORT_WAIT_INF         (0xFFFFFFFF)                            //!< recvMsg() timeout waiting forever.
+
+//******************************************************************************
+
+/** Message transport between the A5 application and the M4 (or its host
+ *  simulator). Implementations throw one of the return values above from
+ *  their constructors if the transport cannot be opened. */
+class CMccTransport {
+public:
+  virtual ~CMccTransport () {}
+
+  /** Retrieves a buffer to compose a message for the M4 in, so that
+   *  sendTxBuffer() does not need to copy it.
+   * @return  Buffer of MCC_ATTR_BUFFER_SIZE_IN_BYTES bytes, NULL if there is
+   *          no free one. */
+  virtual void * getTxBuffer (void) = 0;
+
+  /** Sends a message composed in a getTxBuffer() buffer to the M4 endpoint
+   *  of given port, never blocks. The buffer is handed over, even if the
+   *  call fails.
+   * @return  MCC_OK or MCC_SEND_FAILURE. */
+  virtual int sendTxBuffer (void * pvBuf, MCC_MEM_SIZE size, MCC_PORT iRemotePort) = 0;
+
+  /** Releases a getTxBuffer() buffer which is not going to be sent. */
+  virtual void freeTxBuffer (void * pvBuf) = 0;
+
+  /** Sends a message to the own local endpoint, so that a thread blocked in
+   *  recvMsg() wakes up.
+   * @return  MCC_OK or MCC_SEND_FAILURE. */
+  virtual int sendLocalMsg (const void * pvMsg, MCC_MEM_SIZE size) = 0;
+
+  /** Waits for a message. The buffer must be released by freeMsg().
+   * @param[in] u32TimeoutMs  Maximum time to wait, CMCC_TRANSPORT_WAIT_INF for ever.
+   * @return  MCC_OK, MCC_TIMEOUT or MCC_RECV_FAILURE. */
+  virtual int recvMsg (void ** ppvMsg, MCC_MEM_SIZE * pSize, uint32_t u32TimeoutMs) = 0;
+
+  /** Releases a buffer returned by recvMsg().
+   * @return  MCC_OK or MCC_FREE_FAILURE. */
+  virtual int freeMsg (void * pvMsg) = 0;
+
+  /** Re-creates the local endpoint after the M4 rebooted (the M4 side of the
+   *  link forgets it). Called by the thread receiving the messages only.
+   * @return  MCC_OK or MCC_ENDPOINT_FAILURE. */
+  virtual int reopen (void) { return MCC_OK; }
+
+  /** Retrieves the memory shared with the M4 at MCC_SNAPSHOT_ADDRESS (see
+   *  TMccAccelSnapshot), mapped for the whole transport lifetime.
+   * @return  Region of MCC_SNAPSHOT_SIZE bytes, NULL if not available. */
+  virtual volatile void * getSnapshot (void) { return NULL; }
+
+  /** Opens the libmcc transport, or the simulator transport if the
+   *  CMCC_TRANSPORT_SIM_ENV variable is set (always on builds without libmcc). */
+  static CMccTransport * create (MCC_NODE iNode, MCC_PORT iPort);
+};
+
+//******************************************************************************
+#endif /* CMCCTRANSPORT_H_ */
@@ -0,0 +1,232 @@
+/*
+ * CMccTransportLoopback.cpp
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#include "CMccTransportLoopback.h"
+#include "CMccCrc.h"
+#include "../common/easyduo_mcc_common.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+//******************************************************************************
+// Local functions
+//******************************************************************************
+
+/** Returns the CLOCK_MONOTONIC time in microseconds (wrapping). */
+static uint32_t loopback_timeUs (void)
+{
+  struct timespec oNow;
+
+  clock_gettime(CLOCK_MONOTONIC, &oNow);
+  return (uint32_t)oNow.tv_sec * 1000000u + (uint32_t)(oNow.tv_nsec / 1000);
+}
+
+//******************************************************************************
+//******************************************************************************
+//******************************************************************************
+
+CMccTransportLoopback::CMccTransportLoopback ()
+  : m_u32Head(0), m_u32Tail(0)
+{
+  pthread_condattr_t condAttr;
+
+  m_au32TxSeq[0] = m_au32TxSeq[1] = 0;
+  m_u32StartUs   = loopback_timeUs();
+  pthread_mutex_init(&m_mtx, NULL);
+  pthread_condattr_init(&condAttr);
+  pthread_condattr_setclock(&condAttr, CLOCK_MONOTONIC);                        // recvMsg timeouts
+  pthread_cond_init(&m_cond, &condAttr);
+  pthread_condattr_destroy(&condAttr);
+}
+
+//******************************************************************************
+
+CMccTransportLoopback::~CMccTransportLoopback ()
+{
+  while (m_u32Tail != m_u32Head) {
+    free(m_aoQueue[m_u32Tail++ % CMCC_LOOPBACK_QUEUE_SIZE].pvMsg);
+  }
+  pthread_cond_destroy(&m_cond);
+  pthread_mutex_destroy(&m_mtx);
+}
+
+//******************************************************************************
+
+int CMccTransportLoopback::enqueue (void * pvMsg, MCC_MEM_SIZE size)
+{
+  int ret = MCC_OK;
+
+  pthread_mutex_lock(&m_mtx);
+  if (m_u32Head - m_u32Tail >= CMCC_LOOPBACK_QUEUE_SIZE) {
+    ret = MCC_SEND_FAILURE;                                                     // out of receive buffers, as MCC would be
+  } else {
+    m_aoQueue[m_u32Head % CMCC_LOOPBACK_QUEUE_SIZE].pvMsg = pvMsg;
+    m_aoQueue[m_u32Head % CMCC_LOOPBACK_QUEUE_SIZE].size  = size;
+    ++m_u32Head;
+    pthread_cond_signal(&m_cond);
+  }
+  pthread_mutex_unlock(&m_mtx);
+
+  if (MCC_OK != ret) {
+    printf("loopback queue full\n");
+    free(pvMsg);
+  }
+  return ret;
+}
+
+//******************************************************************************
+
+void * CMccTransportLoopback::reply (const void * pvReq, MCC_MEM_SIZE reqSize, bool bBulk, MCC_MEM_SIZE * pSize)
+{
+  const TMccHdr * poReq   = (const TMccHdr*)pvReq;
+  uint32_t        u32RxUs = loopback_timeUs();
+  TMccHdr       * poHdr;
+  TMccMsg       * poMsg;
+  TMccPingMsg   * poPing;
+  MCC_MEM_SIZE    crcSize;
+  uint32_t        u32Crc;
+
+  if ((reqSize < sizeof(TMccHdr)) || (MCC_HDR_MAGIC != poReq->u16Magic)) {
+    return NULL;                                                                // bare messages are not answered
+  }
+  if (MCCMSG_CREDIT == poReq->type) return NULL;                                // acknowledgements are not acknowledged
+
+  // check the CRC as the M4 would, the reply gets one too
+  crcSize = (poReq->u8Flags & MCC_HDR_FLAG_CRC) ? MCC_CRC_SIZE : 0;
+  if (crcSize) {
+    memcpy(&u32Crc, (const uint8_t*)pvReq + reqSize - MCC_CRC_SIZE, MCC_CRC_SIZE);
+    if (CMccCrc::calc(pvReq, reqSize - MCC_CRC_SIZE) != u32Crc) return NULL;
+    reqSize -= MCC_CRC_SIZE;
+  }
+
+  poHdr = (TMccHdr*)malloc(MCC_ATTR_BUFFER_SIZE_IN_BYTES);
+  if (!poHdr) return NULL;
+
+  if (MCCMSG_HELLO == poReq->type) {
+    poMsg       = (TMccMsg*)&poHdr->type;
+    poMsg->type = MCCMSG_HELLO;
+    poMsg->u32Version = ((const TMccMsg*)&poReq->type)->u32Version;
+    if (poMsg->u32Version > MCC_PROTOCOL_VERSION) poMsg->u32Version = MCC_PROTOCOL_VERSION;
+    *pSize      = MCC_HDR_PREFIX_SIZE + sizeof(TMccMsg);
+  } else if (MCCMSG_PING == poReq->type) {
+    poPing                = (TMccPingMsg*)&poHdr->type;
+    poPing->type          = MCCMSG_PONG;
+    poPing->u32A5TimeUs   = ((const TMccPingMsg*)&poReq->type)->u32A5TimeUs;
+    poPing->u32M4RxTimeUs = u32RxUs;
+    poPing->u32M4TxTimeUs = loopback_timeUs();
+    *pSize                = reqSize;                                            // same size, payload not copied
+  } else if (MCCMSG_HEARTBEAT == poReq->type) {
+    poMsg       = (TMccMsg*)&poHdr->type;
+    poMsg->type = MCCMSG_HEARTBEAT;
+    poMsg->u32UptimeMs = (u32RxUs - m_u32StartUs) / 1000;                       // wraps after 71 minutes, a reboot for the A5
+    *pSize      = MCC_HDR_PREFIX_SIZE + sizeof(TMccMsg);
+  } else {
+    poHdr->type = MCCMSG_CREDIT;                                                // not answered, acknowledged at once
+    *pSize      = sizeof(TMccHdr);
+  }
+
+  if (!++m_au32TxSeq[bBulk]) ++m_au32TxSeq[bBulk];
+  poHdr->u16Magic     = MCC_HDR_MAGIC;
+  poHdr->u8Version    = MCC_PROTOCOL_VERSION;
+  poHdr->u8Flags      = (crcSize ? MCC_HDR_FLAG_CRC : 0) | (bBulk ? MCC_HDR_FLAG_BULK : 0);
+  poHdr->u16Length    = *pSize - sizeof(TMccHdr);
+  poHdr->u16Ack       = (uint16_t)poReq->u32Seq;
+  poHdr->u32Seq       = m_au32TxSeq[bBulk];
+  poHdr->u32Ref       = 0;
+  if (MCCMSG_CREDIT != poHdr->type) {
+    poHdr->u8Flags   |= MCC_HDR_FLAG_REPLY;
+    poHdr->u32Ref     = poReq->u32Seq;
+  }
+  if (crcSize) {
+    u32Crc = CMccCrc::calc(poHdr, *pSize);
+    memcpy((uint8_t*)poHdr + *pSize, &u32Crc, MCC_CRC_SIZE);
+    *pSize += MCC_CRC_SIZE;
+  }
+  return poHdr;
+}
+
+//******************************************************************************
+
+void * CMccTransportLoopback::getTxBuffer (void)
+{
+  return malloc(MCC_ATTR_BUFFER_SIZE_IN_BYTES);
+}
+
+//******************************************************************************
+
+int CMccTransportLoopback::sendTxBuffer (void * pvBuf, MCC_MEM_SIZE size, MCC_PORT iRemotePort)
+{
+  MCC_MEM_SIZE    replySize;
+  void          * pvReply;
+
+  pvReply = this->reply(pvBuf, size, MCC_ENDPOINT_M4_BULK_PORT == iRemotePort, &replySize);
+  free(pvBuf);
+  if (pvReply) this->enqueue(pvReply, replySize);                               // a lost reply is the receiver's problem, as with the M4
+  return MCC_OK;
+}
+
+//******************************************************************************
+
+void CMccTransportLoopback::freeTxBuffer (void * pvBuf)
+{
+  free(pvBuf);
+}
+
+//******************************************************************************
+
+int CMccTransportLoopback::sendLocalMsg (const void * pvMsg, MCC_MEM_SIZE size)
+{
+  void * pvCopy = malloc(size);
+
+  if (!pvCopy) return MCC_SEND_FAILURE;
+  memcpy(pvCopy, pvMsg, size);
+  return this->enqueue(pvCopy, size);
+}
+
+//******************************************************************************
+
+int CMccTransportLoopback::recvMsg (void ** ppvMsg, MCC_MEM_SIZE * pSize, uint32_t u32TimeoutMs)
+{
+  struct timespec oDeadline;
+
+  if (CMCC_TRANSPORT_WAIT_INF != u32TimeoutMs) {
+    clock_gettime(CLOCK_MONOTONIC, &oDeadline);
+    oDeadline.tv_sec  += u32TimeoutMs / 1000;
+    oDeadline.tv_nsec += (u32TimeoutMs % 1000) * 1000000L;
+    if (oDeadline.tv_nsec >= 1000000000L) {
+      oDeadline.tv_sec  += 1;
+      oDeadline.tv_nsec -= 1000000000L;
+    }
+  }
+
+  pthread_mutex_lock(&m_mtx);
+  while (m_u32Tail == m_u32Head) {
+    if (CMCC_TRANSPORT_WAIT_INF == u32TimeoutMs) {
+      pthread_cond_wait(&m_cond, &m_mtx);
+    } else if (ETIMEDOUT == pthread_cond_timedwait(&m_cond, &m_mtx, &oDeadline)) {
+      pthread_mutex_unlock(&m_mtx);
+      return MCC_TIMEOUT;
+    }
+  }
+  *ppvMsg = m_aoQueue[m_u32Tail % CMCC_LOOPBACK_QUEUE_SIZE].pvMsg;
+  *pSize  = m_aoQueue[m_u32Tail % CMCC_LOOPBACK_QUEUE_SIZE].size;
+  ++m_u32Tail;
+  pthread_mutex_unlock(&m_mtx);
+  return MCC_OK;
+}
+
+//******************************************************************************
+
+int CMccTransportLoopback::freeMsg (void * pvMsg)
+{
+  free(pvMsg);
+  return MCC_OK;
+}
+
+//******************************************************************************
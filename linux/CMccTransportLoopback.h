@@ -0,0 +1,58 @@
+/*
+ * CMccTransportLoopback.h
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#ifndef CMCCTRANSPORTLOOPBACK_H_
+#define CMCCTRANSPORTLOOPBACK_H_
+//******************************************************************************
+
+#include "CMccTransport.h"
+
+#include <pthread.h>
+
+//******************************************************************************
+
+#define CMCC_LOOPBACK_QUEUE_SIZE        (MCC_ATTR_NUM_RECEIVE_BUFFERS)          //!< Capacity of the receive queue, as many as the MCC receive buffers.
+
+//******************************************************************************
+
+/** In-process stand-in for the M4, answering MCCMSG_HELLO, MCCMSG_PING and
+ *  MCCMSG_HEARTBEAT right from sendTxBuffer() (checking and appending the CRC
+ *  trailer if the request has one) and acknowledging any other message by a
+ *  MCCMSG_CREDIT.
+ *  Measures the cost of CMcc and its threads without the inter-core link
+ *  (see mccbench). */
+class CMccTransportLoopback : public CMccTransport {
+public:
+  CMccTransportLoopback ();
+  ~CMccTransportLoopback ();
+
+  void * getTxBuffer (void);
+  int sendTxBuffer (void * pvBuf, MCC_MEM_SIZE size, MCC_PORT iRemotePort);
+  void freeTxBuffer (void * pvBuf);
+  int sendLocalMsg (const void * pvMsg, MCC_MEM_SIZE size);
+  int recvMsg (void ** ppvMsg, MCC_MEM_SIZE * pSize, uint32_t u32TimeoutMs);
+  int freeMsg (void * pvMsg);
+
+protected:
+  typedef struct t_loopback_msg_struct {
+    void            * pvMsg;
+    MCC_MEM_SIZE      size;
+  } TLoopbackMsg;
+
+  pthread_mutex_t     m_mtx;                                                    //!< Guards the queue.
+  pthread_cond_t      m_cond;                                                   //!< Signalled when a message is queued.
+  TLoopbackMsg        m_aoQueue[CMCC_LOOPBACK_QUEUE_SIZE];
+  uint32_t            m_u32Head;                                                //!< Total number of queued messages.
+  uint32_t            m_u32Tail;                                                //!< Total number of received messages.
+  uint32_t            m_au32TxSeq[2];                                           //!< Sequence number of the last reply per channel (CMcc serializes the sends).
+  uint32_t            m_u32StartUs;                                             //!< Creation time, the MCCMSG_HEARTBEAT uptime counts from.
+
+  int enqueue (void * pvMsg, MCC_MEM_SIZE size);
+  void * reply (const void * pvReq, MCC_MEM_SIZE reqSize, bool bBulk, MCC_MEM_SIZE * pSize);
+};
+
+//******************************************************************************
+#endif /* CMCCTRANSPORTLOOPBACK_H_ */
@@ -0,0 +1,262 @@
+/*
+ * CMccTransportMcc.cpp
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#include "CMccTransportMcc.h"
+
+extern "C"
+{
+#include <mcc_api.h>
+}
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+//******************************************************************************
+// Local definitions
+//******************************************************************************
+
+#define MCC_DEV_MEM                     "/dev/mem"                              //!< Physical memory device mapping the shared snapshot.
+
+//******************************************************************************
+//******************************************************************************
+//******************************************************************************
+
+CMccTransportMcc::CMccTransportMcc (MCC_NODE iNode, MCC_PORT iPort)
+  : m_pvSnapshotMap(NULL), m_snapshotMapSize(0), m_pvSnapshot(NULL)
+{
+  MCC_INFO_STRUCT     mccInfo;
+  int                 ret;
+
+#if !MCC_SEND_NOCOPY
+  pthread_mutex_init(&m_mtxTxPool, NULL);
+  for (m_u32TxFree = 0; m_u32TxFree < CMCC_TX_POOL_SIZE; ++m_u32TxFree) {
+    m_apvTxFree[m_u32TxFree] = m_au64Tx[m_u32TxFree];
+  }
+#endif
+
+  m_mccEndpointRemote.core = MCC_ENDPOINT_M4_CORE;
+  m_mccEndpointRemote.node = MCC_ENDPOINT_M4_NODE;
+  m_mccEndpointRemote.port = MCC_ENDPOINT_M4_PORT;
+
+  ret = mcc_initialize(iNode);
+  if (MCC_SUCCESS != ret) {
+    printf("mcc_initialize failed: %d\n", ret);
+    throw MCC_INIT_FAILURE;
+  }
+
+  ret = mcc_get_info(iNode, &mccInfo);
+  if (MCC_SUCCESS != ret) {
+    printf("mcc_get_info failed: %d\n", ret);
+    mcc_destroy(iNode);
+    throw MCC_INFO_FAILURE;
+  } else if (strncmp(mccInfo.version_string, MCC_VERSION_STRING, 3) != 0) {     // compare first 3 bytes (major number)
+    printf("MCC Library versions do not match ('%s' vs '%s')\n",
+           mccInfo.version_string, MCC_VERSION_STRING);
+    mcc_destroy(iNode);
+    throw MCC_VERSION_FAILURE;
+  } else {
+    printf("MCC version %s loaded\n", mccInfo.version_string);
+  }
+
+  ret = mcc_create_endpoint(&m_mccEndpointLocal, iPort);
+  if (MCC_SUCCESS != ret) {
+    printf("mcc_create_endpoint() failed: %d, node,port: %d, %d\n",
+           ret, iNode, iPort);
+    mcc_destroy(iNode);                                                         // initialized again by the next attempt
+    throw MCC_ENDPOINT_FAILURE;
+  }
+
+  this->mapSnapshot();                                                          // optional, the messages work without it
+}
+
+//******************************************************************************
+
+CMccTransportMcc::~CMccTransportMcc ()
+{
+  if (m_pvSnapshotMap) munmap(m_pvSnapshotMap, m_snapshotMapSize);
+#if !MCC_SEND_NOCOPY
+  pthread_mutex_destroy(&m_mtxTxPool);
+#endif
+}
+
+//******************************************************************************
+
+void CMccTransportMcc::mapSnapshot (void)
+{
+  off_t   offPage = MCC_SNAPSHOT_ADDRESS & ~((off_t)sysconf(_SC_PAGESIZE) - 1);
+  void  * pvMap;
+  int     iFd;
+
+  iFd = open(MCC_DEV_MEM, O_RDWR | O_SYNC);                                     // O_SYNC: uncached mapping
+  if (iFd < 0) {
+    printf("open %s failed, shared snapshot not available\n", MCC_DEV_MEM);
+    return;
+  }
+  m_snapshotMapSize = MCC_SNAPSHOT_ADDRESS - offPage + MCC_SNAPSHOT_SIZE;
+  pvMap = mmap(NULL, m_snapshotMapSize, PROT_READ | PROT_WRITE, MAP_SHARED, iFd, offPage);
+  close(iFd);
+  if (MAP_FAILED == pvMap) {
+    printf("mmap %s failed, shared snapshot not available\n", MCC_DEV_MEM);
+    return;
+  }
+  m_pvSnapshotMap = pvMap;
+  m_pvSnapshot    = (uint8_t*)pvMap + (MCC_SNAPSHOT_ADDRESS - offPage);
+}
+
+//******************************************************************************
+
+volatile void * CMccTransportMcc::getSnapshot (void)
+{
+  return m_pvSnapshot;
+}
+
+//******************************************************************************
+
+int CMccTransportMcc::send (MCC_ENDPOINT * pEndpoint, const void * pvMsg, MCC_MEM_SIZE size)
+{
+  int ret;
+
+  ret = mcc_send(pEndpoint, (void*)pvMsg, size, 0);                             // non-blocking call
+  if (MCC_SUCCESS != ret) {
+    printf("mcc_send failed: %d\n", ret);
+    return MCC_SEND_FAILURE;
+  }
+  return MCC_OK;
+}
+
+//******************************************************************************
+
+void * CMccTransportMcc::getTxBuffer (void)
+{
+#if MCC_SEND_NOCOPY
+  void          * pvBuf;
+  MCC_MEM_SIZE    size;
+  int             ret;
+
+  ret = mcc_get_buffer(&pvBuf, &size, 0);                                       // non-blocking call
+  if (MCC_SUCCESS != ret) {
+    printf("mcc_get_buffer failed: %d\n", ret);
+    return NULL;
+  }
+  return pvBuf;
+#else
+  void * pvBuf = NULL;
+
+  pthread_mutex_lock(&m_mtxTxPool);
+  if (m_u32TxFree) pvBuf = m_apvTxFree[--m_u32TxFree];
+  pthread_mutex_unlock(&m_mtxTxPool);
+  if (!pvBuf) pvBuf = malloc(MCC_ATTR_BUFFER_SIZE_IN_BYTES);                    // pool exhausted
+  return pvBuf;
+#endif
+}
+
+//******************************************************************************
+
+int CMccTransportMcc::sendTxBuffer (void * pvBuf, MCC_MEM_SIZE size, MCC_PORT iRemotePort)
+{
+  MCC_ENDPOINT  oRemote = m_mccEndpointRemote;
+  int           ret;
+
+  oRemote.port = iRemotePort;
+
+#if MCC_SEND_NOCOPY
+  ret = mcc_send_nocopy(&m_mccEndpointLocal, &oRemote, pvBuf, size);
+  if (MCC_SUCCESS != ret) {
+    printf("mcc_send_nocopy failed: %d\n", ret);
+    mcc_free_buffer(pvBuf);                                                     // still ours on failure
+    return MCC_SEND_FAILURE;
+  }
+  return MCC_OK;
+#else
+  ret = this->send(&oRemote, pvBuf, size);                                      // copied by mcc_send
+  this->freeTxBuffer(pvBuf);
+  return ret;
+#endif
+}
+
+//******************************************************************************
+
+void CMccTransportMcc::freeTxBuffer (void * pvBuf)
+{
+#if MCC_SEND_NOCOPY
+  mcc_free_buffer(pvBuf);
+#else
+  if (((uint8_t*)pvBuf < (uint8_t*)m_au64Tx)
+      || ((uint8_t*)pvBuf >= (uint8_t*)m_au64Tx + sizeof(m_au64Tx))) {
+    free(pvBuf);                                                                // from the heap, see getTxBuffer
+    return;
+  }
+  pthread_mutex_lock(&m_mtxTxPool);
+  m_apvTxFree[m_u32TxFree++] = pvBuf;
+  pthread_mutex_unlock(&m_mtxTxPool);
+#endif
+}
+
+//******************************************************************************
+
+int CMccTransportMcc::sendLocalMsg (const void * pvMsg, MCC_MEM_SIZE size)
+{
+  return this->send(&m_mccEndpointLocal, pvMsg, size);
+}
+
+//******************************************************************************
+
+int CMccTransportMcc::recvMsg (void ** ppvMsg, MCC_MEM_SIZE * pSize, uint32_t u32TimeoutMs)
+{
+  unsigned int  uTimeoutUs = MCC_WAIT_INF;
+  int           ret;
+
+  // finite timeouts are fine as long as the buffer of a failed call is not
+  // touched (which used to crash the callers ignoring the return value)
+  if (CMCC_TRANSPORT_WAIT_INF != u32TimeoutMs) {
+    uTimeoutUs = (u32TimeoutMs < MCC_WAIT_INF / 1000) ? u32TimeoutMs * 1000 : MCC_WAIT_INF - 1;
+  }
+
+  ret = mcc_recv_nocopy(&m_mccEndpointLocal, ppvMsg, pSize, uTimeoutUs);        // blocking call
+  if (MCC_ERR_TIMEOUT == ret) {
+    return MCC_TIMEOUT;
+  } else if (MCC_SUCCESS != ret) {
+    printf("mcc_recv_nocopy failed: %d\n", ret);
+    return MCC_RECV_FAILURE;
+  }
+  return MCC_OK;
+}
+
+//******************************************************************************
+
+int CMccTransportMcc::freeMsg (void * pvMsg)
+{
+  int ret;
+
+  ret = mcc_free_buffer(pvMsg);
+  if (MCC_SUCCESS != ret) {
+    printf("mcc_free_buffer failed: %d\n", ret);
+    return MCC_FREE_FAILURE;
+  }
+  return MCC_OK;
+}
+
+//******************************************************************************
+
+int CMccTransportMcc::reopen (void)
+{
+  MCC_PORT  iPort = m_mccEndpointLocal.port;
+  int       ret;
+
+  mcc_destroy_endpoint(&m_mccEndpointLocal);                                    // may be gone already
+  ret = mcc_create_endpoint(&m_mccEndpointLocal, iPort);
+  if (MCC_SUCCESS != ret) {
+    printf("mcc_create_endpoint() failed: %d, port: %d\n", ret, iPort);
+    return MCC_ENDPOINT_FAILURE;
+  }
+  return MCC_OK;
+}
+
+//******************************************************************************
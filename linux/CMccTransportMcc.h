@@ -0,0 +1,68 @@
+/*
+ * CMccTransportMcc.h
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#ifndef CMCCTRANSPORTMCC_H_
+#define CMCCTRANSPORTMCC_H_
+//******************************************************************************
+
+#include "CMccTransport.h"
+#include "../common/easyduo_mcc_common.h"
+
+#include <pthread.h>
+
+//******************************************************************************
+
+/** @def MCC_SEND_NOCOPY
+ * @brief Set to 1 if libmcc provides mcc_get_buffer() and mcc_send_nocopy().
+ *        The messages are then composed directly in the shared memory,
+ *        otherwise they are composed in a heap buffer and copied by mcc_send(). */
+#ifndef MCC_SEND_NOCOPY
+# define MCC_SEND_NOCOPY                (0)
+#endif
+
+/** @def CMCC_TX_POOL_SIZE
+ * @brief Number of buffers preallocated to compose the messages in without
+ *        MCC_SEND_NOCOPY, as many as the credits of both channels; the heap
+ *        serves the rare excess. */
+#define CMCC_TX_POOL_SIZE               (2 * MCC_CREDITS_A5)
+
+//******************************************************************************
+
+/** Transport over the Vybrid shared memory (kernel MCC driver, libmcc). */
+class CMccTransportMcc : public CMccTransport {
+public:
+  CMccTransportMcc (MCC_NODE iNode, MCC_PORT iPort);
+  ~CMccTransportMcc ();
+
+  void * getTxBuffer (void);
+  int sendTxBuffer (void * pvBuf, MCC_MEM_SIZE size, MCC_PORT iRemotePort);
+  void freeTxBuffer (void * pvBuf);
+  int sendLocalMsg (const void * pvMsg, MCC_MEM_SIZE size);
+  int recvMsg (void ** ppvMsg, MCC_MEM_SIZE * pSize, uint32_t u32TimeoutMs);
+  int freeMsg (void * pvMsg);
+  int reopen (void);
+  volatile void * getSnapshot (void);
+
+protected:
+  MCC_ENDPOINT m_mccEndpointLocal;                                              //!< Local EasyDuo MCC endpoint.
+  MCC_ENDPOINT m_mccEndpointRemote;                                             //!< Remote EasyDuo MCC endpoint (port set per message).
+  void       * m_pvSnapshotMap;                                                 //!< Pages of /dev/mem holding MCC_SNAPSHOT_ADDRESS, NULL if not mapped.
+  size_t       m_snapshotMapSize;                                               //!< Size of the m_pvSnapshotMap mapping.
+  void       * m_pvSnapshot;                                                    //!< MCC_SNAPSHOT_ADDRESS within m_pvSnapshotMap, NULL if not mapped.
+#if !MCC_SEND_NOCOPY
+  pthread_mutex_t m_mtxTxPool;                                                  //!< Guards m_apvTxFree and m_u32TxFree.
+  void       * m_apvTxFree[CMCC_TX_POOL_SIZE];                                  //!< Free buffers of m_au64Tx.
+  uint32_t     m_u32TxFree;                                                     //!< Number of m_apvTxFree.
+  uint64_t     m_au64Tx[CMCC_TX_POOL_SIZE][MCC_ATTR_BUFFER_SIZE_IN_BYTES / 8];  //!< Transmit buffers, 64-bit aligned.
+#endif
+
+  void mapSnapshot (void);
+
+  int send (MCC_ENDPOINT * pEndpoint, const void * pvMsg, MCC_MEM_SIZE size);
+};
+
+//******************************************************************************
+#endif /* CMCCTRANSPORTMCC_H_ */
@@ -0,0 +1,199 @@
+/*
+ * CMccTransportSocket.cpp
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#include "CMccTransportSocket.h"
+#include "../common/easyduo_mcc_common.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+//******************************************************************************
+//******************************************************************************
+//******************************************************************************
+
+CMccTransportSocket::CMccTransportSocket (MCC_NODE iNode, MCC_PORT iPort)
+  : m_pvSnapshot(NULL)
+{
+  int iFd;
+
+  CMccTransportSocket::endpointAddr(&m_oAddrLocal, iNode, iPort);
+
+  m_iSocket = socket(AF_UNIX, SOCK_DGRAM, 0);
+  if (m_iSocket < 0) {
+    printf("socket failed: %d\n", errno);
+    throw MCC_INIT_FAILURE;
+  }
+
+  unlink(m_oAddrLocal.sun_path);                                                // left over by a crashed instance
+  if (bind(m_iSocket, (struct sockaddr*)&m_oAddrLocal, sizeof(m_oAddrLocal)) < 0) {
+    printf("bind %s failed: %d\n", m_oAddrLocal.sun_path, errno);
+    close(m_iSocket);
+    throw MCC_ENDPOINT_FAILURE;
+  }
+
+  // created by whichever side comes first, the simulator may restart meanwhile
+  iFd = shm_open(MCC_SIM_SNAPSHOT_NAME, O_RDWR | O_CREAT, 0600);
+  if ((iFd >= 0) && !ftruncate(iFd, MCC_SNAPSHOT_SIZE)) {
+    m_pvSnapshot = mmap(NULL, MCC_SNAPSHOT_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, iFd, 0);
+    if (MAP_FAILED == m_pvSnapshot) m_pvSnapshot = NULL;
+  }
+  if (iFd >= 0) close(iFd);
+  if (!m_pvSnapshot) printf("shm %s not available: %d\n", MCC_SIM_SNAPSHOT_NAME, errno);
+}
+
+//******************************************************************************
+
+CMccTransportSocket::~CMccTransportSocket ()
+{
+  if (m_pvSnapshot) munmap(m_pvSnapshot, MCC_SNAPSHOT_SIZE);
+  close(m_iSocket);
+  unlink(m_oAddrLocal.sun_path);
+}
+
+//******************************************************************************
+
+void CMccTransportSocket::endpointAddr (struct sockaddr_un * poAddr, MCC_NODE iNode, MCC_PORT iPort)
+{
+  memset(poAddr, 0, sizeof(*poAddr));
+  poAddr->sun_family = AF_UNIX;
+  snprintf(poAddr->sun_path, sizeof(poAddr->sun_path), MCC_SIM_SOCKET_PATH,
+           (unsigned)iNode, (unsigned)iPort);
+}
+
+//******************************************************************************
+
+int CMccTransportSocket::send (const struct sockaddr_un & oAddr, const void * pvMsg, MCC_MEM_SIZE size)
+{
+  if (sendto(m_iSocket, pvMsg, size, MSG_DONTWAIT,
+             (const struct sockaddr*)&oAddr, sizeof(oAddr)) < 0) {              // non-blocking call
+    if (EAGAIN != errno) {                                                      // EAGAIN: receive queue full, as MCC out of buffers
+      printf("sendto %s failed: %d\n", oAddr.sun_path, errno);
+    }
+    return MCC_SEND_FAILURE;
+  }
+  return MCC_OK;
+}
+
+//******************************************************************************
+
+void * CMccTransportSocket::getTxBuffer (void)
+{
+  return malloc(MCC_ATTR_BUFFER_SIZE_IN_BYTES);                                 // same limit as the MCC shared buffers
+}
+
+//******************************************************************************
+
+int CMccTransportSocket::sendTxBuffer (void * pvBuf, MCC_MEM_SIZE size, MCC_PORT iRemotePort)
+{
+  struct sockaddr_un  oAddrRemote;
+  int                 ret;
+
+  CMccTransportSocket::endpointAddr(&oAddrRemote, MCC_ENDPOINT_M4_NODE, iRemotePort);
+  ret = this->send(oAddrRemote, pvBuf, size);                                   // the datagram is sent right from the buffer
+  free(pvBuf);
+  return ret;
+}
+
+//******************************************************************************
+
+void CMccTransportSocket::freeTxBuffer (void * pvBuf)
+{
+  free(pvBuf);
+}
+
+//******************************************************************************
+
+int CMccTransportSocket::sendLocalMsg (const void * pvMsg, MCC_MEM_SIZE size)
+{
+  return this->send(m_oAddrLocal, pvMsg, size);
+}
+
+//******************************************************************************
+
+int CMccTransportSocket::recvMsg (void ** ppvMsg, MCC_MEM_SIZE * pSize, uint32_t u32TimeoutMs)
+{
+  struct pollfd   oPoll;
+  void          * pvBuf;
+  ssize_t         len;
+  int             iTimeout;
+  int             ret;
+
+  oPoll.fd      = m_iSocket;
+  oPoll.events  = POLLIN;
+  iTimeout      = (CMCC_TRANSPORT_WAIT_INF == u32TimeoutMs) ? -1 : (int)u32TimeoutMs;
+  do {
+    ret = poll(&oPoll, 1, iTimeout);                                            // blocking call
+  } while ((ret < 0) && (EINTR == errno));                                      // restarts the timeout, good enough here
+  if (0 == ret) return MCC_TIMEOUT;
+  if (ret < 0) {
+    printf("poll failed: %d\n", errno);
+    return MCC_RECV_FAILURE;
+  }
+
+  pvBuf = malloc(MCC_ATTR_BUFFER_SIZE_IN_BYTES);                                // same limit as the MCC shared buffers
+  if (!pvBuf) return MCC_RECV_FAILURE;
+
+  do {
+    len = recv(m_iSocket, pvBuf, MCC_ATTR_BUFFER_SIZE_IN_BYTES, MSG_DONTWAIT);  // ready, non-blocking call
+  } while ((len < 0) && (EINTR == errno));
+  if (len < 0) {
+    free(pvBuf);
+    if ((EAGAIN == errno) || (EWOULDBLOCK == errno)) return MCC_TIMEOUT;
+    printf("recv failed: %d\n", errno);
+    return MCC_RECV_FAILURE;
+  }
+
+  *ppvMsg = pvBuf;
+  *pSize  = (MCC_MEM_SIZE)len;
+  return MCC_OK;
+}
+
+//******************************************************************************
+
+int CMccTransportSocket::freeMsg (void * pvMsg)
+{
+  free(pvMsg);
+  return MCC_OK;
+}
+
+//******************************************************************************
+
+int CMccTransportSocket::reopen (void)
+{
+  int iSocket;
+
+  // the new socket takes over the descriptor, the other threads may be
+  // sending through it meanwhile
+  iSocket = socket(AF_UNIX, SOCK_DGRAM, 0);
+  if (iSocket < 0) {
+    printf("socket failed: %d\n", errno);
+    return MCC_ENDPOINT_FAILURE;
+  }
+  unlink(m_oAddrLocal.sun_path);
+  if ((bind(iSocket, (struct sockaddr*)&m_oAddrLocal, sizeof(m_oAddrLocal)) < 0)
+      || (dup2(iSocket, m_iSocket) < 0)) {
+    printf("rebind %s failed: %d\n", m_oAddrLocal.sun_path, errno);
+    close(iSocket);
+    return MCC_ENDPOINT_FAILURE;
+  }
+  close(iSocket);
+  return MCC_OK;
+}
+
+//******************************************************************************
+
+volatile void * CMccTransportSocket::getSnapshot (void)
+{
+  return m_pvSnapshot;
+}
+
+//******************************************************************************
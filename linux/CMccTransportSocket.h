@@ -0,0 +1,47 @@
+/*
+ * CMccTransportSocket.h
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#ifndef CMCCTRANSPORTSOCKET_H_
+#define CMCCTRANSPORTSOCKET_H_
+//******************************************************************************
+
+#include "CMccTransport.h"
+
+#include <sys/socket.h>
+#include <sys/un.h>
+
+//******************************************************************************
+
+/** Transport over UNIX datagram sockets, one datagram per message. Talks to
+ *  the host M4 simulator (see sim/), which binds the M4 endpoint the same way
+ *  (MCC_SIM_SOCKET_PATH) and keeps the shared snapshot in a POSIX shared
+ *  memory object (MCC_SIM_SNAPSHOT_NAME). */
+class CMccTransportSocket : public CMccTransport {
+public:
+  CMccTransportSocket (MCC_NODE iNode, MCC_PORT iPort);
+  ~CMccTransportSocket ();
+
+  void * getTxBuffer (void);
+  int sendTxBuffer (void * pvBuf, MCC_MEM_SIZE size, MCC_PORT iRemotePort);
+  void freeTxBuffer (void * pvBuf);
+  int sendLocalMsg (const void * pvMsg, MCC_MEM_SIZE size);
+  int recvMsg (void ** ppvMsg, MCC_MEM_SIZE * pSize, uint32_t u32TimeoutMs);
+  int freeMsg (void * pvMsg);
+  int reopen (void);
+  volatile void * getSnapshot (void);
+
+protected:
+  int                 m_iSocket;
+  struct sockaddr_un  m_oAddrLocal;
+  void              * m_pvSnapshot;                                             //!< MCC_SIM_SNAPSHOT_NAME mapping, NULL if not mapped.
+
+  int send (const struct sockaddr_un & oAddr, const void * pvMsg, MCC_MEM_SIZE size);
+
+  static void endpointAddr (struct sockaddr_un * poAddr, MCC_NODE iNode, MCC_PORT iPort);
+};
+
+//******************************************************************************
+#endif /* CMCCTRANSPORTSOCKET_H_ */
@@ -0,0 +1,538 @@
+/*
+ * CMcfsFile.cpp
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#include "CMcfsFile.h"
+#include "CMccClock.h"
+#include "../common/easyduo_mcfs_common.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+//******************************************************************************
+// Local definitions
+//******************************************************************************
+
+enum {
+  CMCFS_WINDOW_EMPTY              = 0,                                          //!< Nothing loaded.
+  CMCFS_WINDOW_QUEUED,                                                          //!< To be loaded by the I/O thread.
+  CMCFS_WINDOW_LOADING,                                                         //!< Being loaded by the I/O thread, not to be touched.
+  CMCFS_WINDOW_READY,                                                           //!< Loaded (or failed, see TReadWindow::iStatus).
+};
+
+//******************************************************************************
+
+/** Reads until u32Length bytes or the end of the file. */
+static int file_read (int iFd, uint32_t u32Offset, void * pvData, uint32_t u32Length, uint32_t * pu32Read)
+{
+  ssize_t len;
+
+  *pu32Read = 0;
+  while (*pu32Read < u32Length) {
+    len = pread(iFd, (uint8_t*)pvData + *pu32Read, u32Length - *pu32Read, (off_t)u32Offset + *pu32Read);
+    if (len < 0) {
+      if (EINTR == errno) continue;
+      return CMcfsFile::errnoStatus(errno);
+    }
+    if (0 == len) break;                                                        // end of the file
+    *pu32Read += len;
+  }
+  return MCFS_OK;
+}
+
+//******************************************************************************
+
+/** Writes all the u32Length bytes. */
+static int file_write (int iFd, uint32_t u32Offset, const void * pvData, uint32_t u32Length)
+{
+  uint32_t  u32Done = 0;
+  ssize_t   len;
+
+  while (u32Done < u32Length) {
+    len = pwrite(iFd, (const uint8_t*)pvData + u32Done, u32Length - u32Done, (off_t)u32Offset + u32Done);
+    if (len < 0) {
+      if (EINTR == errno) continue;
+      return CMcfsFile::errnoStatus(errno);
+    }
+    u32Done += len;
+  }
+  return MCFS_OK;
+}
+
+//******************************************************************************
+//******************************************************************************
+//******************************************************************************
+
+CMcfsFile::CMcfsFile (const char * sPath, uint32_t u32Mode)
+  : m_u32Mode(u32Mode)
+{
+  int iFlags;
+  int i;
+  int ret;
+
+  switch (u32Mode & (MCFS_OPEN_READ | MCFS_OPEN_WRITE)) {
+  case MCFS_OPEN_READ:                    iFlags = O_RDONLY;  break;
+  case MCFS_OPEN_WRITE:                   iFlags = O_WRONLY;  break;
+  case MCFS_OPEN_READ | MCFS_OPEN_WRITE:  iFlags = O_RDWR;    break;
+  default:                                throw (int)MCFS_ERR_INVALID;
+  }
+  if (u32Mode & MCFS_OPEN_CREATE) iFlags |= O_CREAT;
+  if (u32Mode & MCFS_OPEN_TRUNCATE) iFlags |= O_TRUNC;
+
+  m_iFd = open(sPath, iFlags | O_CLOEXEC, 0644);
+  if (m_iFd < 0) throw CMcfsFile::errnoStatus(errno);
+
+  m_bQuit       = false;
+  m_iWrite      = 0;
+  m_u32WriteSeq = 0;
+  m_iError      = MCFS_OK;
+  m_u32ReadNext = 0;                                                            // reading from the start is sequential
+  memset(m_aoWrite, 0, sizeof(m_aoWrite));
+  memset(m_aoRead, 0, sizeof(m_aoRead));
+
+  // the buffers of the directions the file is open for only
+  ret = MCFS_OK;
+  for (i = 0; (i < CMCFS_WRITE_BUFFERS) && (u32Mode & MCFS_OPEN_WRITE); ++i) {
+    m_aoWrite[i].pu8Data = (uint8_t*)malloc(CMCFS_WRITE_BUFFER_SIZE);
+    if (!m_aoWrite[i].pu8Data) ret = MCFS_ERR_IO;
+  }
+  for (i = 0; (i < CMCFS_READ_WINDOWS) && (u32Mode & MCFS_OPEN_READ); ++i) {
+    m_aoRead[i].pu8Data = (uint8_t*)malloc(CMCFS_READ_WINDOW_SIZE);
+    if (!m_aoRead[i].pu8Data) ret = MCFS_ERR_IO;
+  }
+  if (MCFS_OK != ret) {
+    printf("mcfs out of memory\n");
+    this->release();
+    throw ret;
+  }
+  if (u32Mode & MCFS_OPEN_READ) {
+    posix_fadvise(m_iFd, 0, 0, POSIX_FADV_SEQUENTIAL);                          // the kernel reads ahead too
+  }
+
+  pthread_mutex_init(&m_mtx, NULL);
+  pthread_cond_init(&m_condIo, NULL);
+  pthread_cond_init(&m_condDone, NULL);
+  ret = pthread_create(&m_thrIo, NULL, CMcfsFile::ioThread, this);
+  if (0 != ret) {
+    printf("pthread_create failed: %d\n", ret);
+    pthread_cond_destroy(&m_condDone);
+    pthread_cond_destroy(&m_condIo);
+    pthread_mutex_destroy(&m_mtx);
+    this->release();
+    throw (int)MCFS_ERR_IO;
+  }
+}
+
+//******************************************************************************
+
+CMcfsFile::~CMcfsFile ()
+{
+  // the I/O thread finishes the buffers and windows queued first
+  pthread_mutex_lock(&m_mtx);
+  m_bQuit = true;
+  pthread_cond_signal(&m_condIo);
+  pthread_mutex_unlock(&m_mtx);
+  pthread_join(m_thrIo, NULL);
+
+  pthread_cond_destroy(&m_condDone);
+  pthread_cond_destroy(&m_condIo);
+  pthread_mutex_destroy(&m_mtx);
+  this->release();
+}
+
+//******************************************************************************
+
+void CMcfsFile::release (void)
+{
+  int i;
+
+  for (i = 0; i < CMCFS_WRITE_BUFFERS; ++i) free(m_aoWrite[i].pu8Data);
+  for (i = 0; i < CMCFS_READ_WINDOWS; ++i) free(m_aoRead[i].pu8Data);
+  if (m_iFd >= 0) ::close(m_iFd);
+  m_iFd = -1;
+}
+
+//******************************************************************************
+
+int CMcfsFile::errnoStatus (int iErrno)
+{
+  switch (iErrno) {
+  case ENOENT:
+  case ENOTDIR:       return MCFS_ERR_NOT_FOUND;
+  case EACCES:
+  case EPERM:
+  case EROFS:
+  case EISDIR:        return MCFS_ERR_ACCESS;
+  case EBADF:         return MCFS_ERR_HANDLE;
+  case EMFILE:
+  case ENFILE:        return MCFS_ERR_TOO_MANY;
+  case EINVAL:
+  case ENAMETOOLONG:  return MCFS_ERR_INVALID;
+  case ENOSPC:
+  case EDQUOT:
+  case EFBIG:         return MCFS_ERR_NO_SPACE;
+  default:            return MCFS_ERR_IO;
+  }
+}
+
+//******************************************************************************
+
+uint32_t CMcfsFile::getSize (void)
+{
+  struct stat oStat;
+
+  if (fstat(m_iFd, &oStat) < 0) return 0;
+  return (oStat.st_size > 0xFFFFFFFF) ? 0xFFFFFFFF : (uint32_t)oStat.st_size;   // the protocol offsets are 32-bit
+}
+
+//******************************************************************************
+// Write-behind
+//******************************************************************************
+
+int CMcfsFile::write (uint32_t u32Offset, const void * pvData, uint32_t u32Length)
+{
+  const uint8_t * pu8Data = (const uint8_t*)pvData;
+  TWriteBuffer  * poBuf;
+  uint32_t        u32Len;
+  int             ret;
+
+  if (!(m_u32Mode & MCFS_OPEN_WRITE)) return MCFS_ERR_HANDLE;
+
+  pthread_mutex_lock(&m_mtx);
+  this->dropWindows();                                                          // stale once written
+  while (u32Length) {
+    poBuf = &m_aoWrite[m_iWrite];
+    while (poBuf->bQueued) {                                                    // all the buffers on their way to the disk
+      pthread_cond_wait(&m_condDone, &m_mtx);
+    }
+    if (poBuf->u32Length && (u32Offset != poBuf->u32Offset + poBuf->u32Length)) {
+      this->queueWrite();                                                       // not contiguous, written separately
+      continue;
+    }
+    if (!poBuf->u32Length) {
+      poBuf->u32Offset  = u32Offset;
+      poBuf->u64FirstUs = CMccClock::nowUs();
+    }
+    u32Len = CMCFS_WRITE_BUFFER_SIZE - poBuf->u32Length;
+    if (u32Len > u32Length) u32Len = u32Length;
+    memcpy(poBuf->pu8Data + poBuf->u32Length, pu8Data, u32Len);
+    poBuf->u32Length += u32Len;
+    pu8Data          += u32Len;
+    u32Offset        += u32Len;
+    u32Length        -= u32Len;
+    if (CMCFS_WRITE_BUFFER_SIZE == poBuf->u32Length) this->queueWrite();
+  }
+  ret = this->takeError();
+  pthread_mutex_unlock(&m_mtx);
+  return ret;
+}
+
+//******************************************************************************
+
+void CMcfsFile::flushIdle (void)
+{
+  TWriteBuffer * poBuf;
+
+  if (!(m_u32Mode & MCFS_OPEN_WRITE)) return;
+
+  pthread_mutex_lock(&m_mtx);
+  poBuf = &m_aoWrite[m_iWrite];
+  if (!poBuf->bQueued && poBuf->u32Length
+      && (CMccClock::nowUs() - poBuf->u64FirstUs >= CMCFS_WRITE_DELAY * 1000ull)) {
+    this->queueWrite();
+  }
+  pthread_mutex_unlock(&m_mtx);
+}
+
+//******************************************************************************
+
+int CMcfsFile::flush (void)
+{
+  int ret;
+
+  pthread_mutex_lock(&m_mtx);
+  this->waitWrites();
+  ret = this->takeError();
+  pthread_mutex_unlock(&m_mtx);
+  return ret;
+}
+
+//******************************************************************************
+
+int CMcfsFile::sync (void)
+{
+  int ret;
+
+  ret = this->flush();
+  if ((fsync(m_iFd) < 0) && (MCFS_OK == ret)) ret = CMcfsFile::errnoStatus(errno);
+  return ret;
+}
+
+//******************************************************************************
+
+int CMcfsFile::close (void)
+{
+  int ret;
+
+  pthread_mutex_lock(&m_mtx);
+  this->waitWrites();
+  this->dropWindows();
+  ret = this->takeError();
+  pthread_mutex_unlock(&m_mtx);
+
+  if ((::close(m_iFd) < 0) && (MCFS_OK == ret)) ret = CMcfsFile::errnoStatus(errno);
+  m_iFd = -1;
+  return ret;
+}
+
+//******************************************************************************
+
+void CMcfsFile::queueWrite (void)
+{
+  TWriteBuffer * poBuf = &m_aoWrite[m_iWrite];
+
+  if (poBuf->bQueued || !poBuf->u32Length) return;
+  poBuf->bQueued  = true;
+  poBuf->u32Seq   = ++m_u32WriteSeq;
+  m_iWrite        = (m_iWrite + 1) % CMCFS_WRITE_BUFFERS;
+  pthread_cond_signal(&m_condIo);
+}
+
+//******************************************************************************
+
+void CMcfsFile::waitWrites (void)
+{
+  int i;
+
+  if (!(m_u32Mode & MCFS_OPEN_WRITE)) return;
+
+  this->queueWrite();
+  for (i = 0; i < CMCFS_WRITE_BUFFERS; ++i) {
+    while (m_aoWrite[i].bQueued) pthread_cond_wait(&m_condDone, &m_mtx);
+  }
+}
+
+//******************************************************************************
+
+int CMcfsFile::takeError (void)
+{
+  int ret = m_iError;
+
+  m_iError = MCFS_OK;
+  return ret;
+}
+
+//******************************************************************************
+// Read-ahead
+//******************************************************************************
+
+int CMcfsFile::read (uint32_t u32Offset, void * pvData, uint32_t u32Length, uint32_t * pu32Read)
+{
+  uint8_t     * pu8Data = (uint8_t*)pvData;
+  TReadWindow * poWin;
+  uint32_t      u32Len;
+  int           ret = MCFS_OK;
+
+  *pu32Read = 0;
+  if (!(m_u32Mode & MCFS_OPEN_READ)) return MCFS_ERR_HANDLE;
+
+  pthread_mutex_lock(&m_mtx);
+  this->waitWrites();                                                           // reads see the data written, the failures are reported by the writes
+
+  if (u32Offset != m_u32ReadNext) {
+    // random access: read directly, the read-ahead starts again if the next
+    // read continues this one
+    this->dropWindows();
+    pthread_mutex_unlock(&m_mtx);
+    ret = file_read(m_iFd, u32Offset, pvData, u32Length, pu32Read);
+    pthread_mutex_lock(&m_mtx);
+    m_u32ReadNext = u32Offset + *pu32Read;
+    pthread_mutex_unlock(&m_mtx);
+    return ret;
+  }
+
+  while (*pu32Read < u32Length) {
+    poWin = this->findWindow(u32Offset);
+    if (!poWin) {
+      if (!this->loadWindow(u32Offset, NULL)) {                                 // both windows being loaded
+        pthread_cond_wait(&m_condDone, &m_mtx);
+      }
+      continue;
+    }
+    while (CMCFS_WINDOW_READY != poWin->iState) {
+      pthread_cond_wait(&m_condDone, &m_mtx);
+    }
+    if (MCFS_OK != poWin->iStatus) {
+      ret = poWin->iStatus;
+      poWin->iState = CMCFS_WINDOW_EMPTY;                                       // tried again by the next read
+      break;
+    }
+    if (u32Offset >= poWin->u32Offset + poWin->u32Length) break;                // end of the file
+
+    u32Len = poWin->u32Offset + poWin->u32Length - u32Offset;
+    if (u32Len > u32Length - *pu32Read) u32Len = u32Length - *pu32Read;
+    memcpy(pu8Data + *pu32Read, poWin->pu8Data + (u32Offset - poWin->u32Offset), u32Len);
+    *pu32Read += u32Len;
+    u32Offset += u32Len;
+  }
+  m_u32ReadNext = u32Offset;
+  if (MCFS_OK == ret) this->readAhead(u32Offset);
+  pthread_mutex_unlock(&m_mtx);
+  return ret;
+}
+
+//******************************************************************************
+
+CMcfsFile::TReadWindow * CMcfsFile::findWindow (uint32_t u32Offset)
+{
+  TReadWindow * poWin;
+  uint32_t      u32End;
+  int           i;
+
+  for (i = 0; i < CMCFS_READ_WINDOWS; ++i) {
+    poWin = &m_aoRead[i];
+    if ((CMCFS_WINDOW_EMPTY == poWin->iState) || (u32Offset < poWin->u32Offset)) continue;
+    if (CMCFS_WINDOW_READY != poWin->iState) {
+      u32End = poWin->u32Offset + CMCFS_READ_WINDOW_SIZE;                       // as far as it is going to be loaded
+    } else if (poWin->u32Length < CMCFS_READ_WINDOW_SIZE) {
+      u32End = poWin->u32Offset + poWin->u32Length + 1;                         // including the end of the file
+    } else {
+      u32End = poWin->u32Offset + poWin->u32Length;
+    }
+    if (u32Offset < u32End) return poWin;
+  }
+  return NULL;
+}
+
+//******************************************************************************
+
+bool CMcfsFile::loadWindow (uint32_t u32Offset, const TReadWindow * poKeep)
+{
+  TReadWindow * poWin = NULL;
+  int           i;
+
+  // reuse the window read the longest ago
+  for (i = 0; i < CMCFS_READ_WINDOWS; ++i) {
+    if ((&m_aoRead[i] == poKeep) || (CMCFS_WINDOW_QUEUED == m_aoRead[i].iState)
+        || (CMCFS_WINDOW_LOADING == m_aoRead[i].iState)) continue;
+    if (!poWin || (m_aoRead[i].u32Offset < poWin->u32Offset)) poWin = &m_aoRead[i];
+  }
+  if (!poWin) return false;
+
+  poWin->u32Offset  = u32Offset;
+  poWin->u32Length  = 0;
+  poWin->iStatus    = MCFS_OK;
+  poWin->iState     = CMCFS_WINDOW_QUEUED;
+  pthread_cond_signal(&m_condIo);
+  return true;
+}
+
+//******************************************************************************
+
+void CMcfsFile::readAhead (uint32_t u32Offset)
+{
+  TReadWindow * poWin;
+  uint32_t      u32Next;
+
+  // the window following the one the next read starts in
+  poWin = this->findWindow(u32Offset);
+  if (!poWin) {
+    this->loadWindow(u32Offset, NULL);
+    return;
+  }
+  if ((CMCFS_WINDOW_READY == poWin->iState) && (poWin->u32Length < CMCFS_READ_WINDOW_SIZE)) {
+    return;                                                                     // nothing behind the end of the file
+  }
+  u32Next = poWin->u32Offset + CMCFS_READ_WINDOW_SIZE;
+  if (!this->findWindow(u32Next)) this->loadWindow(u32Next, poWin);
+}
+
+//******************************************************************************
+
+void CMcfsFile::dropWindows (void)
+{
+  int i;
+
+  for (i = 0; i < CMCFS_READ_WINDOWS; ++i) {
+    while (CMCFS_WINDOW_LOADING == m_aoRead[i].iState) {
+      pthread_cond_wait(&m_condDone, &m_mtx);
+    }
+    m_aoRead[i].iState = CMCFS_WINDOW_EMPTY;
+  }
+}
+
+//******************************************************************************
+// I/O thread
+//******************************************************************************
+
+void * CMcfsFile::ioThread (void * pvThis)
+{
+  ((CMcfsFile*)pvThis)->ioLoop();
+  return NULL;
+}
+
+//******************************************************************************
+
+void CMcfsFile::ioLoop (void)
+{
+  TWriteBuffer  * poBuf;
+  TReadWindow   * poWin;
+  uint32_t        u32Len;
+  int             i;
+  int             ret;
+
+  pthread_mutex_lock(&m_mtx);
+  while (1) {
+    // the buffers in the order queued, then the windows
+    poBuf = NULL;
+    for (i = 0; i < CMCFS_WRITE_BUFFERS; ++i) {
+      if (m_aoWrite[i].bQueued
+          && (!poBuf || ((int32_t)(m_aoWrite[i].u32Seq - poBuf->u32Seq) < 0))) {
+        poBuf = &m_aoWrite[i];
+      }
+    }
+    poWin = NULL;
+    for (i = 0; !poBuf && (i < CMCFS_READ_WINDOWS); ++i) {
+      if (CMCFS_WINDOW_QUEUED == m_aoRead[i].iState) {
+        poWin = &m_aoRead[i];
+        break;
+      }
+    }
+    if (!poBuf && !poWin) {
+      if (m_bQuit) break;
+      pthread_cond_wait(&m_condIo, &m_mtx);
+      continue;
+    }
+
+    if (poBuf) {
+      pthread_mutex_unlock(&m_mtx);
+      ret = file_write(m_iFd, poBuf->u32Offset, poBuf->pu8Data, poBuf->u32Length);
+      pthread_mutex_lock(&m_mtx);
+      if (MCFS_OK != ret) {
+        printf("mcfs write of %u bytes at %u failed: %d\n", poBuf->u32Length, poBuf->u32Offset, ret);
+        if (MCFS_OK == m_iError) m_iError = ret;
+      }
+      poBuf->u32Length  = 0;
+      poBuf->bQueued    = false;
+    } else {
+      poWin->iState = CMCFS_WINDOW_LOADING;
+      pthread_mutex_unlock(&m_mtx);
+      ret = file_read(m_iFd, poWin->u32Offset, poWin->pu8Data, CMCFS_READ_WINDOW_SIZE, &u32Len);
+      pthread_mutex_lock(&m_mtx);
+      poWin->u32Length  = u32Len;
+      poWin->iStatus    = ret;
+      poWin->iState     = CMCFS_WINDOW_READY;
+    }
+    pthread_cond_broadcast(&m_condDone);
+  }
+  pthread_mutex_unlock(&m_mtx);
+}
+
+//******************************************************************************
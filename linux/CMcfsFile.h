@@ -0,0 +1,114 @@
+/*
+ * CMcfsFile.h
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#ifndef CMCFSFILE_H_
+#define CMCFSFILE_H_
+//******************************************************************************
+
+#include <pthread.h>
+#include <stdint.h>
+
+//******************************************************************************
+
+#define CMCFS_WRITE_BUFFER_SIZE         (128 * 1024)                            //!< Size of one write-behind buffer.
+#define CMCFS_WRITE_BUFFERS             (2)                                     //!< Write-behind buffers per file, one filled while the other is written.
+#define CMCFS_WRITE_DELAY               (200)                                   //!< Longest time in milliseconds data stays in a write-behind buffer.
+#define CMCFS_READ_WINDOW_SIZE          (128 * 1024)                            //!< Size of one read-ahead window.
+#define CMCFS_READ_WINDOWS              (2)                                     //!< Read-ahead windows per file, one read while the other is loaded.
+
+//******************************************************************************
+
+/** File open by the M4 (MCFS_OP_OPEN). Buffers the data written (write-behind)
+ *  and, while the file is read sequentially, loads the data following the
+ *  last read (read-ahead), both by a thread of its own, so that the caller
+ *  rarely waits for the disk. Called by one thread at a time (the server
+ *  receiver). The methods return MCFS_OK or MCFS_ERR_*. */
+class CMcfsFile {
+public:
+  /** Opens the file, throws MCFS_ERR_* on failure.
+   * @param[in] u32Mode  MCFS_OPEN_* flags. */
+  CMcfsFile (const char * sPath, uint32_t u32Mode);
+
+  /** Closes the file, the data still buffered is dropped unless close() was
+   *  called. */
+  ~CMcfsFile ();
+
+  uint32_t getMode (void) const { return m_u32Mode; }
+  uint32_t getSize (void);                                                      //!< Size on the disk, without the buffered data.
+
+  /** Takes the data to a write-behind buffer, waits only if both of them
+   *  are being written. Reports the failure of an earlier buffer write. */
+  int write (uint32_t u32Offset, const void * pvData, uint32_t u32Length);
+
+  /** Reads up to u32Length bytes (less at the end of the file).
+   * @param[out] pu32Read  Number of bytes stored to pvData. */
+  int read (uint32_t u32Offset, void * pvData, uint32_t u32Length, uint32_t * pu32Read);
+
+  /** Schedules writing the buffered data older than CMCFS_WRITE_DELAY. */
+  void flushIdle (void);
+
+  /** Writes the buffered data and waits for it. */
+  int flush (void);
+
+  /** Writes the buffered data and flushes the file to the disk. */
+  int sync (void);
+
+  /** Writes the buffered data and closes the file. */
+  int close (void);
+
+  /** Converts an errno value to MCFS_ERR_*. */
+  static int errnoStatus (int iErrno);
+
+protected:
+  /** Write-behind buffer. */
+  typedef struct {
+    uint8_t       * pu8Data;
+    uint32_t        u32Offset;                                                  //!< File offset of pu8Data[0].
+    uint32_t        u32Length;                                                  //!< Number of bytes buffered.
+    uint32_t        u32Seq;                                                     //!< Order of the queued buffers, written the lowest first.
+    bool            bQueued;                                                    //!< Handed over to the I/O thread, not to be touched.
+    uint64_t        u64FirstUs;                                                 //!< Time the first byte was buffered.
+  } TWriteBuffer;
+
+  /** Read-ahead window. */
+  typedef struct {
+    uint8_t       * pu8Data;
+    uint32_t        u32Offset;                                                  //!< File offset of pu8Data[0].
+    uint32_t        u32Length;                                                  //!< Number of bytes loaded, less than the size at the end of the file.
+    int             iState;                                                     //!< CMCFS_WINDOW_*.
+    int             iStatus;                                                    //!< Result of the load.
+  } TReadWindow;
+
+  int                 m_iFd;
+  uint32_t            m_u32Mode;
+  pthread_mutex_t     m_mtx;                                                    //!< Guards the buffers, windows, m_iError and m_bQuit.
+  pthread_cond_t      m_condIo;                                                 //!< Signalled when there is work for the I/O thread or on quit.
+  pthread_cond_t      m_condDone;                                               //!< Signalled when the I/O thread finished a buffer or window.
+  pthread_t           m_thrIo;
+  bool                m_bQuit;
+  TWriteBuffer        m_aoWrite[CMCFS_WRITE_BUFFERS];
+  int                 m_iWrite;                                                 //!< Index of the buffer being filled.
+  uint32_t            m_u32WriteSeq;                                            //!< Sequence number of the last buffer queued.
+  int                 m_iError;                                                 //!< Failure of a buffer write not reported yet, MCFS_OK if none.
+  TReadWindow         m_aoRead[CMCFS_READ_WINDOWS];
+  uint32_t            m_u32ReadNext;                                            //!< Offset following the last read, the next one is sequential if it starts here.
+
+  void release (void);
+  void queueWrite (void);
+  void waitWrites (void);
+  int takeError (void);
+  void dropWindows (void);
+  TReadWindow * findWindow (uint32_t u32Offset);
+  bool loadWindow (uint32_t u32Offset, const TReadWindow * poKeep);
+  void readAhead (uint32_t u32Offset);
+  int readDirect (uint32_t u32Offset, void * pvData, uint32_t u32Length, uint32_t * pu32Read);
+
+  void ioLoop (void);
+  static void * ioThread (void * pvThis);
+};
+
+//******************************************************************************
+#endif /* CMCFSFILE_H_ */
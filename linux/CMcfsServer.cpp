@@ -0,0 +1,394 @@
+/*
+ * CMcfsServer.cpp
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#include "CMcfsServer.h"
+#include "CMccClock.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+//******************************************************************************
+// Local definitions
+//******************************************************************************
+
+#define CMCFS_OP_QUIT                   (0)                                     //!< Local message stopping the receiver thread (not a MCFS_OP_*).
+
+//******************************************************************************
+
+/** Checks a path received from the M4 does not leave the served directory. */
+static bool mcfs_isPathSafe (const char * sPath)
+{
+  const char * sPart = sPath;
+
+  if (!*sPath) return false;
+  while (sPart) {
+    while ('/' == *sPart) ++sPart;
+    if (('.' == sPart[0]) && ('.' == sPart[1]) && (('/' == sPart[2]) || !sPart[2])) return false;
+    sPart = strchr(sPart, '/');
+  }
+  return true;
+}
+
+//******************************************************************************
+//******************************************************************************
+//******************************************************************************
+
+CMcfsServer::CMcfsServer (const char * sRoot)
+  : m_poTransport(CMccTransport::create(ESL_MCFS_ENDPOINT_A5_NODE, ESL_MCFS_ENDPOINT_A5_PORT))
+{
+  this->start(sRoot);
+}
+
+//******************************************************************************
+
+CMcfsServer::CMcfsServer (const char * sRoot, CMccTransport * poTransport)
+  : m_poTransport(poTransport)
+{
+  this->start(sRoot);
+}
+
+//******************************************************************************
+
+void CMcfsServer::start (const char * sRoot)
+{
+  int ret;
+
+  snprintf(m_sRoot, sizeof(m_sRoot), "%s", sRoot);
+  memset(m_apoFiles, 0, sizeof(m_apoFiles));
+  memset(&m_oStats, 0, sizeof(m_oStats));
+  m_bVerbose  = false;
+  m_u64IdleUs = CMccClock::nowUs();
+
+  m_pu8Read = (uint8_t*)malloc(MCFS_MAX_READ);
+  if (!m_pu8Read) {
+    printf("mcfs out of memory\n");
+    delete m_poTransport;
+    throw MCC_INIT_FAILURE;
+  }
+
+  ret = pthread_create(&m_thrReceiver, NULL, CMcfsServer::receiverThread, this);
+  if (0 != ret) {
+    printf("pthread_create failed: %d\n", ret);
+    free(m_pu8Read);
+    delete m_poTransport;
+    throw MCC_THREAD_FAILURE;
+  }
+}
+
+//******************************************************************************
+
+CMcfsServer::~CMcfsServer ()
+{
+  TMcfsHdr oQuit;
+
+  // the receiver thread closes the files before it quits
+  memset(&oQuit, 0, sizeof(oQuit));
+  oQuit.u16Magic  = MCFS_MAGIC;
+  oQuit.u8Op      = CMCFS_OP_QUIT;
+  while (MCC_OK != m_poTransport->sendLocalMsg(&oQuit, sizeof(oQuit))) {
+    usleep(CMCFS_RECV_RETRY * 1000);
+  }
+  pthread_join(m_thrReceiver, NULL);
+  delete m_poTransport;
+  free(m_pu8Read);
+}
+
+//******************************************************************************
+
+void CMcfsServer::setVerbose (bool bVerbose)
+{
+  __atomic_store_n(&m_bVerbose, bVerbose, __ATOMIC_RELAXED);
+}
+
+//******************************************************************************
+
+void CMcfsServer::getStats (TMcfsStats * poStats)
+{
+  poStats->u32Requests  = __atomic_load_n(&m_oStats.u32Requests, __ATOMIC_RELAXED);
+  poStats->u32Invalid   = __atomic_load_n(&m_oStats.u32Invalid, __ATOMIC_RELAXED);
+  poStats->u32Failed    = __atomic_load_n(&m_oStats.u32Failed, __ATOMIC_RELAXED);
+  poStats->u32TxDropped = __atomic_load_n(&m_oStats.u32TxDropped, __ATOMIC_RELAXED);
+  poStats->u64Read      = __atomic_load_n(&m_oStats.u64Read, __ATOMIC_RELAXED);
+  poStats->u64Written   = __atomic_load_n(&m_oStats.u64Written, __ATOMIC_RELAXED);
+}
+
+//******************************************************************************
+
+void * CMcfsServer::receiverThread (void * pvThis)
+{
+  ((CMcfsServer*)pvThis)->receiverLoop();
+  return NULL;
+}
+
+//******************************************************************************
+
+void CMcfsServer::receiverLoop (void)
+{
+  void          * pvMsg;
+  TMcfsMsg      * poMsg;
+  MCC_MEM_SIZE    size;
+  int             ret;
+
+  while (1) {
+    ret = m_poTransport->recvMsg(&pvMsg, &size, CMCFS_IDLE_PERIOD);             // blocking call
+    if (MCC_TIMEOUT == ret) {
+      this->flushIdle();
+      continue;
+    } else if (MCC_OK != ret) {
+      usleep(CMCFS_RECV_RETRY * 1000);
+      continue;
+    }
+
+    poMsg = (TMcfsMsg*)pvMsg;
+    if ((size < sizeof(TMcfsHdr)) || (MCFS_MAGIC != poMsg->oHdr.u16Magic)
+        || (size != sizeof(TMcfsHdr) + poMsg->oHdr.u16Length)
+        || (poMsg->oHdr.u8Flags & MCFS_FLAG_REPLY)) {
+      __atomic_add_fetch(&m_oStats.u32Invalid, 1, __ATOMIC_RELAXED);
+      printf("mcfs invalid message: size %d\n", size);
+      m_poTransport->freeMsg(pvMsg);
+      continue;
+    }
+    if (CMCFS_OP_QUIT == poMsg->oHdr.u8Op) {
+      m_poTransport->freeMsg(pvMsg);
+      break;
+    }
+
+    __atomic_add_fetch(&m_oStats.u32Requests, 1, __ATOMIC_RELAXED);
+    switch (poMsg->oHdr.u8Op) {
+    case MCFS_OP_HELLO:   this->onHello(poMsg);   break;
+    case MCFS_OP_OPEN:    this->onOpen(poMsg);    break;
+    case MCFS_OP_CLOSE:   this->onClose(poMsg);   break;
+    case MCFS_OP_READ:    this->onRead(poMsg);    break;
+    case MCFS_OP_WRITE:   this->onWrite(poMsg);   break;
+    case MCFS_OP_SYNC:    this->onSync(poMsg);    break;
+    default:
+      printf("mcfs unknown request %d\n", poMsg->oHdr.u8Op);
+      this->reply(&poMsg->oHdr, MCFS_FLAG_LAST, MCFS_ERR_INVALID, 0, 0, 0, NULL, 0);
+      break;
+    }
+    m_poTransport->freeMsg(pvMsg);
+
+    // a busy link must not hold the written data back either
+    if (CMccClock::nowUs() - m_u64IdleUs >= CMCFS_IDLE_PERIOD * 1000ull) this->flushIdle();
+  }
+
+  this->closeAll();
+}
+
+//******************************************************************************
+
+void CMcfsServer::flushIdle (void)
+{
+  int i;
+
+  m_u64IdleUs = CMccClock::nowUs();
+  for (i = 0; i < MCFS_MAX_FILES; ++i) {
+    if (m_apoFiles[i]) m_apoFiles[i]->flushIdle();
+  }
+}
+
+//******************************************************************************
+
+void CMcfsServer::closeAll (void)
+{
+  int i;
+  int ret;
+
+  for (i = 0; i < MCFS_MAX_FILES; ++i) {
+    if (!m_apoFiles[i]) continue;
+    ret = m_apoFiles[i]->close();
+    if (MCFS_OK != ret) printf("mcfs close of handle %d failed: %d\n", i + 1, ret);
+    delete m_apoFiles[i];
+    m_apoFiles[i] = NULL;
+  }
+}
+
+//******************************************************************************
+
+CMcfsFile * CMcfsServer::getFile (const TMcfsHdr * poReq)
+{
+  CMcfsFile * poFile = NULL;
+
+  if ((poReq->u16Handle >= 1) && (poReq->u16Handle <= MCFS_MAX_FILES)) {
+    poFile = m_apoFiles[poReq->u16Handle - 1];
+  }
+  if (!poFile) {
+    this->reply(poReq, MCFS_FLAG_LAST, MCFS_ERR_HANDLE, poReq->u16Handle, 0, 0, NULL, 0);
+  }
+  return poFile;
+}
+
+//******************************************************************************
+
+void CMcfsServer::reply (const TMcfsHdr * poReq, uint8_t u8Flags, int32_t i32Status, uint16_t u16Handle,
+                         uint32_t u32Offset, uint32_t u32Count, const void * pvData, uint16_t u16Length)
+{
+  TMcfsMsg  * poMsg;
+  uint64_t    u64StartUs = CMccClock::nowUs();
+
+  if ((MCFS_OK != i32Status) && (u8Flags & MCFS_FLAG_LAST)) {
+    __atomic_add_fetch(&m_oStats.u32Failed, 1, __ATOMIC_RELAXED);
+    printf("mcfs request %d of handle %d failed: %d\n", poReq->u8Op, poReq->u16Handle, i32Status);
+  }
+
+  // the M4 frees the buffers as it takes the replies, a send fails while all
+  // of its receive buffers are taken
+  while (true) {
+    if ((poMsg = (TMcfsMsg*)m_poTransport->getTxBuffer())) {
+      poMsg->oHdr.u16Magic  = MCFS_MAGIC;
+      poMsg->oHdr.u8Op      = poReq->u8Op;
+      poMsg->oHdr.u8Flags   = MCFS_FLAG_REPLY | u8Flags;
+      poMsg->oHdr.u32Tag    = poReq->u32Tag;
+      poMsg->oHdr.u16Handle = u16Handle;
+      poMsg->oHdr.u16Length = u16Length;
+      poMsg->oHdr.i32Status = i32Status;
+      poMsg->oHdr.u32Offset = u32Offset;
+      poMsg->oHdr.u32Count  = u32Count;
+      if (u16Length) memcpy(poMsg->au8Data, pvData, u16Length);
+
+      if (MCC_OK == m_poTransport->sendTxBuffer(poMsg, sizeof(TMcfsHdr) + u16Length, ESL_MCFS_ENDPOINT_M4_PORT)) {
+        return;
+      }
+    }
+    if (CMccClock::nowUs() - u64StartUs >= CMCFS_SEND_TIMEOUT * 1000ull) {
+      __atomic_add_fetch(&m_oStats.u32TxDropped, 1, __ATOMIC_RELAXED);
+      printf("mcfs reply to request %d dropped, no MCC buffer\n", poReq->u8Op);
+      return;
+    }
+    usleep(CMCFS_SEND_RETRY * 1000);
+  }
+}
+
+//******************************************************************************
+// Request handlers
+//******************************************************************************
+
+void CMcfsServer::onHello (const TMcfsMsg * poReq)
+{
+  printf("mcfs client protocol version %u\n", poReq->oHdr.u32Count);
+  this->closeAll();                                                             // the M4 restarted
+  this->reply(&poReq->oHdr, MCFS_FLAG_LAST, MCFS_OK, 0, MCFS_MAX_READ, MCFS_PROTOCOL_VERSION, NULL, 0);
+}
+
+//******************************************************************************
+
+void CMcfsServer::onOpen (const TMcfsMsg * poReq)
+{
+  char        sName[ESL_MCFS_FILENAME_MAXLEN];
+  char        sPath[PATH_MAX];
+  CMcfsFile * poFile;
+  int         iFile;
+
+  if ((0 == poReq->oHdr.u16Length) || (poReq->oHdr.u16Length >= sizeof(sName))) {
+    this->reply(&poReq->oHdr, MCFS_FLAG_LAST, MCFS_ERR_INVALID, 0, 0, 0, NULL, 0);
+    return;
+  }
+  memcpy(sName, poReq->au8Data, poReq->oHdr.u16Length);
+  sName[poReq->oHdr.u16Length] = '\0';
+  if ((strlen(sName) != poReq->oHdr.u16Length) || !mcfs_isPathSafe(sName)) {
+    printf("mcfs path %s refused\n", sName);
+    this->reply(&poReq->oHdr, MCFS_FLAG_LAST, MCFS_ERR_ACCESS, 0, 0, 0, NULL, 0);
+    return;
+  }
+
+  for (iFile = 0; (iFile < MCFS_MAX_FILES) && m_apoFiles[iFile]; ++iFile);
+  if (MCFS_MAX_FILES == iFile) {
+    this->reply(&poReq->oHdr, MCFS_FLAG_LAST, MCFS_ERR_TOO_MANY, 0, 0, 0, NULL, 0);
+    return;
+  }
+
+  if (snprintf(sPath, sizeof(sPath), "%s/%s", m_sRoot, sName) >= (int)sizeof(sPath)) {
+    this->reply(&poReq->oHdr, MCFS_FLAG_LAST, MCFS_ERR_INVALID, 0, 0, 0, NULL, 0);
+    return;
+  }
+  try {
+    poFile = new CMcfsFile(sPath, poReq->oHdr.u32Count);
+  } catch (int iStatus) {
+    this->reply(&poReq->oHdr, MCFS_FLAG_LAST, iStatus, 0, 0, 0, NULL, 0);
+    return;
+  }
+  m_apoFiles[iFile] = poFile;
+  if (__atomic_load_n(&m_bVerbose, __ATOMIC_RELAXED)) {
+    printf("mcfs open %s mode 0x%x handle %d\n", sPath, poReq->oHdr.u32Count, iFile + 1);
+  }
+  this->reply(&poReq->oHdr, MCFS_FLAG_LAST, MCFS_OK, iFile + 1, 0, poFile->getSize(), NULL, 0);
+}
+
+//******************************************************************************
+
+void CMcfsServer::onClose (const TMcfsMsg * poReq)
+{
+  CMcfsFile * poFile = this->getFile(&poReq->oHdr);
+  int         ret;
+
+  if (!poFile) return;
+  ret = poFile->close();
+  delete poFile;
+  m_apoFiles[poReq->oHdr.u16Handle - 1] = NULL;
+  if (__atomic_load_n(&m_bVerbose, __ATOMIC_RELAXED)) {
+    printf("mcfs close handle %d\n", poReq->oHdr.u16Handle);
+  }
+  this->reply(&poReq->oHdr, MCFS_FLAG_LAST, ret, poReq->oHdr.u16Handle, 0, 0, NULL, 0);
+}
+
+//******************************************************************************
+
+void CMcfsServer::onRead (const TMcfsMsg * poReq)
+{
+  CMcfsFile * poFile = this->getFile(&poReq->oHdr);
+  uint32_t    u32Count;
+  uint32_t    u32Read;
+  uint32_t    u32Done;
+  uint32_t    u32Len;
+  int         ret;
+
+  if (!poFile) return;
+  u32Count = poReq->oHdr.u32Count;
+  if (u32Count > MCFS_MAX_READ) u32Count = MCFS_MAX_READ;
+  ret = poFile->read(poReq->oHdr.u32Offset, m_pu8Read, u32Count, &u32Read);
+  __atomic_add_fetch(&m_oStats.u64Read, u32Read, __ATOMIC_RELAXED);
+
+  // as many replies as the data takes, at least one
+  u32Done = 0;
+  do {
+    u32Len = u32Read - u32Done;
+    if (u32Len > MCFS_MAX_DATA) u32Len = MCFS_MAX_DATA;
+    this->reply(&poReq->oHdr, (u32Done + u32Len == u32Read) ? MCFS_FLAG_LAST : 0,
+                (u32Done + u32Len == u32Read) ? ret : MCFS_OK, poReq->oHdr.u16Handle,
+                poReq->oHdr.u32Offset + u32Done, u32Read, m_pu8Read + u32Done, u32Len);
+    u32Done += u32Len;
+  } while (u32Done < u32Read);
+}
+
+//******************************************************************************
+
+void CMcfsServer::onWrite (const TMcfsMsg * poReq)
+{
+  CMcfsFile * poFile = this->getFile(&poReq->oHdr);
+  int         ret;
+
+  if (!poFile) return;
+  ret = poFile->write(poReq->oHdr.u32Offset, poReq->au8Data, poReq->oHdr.u16Length);
+  if (MCFS_ERR_HANDLE != ret) {                                                 // taken even if an earlier write failed
+    __atomic_add_fetch(&m_oStats.u64Written, poReq->oHdr.u16Length, __ATOMIC_RELAXED);
+  }
+  this->reply(&poReq->oHdr, MCFS_FLAG_LAST, ret, poReq->oHdr.u16Handle, poReq->oHdr.u32Offset,
+              (MCFS_ERR_HANDLE != ret) ? poReq->oHdr.u16Length : 0, NULL, 0);
+}
+
+//******************************************************************************
+
+void CMcfsServer::onSync (const TMcfsMsg * poReq)
+{
+  CMcfsFile * poFile = this->getFile(&poReq->oHdr);
+
+  if (!poFile) return;
+  this->reply(&poReq->oHdr, MCFS_FLAG_LAST, poFile->sync(), poReq->oHdr.u16Handle, 0, 0, NULL, 0);
+}
+
+//******************************************************************************
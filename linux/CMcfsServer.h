@@ -0,0 +1,88 @@
+/*
+ * CMcfsServer.h
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#ifndef CMCFSSERVER_H_
+#define CMCFSSERVER_H_
+//******************************************************************************
+
+#include "CMccTransport.h"
+#include "CMcfsFile.h"
+#include "../common/easyduo_mcfs_common.h"
+
+#include <limits.h>
+#include <pthread.h>
+
+//******************************************************************************
+
+#define CMCFS_IDLE_PERIOD               (CMCFS_WRITE_DELAY / 2)                 //!< Receive timeout in milliseconds, checks the write-behind buffers.
+#define CMCFS_SEND_TIMEOUT              (1000)                                  //!< Maximum time in milliseconds to wait for the M4 to take a reply.
+#define CMCFS_SEND_RETRY                (1)                                     //!< Delay in milliseconds before retrying to send a reply.
+#define CMCFS_RECV_RETRY                (100)                                   //!< Delay in milliseconds before receiving again after a failure.
+
+/** Counters of the served requests. */
+typedef struct {
+  uint32_t          u32Requests;                                                //!< Requests served.
+  uint32_t          u32Invalid;                                                 //!< Messages dropped as malformed.
+  uint32_t          u32Failed;                                                  //!< Requests answered by an error.
+  uint32_t          u32TxDropped;                                               //!< Replies not sent within CMCFS_SEND_TIMEOUT.
+  uint64_t          u64Read;                                                    //!< Bytes read.
+  uint64_t          u64Written;                                                 //!< Bytes written.
+} TMcfsStats;
+
+//******************************************************************************
+
+/** Serves the files of a Linux directory to the M4 (see
+ *  easyduo_mcfs_common.h) by a thread of its own. The requests are answered
+ *  in the order received, the disk is accessed by the CMcfsFile threads
+ *  ahead of the reads and behind the writes. */
+class CMcfsServer {
+public:
+  /** Opens the ESL_MCFS_ENDPOINT_A5_* endpoint, throws MCC_* (see
+   *  CMccTransport.h) on failure.
+   * @param[in] sRoot   Served directory, the M4 paths are relative to it. */
+  CMcfsServer (const char * sRoot);
+  CMcfsServer (const char * sRoot, CMccTransport * poTransport);
+  ~CMcfsServer ();
+
+  // Every open and close and the failed requests are printed if verbose,
+  // the failures only otherwise
+  void setVerbose (bool bVerbose);
+  void getStats (TMcfsStats * poStats);
+
+protected:
+  CMccTransport     * m_poTransport;
+  char                m_sRoot[PATH_MAX];
+  CMcfsFile         * m_apoFiles[MCFS_MAX_FILES];                               //!< Open files indexed by the handle - 1.
+  uint8_t           * m_pu8Read;                                                //!< MCFS_MAX_READ bytes to read to.
+  pthread_t           m_thrReceiver;
+  bool                m_bVerbose;
+  uint64_t            m_u64IdleUs;                                              //!< Time of the last write-behind check.
+  TMcfsStats          m_oStats;                                                 //!< Updated by the receiver thread, every counter atomically.
+
+  void start (const char * sRoot);
+  void closeAll (void);
+  void flushIdle (void);
+  CMcfsFile * getFile (const TMcfsHdr * poReq);
+
+  void onHello (const TMcfsMsg * poReq);
+  void onOpen (const TMcfsMsg * poReq);
+  void onClose (const TMcfsMsg * poReq);
+  void onRead (const TMcfsMsg * poReq);
+  void onWrite (const TMcfsMsg * poReq);
+  void onSync (const TMcfsMsg * poReq);
+
+  /** Sends a reply to the request, retries up to CMCFS_SEND_TIMEOUT while
+   *  no MCC buffer is free or the M4 has all of its receive buffers taken,
+   *  which throttles the READ replies to the pace of the M4. */
+  void reply (const TMcfsHdr * poReq, uint8_t u8Flags, int32_t i32Status, uint16_t u16Handle,
+              uint32_t u32Offset, uint32_t u32Count, const void * pvData, uint16_t u16Length);
+
+  void receiverLoop (void);
+  static void * receiverThread (void * pvThis);
+};
+
+//******************************************************************************
+#endif /* CMCFSSERVER_H_ */
@@ -0,0 +1,71 @@
+/*
+ * CSpscRing.h
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#ifndef CSPSCRING_H_
+#define CSPSCRING_H_
+//******************************************************************************
+
+#include <stdint.h>
+
+//******************************************************************************
+
+/** Lock-free single-producer/single-consumer ring buffer. One thread may call
+ *  push(), another one pop(), both without blocking.
+ * @tparam T  Element type (copied by assignment).
+ * @tparam N  Capacity. Must be a power of 2. */
+template <typename T, uint32_t N>
+class CSpscRing {
+public:
+  CSpscRing (void) : m_u32Head(0), m_u32Tail(0), m_u32Dropped(0) {}
+
+  /** Stores one element (producer side).
+   * @return  false if the ring is full and the element has been dropped. */
+  bool push (const T & oItem)
+  {
+    uint32_t u32Head = __atomic_load_n(&m_u32Head, __ATOMIC_RELAXED);
+    uint32_t u32Tail = __atomic_load_n(&m_u32Tail, __ATOMIC_ACQUIRE);
+
+    if (u32Head - u32Tail >= N) {
+      __atomic_add_fetch(&m_u32Dropped, 1, __ATOMIC_RELAXED);
+      return false;
+    }
+    m_aoItems[u32Head & (N-1)] = oItem;
+    __atomic_store_n(&m_u32Head, u32Head + 1, __ATOMIC_RELEASE);
+    return true;
+  }
+
+  /** Retrieves up to u32Size of the oldest elements (consumer side).
+   * @return  Number of elements stored to paoItems. */
+  uint32_t pop (T * paoItems, uint32_t u32Size)
+  {
+    uint32_t u32Tail = __atomic_load_n(&m_u32Tail, __ATOMIC_RELAXED);
+    uint32_t u32Head = __atomic_load_n(&m_u32Head, __ATOMIC_ACQUIRE);
+    uint32_t u32Cnt  = u32Head - u32Tail;
+    uint32_t i;
+
+    if (u32Cnt > u32Size) u32Cnt = u32Size;
+    for (i = 0; i < u32Cnt; ++i) {
+      paoItems[i] = m_aoItems[(u32Tail + i) & (N-1)];
+    }
+    __atomic_store_n(&m_u32Tail, u32Tail + u32Cnt, __ATOMIC_RELEASE);
+    return u32Cnt;
+  }
+
+  /** Retrieves and clears the number of elements dropped because of a full ring. */
+  uint32_t takeDropped (void)
+  {
+    return __atomic_exchange_n(&m_u32Dropped, 0, __ATOMIC_RELAXED);
+  }
+
+private:
+  T         m_aoItems[N];
+  uint32_t  m_u32Head;                                                          //!< Total number of pushed elements (written by the producer only).
+  uint32_t  m_u32Tail;                                                          //!< Total number of popped elements (written by the consumer only).
+  uint32_t  m_u32Dropped;                                                       //!< Number of elements dropped since the last takeDropped().
+};
+
+//******************************************************************************
+#endif /* CSPSCRING_H_ */
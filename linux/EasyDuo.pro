@@ -4,25 +4,58 @@ QT += core \
     gui \
     network
 HEADERS += CMcc.h \
+    CMccClock.h \
+    CMccCrc.h \
+    CMccMsg.h \
+    CMccRaw.h \
+    CMccAsync.h \
+    CMccTransport.h \
+    CMccTransportMcc.h \
+    CMccTransportSocket.h \
+    CSpscRing.h \
     ../common/easyduo_mcc_common.h \
     alsa.h \
     easyplayer.h \
+    easydiag.h \
     config.h \
     network.h \
     easyduo.h
 SOURCES += CMcc.cpp \
+    CMccClock.cpp \
+    CMccCrc.cpp \
+    CMccRaw.cpp \
+    CMccAsync.cpp \
+    CMccTransport.cpp \
+    CMccTransportMcc.cpp \
+    CMccTransportSocket.cpp \
     alsa.cpp \
     easyplayer.cpp \
+    easydiag.cpp \
     config.cpp \
     network.cpp \
     main.cpp \
     easyduo.cpp
 FORMS += easyplayer.ui \
+    easydiag.ui \
     easyduo.ui
 RESOURCES += pictures.qrc
 LIBS += -lconfig++ \
     -lasound \
-    -lmcc
+    -lmcc \
+    -lpthread \
+    -lrt
+# NEON batch conversion of the raw samples (CMccRaw) on the Vybrid A5
+contains(QT_ARCH, arm) {
+    QMAKE_CXXFLAGS += -mfpu=neon
+}
+# host build against the M4 simulator (qmake CONFIG+=mccsim, see ../sim)
+mccsim {
+    DEFINES += CMCC_TRANSPORT_SOCKET_ONLY
+    INCLUDEPATH += ../sim/include
+    HEADERS -= CMccTransportMcc.h
+    SOURCES -= CMccTransportMcc.cpp
+    LIBS -= -lmcc
+}
 # make install
 target.path = /usr/bin
 INSTALLS += target
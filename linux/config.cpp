@@ -9,6 +9,7 @@
 
 #include <iostream>
 #include <limits.h>
+#include <string.h>
 #include <libconfig.h++>
 #include <QList>
 
@@ -89,3 +90,169 @@ int config_loadMedia (QComboBox & oCombo, const char * sFilename)
 
   return 0;
 }
+
+// accelerometer settings of the "accel" group
+static void config_accel (const Setting & root, TConfigMcc & oMcc)
+{
+  static const char * const asOversampling[] = {                                // MCC_ACCEL_OS_* order
+    "normal", "lnlp", "high_res", "low_power"
+  };
+
+  try {
+    const Setting & accel = root["accel"];
+    double          fRate;
+    int             iRate;
+    int             iRange;
+    string          sOversampling;
+    bool            bLowNoise;
+
+    if (accel.lookupValue("rate", fRate) && (fRate > 0.0)) {
+      oMcc.oAccel.u32RateMilliHz = (uint32_t)(fRate * 1000.0 + 0.5);
+      oMcc.u32AccelSet |= MCC_ACCEL_SET_RATE;
+    } else if (accel.lookupValue("rate", iRate) && (iRate > 0)) {
+      oMcc.oAccel.u32RateMilliHz = (uint32_t)iRate * 1000;
+      oMcc.u32AccelSet |= MCC_ACCEL_SET_RATE;
+    }
+    if (oMcc.u32AccelSet & MCC_ACCEL_SET_RATE) {                                // the M4 rejects rates out of its range
+      if (oMcc.oAccel.u32RateMilliHz < MCC_ACCEL_RATE_MIN_MHZ) oMcc.oAccel.u32RateMilliHz = MCC_ACCEL_RATE_MIN_MHZ;
+      if (oMcc.oAccel.u32RateMilliHz > MCC_ACCEL_RATE_MAX_MHZ) oMcc.oAccel.u32RateMilliHz = MCC_ACCEL_RATE_MAX_MHZ;
+    }
+    if (accel.lookupValue("range", iRange) && (iRange > 0) && (iRange <= 8)) {
+      oMcc.oAccel.u8RangeG = (uint8_t)iRange;
+      oMcc.u32AccelSet |= MCC_ACCEL_SET_RANGE;
+    }
+    if (accel.lookupValue("oversampling", sOversampling)) {
+      for (int i=0; i<4; ++i) {
+        if (sOversampling != asOversampling[i]) continue;
+        oMcc.oAccel.u8Oversampling = (uint8_t)i;
+        oMcc.u32AccelSet |= MCC_ACCEL_SET_OVERSAMPLING;
+      }
+    }
+    if (accel.lookupValue("low_noise", bLowNoise)) {
+      oMcc.oAccel.u8LowNoise = bLowNoise ? 1 : 0;
+      oMcc.u32AccelSet |= MCC_ACCEL_SET_LOW_NOISE;
+    }
+  } catch (const SettingNotFoundException & e) {
+    // ignore, the M4 defaults stay
+  }
+}
+
+// filter chain of the pushes of the "filter" group
+static void config_filter (const Setting & root, TConfigMcc & oMcc)
+{
+  try {
+    const Setting & filter = root["filter"];
+    double          fHz;
+    int             iCount;
+
+    if (filter.lookupValue("high_pass", fHz) && (fHz > 0.0) && (fHz < 655.0)) {
+      oMcc.oFilter.u16HighPassCentiHz = (uint16_t)(fHz * 100.0 + 0.5);
+      oMcc.bFilter = true;
+    }
+    if (filter.lookupValue("low_pass", fHz) && (fHz > 0.0) && (fHz < 6553.0)) {
+      oMcc.oFilter.u16LowPassDeciHz = (uint16_t)(fHz * 10.0 + 0.5);
+      oMcc.bFilter = true;
+    }
+    if (filter.lookupValue("average", iCount) && (iCount > 1) && (iCount <= MCC_ACCEL_FILTER_MAX_AVERAGE)) {
+      oMcc.oFilter.u8Average = (uint8_t)iCount;
+      oMcc.bFilter = true;
+    }
+    if (filter.lookupValue("decimation", iCount) && (iCount > 1) && (iCount <= 255)) {
+      oMcc.oFilter.u8Decimation = (uint8_t)iCount;
+      oMcc.bFilter = true;
+    }
+  } catch (const SettingNotFoundException & e) {
+    // ignore, the pushes stay unfiltered
+  }
+}
+
+// vibration features of the "features" group
+static void config_features (const Setting & root, TConfigMcc & oMcc)
+{
+  try {
+    const Setting & features = root["features"];
+    int             iCount;
+
+    if (features.lookupValue("window", iCount) && (iCount > 0) && (iCount <= 65535)) {
+      oMcc.oFeatures.u16Length = (uint16_t)iCount;
+      oMcc.oFeatures.u8Bands   = 1;
+      oMcc.bFeatures = true;
+    }
+    if (features.lookupValue("bands", iCount) && (iCount > 0) && (iCount <= 255)) {
+      oMcc.oFeatures.u8Bands = (uint8_t)iCount;
+    }
+  } catch (const SettingNotFoundException & e) {
+    // ignore, no features
+  }
+}
+
+// threshold in g to MCC_ACCEL_EVENTS_THS_MG steps, 0 if out of range
+static uint8_t config_eventThs (const Setting & events, const char * sName)
+{
+  double fG;
+  int    iSteps;
+
+  if (!events.lookupValue(sName, fG) || (fG <= 0.0)) return 0;
+  iSteps = (int)(fG * 1000.0 / MCC_ACCEL_EVENTS_THS_MG + 0.5);
+  if (iSteps < 1) iSteps = 1;
+  return (iSteps <= MCC_ACCEL_EVENTS_MAX_THS) ? (uint8_t)iSteps : 0;
+}
+
+// event detection of the "events" group
+static void config_events (const Setting & root, TConfigMcc & oMcc)
+{
+  TMccAccelEvents & oEvents = oMcc.oEvents;
+
+  try {
+    const Setting & events = root["events"];
+    int             iMs;
+    string          sAxes;
+    bool            bDoubleTap;
+
+    oEvents.u8MotionThs     = config_eventThs(events, "motion");
+    oEvents.u8FreefallThs   = config_eventThs(events, "freefall");
+    oEvents.u8TransientThs  = config_eventThs(events, "transient");
+    oEvents.u8TapThs        = config_eventThs(events, "tap");
+    oMcc.bEvents = (oEvents.u8MotionThs || oEvents.u8FreefallThs || oEvents.u8TransientThs || oEvents.u8TapThs);
+    if (events.lookupValue("debounce", iMs) && (iMs > 0) && (iMs <= 65535)) {
+      oEvents.u16DebounceMs = (uint16_t)iMs;
+    }
+    if (events.lookupValue("axes", sAxes)) {
+      if (sAxes.find('x') != string::npos) oEvents.u8Axes |= MCC_ACCEL_AXIS_X;
+      if (sAxes.find('y') != string::npos) oEvents.u8Axes |= MCC_ACCEL_AXIS_Y;
+      if (sAxes.find('z') != string::npos) oEvents.u8Axes |= MCC_ACCEL_AXIS_Z;
+    }
+    if (events.lookupValue("double_tap", bDoubleTap)) {
+      oEvents.u8DoubleTap = bDoubleTap ? 1 : 0;
+    }
+  } catch (const SettingNotFoundException & e) {
+    // ignore, no events
+  }
+}
+
+int config_loadMcc (TConfigMcc & oMcc, const char * sFilename)
+{
+  Config cfg;
+
+  memset(&oMcc, 0, sizeof(oMcc));
+
+  // read and parse the file
+  try {
+    cfg.readFile(sFilename);
+  } catch (const FileIOException & e) {
+    puts("I/O error while reading file.");
+    return 1;
+  } catch (const ParseException & e) {
+    printf("Parse error at %s: %d - %s\n",
+           e.getFile(), e.getLine(), e.getError());
+    return 2;
+  }
+
+  const Setting & root = cfg.getRoot();
+
+  config_accel(root, oMcc);
+  config_filter(root, oMcc);
+  config_features(root, oMcc);
+  config_events(root, oMcc);
+  return 0;
+}
@@ -10,6 +10,23 @@
 
 #include <QtGui>
 
+#include "../common/easyduo_mcc_common.h"
+
 int config_loadMedia (QComboBox & oCombo, const char * sFilename);
 
+/** M4 settings of easyduo.cfg, all zero for the groups not given. */
+typedef struct t_config_mcc_struct {
+  TMccAccelConfig   oAccel;                                                     //!< Accelerometer settings of the "accel" group.
+  uint32_t          u32AccelSet;                                                //!< MCC_ACCEL_SET_* bits of the oAccel settings given, 0 if none.
+  TMccAccelFilter   oFilter;                                                    //!< Filter chain of the pushes of the "filter" group.
+  bool              bFilter;                                                    //!< The group gives any stage.
+  TMccAccelFeatures oFeatures;                                                  //!< Vibration features of the "features" group.
+  bool              bFeatures;                                                  //!< The group gives a window (checked by the M4).
+  TMccAccelEvents   oEvents;                                                    //!< Event detection of the "events" group, thresholds given in g.
+  bool              bEvents;                                                    //!< The group gives any threshold (none clears the detection).
+} TConfigMcc;
+
+// the "accel", "filter", "features" and "events" groups, read at once
+int config_loadMcc (TConfigMcc & oMcc, const char * sFilename);
+
 #endif /* CONFIG_H_ */
@@ -0,0 +1,194 @@
+#include "easydiag.h"
+
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+//******************************************************************************
+
+#define TIMER_DELAY_DIAG                (1000)                                  //!< Refresh period in milliseconds.
+#define MCC_TIMEOUT_DIAG                (500)                                   //!< Timeout of the M4 statistics requests in milliseconds.
+#define DIAG_COLUMNS                    (1 + CMCC_CHANNEL_COUNT)                //!< The A5 and the M4 channels.
+
+#define DIAG_MSG_NAME(id, name, channel, sender, req, rep)         #id,
+
+/** Message type names indexed by the type. */
+static const char * const g_asMsgNames[MCCMSG_COUNT] = {
+  "RESERVED",
+  MCC_MSG_TABLE(DIAG_MSG_NAME)
+};
+
+/** Single counters of TMccStats in the order displayed. */
+static const struct {
+  const char  * sLabel;
+  size_t        offset;
+} g_aoCounters[] = {
+  { "tx failures",      offsetof(TMccStats, u32TxFailures)  },
+  { "tx no buffer",     offsetof(TMccStats, u32TxNoBuffer)  },
+  { "tx no credit",     offsetof(TMccStats, u32TxNoCredit)  },
+  { "rx errors",        offsetof(TMccStats, u32RxErrors)    },
+  { "rx lost",          offsetof(TMccStats, u32RxLost)      },
+  { "rx reordered",     offsetof(TMccStats, u32RxReordered) },
+  { "rx CRC errors",    offsetof(TMccStats, u32RxCrcErrors) },
+  { "request timeouts", offsetof(TMccStats, u32ReqTimeouts) },
+  { "queue depth",      offsetof(TMccStats, u32QueueDepth)  },
+  { "queue max",        offsetof(TMccStats, u32QueueMax)    },
+};
+
+//******************************************************************************
+
+EasyDiag::EasyDiag (CMcc & oMcc, CMccAsync & oMccAsync, QWidget *parent)
+    : QMainWindow(parent), m_oMcc(oMcc), m_oMccAsync(oMccAsync)
+{
+  ui.setupUi(this);
+
+  memset(m_auStatsId, 0, sizeof(m_auStatsId));
+  memset(m_aoStats, 0, sizeof(m_aoStats));
+  for (int i = 0; i < CMCC_CHANNEL_COUNT; ++i) m_aiStatus[i] = MCC_TIMEOUT;     // nothing received yet
+
+  connect(&m_oMccAsync, SIGNAL(statsReceived(uint, int, TMccStats)),
+          this, SLOT(statsReceived(uint, int, TMccStats)));
+  connect(&m_qTimer, SIGNAL(timeout()), this, SLOT(refresh()));
+}
+
+//******************************************************************************
+
+EasyDiag::~EasyDiag()
+{
+  printf("~EasyDiag\n");
+}
+
+//******************************************************************************
+
+void EasyDiag::start (void)
+{
+  this->showFullScreen();
+  this->refresh();
+  m_qTimer.start(TIMER_DELAY_DIAG);
+}
+
+//******************************************************************************
+
+void EasyDiag::closeEvent (QCloseEvent * ev)
+{
+  m_qTimer.stop();                                                              // the replies in flight are just displayed
+  QMainWindow::closeEvent(ev);
+}
+
+//******************************************************************************
+
+void EasyDiag::refresh (void)
+{
+  for (int i = 0; i < CMCC_CHANNEL_COUNT; ++i) {
+    if (m_auStatsId[i]) continue;                                               // one request in flight at most
+    m_auStatsId[i] = m_oMccAsync.requestStats(i, MCC_TIMEOUT_DIAG);
+    if (!m_auStatsId[i]) m_aiStatus[i] = MCC_SEND_FAILURE;
+  }
+  this->showStats();                                                            // the A5 counters at least
+}
+
+//******************************************************************************
+
+void EasyDiag::statsReceived (uint uId, int iStatus, TMccStats oStats)
+{
+  for (int i = 0; i < CMCC_CHANNEL_COUNT; ++i) {
+    if (!uId || (uId != m_auStatsId[i])) continue;
+    m_auStatsId[i] = 0;
+    m_aiStatus[i]  = iStatus;
+    if (MCC_OK == iStatus) m_aoStats[i] = oStats;
+    this->showStats();
+    return;
+  }
+}
+
+//******************************************************************************
+
+void EasyDiag::showStats (void)
+{
+  TMccStats           oLocal;
+  const TMccStats   * apoStats[DIAG_COLUMNS];
+  bool                abValid[DIAG_COLUMNS];
+  QString             sText;
+  char                acLine[128];
+  char                acCell[32];
+  uint32_t            u32Value;
+  int                 iScroll;
+  size_t              len;
+  int                 iCol;
+  int                 i;
+
+  m_oMcc.getStats(&oLocal);
+  apoStats[0] = &oLocal;
+  abValid[0]  = true;
+  for (i = 0; i < CMCC_CHANNEL_COUNT; ++i) {
+    apoStats[1 + i] = &m_aoStats[i];
+    abValid[1 + i]  = (MCC_OK == m_aiStatus[i]);
+  }
+
+  sText.append("                           A5   M4 control      M4 bulk\n");
+
+  // messages received/sent per type, the ones seen only
+  for (i = 0; i < MCCMSG_COUNT; ++i) {
+    u32Value = 0;
+    for (iCol = 0; iCol < DIAG_COLUMNS; ++iCol) {
+      if (abValid[iCol]) u32Value |= apoStats[iCol]->au32Rx[i] | apoStats[iCol]->au32Tx[i];
+    }
+    if (!u32Value) continue;
+    len = snprintf(acLine, sizeof(acLine), "%-18.18s", g_asMsgNames[i]);
+    for (iCol = 0; iCol < DIAG_COLUMNS; ++iCol) {
+      if (abValid[iCol]) {
+        snprintf(acCell, sizeof(acCell), "%u/%u", apoStats[iCol]->au32Rx[i], apoStats[iCol]->au32Tx[i]);
+      } else {
+        strcpy(acCell, "-");
+      }
+      len += snprintf(acLine + len, sizeof(acLine) - len, " %12s", acCell);
+    }
+    sText.append(acLine).append("\n");
+  }
+
+  // single counters
+  for (i = 0; i < (int)(sizeof(g_aoCounters) / sizeof(g_aoCounters[0])); ++i) {
+    len = snprintf(acLine, sizeof(acLine), "%-18s", g_aoCounters[i].sLabel);
+    for (iCol = 0; iCol < DIAG_COLUMNS; ++iCol) {
+      if (abValid[iCol]) {
+        u32Value = *(const uint32_t*)((const uint8_t*)apoStats[iCol] + g_aoCounters[i].offset);
+        snprintf(acCell, sizeof(acCell), "%u", u32Value);
+      } else {
+        strcpy(acCell, "-");
+      }
+      len += snprintf(acLine + len, sizeof(acLine) - len, " %12s", acCell);
+    }
+    sText.append(acLine).append("\n");
+  }
+
+  // latency histogram
+  sText.append("latency (A5 round trip, M4 service time)\n");
+  for (i = 0; i < MCC_STATS_LATENCY_BINS; ++i) {
+    if (i < MCC_STATS_LATENCY_BINS - 1) {
+      snprintf(acCell, sizeof(acCell), "  < %u us", (unsigned)MCC_STATS_LATENCY_MIN_US << i);
+    } else {
+      snprintf(acCell, sizeof(acCell), "  >= %u us", (unsigned)MCC_STATS_LATENCY_MIN_US << (i - 1));
+    }
+    len = snprintf(acLine, sizeof(acLine), "%-18s", acCell);
+    for (iCol = 0; iCol < DIAG_COLUMNS; ++iCol) {
+      if (abValid[iCol]) {
+        snprintf(acCell, sizeof(acCell), "%u", apoStats[iCol]->au32Latency[i]);
+      } else {
+        strcpy(acCell, "-");
+      }
+      len += snprintf(acLine + len, sizeof(acLine) - len, " %12s", acCell);
+    }
+    sText.append(acLine).append("\n");
+  }
+
+  iScroll = ui.txtStats->verticalScrollBar()->value();                          // keep the part being read
+  ui.txtStats->setPlainText(sText);
+  ui.txtStats->verticalScrollBar()->setValue(iScroll);
+  ui.lblStatus->setText(QString("Protocol %1, link %2, M4 status %3/%4")
+                        .arg(m_oMcc.getProtocolVersion())
+                        .arg(m_oMcc.isLinkUp() ? "up" : "down")
+                        .arg(m_aiStatus[CMCC_CHANNEL_CONTROL])
+                        .arg(m_aiStatus[CMCC_CHANNEL_BULK]));
+}
+
+//******************************************************************************
@@ -0,0 +1,41 @@
+#ifndef EASYDIAG_H
+#define EASYDIAG_H
+
+#include <QtGui>
+#include <QtGui/QMainWindow>
+#include "ui_easydiag.h"
+
+#include "CMcc.h"
+#include "CMccAsync.h"
+
+class EasyDiag : public QMainWindow
+{
+    Q_OBJECT
+
+public:
+    EasyDiag(CMcc & oMcc, CMccAsync & oMccAsync, QWidget *parent = 0);
+    ~EasyDiag();
+
+    void start (void);
+
+protected:
+    CMcc      & m_oMcc;
+    CMccAsync & m_oMccAsync;
+    QTimer      m_qTimer;
+    uint        m_auStatsId[CMCC_CHANNEL_COUNT];                                // M4 requests in flight, 0 if none.
+    int         m_aiStatus[CMCC_CHANNEL_COUNT];                                 // Status of the last M4 reply.
+    TMccStats   m_aoStats[CMCC_CHANNEL_COUNT];                                  // Counters of the M4 channel tasks.
+
+    void closeEvent (QCloseEvent * ev);
+    void showStats (void);
+
+private:
+    Ui::EasyDiagClass ui;
+
+private slots:
+    void refresh (void);
+    void statsReceived (uint uId, int iStatus, TMccStats oStats);
+
+};
+
+#endif // EASYDIAG_H
@@ -11,6 +11,8 @@
 
 #define TIMER_DELAY_ACCEL               (50)
 #define TIMER_DELAY_MEDIA               (1000)
+#define MCC_TIMEOUT_ACCEL               (200)                                   //!< Timeout of the accelerometer requests in milliseconds.
+#define CONFIG_FILE                     "/home/root/easyduo.cfg"
 
 #define PRG_ACCEL_SHIFT                 (8192)
 #define PRG_ACCEL_SCALE                 (4096)
@@ -18,9 +20,12 @@
 //******************************************************************************
 
 EasyDuo::EasyDuo(QWidget *parent)
-    : QMainWindow(parent), m_poMcc(NULL)
+    : QMainWindow(parent), m_pEasyDiag(NULL), m_poMcc(NULL), m_poMccAsync(NULL),
+      m_bAccelPush(false), m_uAccelStreamId(0)
 {
-  QString sIp;
+  QString           sIp;
+  TAccelData        oAccelData;
+  TConfigMcc        oMccConfig;
 
   ui.setupUi(this);
 
@@ -30,7 +35,7 @@ EasyDuo::EasyDuo(QWidget *parent)
   }
 
   // load config file
-  config_loadMedia(*ui.cbxMedia, "/home/root/easyduo.cfg");
+  config_loadMedia(*ui.cbxMedia, CONFIG_FILE);
 
   // initialize MCC
   try {
@@ -40,8 +45,50 @@ EasyDuo::EasyDuo(QWidget *parent)
   }
   m_pEasyPlayer = new EasyPlayer();
 
-  // display accelerometer type
-  refreshAccelName();
+  // the GUI thread never waits for the M4, replies come as signals
+  if (m_poMcc) {
+    m_poMccAsync = new CMccAsync(*m_poMcc);
+    connect(m_poMccAsync, SIGNAL(accelTypeReceived(uint, int, int)),
+            this, SLOT(refreshAccelName(uint, int, int)));
+    connect(m_poMccAsync, SIGNAL(accelStreamReceived(uint, int, QVector<TAccelData>, uint)),
+            this, SLOT(accelStreamReceived(uint, int, QVector<TAccelData>, uint)));
+    connect(m_poMccAsync, SIGNAL(subscribeReceived(uint, int, uint)),
+            this, SLOT(accelSubscribed(uint, int, uint)));
+    connect(m_poMccAsync, SIGNAL(accelConfigReceived(uint, int, TMccAccelConfigMsg)),
+            this, SLOT(accelConfigured(uint, int, TMccAccelConfigMsg)));
+    connect(m_poMccAsync, SIGNAL(accelFilterReceived(uint, int, TMccAccelFilterMsg)),
+            this, SLOT(accelFiltered(uint, int, TMccAccelFilterMsg)));
+    connect(m_poMccAsync, SIGNAL(accelFeaturesReceived(uint, int, TMccAccelFeaturesMsg)),
+            this, SLOT(accelFeatured(uint, int, TMccAccelFeaturesMsg)));
+    connect(m_poMccAsync, SIGNAL(accelEventsReceived(uint, int, TMccAccelEventsMsg)),
+            this, SLOT(accelEventsSet(uint, int, TMccAccelEventsMsg)));
+    connect(m_poMccAsync, SIGNAL(accelEventsReady()),
+            this, SLOT(accelEvents()));
+
+    // display accelerometer type
+    m_poMccAsync->requestAccelType(MCC_TIMEOUT_ACCEL);
+
+    // accelerometer settings of this deployment (all zero if the file is
+    // unreadable)
+    config_loadMcc(oMccConfig, CONFIG_FILE);
+    if (oMccConfig.u32AccelSet) {
+      m_poMccAsync->requestAccelConfig(oMccConfig.oAccel, oMccConfig.u32AccelSet, MCC_TIMEOUT_ACCEL);
+    }
+    if (oMccConfig.bFilter) {
+      m_poMccAsync->requestAccelFilter(oMccConfig.oFilter, MCC_TIMEOUT_ACCEL);  // the pushes only
+    }
+    m_poMccAsync->requestAccelFeatures(oMccConfig.oFeatures, MCC_TIMEOUT_ACCEL);  // none clears the ones of an earlier process
+    m_poMccAsync->requestAccelEvents(oMccConfig.oEvents, MCC_TIMEOUT_ACCEL);    // likewise
+
+    // link statistics shown on request
+    m_pEasyDiag = new EasyDiag(*m_poMcc, *m_poMccAsync);
+
+    // read the samples from the shared memory if possible, otherwise let the
+    // M4 push them, poll until it confirms
+    if (MCC_OK != m_poMcc->readAccelSnapshot(&oAccelData)) {
+      m_poMccAsync->requestSubscribe(TIMER_DELAY_ACCEL, MCC_TIMEOUT_ACCEL);
+    }
+  }
 
   // add periodic signal-slot connections
   connect(&m_qTimerAccel, SIGNAL(timeout()), this, SLOT(refreshAccel()));
@@ -53,6 +100,9 @@ EasyDuo::EasyDuo(QWidget *parent)
 EasyDuo::~EasyDuo()
 {
   this->ledAuto();
+  delete m_pEasyDiag;                                                           // before m_poMccAsync it is connected to
+  delete m_poMccAsync;                                                          // before m_poMcc, it cancels the pending requests
+  if (m_bAccelPush) m_poMcc->unsubscribeAccel();
   delete m_poMcc;
   delete m_pEasyPlayer;
 }
@@ -93,49 +143,191 @@ void EasyDuo::play (void)
 
 //******************************************************************************
 
-void EasyDuo::refreshAccelName (void)
+void EasyDuo::showDiag (void)
+{
+  if (m_pEasyDiag) m_pEasyDiag->start();
+}
+
+//******************************************************************************
+
+void EasyDuo::refreshAccelName (uint uId, int iStatus, int iType)
 {
-  int32_t       i32Type;
   QString       sName;
-  int           ret;
 
-  if (m_poMcc) {
-    ret = m_poMcc->getAccelType(&i32Type);
-    if (MCC_OK == ret) {
-      printf("getAccelType: %d\n", i32Type);
-      switch (i32Type) {
-      case ACCEL_TYPE_MMA8451Q: sName = "MMA8451Q"; break;
-      case ACCEL_TYPE_MMA8452Q: sName = "MMA8452Q"; break;
-      case ACCEL_TYPE_MMA8453Q: sName = "MMA8453Q"; break;
-      default:                  sName = "unknown";  break;
-      }
-    } else {
-      sName = "N/A";
+  (void)uId;
+  if (MCC_OK == iStatus) {
+    printf("getAccelType: %d\n", iType);
+    switch (iType) {
+    case ACCEL_TYPE_MMA8451Q: sName = "MMA8451Q"; break;
+    case ACCEL_TYPE_MMA8452Q: sName = "MMA8452Q"; break;
+    case ACCEL_TYPE_MMA8453Q: sName = "MMA8453Q"; break;
+    default:                  sName = "unknown";  break;
     }
-    ui.gbxAccel->setTitle(QString("Accelerometer (").append(sName).append(")"));
+  } else {
+    sName = "N/A";
   }
+  ui.gbxAccel->setTitle(QString("Accelerometer (").append(sName).append(")"));
 }
 
 //******************************************************************************
 
-void EasyDuo::refreshAccel (void)
+void EasyDuo::accelConfigured (uint uId, int iStatus, TMccAccelConfigMsg oConfig)
 {
-  TAccelData  oAccelData;
-  int         ret;
+  (void)uId;
+  if ((MCC_OK == iStatus) && (MCC_ACCEL_CONFIG_OK == oConfig.i32Status)) {
+    printf("setAccelConfig: %.2f Hz, %u g, oversampling %u, low noise %u\n",
+           oConfig.oConfig.u32RateMilliHz / 1000.0, oConfig.oConfig.u8RangeG,
+           oConfig.oConfig.u8Oversampling, oConfig.oConfig.u8LowNoise);
+  } else {
+    printf("setAccelConfig failed: %d/%d\n", iStatus, oConfig.i32Status);
+  }
+}
 
-  if (m_poMcc) {
-    ret = m_poMcc->getAccelData(&oAccelData);
-    if (MCC_OK == ret) {
-//      printf("getAccelData: %f %f %f\n", oAccelData.x, oAccelData.y, oAccelData.z);
-      EasyDuo::prgAccelSetValue(*ui.prgAccelX, oAccelData.x);
-      EasyDuo::prgAccelSetValue(*ui.prgAccelY, oAccelData.y);
-      EasyDuo::prgAccelSetValue(*ui.prgAccelZ, oAccelData.z);
-    } else {
-      // just to see that MCC communication is broken
-      EasyDuo::prgAccelSetValue(*ui.prgAccelX, -1);
-      EasyDuo::prgAccelSetValue(*ui.prgAccelY, 0);
-      EasyDuo::prgAccelSetValue(*ui.prgAccelZ, 1);
+//******************************************************************************
+
+void EasyDuo::accelFiltered (uint uId, int iStatus, TMccAccelFilterMsg oFilter)
+{
+  (void)uId;
+  if ((MCC_OK == iStatus) && (MCC_ACCEL_FILTER_OK == oFilter.i32Status)) {
+    printf("setAccelFilter: high-pass %.2f Hz, low-pass %.1f Hz, average %u, decimation %u\n",
+           oFilter.oFilter.u16HighPassCentiHz / 100.0, oFilter.oFilter.u16LowPassDeciHz / 10.0,
+           oFilter.oFilter.u8Average, oFilter.oFilter.u8Decimation);
+  } else {
+    printf("setAccelFilter failed: %d/%d\n", iStatus, oFilter.i32Status);
+  }
+}
+
+//******************************************************************************
+
+void EasyDuo::accelFeatured (uint uId, int iStatus, TMccAccelFeaturesMsg oFeatures)
+{
+  (void)uId;
+  if ((MCC_OK == iStatus) && (MCC_ACCEL_FEATURES_OK == oFeatures.i32Status)) {
+    if (oFeatures.oFeatures.u16Length) {
+      printf("setAccelFeatures: window %u samples (%.1f ms), %u bands\n",
+             oFeatures.oFeatures.u16Length, oFeatures.oFeatures.u16Length * oFeatures.u32PeriodUs / 1000.0,
+             oFeatures.oFeatures.u8Bands);
     }
+  } else {
+    printf("setAccelFeatures failed: %d/%d\n", iStatus, oFeatures.i32Status);
+  }
+}
+
+//******************************************************************************
+
+void EasyDuo::accelEventsSet (uint uId, int iStatus, TMccAccelEventsMsg oEvents)
+{
+  const TMccAccelEvents & oSet = oEvents.oEvents;
+
+  (void)uId;
+  if ((MCC_OK == iStatus) && (MCC_ACCEL_EVENTS_OK == oEvents.i32Status)) {
+    if (oSet.u8MotionThs || oSet.u8FreefallThs || oSet.u8TransientThs || oSet.u8TapThs) {
+      printf("setAccelEvents: motion %.3f g, freefall %.3f g, transient %.3f g, tap %.3f g%s, debounce %u ms, axes 0x%x\n",
+             oSet.u8MotionThs * MCC_ACCEL_EVENTS_THS_MG / 1000.0, oSet.u8FreefallThs * MCC_ACCEL_EVENTS_THS_MG / 1000.0,
+             oSet.u8TransientThs * MCC_ACCEL_EVENTS_THS_MG / 1000.0, oSet.u8TapThs * MCC_ACCEL_EVENTS_THS_MG / 1000.0,
+             oSet.u8DoubleTap ? " (double)" : "", oSet.u16DebounceMs, oSet.u8Axes);
+    }
+  } else {
+    printf("setAccelEvents failed: %d/%d\n", iStatus, oEvents.i32Status);
+  }
+}
+
+//******************************************************************************
+
+void EasyDuo::accelEvents (void)
+{
+  static const char * const asType[] = { "?", "motion", "freefall", "transient", "tap", "double tap" };
+  TAccelEvent   aoEvents[CMCC_EVENT_RING_SIZE];
+  uint32_t      u32Count;
+  uint32_t      u32Lost;
+  uint32_t      i;
+
+  if (!m_poMcc) return;
+
+  // told by the CMcc receiver thread, no polling
+  u32Count = m_poMcc->readAccelEvents(aoEvents, CMCC_EVENT_RING_SIZE, &u32Lost);
+  if (u32Lost) printf("events lost: %u\n", u32Lost);
+  for (i = 0; i < u32Count; ++i) {
+    printf("event %u: %s, axes 0x%x (negative 0x%x), sample %u\n",
+           aoEvents[i].number, asType[(aoEvents[i].type <= MCC_ACCEL_EVENT_DOUBLE_TAP) ? aoEvents[i].type : 0],
+           aoEvents[i].axes, aoEvents[i].negative, aoEvents[i].timestamp);
+  }
+}
+
+//******************************************************************************
+
+void EasyDuo::accelSubscribed (uint uId, int iStatus, uint uPeriodMs)
+{
+  (void)uId;
+  if (MCC_OK == iStatus) {
+    printf("subscribeAccel: %u ms\n", uPeriodMs);
+    m_bAccelPush = true;
+  } else {
+    printf("subscribeAccel failed: %d, polling\n", iStatus);
+  }
+}
+
+//******************************************************************************
+
+void EasyDuo::refreshAccel (void)
+{
+  TAccelData    aoAccelData[MCC_ACCEL_STREAM_MAX_SAMPLES];
+  TAccelSummary aoSummaries[CMCC_SUMMARY_RING_SIZE];
+  uint32_t      u32Count;
+  uint32_t      i;
+
+  if (!m_poMcc) return;
+
+  // vibration features summarized by the M4, if set
+  u32Count = m_poMcc->readAccelSummaries(aoSummaries, CMCC_SUMMARY_RING_SIZE);
+  for (i = 0; i < u32Count; ++i) {
+    const TMccAccelAxisFeatures * paoAxes = aoSummaries[i].axes;
+
+    printf("features %u: rms %.4f %.4f %.4f g, p-p %.4f %.4f %.4f g, crest %.2f %.2f %.2f\n",
+           aoSummaries[i].window, paoAxes[0].fRms, paoAxes[1].fRms, paoAxes[2].fRms,
+           paoAxes[0].fPeakToPeak, paoAxes[1].fPeakToPeak, paoAxes[2].fPeakToPeak,
+           paoAxes[0].fCrest, paoAxes[1].fCrest, paoAxes[2].fCrest);
+  }
+
+  if (m_bAccelPush) {                                                           // samples received by the CMcc receiver thread
+    u32Count = m_poMcc->readAccelSamples(aoAccelData, MCC_ACCEL_STREAM_MAX_SAMPLES);
+    if (u32Count) this->showAccel(&aoAccelData[u32Count-1]);                    // display the newest sample, keep the old values otherwise
+  } else if (MCC_OK == m_poMcc->readAccelSnapshot(&aoAccelData[0])) {           // shared memory, no message exchange
+    this->showAccel(&aoAccelData[0]);
+  } else if (!m_uAccelStreamId) {                                               // one poll in flight at most
+    m_uAccelStreamId = m_poMccAsync->requestAccelStream(MCC_ACCEL_STREAM_MAX_SAMPLES, MCC_TIMEOUT_ACCEL);
+    if (!m_uAccelStreamId) this->showAccel(NULL);
+  }
+}
+
+//******************************************************************************
+
+void EasyDuo::accelStreamReceived (uint uId, int iStatus, QVector<TAccelData> qSamples, uint uLost)
+{
+  (void)uLost;
+  if (uId != m_uAccelStreamId) return;
+  m_uAccelStreamId = 0;
+
+  if (MCC_OK == iStatus) {
+    if (!qSamples.isEmpty()) this->showAccel(&qSamples.last());                 // display the newest sample, keep the old values otherwise
+  } else {
+    this->showAccel(NULL);
+  }
+}
+
+//******************************************************************************
+
+void EasyDuo::showAccel (const TAccelData * poData)
+{
+  if (poData) {
+    EasyDuo::prgAccelSetValue(*ui.prgAccelX, poData->x);
+    EasyDuo::prgAccelSetValue(*ui.prgAccelY, poData->y);
+    EasyDuo::prgAccelSetValue(*ui.prgAccelZ, poData->z);
+  } else {
+    // just to see that MCC communication is broken
+    EasyDuo::prgAccelSetValue(*ui.prgAccelX, -1);
+    EasyDuo::prgAccelSetValue(*ui.prgAccelY, 0);
+    EasyDuo::prgAccelSetValue(*ui.prgAccelZ, 1);
   }
 }
 
@@ -193,21 +385,21 @@ void EasyDuo::mute (bool bMute)
 
 void EasyDuo::ledOn ()
 {
-  if (m_poMcc) m_poMcc->setLedOn();
+  if (m_poMccAsync) m_poMccAsync->setLedOn();
 }
 
 //******************************************************************************
 
 void EasyDuo::ledOff ()
 {
-  if (m_poMcc) m_poMcc->setLedOff();
+  if (m_poMccAsync) m_poMccAsync->setLedOff();
 }
 
 //******************************************************************************
 
 void EasyDuo::ledAuto ()
 {
-  if (m_poMcc) m_poMcc->setLedAuto();
+  if (m_poMccAsync) m_poMccAsync->setLedAuto();
 }
 
 //******************************************************************************
@@ -5,7 +5,9 @@
 #include "ui_easyduo.h"
 
 #include "easyplayer.h"
+#include "easydiag.h"
 #include "CMcc.h"
+#include "CMccAsync.h"
 
 class EasyDuo : public QMainWindow
 {
@@ -18,22 +20,35 @@ public:
 private:
     Ui::EasyDuoClass    ui;
     EasyPlayer        * m_pEasyPlayer;
+    EasyDiag          * m_pEasyDiag;
     QTimer              m_qTimerAccel;
     QTimer              m_qTimerMedia;
     CMcc              * m_poMcc;
+    CMccAsync         * m_poMccAsync;
+    bool                m_bAccelPush;
+    uint                m_uAccelStreamId;
 
     static void prgAccelSetValue(QProgressBar & qPrgBar, float val);
+    void showAccel (const TAccelData * poData);
     static void cbxItemEnable(QComboBox & qCombo, int idx, bool bEnable);
     static bool fileExists(const char * sFilename);
 
     bool event(QEvent * ev);
-    void refreshAccelName (void);
 
 private slots:
     void play ();
+    void showDiag ();
     void mute (bool bMute);
     void refreshMedia ();
     void refreshAccel ();
+    void refreshAccelName (uint uId, int iStatus, int iType);
+    void accelStreamReceived (uint uId, int iStatus, QVector<TAccelData> qSamples, uint uLost);
+    void accelSubscribed (uint uId, int iStatus, uint uPeriodMs);
+    void accelConfigured (uint uId, int iStatus, TMccAccelConfigMsg oConfig);
+    void accelFiltered (uint uId, int iStatus, TMccAccelFilterMsg oFilter);
+    void accelFeatured (uint uId, int iStatus, TMccAccelFeaturesMsg oFeatures);
+    void accelEventsSet (uint uId, int iStatus, TMccAccelEventsMsg oEvents);
+    void accelEvents ();
     void ledOn ();
     void ledOff ();
     void ledAuto ();
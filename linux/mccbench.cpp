@@ -0,0 +1,339 @@
+/*
+ * mccbench.cpp
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+// MCC link benchmark: round-trip latency (one MCCMSG_PING at a time) and
+// throughput (a window of pipelined PINGs) for a fixed payload size or a
+// sweep of sizes, with the CRC trailer off and on. Runs against the M4 (or
+// the simulator when EASYDUO_MCC_SIM is set) or, with -l, against an
+// in-process loopback stand-in.
+
+#include "CMcc.h"
+#include "CMccTransportLoopback.h"
+
+#include <algorithm>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+//******************************************************************************
+// Local definitions
+//******************************************************************************
+
+#define BENCH_COUNT_DEFAULT             (10000)                                 //!< Default number of PINGs per test.
+#define BENCH_WINDOW_DEFAULT            (8)                                     //!< Default number of PINGs in flight in the throughput test.
+#define BENCH_TIMEOUT_DEFAULT           (1000)                                  //!< Default PING timeout in milliseconds.
+#define BENCH_HIST_BUCKETS              (24)                                    //!< Latency histogram buckets (powers of 2 microseconds).
+#define BENCH_HIST_WIDTH                (50)                                    //!< Width of the longest histogram bar in characters.
+
+/** State of one test shared with the reply callback. */
+typedef struct t_bench_struct {
+  pthread_mutex_t   mtx;
+  pthread_cond_t    cond;
+  uint32_t          u32Window;                                                  //!< Maximum number of PINGs in flight.
+  uint32_t          u32InFlight;                                                //!< Number of PINGs waiting for the PONG.
+  uint32_t          u32Lost;                                                    //!< Number of PINGs not sent or not answered.
+  uint32_t          u32Count;                                                   //!< Number of valid entries in pu32RttUs.
+  uint32_t        * pu32RttUs;                                                  //!< Round-trip times in microseconds.
+  uint64_t          u64M4Us;                                                    //!< Sum of the M4 (or stand-in) processing times.
+} TBench;
+
+static const uint32_t g_au32Sweep[] = { 0, 16, 64, 256, 512, MCC_PING_MAX_PAYLOAD };  //!< Payload sizes of the sweep.
+
+//******************************************************************************
+// Local functions
+//******************************************************************************
+
+/** Returns the CLOCK_MONOTONIC time in microseconds (wrapping). */
+static uint32_t bench_timeUs (void)
+{
+  struct timespec oNow;
+
+  clock_gettime(CLOCK_MONOTONIC, &oNow);
+  return (uint32_t)oNow.tv_sec * 1000000u + (uint32_t)(oNow.tv_nsec / 1000);
+}
+
+//******************************************************************************
+
+/** TMccReplyFn of the PINGs. */
+static void bench_onPong (void            * pvCtx,
+                          uint32_t          u32Id,
+                          int               iStatus,
+                          const TMccMsg   * poReply,
+                          MCC_MEM_SIZE      size)
+{
+  TBench            * poBench = (TBench*)pvCtx;
+  const TMccPingMsg * poPong  = (const TMccPingMsg*)poReply;
+  uint32_t            u32NowUs = bench_timeUs();
+
+  (void)u32Id;
+  pthread_mutex_lock(&poBench->mtx);
+  if ((MCC_OK == iStatus) && (size >= MCC_PING_HEADER_SIZE) && (MCCMSG_PONG == poPong->type)) {
+    poBench->pu32RttUs[poBench->u32Count++] = u32NowUs - poPong->u32A5TimeUs;
+    poBench->u64M4Us += poPong->u32M4TxTimeUs - poPong->u32M4RxTimeUs;
+  } else {
+    ++poBench->u32Lost;
+  }
+  --poBench->u32InFlight;
+  pthread_cond_signal(&poBench->cond);
+  pthread_mutex_unlock(&poBench->mtx);
+}
+
+//******************************************************************************
+
+/** Sends u32Count PINGs of given payload size keeping up to poBench->u32Window
+ *  of them in flight, waits for all the replies.
+ * @return  Elapsed time in microseconds. */
+static uint32_t bench_run (CMcc      & oMcc,
+                           TBench    * poBench,
+                           uint32_t    u32Size,
+                           uint32_t    u32Count,
+                           uint32_t    u32TimeoutMs)
+{
+  TMccPingMsg * poPing;
+  uint32_t      u32StartUs = bench_timeUs();
+  uint32_t      i;
+  int           ret;
+
+  poBench->u32InFlight  = 0;
+  poBench->u32Lost      = 0;
+  poBench->u32Count     = 0;
+  poBench->u64M4Us      = 0;
+
+  for (i = 0; i < u32Count; ++i) {
+    pthread_mutex_lock(&poBench->mtx);
+    while (poBench->u32InFlight >= poBench->u32Window) pthread_cond_wait(&poBench->cond, &poBench->mtx);
+    ++poBench->u32InFlight;
+    pthread_mutex_unlock(&poBench->mtx);
+
+    poPing = (TMccPingMsg*)oMcc.allocMsg();
+    if (poPing) {
+      poPing->type          = MCCMSG_PING;
+      poPing->u32M4RxTimeUs = poPing->u32M4TxTimeUs = 0;
+      memset(poPing->au8Payload, 0, u32Size);
+      poPing->u32A5TimeUs   = bench_timeUs();
+      ret = oMcc.sendRequest((TMccMsg*)poPing, u32TimeoutMs, bench_onPong, poBench,
+                             NULL, MCC_PING_HEADER_SIZE + u32Size);
+    } else {
+      ret = MCC_SEND_FAILURE;
+    }
+    if (MCC_OK != ret) {
+      pthread_mutex_lock(&poBench->mtx);
+      --poBench->u32InFlight;
+      ++poBench->u32Lost;
+      pthread_mutex_unlock(&poBench->mtx);
+    }
+  }
+
+  pthread_mutex_lock(&poBench->mtx);
+  while (poBench->u32InFlight) pthread_cond_wait(&poBench->cond, &poBench->mtx);
+  pthread_mutex_unlock(&poBench->mtx);
+
+  return bench_timeUs() - u32StartUs;
+}
+
+//******************************************************************************
+
+/** Returns the q-quantile of the sorted round-trip times. */
+static uint32_t bench_quantile (const TBench * poBench, double dQ)
+{
+  uint32_t u32Idx = (uint32_t)(dQ * poBench->u32Count);
+
+  if (!poBench->u32Count) return 0;
+  if (u32Idx >= poBench->u32Count) u32Idx = poBench->u32Count - 1;
+  return poBench->pu32RttUs[u32Idx];
+}
+
+//******************************************************************************
+
+/** Prints the histogram of the round-trip times in power of 2 buckets. */
+static void bench_printHistogram (const TBench * poBench)
+{
+  uint32_t  au32Buckets[BENCH_HIST_BUCKETS];
+  uint32_t  u32Max = 0;
+  uint32_t  u32Bucket;
+  uint32_t  i;
+  int       iFirst = -1;
+  int       iLast  = -1;
+
+  memset(au32Buckets, 0, sizeof(au32Buckets));
+  for (i = 0; i < poBench->u32Count; ++i) {
+    u32Bucket = 0;
+    while ((poBench->pu32RttUs[i] >> (u32Bucket + 1)) && (u32Bucket < BENCH_HIST_BUCKETS - 1)) ++u32Bucket;
+    ++au32Buckets[u32Bucket];
+  }
+  for (i = 0; i < BENCH_HIST_BUCKETS; ++i) {
+    if (!au32Buckets[i]) continue;
+    if (iFirst < 0) iFirst = i;
+    iLast = i;
+    u32Max = std::max(u32Max, au32Buckets[i]);
+  }
+
+  for (int b = iFirst; (b >= 0) && (b <= iLast); ++b) {
+    printf("  %8u us %8u |", 1u << b, au32Buckets[b]);
+    for (i = 0; i < (uint64_t)au32Buckets[b] * BENCH_HIST_WIDTH / u32Max; ++i) putchar('#');
+    putchar('\n');
+  }
+}
+
+//******************************************************************************
+
+/** Runs the latency and throughput tests for one payload size and prints
+ *  one line of results (and the histogram if requested). */
+static void bench_size (CMcc      & oMcc,
+                        TBench    * poBench,
+                        bool        bCrc,
+                        uint32_t    u32Size,
+                        uint32_t    u32Count,
+                        uint32_t    u32Window,
+                        uint32_t    u32TimeoutMs,
+                        bool        bHistogram)
+{
+  uint32_t  u32LatLost;
+  uint32_t  u32ElapsedUs;
+  double    dMsgPerSec;
+
+  oMcc.setCrc(bCrc);
+
+  // latency: one PING at a time
+  poBench->u32Window = 1;
+  bench_run(oMcc, poBench, u32Size, u32Count, u32TimeoutMs);
+  u32LatLost = poBench->u32Lost;
+  std::sort(poBench->pu32RttUs, poBench->pu32RttUs + poBench->u32Count);
+
+  printf("%6u %3s %7u %6u %7u %7u %7u %7u %7u %6.1f",
+         u32Size, bCrc ? "on" : "off", u32Count, u32LatLost,
+         bench_quantile(poBench, 0.0), bench_quantile(poBench, 0.5),
+         bench_quantile(poBench, 0.99), bench_quantile(poBench, 0.999),
+         poBench->u32Count ? poBench->pu32RttUs[poBench->u32Count-1] : 0,
+         poBench->u32Count ? (double)poBench->u64M4Us / poBench->u32Count : 0.0);
+  fflush(stdout);
+
+  // throughput: a window of PINGs in flight
+  poBench->u32Window = u32Window;
+  u32ElapsedUs = bench_run(oMcc, poBench, u32Size, u32Count, u32TimeoutMs);
+  dMsgPerSec = u32ElapsedUs ? poBench->u32Count * 1e6 / u32ElapsedUs : 0.0;
+  printf(" %6u %9.0f %9.1f\n", poBench->u32Lost, dMsgPerSec,
+         dMsgPerSec * 2 * (MCC_HDR_PREFIX_SIZE + MCC_PING_HEADER_SIZE + u32Size
+                           + (bCrc ? MCC_CRC_SIZE : 0)) / 1024);                // both directions
+
+  if (bHistogram) {
+    poBench->u32Window = 1;                                                     // histogram of the latency test
+    bench_run(oMcc, poBench, u32Size, u32Count, u32TimeoutMs);
+    std::sort(poBench->pu32RttUs, poBench->pu32RttUs + poBench->u32Count);
+    bench_printHistogram(poBench);
+  }
+}
+
+//******************************************************************************
+
+static void bench_usage (const char * sName)
+{
+  printf("Usage: %s [-l] [-n count] [-s size] [-w window] [-t timeout] [-c off|on] [-H]\n"
+         "  -l  in-process loopback stand-in instead of the M4\n"
+         "      (set " CMCC_TRANSPORT_SIM_ENV " to use the host simulator)\n"
+         "  -n  PINGs per test (default %u)\n"
+         "  -s  payload size 0..%u, sweep of sizes if omitted\n"
+         "  -w  PINGs in flight in the throughput test, 1..%u (default %u)\n"
+         "  -t  PING timeout in milliseconds (default %u)\n"
+         "  -c  CRC trailer off or on only, both if omitted\n"
+         "  -H  print the latency histograms\n",
+         sName, BENCH_COUNT_DEFAULT, (unsigned)MCC_PING_MAX_PAYLOAD,
+         CMCC_PENDING_MAX, BENCH_WINDOW_DEFAULT, BENCH_TIMEOUT_DEFAULT);
+}
+
+//******************************************************************************
+//******************************************************************************
+//******************************************************************************
+
+int main (int argc, char * argv[])
+{
+  CMcc        * poMcc;
+  TBench        oBench;
+  bool          bLoopback   = false;
+  bool          bHistogram  = false;
+  int           iCrc        = -1;
+  long          lSize       = -1;
+  uint32_t      u32Count    = BENCH_COUNT_DEFAULT;
+  uint32_t      u32Window   = BENCH_WINDOW_DEFAULT;
+  uint32_t      u32Timeout  = BENCH_TIMEOUT_DEFAULT;
+  uint32_t      u32Size;
+  uint32_t      i;
+  int           iPass;
+  int           iOpt;
+
+  while ((iOpt = getopt(argc, argv, "ln:s:w:t:c:H")) != -1) {
+    switch (iOpt) {
+    case 'l': bLoopback   = true;                           break;
+    case 'n': u32Count    = strtoul(optarg, NULL, 0);       break;
+    case 's': lSize       = strtol(optarg, NULL, 0);        break;
+    case 'w': u32Window   = strtoul(optarg, NULL, 0);       break;
+    case 't': u32Timeout  = strtoul(optarg, NULL, 0);       break;
+    case 'c': iCrc        = strcmp(optarg, "off") ? 1 : 0;  break;
+    case 'H': bHistogram  = true;                           break;
+    default:
+      bench_usage(argv[0]);
+      return 1;
+    }
+  }
+  if (!u32Count || (lSize > (long)MCC_PING_MAX_PAYLOAD)
+      || !u32Window || (u32Window > CMCC_PENDING_MAX)) {
+    bench_usage(argv[0]);
+    return 1;
+  }
+
+  try {
+    if (bLoopback) {
+      poMcc = new CMcc(new CMccTransportLoopback());
+    } else {
+      poMcc = new CMcc(MCC_ENDPOINT_A5_NODE, MCC_ENDPOINT_A5_PORT);
+    }
+  } catch (int iErr) {
+    printf("mcc initialization failed: %d\n", iErr);
+    return 1;
+  }
+  if (poMcc->getProtocolVersion() < MCC_PROTOCOL_FRAMED) {
+    printf("the M4 does not support the framed protocol needed by PING\n");
+    delete poMcc;
+    return 1;
+  }
+
+  if ((iCrc < 0) && (poMcc->getProtocolVersion() < MCC_PROTOCOL_CRC)) {
+    iCrc = 0;                                                                   // both only if possible
+  } else if ((iCrc > 0) && (poMcc->getProtocolVersion() < MCC_PROTOCOL_CRC)) {
+    printf("the M4 does not support the CRC trailer\n");
+    delete poMcc;
+    return 1;
+  }
+
+  pthread_mutex_init(&oBench.mtx, NULL);
+  pthread_cond_init(&oBench.cond, NULL);
+  oBench.pu32RttUs = new uint32_t[u32Count];
+
+  printf("%s, %u PINGs per test, window %u\n",
+         bLoopback ? "loopback" : "MCC", u32Count, u32Window);
+  printf("%6s %3s %7s %6s %7s %7s %7s %7s %7s %6s %6s %9s %9s\n",
+         "size", "crc", "count", "lost", "min us", "p50 us", "p99 us", "p99.9us",
+         "max us", "m4 us", "lost", "msg/s", "kB/s");
+  for (i = 0; i < sizeof(g_au32Sweep) / sizeof(g_au32Sweep[0]); ++i) {
+    u32Size = (lSize >= 0) ? lSize : g_au32Sweep[i];
+    for (iPass = 0; iPass < 2; ++iPass) {
+      if ((iCrc >= 0) && (iPass != iCrc)) continue;
+      bench_size(*poMcc, &oBench, iPass != 0, u32Size, u32Count, u32Window, u32Timeout, bHistogram);
+    }
+    if (lSize >= 0) break;                                                      // one size only
+  }
+
+  delete [] oBench.pu32RttUs;
+  pthread_cond_destroy(&oBench.cond);
+  pthread_mutex_destroy(&oBench.mtx);
+  delete poMcc;
+  return 0;
+}
+
+//******************************************************************************
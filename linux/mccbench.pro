@@ -0,0 +1,43 @@
+TEMPLATE = app
+TARGET = mccbench
+CONFIG += console
+CONFIG -= qt \
+    app_bundle
+HEADERS += CMcc.h \
+    CMccClock.h \
+    CMccCrc.h \
+    CMccMsg.h \
+    CMccRaw.h \
+    CMccTransport.h \
+    CMccTransportMcc.h \
+    CMccTransportSocket.h \
+    CMccTransportLoopback.h \
+    CSpscRing.h \
+    ../common/easyduo_mcc_common.h
+SOURCES += CMcc.cpp \
+    CMccClock.cpp \
+    CMccCrc.cpp \
+    CMccRaw.cpp \
+    CMccTransport.cpp \
+    CMccTransportMcc.cpp \
+    CMccTransportSocket.cpp \
+    CMccTransportLoopback.cpp \
+    mccbench.cpp
+LIBS += -lmcc \
+    -lpthread \
+    -lrt
+# NEON batch conversion of the raw samples (CMccRaw) on the Vybrid A5
+contains(QT_ARCH, arm) {
+    QMAKE_CXXFLAGS += -mfpu=neon
+}
+# host build against the M4 simulator (qmake CONFIG+=mccsim, see ../sim)
+mccsim {
+    DEFINES += CMCC_TRANSPORT_SOCKET_ONLY
+    INCLUDEPATH += ../sim/include
+    HEADERS -= CMccTransportMcc.h
+    SOURCES -= CMccTransportMcc.cpp
+    LIBS -= -lmcc
+}
+# make install
+target.path = /usr/bin
+INSTALLS += target
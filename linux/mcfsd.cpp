@@ -0,0 +1,77 @@
+/*
+ * mcfsd.cpp
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+// MCC filesystem daemon: serves the files of a directory to the M4 tasks
+// (mqx/mcfs.c) until SIGINT or SIGTERM, then writes the buffered data and
+// prints the request counters. Talks to the M4 or, when EASYDUO_MCC_SIM is
+// set, to the host simulator.
+
+#include "CMcfsServer.h"
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+//******************************************************************************
+
+static void usage (const char * sName)
+{
+  printf("Usage: %s [-v] <directory>\n"
+         "  -v  print every open and close\n", sName);
+}
+
+//******************************************************************************
+
+int main (int argc, char * argv[])
+{
+  CMcfsServer * poServer;
+  TMcfsStats    oStats;
+  sigset_t      oSignals;
+  bool          bVerbose = false;
+  int           iSignal;
+  int           iOpt;
+
+  while ((iOpt = getopt(argc, argv, "vh")) != -1) {
+    switch (iOpt) {
+    case 'v': bVerbose = true;  break;
+    default:  usage(argv[0]);   return 1;
+    }
+  }
+  if (optind != argc - 1) {
+    usage(argv[0]);
+    return 1;
+  }
+  if (access(argv[optind], R_OK | W_OK | X_OK) < 0) {
+    printf("directory %s not accessible\n", argv[optind]);
+    return 1;
+  }
+
+  // termination signals are handled by sigwait() below, not by the threads
+  sigemptyset(&oSignals);
+  sigaddset(&oSignals, SIGINT);
+  sigaddset(&oSignals, SIGTERM);
+  pthread_sigmask(SIG_BLOCK, &oSignals, NULL);
+
+  try {
+    poServer = new CMcfsServer(argv[optind]);
+  } catch (int ret) {
+    printf("MCC endpoint not available: %d\n", ret);
+    return 1;
+  }
+  poServer->setVerbose(bVerbose);
+  printf("serving %s, Ctrl+C to quit\n", argv[optind]);
+
+  sigwait(&oSignals, &iSignal);
+  poServer->getStats(&oStats);
+  delete poServer;                                                              // writes the buffered data
+  printf("%u requests (%u failed, %u invalid, %u replies dropped), %llu bytes read, %llu written\n",
+         oStats.u32Requests, oStats.u32Failed, oStats.u32Invalid, oStats.u32TxDropped,
+         (unsigned long long)oStats.u64Read, (unsigned long long)oStats.u64Written);
+  return 0;
+}
+
+//******************************************************************************
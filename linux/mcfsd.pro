@@ -0,0 +1,34 @@
+TEMPLATE = app
+TARGET = mcfsd
+CONFIG += console
+CONFIG -= qt \
+    app_bundle
+HEADERS += CMcfsFile.h \
+    CMcfsServer.h \
+    CMccClock.h \
+    CMccTransport.h \
+    CMccTransportMcc.h \
+    CMccTransportSocket.h \
+    ../common/easyduo_mcc_common.h \
+    ../common/easyduo_mcfs_common.h
+SOURCES += CMcfsFile.cpp \
+    CMcfsServer.cpp \
+    CMccClock.cpp \
+    CMccTransport.cpp \
+    CMccTransportMcc.cpp \
+    CMccTransportSocket.cpp \
+    mcfsd.cpp
+LIBS += -lmcc \
+    -lpthread \
+    -lrt
+# host build against the M4 simulator (qmake CONFIG+=mccsim, see ../sim)
+mccsim {
+    DEFINES += CMCC_TRANSPORT_SOCKET_ONLY
+    INCLUDEPATH += ../sim/include
+    HEADERS -= CMccTransportMcc.h
+    SOURCES -= CMccTransportMcc.cpp
+    LIBS -= -lmcc
+}
+# make install
+target.path = /usr/bin
+INSTALLS += target
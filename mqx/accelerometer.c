@@ -28,9 +28,16 @@
  ******************************************************************************/
 
 #include "accelerometer.h"
+#include "eventlog.h"
+#include "vibration.h"
+#include "history.h"
 #include "i2cs.h"
+#include "mma845x_events.h"
+#include "mma845x_fifo.h"
+#include "timebase.h"
 
 #include "esl_appctrl.h"
+#include "esl_gpio.h"
 #include "esl_i2c.h"
 #include "esl_i2c_MMA845xQ.h"
 #include "esl_log.h"
@@ -45,42 +52,321 @@
 // General Definitions
 //******************************************************************************
 
-#define ACCEL_PERIODIC_INTERVAL         (25)                                    //!< Readout period in milliseconds.
-#define ACCEL_INFINITE_INTERVAL         (0)                                     //!< Infinite wait period.
-#define ACCEL_MAX_MISSED_CNT            ((int)(10 * 40))                        //!< Number of missed readouts before switching to standby mode (10 seconds, 40 Hz, see ACCEL_PERIODIC_INTERVAL).
+#define ACCEL_PERIODIC_INTERVAL         (25)                                    //!< Readout period in milliseconds without the FIFO.
+#define ACCEL_STANDBY_INTERVAL          (500)                                   //!< Period of checking the snapshot readers in standby mode in milliseconds.
+#define ACCEL_STANDBY_TIMEOUT           (10000)                                 //!< Time in milliseconds without any reader before switching to standby mode.
 #define ACCEL_LWSEM_WAIT                (10)                                    //!< Maximum number of milliseconds to wait for the semaphore.
+#define ACCEL_SNAPSHOT_RETRIES          (8)                                     //!< Attempts to read a consistent snapshot before giving up.
+
+/** @def ACCEL_DATA_RATE
+ * @brief Output data rate, ESL_I2C_MMA845XQ_CTRL_REG1_DR_VAL_*. Rates above
+ *        ACCEL_PERIODIC_INTERVAL lose samples without the FIFO. */
+#ifndef ACCEL_DATA_RATE
+# define ACCEL_DATA_RATE                ESL_I2C_MMA845XQ_CTRL_REG1_DR_VAL_50
+#endif
+
+/** @def ACCEL_FIFO_ENABLE
+ * @brief Set 1 to drain the FIFO of the MMA8451Q by burst reads, 0 to read
+ *        one sample per ACCEL_PERIODIC_INTERVAL. The other types have no FIFO
+ *        and are always read one sample at a time. */
+#ifndef ACCEL_FIFO_ENABLE
+# define ACCEL_FIFO_ENABLE              (1)
+#endif
+
+#define ACCEL_FIFO_WATERMARK            (MMA845X_FIFO_SIZE / 2)                 //!< Samples expected in the FIFO at each readout, the rest is the margin for a late one.
+#define ACCEL_FIFO_MIN_INTERVAL         (10)                                    //!< Shortest FIFO readout period in milliseconds.
+#define ACCEL_FIFO_MAX_INTERVAL         (100)                                   //!< Longest FIFO readout period in milliseconds (latency of the snapshot at low rates).
+#define ACCEL_FIFO_TIME_GAIN            (8)                                     //!< The sample times follow the readout times by 1/ACCEL_FIFO_TIME_GAIN of the difference.
+
+/** @def ACCEL_INT_ENABLE
+ * @brief Set 1 to read the samples on the data ready or FIFO watermark
+ *        interrupt of ACCEL_MMA845xQ_INT_PIN (see i2cs.h), 0 to read them by
+ *        the timer. Enabled by default where the pin is defined. */
+#ifndef ACCEL_INT_ENABLE
+# ifdef ACCEL_MMA845xQ_INT_PIN
+#   define ACCEL_INT_ENABLE             (1)
+# else
+#   define ACCEL_INT_ENABLE             (0)
+# endif
+#endif
+
+/** Watermark of the FIFO interrupt readouts with the output data period p in
+ *  microseconds: a readout per sample up to 100 Hz, one per
+ *  ACCEL_FIFO_MIN_INTERVAL above. */
+#define ACCEL_INT_WATERMARK(p)          (MIN(MAX(ACCEL_FIFO_MIN_INTERVAL * 1000 / (p), 1), ACCEL_FIFO_WATERMARK))
+#define ACCEL_INT_WATCHDOG              (2)                                     //!< Readout periods without an interrupt before the data is read anyway.
+
+#define ACCEL_CONFIG_MAX_RANGE          (8)                                     //!< Widest full-scale range in g.
+
+/** @def BSP_SHARED_SNAPSHOT
+ * @brief Shared memory region of the TMccAccelSnapshot (provided by the host
+ *        simulator BSP, a fixed on-chip address otherwise). */
+#ifndef BSP_SHARED_SNAPSHOT
+# define BSP_SHARED_SNAPSHOT            ((void*)MCC_SNAPSHOT_ADDRESS)
+#endif
 
 //******************************************************************************
 // Lwevent communication interface
 //******************************************************************************
 
 #define EVENT_Accel_Wakeup                  (1 << 0)                            //!< Event to wakeup from standby.
-#define EVENT_Accel_Mask                    (EVENT_Accel_Wakeup)                //!< Mask of all events.
+#define EVENT_Accel_Data                    (1 << 1)                            //!< Data ready or FIFO watermark interrupt.
+#define EVENT_Accel_Config                  (1 << 2)                            //!< Settings change requested (g_oConfigReq).
+/** Mask of all events. */
+#define EVENT_Accel_Mask                    (EVENT_Accel_Wakeup | EVENT_Accel_Data | EVENT_Accel_Config)
+
+#define EVENT_Accel_ConfigDone              (1 << 0)                            //!< Settings change applied (g_lweventConfig).
+
+//******************************************************************************
+// Acquisition modes
+//******************************************************************************
+
+enum {
+  ACCEL_MODE_POLL                 = 0,                                          //!< One sample per ACCEL_PERIODIC_INTERVAL.
+  ACCEL_MODE_FIFO,                                                              //!< FIFO drained by the timer, see ACCEL_FIFO_WATERMARK.
+  ACCEL_MODE_DRDY,                                                              //!< One sample per data ready interrupt.
+  ACCEL_MODE_FIFO_INT,                                                          //!< FIFO drained on its watermark interrupt, see ACCEL_INT_WATERMARK.
+};
+
+//******************************************************************************
+// Private types
+//******************************************************************************
+
+/** Sample timing of the FIFO and data ready readouts. The samples come at
+ *  the output data rate, their times are extrapolated from the previous
+ *  readout and pulled slowly towards the readout times, which absorbs the
+ *  readout jitter and the drift of the sensor oscillator. */
+typedef struct t_accel_timing_struct {
+  uint32_t          u32PeriodUs;                                                //!< Output data period in microseconds.
+  uint32_t          u32LastUs;                                                  //!< Time of the last sample read.
+  boolean           bSynced;                                                    //!< u32LastUs is valid.
+  uint32_t          u32Overflows;                                               //!< Number of readouts that found the FIFO overflowed.
+} TAccelTiming;
+
+/** Settings change passed from accel_setConfig() or accel_setEvents() to the
+ *  task. */
+typedef struct t_accel_config_req_struct {
+  TMccAccelConfig   oConfig;                                                    //!< Requested settings.
+  uint32_t          u32Set;                                                     //!< MCC_ACCEL_SET_* bits of the oConfig settings to change.
+  TMccAccelEvents   oEvents;                                                    //!< Requested event detection, if bEvents.
+  boolean           bEvents;                                                    //!< Replace the event detection by oEvents.
+  uint32_t          u32Seq;                                                     //!< Number of the last request.
+  uint32_t          u32Done;                                                    //!< Number of the last request applied.
+  uint_8            u8Result;                                                   //!< ACCEL_OK or ACCEL_DEVICE_FAILURE of the request u32Done.
+} TAccelConfigReq;
+
+/** Vibration features change passed from accel_setFeatures() to the task,
+ *  taken at the next readout. */
+typedef struct t_accel_features_req_struct {
+  TMccAccelFeatures oFeatures;                                                  //!< Requested features, validated.
+  volatile uint32_t u32Seq;                                                     //!< Number of the last request.
+  uint32_t          u32Done;                                                    //!< Number of the last request taken (accel_task only).
+} TAccelFeaturesReq;
 
 //******************************************************************************
 // Globals
 //******************************************************************************
 
 static LWEVENT_STRUCT g_lwevent;                                                //!< Controls the periodic readouts.
-static LWSEM_STRUCT   g_lwsem;                                                  //!< Guards exclusive access to g_oAccelData and g_u32MissedCnt.
+static LWSEM_STRUCT   g_lwsem;                                                  //!< Guards exclusive access to the settings below.
+static LWSEM_STRUCT   g_lwsemConfig;                                            //!< Serializes the accel_setConfig() callers.
+static LWEVENT_STRUCT g_lweventConfig;                                          //!< Signals the settings changes applied.
+static TAccelConfigReq g_oConfigReq;                                            //!< Settings change requested.
+static TMccAccelConfig g_oConfig;                                               //!< Settings in effect.
 static int32_t        g_i32DeviceId;                                            //!< Accelerometer device ID.
-static TAccelData     g_oAccelData;                                             //!< Accelerometer data.
-static uint32_t       g_u32MissedCnt;                                           //!< Missed readouts count.
+static volatile TMccAccelSnapshot * g_poSnapshot;                               //!< Last measured data, shared with the A5 (seqlock, see TMccAccelSnapshot).
+static TMccAccelSnapshot g_oLocalSnapshot;                                      //!< Used instead of the shared region if that is not available.
+static THistory       g_oHistory;                                               //!< Last measured samples (lock-free, accel_task writes).
+static uint32_t       g_u32MissedMs;                                            //!< Time of the readouts no one read since (accel_task only).
+static uint32_t       g_u32ReadoutMs;                                           //!< Readout period in milliseconds (accel_task only).
+static uint32_t       g_u32ReadCnt;                                             //!< Last seen TMccAccelSnapshot::u32ReadCnt.
+static TTimebase      g_oTimebase;                                              //!< Time base of the readout times (accel_task only).
+static TMccAccelScale g_oScale;                                                 //!< Conversion of the raw counts, set before the task init is done.
+static TMccAccelScale g_oScaleOld;                                              //!< Conversion of the raw counts measured before g_u32ScaleFirst.
+static uint32_t       g_u32ScaleFirst;                                          //!< Timestamp of the first sample converted by g_oScale.
+static TAccelTiming   g_oTiming;                                                //!< Sample timing (accel_task only).
+static TAccelData     g_aoBatch[MMA845X_FIFO_SIZE];                             //!< Samples of one FIFO readout (accel_task only).
+static TAccelFeaturesReq g_oFeaturesReq;                                        //!< Vibration features requested (guarded by g_lwsem but u32Done).
+static TVibration      g_oVibration;                                            //!< Window and FFT state of the vibration features (accel_task only).
+static TMccAccelSummaryMsg g_oSummary;                                          //!< Summary being composed (accel_task only).
+static TVibrationQueue g_oSummaries;                                            //!< Last summaries computed (lock-free, accel_task writes).
+static TMccAccelEvents g_oEvents;                                               //!< Event detection in effect (guarded by g_lwsem).
+static TMccAccelEvents g_oEventsSet;                                            //!< Event detection requested, encoded again for a new rate (accel_task only).
+static TMma845xEvents  g_oEventRegs;                                            //!< Registers of the event detection in effect (accel_task only).
+static TEventLog       g_oEventLog;                                             //!< Last events read (lock-free, accel_task writes).
+#if ACCEL_INT_ENABLE
+static LWGPIO_STRUCT  g_lwInt;                                                  //!< Accelerometer interrupt input.
+#endif
 
 //******************************************************************************
 // Functions declarations
 //******************************************************************************
 
-/** Saves the last measured accelerometer data, guarded by a semaphore.
- * @param[in]   poSrc         Source data to store to the global variable.
- * @param[in]   u32WaitTicks  Semaphore wait timeout ticks. Use 0 for infinity.
+/** Saves the samples of one readout to the history and publishes the last
+ *  one to the snapshot.
+ * @param[in]   paoSrc        Samples with consecutive timestamps, the oldest
+ *                            first.
+ * @param[in]   u32Cnt        Number of samples in paoSrc, at least 1.
  * @return      ACCEL_OK on success.
- *              ACCEL_LWSEM_FAILURE if waiting for semaphore fails.
- *              ACCEL_OUTDATED if too many readouts have been missed by
- *              consumer(s) (see ACCEL_MAX_MISSED_CNT). The module should switch
- *              to the standby mode. */
-static uint_8 accel_setLastData (const TAccelData   * poSrc,
-                                 uint_32              u32WaitTicks);
+ *              ACCEL_OUTDATED if no consumer read the data for too long
+ *              (see ACCEL_STANDBY_TIMEOUT). The module should switch to the
+ *              standby mode. */
+static uint_8 accel_setLastData (const TAccelData   * paoSrc,
+                                 uint32_t             u32Cnt);
+
+/** Takes a vibration features change requested and collects the samples of
+ *  one readout into the windows, each full one summarized and published in
+ *  g_oSummaries (accel_task only).
+ * @param[in]   paoSrc        Samples with consecutive timestamps, the oldest
+ *                            first.
+ * @param[in]   u32Cnt        Number of samples in paoSrc. */
+static void accel_summarize (const TAccelData   * paoSrc,
+                             uint32_t             u32Cnt);
+
+/** Reads the events detected by the sensor, times them by the samples read
+ *  so far and publishes them in g_oEventLog.
+ * @param[in]   hAccelDevice  Accelerometer device with a detection set.
+ * @param[in]   u32Timestamp  Timestamp of the newest sample read.
+ * @param[in]   u32AgeUs      Expected age of the events at the call: 0 right
+ *                            after the interrupt, half the readout period for
+ *                            a readout by the timer.
+ * @param[out]  pu8IntSource  INT_SOURCE value read.
+ * @return      ESL_I2C_OK on success, an ESL_I2C_* error otherwise. */
+static uint_8 accel_readEvents (ESL_I2C_MMA845XQ_TDevice * hAccelDevice,
+                                uint32_t                   u32Timestamp,
+                                uint32_t                   u32AgeUs,
+                                uint_8                   * pu8IntSource);
+
+/** Drains the FIFO to g_aoBatch, numbering the samples from the timestamp
+ *  of the previous one and timing them by accel_trackTime().
+ * @param[in]   hAccelDevice  Accelerometer device with the FIFO enabled.
+ * @param[in]   u32Timestamp  Timestamp of the previous sample.
+ * @param[in]   u32AgeUs      Expected age of the newest sample at the call:
+ *                            0 right after the watermark interrupt, half the
+ *                            period for a readout by the timer.
+ * @param[out]  pu32Cnt       Number of samples stored to g_aoBatch.
+ * @return      ESL_I2C_OK on success, an ESL_I2C_* error otherwise. */
+static uint_8 accel_readFifo (ESL_I2C_MMA845XQ_TDevice * hAccelDevice,
+                              uint32_t                   u32Timestamp,
+                              uint32_t                   u32AgeUs,
+                              uint32_t                 * pu32Cnt);
+
+/** Times the newest sample of a readout by g_oTiming.
+ * @param[in]   u32NowUs      Readout time less the expected age of the newest
+ *                            sample.
+ * @param[in]   u32Cnt        Number of samples read, 0 for one data ready
+ *                            sample (those missed in between are counted by
+ *                            the time).
+ * @param[in]   bLost         TRUE if samples were lost since the previous
+ *                            readout (FIFO overflow).
+ * @return      Time of the newest sample, the older ones follow by the
+ *              output data period. */
+static uint32_t accel_trackTime (uint32_t u32NowUs, uint32_t u32Cnt, boolean bLost);
+
+/** Computes the readout period of an acquisition mode, also the time the
+ *  readouts count towards ACCEL_STANDBY_TIMEOUT.
+ * @param[in]   u8Mode        ACCEL_MODE_* value.
+ * @param[in]   u32PeriodUs   Output data period in microseconds.
+ * @return      Readout period in milliseconds. */
+static uint32_t accel_readoutMs (uint_8 u8Mode, uint32_t u32PeriodUs);
+
+#if ACCEL_INT_ENABLE
+/** Sets the ACCEL_MMA845xQ_INT_PIN interrupt up and routes the data ready or
+ *  FIFO interrupt of the accelerometer (in standby) to it, active low.
+ * @param[in]   hAccelDevice  Accelerometer device.
+ * @param[in]   poConfig      Accelerometer configuration, the interrupt
+ *                            settings are added to it.
+ * @param[in]   bFifo         TRUE for the FIFO interrupt, FALSE for data
+ *                            ready.
+ * @return      ESL_I2C_OK on success, ESL_GPIO_* or ESL_I2C_* error code
+ *              otherwise. */
+static uint_32 accel_intInit (ESL_I2C_MMA845XQ_TDevice * hAccelDevice,
+                              ESL_I2C_MMA845XQ_TConfig * poConfig,
+                              boolean                    bFifo);
+
+/** Interrupt service routine of ACCEL_MMA845xQ_INT_PIN.
+ * @param[in]   pvArg         Pin handle (g_lwInt). */
+static void accel_isr (void * pvArg);
+#endif
+
+/** Finds the output data rate of the sensor nearest to the requested one.
+ * @param[in]   u32RateMilliHz  Requested rate in millihertz, not zero.
+ * @return      CTRL_REG1 DR field value (0 for 800 Hz to 7 for 1.56 Hz). */
+static uint_8 accel_rateCode (uint32_t u32RateMilliHz);
+
+/** Changes the accelerometer configuration by the requested settings.
+ * @param[in]   poReq         Requested settings, validated.
+ * @param[in]   u32Set        MCC_ACCEL_SET_* bits of the settings to change.
+ * @param[out]  poConfig      Accelerometer configuration to modify. */
+static void accel_encodeConfig (const TMccAccelConfig    * poReq,
+                                uint32_t                   u32Set,
+                                ESL_I2C_MMA845XQ_TConfig * poConfig);
+
+/** Describes the settings in effect of an accelerometer configuration.
+ * @param[in]   poConfig      Accelerometer configuration.
+ * @param[out]  poDst         Destination of the settings. */
+static void accel_decodeConfig (const ESL_I2C_MMA845XQ_TConfig * poConfig,
+                                TMccAccelConfig                * poDst);
+
+/** Applies the g_oConfigReq settings change (accel_task only): reconfigures
+ *  the sensor, updates g_oConfig, g_oEvents, g_oScale and g_oTiming and
+ *  signals the requester.
+ * @param[in]   hAccelDevice  Accelerometer device.
+ * @param[in]   poConfig      Configuration applied, changed on success.
+ * @param[in]   u8Mode        ACCEL_MODE_* acquisition mode. */
+static void accel_serveConfig (ESL_I2C_MMA845XQ_TDevice * hAccelDevice,
+                               ESL_I2C_MMA845XQ_TConfig * poConfig,
+                               uint_8                     u8Mode);
+
+/** Puts the sensor in STANDBY, writes a configuration and the event detection,
+ *  flushes the FIFO and sets its watermark by the new output data rate, and
+ *  activates the sensor.
+ * @param[in]   hAccelDevice  Accelerometer device.
+ * @param[in]   poConfig      Configuration to write, with the interrupts of
+ *                            the events.
+ * @param[in]   poEvents      Event detection registers to write.
+ * @param[in]   u8Mode        ACCEL_MODE_* acquisition mode.
+ * @return      ESL_I2C_OK on success, an ESL_I2C_* error otherwise. */
+static uint_8 accel_applyConfig (ESL_I2C_MMA845XQ_TDevice       * hAccelDevice,
+                                 const ESL_I2C_MMA845XQ_TConfig * poConfig,
+                                 const TMma845xEvents           * poEvents,
+                                 uint_8                           u8Mode);
+
+/** Passes a settings or event detection change to the task and waits for it
+ *  to be applied, one change at a time.
+ * @param[in]   poConfig      Requested settings, NULL if none.
+ * @param[in]   u32Set        MCC_ACCEL_SET_* bits of the poConfig settings to
+ *                            change.
+ * @param[in]   poEvents      Requested event detection, NULL to keep it.
+ * @param[in]   u32WaitTicks  As in accel_setConfig().
+ * @return      As accel_setConfig(). */
+static uint_8 accel_request (const TMccAccelConfig  * poConfig,
+                             uint32_t                 u32Set,
+                             const TMccAccelEvents  * poEvents,
+                             uint_32                  u32WaitTicks);
+
+/** Computes the conversion of the raw counts to g.
+ * @param[in]   poConfig      Accelerometer configuration applied.
+ * @param[in]   i32DeviceId   Accelerometer type (ACCEL_TYPE_*).
+ * @param[out]  poScale       Destination of the conversion. */
+static void accel_computeScale (const ESL_I2C_MMA845XQ_TConfig * poConfig,
+                                int32_t                          i32DeviceId,
+                                TMccAccelScale                 * poScale);
+
+/** Publishes the data to the shared snapshot (the only writer).
+ * @param[in]   poSrc         Data to publish.
+ * @param[in]   u32Flags      MCC_SNAPSHOT_FLAG_* bits. */
+static void accel_writeSnapshot (const TAccelData   * poSrc,
+                                 uint32_t             u32Flags);
+
+/** Checks whether the A5 read the shared snapshot since the last call.
+ * @return      TRUE if it did. */
+static boolean accel_snapshotRead (void);
+
+/** Records a read of the last measured data by an M4 task, like the A5
+ *  readers do, and wakes the module up if it is in the standby mode.
+ * @return      ACCEL_OK, or ACCEL_OUTDATED if the module was in standby. */
+static uint_8 accel_markRead (void);
 
 //******************************************************************************
 //******************************************************************************
@@ -93,6 +379,15 @@ void accel_task (uint32_t u32InitialData)
   int_16                    ai16Data[3];
   TAccelData                oAccelData;
   _mqx_uint                 uEventWaitTicks;
+  _mqx_uint                 uReadoutTicks;
+  _mqx_uint                 uSignalled;
+  boolean                   bStandby;
+  boolean                   bInt;
+  uint_8                    u8Mode;
+  uint32_t                  u32PeriodUs;
+  uint32_t                  u32IntMissed = 0;
+  uint32_t                  u32Cnt;
+  uint_8                    u8IntSource;
   uint_32                   ret;
 
   // Lwevent initialization ----------------------------------------------------
@@ -109,16 +404,44 @@ void accel_task (uint32_t u32InitialData)
     ESL_APPCTRL_INITDONE(u32InitialData, ACCEL_LWSEM_FAILURE);
   }
 
+  // Settings change initialization -------------------------------------------
+  ret = _lwsem_create(&g_lwsemConfig, 1);
+  if (MQX_OK != ret) {
+    LOGE_FORMATTED ("_lwsem_create failed: %d", ret);
+    ESL_APPCTRL_INITDONE(u32InitialData, ACCEL_LWSEM_FAILURE);
+  }
+  ret = _lwevent_create(&g_lweventConfig, LWEVENT_AUTO_CLEAR);
+  if (MQX_OK != ret) {
+    LOGE_FORMATTED ("_lwevent_create failed: %d", ret);
+    ESL_APPCTRL_INITDONE(u32InitialData, ACCEL_LWEVENT_FAILURE);
+  }
+
+  // Shared snapshot initialization --------------------------------------------
+  g_poSnapshot = (volatile TMccAccelSnapshot*)BSP_SHARED_SNAPSHOT;
+  if (!g_poSnapshot) {
+    LOGW_STR("shared snapshot not available");
+    g_poSnapshot = &g_oLocalSnapshot;
+  }
+  g_poSnapshot->u32Magic = 0;
+  g_poSnapshot->u32Seq   = 0;
+  g_u32ReadCnt = g_poSnapshot->u32ReadCnt;
+
   // Data storage initialization -----------------------------------------------
   oAccelData.afData[0]    = 0.0f;
   oAccelData.afData[1]    = 0.0f;
   oAccelData.afData[2]    = 0.0f;
+  oAccelData.ai16Raw[0]   = 0;
+  oAccelData.ai16Raw[1]   = 0;
+  oAccelData.ai16Raw[2]   = 0;
   oAccelData.u32Timestamp = 0;
-  ret = accel_setLastData (&oAccelData, 0);
-  if (ACCEL_OK != ret) {
-    LOGE_FORMATTED("accel_setLastData failed: %d", ret);
-    ESL_APPCTRL_INITDONE(u32InitialData, ret);
-  }
+  oAccelData.u32TimeUs    = timebase_getUs(&g_oTimebase);
+  history_init(&g_oHistory, &oAccelData);
+  vibration_init(&g_oVibration);
+  vibration_initQueue(&g_oSummaries);
+  eventlog_init(&g_oEventLog);
+  accel_writeSnapshot(&oAccelData, 0);
+  MCC_SNAPSHOT_BARRIER();
+  g_poSnapshot->u32Magic = MCC_SNAPSHOT_MAGIC;
 
   // Accelerometer initialization ----------------------------------------------
   // get default accelerometer configuration
@@ -128,9 +451,9 @@ void accel_task (uint32_t u32InitialData)
     ESL_APPCTRL_INITDONE(u32InitialData, ret);
   }
 
-  // change the configuration: set Output Data Rate to 50 Hz
+  // change the configuration: set Output Data Rate (50 Hz by default)
   oAccelConfig.u8CtrlReg1 &= ~ESL_I2C_MMA845XQ_CTRL_REG1_DR_MASK;
-  oAccelConfig.u8CtrlReg1 |=  ESL_I2C_MMA845XQ_CTRL_REG1_DR_VAL_50;
+  oAccelConfig.u8CtrlReg1 |=  ACCEL_DATA_RATE;
   // change the configuration: reduce Noise (limits Dynamic Range to 4g!)
   oAccelConfig.u8CtrlReg1 |=  ESL_I2C_MMA845XQ_CTRL_REG1_LNOISE_MASK;
   // change the configuration: set High Resolution mode (high oversampling -> low noise)
@@ -161,6 +484,39 @@ void accel_task (uint32_t u32InitialData)
   } else {
     g_i32DeviceId = ACCEL_TYPE_UNKNOWN;
   }
+  accel_computeScale(&oAccelConfig, g_i32DeviceId, &g_oScale);
+  g_oScaleOld = g_oScale;
+
+  // enable the FIFO (MMA8451Q only), the readouts follow its watermark
+  u32PeriodUs = mma845x_periodUs(&oAccelConfig);
+  g_oTiming.u32PeriodUs = u32PeriodUs;
+  u8Mode = ACCEL_MODE_POLL;
+  if (ACCEL_FIFO_ENABLE && (ACCEL_TYPE_MMA8451Q == g_i32DeviceId)) {
+    ret = mma845x_fifoSetup (&hAccelDevice, MMA845X_F_SETUP_F_MODE_CIRCULAR,
+                             ACCEL_INT_ENABLE ? ACCEL_INT_WATERMARK(u32PeriodUs) : ACCEL_FIFO_WATERMARK);
+    if (ESL_I2C_OK == ret) {
+      u8Mode = ACCEL_MODE_FIFO;
+    } else {
+      LOGW_FORMATTED("mma845x_fifoSetup failed: %d", ret);
+    }
+  }
+
+  // read on the data ready or FIFO interrupt if its pin is wired
+  bInt = FALSE;
+#if ACCEL_INT_ENABLE
+  ret = accel_intInit (&hAccelDevice, &oAccelConfig, (ACCEL_MODE_FIFO == u8Mode) ? TRUE : FALSE);
+  if (ESL_I2C_OK == ret) {
+    u8Mode = (ACCEL_MODE_FIFO == u8Mode) ? ACCEL_MODE_FIFO_INT : ACCEL_MODE_DRDY;
+    bInt = TRUE;
+  } else {
+    LOGW_FORMATTED("accel_intInit failed: %d", ret);
+  }
+#endif
+  accel_decodeConfig(&oAccelConfig, &g_oConfig);
+  g_u32ReadoutMs = accel_readoutMs(u8Mode, u32PeriodUs);
+  uReadoutTicks  = bInt ? MSECS_TO_MQX_TICKS(ACCEL_INT_WATCHDOG * g_u32ReadoutMs) + 1   // watchdog of the interrupts
+                        : MSECS_TO_MQX_TICKS(g_u32ReadoutMs);
+  LOGI_FORMATTED("Accel: mode %u, readout every %u ms", u8Mode, g_u32ReadoutMs);
 
   // activate the device
   ret = esl_i2c_MMA845xQ_activate (&hAccelDevice);
@@ -172,43 +528,112 @@ void accel_task (uint32_t u32InitialData)
   ESL_APPCTRL_INITDONE(u32InitialData, MQX_OK);
 
   // Infinite loop -------------------------------------------------------------
-  uEventWaitTicks = MSECS_TO_MQX_TICKS(ACCEL_PERIODIC_INTERVAL);
+  uEventWaitTicks = uReadoutTicks;
+  bStandby = FALSE;
   while (1) {
     // Wait for an event
     ret = _lwevent_wait_ticks(&g_lwevent,
-                              EVENT_Accel_Wakeup,
+                              EVENT_Accel_Mask,
                               FALSE,
                               uEventWaitTicks);
-    if (MQX_OK == ret) {                                                        // WAKEUP event received
-      uEventWaitTicks = MSECS_TO_MQX_TICKS(ACCEL_PERIODIC_INTERVAL);
+    uSignalled = (MQX_OK == ret) ? _lwevent_get_signalled() : 0;
+    if (uSignalled & EVENT_Accel_Config) {                                      // new settings, then read as usual
+      accel_serveConfig (&hAccelDevice, &oAccelConfig, u8Mode);
+      u32PeriodUs    = g_oTiming.u32PeriodUs;
+      g_u32ReadoutMs = accel_readoutMs(u8Mode, u32PeriodUs);
+      uReadoutTicks  = bInt ? MSECS_TO_MQX_TICKS(ACCEL_INT_WATCHDOG * g_u32ReadoutMs) + 1
+                            : MSECS_TO_MQX_TICKS(g_u32ReadoutMs);
+      if (!bStandby) uEventWaitTicks = uReadoutTicks;
+    }
+    if ((uSignalled & EVENT_Accel_Wakeup) || (bStandby && accel_snapshotRead())) { // WAKEUP event received or snapshot read by the A5
+      uEventWaitTicks = uReadoutTicks;
+      bStandby = FALSE;
+      g_u32MissedMs = 0;
+      vibration_restart(&g_oVibration);                                         // a window spans consecutive samples
+#if ACCEL_INT_ENABLE
+      if (bInt) lwgpio_int_enable(&g_lwInt, TRUE);
+#endif
       LOGI_FORMATTED("Accel: Switching to READY");
-    } else if (LWEVENT_WAIT_TIMEOUT != ret) {                                   // error occured
+    } else if ((MQX_OK != ret) && (LWEVENT_WAIT_TIMEOUT != ret)) {              // error occured
       LOGW_FORMATTED("_lwevent_wait_ticks failed: %d", ret);
       continue;
+    } else if (bStandby) {                                                      // nobody interested in the data
+      continue;
+    } else if (bInt && !(uSignalled & (EVENT_Accel_Data | EVENT_Accel_Config))) { // interrupt missed, read anyway
+      if (!(u32IntMissed++ & 0xFF)) {
+        LOGW_FORMATTED("Accel: no interrupt within %u ms (%u times)",
+                       ACCEL_INT_WATCHDOG * g_u32ReadoutMs, u32IntMissed);
+      }
     }
 
-    // wait timeout occured or WAKEUP event received -> get new data
+    // interrupt, wait timeout or WAKEUP event -> get new data
 
-    ret = esl_i2c_MMA845xQ_getRawData (ai16Data, &hAccelDevice);
-    if (ESL_I2C_OK == ret) {
+    if (g_oEventRegs.u8IntEn) {                                                 // the events first, timed by the samples read so far
+      ret = accel_readEvents (&hAccelDevice, oAccelData.u32Timestamp,
+                              (uSignalled & EVENT_Accel_Data) ? 0 : g_u32ReadoutMs * 1000 / 2, &u8IntSource);
+      if (ESL_I2C_OK != ret) {
+        LOGW_FORMATTED("accel_readEvents failed: %d", ret);
+      }
+#if ACCEL_INT_ENABLE
+      else if (bInt && (uSignalled & EVENT_Accel_Data)
+               && !(u8IntSource & (MMA845X_INT_SOURCE_FIFO_MASK | MMA845X_INT_SOURCE_DRDY_MASK))) {
+        // an event interrupt only, the samples interrupt by themselves
+        if (LWGPIO_VALUE_LOW == lwgpio_get_value(&g_lwInt)) _lwevent_set(&g_lwevent, EVENT_Accel_Data);
+        continue;
+      }
+#endif
+    }
+
+    if ((ACCEL_MODE_FIFO == u8Mode) || (ACCEL_MODE_FIFO_INT == u8Mode)) {
+      ret = accel_readFifo (&hAccelDevice, oAccelData.u32Timestamp,
+                            (uSignalled & EVENT_Accel_Data) ? 0 : u32PeriodUs / 2, &u32Cnt);
+      if (ESL_I2C_OK != ret) {
+        LOGW_FORMATTED("accel_readFifo failed: %d", ret);
+        continue;
+      }
+      if (!u32Cnt) continue;
+      oAccelData.u32Timestamp = g_aoBatch[u32Cnt-1].u32Timestamp;
+      ret = accel_setLastData (g_aoBatch, u32Cnt);
+    } else {
+      oAccelData.u32TimeUs = timebase_getUs(&g_oTimebase);
+      ret = esl_i2c_MMA845xQ_getRawData (ai16Data, &hAccelDevice);
+      if (ESL_I2C_MMA845XQ_DATA_NOT_READY == ret) {
+        continue;
+      } else if (ESL_I2C_OK != ret) {
+        LOGW_FORMATTED("esl_i2c_MMA845xQ_getRawData failed: %d", ret);
+        continue;
+      }
+      if (ACCEL_MODE_DRDY == u8Mode) {                                          // ready at the interrupt, or within the last period
+        oAccelData.u32TimeUs = accel_trackTime(oAccelData.u32TimeUs
+                                               - ((uSignalled & EVENT_Accel_Data) ? 0 : u32PeriodUs / 2), 0, FALSE);
+      }
       ret = esl_i2c_MMA845xQ_raw2g (oAccelData.afData, ai16Data, &hAccelDevice);
-      if (ESL_I2C_OK == ret) {
-        ++oAccelData.u32Timestamp;
-        ret = accel_setLastData (&oAccelData,
-                                 MSECS_TO_MQX_TICKS(ACCEL_LWSEM_WAIT));
-        if (ACCEL_OUTDATED == ret) {
-          uEventWaitTicks = ACCEL_INFINITE_INTERVAL;
-          LOGI_FORMATTED("Accel: Switching to STANDBY");
-        } else if (ACCEL_OK != ret) {
-          LOGW_FORMATTED("accel_setLastData failed: %d", ret);
-        }
-      } else {
-        LOGW_FORMATTED("esl_i2c_MMA845xQ_raw2int failed: %d", ret);
+      if (ESL_I2C_OK != ret) {
+        LOGW_FORMATTED("esl_i2c_MMA845xQ_raw2g failed: %d", ret);
+        continue;
       }
+      oAccelData.ai16Raw[0] = ai16Data[0];
+      oAccelData.ai16Raw[1] = ai16Data[1];
+      oAccelData.ai16Raw[2] = ai16Data[2];
+      ++oAccelData.u32Timestamp;
+      ret = accel_setLastData (&oAccelData, 1);
+    }
+
+    if (ACCEL_OUTDATED == ret) {
+      uEventWaitTicks = MSECS_TO_MQX_TICKS(ACCEL_STANDBY_INTERVAL);
+      bStandby = TRUE;
+#if ACCEL_INT_ENABLE
+      if (bInt) lwgpio_int_enable(&g_lwInt, FALSE);
+#endif
+      LOGI_FORMATTED("Accel: Switching to STANDBY");
+    }
 
-    } else if (ESL_I2C_MMA845XQ_DATA_NOT_READY != ret) {
-      LOGW_FORMATTED("esl_i2c_MMA845xQ_getRawData failed: %d", ret);
+#if ACCEL_INT_ENABLE
+    // the edge of a source pending since before the readout never comes
+    if (bInt && !bStandby && (LWGPIO_VALUE_LOW == lwgpio_get_value(&g_lwInt))) {
+      _lwevent_set(&g_lwevent, EVENT_Accel_Data);
     }
+#endif
   }
 }
 
@@ -224,58 +649,707 @@ int32_t accel_getIdentifier (void)
 uint_8 accel_getLastData (TAccelData  * poDst,
                           uint_32       u32WaitTicks)
 {
-  int ret;
+  uint32_t  u32Seq;
+  uint_32   u32Ticks = 0;
   assert(poDst);
 
-  // Retrieve the semaphore
+  // Seqlock read of the snapshot, the writer runs at a lower priority
+  while (1) {
+    u32Seq = g_poSnapshot->u32Seq;
+    if (!(u32Seq & 1)) {
+      MCC_SNAPSHOT_BARRIER();
+      poDst->u32Timestamp = g_poSnapshot->u32Timestamp;
+      poDst->afData[0]    = g_poSnapshot->afData[0];
+      poDst->afData[1]    = g_poSnapshot->afData[1];
+      poDst->afData[2]    = g_poSnapshot->afData[2];
+      poDst->u32TimeUs    = g_poSnapshot->u32TimeUs;
+      MCC_SNAPSHOT_BARRIER();
+      if (g_poSnapshot->u32Seq == u32Seq) break;
+    }
+    if (u32WaitTicks && (++u32Ticks > u32WaitTicks)) return ACCEL_BUSY;
+    _time_delay_ticks(1);                                                       // let the preempted writer finish
+  }
+
+  return accel_markRead();
+}
+
+//******************************************************************************
+
+uint_8 accel_getHistory (TMccAccelSample  * paoDst,
+                         uint32_t           u32MaxCnt,
+                         uint32_t           u32Since,
+                         uint32_t         * pu32Cnt,
+                         uint32_t         * pu32Lost,
+                         uint32_t         * pau32TimeUs)
+{
+  TAccelData  oSample;
+  uint32_t    u32Ts;
+  uint32_t    u32Cnt;
+  uint32_t    i;
+  assert(paoDst && pu32Cnt && pu32Lost);
+
+  u32Ts = history_window(history_newest(&g_oHistory), u32MaxCnt, u32Since, &u32Cnt, pu32Lost);
+  *pu32Cnt = 0;
+  for (i = 0; i < u32Cnt; ++i, ++u32Ts) {
+    if (!history_get(&g_oHistory, u32Ts, &oSample)) {                           // overwritten while reading
+      if (*pu32Cnt) break;                                                      // the writer went round, the rest is lost next time
+      ++*pu32Lost;
+      continue;
+    }
+    paoDst[*pu32Cnt].u32Timestamp = oSample.u32Timestamp;
+    paoDst[*pu32Cnt].afData[0]    = oSample.afData[0];
+    paoDst[*pu32Cnt].afData[1]    = oSample.afData[1];
+    paoDst[*pu32Cnt].afData[2]    = oSample.afData[2];
+    if (pau32TimeUs) pau32TimeUs[*pu32Cnt] = oSample.u32TimeUs;
+    ++*pu32Cnt;
+  }
+
+  return accel_markRead();
+}
+
+//******************************************************************************
+
+uint_8 accel_getRawHistory (int16_t          (* pai16Dst)[3],
+                            uint32_t           u32MaxCnt,
+                            uint32_t           u32Since,
+                            uint32_t         * pu32First,
+                            uint32_t         * pu32Cnt,
+                            uint32_t         * pu32Lost,
+                            uint32_t         * pau32TimeUs,
+                            TMccAccelScale   * poScale,
+                            uint_32            u32WaitTicks)
+{
+  TAccelData  oSample;
+  uint32_t    u32Ts;
+  uint32_t    u32Cnt;
+  uint32_t    i;
+  int         ret;
+  assert(pai16Dst && pu32First && pu32Cnt && pu32Lost && poScale);
+
+  u32Ts = history_window(history_newest(&g_oHistory), u32MaxCnt, u32Since, &u32Cnt, pu32Lost);
+  *pu32First = u32Ts;
+  *pu32Cnt   = 0;
+  for (i = 0; i < u32Cnt; ++i, ++u32Ts) {
+    if (!history_get(&g_oHistory, u32Ts, &oSample)) {                           // overwritten while reading
+      if (*pu32Cnt) break;                                                      // the writer went round, the rest is lost next time
+      ++*pu32Lost;
+      ++*pu32First;
+      continue;
+    }
+    pai16Dst[*pu32Cnt][0] = oSample.ai16Raw[0];
+    pai16Dst[*pu32Cnt][1] = oSample.ai16Raw[1];
+    pai16Dst[*pu32Cnt][2] = oSample.ai16Raw[2];
+    if (pau32TimeUs) pau32TimeUs[*pu32Cnt] = oSample.u32TimeUs;
+    ++*pu32Cnt;
+  }
+
+  // The scale after the samples: a range change published since applies to
+  // newer samples only
   ret = _lwsem_wait_ticks(&g_lwsem, u32WaitTicks);
   if (ret != MQX_OK) return ACCEL_LWSEM_FAILURE;
+  if (g_u32ScaleFirst - *pu32First - 1 < HISTORY_SIZE) {                        // measured before the range changed
+    *pu32Cnt = MIN(*pu32Cnt, g_u32ScaleFirst - *pu32First);
+    *poScale = g_oScaleOld;
+  } else {
+    *poScale = g_oScale;
+  }
+  _lwsem_post(&g_lwsem);
 
-  // CRITICIAL SECTION START //
+  return accel_markRead();
+}
 
-  *poDst = g_oAccelData;
-  if (g_u32MissedCnt >= ACCEL_MAX_MISSED_CNT) {
-    ret = ACCEL_OUTDATED;
-    _lwevent_set(&g_lwevent, EVENT_Accel_Wakeup);
-  } else {
-    ret = ACCEL_OK;
+//******************************************************************************
+
+void accel_getScale (TMccAccelScale * poScale)
+{
+  assert(poScale);
+  *poScale = g_oScale;
+}
+
+//******************************************************************************
+
+uint_8 accel_setConfig (const TMccAccelConfig  * poReq,
+                        uint32_t                 u32Set,
+                        uint_32                  u32WaitTicks)
+{
+  if (!poReq) return ACCEL_INVALID_ARGUMENT;
+  if (   ((u32Set & MCC_ACCEL_SET_RATE) && (   (poReq->u32RateMilliHz < MCC_ACCEL_RATE_MIN_MHZ)
+                                             || (poReq->u32RateMilliHz > MCC_ACCEL_RATE_MAX_MHZ)))
+      || ((u32Set & MCC_ACCEL_SET_RANGE) && (!poReq->u8RangeG || (poReq->u8RangeG > ACCEL_CONFIG_MAX_RANGE)))
+      || ((u32Set & MCC_ACCEL_SET_OVERSAMPLING) && (poReq->u8Oversampling > MCC_ACCEL_OS_LOW_POWER))
+      || ((u32Set & MCC_ACCEL_SET_LOW_NOISE) && (poReq->u8LowNoise > 1))) {
+    return ACCEL_INVALID_ARGUMENT;
   }
-  g_u32MissedCnt = 0;
 
+  return accel_request(poReq, u32Set, NULL, u32WaitTicks);
+}
+
+//******************************************************************************
+
+void accel_getConfig (TMccAccelConfig  * poConfig,
+                      uint32_t         * pu32PeriodUs)
+{
+  assert(poConfig);
+
+  // the task holds the semaphore only shortly, wait as long as it takes
+  _lwsem_wait_ticks(&g_lwsem, 0);
+  *poConfig = g_oConfig;
+  if (pu32PeriodUs) *pu32PeriodUs = g_oTiming.u32PeriodUs;
   _lwsem_post(&g_lwsem);
+}
 
-  // CRITICIAL SECTION END //
+//******************************************************************************
 
-  return ret;
+uint_8 accel_setFeatures (const TMccAccelFeatures  * poReq,
+                          uint_32                    u32WaitTicks)
+{
+  int ret;
+
+  if (!poReq || !vibration_check(poReq)) return ACCEL_INVALID_ARGUMENT;
+
+  ret = _lwsem_wait_ticks(&g_lwsem, u32WaitTicks);
+  if (ret != MQX_OK) return ACCEL_LWSEM_FAILURE;
+  g_oFeaturesReq.oFeatures = *poReq;
+  ++g_oFeaturesReq.u32Seq;
+  _lwsem_post(&g_lwsem);
+
+  accel_markRead();                                                             // the readouts resume if in standby
+  return ACCEL_OK;
+}
+
+//******************************************************************************
+
+void accel_getFeatures (TMccAccelFeatures * poFeatures)
+{
+  assert(poFeatures);
+
+  _lwsem_wait_ticks(&g_lwsem, 0);
+  *poFeatures = g_oFeaturesReq.oFeatures;
+  _lwsem_post(&g_lwsem);
+}
+
+//******************************************************************************
+
+boolean accel_getSummary (uint32_t               u32Since,
+                          TMccAccelSummaryMsg  * poDst)
+{
+  assert(poDst);
+
+  return vibration_get(&g_oSummaries, u32Since, poDst);
+}
+
+//******************************************************************************
+
+uint_8 accel_setEvents (const TMccAccelEvents  * poReq,
+                        uint_32                  u32WaitTicks)
+{
+  uint_8 u8Result;
+
+  if (!poReq || !mma845x_eventsCheck(poReq)) return ACCEL_INVALID_ARGUMENT;
+
+  u8Result = accel_request(NULL, 0, poReq, u32WaitTicks);
+  accel_markRead();                                                             // the readouts resume if in standby
+  return u8Result;
+}
+
+//******************************************************************************
+
+void accel_getEvents (TMccAccelEvents * poEvents)
+{
+  assert(poEvents);
+
+  _lwsem_wait_ticks(&g_lwsem, 0);
+  *poEvents = g_oEvents;
+  _lwsem_post(&g_lwsem);
+}
+
+//******************************************************************************
+
+uint32_t accel_lastEvent (void)
+{
+  return eventlog_newest(&g_oEventLog);
+}
+
+//******************************************************************************
+
+uint32_t accel_getEventLog (uint32_t           u32Since,
+                            TMccAccelEvent   * paoDst,
+                            uint32_t           u32MaxCnt,
+                            uint32_t         * pu32First,
+                            uint32_t         * pu32Lost)
+{
+  assert(paoDst && pu32First && pu32Lost);
+
+  return eventlog_read(&g_oEventLog, u32Since, paoDst, u32MaxCnt, pu32First, pu32Lost);
 }
 
 //******************************************************************************
 // Private functions
 //******************************************************************************
 
-static uint_8 accel_setLastData (const TAccelData   * poSrc,
-                                 uint_32              u32WaitTicks)
+static uint_8 accel_request (const TMccAccelConfig  * poConfig,
+                             uint32_t                 u32Set,
+                             const TMccAccelEvents  * poEvents,
+                             uint_32                  u32WaitTicks)
 {
-  int ret;
-  assert(poSrc);
+  uint32_t  u32Seq;
+  uint_8    u8Result;
+  int       ret;
 
-  // Retrieve the semaphore
-  ret = _lwsem_wait_ticks(&g_lwsem, u32WaitTicks);
+  // One change at a time
+  ret = _lwsem_wait_ticks(&g_lwsemConfig, u32WaitTicks);
   if (ret != MQX_OK) return ACCEL_LWSEM_FAILURE;
 
-  // CRITICIAL SECTION START //
+  ret = _lwsem_wait_ticks(&g_lwsem, u32WaitTicks);
+  if (ret != MQX_OK) {
+    _lwsem_post(&g_lwsemConfig);
+    return ACCEL_LWSEM_FAILURE;
+  }
+  if (poConfig) g_oConfigReq.oConfig = *poConfig;
+  g_oConfigReq.u32Set  = poConfig ? u32Set : 0;
+  g_oConfigReq.bEvents = poEvents ? TRUE : FALSE;
+  if (poEvents) g_oConfigReq.oEvents = *poEvents;
+  u32Seq = ++g_oConfigReq.u32Seq;
+  _lwsem_post(&g_lwsem);
+  _lwevent_set(&g_lwevent, EVENT_Accel_Config);
 
-  g_oAccelData = *poSrc;
-  if (g_u32MissedCnt >= ACCEL_MAX_MISSED_CNT) {
-    ret = ACCEL_OUTDATED;
+  // Wait for the task, a request of a previous caller given up may finish first
+  do {
+    ret = _lwevent_wait_ticks(&g_lweventConfig, EVENT_Accel_ConfigDone, FALSE, u32WaitTicks);
+    if (MQX_OK != ret) {
+      u8Result = (LWEVENT_WAIT_TIMEOUT == ret) ? ACCEL_BUSY : ACCEL_LWEVENT_FAILURE;
+      break;
+    }
+    u8Result = g_oConfigReq.u8Result;                                           // written before the event was set
+  } while (g_oConfigReq.u32Done != u32Seq);
+
+  _lwsem_post(&g_lwsemConfig);
+  return u8Result;
+}
+
+//******************************************************************************
+
+static uint_8 accel_rateCode (uint32_t u32RateMilliHz)
+{
+  static const uint32_t au32RateMilliHz[8] = {                                  // 800, 400, 200, 100, 50, 12.5, 6.25, 1.56 Hz
+    800000, 400000, 200000, 100000, 50000, 12500, 6250, 1563
+  };
+  uint_8 i;
+
+  // nearest by ratio: at or above the geometric mean of the rate and the next lower one
+  for (i = 0; i < 7; ++i) {
+    if ((uint64_t)u32RateMilliHz * u32RateMilliHz >= (uint64_t)au32RateMilliHz[i] * au32RateMilliHz[i+1]) break;
+  }
+  return i;
+}
+
+//******************************************************************************
+
+static void accel_encodeConfig (const TMccAccelConfig    * poReq,
+                                uint32_t                   u32Set,
+                                ESL_I2C_MMA845XQ_TConfig * poConfig)
+{
+  if (u32Set & MCC_ACCEL_SET_RATE) {
+    poConfig->u8CtrlReg1 &= ~ESL_I2C_MMA845XQ_CTRL_REG1_DR_MASK;
+    poConfig->u8CtrlReg1 |=  ESL_I2C_MMA845XQ_CTRL_REG1_DR_VAL(accel_rateCode(poReq->u32RateMilliHz));
+  }
+  if (u32Set & MCC_ACCEL_SET_RANGE) {                                           // up to the next range
+    poConfig->u8XyzDataCfg &= ~ESL_I2C_MMA845XQ_XYZ_DATA_CFG_FS_MASK;
+    poConfig->u8XyzDataCfg |=  (poReq->u8RangeG <= 2) ? ESL_I2C_MMA845XQ_XYZ_DATA_CFG_FS_VAL_2
+                             : (poReq->u8RangeG <= 4) ? ESL_I2C_MMA845XQ_XYZ_DATA_CFG_FS_VAL_4
+                             :                          ESL_I2C_MMA845XQ_XYZ_DATA_CFG_FS_VAL_8;
+  }
+  if (u32Set & MCC_ACCEL_SET_OVERSAMPLING) {
+    poConfig->u8CtrlReg2 &= ~ESL_I2C_MMA845XQ_CTRL_REG2_MODS_MASK;
+    poConfig->u8CtrlReg2 |=  ESL_I2C_MMA845XQ_CTRL_REG2_MODS_VAL(poReq->u8Oversampling);
+  }
+  if (u32Set & MCC_ACCEL_SET_LOW_NOISE) {
+    if (poReq->u8LowNoise) {
+      poConfig->u8CtrlReg1 |=  ESL_I2C_MMA845XQ_CTRL_REG1_LNOISE_MASK;
+    } else {
+      poConfig->u8CtrlReg1 &= ~ESL_I2C_MMA845XQ_CTRL_REG1_LNOISE_MASK;
+    }
+  }
+}
+
+//******************************************************************************
+
+static void accel_decodeConfig (const ESL_I2C_MMA845XQ_TConfig * poConfig,
+                                TMccAccelConfig                * poDst)
+{
+  int iFs = (poConfig->u8XyzDataCfg & ESL_I2C_MMA845XQ_XYZ_DATA_CFG_FS_MASK)
+            >> ESL_I2C_MMA845XQ_XYZ_DATA_CFG_FS_SHIFT;
+
+  poDst->u32RateMilliHz = (1000000000 + mma845x_periodUs(poConfig) / 2) / mma845x_periodUs(poConfig);
+  poDst->u8RangeG       = (uint8_t)(2 << MIN(iFs, 2));
+  poDst->u8Oversampling = (uint8_t)((poConfig->u8CtrlReg2 & ESL_I2C_MMA845XQ_CTRL_REG2_MODS_MASK)
+                                    >> ESL_I2C_MMA845XQ_CTRL_REG2_MODS_SHIFT);
+  poDst->u8LowNoise     = (poConfig->u8CtrlReg1 & ESL_I2C_MMA845XQ_CTRL_REG1_LNOISE_MASK) ? 1 : 0;
+  poDst->u8Reserved     = 0;
+  // the low noise mode limits the range, report the one in effect (as g_oScale)
+  if (poDst->u8LowNoise && (poDst->u8RangeG > 4)) poDst->u8RangeG = 4;
+}
+
+//******************************************************************************
+
+static void accel_serveConfig (ESL_I2C_MMA845XQ_TDevice * hAccelDevice,
+                               ESL_I2C_MMA845XQ_TConfig * poConfig,
+                               uint_8                     u8Mode)
+{
+  ESL_I2C_MMA845XQ_TConfig  oNew = *poConfig;                                   // keeps the interrupt settings
+  TMccAccelScale            oScale;
+  TMccAccelEvents           oEventsSet;
+  TMccAccelEvents           oEvents;
+  TMma845xEvents            oEventRegs;
+  uint32_t                  u32Seq;
+  uint_8                    u8Result = ACCEL_OK;
+  uint_8                    ret;
+
+  // Retrieve the request
+  ret = _lwsem_wait_ticks(&g_lwsem, MSECS_TO_MQX_TICKS(ACCEL_LWSEM_WAIT));
+  if (ret != MQX_OK) {
+    LOGW_FORMATTED("Accel: settings change not taken: %d", ret);                // the requester times out
+    return;
+  }
+  accel_encodeConfig(&g_oConfigReq.oConfig, g_oConfigReq.u32Set, &oNew);
+  oEventsSet = g_oConfigReq.bEvents ? g_oConfigReq.oEvents : g_oEventsSet;
+  u32Seq = g_oConfigReq.u32Seq;
+  _lwsem_post(&g_lwsem);
+
+  // the event time steps follow the rate and the oversampling mode
+  mma845x_eventsEncode(&oEventsSet, &oNew, ACCEL_MMA845xQ_INT_LINE, &oEventRegs, &oEvents);
+  ret = accel_applyConfig(hAccelDevice, &oNew, &oEventRegs, u8Mode);
+  if (ESL_I2C_OK == ret) {
+    *poConfig     = oNew;
+    g_oEventsSet  = oEventsSet;
+    g_oEventRegs  = oEventRegs;
   } else {
-    ++g_u32MissedCnt;
-    ret = ACCEL_OK;
+    LOGW_FORMATTED("Accel: settings change failed: %d", ret);
+    oEvents = g_oEvents;                                                        // written by this task only
+    ret = accel_applyConfig(hAccelDevice, poConfig, &g_oEventRegs, u8Mode);
+    if (ESL_I2C_OK != ret) LOGE_FORMATTED("Accel: settings not restored: %d", ret);
+    u8Result = ACCEL_DEVICE_FAILURE;
   }
+  accel_computeScale(poConfig, g_i32DeviceId, &oScale);
+  g_oTiming.u32PeriodUs = mma845x_periodUs(poConfig);
+  g_oTiming.bSynced     = FALSE;
+  vibration_restart(&g_oVibration);                                             // one rate and scale per window
 
+  // Publish the settings in effect
+  _lwsem_wait_ticks(&g_lwsem, 0);
+  accel_decodeConfig(poConfig, &g_oConfig);
+  g_oEvents = oEvents;
+  if ((oScale.u16CountsPerG != g_oScale.u16CountsPerG) || (oScale.u8RangeG != g_oScale.u8RangeG)) {
+    g_oScaleOld     = g_oScale;
+    g_oScale        = oScale;
+    g_u32ScaleFirst = history_newest(&g_oHistory) + 1;
+  }
+  g_oConfigReq.u8Result = u8Result;
+  g_oConfigReq.u32Done  = u32Seq;
   _lwsem_post(&g_lwsem);
+  _lwevent_set(&g_lweventConfig, EVENT_Accel_ConfigDone);
+
+  LOGI_FORMATTED("Accel: %u mHz, %u g, mods %u, lnoise %u", g_oConfig.u32RateMilliHz,
+                 g_oConfig.u8RangeG, g_oConfig.u8Oversampling, g_oConfig.u8LowNoise);
+  if (g_oEventRegs.u8IntEn) {
+    LOGI_FORMATTED("Accel: events 0x%02x, debounce %u ms", g_oEventRegs.u8IntEn, oEvents.u16DebounceMs);
+  }
+}
+
+//******************************************************************************
+
+static uint_8 accel_applyConfig (ESL_I2C_MMA845XQ_TDevice       * hAccelDevice,
+                                 const ESL_I2C_MMA845XQ_TConfig * poConfig,
+                                 const TMma845xEvents           * poEvents,
+                                 uint_8                           u8Mode)
+{
+  uint32_t  u32PeriodUs = mma845x_periodUs(poConfig);
+  uint_8    ret;
 
-  // CRITICIAL SECTION END //
+  ret = esl_i2c_MMA845xQ_standby(hAccelDevice);
+  if (ESL_I2C_OK != ret) return ret;
+  ret = esl_i2c_MMA845xQ_configure(hAccelDevice, poConfig);
+  if (ESL_I2C_OK != ret) return ret;
+  ret = mma845x_eventsWrite(hAccelDevice, poEvents);
+  if (ESL_I2C_OK != ret) return ret;
+  if ((ACCEL_MODE_FIFO == u8Mode) || (ACCEL_MODE_FIFO_INT == u8Mode)) {
+    ret = mma845x_fifoSetup(hAccelDevice, MMA845X_F_SETUP_F_MODE_OFF, 0);       // drops the samples of the old rate
+    if (ESL_I2C_OK != ret) return ret;
+    ret = mma845x_fifoSetup(hAccelDevice, MMA845X_F_SETUP_F_MODE_CIRCULAR,
+                            (ACCEL_MODE_FIFO_INT == u8Mode) ? ACCEL_INT_WATERMARK(u32PeriodUs) : ACCEL_FIFO_WATERMARK);
+    if (ESL_I2C_OK != ret) return ret;
+  }
+  return esl_i2c_MMA845xQ_activate(hAccelDevice);
+}
+
+//******************************************************************************
+
+static void accel_computeScale (const ESL_I2C_MMA845XQ_TConfig * poConfig,
+                                int32_t                          i32DeviceId,
+                                TMccAccelScale                 * poScale)
+{
+  int iFs    = (poConfig->u8XyzDataCfg & ESL_I2C_MMA845XQ_XYZ_DATA_CFG_FS_MASK)
+               >> ESL_I2C_MMA845XQ_XYZ_DATA_CFG_FS_SHIFT;
+  int iScale = 2 << MIN(iFs, 2);                                                // 2, 4 or 8 g
+
+  poScale->u16CountsPerG = ESL_I2C_MMA845XQ_RAW2G_DIVIDER(iScale);
+  switch (i32DeviceId) {
+  case ACCEL_TYPE_MMA8452Q: poScale->u8Bits = ESL_I2C_MMA8452Q_DATA_RESOLUTION; break;
+  case ACCEL_TYPE_MMA8453Q: poScale->u8Bits = ESL_I2C_MMA8453Q_DATA_RESOLUTION; break;
+  default:                  poScale->u8Bits = ESL_I2C_MMA8451Q_DATA_RESOLUTION; break;
+  }
+  if ((poConfig->u8CtrlReg1 & ESL_I2C_MMA845XQ_CTRL_REG1_LNOISE_MASK) && (iScale > 4)) {
+    iScale = 4;                                                                 // the low noise mode limits the dynamic range
+  }
+  poScale->u8RangeG = (uint8_t)iScale;
+}
+
+//******************************************************************************
+
+static uint_8 accel_setLastData (const TAccelData   * paoSrc,
+                                 uint32_t             u32Cnt)
+{
+  const TAccelData * poLast = &paoSrc[u32Cnt-1];
+  uint_8             ret;
+  assert(paoSrc && u32Cnt);
+
+  history_push(&g_oHistory, paoSrc, u32Cnt);
+  accel_summarize(paoSrc, u32Cnt);
+
+  // the summaries and the events are pushed to the A5 as long as they are set
+  if (accel_snapshotRead() || vibration_isActive(&g_oVibration) || g_oEventRegs.u8IntEn) g_u32MissedMs = 0;
+  if (g_u32MissedMs >= ACCEL_STANDBY_TIMEOUT) {
+    ret = ACCEL_OUTDATED;
+  } else {
+    g_u32MissedMs += g_u32ReadoutMs;
+    ret = ACCEL_OK;
+  }
+  accel_writeSnapshot(poLast, (ACCEL_OUTDATED == ret) ? MCC_SNAPSHOT_FLAG_STANDBY : 0);
 
   return ret;
 }
+
+//******************************************************************************
+
+static void accel_summarize (const TAccelData   * paoSrc,
+                             uint32_t             u32Cnt)
+{
+  uint32_t u32Taken;
+
+  // Take the change requested, the window restarts
+  if (g_oFeaturesReq.u32Seq != g_oFeaturesReq.u32Done) {
+    if (MQX_OK == _lwsem_wait_ticks(&g_lwsem, MSECS_TO_MQX_TICKS(ACCEL_LWSEM_WAIT))) {
+      vibration_setup(&g_oVibration, &g_oFeaturesReq.oFeatures);
+      g_oFeaturesReq.u32Done = g_oFeaturesReq.u32Seq;
+      _lwsem_post(&g_lwsem);
+      LOGI_FORMATTED("Accel: features window %u, %u bands",
+                     g_oVibration.oSettings.u16Length, g_oVibration.oSettings.u8Bands);
+    }
+  }
+  if (!vibration_isActive(&g_oVibration)) return;
+
+  while (u32Cnt) {
+    u32Taken = vibration_add(&g_oVibration, paoSrc, u32Cnt);
+    paoSrc += u32Taken;
+    u32Cnt -= u32Taken;
+    if (vibration_isFull(&g_oVibration)) {                                      // the range is the one of g_oScale, see accel_serveConfig()
+      vibration_compute(&g_oVibration, &g_oScale, g_oTiming.u32PeriodUs, &g_oSummary);
+      vibration_publish(&g_oSummaries, &g_oSummary);
+    }
+  }
+}
+
+//******************************************************************************
+
+static uint_8 accel_readEvents (ESL_I2C_MMA845XQ_TDevice * hAccelDevice,
+                                uint32_t                   u32Timestamp,
+                                uint32_t                   u32AgeUs,
+                                uint_8                   * pu8IntSource)
+{
+  TMccAccelEvent  aoEvents[MMA845X_EVENTS_MAX];
+  uint32_t        u32NowUs;
+  uint32_t        u32Periods = 0;
+  uint32_t        u32Cnt;
+  uint32_t        i;
+  uint_8          ret;
+
+  u32NowUs = timebase_getUs(&g_oTimebase) - u32AgeUs;
+  ret = mma845x_eventsRead (aoEvents, &u32Cnt, pu8IntSource, &g_oEventRegs, hAccelDevice);
+  if ((ESL_I2C_OK != ret) || !u32Cnt) return ret;
+
+  // the sample the event was detected at: the newest one produced by now
+  if (g_oTiming.bSynced && ((int32_t)(u32NowUs - g_oTiming.u32LastUs) > 0)) {
+    u32Periods = (u32NowUs - g_oTiming.u32LastUs) / g_oTiming.u32PeriodUs;
+  }
+  for (i = 0; i < u32Cnt; ++i) {
+    aoEvents[i].u32Timestamp = u32Timestamp + u32Periods;
+    aoEvents[i].u32TimeUs    = g_oTiming.bSynced ? g_oTiming.u32LastUs + u32Periods * g_oTiming.u32PeriodUs
+                                                 : u32NowUs;
+  }
+  eventlog_publish(&g_oEventLog, aoEvents, u32Cnt);
+  return ESL_I2C_OK;
+}
+
+//******************************************************************************
+
+static uint_8 accel_readFifo (ESL_I2C_MMA845XQ_TDevice * hAccelDevice,
+                              uint32_t                   u32Timestamp,
+                              uint32_t                   u32AgeUs,
+                              uint32_t                 * pu32Cnt)
+{
+  int_16    aai16Data[MMA845X_FIFO_SIZE][3];
+  boolean   bOverflow;
+  uint32_t  u32NowUs;
+  uint32_t  u32LastUs;
+  uint32_t  i;
+  uint_8    ret;
+
+  u32NowUs = timebase_getUs(&g_oTimebase);
+  ret = mma845x_fifoRead (aai16Data, MMA845X_FIFO_SIZE, pu32Cnt, &bOverflow, hAccelDevice);
+  if ((ESL_I2C_OK != ret) || !*pu32Cnt) return ret;
+
+  if (bOverflow && !(g_oTiming.u32Overflows++ & 0xFF)) {
+    LOGW_FORMATTED("Accel: FIFO overflow, samples lost (%u times)", g_oTiming.u32Overflows);
+  }
+  u32LastUs = accel_trackTime(u32NowUs - u32AgeUs, *pu32Cnt, bOverflow);
+
+  for (i = 0; i < *pu32Cnt; ++i) {
+    TAccelData * poDst = &g_aoBatch[i];
+    ret = esl_i2c_MMA845xQ_raw2g (poDst->afData, aai16Data[i], hAccelDevice);
+    if (ESL_I2C_OK != ret) return ret;
+    poDst->ai16Raw[0]   = aai16Data[i][0];
+    poDst->ai16Raw[1]   = aai16Data[i][1];
+    poDst->ai16Raw[2]   = aai16Data[i][2];
+    poDst->u32Timestamp = u32Timestamp + 1 + i;
+    poDst->u32TimeUs    = u32LastUs - (*pu32Cnt - 1 - i) * g_oTiming.u32PeriodUs;
+  }
+  return ESL_I2C_OK;
+}
+
+//******************************************************************************
+
+static uint32_t accel_trackTime (uint32_t u32NowUs, uint32_t u32Cnt, boolean bLost)
+{
+  uint32_t  u32LastUs;
+  int32_t   i32Err;
+  int32_t   i32Lim = (int32_t)(2 * g_oTiming.u32PeriodUs);
+
+  if (bLost) g_oTiming.bSynced = FALSE;                                         // the gap is unknown
+  if (!u32Cnt) {                                                                // the periods passed, at least one
+    u32Cnt = (u32NowUs - g_oTiming.u32LastUs + g_oTiming.u32PeriodUs / 2) / g_oTiming.u32PeriodUs;
+    u32Cnt = MAX(u32Cnt, 1);
+  }
+  u32LastUs = g_oTiming.u32LastUs + u32Cnt * g_oTiming.u32PeriodUs;
+  i32Err    = (int32_t)(u32NowUs - u32LastUs);
+  if (!g_oTiming.bSynced || (i32Err > i32Lim) || (i32Err < -i32Lim)) {          // started, or lost track
+    u32LastUs = u32NowUs;
+    g_oTiming.bSynced = TRUE;
+  } else {
+    u32LastUs += i32Err / ACCEL_FIFO_TIME_GAIN;
+  }
+  g_oTiming.u32LastUs = u32LastUs;
+  return u32LastUs;
+}
+
+//******************************************************************************
+
+static uint32_t accel_readoutMs (uint_8 u8Mode, uint32_t u32PeriodUs)
+{
+  uint32_t u32Ms;
+
+  switch (u8Mode) {
+  case ACCEL_MODE_FIFO:
+    u32Ms = u32PeriodUs * ACCEL_FIFO_WATERMARK / 1000;
+    return MIN(MAX(u32Ms, ACCEL_FIFO_MIN_INTERVAL), ACCEL_FIFO_MAX_INTERVAL);
+  case ACCEL_MODE_DRDY:
+    return MAX(u32PeriodUs / 1000, 1);
+  case ACCEL_MODE_FIFO_INT:
+    return MAX(u32PeriodUs * ACCEL_INT_WATERMARK(u32PeriodUs) / 1000, 1);
+  default:
+    return ACCEL_PERIODIC_INTERVAL;
+  }
+}
+
+//******************************************************************************
+
+#if ACCEL_INT_ENABLE
+static uint_32 accel_intInit (ESL_I2C_MMA845XQ_TDevice * hAccelDevice,
+                              ESL_I2C_MMA845XQ_TConfig * poConfig,
+                              boolean                    bFifo)
+{
+  uint_8 u8Src = bFifo ? ESL_I2C_MMA845XQ_CTRL_REG4_INT_EN_FIFO_MASK : ESL_I2C_MMA845XQ_CTRL_REG4_INT_EN_DRDY_MASK;
+  uint_8 ret;
+
+  // falling edge of the active low output
+  if (!lwgpio_init(&g_lwInt, ACCEL_MMA845xQ_INT_PIN, LWGPIO_DIR_INPUT, LWGPIO_VALUE_NOCHANGE)) return ESL_GPIO_INVALID_PORT_NUMBER;
+  lwgpio_set_functionality(&g_lwInt, ACCEL_MMA845xQ_INT_MUX);
+  if (!lwgpio_int_init(&g_lwInt, LWGPIO_INT_MODE_FALLING)) return ESL_GPIO_BSP_INT_INIT_FAILURE;
+  ret = esl_gpio_isrRegister(&g_lwInt, accel_isr, &g_lwInt);
+  if (ESL_GPIO_OK != ret) return ret;
+
+  // CTRL_REG4 bits and their CTRL_REG5 routing bits are at the same positions
+  poConfig->u8CtrlReg3 &= ~ESL_I2C_MMA845XQ_CTRL_REG3_IPOL_MASK;
+  poConfig->u8CtrlReg4 |= u8Src;
+  if (1 == ACCEL_MMA845xQ_INT_LINE) {
+    poConfig->u8CtrlReg5 |= u8Src;
+  } else {
+    poConfig->u8CtrlReg5 &= ~u8Src;
+  }
+  ret = esl_i2c_MMA845xQ_configure(hAccelDevice, poConfig);
+  if (ESL_I2C_OK != ret) return ret;
+
+  lwgpio_int_clear_flag(&g_lwInt);
+  lwgpio_int_enable(&g_lwInt, TRUE);
+  return ESL_I2C_OK;
+}
+
+//******************************************************************************
+
+static void accel_isr (void * pvArg)
+{
+  lwgpio_int_clear_flag((LWGPIO_STRUCT_PTR)pvArg);
+  _lwevent_set(&g_lwevent, EVENT_Accel_Data);
+}
+#endif
+
+//******************************************************************************
+
+static void accel_writeSnapshot (const TAccelData   * poSrc,
+                                 uint32_t             u32Flags)
+{
+  uint32_t u32Seq = g_poSnapshot->u32Seq;
+
+  g_poSnapshot->u32Seq = u32Seq + 1;
+  MCC_SNAPSHOT_BARRIER();
+  g_poSnapshot->u32Timestamp  = poSrc->u32Timestamp;
+  g_poSnapshot->afData[0]     = poSrc->afData[0];
+  g_poSnapshot->afData[1]     = poSrc->afData[1];
+  g_poSnapshot->afData[2]     = poSrc->afData[2];
+  g_poSnapshot->u32TimeUs     = poSrc->u32TimeUs;
+  g_poSnapshot->u32Flags      = u32Flags;
+  MCC_SNAPSHOT_BARRIER();
+  g_poSnapshot->u32Seq = u32Seq + 2;
+}
+
+//******************************************************************************
+
+static boolean accel_snapshotRead (void)
+{
+  uint32_t u32ReadCnt = g_poSnapshot->u32ReadCnt;
+
+  if (u32ReadCnt == g_u32ReadCnt) return FALSE;
+  g_u32ReadCnt = u32ReadCnt;
+  return TRUE;
+}
+
+//******************************************************************************
+
+static uint_8 accel_markRead (void)
+{
+  ++g_poSnapshot->u32ReadCnt;                                                   // racy, only the change matters
+  if (g_poSnapshot->u32Flags & MCC_SNAPSHOT_FLAG_STANDBY) {
+    _lwevent_set(&g_lwevent, EVENT_Accel_Wakeup);
+    return ACCEL_OUTDATED;
+  }
+  return ACCEL_OK;
+}
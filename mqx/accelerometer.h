@@ -59,6 +59,9 @@ enum {
   ACCEL_LWSEM_FAILURE,
   ACCEL_OUTDATED,
   ACCEL_MODULE_OFF,
+  ACCEL_BUSY,
+  ACCEL_INVALID_ARGUMENT,
+  ACCEL_DEVICE_FAILURE,
 };
 
 //******************************************************************************
@@ -68,6 +71,8 @@ enum {
 typedef struct t_accel_data_struct {
   uint32_t  u32Timestamp;                                                       //!< Data timestamp (simple increasing integer).
   float     afData[3];                                                          //!< Accelerometer 3-axis data.
+  int16_t   ai16Raw[3];                                                         //!< Raw 3-axis counts the data was converted from (see TMccAccelScale).
+  uint32_t  u32TimeUs;                                                          //!< Sample time in microseconds (timebase_getUs()): the readout time, or the time estimated from the output data rate for samples read on the interrupt or from the FIFO.
 } TAccelData;
 
 //******************************************************************************
@@ -83,17 +88,166 @@ void accel_task (uint32_t u32InitialData);
                 ACCEL_TYPE_UNKNOWN if not known. */
 int32_t accel_getIdentifier (void);
 
-/** Retrieves the last measured accelerometer data, guarded by a semaphore.
+/** Retrieves the last measured accelerometer data from the snapshot shared
+ *  with the A5 (lock-free, see TMccAccelSnapshot).
  * @param[out]  poDst         Destination memory to store the data to.
- * @param[in]   u32WaitTicks  Semaphore wait timeout ticks. Use 0 for infinity.
+ * @param[in]   u32WaitTicks  Maximum ticks to wait for an interrupted update
+ *                            of the snapshot to finish. Use 0 for infinity.
  * @return      ACCEL_OK on success.
- *              ACCEL_LWSEM_FAILURE if waiting for semaphore fails.
+ *              ACCEL_BUSY if the snapshot kept being updated.
  *              ACCEL_OUTDATED if the read data is outdated because the module
  *              switched to the standby mode. Call this function within
- *              (ACCEL_MAX_MISSED_CNT * ACCEL_PERIODIC_INTERVAL) to retrieve
- *              up-to-date data. Anyway, the data is copied. */
+ *              ACCEL_STANDBY_TIMEOUT milliseconds to retrieve up-to-date
+ *              data. Anyway, the data is copied. */
 uint_8 accel_getLastData (TAccelData  * poDst,
                           uint_32       u32WaitTicks);
 
+/** Retrieves the measured samples newer than given timestamp from the sample
+ *  history (lock-free, see history.h). The samples are ordered the oldest
+ *  first and have consecutive timestamps.
+ * @param[out]  paoDst        Destination array to store the samples to.
+ * @param[in]   u32MaxCnt     Size of the paoDst array.
+ * @param[in]   u32Since      Timestamp of the last sample already known to the
+ *                            consumer. Use 0 to get all available samples.
+ * @param[out]  pu32Cnt       Number of samples stored to paoDst.
+ * @param[out]  pu32Lost      Number of samples newer than u32Since that have
+ *                            already been overwritten in the history (also
+ *                            while being read).
+ * @param[out]  pau32TimeUs   Array of u32MaxCnt readout times of the samples
+ *                            (see TAccelData::u32TimeUs), NULL if not needed.
+ * @return      ACCEL_OK on success.
+ *              ACCEL_OUTDATED as accel_getLastData(). */
+uint_8 accel_getHistory (TMccAccelSample  * paoDst,
+                         uint32_t           u32MaxCnt,
+                         uint32_t           u32Since,
+                         uint32_t         * pu32Cnt,
+                         uint32_t         * pu32Lost,
+                         uint32_t         * pau32TimeUs);
+
+/** Retrieves the raw counts of the measured samples newer than given
+ *  timestamp from the sample history, as accel_getHistory() does. The samples
+ *  have consecutive timestamps starting from *pu32First.
+ * @param[out]  pai16Dst      Destination array to store the X, Y, Z counts to.
+ * @param[in]   u32MaxCnt     Size of the pai16Dst array.
+ * @param[in]   u32Since      As in accel_getHistory().
+ * @param[out]  pu32First     Timestamp of the first sample stored to pai16Dst.
+ * @param[out]  pu32Cnt       Number of samples stored to pai16Dst.
+ * @param[out]  pu32Lost      As in accel_getHistory().
+ * @param[out]  pau32TimeUs   As in accel_getHistory().
+ * @param[out]  poScale       Conversion of the counts stored. The samples
+ *                            returned stop before the first one measured
+ *                            with a different range (see accel_setConfig()).
+ * @param[in]   u32WaitTicks  Wait timeout ticks of the semaphore guarding the
+ *                            scale. Use 0 for infinity.
+ * @return      ACCEL_OK on success.
+ *              ACCEL_LWSEM_FAILURE if waiting for semaphore fails.
+ *              ACCEL_OUTDATED as accel_getLastData(). */
+uint_8 accel_getRawHistory (int16_t          (* pai16Dst)[3],
+                            uint32_t           u32MaxCnt,
+                            uint32_t           u32Since,
+                            uint32_t         * pu32First,
+                            uint32_t         * pu32Cnt,
+                            uint32_t         * pu32Lost,
+                            uint32_t         * pau32TimeUs,
+                            TMccAccelScale   * poScale,
+                            uint_32            u32WaitTicks);
+
+/** Retrieves the conversion of the raw counts (TAccelData::ai16Raw) to g, as
+ *  given by the accelerometer configuration and type. Valid once the task
+ *  has been initialized. */
+void accel_getScale (TMccAccelScale * poScale);
+
+/** Changes the accelerometer settings. The task applies them between two
+ *  readouts: STANDBY, the new configuration and the FIFO flushed, ACTIVE.
+ *  The sample timestamps go on, the sample times follow the new output data
+ *  rate from then on.
+ * @param[in]   poReq         Requested settings (see TMccAccelConfig).
+ * @param[in]   u32Set        MCC_ACCEL_SET_* bits of the poReq settings to
+ *                            change, the others are kept.
+ * @param[in]   u32WaitTicks  Maximum ticks to wait for the task to apply
+ *                            them. Use 0 for infinity.
+ * @return      ACCEL_OK on success.
+ *              ACCEL_INVALID_ARGUMENT if a requested setting is out of range,
+ *              nothing changed.
+ *              ACCEL_DEVICE_FAILURE if the sensor failed, the previous
+ *              settings are restored if it allows.
+ *              ACCEL_LWSEM_FAILURE if another change did not finish in time.
+ *              ACCEL_BUSY if the task did not apply them in time, it may
+ *              still do. */
+uint_8 accel_setConfig (const TMccAccelConfig  * poReq,
+                        uint32_t                 u32Set,
+                        uint_32                  u32WaitTicks);
+
+/** Retrieves the settings in effect. Valid once the task has been
+ *  initialized.
+ * @param[out]  poConfig      Destination of the settings.
+ * @param[out]  pu32PeriodUs  Output data period in microseconds, NULL if not
+ *                            needed. */
+void accel_getConfig (TMccAccelConfig  * poConfig,
+                      uint32_t         * pu32PeriodUs);
+
+/** Changes the vibration features summarized by the task (see
+ *  TMccAccelFeatures). The task takes them at its next readout and starts a
+ *  new window, it stays out of the standby mode while they are set.
+ * @param[in]   poReq         Requested features, u16Length 0 for none.
+ * @param[in]   u32WaitTicks  Wait timeout ticks of the semaphore guarding the
+ *                            request. Use 0 for infinity.
+ * @return      ACCEL_OK on success.
+ *              ACCEL_INVALID_ARGUMENT if a requested setting is out of range,
+ *              nothing changed.
+ *              ACCEL_LWSEM_FAILURE if waiting for semaphore fails. */
+uint_8 accel_setFeatures (const TMccAccelFeatures  * poReq,
+                          uint_32                    u32WaitTicks);
+
+/** Retrieves the vibration features last requested (all zero before any).
+ * @param[out]  poFeatures    Destination of the features. */
+void accel_getFeatures (TMccAccelFeatures * poFeatures);
+
+/** Retrieves the oldest summary of the vibration features newer than given
+ *  window number (lock-free, see vibration.h).
+ * @param[in]   u32Since      Window number of the last summary already known
+ *                            to the consumer. Use 0 to get the oldest one
+ *                            available.
+ * @param[out]  poDst         Destination of the summary, its u32Lost set to
+ *                            the summaries newer than u32Since already
+ *                            overwritten (type not set).
+ * @return      TRUE if a summary was copied, FALSE if there is none newer. */
+boolean accel_getSummary (uint32_t               u32Since,
+                          TMccAccelSummaryMsg  * poDst);
+
+/** Changes the motion, freefall, transient and tap detection of the sensor
+ *  (see TMccAccelEvents). The task applies it between two readouts as
+ *  accel_setConfig() does, reads the events on the interrupt (or at each
+ *  readout without it) and stays out of the standby mode while any function
+ *  is enabled.
+ * @param[in]   poReq         Requested detection, all zero for none.
+ * @param[in]   u32WaitTicks  As in accel_setConfig().
+ * @return      As accel_setConfig(). */
+uint_8 accel_setEvents (const TMccAccelEvents  * poReq,
+                        uint_32                  u32WaitTicks);
+
+/** Retrieves the detection in effect (all zero before any).
+ * @param[out]  poEvents      Destination of the detection. */
+void accel_getEvents (TMccAccelEvents * poEvents);
+
+/** Returns the number of the newest event detected, 0 if none. */
+uint32_t accel_lastEvent (void);
+
+/** Retrieves the events newer than given number, the oldest first (lock-free,
+ *  see eventlog.h).
+ * @param[in]   u32Since      Number of the last event already known to the
+ *                            consumer, 0 for the oldest one available.
+ * @param[out]  paoDst        Destination array of the events.
+ * @param[in]   u32MaxCnt     Size of paoDst.
+ * @param[out]  pu32First     Number of the first event copied.
+ * @param[out]  pu32Lost      Number of the events newer than u32Since already
+ *                            overwritten.
+ * @return      Number of events copied. */
+uint32_t accel_getEventLog (uint32_t           u32Since,
+                            TMccAccelEvent   * paoDst,
+                            uint32_t           u32MaxCnt,
+                            uint32_t         * pu32First,
+                            uint32_t         * pu32Lost);
+
 //******************************************************************************
 #endif // ACCELEROMETER_H_385362083936620546820752037 //
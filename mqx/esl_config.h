@@ -25,6 +25,7 @@
 #endif
 
 #define ESL_APPCTRL_MODULE_ENABLE           (1)
+#define ESL_CRC_MODULE_ENABLE               (1)
 #define ESL_I2C_MODULE_ENABLE               (1)
 #define ESL_I2C_MMA845XQ_MODULE_ENABLE      (1)
 #define ESL_KEYBOARD_MODULE_ENABLE          (1)
@@ -0,0 +1,117 @@
+/** ****************************************************************************
+ *
+ *  @file       eventlog.c
+ *  @brief      Lock-free log of the accelerometer events.
+ *
+ *  @copyright  Elnico Ltd. All rights reserved.
+ *
+ ******************************************************************************/
+/*
+ *  THIS SOFTWARE IS PROVIDED BY ELNICO "AS IS" AND ANY EXPRESSED OR
+ *  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ *  OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ *  IN NO EVENT SHALL ELNICO OR ITS CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ *  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ *  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ *  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ *  IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ *  THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************/
+
+#include "eventlog.h"
+
+#include "esl_utils.h"
+
+#define EVENTLOG_BARRIER()              MCC_SNAPSHOT_BARRIER()
+
+//******************************************************************************
+//******************************************************************************
+//******************************************************************************
+
+void eventlog_init (TEventLog * poLog)
+{
+  uint32_t i;
+
+  for (i = 0; i < EVENTLOG_SIZE; ++i) {                                         // no event number 0
+    poLog->aoSlots[i].u32Seq = 0;
+  }
+  poLog->u32Newest = 0;
+  EVENTLOG_BARRIER();
+}
+
+//******************************************************************************
+
+void eventlog_publish (TEventLog             * poLog,
+                       const TMccAccelEvent  * paoSrc,
+                       uint32_t                u32Cnt)
+{
+  uint32_t  u32Number = poLog->u32Newest;
+  uint32_t  i;
+
+  for (i = 0; i < u32Cnt; ++i) {
+    TEventLogSlot * poSlot = &poLog->aoSlots[EVENTLOG_IDX(++u32Number)];
+
+    poSlot->u32Seq = u32Number - 1;                                             // readers of the old event fail from now on
+    EVENTLOG_BARRIER();
+    poSlot->oEvent = paoSrc[i];
+    EVENTLOG_BARRIER();
+    poSlot->u32Seq = u32Number;
+  }
+  EVENTLOG_BARRIER();
+  poLog->u32Newest = u32Number;
+}
+
+//******************************************************************************
+
+uint32_t eventlog_newest (const TEventLog * poLog)
+{
+  return poLog->u32Newest;
+}
+
+//******************************************************************************
+
+uint32_t eventlog_read (const TEventLog  * poLog,
+                        uint32_t           u32Since,
+                        TMccAccelEvent   * paoDst,
+                        uint32_t           u32MaxCnt,
+                        uint32_t         * pu32First,
+                        uint32_t         * pu32Lost)
+{
+  uint32_t  u32Newest = poLog->u32Newest;
+  uint32_t  u32Avail  = MIN(u32Newest, EVENTLOG_SIZE);
+  uint32_t  u32Cnt    = 0;
+  uint32_t  u32Number;
+
+  *pu32Lost = 0;
+  EVENTLOG_BARRIER();                                                           // the slots are read after the number
+  if ((int32_t)(u32Newest - u32Since) < 0) {                                    // reader ahead of us -> M4 restarted, take everything
+    u32Since = u32Newest - u32Avail;
+  } else if (u32Newest - u32Since > u32Avail) {                                 // some events already overwritten
+    *pu32Lost = u32Newest - u32Since - u32Avail;
+    u32Since  = u32Newest - u32Avail;
+  }
+
+  *pu32First = u32Since + 1;
+  for (u32Number = u32Since + 1; ((int32_t)(u32Newest - u32Number) >= 0) && (u32Cnt < u32MaxCnt); ++u32Number) {
+    const TEventLogSlot * poSlot = &poLog->aoSlots[EVENTLOG_IDX(u32Number)];
+
+    if (poSlot->u32Seq == u32Number) {
+      EVENTLOG_BARRIER();
+      paoDst[u32Cnt] = poSlot->oEvent;
+      EVENTLOG_BARRIER();
+      if (poSlot->u32Seq == u32Number) {                                        // not overwritten while copying
+        ++u32Cnt;
+        continue;
+      }
+    }
+    if (u32Cnt) break;                                                          // the writer went round, the rest is lost next time
+    ++*pu32Lost;
+    ++*pu32First;
+  }
+  return u32Cnt;
+}
+
+//******************************************************************************
@@ -0,0 +1,107 @@
+/** ****************************************************************************
+ *
+ *  @file       eventlog.h
+ *  @brief      Lock-free log of the accelerometer events.
+ *
+ *  The accelerometer task (the only writer) numbers the events it reads from
+ *  the sensor from 1 and keeps the last EVENTLOG_SIZE of them; the MCC tasks
+ *  read them by number without locking, as they do the sample history: each
+ *  slot holds the number of its event, the number less 1 while being
+ *  rewritten.
+ *
+ *  @copyright  Elnico Ltd. All rights reserved.
+ *
+ ******************************************************************************/
+/*
+ *  THIS SOFTWARE IS PROVIDED BY ELNICO "AS IS" AND ANY EXPRESSED OR
+ *  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ *  OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ *  IN NO EVENT SHALL ELNICO OR ITS CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ *  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ *  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ *  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ *  IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ *  THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************/
+
+#ifndef EVENTLOG_H_730291857203957102938571
+#define EVENTLOG_H_730291857203957102938571
+//******************************************************************************
+#include <mqx.h>
+#include <bsp.h>
+#if (MQX_VERSION >= 410)
+# include "psptypes_legacy.h"
+#endif
+
+#include "easyduo_mcc_common.h"
+
+//******************************************************************************
+// Settings
+//******************************************************************************
+
+/** @def EVENTLOG_SIZE
+ * @brief Number of events kept for the readers. Must be a power of 2. */
+#ifndef EVENTLOG_SIZE
+# define EVENTLOG_SIZE                  (32)
+#endif
+
+#define EVENTLOG_IDX(n)                 ((n) & (EVENTLOG_SIZE - 1))             //!< Slot of the event of given number.
+
+//******************************************************************************
+// Public types
+//******************************************************************************
+
+/** One event of the log. */
+typedef struct t_eventlog_slot_struct {
+  volatile uint32_t u32Seq;                                                     //!< Number of oEvent, the number less 1 while oEvent is being written.
+  TMccAccelEvent    oEvent;                                                     //!< The event.
+} TEventLogSlot;
+
+/** Event log, initialize by eventlog_init(). */
+typedef struct t_eventlog_struct {
+  volatile uint32_t u32Newest;                                                  //!< Number of the newest event published, 0 if none.
+  TEventLogSlot     aoSlots[EVENTLOG_SIZE];                                     //!< Events, indexed by EVENTLOG_IDX(number).
+} TEventLog;
+
+//******************************************************************************
+// Public functions
+//******************************************************************************
+
+/** Empties the log. Must be called before any reader uses it.
+ * @param[out]  poLog         Log to initialize. */
+void eventlog_init (TEventLog * poLog);
+
+/** Publishes events as the next ones (the only writer).
+ * @param[in,out] poLog       Log.
+ * @param[in]   paoSrc        Events, the oldest first.
+ * @param[in]   u32Cnt        Number of events in paoSrc. */
+void eventlog_publish (TEventLog             * poLog,
+                       const TMccAccelEvent  * paoSrc,
+                       uint32_t                u32Cnt);
+
+/** Returns the number of the newest event published, 0 if none.
+ * @param[in]   poLog         Log. */
+uint32_t eventlog_newest (const TEventLog * poLog);
+
+/** Copies the consecutive events newer than given number, the oldest first.
+ * @param[in]   poLog         Log.
+ * @param[in]   u32Since      Number of the last event known to the reader, 0
+ *                            for the oldest one kept.
+ * @param[out]  paoDst        Destination array of the events.
+ * @param[in]   u32MaxCnt     Size of paoDst.
+ * @param[out]  pu32First     Number of the first event copied.
+ * @param[out]  pu32Lost      Number of the events newer than u32Since already
+ *                            overwritten (also while being read).
+ * @return      Number of events copied. */
+uint32_t eventlog_read (const TEventLog  * poLog,
+                        uint32_t           u32Since,
+                        TMccAccelEvent   * paoDst,
+                        uint32_t           u32MaxCnt,
+                        uint32_t         * pu32First,
+                        uint32_t         * pu32Lost);
+
+//******************************************************************************
+#endif // EVENTLOG_H_730291857203957102938571 //
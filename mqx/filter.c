@@ -0,0 +1,244 @@
+/** ****************************************************************************
+ *
+ *  @file       filter.c
+ *  @brief      Fixed-point filter chain of the accelerometer samples.
+ *
+ *  @copyright  Elnico Ltd. All rights reserved.
+ *
+ ******************************************************************************/
+/*
+ *  THIS SOFTWARE IS PROVIDED BY ELNICO "AS IS" AND ANY EXPRESSED OR
+ *  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ *  OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ *  IN NO EVENT SHALL ELNICO OR ITS CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ *  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ *  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ *  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ *  IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ *  THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************/
+
+#include "filter.h"
+
+#include "esl_utils.h"
+
+#include <math.h>
+#include <string.h>
+
+#define FILTER_STATE_MAX                ((int32_t)1 << (16 + FILTER_SHIFT))     //!< Biquad outputs are limited to twice the full scale.
+#define FILTER_PI                       (3.14159265358979323846)
+
+//******************************************************************************
+// Functions declarations
+//******************************************************************************
+
+/** Designs a 2nd order Butterworth biquad (bilinear transform, the cutoff
+ *  prewarped). The low-pass numerator is derived from the quantized
+ *  denominator, so that its DC gain stays 1; the high-pass one sums to 0.
+ * @param[out]  poBiquad      Stage to design.
+ * @param[in]   dCutoff       Cutoff relative to the sample rate.
+ * @param[in]   bHighPass     TRUE for a high-pass, FALSE for a low-pass. */
+static void filter_design (TFilterBiquad * poBiquad, double dCutoff, boolean bHighPass);
+
+/** Runs one input sample of one axis through a biquad.
+ * @param[in,out] poBiquad    Stage.
+ * @param[in]   iAxis         Axis (0 to 2).
+ * @param[in]   i32X          Input scaled by 2^FILTER_SHIFT.
+ * @param[in]   bStart        TRUE for the first sample after a reset.
+ * @return      Output scaled by 2^FILTER_SHIFT. */
+static int32_t filter_biquad (TFilterBiquad * poBiquad, int iAxis, int32_t i32X, boolean bStart);
+
+/** Quantizes a coefficient.
+ * @param[in]   dValue        Coefficient, within (-2, 2).
+ * @return      Q30 value. */
+static int32_t filter_q30 (double dValue);
+
+//******************************************************************************
+//******************************************************************************
+//******************************************************************************
+
+boolean filter_setup (TFilter                * poFilter,
+                      const TMccAccelFilter  * poSettings,
+                      uint32_t                 u32PeriodUs)
+{
+  TMccAccelFilter oSettings;
+  double          dRate;
+
+  if (!poFilter || !poSettings || !u32PeriodUs) return FALSE;
+  if (   (poSettings->u8Average > MCC_ACCEL_FILTER_MAX_AVERAGE)
+      || poSettings->au8Reserved[0] || poSettings->au8Reserved[1]) {
+    return FALSE;
+  }
+
+  oSettings = *poSettings;                                                      // may be the one of poFilter
+  memset(poFilter, 0, sizeof(*poFilter));
+  poFilter->oSettings   = oSettings;
+  poFilter->u32PeriodUs = u32PeriodUs;
+  dRate = 1e6 / u32PeriodUs;
+  if (oSettings.u16HighPassCentiHz) {
+    filter_design(&poFilter->oHighPass, oSettings.u16HighPassCentiHz / 100.0 / dRate, TRUE);
+  }
+  if (oSettings.u16LowPassDeciHz) {
+    filter_design(&poFilter->oLowPass, oSettings.u16LowPassDeciHz / 10.0 / dRate, FALSE);
+  }
+  return TRUE;
+}
+
+//******************************************************************************
+
+void filter_reset (TFilter * poFilter)
+{
+  poFilter->bStarted = FALSE;
+  poFilter->u32Phase = 0;
+}
+
+//******************************************************************************
+
+boolean filter_isActive (const TFilter * poFilter)
+{
+  return (   poFilter->oSettings.u16HighPassCentiHz
+          || poFilter->oSettings.u16LowPassDeciHz
+          || (poFilter->oSettings.u8Average > 1)
+          || (poFilter->oSettings.u8Decimation > 1)) ? TRUE : FALSE;
+}
+
+//******************************************************************************
+
+uint32_t filter_maxInput (const TFilter * poFilter, uint32_t u32Room)
+{
+  uint32_t u32Decimation = MAX(poFilter->oSettings.u8Decimation, 1);
+
+  return poFilter->u32Phase + u32Room * u32Decimation;
+}
+
+//******************************************************************************
+
+uint32_t filter_run (TFilter   * poFilter,
+                     int16_t  (* pai16Data)[3],
+                     uint32_t  * pau32TimeUs,
+                     uint32_t    u32Cnt,
+                     uint32_t  * pu32First)
+{
+  uint32_t  u32Average    = MAX(poFilter->oSettings.u8Average, 1);
+  uint32_t  u32Decimation = MAX(poFilter->oSettings.u8Decimation, 1);
+  uint32_t  u32Kept = 0;
+  uint32_t  i;
+  int       iAxis;
+
+  *pu32First = 0;
+  for (i = 0; i < u32Cnt; ++i) {
+    boolean bStart = !poFilter->bStarted;
+    int16_t ai16Out[3];
+
+    for (iAxis = 0; iAxis < 3; ++iAxis) {
+      int32_t i32Y = (int32_t)pai16Data[i][iAxis] * (1 << FILTER_SHIFT);
+      int32_t i32Out;
+
+      if (poFilter->oSettings.u16HighPassCentiHz) i32Y = filter_biquad(&poFilter->oHighPass, iAxis, i32Y, bStart);
+      if (poFilter->oSettings.u16LowPassDeciHz)   i32Y = filter_biquad(&poFilter->oLowPass, iAxis, i32Y, bStart);
+      i32Out = (i32Y + (1 << (FILTER_SHIFT - 1))) >> FILTER_SHIFT;              // rounded back to the counts
+      i32Out = MIN(MAX(i32Out, -32768), 32767);
+
+      if (u32Average > 1) {
+        int32_t * pi32Sum = &poFilter->ai32Sum[iAxis];
+        uint32_t  j;
+
+        if (bStart) {                                                           // as if the input had been there forever
+          for (j = 0; j < u32Average; ++j) poFilter->aai16Average[j][iAxis] = (int16_t)i32Out;
+          *pi32Sum = i32Out * (int32_t)u32Average;
+        }
+        *pi32Sum += i32Out - poFilter->aai16Average[poFilter->u32AverageIdx][iAxis];
+        poFilter->aai16Average[poFilter->u32AverageIdx][iAxis] = (int16_t)i32Out;
+        i32Out = (*pi32Sum >= 0) ? (*pi32Sum + (int32_t)u32Average / 2) / (int32_t)u32Average
+                                 : -((-*pi32Sum + (int32_t)u32Average / 2) / (int32_t)u32Average);
+      }
+      ai16Out[iAxis] = (int16_t)i32Out;
+    }
+    if (u32Average > 1) poFilter->u32AverageIdx = (poFilter->u32AverageIdx + 1) % u32Average;
+    poFilter->bStarted = TRUE;
+
+    if (poFilter->u32Phase) {                                                   // dropped by the decimation
+      --poFilter->u32Phase;
+      continue;
+    }
+    poFilter->u32Phase = u32Decimation - 1;
+    if (!u32Kept) *pu32First = i;
+    pai16Data[u32Kept][0] = ai16Out[0];                                         // never ahead of i
+    pai16Data[u32Kept][1] = ai16Out[1];
+    pai16Data[u32Kept][2] = ai16Out[2];
+    if (pau32TimeUs) pau32TimeUs[u32Kept] = pau32TimeUs[i];
+    ++u32Kept;
+  }
+  return u32Kept;
+}
+
+//******************************************************************************
+// Private functions
+//******************************************************************************
+
+static void filter_design (TFilterBiquad * poBiquad, double dCutoff, boolean bHighPass)
+{
+  double  dW0, dS2, dAlpha, dA0;
+  int32_t i32B0;
+
+  dW0    = 2.0 * FILTER_PI * MIN(dCutoff, FILTER_CUTOFF_MAX);
+  dS2    = sin(dW0 / 2.0) * sin(dW0 / 2.0);                                     // 1 - cos(w0) = 2 sin^2(w0/2), exact at low cutoffs
+  dAlpha = sin(dW0) / sqrt(2.0);                                                // Q = 1/sqrt(2)
+  dA0    = 1.0 + dAlpha;
+  poBiquad->ai32A[0] = filter_q30((-2.0 + 4.0 * dS2) / dA0);
+  poBiquad->ai32A[1] = filter_q30((1.0 - dAlpha) / dA0);
+  if (bHighPass) {
+    i32B0 = filter_q30((1.0 - dS2) / dA0);                                      // (1 + cos(w0)) / 2
+    poBiquad->ai32B[0] = i32B0;
+    poBiquad->ai32B[1] = -2 * i32B0;
+    poBiquad->ai32B[2] = i32B0;
+    poBiquad->bPassDc  = FALSE;
+  } else {
+    i32B0 = (int32_t)((((int64_t)1 << FILTER_COEF_SHIFT) + poBiquad->ai32A[0] + poBiquad->ai32A[1] + 2) >> 2);  // the sum exceeds int32 at high cutoffs
+    poBiquad->ai32B[0] = i32B0;
+    poBiquad->ai32B[1] = 2 * i32B0;
+    poBiquad->ai32B[2] = i32B0;
+    poBiquad->bPassDc  = TRUE;
+  }
+}
+
+//******************************************************************************
+
+static int32_t filter_biquad (TFilterBiquad * poBiquad, int iAxis, int32_t i32X, boolean bStart)
+{
+  int32_t * pi32State = poBiquad->aai32State[iAxis];
+  int64_t   i64Acc;
+  int32_t   i32Y;
+
+  if (bStart) {                                                                 // settled at the first input
+    pi32State[0] = pi32State[1] = i32X;
+    pi32State[2] = pi32State[3] = poBiquad->bPassDc ? i32X : 0;
+  }
+  i64Acc  = (int64_t)poBiquad->ai32B[0] * i32X;
+  i64Acc += (int64_t)poBiquad->ai32B[1] * pi32State[0];
+  i64Acc += (int64_t)poBiquad->ai32B[2] * pi32State[1];
+  i64Acc -= (int64_t)poBiquad->ai32A[0] * pi32State[2];
+  i64Acc -= (int64_t)poBiquad->ai32A[1] * pi32State[3];
+  i64Acc  = (i64Acc + ((int64_t)1 << (FILTER_COEF_SHIFT - 1))) >> FILTER_COEF_SHIFT;
+  i32Y    = (int32_t)MIN(MAX(i64Acc, -FILTER_STATE_MAX), FILTER_STATE_MAX);
+
+  pi32State[1] = pi32State[0];
+  pi32State[0] = i32X;
+  pi32State[3] = pi32State[2];
+  pi32State[2] = i32Y;
+  return i32Y;
+}
+
+//******************************************************************************
+
+static int32_t filter_q30 (double dValue)
+{
+  double dQ = floor(dValue * (double)((int64_t)1 << FILTER_COEF_SHIFT) + 0.5);
+
+  return (int32_t)MIN(MAX(dQ, (double)INT32_MIN), (double)INT32_MAX);
+}
+
+//******************************************************************************
@@ -0,0 +1,126 @@
+/** ****************************************************************************
+ *
+ *  @file       filter.h
+ *  @brief      Fixed-point filter chain of the accelerometer samples.
+ *
+ *  Runs the raw counts of the three axes through the stages of a
+ *  TMccAccelFilter: high-pass and low-pass biquads, moving average and
+ *  decimation. The biquads are direct form I with Q30 coefficients and
+ *  a 64-bit accumulator on the counts scaled by 2^FILTER_SHIFT (two bits
+ *  of headroom for the overshoot), the moving average sums the rounded
+ *  16-bit results. Integer arithmetic only but the coefficient design, so
+ *  the output is the same on every host given the same input.
+ *
+ *  @copyright  Elnico Ltd. All rights reserved.
+ *
+ ******************************************************************************/
+/*
+ *  THIS SOFTWARE IS PROVIDED BY ELNICO "AS IS" AND ANY EXPRESSED OR
+ *  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ *  OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ *  IN NO EVENT SHALL ELNICO OR ITS CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ *  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ *  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ *  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ *  IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ *  THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************/
+
+#ifndef FILTER_H_740238510753290573210957
+#define FILTER_H_740238510753290573210957
+//******************************************************************************
+#include <mqx.h>
+#include <bsp.h>
+#if (MQX_VERSION >= 410)
+# include "psptypes_legacy.h"
+#endif
+
+#include "easyduo_mcc_common.h"
+
+//******************************************************************************
+// Settings
+//******************************************************************************
+
+#define FILTER_SHIFT                    (14)                                    //!< Fraction bits of the biquad state below the 16-bit counts.
+#define FILTER_COEF_SHIFT               (30)                                    //!< Fraction bits of the biquad coefficients.
+#define FILTER_CUTOFF_MAX               (0.45)                                  //!< Highest cutoff relative to the output data rate.
+
+//******************************************************************************
+// Public types
+//******************************************************************************
+
+/** One biquad stage, a0 = 1. */
+typedef struct t_filter_biquad_struct {
+  int32_t           ai32B[3];                                                   //!< b0, b1, b2 (Q30).
+  int32_t           ai32A[2];                                                   //!< a1, a2 (Q30).
+  boolean           bPassDc;                                                    //!< The stage passes DC (low-pass), its state starts at the first input then.
+  int32_t           aai32State[3][4];                                           //!< x[n-1], x[n-2], y[n-1], y[n-2] per axis, scaled by 2^FILTER_SHIFT.
+} TFilterBiquad;
+
+/** Filter chain and its state, set up by filter_setup(). */
+typedef struct t_filter_struct {
+  TMccAccelFilter   oSettings;                                                  //!< Stages in effect.
+  uint32_t          u32PeriodUs;                                                //!< Output data period the biquads are designed for.
+  TFilterBiquad     oHighPass;                                                  //!< High-pass stage, if oSettings.u16HighPassCentiHz.
+  TFilterBiquad     oLowPass;                                                   //!< Low-pass stage, if oSettings.u16LowPassDeciHz.
+  int16_t           aai16Average[MCC_ACCEL_FILTER_MAX_AVERAGE][3];              //!< Last oSettings.u8Average inputs of the moving average.
+  int32_t           ai32Sum[3];                                                 //!< Sum of aai16Average per axis.
+  uint32_t          u32AverageIdx;                                              //!< Slot of the oldest input in aai16Average.
+  uint32_t          u32Phase;                                                   //!< Filtered samples to drop before the next one kept (decimation).
+  boolean           bStarted;                                                   //!< The state holds the previous samples.
+} TFilter;
+
+//******************************************************************************
+// Public functions
+//******************************************************************************
+
+/** Sets the stages up and restarts the chain. Settings out of range leave
+ *  the filter unchanged.
+ * @param[out]  poFilter      Filter to set up.
+ * @param[in]   poSettings    Stages (see TMccAccelFilter).
+ * @param[in]   u32PeriodUs   Output data period of the input samples.
+ * @return      TRUE on success, FALSE if a setting is out of range. */
+boolean filter_setup (TFilter                * poFilter,
+                      const TMccAccelFilter  * poSettings,
+                      uint32_t                 u32PeriodUs);
+
+/** Restarts the chain: the next input sample is taken as if it had been the
+ *  input forever (no transient), and is kept by the decimation.
+ * @param[in,out] poFilter    Filter. */
+void filter_reset (TFilter * poFilter);
+
+/** Checks whether any stage is set.
+ * @param[in]   poFilter      Filter.
+ * @return      TRUE if the filter changes the samples. */
+boolean filter_isActive (const TFilter * poFilter);
+
+/** Computes how many input samples filter_run() may take to keep at most
+ *  given number of them.
+ * @param[in]   poFilter      Filter.
+ * @param[in]   u32Room       Number of output samples wanted, at least 1.
+ * @return      Number of input samples. */
+uint32_t filter_maxInput (const TFilter * poFilter, uint32_t u32Room);
+
+/** Filters consecutive samples in place, the samples dropped by the
+ *  decimation are removed.
+ * @param[in,out] poFilter    Filter.
+ * @param[in,out] pai16Data   u32Cnt X, Y, Z counts; the filtered samples kept
+ *                            are moved to the front.
+ * @param[in,out] pau32TimeUs u32Cnt times of the samples, moved along, NULL
+ *                            if none.
+ * @param[in]   u32Cnt        Number of input samples.
+ * @param[out]  pu32First     Index of the input sample the first one kept was
+ *                            computed at, the next ones follow by the
+ *                            decimation.
+ * @return      Number of samples kept. */
+uint32_t filter_run (TFilter   * poFilter,
+                     int16_t  (* pai16Data)[3],
+                     uint32_t  * pau32TimeUs,
+                     uint32_t    u32Cnt,
+                     uint32_t  * pu32First);
+
+//******************************************************************************
+#endif // FILTER_H_740238510753290573210957 //
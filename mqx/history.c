@@ -0,0 +1,121 @@
+/** ****************************************************************************
+ *
+ *  @file       history.c
+ *  @brief      Lock-free history of the accelerometer samples.
+ *
+ *  @copyright  Elnico Ltd. All rights reserved.
+ *
+ ******************************************************************************/
+/*
+ *  THIS SOFTWARE IS PROVIDED BY ELNICO "AS IS" AND ANY EXPRESSED OR
+ *  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ *  OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ *  IN NO EVENT SHALL ELNICO OR ITS CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ *  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ *  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ *  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ *  IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ *  THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************/
+
+#include "history.h"
+
+#include "esl_utils.h"
+
+// the same barrier as the seqlock of the snapshot shared with the A5
+#define HISTORY_BARRIER()               MCC_SNAPSHOT_BARRIER()
+
+//******************************************************************************
+//******************************************************************************
+//******************************************************************************
+
+void history_init (THistory          * poHistory,
+                   const TAccelData  * poFirst)
+{
+  uint32_t i;
+
+  for (i = 0; i < HISTORY_SIZE; ++i) {                                          // no timestamp maps to the slot
+    poHistory->aoSlots[i].u32Seq = i - 1;
+  }
+  poHistory->aoSlots[HISTORY_IDX(poFirst->u32Timestamp)].oData  = *poFirst;
+  poHistory->aoSlots[HISTORY_IDX(poFirst->u32Timestamp)].u32Seq = poFirst->u32Timestamp;
+  poHistory->u32Newest = poFirst->u32Timestamp;
+  HISTORY_BARRIER();
+}
+
+//******************************************************************************
+
+void history_push (THistory          * poHistory,
+                   const TAccelData  * paoSrc,
+                   uint32_t            u32Cnt)
+{
+  uint32_t i;
+
+  if (!u32Cnt) return;
+  for (i = 0; i < u32Cnt; ++i) {
+    THistorySlot * poSlot = &poHistory->aoSlots[HISTORY_IDX(paoSrc[i].u32Timestamp)];
+    poSlot->u32Seq = paoSrc[i].u32Timestamp - 1;                                // readers of the old sample fail from now on
+    HISTORY_BARRIER();
+    poSlot->oData = paoSrc[i];
+    HISTORY_BARRIER();
+    poSlot->u32Seq = paoSrc[i].u32Timestamp;
+  }
+  HISTORY_BARRIER();
+  poHistory->u32Newest = paoSrc[u32Cnt-1].u32Timestamp;
+}
+
+//******************************************************************************
+
+uint32_t history_newest (const THistory * poHistory)
+{
+  uint32_t u32Newest = poHistory->u32Newest;
+
+  HISTORY_BARRIER();                                                            // the slots are read after the timestamp
+  return u32Newest;
+}
+
+//******************************************************************************
+
+uint32_t history_window (uint32_t    u32Newest,
+                         uint32_t    u32MaxCnt,
+                         uint32_t    u32Since,
+                         uint32_t  * pu32Cnt,
+                         uint32_t  * pu32Lost)
+{
+  uint32_t  u32Avail  = MIN(u32Newest, HISTORY_SIZE);                           // timestamp 0 is the initial (unmeasured) value
+  uint32_t  u32Lost   = 0;
+
+  if ((int32_t)(u32Newest - u32Since) < 0) {                                    // consumer ahead of us -> M4 restarted, send everything
+    u32Since = u32Newest - u32Avail;
+  } else {
+    if (u32Since > u32Newest) u32Avail = HISTORY_SIZE;                          // the timestamp wrapped, the ring is full
+    if (u32Newest - u32Since > u32Avail) {                                      // some samples already overwritten
+      u32Lost  = u32Newest - u32Since - u32Avail;
+      u32Since = u32Newest - u32Avail;
+    }
+  }
+
+  *pu32Cnt  = MIN(u32Newest - u32Since, u32MaxCnt);
+  *pu32Lost = u32Lost;
+  return u32Since + 1;
+}
+
+//******************************************************************************
+
+boolean history_get (const THistory  * poHistory,
+                     uint32_t          u32Timestamp,
+                     TAccelData      * poDst)
+{
+  const THistorySlot * poSlot = &poHistory->aoSlots[HISTORY_IDX(u32Timestamp)];
+
+  if (poSlot->u32Seq != u32Timestamp) return FALSE;
+  HISTORY_BARRIER();
+  *poDst = poSlot->oData;
+  HISTORY_BARRIER();
+  return (poSlot->u32Seq == u32Timestamp) ? TRUE : FALSE;                       // not overwritten while copying
+}
+
+//******************************************************************************
@@ -0,0 +1,122 @@
+/** ****************************************************************************
+ *
+ *  @file       history.h
+ *  @brief      Lock-free history of the accelerometer samples.
+ *
+ *  Ring of the last HISTORY_SIZE samples written by a single task (accel_task)
+ *  and read by any number of tasks without a lock. Each slot carries the
+ *  timestamp of the sample it holds: the writer invalidates it, writes the
+ *  sample and sets it, then publishes the newest timestamp. A reader finds
+ *  the samples newer than a timestamp it knows (its cursor) by the newest one
+ *  and copies each sample between two reads of its slot timestamp; a sample
+ *  overwritten meanwhile is reported as lost instead of blocking either side.
+ *
+ *  @copyright  Elnico Ltd. All rights reserved.
+ *
+ ******************************************************************************/
+/*
+ *  THIS SOFTWARE IS PROVIDED BY ELNICO "AS IS" AND ANY EXPRESSED OR
+ *  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ *  OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ *  IN NO EVENT SHALL ELNICO OR ITS CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ *  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ *  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ *  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ *  IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ *  THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************/
+
+#ifndef HISTORY_H_281057392057130572103957
+#define HISTORY_H_281057392057130572103957
+//******************************************************************************
+#include <mqx.h>
+#include <bsp.h>
+#if (MQX_VERSION >= 410)
+# include "psptypes_legacy.h"
+#endif
+
+#include "accelerometer.h"
+
+//******************************************************************************
+// Settings
+//******************************************************************************
+
+/** @def HISTORY_SIZE
+ * @brief Number of samples kept (320 ms at 800 Hz). Must be a power of 2. */
+#ifndef HISTORY_SIZE
+# define HISTORY_SIZE                   (256)
+#endif
+
+#define HISTORY_IDX(ts)                 ((ts) & (HISTORY_SIZE - 1))             //!< Slot of the sample with given timestamp.
+
+//******************************************************************************
+// Public types
+//******************************************************************************
+
+/** One sample of the history. */
+typedef struct t_history_slot_struct {
+  volatile uint32_t u32Seq;                                                     //!< Timestamp of oData, the timestamp less 1 (the one of the previous slot) while oData is being written.
+  TAccelData        oData;                                                      //!< The sample.
+} THistorySlot;
+
+/** Sample history, initialize by history_init(). */
+typedef struct t_history_struct {
+  volatile uint32_t u32Newest;                                                  //!< Timestamp of the newest sample published.
+  THistorySlot      aoSlots[HISTORY_SIZE];                                      //!< Samples, indexed by HISTORY_IDX(u32Timestamp).
+} THistory;
+
+//******************************************************************************
+// Public functions
+//******************************************************************************
+
+/** Empties the history and publishes the first sample. Must be called before
+ *  any reader uses it.
+ * @param[out]  poHistory     History to initialize.
+ * @param[in]   poFirst       First sample, its timestamp 0 stands for an
+ *                            initial (unmeasured) value never read back. */
+void history_init (THistory          * poHistory,
+                   const TAccelData  * poFirst);
+
+/** Saves the samples of one readout and publishes the newest one (the only
+ *  writer).
+ * @param[in,out] poHistory   History.
+ * @param[in]   paoSrc        Samples with consecutive timestamps following the
+ *                            newest one, the oldest first.
+ * @param[in]   u32Cnt        Number of samples in paoSrc. */
+void history_push (THistory          * poHistory,
+                   const TAccelData  * paoSrc,
+                   uint32_t            u32Cnt);
+
+/** Returns the timestamp of the newest sample published, the samples up to
+ *  it may be read then.
+ * @param[in]   poHistory     History. */
+uint32_t history_newest (const THistory * poHistory);
+
+/** Limits a request to the samples available.
+ * @param[in]   u32Newest     Timestamp of the newest sample (history_newest()).
+ * @param[in]   u32MaxCnt     Maximum number of samples requested.
+ * @param[in]   u32Since      Timestamp of the last sample known to the reader.
+ * @param[out]  pu32Cnt       Number of samples to read.
+ * @param[out]  pu32Lost      Number of samples already overwritten.
+ * @return      Timestamp of the first sample to read. */
+uint32_t history_window (uint32_t    u32Newest,
+                         uint32_t    u32MaxCnt,
+                         uint32_t    u32Since,
+                         uint32_t  * pu32Cnt,
+                         uint32_t  * pu32Lost);
+
+/** Copies one sample up to the newest one published.
+ * @param[in]   poHistory     History.
+ * @param[in]   u32Timestamp  Timestamp of the sample.
+ * @param[out]  poDst         Destination of the sample.
+ * @return      TRUE on success, FALSE if the sample has been overwritten
+ *              (*poDst is undefined then). */
+boolean history_get (const THistory  * poHistory,
+                     uint32_t          u32Timestamp,
+                     TAccelData      * poDst);
+
+//******************************************************************************
+#endif // HISTORY_H_281057392057130572103957 //
@@ -39,5 +39,15 @@
 #define ACCEL_MMA845xQ_DEVICE_ADDRESS       ESL_I2C_MMA845XQ_SLAVE_ADDRESS(ACCEL_MMA845xQ_SA0)
 #define ACCEL_MMA845xQ_REG_ADDR_SIZE        ESL_I2C_MMA845XQ_REG_ADDR_SIZE
 
+// MMA8451Q interrupt output wired to the M4: the accelerometer task reads the
+// samples on the data ready or FIFO watermark interrupt of this pin if defined
+// (ESL_GPIO_MODULE_ENABLE with an ISR slot for its port is needed then), by a
+// timer otherwise. The board header names the pin, or define it here.
+#if !defined(ACCEL_MMA845xQ_INT_PIN) && defined(BSP_ACCEL_INT_PIN)
+# define ACCEL_MMA845xQ_INT_PIN             BSP_ACCEL_INT_PIN
+# define ACCEL_MMA845xQ_INT_MUX             BSP_ACCEL_INT_MUX_GPIO
+#endif
+#define ACCEL_MMA845xQ_INT_LINE             (1)                                 // 1: INT1, 2: INT2 of the MMA8451Q drives ACCEL_MMA845xQ_INT_PIN
+
 //******************************************************************************
 #endif // I2CS_H_16520742101654054001145105 //
@@ -46,6 +46,7 @@
 ESL_APPCTRL_TASKID_BEGIN()
   ESL_APPCTRL_TASKID_ADD(STARTUP_TASKID)
   ESL_APPCTRL_TASKID_ADD(MCC_TASKID)
+  ESL_APPCTRL_TASKID_ADD(MCC_BULK_TASKID)
   ESL_APPCTRL_TASKID_ADD(ACCEL_TASKID)
   ESL_APPCTRL_TASKID_ADD(GPIO_TASKID)
 ESL_APPCTRL_TASKID_END()
@@ -56,6 +57,7 @@ ESL_APPCTRL_TASKID_END()
 ESL_APPCTRL_MSGID_BEGIN()
   ESL_APPCTRL_MSGID_ADD(MSGID_STARTUP_READY)
   ESL_APPCTRL_MSGID_ADD(MSGID_MCC_READY)
+  ESL_APPCTRL_MSGID_ADD(MSGID_MCC_BULK_READY)
   ESL_APPCTRL_MSGID_ADD(MSGID_ACCEL_READY)
   ESL_APPCTRL_MSGID_ADD(MSGID_GPIO_READY)
 ESL_APPCTRL_MSGID_END()
@@ -70,7 +72,8 @@ ESL_APPCTRL_TEMPLATE_BEGIN()
   ESL_APPCTRL_TEMPLATE_ADD_ESL(STARTUP_TASKID,  startup_task, STARTUP_TASKSTACK,      17,STARTUP_TASKNAME,  ESL_APPCTRL_SENDMSGONREADY | ESL_APPCTRL_QUITAPPONFAILURE | MSGID_STARTUP_READY )
   ESL_APPCTRL_TEMPLATE_ADD_ESL(  ACCEL_TASKID,    accel_task,   ACCEL_TASKSTACK,      18,  ACCEL_TASKNAME,  ESL_APPCTRL_SENDMSGONREADY | ESL_APPCTRL_QUITAPPONFAILURE | MSGID_ACCEL_READY   )
   ESL_APPCTRL_TEMPLATE_ADD_ESL(   GPIO_TASKID,     gpio_task,    GPIO_TASKSTACK,      16,   GPIO_TASKNAME,  ESL_APPCTRL_SENDMSGONREADY |                                MSGID_GPIO_READY    )
-  ESL_APPCTRL_TEMPLATE_ADD_ESL(    MCC_TASKID,      mcc_task,     MCC_TASKSTACK,      17,    MCC_TASKNAME,  ESL_APPCTRL_SENDMSGONREADY |                                MSGID_MCC_READY     )
+  ESL_APPCTRL_TEMPLATE_ADD_ESL(    MCC_TASKID,      mcc_task,     MCC_TASKSTACK,      16,    MCC_TASKNAME,  ESL_APPCTRL_SENDMSGONREADY |                                MSGID_MCC_READY     )
+  ESL_APPCTRL_TEMPLATE_ADD_ESL(MCC_BULK_TASKID, mcc_bulk_task,MCC_BULK_TASKSTACK,     17,MCC_BULK_TASKNAME,ESL_APPCTRL_SENDMSGONREADY |                                MSGID_MCC_BULK_READY)
 ESL_APPCTRL_TEMPLATE_END()
 
 //******************************************************************************
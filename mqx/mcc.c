@@ -31,8 +31,11 @@
 #include "easyduo_mcc_common.h"
 #include "gpio.h"
 #include "accelerometer.h"
+#include "filter.h"
+#include "timebase.h"
 
 #include "esl_appctrl.h"
+#include "esl_crc.h"
 
 #include "mcc_config.h"
 #include "mcc_common.h"
@@ -41,8 +44,101 @@
 
 #include <mqx.h>
 #include <bsp.h>
+#include <string.h>
+#if defined(__ICCARM__)
+# include <intrinsics.h>
+#endif
 
 
+//******************************************************************************
+// Local definitions
+//******************************************************************************
+
+#define MCC_PUSH_PERIOD_MIN             (20)                                    //!< Minimum push period in milliseconds granted to a subscriber.
+#define MCC_PUSH_PERIOD_MAX             (1000)                                  //!< Maximum push period in milliseconds granted to a subscriber.
+#define MCC_CREDIT_RETRY_US             (10000)                                 //!< Delay before retrying a MCCMSG_CREDIT not sent for lack of buffers.
+#define MCC_READY_WAIT                  (1000)                                  //!< Longest wait in milliseconds of mcc_task for the bulk channel before announcing MCCMSG_READY.
+#define MCC_ACCEL_CONFIG_WAIT           (100)                                   //!< Longest wait in milliseconds for the accelerometer task to apply a MCCMSG_ACCEL_CONFIG.
+#define MCC_SUMMARY_POLL                (20)                                    //!< Period in milliseconds of checking for new summaries while the features are set.
+
+/** @def MCC_SEND_NOCOPY
+ * @brief Set to 1 if the MCC library provides mcc_get_buffer() and
+ *        mcc_send_nocopy(). The messages for the A5 are then composed
+ *        directly in the shared memory, otherwise they are composed in
+ *        TMccChannel::au32TxBuffer and copied there by mcc_send(). */
+#ifndef MCC_SEND_NOCOPY
+# define MCC_SEND_NOCOPY                (0)
+#endif
+
+/** @def MCC_CRC_WORD
+ * @brief Frame word as esl_crc_write32() takes it, the first byte in the MSB
+ *        (the CRC engine of Vybrid cannot transpose the input itself). */
+#if defined(__ICCARM__)
+# define MCC_CRC_WORD(w)                __REV(w)
+#else
+# define MCC_CRC_WORD(w)                __builtin_bswap32(w)
+#endif
+
+/** Received message, framed or bare. */
+typedef struct mcc_rx_struct {
+  TMccMsg         oMsg;                                                         //!< Message body, payload bytes not received are zeroed.
+  uint8_t         u8Version;                                                    //!< Protocol version to reply with.
+  uint8_t         u8PeerVersion;                                                //!< Protocol version of the sender (what it understands).
+  uint8_t         u8Flags;                                                      //!< MCC_HDR_FLAG_CRC if the sender protects its messages, the reply is protected too.
+  uint16_t        u16Ack;                                                       //!< Acknowledged sequence number of our messages (MCC_PROTOCOL_CREDITS).
+  uint32_t        u32Seq;                                                       //!< Sequence number, 0 for bare messages.
+  MCC_MEM_SIZE    size;                                                         //!< Received body size in bytes (including type).
+  uint32_t        u32TimeUs;                                                    //!< timebase_getUs() of the reception.
+} TMccRx;
+
+/** State of one endpoint served by its own task. The control channel carries
+ *  the short latency-sensitive messages, the bulk channel the sample
+ *  transfers and the requests waiting for accel_task (see MCC_MSG_IS_BULK);
+ *  an A5 not knowing the bulk channel sends everything to the control one. */
+typedef struct mcc_channel_struct {
+  const char      * sName;                                                      //!< Task name for the log.
+  MCC_PORT          port;                                                       //!< Local port number.
+  uint8_t           u8Flags;                                                    //!< MCC_HDR_FLAG_* bits of all the messages sent.
+  MCC_ENDPOINT      oEndpoint;                                                  //!< Local endpoint.
+#if !MCC_SEND_NOCOPY
+  uint32_t          au32TxBuffer[MCC_ATTR_BUFFER_SIZE_IN_BYTES / sizeof(uint32_t)];//!< Message composition buffer (too big for the task stack).
+#endif
+  uint32_t          u32TxSeq;                                                   //!< Sequence number of the last framed message sent.
+  uint16_t          u16TxAck;                                                   //!< Last u32TxSeq acknowledged by the A5 (low half).
+  uint32_t          u32RxSeqNext;                                               //!< Expected sequence number of the next framed message, 0 if unknown.
+  uint8_t           u8PeerVersion;                                              //!< Protocol version of the last framed message received.
+  uint8_t           u8PeerFlags;                                                //!< MCC_HDR_FLAG_CRC if the last framed message received was protected.
+  uint32_t          u32RxSeqLast;                                               //!< Sequence number of the last framed message consumed, acknowledged by TMccHdr::u16Ack.
+  uint32_t          u32RxUnacked;                                               //!< Number of messages (but MCCMSG_CREDIT) consumed since the last acknowledgement sent.
+  uint8_t           u8PushVersion;                                              //!< Protocol version of the subscription.
+  uint8_t           u8PushPeerVersion;                                          //!< Protocol version of the subscriber.
+  uint8_t           u8PushFlags;                                                //!< MCC_HDR_FLAG_CRC if the subscriber wants it.
+  uint8_t           u8PushFormat;                                               //!< MCC_ACCEL_FORMAT_RAW if the subscriber takes the raw counts.
+  uint32_t          u32PushWindow;                                              //!< Messages the subscriber can take unacknowledged, 0 for no limit.
+  boolean           bPushStalled;                                               //!< The last push was held back for lack of credit.
+  uint32_t          u32PushPeriod;                                              //!< Push period in milliseconds, 0 if the A5 is not subscribed.
+  uint32_t          u32PushSince;                                               //!< Timestamp of the last pushed sample (the last one filtered if the pushes are filtered).
+  TFilter           oPushFilter;                                                //!< Filter chain of the pushes (MCCMSG_ACCEL_FILTER).
+  TFilter           oPushFilterUndo;                                            //!< oPushFilter before the push being composed, restored if it is not sent.
+  TMccAccelScale    oPushScale;                                                 //!< Conversion of the last sample filtered, the chain restarts on a range change.
+  int16_t           aai16PushWork[MCC_ACCEL_RAW_MAX_SAMPLES][3];                //!< Samples being filtered (too big for the task stack).
+  uint32_t          au32PushWorkUs[MCC_ACCEL_RAW_MAX_SAMPLES];                  //!< Times of aai16PushWork.
+  MQX_TICK_STRUCT   oPushNext;                                                  //!< Time of the next push.
+  boolean           bSummary;                                                   //!< The A5 set vibration features, their summaries are pushed.
+  uint8_t           u8SummaryVersion;                                           //!< Protocol version of the MCCMSG_ACCEL_FEATURES request.
+  uint8_t           u8SummaryFlags;                                             //!< MCC_HDR_FLAG_CRC if the requester wants it.
+  uint32_t          u32SummarySince;                                            //!< Window number of the last summary pushed (or skipped).
+  uint32_t          u32SummaryFirst;                                            //!< Timestamp of the first sample of the features requested, older windows are skipped.
+  boolean           bEvents;                                                    //!< The A5 set an event detection, its events are pushed.
+  uint8_t           u8EventsVersion;                                            //!< Protocol version of the MCCMSG_ACCEL_EVENTS request.
+  uint8_t           u8EventsFlags;                                              //!< MCC_HDR_FLAG_CRC if the requester wants it.
+  uint32_t          u32EventsSince;                                             //!< Number of the last event pushed (or skipped).
+  uint32_t          u32EventsLost;                                              //!< Events skipped as lost since the last push, reported by the next one.
+  MQX_TICK_STRUCT   oSummaryNext;                                               //!< Time of the next check for new summaries and events.
+  TTimebase         oTimebase;                                                  //!< Time base of the PING/PONG times.
+  TMccStats         oStats;                                                     //!< Link statistics (MCCMSG_STATS), written by the channel task only.
+} TMccChannel;
+
 //******************************************************************************
 // Local functions
 //******************************************************************************
@@ -53,13 +149,184 @@
  *            APPMGR_MCC_INIT_FAILURE, APPMGR_MCC_INFO_FAILURE on failure. */
 static uint_8 mcc_init (MCC_NODE iNode);
 
+/** Creates the channel endpoint, reports the task initialized and serves
+ *  the messages received on the endpoint forever.
+ * @param[in] poChannel       Channel of the calling task.
+ * @param[in] u32InitialData  Task initial data. */
+static void mcc_run (TMccChannel * poChannel, uint_32 u32InitialData);
+
+/** Announces the M4 ready to the A5 by MCCMSG_READY once the bulk channel
+ *  is up too (the tasks are initialized in the order of the application
+ *  configuration, mcc_bulk_task the last one), so that the A5 does not have
+ *  to wait for a worst-case boot time. The A5 endpoint may not exist yet,
+ *  the A5 says HELLO then when it starts.
+ * @param[in] poChannel   Control channel. */
+static void mcc_announceReady (TMccChannel * poChannel);
+
+/** Computes the CRC of a frame (see MCC_CRC_POLYNOMIAL) by the CRC engine.
+ * @param[in] pvBuf   Frame start (TMccHdr::u16Magic).
+ * @param[in] u32Len  Frame length without the trailer in bytes.
+ * @return    CRC value. */
+static uint32_t mcc_crc (const void * pvBuf, uint32_t u32Len);
+
+/** Validates a received message and copies its body to poRx.
+ * @param[in]  poChannel  Channel the message was received on (the errors are counted).
+ * @param[in]  pvMsg    Received buffer.
+ * @param[in]  size     Received size in bytes.
+ * @param[out] poRx     Message body and framing information.
+ * @return    TRUE if the message is well formed. */
+static boolean mcc_parse (TMccChannel * poChannel, const void * pvMsg, MCC_MEM_SIZE size, TMccRx * poRx);
+
+/** Checks the sequence number of a framed message against the expected one
+ *  and reports lost or reordered messages.
+ * @param[in] poChannel   Channel the message was received on.
+ * @param[in] poRx        Parsed message. */
+static void mcc_checkSeq (TMccChannel * poChannel, const TMccRx * poRx);
+
+/** Records a framed message as consumed (to be acknowledged) and takes the
+ *  acknowledgement of our messages it carries (MCC_PROTOCOL_CREDITS).
+ * @param[in] poChannel   Channel the message was received on.
+ * @param[in] poRx        Parsed message. */
+static void mcc_takeAck (TMccChannel * poChannel, const TMccRx * poRx);
+
+/** Acknowledges the consumed messages by a MCCMSG_CREDIT if there are at least
+ *  MCC_CREDIT_BATCH(MCC_CREDITS_A5) of them (and nothing else carried the
+ *  acknowledgement).
+ * @param[in] poChannel   Channel to acknowledge the messages of. */
+static void mcc_sendCredit (TMccChannel * poChannel);
+
+/** Retrieves a buffer to compose a message for the A5 in.
+ * @param[in] poChannel   Channel to send the message on.
+ * @param[in] u8Version   Protocol version of the message.
+ * @return    Message body (followed by room for MCC_ACCEL_STREAM_MAX_SAMPLES
+ *            samples), NULL if there is no free buffer. */
+static void * mcc_getTxBuffer (TMccChannel * poChannel, uint8_t u8Version);
+
+/** Completes the header of a message composed in the mcc_getTxBuffer() buffer
+ *  and sends it to the A5 without blocking. The buffer must not be touched
+ *  after this call. A message not sent is counted and logged here.
+ * @param[in] poChannel   Channel passed to mcc_getTxBuffer().
+ * @param[in] pvMsg       Message body returned by mcc_getTxBuffer().
+ * @param[in] u8Version   Protocol version passed to mcc_getTxBuffer().
+ * @param[in] u8Flags     MCC_HDR_FLAG_CRC to append the CRC trailer, 0 otherwise.
+ * @param[in] u32Ref      Sequence number of the answered request, 0 if none.
+ * @param[in] size        Body size in bytes (including type).
+ * @return    MCC_SUCCESS or the mcc_send error code. */
+static int mcc_sendTxBuffer (TMccChannel * poChannel, void * pvMsg, uint8_t u8Version,
+                             uint8_t u8Flags, uint32_t u32Ref, MCC_MEM_SIZE size);
+
+/** Releases the mcc_getTxBuffer() buffer if it is not going to be sent.
+ * @param[in] poChannel   Channel passed to mcc_getTxBuffer().
+ * @param[in] pvMsg       Message body returned by mcc_getTxBuffer().
+ * @param[in] u8Version   Protocol version passed to mcc_getTxBuffer(). */
+static void mcc_freeTxBuffer (TMccChannel * poChannel, void * pvMsg, uint8_t u8Version);
+
+/** Computes the receive timeout until the next subscription push.
+ * @param[in] poChannel   Channel of the subscription.
+ * @return    MCC_WAIT_INF if the A5 is not subscribed.
+ *            Number of microseconds to the next push otherwise (0 if due). */
+static uint_32 mcc_pushTimeout (TMccChannel * poChannel);
+
+/** Copies the samples newer than given timestamp from the accelerometer
+ *  history to a stream message, followed by their times if the peer knows
+ *  them (see MCC_ACCEL_STREAM_TIMES).
+ * @param[out] poStream       Message to fill in u32Count, u32Lost and the samples of.
+ * @param[in]  u32MaxCount    Maximum number of samples requested.
+ * @param[in]  u32Since       Timestamp of the last sample the peer has.
+ * @param[in]  u8PeerVersion  Protocol version of the peer.
+ * @return    Message body size in bytes. */
+static MCC_MEM_SIZE mcc_fillStream (TMccAccelStreamMsg * poStream, uint32_t u32MaxCount,
+                                    uint32_t u32Since, uint8_t u8PeerVersion);
+
+/** Copies the raw counts of the samples newer than given timestamp from the
+ *  accelerometer history to a raw message, followed by their times (see
+ *  MCC_ACCEL_RAW_TIMES).
+ * @param[out] poRaw          Message to fill in all the fields but type of.
+ * @param[in]  u32MaxCount    Maximum number of samples requested.
+ * @param[in]  u32Since       Timestamp of the last sample the peer has.
+ * @return    Message body size in bytes. */
+static MCC_MEM_SIZE mcc_fillRaw (TMccAccelRawMsg * poRaw, uint32_t u32MaxCount, uint32_t u32Since);
+
+/** Runs the samples newer than the last push through the filter chain of the
+ *  subscription and fills the samples kept in a push of its format. Stops
+ *  at a gap or a range change following the first sample kept, so that the
+ *  samples of one message are evenly spaced and of one scale.
+ * @param[in]  poChannel      Channel of the subscription, its filter state
+ *                            advances.
+ * @param[out] pvMsg          TMccAccelRawMsg (MCC_ACCEL_FORMAT_RAW) or
+ *                            TMccAccelStreamMsg to fill in all the fields but
+ *                            type of.
+ * @param[out] pu32Newest     Timestamp of the last sample filtered, kept or
+ *                            not.
+ * @return    Message body size in bytes. */
+static MCC_MEM_SIZE mcc_fillFiltered (TMccChannel * poChannel, void * pvMsg, uint32_t * pu32Newest);
+
+/** Sends the samples measured since the last push to the A5 (if there are
+ *  any) and schedules the next push.
+ * @param[in] poChannel   Channel of the subscription. */
+static void mcc_push (TMccChannel * poChannel);
+
+/** Computes the receive timeout until the next check for new summaries and
+ *  events.
+ * @param[in] poChannel   Channel the features or the detection were set on.
+ * @return    MCC_WAIT_INF if the A5 set neither features nor a detection.
+ *            Number of microseconds to the next check otherwise (0 if due). */
+static uint_32 mcc_summaryTimeout (TMccChannel * poChannel);
+
+/** Sends the summaries computed since the last check to the A5, one message
+ *  each. A summary not sent for lack of credit or buffers stays in the queue
+ *  of the accelerometer task for the next check.
+ * @param[in] poChannel   Channel the features were set on. */
+static void mcc_pushSummaries (TMccChannel * poChannel);
+
+/** Sends the events detected since the last check to the A5, up to
+ *  MCC_ACCEL_EVENT_MAX a message. The events not sent for lack of credit or
+ *  buffers stay in the log of the accelerometer task for the next check.
+ * @param[in] poChannel   Channel the detection was set on. */
+static void mcc_pushEvents (TMccChannel * poChannel);
+
+/** Counts a served message in the latency histogram (see TMccStats).
+ * @param[in] poChannel   Channel the message was received on.
+ * @param[in] u32Us       Time from the reception to the handler return in microseconds. */
+static void mcc_countLatency (TMccChannel * poChannel, uint32_t u32Us);
+
+//******************************************************************************
+// Message handlers
+//******************************************************************************
+
+/** Serves a message received from the A5, one mcc_on<Name> per MCC_MSG_TABLE
+ *  row sent by the A5 (replies in the format of the request).
+ * @param[in] poChannel   Channel the message was received on.
+ * @param[in] poRx        Parsed message. */
+typedef void (*TMccHandler) (TMccChannel * poChannel, const TMccRx * poRx);
+
+#define MCC_HANDLER_DECLARE_A5(name)    static void mcc_on##name (TMccChannel * poChannel, const TMccRx * poRx);
+#define MCC_HANDLER_DECLARE_M4(name)                                            // never received
+#define MCC_HANDLER_DECLARE(id, name, channel, sender, req, rep)  MCC_HANDLER_DECLARE_##sender(name)
+#define MCC_HANDLER_ENTRY_A5(name)      mcc_on##name,
+#define MCC_HANDLER_ENTRY_M4(name)      NULL,
+#define MCC_HANDLER_ENTRY(id, name, channel, sender, req, rep)    MCC_HANDLER_ENTRY_##sender(name)
+
+MCC_MSG_TABLE(MCC_HANDLER_DECLARE)
+
 //******************************************************************************
 // Globals
 //******************************************************************************
-static MCC_ENDPOINT g_mccEndpointLocal;                                         //!< Local EasyDuo MCC endpoint.
+static const TMccHandler g_apfnHandlers[MCCMSG_COUNT] = {
+  NULL,                                                                         // MCCMSG_RESERVED
+  MCC_MSG_TABLE(MCC_HANDLER_ENTRY)
+};                                                                              //!< Message handlers indexed by the message type.
 static MCC_ENDPOINT g_mccEndpointRemote = { MCC_ENDPOINT_A5_CORE,
                                             MCC_ENDPOINT_A5_NODE,
                                             MCC_ENDPOINT_A5_PORT };             //!< Remote EasyDuo MCC endpoint.
+static TMccChannel  g_oControl = { .sName   = MCC_TASKNAME,
+                                   .port    = MCC_ENDPOINT_M4_PORT,
+                                   .u8Flags = 0 };                              //!< Control channel, served by mcc_task.
+static TMccChannel  g_oBulk    = { .sName   = MCC_BULK_TASKNAME,
+                                   .port    = MCC_ENDPOINT_M4_BULK_PORT,
+                                   .u8Flags = MCC_HDR_FLAG_BULK };              //!< Bulk channel, served by mcc_bulk_task.
+static LWSEM_STRUCT g_lwsemCrc;                                                 //!< Guards the CRC engine shared by the channel tasks.
+static LWSEM_STRUCT g_lwsemBulkUp;                                              //!< Posted by mcc_bulk_task once its endpoint exists.
 
 //******************************************************************************
 //******************************************************************************
@@ -67,11 +334,7 @@ static MCC_ENDPOINT g_mccEndpointRemote = { MCC_ENDPOINT_A5_CORE,
 
 void mcc_task (uint_32 u32InitialData)
 {
-  TMccMsg       * poMsg;
-  TMccMsg         oMsg;
-  MCC_MEM_SIZE    size;
-  TAccelData      oAccelData;
-  int             ret;
+  int ret;
 
   ret = mcc_init (MCC_ENDPOINT_M4_NODE);
   if (MCC_OK != ret) {
@@ -79,85 +342,476 @@ void mcc_task (uint_32 u32InitialData)
     ESL_APPCTRL_INITDONE (u32InitialData, ret);
   }
 
-  ret = mcc_create_endpoint(&g_mccEndpointLocal, MCC_ENDPOINT_M4_PORT);
+  mcc_run(&g_oControl, u32InitialData);
+}
+
+//******************************************************************************
+
+void mcc_bulk_task (uint_32 u32InitialData)
+{
+  mcc_run(&g_oBulk, u32InitialData);                                            // MCC initialized by mcc_task
+}
+
+//******************************************************************************
+
+static void mcc_run (TMccChannel * poChannel, uint_32 u32InitialData)
+{
+  void                * pvMsg;
+  TMccRx                oRx;
+  boolean               bValid;
+  MCC_MEM_SIZE          size;
+  uint_32               u32Timeout;
+  uint_32               u32SummaryTimeout;
+  unsigned int          uQueued;
+  int                   ret;
+
+  ret = mcc_create_endpoint(&poChannel->oEndpoint, poChannel->port);
   if (MCC_SUCCESS != ret) {
     LOGE_FORMATTED("mcc_create_endpoint() failed: %d, node,port: %d, %d",
-                   ret, MCC_ENDPOINT_M4_NODE, MCC_ENDPOINT_M4_PORT);
+                   ret, MCC_ENDPOINT_M4_NODE, poChannel->port);
     ESL_APPCTRL_INITDONE (u32InitialData, MCC_ENDPOINT_FAILURE);
   }
 
   ESL_APPCTRL_INITDONE (u32InitialData, MQX_OK);
 
+  if (&g_oBulk == poChannel) {
+    _lwsem_post(&g_lwsemBulkUp);
+  } else {
+    mcc_announceReady(poChannel);
+  }
+
   // Infinite message loop -----------------------------------------------------
   while (1) {
-    // Wait for a message
-    ret = mcc_recv_nocopy(&g_mccEndpointLocal, (void**)&poMsg, &size, MCC_WAIT_INF);  // blocking call
-    if (MCC_SUCCESS != ret) {
-      LOGE_FORMATTED("mcc_task mcc_recv_nocopy failed: %d", ret);
+    // Push the subscribed samples if the period elapsed
+    u32Timeout = mcc_pushTimeout(poChannel);
+    if (0 == u32Timeout) {
+      mcc_push(poChannel);
+      continue;
+    }
+    u32SummaryTimeout = mcc_summaryTimeout(poChannel);
+    if (0 == u32SummaryTimeout) {
+      _time_get_elapsed_ticks(&poChannel->oSummaryNext);                        // nothing to catch up on
+      _time_add_msec_to_ticks(&poChannel->oSummaryNext, MCC_SUMMARY_POLL);
+      if (poChannel->bSummary) mcc_pushSummaries(poChannel);
+      if (poChannel->bEvents)  mcc_pushEvents(poChannel);
+      continue;
+    }
+    u32Timeout = MIN(u32Timeout, u32SummaryTimeout);
+    if (poChannel->u32RxUnacked >= MCC_CREDIT_BATCH(MCC_CREDITS_A5)) {          // the MCCMSG_CREDIT failed
+      u32Timeout = MIN(u32Timeout, MCC_CREDIT_RETRY_US);
+    }
+
+    // Wait for a message (or for the next push)
+    ret = mcc_recv_nocopy(&poChannel->oEndpoint, &pvMsg, &size, u32Timeout);    // blocking call
+    if (MCC_ERR_TIMEOUT == ret) {                                               // time for a push, nothing was expected
+      mcc_sendCredit(poChannel);
+      continue;
+    } else if (MCC_SUCCESS != ret) {
+      ++poChannel->oStats.u32RxErrors;
+      LOGE_FORMATTED("%s mcc_recv_nocopy failed: %d", poChannel->sName, ret);
       continue;
     }
-    if (size != sizeof(TMccMsg)) {
-      LOGE_FORMATTED("mcc_task invalid size received: %d", size);
+    oRx.u32TimeUs = timebase_getUs(&poChannel->oTimebase);
+    if (MCC_SUCCESS == mcc_msgs_available(&poChannel->oEndpoint, &uQueued)) {   // the ones behind this one
+      poChannel->oStats.u32QueueDepth = uQueued;
+      poChannel->oStats.u32QueueMax = MAX(poChannel->oStats.u32QueueMax, uQueued);
+    }
+    bValid = mcc_parse(poChannel, pvMsg, size, &oRx);
+
+    // Release the mcc buffer, the message is copied in oRx
+    ret = mcc_free_buffer(pvMsg);
+    if (MCC_SUCCESS != ret) {
+      LOGW_FORMATTED("%s mcc_free_buffer failed: %d", poChannel->sName, ret);
+    }
+    if (!bValid) {
+      LOGE_FORMATTED("%s invalid message received, size %d", poChannel->sName, size);
       continue;
     }
+    mcc_checkSeq(poChannel, &oRx);
+    mcc_takeAck(poChannel, &oRx);
 
     // Evaluate the message
-    switch (poMsg->type) {
+    if (((uint32_t)oRx.oMsg.type < MCCMSG_COUNT) && g_apfnHandlers[oRx.oMsg.type]) {
+      ++poChannel->oStats.au32Rx[oRx.oMsg.type];
+      g_apfnHandlers[oRx.oMsg.type](poChannel, &oRx);
+      mcc_countLatency(poChannel, timebase_getUs(&poChannel->oTimebase) - oRx.u32TimeUs);
+    } else {
+      ++poChannel->oStats.au32Rx[MCCMSG_RESERVED];
+      LOGW_FORMATTED("%s unrecognized message: %d", poChannel->sName, oRx.oMsg.type);
+    }
 
-    case MCCMSG_LED_ON:
-      gpio_setLedOn();
-      break;
+    // Acknowledge the messages not answered
+    mcc_sendCredit(poChannel);
+  }
+}
 
-    case MCCMSG_LED_OFF:
-      gpio_setLedOff();
-      break;
+//******************************************************************************
+// Message handlers
+//******************************************************************************
 
-    case MCCMSG_LED_AUTO:
-      gpio_setLedAuto();
-      break;
+static void mcc_onLedOn (TMccChannel * poChannel, const TMccRx * poRx)
+{
+  (void)poChannel;
+  (void)poRx;
+  gpio_setLedOn();
+}
 
-    case MCCMSG_ACCEL_INFO:
-      oMsg.type = MCCMSG_ACCEL_INFO;
-      oMsg.iAccelType = accel_getIdentifier();
-      ret = mcc_send(&g_mccEndpointRemote, &oMsg, sizeof(oMsg), 0);             // non-blocking call
-      if (MCC_OK != ret) {
-        LOGE_FORMATTED("mcc_task mcc_send failed: %d", ret);
-      }
-      break;
+//******************************************************************************
 
-    case MCCMSG_ACCEL_DATA:
-      oMsg.type = MCCMSG_ACCEL_DATA;
-      ret = accel_getLastData (&oAccelData, MSECS_TO_MQX_TICKS(1));
-      if (ACCEL_OK != ret) {
-        LOGW_FORMATTED("mcc_task accel_getLastData failed: %d", ret);
-        oMsg.fDataX = oMsg.fDataY = oMsg.fDataZ = 0.0f;
-      } else {
-        oMsg.fDataX = oAccelData.afData[0];
-        oMsg.fDataY = oAccelData.afData[1];
-        oMsg.fDataZ = oAccelData.afData[2];
-      }
-      ret = mcc_send(&g_mccEndpointRemote, &oMsg, sizeof(oMsg), 0);             // non-blocking call
-      if (MCC_OK != ret) {
-        LOGE_FORMATTED("mcc_task mcc_send failed: %d", ret);
-      }
-      break;
+static void mcc_onLedOff (TMccChannel * poChannel, const TMccRx * poRx)
+{
+  (void)poChannel;
+  (void)poRx;
+  gpio_setLedOff();
+}
 
-    default:
-      LOGW_FORMATTED("mcc_task unrecognized message: %d", poMsg->type);
-      break;
+//******************************************************************************
+
+static void mcc_onLedAuto (TMccChannel * poChannel, const TMccRx * poRx)
+{
+  (void)poChannel;
+  (void)poRx;
+  gpio_setLedAuto();
+}
+
+//******************************************************************************
+
+static void mcc_onAccelInfo (TMccChannel * poChannel, const TMccRx * poRx)
+{
+  TMccMsg * poReply;
+
+  poReply = (TMccMsg*)mcc_getTxBuffer(poChannel, poRx->u8Version);
+  if (!poReply) return;
+  poReply->type = MCCMSG_ACCEL_INFO;
+  poReply->iAccelType = accel_getIdentifier();
+  mcc_sendTxBuffer(poChannel, poReply, poRx->u8Version, poRx->u8Flags, poRx->u32Seq, sizeof(TMccMsg));  // non-blocking call
+}
+
+//******************************************************************************
+
+static void mcc_onAccelData (TMccChannel * poChannel, const TMccRx * poRx)
+{
+  TMccAccelDataMsg  * poReply;
+  TAccelData          oAccelData;
+  MCC_MEM_SIZE        size;
+  int                 ret;
+
+  poReply = (TMccAccelDataMsg*)mcc_getTxBuffer(poChannel, poRx->u8Version);
+  if (!poReply) return;
+  poReply->type = MCCMSG_ACCEL_DATA;
+  ret = accel_getLastData (&oAccelData, MSECS_TO_MQX_TICKS(1));
+  if (ACCEL_OK != ret) {
+    LOGW_FORMATTED("%s accel_getLastData failed: %d", poChannel->sName, ret);
+    memset(&oAccelData, 0, sizeof(oAccelData));
+  }
+  poReply->afData[0] = oAccelData.afData[0];
+  poReply->afData[1] = oAccelData.afData[1];
+  poReply->afData[2] = oAccelData.afData[2];
+  size = sizeof(TMccMsg);
+  if (poRx->u8PeerVersion >= MCC_PROTOCOL_TIMESTAMPS) {                         // the peer knows the longer reply
+    poReply->u32Timestamp = oAccelData.u32Timestamp;
+    poReply->u32TimeUs    = oAccelData.u32TimeUs;
+    size = sizeof(TMccAccelDataMsg);
+  }
+  mcc_sendTxBuffer(poChannel, poReply, poRx->u8Version, poRx->u8Flags, poRx->u32Seq, size);  // non-blocking call
+}
+
+//******************************************************************************
+
+static void mcc_onAccelStream (TMccChannel * poChannel, const TMccRx * poRx)
+{
+  TMccAccelStreamMsg  * poStream;
+  MCC_MEM_SIZE          size;
+
+  poStream = (TMccAccelStreamMsg*)mcc_getTxBuffer(poChannel, poRx->u8Version);
+  if (!poStream) return;
+  poStream->type = MCCMSG_ACCEL_STREAM;
+  size = mcc_fillStream(poStream, poRx->oMsg.u32MaxCount, poRx->oMsg.u32Since, poRx->u8PeerVersion);
+  mcc_sendTxBuffer(poChannel, poStream, poRx->u8Version, poRx->u8Flags, poRx->u32Seq, size);  // non-blocking call
+}
+
+//******************************************************************************
+
+static void mcc_onAccelRawStream (TMccChannel * poChannel, const TMccRx * poRx)
+{
+  TMccAccelRawMsg * poRaw;
+  MCC_MEM_SIZE      size;
+
+  poRaw = (TMccAccelRawMsg*)mcc_getTxBuffer(poChannel, poRx->u8Version);
+  if (!poRaw) return;
+  poRaw->type = MCCMSG_ACCEL_RAW_STREAM;
+  size = mcc_fillRaw(poRaw, poRx->oMsg.u32MaxCount, poRx->oMsg.u32Since);
+  mcc_sendTxBuffer(poChannel, poRaw, poRx->u8Version, poRx->u8Flags, poRx->u32Seq, size);  // non-blocking call
+}
+
+//******************************************************************************
+
+static void mcc_onAccelSubscribe (TMccChannel * poChannel, const TMccRx * poRx)
+{
+  TMccMsg     * poReply;
+  TAccelData    oAccelData;
+  int           ret;
+
+  poChannel->u32PushPeriod = MIN(MAX(poRx->oMsg.u32PeriodMs, MCC_PUSH_PERIOD_MIN), MCC_PUSH_PERIOD_MAX);
+  poChannel->u8PushVersion = poRx->u8Version;                                   // push in the format of the subscriber
+  poChannel->u8PushPeerVersion = poRx->u8PeerVersion;
+  poChannel->u8PushFlags = poRx->u8Flags;
+  poChannel->u32PushWindow = (poRx->u8PeerVersion >= MCC_PROTOCOL_CREDITS) ? poRx->oMsg.u32Credits : 0;
+  poChannel->u8PushFormat = ((poRx->u8PeerVersion >= MCC_PROTOCOL_RAW)          // older peers leave the field undefined
+                             && (MCC_ACCEL_FORMAT_RAW == poRx->oMsg.u32Format))
+                            ? MCC_ACCEL_FORMAT_RAW : MCC_ACCEL_FORMAT_FLOAT;
+  poChannel->u16TxAck = (uint16_t)poChannel->u32TxSeq;                          // a new subscriber has nothing in flight
+  poChannel->bPushStalled = FALSE;
+  ret = accel_getLastData (&oAccelData, MSECS_TO_MQX_TICKS(1));                 // start with the current sample
+  poChannel->u32PushSince = ((ACCEL_OK == ret) || (ACCEL_OUTDATED == ret)) ? oAccelData.u32Timestamp : 0;
+  filter_reset(&poChannel->oPushFilter);                                        // nothing to continue from
+  _time_get_elapsed_ticks(&poChannel->oPushNext);
+  _time_add_msec_to_ticks(&poChannel->oPushNext, poChannel->u32PushPeriod);
+  LOGI_FORMATTED("%s A5 subscribed, period %d ms, format %d", poChannel->sName,
+                 poChannel->u32PushPeriod, poChannel->u8PushFormat);
+  poReply = (TMccMsg*)mcc_getTxBuffer(poChannel, poRx->u8Version);
+  if (!poReply) return;
+  poReply->type = MCCMSG_ACCEL_SUBSCRIBE;
+  poReply->u32PeriodMs = poChannel->u32PushPeriod;
+  poReply->u32Credits = poChannel->u32PushWindow;
+  poReply->u32Format = poChannel->u8PushFormat;
+  mcc_sendTxBuffer(poChannel, poReply, poRx->u8Version, poRx->u8Flags, poRx->u32Seq, sizeof(TMccMsg));  // non-blocking call
+}
+
+//******************************************************************************
+
+static void mcc_onAccelUnsubscribe (TMccChannel * poChannel, const TMccRx * poRx)
+{
+  TMccMsg * poReply;
+
+  poChannel->u32PushPeriod = 0;
+  LOGI_FORMATTED("%s A5 unsubscribed", poChannel->sName);
+  poReply = (TMccMsg*)mcc_getTxBuffer(poChannel, poRx->u8Version);
+  if (!poReply) return;
+  poReply->type = MCCMSG_ACCEL_UNSUBSCRIBE;
+  poReply->u32PeriodMs = 0;
+  mcc_sendTxBuffer(poChannel, poReply, poRx->u8Version, poRx->u8Flags, poRx->u32Seq, sizeof(TMccMsg));  // non-blocking call
+}
+
+//******************************************************************************
+
+static void mcc_onHello (TMccChannel * poChannel, const TMccRx * poRx)
+{
+  TMccMsg * poReply;
+
+  LOGI_FORMATTED("%s A5 protocol version %d", poChannel->sName, poRx->oMsg.u32Version);
+  poReply = (TMccMsg*)mcc_getTxBuffer(poChannel, poRx->u8Version);
+  if (!poReply) return;
+  poReply->type = MCCMSG_HELLO;
+  poReply->u32Version = MIN(poRx->oMsg.u32Version, MCC_PROTOCOL_VERSION);
+  mcc_sendTxBuffer(poChannel, poReply, poRx->u8Version, poRx->u8Flags, poRx->u32Seq, sizeof(TMccMsg));  // non-blocking call
+}
+
+//******************************************************************************
+
+static void mcc_onPing (TMccChannel * poChannel, const TMccRx * poRx)
+{
+  TMccPingMsg * poPing;
+
+  poPing = (TMccPingMsg*)mcc_getTxBuffer(poChannel, poRx->u8Version);
+  if (!poPing) return;
+  poPing->type          = MCCMSG_PONG;                                          // payload not copied, only the size matters
+  poPing->u32A5TimeUs   = poRx->oMsg.u32PingTimeUs;
+  poPing->u32M4RxTimeUs = poRx->u32TimeUs;
+  poPing->u32M4TxTimeUs = timebase_getUs(&poChannel->oTimebase);
+  mcc_sendTxBuffer(poChannel, poPing, poRx->u8Version, poRx->u8Flags, poRx->u32Seq,
+                   MIN(MAX(poRx->size, MCC_PING_HEADER_SIZE), MCC_PING_HEADER_SIZE + MCC_PING_MAX_PAYLOAD));  // non-blocking call
+}
+
+//******************************************************************************
+
+static void mcc_onCredit (TMccChannel * poChannel, const TMccRx * poRx)
+{
+  (void)poChannel;                                                              // acknowledgement only, taken by mcc_takeAck()
+  (void)poRx;
+}
+
+//******************************************************************************
+
+static void mcc_onHeartbeat (TMccChannel * poChannel, const TMccRx * poRx)
+{
+  TMccMsg     * poReply;
+  TIME_STRUCT   oTime;
+
+  poReply = (TMccMsg*)mcc_getTxBuffer(poChannel, poRx->u8Version);
+  if (!poReply) return;
+  poReply->type = MCCMSG_HEARTBEAT;
+  _time_get_elapsed(&oTime);
+  poReply->u32UptimeMs = oTime.SECONDS * 1000 + oTime.MILLISECONDS;             // the A5 sees a reboot as the uptime going back
+  mcc_sendTxBuffer(poChannel, poReply, poRx->u8Version, poRx->u8Flags, poRx->u32Seq, sizeof(TMccMsg));  // non-blocking call
+}
+
+//******************************************************************************
+
+static void mcc_onStats (TMccChannel * poChannel, const TMccRx * poRx)
+{
+  TMccStatsMsg  * poReply;
+
+  poReply = (TMccStatsMsg*)mcc_getTxBuffer(poChannel, poRx->u8Version);
+  if (!poReply) return;
+  poReply->type = MCCMSG_STATS;
+  poReply->u32Channel = (MCC_MSG_CHANNEL_BULK == poRx->oMsg.u32Channel) ? MCC_MSG_CHANNEL_BULK : MCC_MSG_CHANNEL_CONTROL;
+  memcpy(&poReply->oStats,                                                      // the bulk task may be counting meanwhile
+         (MCC_MSG_CHANNEL_BULK == poReply->u32Channel) ? &g_oBulk.oStats : &g_oControl.oStats,
+         sizeof(TMccStats));
+  mcc_sendTxBuffer(poChannel, poReply, poRx->u8Version, poRx->u8Flags, poRx->u32Seq, sizeof(TMccStatsMsg));  // non-blocking call
+}
+
+//******************************************************************************
+
+static void mcc_onAccelConfig (TMccChannel * poChannel, const TMccRx * poRx)
+{
+  TMccAccelConfigMsg  * poReply;
+  int                   ret = ACCEL_OK;
+
+  // the accelerometer task applies the change between two readouts
+  if (poRx->oMsg.u32AccelSet) {
+    ret = accel_setConfig (&poRx->oMsg.oAccelConfig, poRx->oMsg.u32AccelSet,
+                           MSECS_TO_MQX_TICKS(MCC_ACCEL_CONFIG_WAIT));
+    if (ACCEL_OK != ret) LOGW_FORMATTED("%s accel_setConfig failed: %d", poChannel->sName, ret);
+  }
+
+  poReply = (TMccAccelConfigMsg*)mcc_getTxBuffer(poChannel, poRx->u8Version);
+  if (!poReply) return;
+  poReply->type = MCCMSG_ACCEL_CONFIG;
+  switch (ret) {
+  case ACCEL_OK:                poReply->i32Status = MCC_ACCEL_CONFIG_OK;      break;
+  case ACCEL_INVALID_ARGUMENT:  poReply->i32Status = MCC_ACCEL_CONFIG_INVALID; break;
+  case ACCEL_DEVICE_FAILURE:    poReply->i32Status = MCC_ACCEL_CONFIG_FAILED;  break;
+  default:                      poReply->i32Status = MCC_ACCEL_CONFIG_TIMEOUT; break;
+  }
+  accel_getConfig(&poReply->oConfig, &poReply->u32PeriodUs);
+  accel_getScale(&poReply->oScale);
+  mcc_sendTxBuffer(poChannel, poReply, poRx->u8Version, poRx->u8Flags, poRx->u32Seq, sizeof(TMccAccelConfigMsg));  // non-blocking call
+}
+
+//******************************************************************************
+
+static void mcc_onAccelFilter (TMccChannel * poChannel, const TMccRx * poRx)
+{
+  TMccAccelFilterMsg  * poReply;
+  TMccAccelConfig       oConfig;
+  uint32_t              u32PeriodUs;
+  int32_t               i32Status = MCC_ACCEL_FILTER_OK;
+
+  // served by the task of the subscription, the pushes composed after the
+  // reply are filtered by the new chain
+  if (poRx->oMsg.u32FilterSet) {
+    accel_getConfig(&oConfig, &u32PeriodUs);
+    if (filter_setup(&poChannel->oPushFilter, &poRx->oMsg.oAccelFilter, u32PeriodUs)) {
+      LOGI_FORMATTED("%s push filter: high-pass %u cHz, low-pass %u dHz, average %u, decimation %u",
+                     poChannel->sName,
+                     poChannel->oPushFilter.oSettings.u16HighPassCentiHz,
+                     poChannel->oPushFilter.oSettings.u16LowPassDeciHz,
+                     poChannel->oPushFilter.oSettings.u8Average,
+                     poChannel->oPushFilter.oSettings.u8Decimation);
+    } else {
+      LOGW_FORMATTED("%s push filter out of range", poChannel->sName);
+      i32Status = MCC_ACCEL_FILTER_INVALID;
     }
+  }
 
-    // Release the mcc buffer
-    ret = mcc_free_buffer(poMsg);
-    if (MCC_SUCCESS != ret) {
-      LOGW_FORMATTED("mcc_task mcc_free_buffer failed: %d", ret);
-      continue;
+  poReply = (TMccAccelFilterMsg*)mcc_getTxBuffer(poChannel, poRx->u8Version);
+  if (!poReply) return;
+  poReply->type      = MCCMSG_ACCEL_FILTER;
+  poReply->i32Status = i32Status;
+  poReply->oFilter   = poChannel->oPushFilter.oSettings;
+  mcc_sendTxBuffer(poChannel, poReply, poRx->u8Version, poRx->u8Flags, poRx->u32Seq, sizeof(TMccAccelFilterMsg));  // non-blocking call
+}
+
+//******************************************************************************
+
+static void mcc_onAccelFeatures (TMccChannel * poChannel, const TMccRx * poRx)
+{
+  TMccAccelFeaturesMsg  * poReply;
+  TMccAccelFeatures       oFeatures;
+  TMccAccelConfig         oConfig;
+  TAccelData              oAccelData;
+  uint32_t                u32PeriodUs;
+  int32_t                 i32Status = MCC_ACCEL_FEATURES_OK;
+  int                     ret;
+
+  // the accelerometer task computes the summaries, the task of the request
+  // pushes them after the reply
+  if (poRx->oMsg.u32FeaturesSet) {
+    ret = accel_setFeatures(&poRx->oMsg.oAccelFeatures, MSECS_TO_MQX_TICKS(MCC_ACCEL_CONFIG_WAIT));
+    if (ACCEL_OK == ret) {
+      poChannel->u8SummaryVersion = poRx->u8Version;                            // push in the format of the requester
+      poChannel->u8SummaryFlags   = poRx->u8Flags;
+      ret = accel_getLastData (&oAccelData, MSECS_TO_MQX_TICKS(1));             // the windows of the new features start later
+      poChannel->u32SummaryFirst  = (((ACCEL_OK == ret) || (ACCEL_OUTDATED == ret)) ? oAccelData.u32Timestamp : 0) + 1;
+      poChannel->bSummary         = poRx->oMsg.oAccelFeatures.u16Length ? TRUE : FALSE;
+      _time_get_elapsed_ticks(&poChannel->oSummaryNext);
+      _time_add_msec_to_ticks(&poChannel->oSummaryNext, MCC_SUMMARY_POLL);
+      LOGI_FORMATTED("%s features: window %u, %u bands", poChannel->sName,
+                     poRx->oMsg.oAccelFeatures.u16Length, poRx->oMsg.oAccelFeatures.u8Bands);
+    } else {
+      LOGW_FORMATTED("%s accel_setFeatures failed: %d", poChannel->sName, ret);
+      i32Status = (ACCEL_INVALID_ARGUMENT == ret) ? MCC_ACCEL_FEATURES_INVALID : MCC_ACCEL_FEATURES_TIMEOUT;
     }
   }
+
+  accel_getFeatures(&oFeatures);
+  accel_getConfig(&oConfig, &u32PeriodUs);
+  poReply = (TMccAccelFeaturesMsg*)mcc_getTxBuffer(poChannel, poRx->u8Version);
+  if (!poReply) return;
+  poReply->type        = MCCMSG_ACCEL_FEATURES;
+  poReply->i32Status   = i32Status;
+  poReply->oFeatures   = oFeatures;
+  poReply->u32PeriodUs = u32PeriodUs;
+  mcc_sendTxBuffer(poChannel, poReply, poRx->u8Version, poRx->u8Flags, poRx->u32Seq, sizeof(TMccAccelFeaturesMsg));  // non-blocking call
 }
 
 //******************************************************************************
 
+static void mcc_onAccelEvents (TMccChannel * poChannel, const TMccRx * poRx)
+{
+  TMccAccelEventsMsg    * poReply;
+  const TMccAccelEvents * poReq = &poRx->oMsg.oAccelEvents;
+  int                     ret = ACCEL_OK;
+
+  // the accelerometer task reads the events on the interrupt, the task of
+  // the request pushes them after the reply
+  if (poRx->oMsg.u32EventsSet) {
+    ret = accel_setEvents(poReq, MSECS_TO_MQX_TICKS(MCC_ACCEL_CONFIG_WAIT));
+    if (ACCEL_OK == ret) {
+      poChannel->u8EventsVersion = poRx->u8Version;                             // push in the format of the requester
+      poChannel->u8EventsFlags   = poRx->u8Flags;
+      poChannel->u32EventsSince  = accel_lastEvent();                           // the events of the previous detection are skipped
+      poChannel->u32EventsLost   = 0;
+      poChannel->bEvents         = (poReq->u8MotionThs || poReq->u8FreefallThs
+                                    || poReq->u8TransientThs || poReq->u8TapThs) ? TRUE : FALSE;
+      _time_get_elapsed_ticks(&poChannel->oSummaryNext);
+      _time_add_msec_to_ticks(&poChannel->oSummaryNext, MCC_SUMMARY_POLL);
+      LOGI_FORMATTED("%s events: motion %u, freefall %u, transient %u, tap %u", poChannel->sName,
+                     poReq->u8MotionThs, poReq->u8FreefallThs, poReq->u8TransientThs, poReq->u8TapThs);
+    } else {
+      LOGW_FORMATTED("%s accel_setEvents failed: %d", poChannel->sName, ret);
+    }
+  }
+
+  poReply = (TMccAccelEventsMsg*)mcc_getTxBuffer(poChannel, poRx->u8Version);
+  if (!poReply) return;
+  poReply->type = MCCMSG_ACCEL_EVENTS;
+  switch (ret) {
+  case ACCEL_OK:                poReply->i32Status = MCC_ACCEL_EVENTS_OK;      break;
+  case ACCEL_INVALID_ARGUMENT:  poReply->i32Status = MCC_ACCEL_EVENTS_INVALID; break;
+  case ACCEL_DEVICE_FAILURE:    poReply->i32Status = MCC_ACCEL_EVENTS_FAILED;  break;
+  default:                      poReply->i32Status = MCC_ACCEL_EVENTS_TIMEOUT; break;
+  }
+  accel_getEvents(&poReply->oEvents);
+  mcc_sendTxBuffer(poChannel, poReply, poRx->u8Version, poRx->u8Flags, poRx->u32Seq, sizeof(TMccAccelEventsMsg));  // non-blocking call
+}
+
+//******************************************************************************
+//******************************************************************************
+//******************************************************************************
+
 static uint_8 mcc_init (MCC_NODE iNode)
 {
   MCC_INFO_STRUCT   mccInfo;
@@ -183,7 +837,629 @@ static uint_8 mcc_init (MCC_NODE iNode)
     LOGI_FORMATTED("MCC version %s loaded", mccInfo.version_string);
   }
 
+  // CRC engine for the MCC_HDR_FLAG_CRC trailers
+  ret = _lwsem_create(&g_lwsemCrc, 1);
+  if (MQX_OK != ret) {
+    LOGE_FORMATTED("_lwsem_create failed: %d", ret);
+    mcc_destroy(iNode);
+    return MCC_CRC_FAILURE;
+  }
+  ret = esl_crc_init(ESL_CRC_WIDTH_32_BIT, MCC_CRC_POLYNOMIAL, MCC_CRC_SEED);
+  if (ESL_CRC_OK != ret) {
+    LOGE_FORMATTED("esl_crc_init failed: %d", ret);
+    _lwsem_destroy(&g_lwsemCrc);
+    mcc_destroy(iNode);
+    return MCC_CRC_FAILURE;
+  }
+
+  // MCCMSG_READY waits for the bulk channel
+  ret = _lwsem_create(&g_lwsemBulkUp, 0);
+  if (MQX_OK != ret) {
+    LOGE_FORMATTED("_lwsem_create failed: %d", ret);
+    _lwsem_destroy(&g_lwsemCrc);
+    mcc_destroy(iNode);
+    return MCC_INIT_FAILURE;
+  }
+
   return MCC_OK;
 }
 
 //******************************************************************************
+
+static void mcc_announceReady (TMccChannel * poChannel)
+{
+  TMccMsg     * poReady;
+  TIME_STRUCT   oTime;
+  uint32_t      u32UptimeMs;
+
+  if (MQX_OK != _lwsem_wait_ticks(&g_lwsemBulkUp, MSECS_TO_MQX_TICKS(MCC_READY_WAIT))) {
+    LOGW_STR("bulk channel not up, announcing the control channel only");
+  }
+
+  poReady = (TMccMsg*)mcc_getTxBuffer(poChannel, MCC_PROTOCOL_VERSION);
+  if (!poReady) return;
+  _time_get_elapsed(&oTime);
+  u32UptimeMs = oTime.SECONDS * 1000 + oTime.MILLISECONDS;
+  poReady->type = MCCMSG_READY;
+  poReady->u32UptimeMs = u32UptimeMs;
+  if (MCC_SUCCESS == mcc_sendTxBuffer(poChannel, poReady, MCC_PROTOCOL_VERSION, 0, 0, sizeof(TMccMsg))) {  // non-blocking call
+    LOGI_FORMATTED("%s M4 ready after %u ms", poChannel->sName, (unsigned)u32UptimeMs);
+  }
+}
+
+//******************************************************************************
+
+static uint32_t mcc_crc (const void * pvBuf, uint32_t u32Len)
+{
+  const uint32_t  * pu32Word = (const uint32_t*)pvBuf;
+  uint_32           u32Crc   = 0;
+  uint32_t          i;
+
+  _lwsem_wait_ticks(&g_lwsemCrc, 0);                                            // one engine for both channel tasks
+  if (!((uintptr_t)pvBuf & 3) && !(u32Len & 3)) {                               // whole words (all the frames but odd PINGs)
+    esl_crc_reinit(ESL_CRC_WIDTH_32_BIT, MCC_CRC_POLYNOMIAL, MCC_CRC_SEED);
+    for (i = 0; i < u32Len / sizeof(uint32_t); ++i) {
+      esl_crc_write32(MCC_CRC_WORD(pu32Word[i]));
+    }
+    u32Crc = esl_crc_read();
+  } else {
+    esl_crc_calcForBuf(ESL_CRC_WIDTH_32_BIT, MCC_CRC_POLYNOMIAL, MCC_CRC_SEED,
+                       (const uint_8*)pvBuf, u32Len, &u32Crc);
+  }
+  _lwsem_post(&g_lwsemCrc);
+
+  return u32Crc;
+}
+
+//******************************************************************************
+
+static boolean mcc_parse (TMccChannel * poChannel, const void * pvMsg, MCC_MEM_SIZE size, TMccRx * poRx)
+{
+  const TMccHdr * poHdr = (const TMccHdr*)pvMsg;
+  const uint8_t * pu8Body;
+  MCC_MEM_SIZE    bodySize;
+  MCC_MEM_SIZE    crcSize;
+  uint32_t        u32Crc;
+
+  memset(&poRx->oMsg, 0, sizeof(poRx->oMsg));
+  if ((size >= sizeof(TMccHdr)) && (MCC_HDR_MAGIC == poHdr->u16Magic)) {
+    crcSize = (poHdr->u8Flags & MCC_HDR_FLAG_CRC) ? MCC_CRC_SIZE : 0;
+    if ((poHdr->u8Version < MCC_PROTOCOL_FRAMED)
+        || (size != MCC_HDR_PREFIX_SIZE + sizeof(int32_t) + poHdr->u16Length + crcSize)) {
+      ++poChannel->oStats.u32RxErrors;
+      return FALSE;
+    }
+    if (crcSize) {
+      memcpy(&u32Crc, (const uint8_t*)pvMsg + size - MCC_CRC_SIZE, MCC_CRC_SIZE);
+      if (mcc_crc(pvMsg, size - MCC_CRC_SIZE) != u32Crc) {
+        ++poChannel->oStats.u32RxCrcErrors;
+        LOGW_FORMATTED("%s message seq %u CRC mismatch (%u total)", poChannel->sName,
+                       poHdr->u32Seq, poChannel->oStats.u32RxCrcErrors);
+        return FALSE;
+      }
+    }
+    pu8Body           = (const uint8_t*)&poHdr->type;
+    bodySize          = size - MCC_HDR_PREFIX_SIZE - crcSize;
+    poRx->u8Version   = MCC_PROTOCOL_FRAMED;                                    // the highest version both of us know
+    poRx->u8PeerVersion = poHdr->u8Version;
+    poRx->u8Flags     = poHdr->u8Flags & MCC_HDR_FLAG_CRC;
+    poRx->u16Ack      = poHdr->u16Ack;
+    poRx->u32Seq      = poHdr->u32Seq;
+    poRx->size        = bodySize;
+  } else if (size == sizeof(TMccMsg)) {
+    pu8Body           = (const uint8_t*)pvMsg;
+    bodySize          = size;
+    poRx->u8Version   = MCC_PROTOCOL_LEGACY;
+    poRx->u8PeerVersion = MCC_PROTOCOL_LEGACY;
+    poRx->u8Flags     = 0;
+    poRx->u16Ack      = 0;
+    poRx->u32Seq      = 0;
+    poRx->size        = bodySize;
+  } else {
+    ++poChannel->oStats.u32RxErrors;
+    return FALSE;
+  }
+
+  memcpy(&poRx->oMsg, pu8Body, MIN(bodySize, sizeof(poRx->oMsg)));              // longer payloads are not used by any request
+  return TRUE;
+}
+
+//******************************************************************************
+
+static void mcc_checkSeq (TMccChannel * poChannel, const TMccRx * poRx)
+{
+  int32_t i32Diff;
+
+  if (!poRx->u32Seq) return;                                                    // bare message
+
+  if ((MCCMSG_HELLO == poRx->oMsg.type) || !poChannel->u32RxSeqNext) {          // new A5 session
+    i32Diff = 0;
+  } else {
+    i32Diff = (int32_t)(poRx->u32Seq - poChannel->u32RxSeqNext);
+  }
+
+  if (i32Diff > 0) {
+    poChannel->oStats.u32RxLost += i32Diff;
+    LOGW_FORMATTED("%s %d message(s) lost before seq %u (%u total)", poChannel->sName,
+                   i32Diff, poRx->u32Seq, poChannel->oStats.u32RxLost);
+  } else if (i32Diff < 0) {
+    ++poChannel->oStats.u32RxReordered;
+    LOGW_FORMATTED("%s message seq %u out of order (%u total)", poChannel->sName,
+                   poRx->u32Seq, poChannel->oStats.u32RxReordered);
+    return;                                                                     // keep expecting the newer one
+  }
+  poChannel->u32RxSeqNext = poRx->u32Seq + 1;
+  if (!poChannel->u32RxSeqNext) poChannel->u32RxSeqNext = 1;
+}
+
+//******************************************************************************
+
+static void mcc_takeAck (TMccChannel * poChannel, const TMccRx * poRx)
+{
+  if (!poRx->u32Seq) return;                                                    // bare message
+
+  poChannel->u8PeerVersion = poRx->u8PeerVersion;
+  poChannel->u8PeerFlags   = poRx->u8Flags;
+  if (poRx->u8PeerVersion < MCC_PROTOCOL_CREDITS) return;
+
+  poChannel->u32RxSeqLast = poRx->u32Seq;                                       // the newest, a restarted A5 starts over
+  if (MCCMSG_CREDIT != poRx->oMsg.type) ++poChannel->u32RxUnacked;              // acknowledgements are not acknowledged
+  if (MCC_CREDIT_IN_FLIGHT(poChannel->u32TxSeq, poRx->u16Ack)
+      < MCC_CREDIT_IN_FLIGHT(poChannel->u32TxSeq, poChannel->u16TxAck)) {
+    poChannel->u16TxAck = poRx->u16Ack;                                         // older ones (reordered, previous subscriber) ignored
+  }
+}
+
+//******************************************************************************
+
+static void mcc_sendCredit (TMccChannel * poChannel)
+{
+  TMccMsg * poCredit;
+
+  if (poChannel->u32RxUnacked < MCC_CREDIT_BATCH(MCC_CREDITS_A5)) return;
+
+  poCredit = (TMccMsg*)mcc_getTxBuffer(poChannel, MCC_PROTOCOL_FRAMED);
+  if (!poCredit) return;                                                        // retried after MCC_CREDIT_RETRY_US
+  poCredit->type = MCCMSG_CREDIT;
+  mcc_sendTxBuffer(poChannel, poCredit, MCC_PROTOCOL_FRAMED, poChannel->u8PeerFlags,
+                   0, sizeof(int32_t));                                         // non-blocking call
+}
+
+//******************************************************************************
+
+static void * mcc_getTxBuffer (TMccChannel * poChannel, uint8_t u8Version)
+{
+#if MCC_SEND_NOCOPY
+  void          * pvMsg;
+  MCC_MEM_SIZE    size;
+  int             ret;
+
+  ret = mcc_get_buffer(&pvMsg, &size, 0);                                       // non-blocking call
+  if (MCC_SUCCESS != ret) {
+    ++poChannel->oStats.u32TxNoBuffer;
+    LOGE_FORMATTED("%s mcc_get_buffer failed: %d (%u total)", poChannel->sName, ret,
+                   poChannel->oStats.u32TxNoBuffer);
+    return NULL;
+  }
+  return (uint8_t*)pvMsg + MCC_PREFIX_SIZE(u8Version);
+#else
+  return (uint8_t*)poChannel->au32TxBuffer + MCC_PREFIX_SIZE(u8Version);        // only the channel task sends
+#endif
+}
+
+//******************************************************************************
+
+static int mcc_sendTxBuffer (TMccChannel * poChannel, void * pvMsg, uint8_t u8Version,
+                             uint8_t u8Flags, uint32_t u32Ref, MCC_MEM_SIZE size)
+{
+  TMccHdr * poHdr = (TMccHdr*)((uint8_t*)pvMsg - MCC_PREFIX_SIZE(u8Version));
+  int32_t   i32Type = *(int32_t*)pvMsg;                                         // the buffer is gone after sending
+  uint32_t  u32Crc;
+  int       ret;
+
+  if (u8Version >= MCC_PROTOCOL_FRAMED) {                                       // the type is already in place
+    if (!++poChannel->u32TxSeq) ++poChannel->u32TxSeq;                          // 0 is never used
+    poHdr->u16Magic     = MCC_HDR_MAGIC;
+    poHdr->u8Version    = MCC_PROTOCOL_VERSION;
+    poHdr->u8Flags      = poChannel->u8Flags | u8Flags | (u32Ref ? MCC_HDR_FLAG_REPLY : 0);
+    poHdr->u16Length    = size - sizeof(int32_t);
+    poHdr->u16Ack       = (poChannel->u8PeerVersion >= MCC_PROTOCOL_CREDITS) ? (uint16_t)poChannel->u32RxSeqLast : 0;
+    poHdr->u32Seq       = poChannel->u32TxSeq;
+    poHdr->u32Ref       = u32Ref;
+    size += MCC_HDR_PREFIX_SIZE;
+    if (u8Flags & MCC_HDR_FLAG_CRC) {                                           // room left by every message body
+      u32Crc = mcc_crc(poHdr, size);
+      memcpy((uint8_t*)poHdr + size, &u32Crc, MCC_CRC_SIZE);
+      size += MCC_CRC_SIZE;
+    }
+  }
+
+#if MCC_SEND_NOCOPY
+  ret = mcc_send_nocopy(&poChannel->oEndpoint, &g_mccEndpointRemote, poHdr, size);
+  if (MCC_SUCCESS != ret) mcc_free_buffer(poHdr);                               // still ours on failure
+#else
+  ret = mcc_send(&g_mccEndpointRemote, poHdr, size, 0);
+#endif
+  if (MCC_SUCCESS != ret) {
+    if (MCC_ERR_NOMEM == ret) {                                                 // out of the shared buffers
+      ++poChannel->oStats.u32TxNoBuffer;
+    } else {
+      ++poChannel->oStats.u32TxFailures;
+    }
+    LOGW_FORMATTED("%s message type %d dropped: %d (%u total)", poChannel->sName, i32Type, ret,
+                   poChannel->oStats.u32TxNoBuffer + poChannel->oStats.u32TxFailures);
+    return ret;
+  }
+  if ((uint32_t)i32Type < MCCMSG_COUNT) ++poChannel->oStats.au32Tx[i32Type];
+  if (u8Version >= MCC_PROTOCOL_FRAMED) {
+    poChannel->u32RxUnacked = 0;                                                // acknowledged by u16Ack
+  }
+  return ret;
+}
+
+//******************************************************************************
+
+static void mcc_freeTxBuffer (TMccChannel * poChannel, void * pvMsg, uint8_t u8Version)
+{
+  (void)poChannel;
+#if MCC_SEND_NOCOPY
+  mcc_free_buffer((uint8_t*)pvMsg - MCC_PREFIX_SIZE(u8Version));
+#else
+  (void)pvMsg;
+  (void)u8Version;
+#endif
+}
+
+//******************************************************************************
+
+static uint_32 mcc_pushTimeout (TMccChannel * poChannel)
+{
+  MQX_TICK_STRUCT   oNow;
+  boolean           bOverflow;
+  int_32            i32Diff;
+
+  if (!poChannel->u32PushPeriod) return MCC_WAIT_INF;
+
+  _time_get_elapsed_ticks(&oNow);
+  i32Diff = _time_diff_microseconds(&poChannel->oPushNext, &oNow, &bOverflow);
+  return (!bOverflow && (i32Diff > 0)) ? (uint_32)i32Diff : 0;
+}
+
+//******************************************************************************
+
+static MCC_MEM_SIZE mcc_fillStream (TMccAccelStreamMsg * poStream, uint32_t u32MaxCount,
+                                    uint32_t u32Since, uint8_t u8PeerVersion)
+{
+  uint32_t  au32TimeUs[MCC_ACCEL_STREAM_MAX_TIMED_SAMPLES];
+  boolean   bTimes = (u8PeerVersion >= MCC_PROTOCOL_TIMESTAMPS);
+  int       ret;
+
+  u32MaxCount = MIN(u32MaxCount, bTimes ? MCC_ACCEL_STREAM_MAX_TIMED_SAMPLES : MCC_ACCEL_STREAM_MAX_SAMPLES);
+  ret = accel_getHistory (poStream->aoSamples,                                  // the samples go straight to the message
+                          u32MaxCount,
+                          u32Since,
+                          &poStream->u32Count,
+                          &poStream->u32Lost,
+                          bTimes ? au32TimeUs : NULL);
+  if ((ACCEL_OK != ret) && (ACCEL_OUTDATED != ret)) {
+    LOGW_FORMATTED("accel_getHistory failed: %d", ret);
+    poStream->u32Count = poStream->u32Lost = 0;
+  }
+  if (!bTimes) {
+    return MCC_ACCEL_STREAM_HEADER_SIZE + poStream->u32Count * sizeof(TMccAccelSample);
+  }
+  memcpy(MCC_ACCEL_STREAM_TIMES(poStream), au32TimeUs, poStream->u32Count * sizeof(uint32_t));
+  return MCC_ACCEL_STREAM_HEADER_SIZE + poStream->u32Count * (sizeof(TMccAccelSample) + sizeof(uint32_t));
+}
+
+//******************************************************************************
+
+static MCC_MEM_SIZE mcc_fillRaw (TMccAccelRawMsg * poRaw, uint32_t u32MaxCount, uint32_t u32Since)
+{
+  uint32_t * pau32TimeUs;
+  int        ret;
+
+  // The times are read behind the room for u32MaxCount samples and moved
+  // down behind the actual ones then (the task stack is small)
+  u32MaxCount = MIN(u32MaxCount, MCC_ACCEL_RAW_MAX_SAMPLES);
+  pau32TimeUs = (uint32_t*)((uint8_t*)poRaw->ai16Data + MCC_ACCEL_RAW_DATA_SIZE(u32MaxCount));
+  ret = accel_getRawHistory (poRaw->ai16Data,                                   // the counts go straight to the message
+                             u32MaxCount,
+                             u32Since,
+                             &poRaw->u32First,
+                             &poRaw->u32Count,
+                             &poRaw->u32Lost,
+                             pau32TimeUs,
+                             &poRaw->oScale,
+                             MSECS_TO_MQX_TICKS(1));
+  if ((ACCEL_OK != ret) && (ACCEL_OUTDATED != ret)) {
+    LOGW_FORMATTED("accel_getRawHistory failed: %d", ret);
+    poRaw->u32Count = poRaw->u32Lost = 0;
+    poRaw->u32First = u32Since + 1;
+    accel_getScale(&poRaw->oScale);
+  }
+  memmove(MCC_ACCEL_RAW_TIMES(poRaw), pau32TimeUs, poRaw->u32Count * sizeof(uint32_t));
+  return MCC_ACCEL_RAW_SIZE(poRaw->u32Count);
+}
+
+//******************************************************************************
+
+static MCC_MEM_SIZE mcc_fillFiltered (TMccChannel * poChannel, void * pvMsg, uint32_t * pu32Newest)
+{
+  TMccAccelRawMsg     * poRaw     = (TMccAccelRawMsg*)pvMsg;
+  TMccAccelStreamMsg  * poStream  = (TMccAccelStreamMsg*)pvMsg;
+  TFilter             * poFilter  = &poChannel->oPushFilter;
+  boolean               bRaw      = (MCC_ACCEL_FORMAT_RAW == poChannel->u8PushFormat);
+  boolean               bTimes    = bRaw || (poChannel->u8PushPeerVersion >= MCC_PROTOCOL_TIMESTAMPS);
+  uint32_t              u32Step   = MAX(poFilter->oSettings.u8Decimation, 1);
+  uint32_t              u32Since  = poChannel->u32PushSince;
+  uint32_t              u32Room, u32Max, u32First, u32Cnt, u32Lost, u32Kept, u32Offset;
+  uint32_t              u32Out = 0, u32OutFirst = 0, u32OutLost = 0;
+  uint32_t            * pau32TimeUs;
+  TMccAccelScale        oScale;
+  TMccAccelScale        oOutScale = poChannel->oPushScale;
+  TMccAccelConfig       oConfig;
+  uint32_t              u32PeriodUs;
+  uint32_t              i;
+  int                   ret;
+
+  accel_getConfig(&oConfig, &u32PeriodUs);                                      // redesign for a new rate
+  if (u32PeriodUs != poFilter->u32PeriodUs) filter_setup(poFilter, &poFilter->oSettings, u32PeriodUs);
+
+  // The times of the samples kept are stored behind the room for the
+  // samples and moved down behind the actual ones then (as in mcc_fillRaw())
+  if (bRaw) {
+    u32Room     = MCC_ACCEL_RAW_MAX_SAMPLES;
+    pau32TimeUs = (uint32_t*)((uint8_t*)poRaw->ai16Data + MCC_ACCEL_RAW_DATA_SIZE(u32Room));
+  } else {
+    u32Room     = bTimes ? MCC_ACCEL_STREAM_MAX_TIMED_SAMPLES : MCC_ACCEL_STREAM_MAX_SAMPLES;
+    pau32TimeUs = (uint32_t*)&poStream->aoSamples[u32Room];
+  }
+
+  do {
+    u32Max = MIN(filter_maxInput(poFilter, u32Room - u32Out), MCC_ACCEL_RAW_MAX_SAMPLES);
+    ret = accel_getRawHistory (poChannel->aai16PushWork,
+                               u32Max,
+                               u32Since,
+                               &u32First,
+                               &u32Cnt,
+                               &u32Lost,
+                               poChannel->au32PushWorkUs,
+                               &oScale,
+                               MSECS_TO_MQX_TICKS(1));
+    if ((ACCEL_OK != ret) && (ACCEL_OUTDATED != ret)) {
+      LOGW_FORMATTED("accel_getRawHistory failed: %d", ret);
+      break;
+    }
+    if (!u32Cnt) break;
+    if (u32Lost || (u32First != u32Since + 1)
+        || memcmp(&oScale, &poChannel->oPushScale, sizeof(oScale))) {
+      if (u32Out) break;                                                        // left to the next push
+      filter_reset(poFilter);                                                   // nothing to continue from
+      poChannel->oPushScale = oOutScale = oScale;
+    }
+    u32OutLost += u32Lost;
+
+    u32Kept = filter_run(poFilter, poChannel->aai16PushWork, poChannel->au32PushWorkUs, u32Cnt, &u32Offset);
+    if (u32Kept && !u32Out) u32OutFirst = u32First + u32Offset;
+    for (i = 0; i < u32Kept; ++i) {
+      const int16_t * pi16Src = poChannel->aai16PushWork[i];
+
+      if (bRaw) {
+        poRaw->ai16Data[u32Out + i][0] = pi16Src[0];
+        poRaw->ai16Data[u32Out + i][1] = pi16Src[1];
+        poRaw->ai16Data[u32Out + i][2] = pi16Src[2];
+      } else {
+        TMccAccelSample * poSample = &poStream->aoSamples[u32Out + i];
+
+        poSample->u32Timestamp = u32First + u32Offset + i * u32Step;
+        poSample->afData[0]    = (float)pi16Src[0] / oScale.u16CountsPerG;
+        poSample->afData[1]    = (float)pi16Src[1] / oScale.u16CountsPerG;
+        poSample->afData[2]    = (float)pi16Src[2] / oScale.u16CountsPerG;
+      }
+      if (bTimes) pau32TimeUs[u32Out + i] = poChannel->au32PushWorkUs[i];
+    }
+    u32Out  += u32Kept;
+    u32Since = u32First + u32Cnt - 1;
+  } while ((u32Cnt == u32Max) && (u32Out < u32Room));
+
+  *pu32Newest = u32Since;
+  if (bRaw) {
+    poRaw->u32Count = u32Out;
+    poRaw->u32Lost  = u32OutLost;
+    poRaw->u32First = u32Out ? u32OutFirst : u32Since + 1;
+    poRaw->oScale   = oOutScale;
+    memmove(MCC_ACCEL_RAW_TIMES(poRaw), pau32TimeUs, u32Out * sizeof(uint32_t));
+    return MCC_ACCEL_RAW_SIZE(u32Out);
+  }
+  poStream->u32Count = u32Out;
+  poStream->u32Lost  = u32OutLost;
+  if (!bTimes) {
+    return MCC_ACCEL_STREAM_HEADER_SIZE + u32Out * sizeof(TMccAccelSample);
+  }
+  memmove(MCC_ACCEL_STREAM_TIMES(poStream), pau32TimeUs, u32Out * sizeof(uint32_t));
+  return MCC_ACCEL_STREAM_HEADER_SIZE + u32Out * (sizeof(TMccAccelSample) + sizeof(uint32_t));
+}
+
+//******************************************************************************
+
+static void mcc_push (TMccChannel * poChannel)
+{
+  MQX_TICK_STRUCT       oNow;
+  TMccAccelStreamMsg  * poStream;
+  TMccAccelRawMsg     * poRaw;
+  void                * pvMsg;
+  MCC_MEM_SIZE          size;
+  uint32_t              u32Count;
+  uint32_t              u32Newest;
+  TMccAccelScale        oScaleUndo;
+  boolean               bFiltered;
+  boolean               bOverflow;
+  int                   ret;
+
+  // Schedule the next push, skip the missed periods if we are late
+  _time_add_msec_to_ticks(&poChannel->oPushNext, poChannel->u32PushPeriod);
+  _time_get_elapsed_ticks(&oNow);
+  if (_time_diff_microseconds(&poChannel->oPushNext, &oNow, &bOverflow) <= 0) {
+    poChannel->oPushNext = oNow;
+    _time_add_msec_to_ticks(&poChannel->oPushNext, poChannel->u32PushPeriod);
+  }
+
+  // Hold the push back while the subscriber's window is full
+  if (poChannel->u32PushWindow
+      && (MCC_CREDIT_IN_FLIGHT(poChannel->u32TxSeq, poChannel->u16TxAck) >= poChannel->u32PushWindow)) {
+    ++poChannel->oStats.u32TxNoCredit;
+    if (!poChannel->bPushStalled) {
+      LOGW_FORMATTED("%s push held back, no credit (%u total)", poChannel->sName,
+                     poChannel->oStats.u32TxNoCredit);
+    }
+    poChannel->bPushStalled = TRUE;
+    return;                                                                     // samples stay in the history for the next push
+  }
+  poChannel->bPushStalled = FALSE;
+
+  pvMsg = mcc_getTxBuffer(poChannel, poChannel->u8PushVersion);
+  if (!pvMsg) return;                                                           // samples stay in the history for the next push
+  poRaw = (TMccAccelRawMsg*)pvMsg;
+  poStream = (TMccAccelStreamMsg*)pvMsg;
+  bFiltered = filter_isActive(&poChannel->oPushFilter);
+  if (bFiltered) {
+    poChannel->oPushFilterUndo = poChannel->oPushFilter;
+    oScaleUndo = poChannel->oPushScale;
+    if (MCC_ACCEL_FORMAT_RAW == poChannel->u8PushFormat) {
+      poRaw->type = MCCMSG_ACCEL_RAW_PUSH;
+      size = mcc_fillFiltered(poChannel, pvMsg, &u32Newest);
+      u32Count = poRaw->u32Count + poRaw->u32Lost;                              // a loss is worth a message
+    } else {
+      poStream->type = MCCMSG_ACCEL_PUSH;
+      size = mcc_fillFiltered(poChannel, pvMsg, &u32Newest);
+      u32Count = poStream->u32Count + poStream->u32Lost;
+    }
+  } else if (MCC_ACCEL_FORMAT_RAW == poChannel->u8PushFormat) {
+    poRaw->type = MCCMSG_ACCEL_RAW_PUSH;
+    size = mcc_fillRaw(poRaw, MCC_ACCEL_RAW_MAX_SAMPLES, poChannel->u32PushSince);
+    u32Count = poRaw->u32Count;
+    u32Newest = poRaw->u32First + u32Count - 1;                                 // the buffer is gone after sending
+  } else {
+    poStream->type = MCCMSG_ACCEL_PUSH;
+    size = mcc_fillStream(poStream, MCC_ACCEL_STREAM_MAX_SAMPLES, poChannel->u32PushSince,
+                          poChannel->u8PushPeerVersion);
+    u32Count = poStream->u32Count;
+    u32Newest = u32Count ? poStream->aoSamples[u32Count-1].u32Timestamp : 0;    // the buffer is gone after sending
+  }
+  if (!u32Count) {                                                              // nothing new (to send)
+    mcc_freeTxBuffer(poChannel, pvMsg, poChannel->u8PushVersion);
+    if (bFiltered) poChannel->u32PushSince = u32Newest;                         // dropped by the decimation, the chain state has them
+    return;
+  }
+
+  ret = mcc_sendTxBuffer(poChannel, pvMsg, poChannel->u8PushVersion,
+                         poChannel->u8PushFlags, 0, size);                      // non-blocking call
+  if (MCC_OK != ret) {                                                          // samples stay in the history for the next push
+    if (bFiltered) {
+      poChannel->oPushFilter = poChannel->oPushFilterUndo;
+      poChannel->oPushScale  = oScaleUndo;
+    }
+    return;
+  }
+  poChannel->u32PushSince = u32Newest;
+}
+
+//******************************************************************************
+
+static uint_32 mcc_summaryTimeout (TMccChannel * poChannel)
+{
+  MQX_TICK_STRUCT   oNow;
+  boolean           bOverflow;
+  int_32            i32Diff;
+
+  if (!poChannel->bSummary && !poChannel->bEvents) return MCC_WAIT_INF;
+
+  _time_get_elapsed_ticks(&oNow);
+  i32Diff = _time_diff_microseconds(&poChannel->oSummaryNext, &oNow, &bOverflow);
+  return (!bOverflow && (i32Diff > 0)) ? (uint_32)i32Diff : 0;
+}
+
+//******************************************************************************
+
+static void mcc_pushSummaries (TMccChannel * poChannel)
+{
+  TMccAccelSummaryMsg * poSummary;
+  uint32_t              u32Window;
+  int                   ret;
+
+  while (1) {
+    if (poChannel->u32PushWindow                                                // the same window as the sample pushes
+        && (MCC_CREDIT_IN_FLIGHT(poChannel->u32TxSeq, poChannel->u16TxAck) >= poChannel->u32PushWindow)) {
+      ++poChannel->oStats.u32TxNoCredit;
+      return;
+    }
+    poSummary = (TMccAccelSummaryMsg*)mcc_getTxBuffer(poChannel, poChannel->u8SummaryVersion);
+    if (!poSummary) return;
+    if (!accel_getSummary(poChannel->u32SummarySince, poSummary)) {             // nothing new
+      mcc_freeTxBuffer(poChannel, poSummary, poChannel->u8SummaryVersion);
+      return;
+    }
+    u32Window = poSummary->u32Window;                                           // the buffer is gone after sending
+    if ((int32_t)(poSummary->u32First - poChannel->u32SummaryFirst) < 0) {      // window of the previous features
+      mcc_freeTxBuffer(poChannel, poSummary, poChannel->u8SummaryVersion);
+      poChannel->u32SummarySince = u32Window;
+      continue;
+    }
+    poSummary->type = MCCMSG_ACCEL_SUMMARY;
+    ret = mcc_sendTxBuffer(poChannel, poSummary, poChannel->u8SummaryVersion,
+                           poChannel->u8SummaryFlags, 0, sizeof(TMccAccelSummaryMsg));  // non-blocking call
+    if (MCC_OK != ret) return;                                                  // sent again at the next check
+    poChannel->u32SummarySince = u32Window;
+  }
+}
+
+//******************************************************************************
+
+static void mcc_pushEvents (TMccChannel * poChannel)
+{
+  TMccAccelEventMsg   * poEvents;
+  uint32_t              u32First;
+  uint32_t              u32Count;
+  uint32_t              u32Lost;
+  int                   ret;
+
+  while (1) {
+    if (poChannel->u32PushWindow                                                // the same window as the sample pushes
+        && (MCC_CREDIT_IN_FLIGHT(poChannel->u32TxSeq, poChannel->u16TxAck) >= poChannel->u32PushWindow)) {
+      ++poChannel->oStats.u32TxNoCredit;
+      return;
+    }
+    poEvents = (TMccAccelEventMsg*)mcc_getTxBuffer(poChannel, poChannel->u8EventsVersion);
+    if (!poEvents) return;
+    u32Count = accel_getEventLog(poChannel->u32EventsSince, poEvents->aoEvents, MCC_ACCEL_EVENT_MAX,
+                                 &u32First, &u32Lost);
+    if (!u32Count) {                                                            // nothing new
+      mcc_freeTxBuffer(poChannel, poEvents, poChannel->u8EventsVersion);
+      poChannel->u32EventsSince = u32First - 1;
+      poChannel->u32EventsLost += u32Lost;
+      return;
+    }
+    poEvents->type     = MCCMSG_ACCEL_EVENT;
+    poEvents->u32First = u32First;
+    poEvents->u32Count = u32Count;
+    poEvents->u32Lost  = poChannel->u32EventsLost + u32Lost;
+    ret = mcc_sendTxBuffer(poChannel, poEvents, poChannel->u8EventsVersion, poChannel->u8EventsFlags, 0,
+                           MCC_ACCEL_EVENT_HEADER_SIZE + u32Count * sizeof(TMccAccelEvent));  // non-blocking call
+    if (MCC_OK != ret) return;                                                  // sent again at the next check
+    poChannel->u32EventsSince = u32First + u32Count - 1;
+    poChannel->u32EventsLost  = 0;
+  }
+}
+
+//******************************************************************************
+
+static void mcc_countLatency (TMccChannel * poChannel, uint32_t u32Us)
+{
+  uint32_t i = 0;
+
+  while ((i < MCC_STATS_LATENCY_BINS - 1) && (u32Us >= ((uint32_t)MCC_STATS_LATENCY_MIN_US << i))) ++i;
+  ++poChannel->oStats.au32Latency[i];
+}
+
+//******************************************************************************
@@ -41,6 +41,8 @@
 
 #define MCC_TASKSTACK                   2000                                    //!< Task stack
 #define MCC_TASKNAME                    "mcc"                                   //!< Task Name - should be unique
+#define MCC_BULK_TASKSTACK              2000                                    //!< Bulk channel task stack
+#define MCC_BULK_TASKNAME               "mcc_bulk"                              //!< Bulk channel task name - should be unique
 
 // NOTE: Task start strategy and priority is application dependent and that's
 //       why it shouldn't be defined here, but in an application configuration!
@@ -55,13 +57,21 @@ enum {
   MCC_INFO_FAILURE,
   MCC_VERSION_FAILURE,
   MCC_ENDPOINT_FAILURE,
+  MCC_CRC_FAILURE,
 };
 
 //******************************************************************************
 
-/** Multicore communication task.
+/** Multicore communication task, control channel (MCC_ENDPOINT_M4_PORT).
+ *  Initializes MCC, so it must be ready before mcc_bulk_task starts.
  * @param [in] initialData Task initial data. */
 void mcc_task (uint_32 u32InitialData);
 
+/** Multicore communication task, bulk channel (MCC_ENDPOINT_M4_BULK_PORT).
+ *  Should run at a lower priority than mcc_task, so that sample transfers
+ *  do not delay the control messages.
+ * @param [in] initialData Task initial data. */
+void mcc_bulk_task (uint_32 u32InitialData);
+
 //******************************************************************************
 #endif // MCC_H_237678262778876362057387698 //
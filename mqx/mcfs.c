@@ -0,0 +1,485 @@
+/** ****************************************************************************
+ *
+ *  @file       mcfs.c
+ *  @brief      MCC filesystem client.
+ *
+ *  @copyright  Elnico Ltd. All rights reserved.
+ *
+ ******************************************************************************/
+/*
+ *  THIS SOFTWARE IS PROVIDED BY ELNICO "AS IS" AND ANY EXPRESSED OR
+ *  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ *  OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ *  IN NO EVENT SHALL ELNICO OR ITS CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ *  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ *  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ *  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ *  IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ *  THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************/
+
+#include "mcfs.h"
+
+#include "esl_log.h"
+#include "esl_utils.h"
+
+#include "mcc_config.h"
+#include "mcc_common.h"
+#include "mcc_api.h"
+#include "mcc_mqx.h"
+
+#include <mqx.h>
+#include <bsp.h>
+#include <string.h>
+
+//******************************************************************************
+// Local definitions
+//******************************************************************************
+
+/** @def MCC_SEND_NOCOPY
+ * @brief Set to 1 if the MCC library provides mcc_get_buffer() and
+ *        mcc_send_nocopy() (as in mcc.c). The requests are then composed
+ *        directly in the shared memory. */
+#ifndef MCC_SEND_NOCOPY
+# define MCC_SEND_NOCOPY                (0)
+#endif
+
+/** File open on the server, indexed by the handle - 1. */
+typedef struct mcfs_file_struct {
+  boolean           bOpen;
+  uint32_t          u32Pos;                                                     //!< Current position.
+  uint32_t          u32Size;                                                    //!< File size known from the open and the writes.
+  int_32            i32Error;                                                   //!< Failed write not reported yet, MCFS_OK if none.
+} TMcfsFile;
+
+/** Client state, guarded by lwsem. */
+typedef struct mcfs_client_struct {
+  LWSEM_STRUCT      lwsem;                                                      //!< Serializes the calls of the tasks.
+  boolean           bInitialized;                                               //!< lwsem and oEndpoint created.
+  boolean           bReady;                                                     //!< Server greeted.
+  MCC_ENDPOINT      oEndpoint;                                                  //!< Local endpoint.
+  uint32_t          u32Tag;                                                     //!< Tag of the last request sent.
+  uint32_t          u32Unacked;                                                 //!< WRITE requests sent and not acknowledged yet.
+  uint32_t          u32MaxRead;                                                 //!< Largest READ the server takes.
+  TMcfsFile         aoFiles[MCFS_MAX_FILES];
+#if !MCC_SEND_NOCOPY
+  TMcfsMsg          oTx;                                                        //!< Request composition buffer (too big for the task stacks).
+#endif
+} TMcfsClient;
+
+//******************************************************************************
+// Local functions
+//******************************************************************************
+
+/** Sends a request, waits for a free MCC buffer up to MCFS_TIMEOUT.
+ * @return  MCFS_OK or MCFS_ERR_SEND. */
+static int_32 mcfs_send (uint8_t u8Op, int_32 iHandle, uint32_t u32Offset, uint32_t u32Count,
+                         const void * pvData, uint16_t u16Length);
+
+/** Waits for the next reply, takes the WRITE acknowledgements on the way.
+ *  The reply must be released by mcc_free_buffer().
+ * @param[in] u32Tag  Tag of the request answered, 0 for the next WRITE
+ *                    acknowledgement.
+ * @return  MCFS_OK or MCFS_ERR_TIMEOUT. */
+static int_32 mcfs_recv (uint32_t u32Tag, TMcfsMsg ** ppoReply);
+
+/** Records a WRITE acknowledgement. */
+static void mcfs_takeAck (const TMcfsHdr * poReply);
+
+/** Waits until at most u32Max WRITE requests are not acknowledged.
+ * @return  MCFS_OK or MCFS_ERR_TIMEOUT. */
+static int_32 mcfs_waitAcks (uint32_t u32Max);
+
+/** Sends a request answered by a single reply and waits for it.
+ * @return  Reply status or the send or receive failure. */
+static int_32 mcfs_transact (uint8_t u8Op, int_32 iHandle, uint32_t u32Count,
+                             const void * pvData, uint16_t u16Length, TMcfsHdr * poReply);
+
+/** Takes the client semaphore, checks the handle if non-zero.
+ * @return  MCFS_OK or MCFS_ERR_*, the semaphore is not taken on failure. */
+static int_32 mcfs_lock (int_32 iHandle);
+
+//******************************************************************************
+// Globals
+//******************************************************************************
+
+static MCC_ENDPOINT g_mcfsEndpointRemote = { ESL_MCFS_ENDPOINT_A5_CORE,
+                                             ESL_MCFS_ENDPOINT_A5_NODE,
+                                             ESL_MCFS_ENDPOINT_A5_PORT };        //!< Endpoint of the Linux server.
+static TMcfsClient  g_oMcfs;
+
+//******************************************************************************
+//******************************************************************************
+//******************************************************************************
+
+uint_32 mcfs_init (void)
+{
+  TMcfsHdr  oReply;
+  int       ret;
+
+  if (!g_oMcfs.bInitialized) {
+    ret = _lwsem_create(&g_oMcfs.lwsem, 1);
+    if (MQX_OK != ret) {
+      LOGE_FORMATTED("_lwsem_create failed: %d", ret);
+      return MCFS_ERR_LWSEM;
+    }
+    ret = mcc_create_endpoint(&g_oMcfs.oEndpoint, ESL_MCFS_ENDPOINT_M4_PORT);
+    if (MCC_SUCCESS != ret) {
+      LOGE_FORMATTED("mcc_create_endpoint() failed: %d, node,port: %d, %d",
+                     ret, ESL_MCFS_ENDPOINT_M4_NODE, ESL_MCFS_ENDPOINT_M4_PORT);
+      _lwsem_destroy(&g_oMcfs.lwsem);
+      return MCFS_ERR_ENDPOINT;
+    }
+    g_oMcfs.bInitialized = TRUE;
+  }
+
+  _lwsem_wait_ticks(&g_oMcfs.lwsem, 0);
+  g_oMcfs.bReady      = FALSE;
+  g_oMcfs.u32Unacked  = 0;
+  memset(g_oMcfs.aoFiles, 0, sizeof(g_oMcfs.aoFiles));                          // closed by the server
+  ret = mcfs_transact(MCFS_OP_HELLO, 0, MCFS_PROTOCOL_VERSION, NULL, 0, &oReply);
+  if ((MCFS_OK == ret) && (oReply.u32Count < MCFS_PROTOCOL_VERSION)) {
+    LOGE_FORMATTED("mcfs server protocol version %u not supported", oReply.u32Count);
+    ret = MCFS_ERR_VERSION;
+  }
+  if (MCFS_OK == ret) {
+    g_oMcfs.u32MaxRead  = MIN(oReply.u32Offset, MCFS_MAX_READ);
+    g_oMcfs.bReady      = (g_oMcfs.u32MaxRead > 0);
+    LOGI_FORMATTED("mcfs server protocol version %u", oReply.u32Count);
+  }
+  _lwsem_post(&g_oMcfs.lwsem);
+  return ret;
+}
+
+//******************************************************************************
+
+int_32 mcfs_open (const char * sPath, uint32_t u32Mode)
+{
+  TMcfsHdr  oReply;
+  size_t    len = strlen(sPath);
+  int_32    ret;
+
+  if ((0 == len) || (len >= ESL_MCFS_FILENAME_MAXLEN)) return -MCFS_ERR_INVALID;
+  ret = mcfs_lock(0);
+  if (MCFS_OK != ret) return -ret;
+
+  ret = mcfs_transact(MCFS_OP_OPEN, 0, u32Mode, sPath, (uint16_t)len, &oReply);
+  if ((MCFS_OK == ret) && ((oReply.u16Handle < 1) || (oReply.u16Handle > MCFS_MAX_FILES))) {
+    ret = MCFS_ERR_HANDLE;
+  }
+  if (MCFS_OK == ret) {
+    memset(&g_oMcfs.aoFiles[oReply.u16Handle - 1], 0, sizeof(TMcfsFile));
+    g_oMcfs.aoFiles[oReply.u16Handle - 1].bOpen   = TRUE;
+    g_oMcfs.aoFiles[oReply.u16Handle - 1].u32Size = oReply.u32Count;
+    ret = oReply.u16Handle;
+  } else {
+    LOGW_FORMATTED("mcfs open %s failed: %d", sPath, ret);
+    ret = -ret;
+  }
+  _lwsem_post(&g_oMcfs.lwsem);
+  return ret;
+}
+
+//******************************************************************************
+
+int_32 mcfs_read (int_32 iHandle, void * pvData, uint32_t u32Length)
+{
+  TMcfsFile * poFile;
+  TMcfsMsg  * poReply;
+  uint32_t    u32Tag;                                                           // of the oldest READ not answered completely
+  uint32_t    u32Sent   = 0;                                                    // bytes requested
+  uint32_t    u32Asked  = 0;                                                    // bytes requested by the READs answered
+  uint32_t    u32Done   = 0;                                                    // bytes received
+  uint32_t    u32Pending = 0;                                                   // READs not answered completely
+  uint32_t    u32Len;
+  boolean     bEnd      = FALSE;
+  int_32      ret;
+
+  ret = mcfs_lock(iHandle);
+  if (MCFS_OK != ret) return -ret;
+  poFile = &g_oMcfs.aoFiles[iHandle - 1];
+
+  // a window of READs in flight, each answered by a series of replies in the
+  // order of the requests, the next one sent as soon as the data of the
+  // previous ones has arrived
+  u32Tag = g_oMcfs.u32Tag + 1;
+  while ((MCFS_OK == ret) && (u32Pending || (!bEnd && (u32Sent < u32Length)))) {
+    u32Len = MIN(u32Length - u32Sent, g_oMcfs.u32MaxRead);
+    if (!bEnd && (u32Sent < u32Length)
+        && (!u32Pending || ((u32Pending + g_oMcfs.u32Unacked < MCFS_WINDOW)
+                            && (u32Sent + u32Len - u32Done <= MCFS_READ_WINDOW)))) {
+      ret = mcfs_send(MCFS_OP_READ, iHandle, poFile->u32Pos + u32Sent, u32Len, NULL, 0);
+      u32Sent += u32Len;
+      ++u32Pending;
+      continue;
+    }
+
+    ret = mcfs_recv(u32Tag, &poReply);
+    if (MCFS_OK != ret) break;
+    u32Len = poReply->oHdr.u16Length;
+    if (!bEnd && (poReply->oHdr.u32Offset >= poFile->u32Pos + u32Asked)
+        && (poReply->oHdr.u32Offset - poFile->u32Pos + u32Len <= u32Length)) {
+      memcpy((uint8_t*)pvData + (poReply->oHdr.u32Offset - poFile->u32Pos), poReply->au8Data, u32Len);
+    }
+    if (poReply->oHdr.u8Flags & MCFS_FLAG_LAST) {
+      if (!bEnd) {
+        if (MCFS_OK != poReply->oHdr.i32Status) ret = poReply->oHdr.i32Status;
+        u32Len    = MIN(u32Length - u32Asked, g_oMcfs.u32MaxRead);
+        u32Done  += poReply->oHdr.u32Count;
+        u32Asked += u32Len;
+        bEnd      = (poReply->oHdr.u32Count < u32Len);                          // end of the file, the following READs get nothing
+      }
+      ++u32Tag;
+      --u32Pending;
+    }
+    mcc_free_buffer(poReply);
+  }
+
+  if (MCFS_OK == ret) {
+    poFile->u32Pos += u32Done;
+    ret = u32Done;
+  } else {
+    ret = -ret;
+  }
+  _lwsem_post(&g_oMcfs.lwsem);
+  return ret;
+}
+
+//******************************************************************************
+
+int_32 mcfs_write (int_32 iHandle, const void * pvData, uint32_t u32Length)
+{
+  TMcfsFile * poFile;
+  uint32_t    u32Done = 0;
+  uint32_t    u32Len;
+  int_32      ret;
+
+  ret = mcfs_lock(iHandle);
+  if (MCFS_OK != ret) return -ret;
+  poFile = &g_oMcfs.aoFiles[iHandle - 1];
+
+  while ((MCFS_OK == ret) && (u32Done < u32Length)) {
+    ret = mcfs_waitAcks(MCFS_WINDOW - 1);
+    if (MCFS_OK != ret) break;
+    u32Len = MIN(u32Length - u32Done, MCFS_MAX_DATA);
+    ret = mcfs_send(MCFS_OP_WRITE, iHandle, poFile->u32Pos, 0, (const uint8_t*)pvData + u32Done, (uint16_t)u32Len);
+    if (MCFS_OK != ret) break;
+    ++g_oMcfs.u32Unacked;
+    poFile->u32Pos += u32Len;
+    poFile->u32Size = MAX(poFile->u32Size, poFile->u32Pos);
+    u32Done        += u32Len;
+  }
+
+  if ((MCFS_OK == ret) && (MCFS_OK != poFile->i32Error)) {                      // an earlier one failed
+    ret = poFile->i32Error;
+    poFile->i32Error = MCFS_OK;
+  }
+  _lwsem_post(&g_oMcfs.lwsem);
+  return (MCFS_OK == ret) ? (int_32)u32Length : -ret;
+}
+
+//******************************************************************************
+
+int_32 mcfs_seek (int_32 iHandle, uint32_t u32Offset)
+{
+  TMcfsFile * poFile;
+  int_32      ret;
+
+  ret = mcfs_lock(iHandle);
+  if (MCFS_OK != ret) return -ret;
+  poFile = &g_oMcfs.aoFiles[iHandle - 1];
+  poFile->u32Pos = (MCFS_SEEK_END == u32Offset) ? poFile->u32Size : u32Offset;
+  _lwsem_post(&g_oMcfs.lwsem);
+  return MCFS_OK;
+}
+
+//******************************************************************************
+
+int_32 mcfs_sync (int_32 iHandle)
+{
+  TMcfsFile * poFile;
+  TMcfsHdr    oReply;
+  int_32      ret;
+
+  ret = mcfs_lock(iHandle);
+  if (MCFS_OK != ret) return -ret;
+  poFile = &g_oMcfs.aoFiles[iHandle - 1];
+
+  ret = mcfs_transact(MCFS_OP_SYNC, iHandle, 0, NULL, 0, &oReply);
+  if (MCFS_OK != poFile->i32Error) {                                            // acknowledged on the way
+    if (MCFS_OK == ret) ret = poFile->i32Error;
+    poFile->i32Error = MCFS_OK;
+  }
+  _lwsem_post(&g_oMcfs.lwsem);
+  return -ret;
+}
+
+//******************************************************************************
+
+int_32 mcfs_close (int_32 iHandle)
+{
+  TMcfsFile * poFile;
+  TMcfsHdr    oReply;
+  int_32      ret;
+
+  ret = mcfs_lock(iHandle);
+  if (MCFS_OK != ret) return -ret;
+  poFile = &g_oMcfs.aoFiles[iHandle - 1];
+
+  ret = mcfs_transact(MCFS_OP_CLOSE, iHandle, 0, NULL, 0, &oReply);
+  if ((MCFS_OK == ret) && (MCFS_OK != poFile->i32Error)) ret = poFile->i32Error;
+  if (MCFS_OK != ret) LOGW_FORMATTED("mcfs close of handle %d failed: %d", iHandle, ret);
+  poFile->bOpen = FALSE;
+  _lwsem_post(&g_oMcfs.lwsem);
+  return -ret;
+}
+
+//******************************************************************************
+// Private functions
+//******************************************************************************
+
+static int_32 mcfs_lock (int_32 iHandle)
+{
+  if (!g_oMcfs.bInitialized) return MCFS_ERR_NOT_INITIALIZED;
+  if (MQX_OK != _lwsem_wait_ticks(&g_oMcfs.lwsem, 0)) return MCFS_ERR_LWSEM;
+  if (!g_oMcfs.bReady) {
+    _lwsem_post(&g_oMcfs.lwsem);
+    return MCFS_ERR_NOT_INITIALIZED;
+  }
+  if (iHandle && ((iHandle < 1) || (iHandle > MCFS_MAX_FILES) || !g_oMcfs.aoFiles[iHandle - 1].bOpen)) {
+    _lwsem_post(&g_oMcfs.lwsem);
+    return MCFS_ERR_HANDLE;
+  }
+  return MCFS_OK;
+}
+
+//******************************************************************************
+
+static int_32 mcfs_send (uint8_t u8Op, int_32 iHandle, uint32_t u32Offset, uint32_t u32Count,
+                         const void * pvData, uint16_t u16Length)
+{
+  TMcfsMsg      * poMsg;
+  MCC_MEM_SIZE    size;
+  int             ret;
+
+#if MCC_SEND_NOCOPY
+  ret = mcc_get_buffer((void**)&poMsg, &size, MCFS_TIMEOUT * 1000);             // blocking call, the A5 frees them
+  if (MCC_SUCCESS != ret) {
+    LOGE_FORMATTED("mcfs mcc_get_buffer failed: %d", ret);
+    return MCFS_ERR_SEND;
+  }
+#else
+  poMsg = &g_oMcfs.oTx;
+#endif
+
+  poMsg->oHdr.u16Magic  = MCFS_MAGIC;
+  poMsg->oHdr.u8Op      = u8Op;
+  poMsg->oHdr.u8Flags   = 0;
+  poMsg->oHdr.u32Tag    = ++g_oMcfs.u32Tag;
+  poMsg->oHdr.u16Handle = (uint16_t)iHandle;
+  poMsg->oHdr.u16Length = u16Length;
+  poMsg->oHdr.i32Status = MCFS_OK;
+  poMsg->oHdr.u32Offset = u32Offset;
+  poMsg->oHdr.u32Count  = u32Count;
+  if (u16Length) memcpy(poMsg->au8Data, pvData, u16Length);
+  size = sizeof(TMcfsHdr) + u16Length;
+
+#if MCC_SEND_NOCOPY
+  ret = mcc_send_nocopy(&g_oMcfs.oEndpoint, &g_mcfsEndpointRemote, poMsg, size);
+  if (MCC_SUCCESS != ret) mcc_free_buffer(poMsg);                               // still ours on failure
+#else
+  ret = mcc_send(&g_mcfsEndpointRemote, poMsg, size, MCFS_TIMEOUT * 1000);      // blocking call, waits for a free buffer
+#endif
+  if (MCC_SUCCESS != ret) {
+    LOGE_FORMATTED("mcfs request %d not sent: %d", u8Op, ret);
+    return MCFS_ERR_SEND;
+  }
+  return MCFS_OK;
+}
+
+//******************************************************************************
+
+static int_32 mcfs_recv (uint32_t u32Tag, TMcfsMsg ** ppoReply)
+{
+  TMcfsMsg      * poReply;
+  MCC_MEM_SIZE    size;
+  int             ret;
+
+  while (1) {
+    ret = mcc_recv_nocopy(&g_oMcfs.oEndpoint, (void**)&poReply, &size, MCFS_TIMEOUT * 1000); // blocking call
+    if (MCC_ERR_TIMEOUT == ret) {
+      LOGE_FORMATTED("mcfs no reply to request %u", u32Tag);
+      g_oMcfs.u32Unacked = 0;                                                   // lost, the following replies are still matched by their tags
+      return MCFS_ERR_TIMEOUT;
+    } else if (MCC_SUCCESS != ret) {
+      LOGE_FORMATTED("mcfs mcc_recv_nocopy failed: %d", ret);
+      return MCFS_ERR_TIMEOUT;
+    }
+
+    if ((size < sizeof(TMcfsHdr)) || (MCFS_MAGIC != poReply->oHdr.u16Magic)
+        || (size != sizeof(TMcfsHdr) + poReply->oHdr.u16Length)
+        || !(poReply->oHdr.u8Flags & MCFS_FLAG_REPLY)) {
+      LOGW_FORMATTED("mcfs invalid reply, size %d", size);
+    } else if ((MCFS_OP_WRITE == poReply->oHdr.u8Op) && (!u32Tag || (u32Tag != poReply->oHdr.u32Tag))) {
+      mcfs_takeAck(&poReply->oHdr);
+      if (!u32Tag) break;
+    } else if (u32Tag && (u32Tag == poReply->oHdr.u32Tag)) {
+      *ppoReply = poReply;
+      return MCFS_OK;
+    }
+    mcc_free_buffer(poReply);                                                   // taken, or stale reply of a request timed out
+  }
+  mcc_free_buffer(poReply);
+  return MCFS_OK;
+}
+
+//******************************************************************************
+
+static void mcfs_takeAck (const TMcfsHdr * poReply)
+{
+  TMcfsFile * poFile;
+
+  if (g_oMcfs.u32Unacked) --g_oMcfs.u32Unacked;
+  if ((MCFS_OK == poReply->i32Status) || (poReply->u16Handle < 1)
+      || (poReply->u16Handle > MCFS_MAX_FILES)) return;
+
+  poFile = &g_oMcfs.aoFiles[poReply->u16Handle - 1];
+  LOGW_FORMATTED("mcfs write of handle %d at %u failed: %d", poReply->u16Handle,
+                 poReply->u32Offset, poReply->i32Status);
+  if (poFile->bOpen && (MCFS_OK == poFile->i32Error)) poFile->i32Error = poReply->i32Status;
+}
+
+//******************************************************************************
+
+static int_32 mcfs_waitAcks (uint32_t u32Max)
+{
+  TMcfsMsg  * poReply;
+  int_32      ret = MCFS_OK;
+
+  while ((MCFS_OK == ret) && (g_oMcfs.u32Unacked > u32Max)) {
+    ret = mcfs_recv(0, &poReply);
+  }
+  return ret;
+}
+
+//******************************************************************************
+
+static int_32 mcfs_transact (uint8_t u8Op, int_32 iHandle, uint32_t u32Count,
+                             const void * pvData, uint16_t u16Length, TMcfsHdr * poReply)
+{
+  TMcfsMsg  * poMsg;
+  int_32      ret;
+
+  ret = mcfs_send(u8Op, iHandle, 0, u32Count, pvData, u16Length);
+  if (MCFS_OK != ret) return ret;
+  ret = mcfs_recv(g_oMcfs.u32Tag, &poMsg);                                      // takes the WRITE acknowledgements first
+  if (MCFS_OK != ret) return ret;
+  memcpy(poReply, &poMsg->oHdr, sizeof(*poReply));
+  mcc_free_buffer(poMsg);
+  return poReply->i32Status;
+}
+
+//******************************************************************************
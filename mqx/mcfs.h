@@ -0,0 +1,109 @@
+/** ****************************************************************************
+ *
+ *  @file       mcfs.h
+ *  @brief      MCC filesystem client.
+ *
+ *  Reads and writes files of the Linux directory served by mcfsd over MCC
+ *  (see easyduo_mcfs_common.h). The ESL MCFS client (_io_mcfs_install) is
+ *  not built in the shipped library, this one is called directly instead of
+ *  through the MQX I/O subsystem. Writes are pipelined: mcfs_write() returns
+ *  once the data is sent, MCFS_WINDOW requests may wait for their
+ *  acknowledgement and the server writes them to the disk later on, so a
+ *  failure shows up in a later call on the same file. Reads of up to
+ *  MCFS_MAX_READ bytes take one request, the server reads ahead while a file
+ *  is read sequentially. The functions may be called by any task once
+ *  mcfs_init() succeeded, the calls are serialized by a semaphore.
+ *
+ *  @copyright  Elnico Ltd. All rights reserved.
+ *
+ ******************************************************************************/
+/*
+ *  THIS SOFTWARE IS PROVIDED BY ELNICO "AS IS" AND ANY EXPRESSED OR
+ *  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ *  OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ *  IN NO EVENT SHALL ELNICO OR ITS CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ *  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ *  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ *  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ *  IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ *  THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************/
+
+#ifndef MCFS_H_730582305823058230582305
+#define MCFS_H_730582305823058230582305
+//******************************************************************************
+#include <mqx.h>
+#include <bsp.h>
+#if (MQX_VERSION >= 410)
+# include "psptypes_legacy.h"
+#endif
+
+#include "easyduo_mcfs_common.h"
+
+//******************************************************************************
+// Return values
+//******************************************************************************
+
+// MCFS_OK and MCFS_ERR_* of the server (see easyduo_mcfs_common.h), and
+enum {
+  MCFS_ERR_NOT_INITIALIZED        = 64,                                         //!< mcfs_init() not called or failed.
+  MCFS_ERR_LWSEM,                                                               //!< Waiting for the client semaphore failed.
+  MCFS_ERR_ENDPOINT,                                                            //!< MCC endpoint not created.
+  MCFS_ERR_SEND,                                                                //!< Request not sent.
+  MCFS_ERR_TIMEOUT,                                                             //!< No reply within MCFS_TIMEOUT.
+  MCFS_ERR_VERSION,                                                             //!< Protocol of the server not supported.
+};
+
+#define MCFS_TIMEOUT                    (2000)                                  //!< Maximum time in milliseconds to wait for a reply.
+#define MCFS_SEEK_END                   (0xFFFFFFFF)                            //!< mcfs_seek() offset of the end of the file.
+
+//******************************************************************************
+// Public functions
+//******************************************************************************
+
+/** Creates the ESL_MCFS_ENDPOINT_M4_* endpoint and greets the server, which
+ *  closes the files left open by a previous run. MCC must be initialized
+ *  (by mcc_task). May be called again if the server was not running.
+ * @return      MCFS_OK on success.
+ *              MCFS_ERR_ENDPOINT, MCFS_ERR_SEND, MCFS_ERR_TIMEOUT or
+ *              MCFS_ERR_VERSION on failure. */
+uint_32 mcfs_init (void);
+
+/** Opens a file.
+ * @param[in]   sPath         Path relative to the directory served.
+ * @param[in]   u32Mode       MCFS_OPEN_* flags.
+ * @return      Handle (positive) on success, -MCFS_ERR_* on failure. */
+int_32 mcfs_open (const char * sPath, uint32_t u32Mode);
+
+/** Reads from the current position of a file, which moves by the bytes
+ *  read.
+ * @return      Number of bytes read (less than u32Length at the end of the
+ *              file), -MCFS_ERR_* on failure. */
+int_32 mcfs_read (int_32 iHandle, void * pvData, uint32_t u32Length);
+
+/** Writes at the current position of a file, which moves by u32Length.
+ * @return      u32Length on success, -MCFS_ERR_* if the data was not sent or
+ *              an earlier write of the file failed. */
+int_32 mcfs_write (int_32 iHandle, const void * pvData, uint32_t u32Length);
+
+/** Moves the current position of a file.
+ * @param[in]   u32Offset     New position, MCFS_SEEK_END for the end of the
+ *                            file (as known from the open and the writes).
+ * @return      MCFS_OK on success, -MCFS_ERR_HANDLE if not open. */
+int_32 mcfs_seek (int_32 iHandle, uint32_t u32Offset);
+
+/** Waits for the writes of a file and flushes it to the disk of the server.
+ * @return      MCFS_OK on success, -MCFS_ERR_* of this or an earlier write
+ *              on failure. */
+int_32 mcfs_sync (int_32 iHandle);
+
+/** Waits for the writes of a file and closes it, the handle is not valid
+ *  any more even on failure.
+ * @return      As mcfs_sync(). */
+int_32 mcfs_close (int_32 iHandle);
+
+//******************************************************************************
+#endif // MCFS_H_730582305823058230582305 //
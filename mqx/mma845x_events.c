@@ -0,0 +1,272 @@
+/** ****************************************************************************
+ *
+ *  @file       mma845x_events.c
+ *  @brief      MMA845xQ motion, freefall, transient and pulse functions on
+ *              top of the ESL MMA845xQ driver.
+ *
+ *  @copyright  Elnico Ltd. All rights reserved.
+ *
+ ******************************************************************************/
+/*
+ *  THIS SOFTWARE IS PROVIDED BY ELNICO "AS IS" AND ANY EXPRESSED OR
+ *  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ *  OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ *  IN NO EVENT SHALL ELNICO OR ITS CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ *  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ *  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ *  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ *  IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ *  THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************/
+
+#include "mma845x_events.h"
+
+#include "esl_i2c.h"
+#include "esl_utils.h"
+
+#include <string.h>
+
+//******************************************************************************
+// Functions declarations
+//******************************************************************************
+
+/** Computes the debounce time step of FF_MT_COUNT and TRANSIENT_COUNT, which
+ *  is also the step of PULSE_LTCY and PULSE_WIND; PULSE_TMLT counts half of
+ *  it (PULSE_LPF_EN cleared).
+ * @param[in]   poConfig      Accelerometer configuration.
+ * @return      Step in microseconds. */
+static uint_32 mma845x_stepUs (const ESL_I2C_MMA845XQ_TConfig * poConfig);
+
+/** Converts a time to a number of steps.
+ * @param[in]   u32Us         Time in microseconds.
+ * @param[in]   u32StepUs     Step in microseconds.
+ * @return      Steps rounded, limited to 255. */
+static uint_8 mma845x_steps (uint_32 u32Us, uint_32 u32StepUs);
+
+/** Decodes the axes of FF_MT_SRC or TRANSIENT_SRC (XHP, XHE, YHP, YHE, ZHP,
+ *  ZHE from bit 0 up in both).
+ * @param[in]   u8Src         Source register value.
+ * @param[out]  pu8Negative   MCC_ACCEL_AXIS_* bits of the negative axes.
+ * @return      MCC_ACCEL_AXIS_* bits of the axes of the event. */
+static uint_8 mma845x_axes (uint_8 u8Src, uint_8 * pu8Negative);
+
+/** Reads one register.
+ * @param[in]   hAccelDevice  Opened accelerometer device handle.
+ * @param[in]   u8Reg         Register address.
+ * @param[out]  pu8Value      Destination of the value.
+ * @return      ESL_I2C_OK on success, an ESL_I2C_* error otherwise. */
+static uint_8 mma845x_readReg (ESL_I2C_MMA845XQ_TDevice * hAccelDevice,
+                               uint_8                     u8Reg,
+                               uint_8                   * pu8Value);
+
+//******************************************************************************
+//******************************************************************************
+//******************************************************************************
+
+boolean mma845x_eventsCheck (const TMccAccelEvents * poReq)
+{
+  if (!poReq) return FALSE;
+  return (   (poReq->u8MotionThs <= MCC_ACCEL_EVENTS_MAX_THS)
+          && (poReq->u8FreefallThs <= MCC_ACCEL_EVENTS_MAX_THS)
+          && (poReq->u8TransientThs <= MCC_ACCEL_EVENTS_MAX_THS)
+          && (poReq->u8TapThs <= MCC_ACCEL_EVENTS_MAX_THS)
+          && !(poReq->u8MotionThs && poReq->u8FreefallThs)                      // one engine for both
+          && !(poReq->u8Axes & ~MCC_ACCEL_AXIS_ALL)
+          && (poReq->u8DoubleTap <= 1)
+          && !(poReq->u8DoubleTap && !poReq->u8TapThs)) ? TRUE : FALSE;
+}
+
+//******************************************************************************
+
+void mma845x_eventsEncode (const TMccAccelEvents     * poReq,
+                           ESL_I2C_MMA845XQ_TConfig  * poConfig,
+                           uint_8                      u8Line,
+                           TMma845xEvents            * poRegs,
+                           TMccAccelEvents           * poEffective)
+{
+  uint_8  u8Axes    = poReq->u8Axes ? poReq->u8Axes : MCC_ACCEL_AXIS_ALL;
+  uint_32 u32StepUs = mma845x_stepUs(poConfig);
+  uint_8  u8Count   = mma845x_steps((uint_32)poReq->u16DebounceMs * 1000, u32StepUs);
+  uint_8  u8Pulse;
+
+  memset(poRegs, 0, sizeof(*poRegs));
+  if (poReq->u8MotionThs || poReq->u8FreefallThs) {
+    poRegs->u8FfMtCfg   = MMA845X_FF_MT_CFG_ELE_MASK | (uint_8)(u8Axes << MMA845X_FF_MT_CFG_EFE_SHIFT)
+                          | (poReq->u8MotionThs ? MMA845X_FF_MT_CFG_OAE_MASK : 0);
+    poRegs->u8FfMtThs   = MMA845X_FF_MT_THS_DBCNTM_MASK
+                          | (poReq->u8MotionThs ? poReq->u8MotionThs : poReq->u8FreefallThs);
+    poRegs->u8FfMtCount = u8Count;
+    poRegs->u8IntEn    |= ESL_I2C_MMA845XQ_CTRL_REG4_INT_EN_FF_MT_MASK;
+  }
+  if (poReq->u8TransientThs) {
+    poRegs->u8TransientCfg   = MMA845X_TRANSIENT_CFG_ELE_MASK | (uint_8)(u8Axes << MMA845X_TRANSIENT_CFG_EFE_SHIFT);
+    poRegs->u8TransientThs   = MMA845X_TRANSIENT_THS_DBCNTM_MASK | poReq->u8TransientThs;
+    poRegs->u8TransientCount = u8Count;
+    poRegs->u8IntEn         |= ESL_I2C_MMA845XQ_CTRL_REG4_INT_EN_TRANS_MASK;
+  }
+  if (poReq->u8TapThs) {
+    u8Pulse = (u8Axes & MCC_ACCEL_AXIS_X) | ((u8Axes & MCC_ACCEL_AXIS_Y) << 1) | ((u8Axes & MCC_ACCEL_AXIS_Z) << 2);
+    poRegs->u8PulseCfg  = MMA845X_PULSE_CFG_ELE_MASK | (u8Pulse & MMA845X_PULSE_CFG_SPEFE_MASK);
+    if (poReq->u8DoubleTap) poRegs->u8PulseCfg |= (uint_8)(u8Pulse << 1) & MMA845X_PULSE_CFG_DPEFE_MASK;
+    poRegs->au8Pulse[0] = poReq->u8TapThs;                                      // PULSE_THSX to PULSE_WIND
+    poRegs->au8Pulse[1] = poReq->u8TapThs;
+    poRegs->au8Pulse[2] = poReq->u8TapThs;
+    poRegs->au8Pulse[3] = MAX(mma845x_steps(MMA845X_TAP_LIMIT_US, u32StepUs / 2), 1);
+    poRegs->au8Pulse[4] = mma845x_steps(MMA845X_TAP_LATENCY_US, u32StepUs);
+    poRegs->au8Pulse[5] = poReq->u8DoubleTap ? mma845x_steps(MMA845X_TAP_WINDOW_US, u32StepUs) : 0;
+    poRegs->u8IntEn    |= ESL_I2C_MMA845XQ_CTRL_REG4_INT_EN_PULSE_MASK;
+  }
+
+  // CTRL_REG4 bits and their CTRL_REG5 routing bits are at the same positions
+  poConfig->u8CtrlReg4 = (uint_8)((poConfig->u8CtrlReg4 & ~MMA845X_CTRL_REG4_EVENTS_MASK) | poRegs->u8IntEn);
+  poConfig->u8CtrlReg5 &= ~MMA845X_CTRL_REG4_EVENTS_MASK;
+  if (1 == u8Line) poConfig->u8CtrlReg5 |= poRegs->u8IntEn;
+
+  if (poEffective) {
+    *poEffective = *poReq;
+    poEffective->u8Axes        = u8Axes;
+    poEffective->u16DebounceMs = (uint16_t)((u8Count * u32StepUs + 500) / 1000);
+  }
+}
+
+//******************************************************************************
+
+uint_8 mma845x_eventsWrite (ESL_I2C_MMA845XQ_TDevice * hAccelDevice,
+                            const TMma845xEvents     * poRegs)
+{
+  uint_8  au8Data[2];
+  uint_32 u32Wait;
+  int     ret;
+
+  if (!hAccelDevice || !poRegs) return ESL_I2C_INVALID_ARGUMENT;
+  u32Wait = hAccelDevice->oConfig.u32WaitTicks;
+
+  // the source registers between the writable ones are skipped
+  ret = esl_i2c_write(&hAccelDevice->hI2CDevice, ESL_I2C_MMA845XQ_FF_MT_CFG, &poRegs->u8FfMtCfg, 1, u32Wait);
+  if (ESL_I2C_OK != ret) return (uint_8)ret;
+  au8Data[0] = poRegs->u8FfMtThs;
+  au8Data[1] = poRegs->u8FfMtCount;
+  ret = esl_i2c_write(&hAccelDevice->hI2CDevice, MMA845X_FF_MT_THS, au8Data, 2, u32Wait);
+  if (ESL_I2C_OK != ret) return (uint_8)ret;
+
+  ret = esl_i2c_write(&hAccelDevice->hI2CDevice, MMA845X_TRANSIENT_CFG, &poRegs->u8TransientCfg, 1, u32Wait);
+  if (ESL_I2C_OK != ret) return (uint_8)ret;
+  au8Data[0] = poRegs->u8TransientThs;
+  au8Data[1] = poRegs->u8TransientCount;
+  ret = esl_i2c_write(&hAccelDevice->hI2CDevice, MMA845X_TRANSIENT_THS, au8Data, 2, u32Wait);
+  if (ESL_I2C_OK != ret) return (uint_8)ret;
+
+  ret = esl_i2c_write(&hAccelDevice->hI2CDevice, MMA845X_PULSE_CFG, &poRegs->u8PulseCfg, 1, u32Wait);
+  if (ESL_I2C_OK != ret) return (uint_8)ret;
+  return (uint_8)esl_i2c_write(&hAccelDevice->hI2CDevice, MMA845X_PULSE_THSX, poRegs->au8Pulse,
+                               MMA845X_PULSE_REGS, u32Wait);
+}
+
+//******************************************************************************
+
+uint_8 mma845x_eventsRead (TMccAccelEvent           * paoDst,
+                           uint32_t                 * pu32Cnt,
+                           uint_8                   * pu8IntSource,
+                           const TMma845xEvents     * poRegs,
+                           ESL_I2C_MMA845XQ_TDevice * hAccelDevice)
+{
+  TMccAccelEvent  * poEvent;
+  uint_8            u8Src;
+  uint_8            ret;
+
+  if (!paoDst || !pu32Cnt || !pu8IntSource || !poRegs || !hAccelDevice) return ESL_I2C_INVALID_ARGUMENT;
+  *pu32Cnt = 0;
+
+  ret = mma845x_readReg(hAccelDevice, ESL_I2C_MMA845XQ_INT_SOURCE, pu8IntSource);
+  if (ESL_I2C_OK != ret) return ret;
+  memset(paoDst, 0, MMA845X_EVENTS_MAX * sizeof(*paoDst));
+
+  // reading the source register clears the event
+  if ((*pu8IntSource & MMA845X_INT_SOURCE_FF_MT_MASK) && (poRegs->u8IntEn & ESL_I2C_MMA845XQ_CTRL_REG4_INT_EN_FF_MT_MASK)) {
+    ret = mma845x_readReg(hAccelDevice, ESL_I2C_MMA845XQ_FF_MT_SRC, &u8Src);
+    if (ESL_I2C_OK != ret) return ret;
+    if (u8Src & MMA845X_FF_MT_SRC_EA_MASK) {
+      poEvent = &paoDst[(*pu32Cnt)++];
+      poEvent->u8Source = u8Src;
+      if (poRegs->u8FfMtCfg & MMA845X_FF_MT_CFG_OAE_MASK) {
+        poEvent->u8Type = MCC_ACCEL_EVENT_MOTION;
+        poEvent->u8Axes = mma845x_axes(u8Src, &poEvent->u8Negative);
+      } else {                                                                  // all the axes watched
+        poEvent->u8Type = MCC_ACCEL_EVENT_FREEFALL;
+        poEvent->u8Axes = (poRegs->u8FfMtCfg >> MMA845X_FF_MT_CFG_EFE_SHIFT) & MCC_ACCEL_AXIS_ALL;
+      }
+    }
+  }
+  if ((*pu8IntSource & MMA845X_INT_SOURCE_TRANS_MASK) && (poRegs->u8IntEn & ESL_I2C_MMA845XQ_CTRL_REG4_INT_EN_TRANS_MASK)) {
+    ret = mma845x_readReg(hAccelDevice, MMA845X_TRANSIENT_SRC, &u8Src);
+    if (ESL_I2C_OK != ret) return ret;
+    if (u8Src & MMA845X_TRANSIENT_SRC_EA_MASK) {
+      poEvent = &paoDst[(*pu32Cnt)++];
+      poEvent->u8Source = u8Src;
+      poEvent->u8Type   = MCC_ACCEL_EVENT_TRANSIENT;
+      poEvent->u8Axes   = mma845x_axes(u8Src, &poEvent->u8Negative);
+    }
+  }
+  if ((*pu8IntSource & MMA845X_INT_SOURCE_PULSE_MASK) && (poRegs->u8IntEn & ESL_I2C_MMA845XQ_CTRL_REG4_INT_EN_PULSE_MASK)) {
+    ret = mma845x_readReg(hAccelDevice, MMA845X_PULSE_SRC, &u8Src);
+    if (ESL_I2C_OK != ret) return ret;
+    if (u8Src & MMA845X_PULSE_SRC_EA_MASK) {
+      poEvent = &paoDst[(*pu32Cnt)++];
+      poEvent->u8Source   = u8Src;
+      poEvent->u8Type     = (u8Src & MMA845X_PULSE_SRC_DPE_MASK) ? MCC_ACCEL_EVENT_DOUBLE_TAP : MCC_ACCEL_EVENT_TAP;
+      poEvent->u8Axes     = (u8Src >> MMA845X_PULSE_SRC_AX_SHIFT) & MCC_ACCEL_AXIS_ALL;
+      poEvent->u8Negative = (u8Src >> MMA845X_PULSE_SRC_POL_SHIFT) & poEvent->u8Axes;
+    }
+  }
+  return ESL_I2C_OK;
+}
+
+//******************************************************************************
+// Private functions
+//******************************************************************************
+
+static uint_32 mma845x_stepUs (const ESL_I2C_MMA845XQ_TConfig * poConfig)
+{
+  static const uint_32 aau32Step[4][8] = {                                      // 800, 400, 200, 100, 50, 12.5, 6.25, 1.56 Hz
+    { 1250, 2500, 5000, 10000, 20000, 20000,  20000,  20000 },                  // normal
+    { 1250, 2500, 5000, 10000, 20000, 80000,  80000,  80000 },                  // low noise low power
+    { 1250, 2500, 2500,  2500,  2500,  2500,   2500,   2500 },                  // high resolution
+    { 1250, 2500, 5000, 10000, 20000, 80000, 160000, 640000 },                  // low power
+  };
+
+  return aau32Step[(poConfig->u8CtrlReg2 & ESL_I2C_MMA845XQ_CTRL_REG2_MODS_MASK) >> ESL_I2C_MMA845XQ_CTRL_REG2_MODS_SHIFT]
+                  [(poConfig->u8CtrlReg1 & ESL_I2C_MMA845XQ_CTRL_REG1_DR_MASK) >> ESL_I2C_MMA845XQ_CTRL_REG1_DR_SHIFT];
+}
+
+//******************************************************************************
+
+static uint_8 mma845x_steps (uint_32 u32Us, uint_32 u32StepUs)
+{
+  return (uint_8)MIN((u32Us + u32StepUs / 2) / u32StepUs, 255);
+}
+
+//******************************************************************************
+
+static uint_8 mma845x_axes (uint_8 u8Src, uint_8 * pu8Negative)
+{
+  uint_8 u8Axes = ((u8Src >> 1) & MCC_ACCEL_AXIS_X) | ((u8Src >> 2) & MCC_ACCEL_AXIS_Y) | ((u8Src >> 3) & MCC_ACCEL_AXIS_Z);
+
+  *pu8Negative = (u8Src & MCC_ACCEL_AXIS_X) | ((u8Src >> 1) & MCC_ACCEL_AXIS_Y) | ((u8Src >> 2) & MCC_ACCEL_AXIS_Z);
+  *pu8Negative &= u8Axes;                                                       // the polarity of the axes not triggered is stale
+  return u8Axes;
+}
+
+//******************************************************************************
+
+static uint_8 mma845x_readReg (ESL_I2C_MMA845XQ_TDevice * hAccelDevice,
+                               uint_8                     u8Reg,
+                               uint_8                   * pu8Value)
+{
+  return (uint_8)esl_i2c_read(&hAccelDevice->hI2CDevice, u8Reg, pu8Value, 1,
+                              hAccelDevice->oConfig.u32WaitTicks);
+}
+
+//******************************************************************************
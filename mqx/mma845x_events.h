@@ -0,0 +1,181 @@
+/** ****************************************************************************
+ *
+ *  @file       mma845x_events.h
+ *  @brief      MMA845xQ motion, freefall, transient and pulse functions on
+ *              top of the ESL MMA845xQ driver.
+ *
+ *  The ESL driver defines FF_MT_CFG and FF_MT_SRC and the interrupt bits of
+ *  the embedded functions, but neither their thresholds nor the transient and
+ *  pulse registers. These functions translate a TMccAccelEvents detection to
+ *  the register values (the time steps depend on the output data rate and
+ *  the oversampling mode, see AN4070, AN4071 and AN4072), write them while
+ *  the sensor is in STANDBY, and read the sources back: INT_SOURCE, then the
+ *  source register of each function flagged, which clears its event.
+ *
+ *  @copyright  Elnico Ltd. All rights reserved.
+ *
+ ******************************************************************************/
+/*
+ *  THIS SOFTWARE IS PROVIDED BY ELNICO "AS IS" AND ANY EXPRESSED OR
+ *  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ *  OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ *  IN NO EVENT SHALL ELNICO OR ITS CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ *  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ *  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ *  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ *  IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ *  THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************/
+
+#ifndef MMA845X_EVENTS_H_618203957103857201937502
+#define MMA845X_EVENTS_H_618203957103857201937502
+//******************************************************************************
+#include <mqx.h>
+#include <bsp.h>
+#if (MQX_VERSION >= 410)
+# include "psptypes_legacy.h"
+#endif
+
+#include "esl_i2c_MMA845xQ.h"
+#include "easyduo_mcc_common.h"
+
+//******************************************************************************
+// Settings
+//******************************************************************************
+
+/** @def MMA845X_TAP_LIMIT_US
+ * @brief Longest pulse taken for a tap (PULSE_TMLT) in microseconds. */
+#ifndef MMA845X_TAP_LIMIT_US
+# define MMA845X_TAP_LIMIT_US           (50000)
+#endif
+/** @def MMA845X_TAP_LATENCY_US
+ * @brief Time after a tap in which pulses are ignored (PULSE_LTCY) in
+ *        microseconds. */
+#ifndef MMA845X_TAP_LATENCY_US
+# define MMA845X_TAP_LATENCY_US         (100000)
+#endif
+/** @def MMA845X_TAP_WINDOW_US
+ * @brief Time after the latency in which the second tap of a double tap
+ *        comes (PULSE_WIND) in microseconds. */
+#ifndef MMA845X_TAP_WINDOW_US
+# define MMA845X_TAP_WINDOW_US          (300000)
+#endif
+
+#define MMA845X_EVENTS_MAX              (3)                                     //!< Events of one mma845x_eventsRead(), one per function.
+
+//******************************************************************************
+// Registers missing in esl_i2c_MMA845xQ.h
+//******************************************************************************
+
+#define MMA845X_FF_MT_THS               (0x17)                                  //!< RW Freefall/Motion threshold.
+#define MMA845X_FF_MT_COUNT             (0x18)                                  //!< RW Freefall/Motion debounce counter.
+#define MMA845X_TRANSIENT_CFG           (0x1D)                                  //!< RW Transient configuration.
+#define MMA845X_TRANSIENT_SRC           (0x1E)                                  //!< R  Transient source.
+#define MMA845X_TRANSIENT_THS           (0x1F)                                  //!< RW Transient threshold.
+#define MMA845X_TRANSIENT_COUNT         (0x20)                                  //!< RW Transient debounce counter.
+#define MMA845X_PULSE_CFG               (0x21)                                  //!< RW Pulse configuration.
+#define MMA845X_PULSE_SRC               (0x22)                                  //!< R  Pulse source.
+#define MMA845X_PULSE_THSX              (0x23)                                  //!< RW Pulse X threshold, followed by PULSE_THSY, PULSE_THSZ, PULSE_TMLT, PULSE_LTCY and PULSE_WIND.
+#define MMA845X_PULSE_REGS              (6)                                     //!< PULSE_THSX to PULSE_WIND.
+
+#define MMA845X_FF_MT_CFG_ELE_MASK      (0x80)                                  //!< Event latch: 1: FF_MT_SRC holds the event until read.
+#define MMA845X_FF_MT_CFG_OAE_MASK      (0x40)                                  //!< 1: motion (OR of the axes above), 0: freefall (AND of the axes below).
+#define MMA845X_FF_MT_CFG_EFE_SHIFT     (3)                                     //!< XEFE, YEFE, ZEFE axis enables shift (MCC_ACCEL_AXIS_* order).
+#define MMA845X_FF_MT_SRC_EA_MASK       (0x80)                                  //!< Event active.
+#define MMA845X_FF_MT_THS_DBCNTM_MASK   (0x80)                                  //!< 1: the debounce counter clears when the condition ends.
+
+#define MMA845X_TRANSIENT_CFG_ELE_MASK  (0x10)                                  //!< Event latch: 1: TRANSIENT_SRC holds the event until read.
+#define MMA845X_TRANSIENT_CFG_HPF_BYP_MASK (0x01)                               //!< 1: the high-pass filter is bypassed.
+#define MMA845X_TRANSIENT_CFG_EFE_SHIFT (1)                                     //!< XTEFE, YTEFE, ZTEFE axis enables shift (MCC_ACCEL_AXIS_* order).
+#define MMA845X_TRANSIENT_SRC_EA_MASK   (0x40)                                  //!< Event active.
+#define MMA845X_TRANSIENT_THS_DBCNTM_MASK (0x80)                                //!< 1: the debounce counter clears when the condition ends.
+
+#define MMA845X_PULSE_CFG_ELE_MASK      (0x40)                                  //!< Event latch: 1: PULSE_SRC holds the event until read.
+#define MMA845X_PULSE_CFG_SPEFE_MASK    (0x15)                                  //!< XSPEFE, YSPEFE, ZSPEFE single pulse enables (bits 0, 2, 4).
+#define MMA845X_PULSE_CFG_DPEFE_MASK    (0x2A)                                  //!< XDPEFE, YDPEFE, ZDPEFE double pulse enables (bits 1, 3, 5).
+#define MMA845X_PULSE_SRC_EA_MASK       (0x80)                                  //!< Event active.
+#define MMA845X_PULSE_SRC_AX_SHIFT      (4)                                     //!< AxX, AxY, AxZ axes of the event shift (MCC_ACCEL_AXIS_* order).
+#define MMA845X_PULSE_SRC_DPE_MASK      (0x08)                                  //!< 1: double pulse.
+#define MMA845X_PULSE_SRC_POL_SHIFT     (0)                                     //!< PolX, PolY, PolZ shift (1: negative, MCC_ACCEL_AXIS_* order).
+
+#define MMA845X_INT_SOURCE_TRANS_MASK   (0x20)                                  //!< Transient interrupt pending.
+#define MMA845X_INT_SOURCE_PULSE_MASK   (0x08)                                  //!< Pulse interrupt pending.
+#define MMA845X_INT_SOURCE_FF_MT_MASK   (0x04)                                  //!< Freefall/Motion interrupt pending.
+
+/** CTRL_REG4 bits (and CTRL_REG5 routing bits) of the functions handled here. */
+#define MMA845X_CTRL_REG4_EVENTS_MASK   (ESL_I2C_MMA845XQ_CTRL_REG4_INT_EN_TRANS_MASK | ESL_I2C_MMA845XQ_CTRL_REG4_INT_EN_PULSE_MASK \
+                                         | ESL_I2C_MMA845XQ_CTRL_REG4_INT_EN_FF_MT_MASK)
+
+//******************************************************************************
+// Public types
+//******************************************************************************
+
+/** Register values of a detection, computed by mma845x_eventsEncode(). */
+typedef struct t_mma845x_events_struct {
+  uint_8            u8FfMtCfg;                                                  //!< FF_MT_CFG.
+  uint_8            u8FfMtThs;                                                  //!< FF_MT_THS.
+  uint_8            u8FfMtCount;                                                //!< FF_MT_COUNT.
+  uint_8            u8TransientCfg;                                             //!< TRANSIENT_CFG.
+  uint_8            u8TransientThs;                                             //!< TRANSIENT_THS.
+  uint_8            u8TransientCount;                                           //!< TRANSIENT_COUNT.
+  uint_8            u8PulseCfg;                                                 //!< PULSE_CFG.
+  uint_8            au8Pulse[MMA845X_PULSE_REGS];                               //!< PULSE_THSX to PULSE_WIND.
+  uint_8            u8IntEn;                                                    //!< MMA845X_CTRL_REG4_EVENTS_MASK bits of the functions enabled.
+} TMma845xEvents;
+
+//******************************************************************************
+// Public functions
+//******************************************************************************
+
+/** Checks the detection settings.
+ * @param[in]   poReq         Settings (see TMccAccelEvents).
+ * @return      TRUE if they are in range (none included). */
+boolean mma845x_eventsCheck (const TMccAccelEvents * poReq);
+
+/** Computes the register values of a detection for a configuration, and sets
+ *  the interrupts of the functions enabled in it: CTRL_REG4 and the CTRL_REG5
+ *  routing to the given line.
+ * @param[in]   poReq         Settings, checked by mma845x_eventsCheck().
+ * @param[in,out] poConfig    Accelerometer configuration the detection runs
+ *                            with (output data rate and oversampling mode).
+ * @param[in]   u8Line        Interrupt line of the events (1: INT1, 2: INT2).
+ * @param[out]  poRegs        Destination of the register values.
+ * @param[out]  poEffective   Destination of the settings in effect (u8Axes
+ *                            resolved, u16DebounceMs rounded), NULL if not
+ *                            needed. */
+void mma845x_eventsEncode (const TMccAccelEvents     * poReq,
+                           ESL_I2C_MMA845XQ_TConfig  * poConfig,
+                           uint_8                      u8Line,
+                           TMma845xEvents            * poRegs,
+                           TMccAccelEvents           * poEffective);
+
+/** Writes the registers of a detection. The sensor must be in STANDBY.
+ * @param[in]   hAccelDevice  Opened accelerometer device handle.
+ * @param[in]   poRegs        Register values (mma845x_eventsEncode()).
+ * @return      ESL_I2C_OK on success.
+ *              ESL_I2C_INVALID_ARGUMENT if NULL or invalid handle given.
+ *              Any I2C bus communication error. */
+uint_8 mma845x_eventsWrite (ESL_I2C_MMA845XQ_TDevice * hAccelDevice,
+                            const TMma845xEvents     * poRegs);
+
+/** Reads INT_SOURCE and the source register of each function flagged, and
+ *  decodes the events (timestamps not set).
+ * @param[out]  paoDst        Array of MMA845X_EVENTS_MAX events.
+ * @param[out]  pu32Cnt       Number of events stored to paoDst.
+ * @param[out]  pu8IntSource  INT_SOURCE value read.
+ * @param[in]   poRegs        Register values of the detection in effect.
+ * @param[in]   hAccelDevice  Opened accelerometer device handle.
+ * @return      ESL_I2C_OK on success.
+ *              ESL_I2C_INVALID_ARGUMENT if NULL or invalid handle given.
+ *              Any I2C bus communication error. */
+uint_8 mma845x_eventsRead (TMccAccelEvent           * paoDst,
+                           uint32_t                 * pu32Cnt,
+                           uint_8                   * pu8IntSource,
+                           const TMma845xEvents     * poRegs,
+                           ESL_I2C_MMA845XQ_TDevice * hAccelDevice);
+
+//******************************************************************************
+#endif // MMA845X_EVENTS_H_618203957103857201937502 //
@@ -0,0 +1,98 @@
+/** ****************************************************************************
+ *
+ *  @file       mma845x_fifo.c
+ *  @brief      MMA8451Q FIFO access on top of the ESL MMA845xQ driver.
+ *
+ *  @copyright  Elnico Ltd. All rights reserved.
+ *
+ ******************************************************************************/
+/*
+ *  THIS SOFTWARE IS PROVIDED BY ELNICO "AS IS" AND ANY EXPRESSED OR
+ *  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ *  OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ *  IN NO EVENT SHALL ELNICO OR ITS CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ *  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ *  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ *  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ *  IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ *  THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************/
+
+#include "mma845x_fifo.h"
+
+#include "esl_i2c.h"
+#include "esl_utils.h"
+
+//******************************************************************************
+//******************************************************************************
+//******************************************************************************
+
+uint_8 mma845x_fifoSetup (ESL_I2C_MMA845XQ_TDevice * hAccelDevice,
+                          uint_8                     u8Mode,
+                          uint_8                     u8Watermark)
+{
+  uint_8 u8FSetup;
+
+  if (!hAccelDevice || (u8Watermark > MMA845X_FIFO_SIZE)) return ESL_I2C_INVALID_ARGUMENT;
+
+  u8FSetup = (u8Mode & MMA845X_F_SETUP_F_MODE_MASK) | (u8Watermark & MMA845X_F_SETUP_F_WMRK_MASK);
+  return (uint_8)esl_i2c_write(&hAccelDevice->hI2CDevice, MMA845X_F_SETUP, &u8FSetup, 1,
+                               hAccelDevice->oConfig.u32WaitTicks);
+}
+
+//******************************************************************************
+
+uint_8 mma845x_fifoRead (int_16                  (* pai16Data)[3],
+                         uint32_t                   u32MaxCnt,
+                         uint32_t                 * pu32Cnt,
+                         boolean                  * pbOverflow,
+                         ESL_I2C_MMA845XQ_TDevice * hAccelDevice)
+{
+  uint_8    au8Data[MMA845X_FIFO_SIZE * MMA845X_SAMPLE_BYTES];
+  uint_8    u8Status;
+  uint32_t  u32Cnt;
+  uint32_t  i;
+  int       ret;
+
+  if (!pai16Data || !pu32Cnt || !pbOverflow || !hAccelDevice) return ESL_I2C_INVALID_ARGUMENT;
+  *pu32Cnt    = 0;
+  *pbOverflow = FALSE;
+
+  ret = esl_i2c_read(&hAccelDevice->hI2CDevice, ESL_I2C_MMA845XQ_F_STATUS, &u8Status, 1,
+                     hAccelDevice->oConfig.u32WaitTicks);
+  if (ESL_I2C_OK != ret) return (uint_8)ret;
+  *pbOverflow = (u8Status & MMA845X_F_STATUS_F_OVF_MASK) ? TRUE : FALSE;
+  u32Cnt = MIN(MIN(u8Status & MMA845X_F_STATUS_F_CNT_MASK, MMA845X_FIFO_SIZE), u32MaxCnt);
+  if (!u32Cnt) return ESL_I2C_OK;
+
+  // one transfer for all the samples, the address wraps at OUT_Z_LSB
+  ret = esl_i2c_read(&hAccelDevice->hI2CDevice, ESL_I2C_MMA845XQ_OUT_X_MSB, au8Data,
+                     (uint_8)(u32Cnt * MMA845X_SAMPLE_BYTES), hAccelDevice->oConfig.u32WaitTicks);
+  if (ESL_I2C_OK != ret) return (uint_8)ret;
+
+  for (i = 0; i < u32Cnt; ++i) {
+    const uint_8 * pu8Src = &au8Data[i * MMA845X_SAMPLE_BYTES];
+    pai16Data[i][0] = (int_16)((pu8Src[0] << 8) | pu8Src[1]);
+    pai16Data[i][1] = (int_16)((pu8Src[2] << 8) | pu8Src[3]);
+    pai16Data[i][2] = (int_16)((pu8Src[4] << 8) | pu8Src[5]);
+  }
+  *pu32Cnt = u32Cnt;
+  return ESL_I2C_OK;
+}
+
+//******************************************************************************
+
+uint_32 mma845x_periodUs (const ESL_I2C_MMA845XQ_TConfig * poConfig)
+{
+  static const uint_32 au32Period[8] = {                                        // 800, 400, 200, 100, 50, 12.5, 6.25, 1.56 Hz
+    1250, 2500, 5000, 10000, 20000, 80000, 160000, 640000
+  };
+
+  return au32Period[(poConfig->u8CtrlReg1 & ESL_I2C_MMA845XQ_CTRL_REG1_DR_MASK)
+                    >> ESL_I2C_MMA845XQ_CTRL_REG1_DR_SHIFT];
+}
+
+//******************************************************************************
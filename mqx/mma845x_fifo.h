@@ -0,0 +1,110 @@
+/** ****************************************************************************
+ *
+ *  @file       mma845x_fifo.h
+ *  @brief      MMA8451Q FIFO access on top of the ESL MMA845xQ driver.
+ *
+ *  The ESL driver reads one sample at a time and does not know the 32 sample
+ *  FIFO of the MMA8451Q (the MMA8452Q and MMA8453Q have none). These
+ *  functions set the FIFO up through the general I2C device of an opened
+ *  ESL_I2C_MMA845XQ_TDevice and drain it by one burst read: with the FIFO
+ *  enabled, the register address wraps from OUT_Z_LSB back to OUT_X_MSB and
+ *  each wrap pops the next sample.
+ *
+ *  @copyright  Elnico Ltd. All rights reserved.
+ *
+ ******************************************************************************/
+/*
+ *  THIS SOFTWARE IS PROVIDED BY ELNICO "AS IS" AND ANY EXPRESSED OR
+ *  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ *  OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ *  IN NO EVENT SHALL ELNICO OR ITS CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ *  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ *  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ *  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ *  IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ *  THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************/
+
+#ifndef MMA845X_FIFO_H_402795710395827105729385
+#define MMA845X_FIFO_H_402795710395827105729385
+//******************************************************************************
+#include <mqx.h>
+#include <bsp.h>
+#if (MQX_VERSION >= 410)
+# include "psptypes_legacy.h"
+#endif
+
+#include "esl_i2c_MMA845xQ.h"
+
+//******************************************************************************
+// Registers missing in esl_i2c_MMA845xQ.h
+//******************************************************************************
+
+#define MMA845X_FIFO_SIZE               (32)                                    //!< Number of samples the MMA8451Q FIFO holds.
+#define MMA845X_SAMPLE_BYTES            (6)                                     //!< OUT_X_MSB to OUT_Z_LSB.
+
+#define MMA845X_F_SETUP                 (0x09)                                  //!< RW FIFO setup (MMA8451Q only).
+#define MMA845X_TRIG_CFG                (0x0A)                                  //!< RW FIFO trigger configuration (MMA8451Q only).
+
+#define MMA845X_F_STATUS_F_OVF_MASK     (0x80)                                  //!< FIFO overflow: 1: more samples came than the FIFO holds.
+#define MMA845X_F_STATUS_F_WMRK_MASK    (0x40)                                  //!< Watermark reached: 1: F_CNT >= F_WMRK.
+#define MMA845X_F_STATUS_F_CNT_MASK     (0x3F)                                  //!< Number of samples in the FIFO.
+
+#define MMA845X_F_SETUP_F_MODE_SHIFT    (6)                                     //!< FIFO mode shift.
+#define MMA845X_F_SETUP_F_MODE_MASK     (0x03 << MMA845X_F_SETUP_F_MODE_SHIFT)  //!< FIFO mode mask.
+#define MMA845X_F_SETUP_F_MODE_OFF      (0x00 << MMA845X_F_SETUP_F_MODE_SHIFT)  //!< FIFO disabled, STATUS and OUT_* hold the current sample.
+#define MMA845X_F_SETUP_F_MODE_CIRCULAR (0x01 << MMA845X_F_SETUP_F_MODE_SHIFT)  //!< The newest sample replaces the oldest one when full.
+#define MMA845X_F_SETUP_F_MODE_FILL     (0x02 << MMA845X_F_SETUP_F_MODE_SHIFT)  //!< Stops accepting new samples when full.
+#define MMA845X_F_SETUP_F_MODE_TRIGGER  (0x03 << MMA845X_F_SETUP_F_MODE_SHIFT)  //!< Circular until a TRIG_CFG event, then fill.
+#define MMA845X_F_SETUP_F_WMRK_MASK     (0x3F)                                  //!< Watermark (samples), 0 disables the watermark flag.
+
+#define MMA845X_INT_SOURCE_FIFO_MASK    (0x40)                                  //!< FIFO interrupt (watermark or overflow) pending.
+#define MMA845X_INT_SOURCE_DRDY_MASK    (0x01)                                  //!< Data ready interrupt pending.
+
+//******************************************************************************
+// Public functions
+//******************************************************************************
+
+/** Enables or disables the FIFO. Changing the mode from or to
+ *  MMA845X_F_SETUP_F_MODE_OFF takes the STANDBY mode.
+ * @param[in]   hAccelDevice  Opened accelerometer device handle.
+ * @param[in]   u8Mode        MMA845X_F_SETUP_F_MODE_* value.
+ * @param[in]   u8Watermark   Watermark in samples (1 to MMA845X_FIFO_SIZE),
+ *                            0 to disable the watermark flag.
+ * @return      ESL_I2C_OK on success.
+ *              ESL_I2C_INVALID_ARGUMENT if invalid handle or watermark given.
+ *              Any I2C bus communication error. */
+uint_8 mma845x_fifoSetup (ESL_I2C_MMA845XQ_TDevice * hAccelDevice,
+                          uint_8                     u8Mode,
+                          uint_8                     u8Watermark);
+
+/** Reads all the samples in the FIFO, the oldest first: F_STATUS by one
+ *  transfer, then the samples counted by one burst transfer.
+ * @param[out]  pai16Data     Array of u32MaxCnt X, Y, Z samples, the values
+ *                            are left-justified as esl_i2c_MMA845xQ_getRawData()
+ *                            retrieves them.
+ * @param[in]   u32MaxCnt     Size of pai16Data, the rest stays in the FIFO.
+ * @param[out]  pu32Cnt       Number of samples stored to pai16Data.
+ * @param[out]  pbOverflow    Set TRUE if samples were lost because the FIFO
+ *                            was full.
+ * @param[in]   hAccelDevice  Opened accelerometer device handle with the
+ *                            FIFO enabled and F_READ cleared.
+ * @return      ESL_I2C_OK on success (also if the FIFO was empty).
+ *              ESL_I2C_INVALID_ARGUMENT if NULL or invalid handle given.
+ *              Any I2C bus communication error. */
+uint_8 mma845x_fifoRead (int_16                  (* pai16Data)[3],
+                         uint32_t                   u32MaxCnt,
+                         uint32_t                 * pu32Cnt,
+                         boolean                  * pbOverflow,
+                         ESL_I2C_MMA845XQ_TDevice * hAccelDevice);
+
+/** Computes the output data period from the CTRL_REG1 data rate.
+ * @param[in]   poConfig      Accelerometer configuration.
+ * @return      Period in microseconds. */
+uint_32 mma845x_periodUs (const ESL_I2C_MMA845XQ_TConfig * poConfig);
+
+//******************************************************************************
+#endif // MMA845X_FIFO_H_402795710395827105729385 //
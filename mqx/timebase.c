@@ -0,0 +1,46 @@
+/** ****************************************************************************
+ *
+ *  @file       timebase.c
+ *  @brief      M4 microsecond time base.
+ *
+ *  @copyright  Elnico Ltd. All rights reserved.
+ *
+ ******************************************************************************/
+/*
+ *  THIS SOFTWARE IS PROVIDED BY ELNICO "AS IS" AND ANY EXPRESSED OR
+ *  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ *  OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ *  IN NO EVENT SHALL ELNICO OR ITS CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ *  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ *  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ *  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ *  IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ *  THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************/
+
+#include "timebase.h"
+
+//******************************************************************************
+//******************************************************************************
+//******************************************************************************
+
+uint32_t timebase_getUs (TTimebase * poTimebase)
+{
+  MQX_TICK_STRUCT   oNow;
+  boolean           bOverflow;
+  int_32            i32Diff;
+
+  _time_get_elapsed_ticks(&oNow);
+  i32Diff = _time_diff_microseconds(&oNow, &poTimebase->oEpoch, &bOverflow);
+  while (bOverflow || (i32Diff >= 1000000000)) {                                // move the epoch before the difference overflows
+    _time_add_msec_to_ticks(&poTimebase->oEpoch, 1000000);
+    poTimebase->u32Base += 1000000000;
+    i32Diff = _time_diff_microseconds(&oNow, &poTimebase->oEpoch, &bOverflow);
+  }
+  return poTimebase->u32Base + (uint32_t)i32Diff;
+}
+
+//******************************************************************************
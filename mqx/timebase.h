@@ -0,0 +1,61 @@
+/** ****************************************************************************
+ *
+ *  @file       timebase.h
+ *  @brief      M4 microsecond time base.
+ *
+ *  Free running microsecond time shared by the M4 tasks: sample capture
+ *  times and the MCC clock synchronization (MCCMSG_PING) use the same one.
+ *
+ *  @copyright  Elnico Ltd. All rights reserved.
+ *
+ ******************************************************************************/
+/*
+ *  THIS SOFTWARE IS PROVIDED BY ELNICO "AS IS" AND ANY EXPRESSED OR
+ *  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ *  OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ *  IN NO EVENT SHALL ELNICO OR ITS CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ *  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ *  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ *  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ *  IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ *  THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************/
+
+#ifndef TIMEBASE_H_620357230572305723057230
+#define TIMEBASE_H_620357230572305723057230
+//******************************************************************************
+#include <mqx.h>
+#include <bsp.h>
+#if (MQX_VERSION >= 410)
+# include "psptypes_legacy.h"
+#endif
+
+#include <stdint.h>
+
+//******************************************************************************
+// Public types
+//******************************************************************************
+
+/** State of the time base kept by each task using it (no locking needed).
+ *  All the states start at the MQX boot, so they all give the same time;
+ *  zero-initialize before the first use. */
+typedef struct t_timebase_struct {
+  MQX_TICK_STRUCT   oEpoch;                                                     //!< Time when timebase_getUs() returned u32Base.
+  uint32_t          u32Base;                                                    //!< See oEpoch.
+} TTimebase;
+
+//******************************************************************************
+// Public functions
+//******************************************************************************
+
+/** Returns the microseconds elapsed since the MQX boot (wraps every ~71
+ *  minutes, only differences are meaningful).
+ * @param[in,out] poTimebase  Time base state of the calling task.
+ * @return    Time in microseconds. */
+uint32_t timebase_getUs (TTimebase * poTimebase);
+
+//******************************************************************************
+#endif // TIMEBASE_H_620357230572305723057230 //
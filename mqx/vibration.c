@@ -0,0 +1,363 @@
+/** ****************************************************************************
+ *
+ *  @file       vibration.c
+ *  @brief      Vibration features of the accelerometer samples.
+ *
+ *  @copyright  Elnico Ltd. All rights reserved.
+ *
+ ******************************************************************************/
+/*
+ *  THIS SOFTWARE IS PROVIDED BY ELNICO "AS IS" AND ANY EXPRESSED OR
+ *  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ *  OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ *  IN NO EVENT SHALL ELNICO OR ITS CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ *  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ *  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ *  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ *  IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ *  THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************/
+
+#include "vibration.h"
+
+#include "esl_utils.h"
+
+#include <math.h>
+#include <string.h>
+
+// the same barrier as the seqlock of the snapshot shared with the A5
+#define VIBRATION_BARRIER()             MCC_SNAPSHOT_BARRIER()
+
+#define VIBRATION_PI                    (3.14159265358979323846)
+#define VIBRATION_HANN_POWER            (3.0f / 8.0f)                           //!< Mean square of the Hann window.
+
+//******************************************************************************
+// Functions declarations
+//******************************************************************************
+
+/** Transforms poVibration->aai32Fft in place (radix-2 decimation in time, the
+ *  input in bit-reversed order), each stage halving the values.
+ * @param[in,out] poVibration State, the input loaded.
+ * @param[in]   u32Length     Transform length, a power of 2. */
+static void vibration_fft (TVibration * poVibration, uint32_t u32Length);
+
+/** Reverses the bits of an index.
+ * @param[in]   u32Idx        Index.
+ * @param[in]   u32Bits       Number of bits of the index.
+ * @return      Reversed index. */
+static uint32_t vibration_reverse (uint32_t u32Idx, uint32_t u32Bits);
+
+/** Quantizes a value within [-1, 1].
+ * @param[in]   dValue        Value.
+ * @return      Q15 value, 1 saturated. */
+static int16_t vibration_q15 (double dValue);
+
+//******************************************************************************
+//******************************************************************************
+//******************************************************************************
+
+void vibration_init (TVibration * poVibration)
+{
+  uint32_t i;
+
+  memset(poVibration, 0, sizeof(*poVibration));
+  for (i = 0; i < MCC_ACCEL_FEATURES_MAX_LENGTH / 2; ++i) {
+    poVibration->ai16Cos[i] = vibration_q15(cos(2.0 * VIBRATION_PI * i / MCC_ACCEL_FEATURES_MAX_LENGTH));
+    poVibration->ai16Sin[i] = vibration_q15(sin(2.0 * VIBRATION_PI * i / MCC_ACCEL_FEATURES_MAX_LENGTH));
+  }
+}
+
+//******************************************************************************
+
+boolean vibration_check (const TMccAccelFeatures * poSettings)
+{
+  uint32_t u32Length = poSettings->u16Length;
+
+  if (poSettings->u8Reserved) return FALSE;
+  if (!u32Length) return TRUE;                                                  // none
+  if (   (u32Length < MCC_ACCEL_FEATURES_MIN_LENGTH)
+      || (u32Length > MCC_ACCEL_FEATURES_MAX_LENGTH)
+      || (u32Length & (u32Length - 1))) {
+    return FALSE;
+  }
+  return (poSettings->u8Bands && (poSettings->u8Bands <= MCC_ACCEL_FEATURES_MAX_BANDS)) ? TRUE : FALSE;
+}
+
+//******************************************************************************
+
+boolean vibration_setup (TVibration               * poVibration,
+                         const TMccAccelFeatures  * poSettings)
+{
+  if (!poVibration || !poSettings || !vibration_check(poSettings)) return FALSE;
+
+  poVibration->oSettings = *poSettings;
+  poVibration->u32Fill   = 0;
+  return TRUE;
+}
+
+//******************************************************************************
+
+void vibration_restart (TVibration * poVibration)
+{
+  poVibration->u32Fill = 0;
+}
+
+//******************************************************************************
+
+boolean vibration_isActive (const TVibration * poVibration)
+{
+  return poVibration->oSettings.u16Length ? TRUE : FALSE;
+}
+
+//******************************************************************************
+
+uint32_t vibration_add (TVibration        * poVibration,
+                        const TAccelData  * paoSrc,
+                        uint32_t            u32Cnt)
+{
+  uint32_t u32Taken = MIN(u32Cnt, poVibration->oSettings.u16Length - poVibration->u32Fill);
+  uint32_t i;
+
+  if (u32Taken && !poVibration->u32Fill) {
+    poVibration->u32First   = paoSrc[0].u32Timestamp;
+    poVibration->u32FirstUs = paoSrc[0].u32TimeUs;
+  }
+  for (i = 0; i < u32Taken; ++i) {
+    int16_t * pi16Dst = poVibration->aai16Window[poVibration->u32Fill + i];
+
+    pi16Dst[0] = paoSrc[i].ai16Raw[0];
+    pi16Dst[1] = paoSrc[i].ai16Raw[1];
+    pi16Dst[2] = paoSrc[i].ai16Raw[2];
+  }
+  poVibration->u32Fill += u32Taken;
+  return u32Taken;
+}
+
+//******************************************************************************
+
+boolean vibration_isFull (const TVibration * poVibration)
+{
+  return (poVibration->oSettings.u16Length && (poVibration->u32Fill >= poVibration->oSettings.u16Length))
+         ? TRUE : FALSE;
+}
+
+//******************************************************************************
+
+void vibration_compute (TVibration            * poVibration,
+                        const TMccAccelScale  * poScale,
+                        uint32_t                u32PeriodUs,
+                        TMccAccelSummaryMsg   * poDst)
+{
+  uint32_t  u32Length = poVibration->oSettings.u16Length;
+  uint32_t  u32Half   = u32Length / 2;
+  uint32_t  u32Bands  = poVibration->oSettings.u8Bands;
+  uint32_t  u32Stride = MCC_ACCEL_FEATURES_MAX_LENGTH / u32Length;
+  uint32_t  u32Bits   = 0;
+  float     fGPerCount = 1.0f / poScale->u16CountsPerG;
+  uint32_t  i, k;
+  int       iAxis;
+
+  while (((uint32_t)1 << u32Bits) < u32Length) ++u32Bits;
+
+  poDst->u32First    = poVibration->u32First;
+  poDst->u32TimeUs   = poVibration->u32FirstUs;
+  poDst->u32PeriodUs = u32PeriodUs;
+  poDst->oFeatures   = poVibration->oSettings;
+  for (iAxis = 0; iAxis < 3; ++iAxis) {
+    TMccAccelAxisFeatures * poAxis = &poDst->aoAxes[iAxis];
+    uint64_t  au64Bands[MCC_ACCEL_FEATURES_MAX_BANDS];
+    uint64_t  u64SumSq = 0;
+    int32_t   i32Sum   = 0;
+    int32_t   i32Min   = INT16_MAX;
+    int32_t   i32Max   = INT16_MIN;
+    int32_t   i32Mean;
+    uint32_t  u32Peak  = 0;
+    float     fRms;
+
+    // Time domain: mean, RMS less the mean, peaks
+    for (i = 0; i < u32Length; ++i) {
+      int32_t i32X = poVibration->aai16Window[i][iAxis];
+
+      i32Sum += i32X;
+      i32Min  = MIN(i32Min, i32X);
+      i32Max  = MAX(i32Max, i32X);
+    }
+    i32Mean = (i32Sum >= 0) ? (i32Sum + (int32_t)u32Half) >> u32Bits
+                            : -((-i32Sum + (int32_t)u32Half) >> u32Bits);
+    for (i = 0; i < u32Length; ++i) {
+      int32_t   i32V = poVibration->aai16Window[i][iAxis] - i32Mean;            // 17 bits
+      uint32_t  u32Abs = (uint32_t)((i32V >= 0) ? i32V : -i32V);
+      int32_t   i32Cos;
+      int32_t   i32Hann;
+      uint32_t  u32Dst;
+
+      u64SumSq += (uint64_t)u32Abs * u32Abs;
+      u32Peak   = MAX(u32Peak, u32Abs);
+
+      // periodic Hann window, cos(2 pi i / N) = -cos(2 pi (i - N/2) / N)
+      i32Cos  = (i < u32Half) ? poVibration->ai16Cos[i * u32Stride]
+                              : -poVibration->ai16Cos[(i - u32Half) * u32Stride];
+      i32Hann = ((1 << VIBRATION_TWIDDLE_SHIFT) - i32Cos) >> 1;
+      u32Dst  = vibration_reverse(i, u32Bits);
+      poVibration->aai32Fft[u32Dst][0] = (int32_t)(((int64_t)i32V * i32Hann)
+                                                  >> (VIBRATION_TWIDDLE_SHIFT - VIBRATION_SHIFT));
+      poVibration->aai32Fft[u32Dst][1] = 0;
+    }
+    fRms = sqrtf((float)u64SumSq / u32Length);
+
+    poAxis->fMean       = (float)i32Sum / u32Length * fGPerCount;
+    poAxis->fRms        = fRms * fGPerCount;
+    poAxis->fPeakToPeak = (float)(i32Max - i32Min) * fGPerCount;
+    poAxis->fCrest      = (fRms > 0.0f) ? u32Peak / fRms : 0.0f;
+
+    // Frequency domain: the bins 1 to N/2 split into the bands, each bin but
+    // the Nyquist one stands for its mirror too
+    vibration_fft(poVibration, u32Length);
+    memset(au64Bands, 0, sizeof(au64Bands));
+    for (k = 1; k <= u32Half; ++k) {
+      int64_t   i64Re = poVibration->aai32Fft[k][0];
+      int64_t   i64Im = poVibration->aai32Fft[k][1];
+      uint64_t  u64Power = (uint64_t)(i64Re * i64Re) + (uint64_t)(i64Im * i64Im);
+
+      au64Bands[((k - 1) * u32Bands) / u32Half] += (k < u32Half) ? 2 * u64Power : u64Power;
+    }
+    for (k = 0; k < MCC_ACCEL_FEATURES_MAX_BANDS; ++k) {                        // the stages divided by N already, |X / N|^2 is left
+      poAxis->afBands[k] = (k < u32Bands)
+                           ? (float)au64Bands[k] / ((float)((uint32_t)1 << (2 * VIBRATION_SHIFT)) * VIBRATION_HANN_POWER)
+                             * fGPerCount * fGPerCount
+                           : 0.0f;
+    }
+  }
+  poVibration->u32Fill = 0;
+}
+
+//******************************************************************************
+
+void vibration_initQueue (TVibrationQueue * poQueue)
+{
+  uint32_t i;
+
+  for (i = 0; i < VIBRATION_QUEUE_SIZE; ++i) {                                  // no window number 0
+    poQueue->aoSlots[i].u32Seq = 0;
+  }
+  poQueue->u32Newest = 0;
+  VIBRATION_BARRIER();
+}
+
+//******************************************************************************
+
+void vibration_publish (TVibrationQueue            * poQueue,
+                        const TMccAccelSummaryMsg  * poSummary)
+{
+  uint32_t         u32Window = poQueue->u32Newest + 1;
+  TVibrationSlot * poSlot = &poQueue->aoSlots[VIBRATION_QUEUE_IDX(u32Window)];
+
+  poSlot->u32Seq = u32Window - 1;                                               // readers of the old summary fail from now on
+  VIBRATION_BARRIER();
+  poSlot->oSummary = *poSummary;
+  poSlot->oSummary.u32Window = u32Window;
+  VIBRATION_BARRIER();
+  poSlot->u32Seq = u32Window;
+  VIBRATION_BARRIER();
+  poQueue->u32Newest = u32Window;
+}
+
+//******************************************************************************
+
+boolean vibration_get (const TVibrationQueue  * poQueue,
+                       uint32_t                 u32Since,
+                       TMccAccelSummaryMsg    * poDst)
+{
+  uint32_t  u32Newest = poQueue->u32Newest;
+  uint32_t  u32Avail  = MIN(u32Newest, VIBRATION_QUEUE_SIZE);
+  uint32_t  u32Lost   = 0;
+  uint32_t  u32Window;
+
+  VIBRATION_BARRIER();                                                          // the slots are read after the number
+  if ((int32_t)(u32Newest - u32Since) < 0) {                                    // reader ahead of us -> M4 restarted, take everything
+    u32Since = u32Newest - u32Avail;
+  } else if (u32Newest - u32Since > u32Avail) {                                 // some summaries already overwritten
+    u32Lost  = u32Newest - u32Since - u32Avail;
+    u32Since = u32Newest - u32Avail;
+  }
+
+  for (u32Window = u32Since + 1; (int32_t)(u32Newest - u32Window) >= 0; ++u32Window, ++u32Lost) {
+    const TVibrationSlot * poSlot = &poQueue->aoSlots[VIBRATION_QUEUE_IDX(u32Window)];
+
+    if (poSlot->u32Seq == u32Window) {
+      VIBRATION_BARRIER();
+      *poDst = poSlot->oSummary;
+      VIBRATION_BARRIER();
+      if (poSlot->u32Seq == u32Window) {                                        // not overwritten while copying
+        poDst->u32Lost = u32Lost;
+        return TRUE;
+      }
+    }
+    u32Newest = poQueue->u32Newest;                                             // overwritten, the writer went on
+    VIBRATION_BARRIER();
+  }
+  return FALSE;
+}
+
+//******************************************************************************
+// Private functions
+//******************************************************************************
+
+static void vibration_fft (TVibration * poVibration, uint32_t u32Length)
+{
+  int32_t  (* pai32X)[2] = poVibration->aai32Fft;
+  uint32_t    u32Span;
+  uint32_t    i, j;
+
+  for (u32Span = 1; u32Span < u32Length; u32Span <<= 1) {                       // butterflies of 2 * u32Span points
+    uint32_t u32Step = MCC_ACCEL_FEATURES_MAX_LENGTH / (2 * u32Span);
+
+    for (j = 0; j < u32Span; ++j) {
+      int32_t i32Wr = poVibration->ai16Cos[j * u32Step];                        // W = exp(-2 pi i j / (2 * u32Span))
+      int32_t i32Wi = poVibration->ai16Sin[j * u32Step];
+
+      for (i = j; i < u32Length; i += 2 * u32Span) {
+        int32_t * pi32A = pai32X[i];
+        int32_t * pi32B = pai32X[i + u32Span];
+        int32_t   i32Tr, i32Ti;
+
+        i32Tr = (int32_t)(((int64_t)pi32B[0] * i32Wr + (int64_t)pi32B[1] * i32Wi
+                           + (1 << (VIBRATION_TWIDDLE_SHIFT - 1))) >> VIBRATION_TWIDDLE_SHIFT);
+        i32Ti = (int32_t)(((int64_t)pi32B[1] * i32Wr - (int64_t)pi32B[0] * i32Wi
+                           + (1 << (VIBRATION_TWIDDLE_SHIFT - 1))) >> VIBRATION_TWIDDLE_SHIFT);
+        pi32B[0] = (pi32A[0] - i32Tr) >> 1;                                     // |A| and |B| never grow
+        pi32B[1] = (pi32A[1] - i32Ti) >> 1;
+        pi32A[0] = (pi32A[0] + i32Tr) >> 1;
+        pi32A[1] = (pi32A[1] + i32Ti) >> 1;
+      }
+    }
+  }
+}
+
+//******************************************************************************
+
+static uint32_t vibration_reverse (uint32_t u32Idx, uint32_t u32Bits)
+{
+  uint32_t u32Rev = 0;
+  uint32_t i;
+
+  for (i = 0; i < u32Bits; ++i) {
+    u32Rev = (u32Rev << 1) | (u32Idx & 1);
+    u32Idx >>= 1;
+  }
+  return u32Rev;
+}
+
+//******************************************************************************
+
+static int16_t vibration_q15 (double dValue)
+{
+  double dQ = floor(dValue * (1 << VIBRATION_TWIDDLE_SHIFT) + 0.5);
+
+  return (int16_t)MIN(MAX(dQ, -32767.0), 32767.0);
+}
+
+//******************************************************************************
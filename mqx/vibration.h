@@ -0,0 +1,172 @@
+/** ****************************************************************************
+ *
+ *  @file       vibration.h
+ *  @brief      Vibration features of the accelerometer samples.
+ *
+ *  Collects the raw counts of the three axes into windows of a
+ *  TMccAccelFeatures and summarizes each full window: mean, RMS less the
+ *  mean, peak-to-peak and crest factor from the counts, and the band mean
+ *  squares from a radix-2 FFT of the Hann windowed counts less the mean.
+ *  The FFT runs in place on 32-bit fixed-point values (the counts scaled by
+ *  2^VIBRATION_SHIFT, Q15 twiddle factors) halved at every stage, so that it
+ *  never overflows; its result is exact to a fraction of a count. Only the
+ *  results are converted to g.
+ *
+ *  The summaries are published in a small lock-free queue written by a
+ *  single task (accel_task) and read by any other task, the same way as the
+ *  sample history (see history.h): each slot carries the number of the
+ *  window it holds, a summary overwritten while being read is reported as
+ *  lost.
+ *
+ *  @copyright  Elnico Ltd. All rights reserved.
+ *
+ ******************************************************************************/
+/*
+ *  THIS SOFTWARE IS PROVIDED BY ELNICO "AS IS" AND ANY EXPRESSED OR
+ *  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ *  OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ *  IN NO EVENT SHALL ELNICO OR ITS CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ *  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ *  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ *  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ *  IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ *  THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************/
+
+#ifndef VIBRATION_H_503827105739201857302175
+#define VIBRATION_H_503827105739201857302175
+//******************************************************************************
+#include <mqx.h>
+#include <bsp.h>
+#if (MQX_VERSION >= 410)
+# include "psptypes_legacy.h"
+#endif
+
+#include "accelerometer.h"
+
+//******************************************************************************
+// Settings
+//******************************************************************************
+
+#define VIBRATION_SHIFT                 (13)                                    //!< Fraction bits of the FFT input below the counts (the distance from the mean takes 17 bits).
+#define VIBRATION_TWIDDLE_SHIFT         (15)                                    //!< Fraction bits of the twiddle factors and of the Hann window.
+
+/** @def VIBRATION_QUEUE_SIZE
+ * @brief Number of summaries kept for the readers. Must be a power of 2. */
+#ifndef VIBRATION_QUEUE_SIZE
+# define VIBRATION_QUEUE_SIZE           (4)
+#endif
+
+#define VIBRATION_QUEUE_IDX(w)          ((w) & (VIBRATION_QUEUE_SIZE - 1))      //!< Slot of the summary of given window number.
+
+//******************************************************************************
+// Public types
+//******************************************************************************
+
+/** Window collection and FFT state, initialize by vibration_init(). */
+typedef struct t_vibration_struct {
+  TMccAccelFeatures oSettings;                                                  //!< Features in effect, u16Length 0 for none.
+  uint32_t          u32Fill;                                                    //!< Samples collected in aai16Window.
+  uint32_t          u32First;                                                   //!< Timestamp of the first sample of the window.
+  uint32_t          u32FirstUs;                                                 //!< Time of the first sample of the window.
+  int16_t           aai16Window[MCC_ACCEL_FEATURES_MAX_LENGTH][3];              //!< X, Y, Z counts of the window.
+  int32_t           aai32Fft[MCC_ACCEL_FEATURES_MAX_LENGTH][2];                 //!< Real and imaginary parts of one axis being transformed.
+  int16_t           ai16Cos[MCC_ACCEL_FEATURES_MAX_LENGTH / 2];                 //!< cos(2 pi k / MCC_ACCEL_FEATURES_MAX_LENGTH) (Q15).
+  int16_t           ai16Sin[MCC_ACCEL_FEATURES_MAX_LENGTH / 2];                 //!< sin(2 pi k / MCC_ACCEL_FEATURES_MAX_LENGTH) (Q15).
+} TVibration;
+
+/** One summary of the queue. */
+typedef struct t_vibration_slot_struct {
+  volatile uint32_t u32Seq;                                                     //!< Window number of oSummary, the number less 1 while oSummary is being written.
+  TMccAccelSummaryMsg oSummary;                                                 //!< The summary, type not set.
+} TVibrationSlot;
+
+/** Summary queue, initialize by vibration_initQueue(). */
+typedef struct t_vibration_queue_struct {
+  volatile uint32_t u32Newest;                                                  //!< Window number of the newest summary published, 0 if none.
+  TVibrationSlot    aoSlots[VIBRATION_QUEUE_SIZE];                              //!< Summaries, indexed by VIBRATION_QUEUE_IDX(u32Window).
+} TVibrationQueue;
+
+//******************************************************************************
+// Public functions
+//******************************************************************************
+
+/** Computes the twiddle factors, no features set.
+ * @param[out]  poVibration   State to initialize. */
+void vibration_init (TVibration * poVibration);
+
+/** Checks the features settings.
+ * @param[in]   poSettings    Settings (see TMccAccelFeatures).
+ * @return      TRUE if they are in range (none included). */
+boolean vibration_check (const TMccAccelFeatures * poSettings);
+
+/** Sets the features up and restarts the window. Settings out of range leave
+ *  the state unchanged.
+ * @param[in,out] poVibration State.
+ * @param[in]   poSettings    Settings (see TMccAccelFeatures).
+ * @return      TRUE on success, FALSE if a setting is out of range. */
+boolean vibration_setup (TVibration               * poVibration,
+                         const TMccAccelFeatures  * poSettings);
+
+/** Drops the samples collected, the next one starts a window.
+ * @param[in,out] poVibration State. */
+void vibration_restart (TVibration * poVibration);
+
+/** Checks whether features are set.
+ * @param[in]   poVibration   State.
+ * @return      TRUE if the samples are to be collected. */
+boolean vibration_isActive (const TVibration * poVibration);
+
+/** Collects consecutive samples up to the end of the window.
+ * @param[in,out] poVibration State, features set.
+ * @param[in]   paoSrc        Samples, the oldest first.
+ * @param[in]   u32Cnt        Number of samples in paoSrc.
+ * @return      Number of samples taken, fewer than u32Cnt once the window is
+ *              full (vibration_compute() starts the next one). */
+uint32_t vibration_add (TVibration        * poVibration,
+                        const TAccelData  * paoSrc,
+                        uint32_t            u32Cnt);
+
+/** Checks whether the window is full.
+ * @param[in]   poVibration   State.
+ * @return      TRUE if vibration_compute() is due. */
+boolean vibration_isFull (const TVibration * poVibration);
+
+/** Summarizes the full window and starts the next one.
+ * @param[in,out] poVibration State, window full.
+ * @param[in]   poScale       Conversion of the counts of the window to g.
+ * @param[in]   u32PeriodUs   Output data period of the samples.
+ * @param[out]  poDst         Summary to fill in all the fields but type,
+ *                            u32Window and u32Lost of. */
+void vibration_compute (TVibration            * poVibration,
+                        const TMccAccelScale  * poScale,
+                        uint32_t                u32PeriodUs,
+                        TMccAccelSummaryMsg   * poDst);
+
+/** Empties the queue. Must be called before any reader uses it.
+ * @param[out]  poQueue       Queue to initialize. */
+void vibration_initQueue (TVibrationQueue * poQueue);
+
+/** Publishes a summary as the next window (the only writer).
+ * @param[in,out] poQueue     Queue.
+ * @param[in]   poSummary     Summary, its u32Window is set here. */
+void vibration_publish (TVibrationQueue            * poQueue,
+                        const TMccAccelSummaryMsg  * poSummary);
+
+/** Copies the oldest summary newer than given window number.
+ * @param[in]   poQueue       Queue.
+ * @param[in]   u32Since      Window number of the last summary known to the
+ *                            reader, 0 for the oldest one kept.
+ * @param[out]  poDst         Destination of the summary, its u32Lost set to
+ *                            the summaries newer than u32Since already
+ *                            overwritten (type not set).
+ * @return      TRUE if a summary was copied, FALSE if there is none newer. */
+boolean vibration_get (const TVibrationQueue  * poQueue,
+                       uint32_t                 u32Since,
+                       TMccAccelSummaryMsg    * poDst);
+
+//******************************************************************************
+#endif // VIBRATION_H_503827105739201857302175 //
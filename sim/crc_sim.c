@@ -0,0 +1,131 @@
+/** ****************************************************************************
+ *
+ *  @file       crc_sim.c
+ *  @brief      CRC module for the host M4 simulator.
+ *
+ *  Implements the esl_crc interface in software, computing what the Vybrid
+ *  CRC engine does: MSB first, no transposition, optional final complement.
+ *  A 16-bit CRC runs as a 32-bit one in the upper half of the register.
+ *
+ *  @copyright  Elnico Ltd. All rights reserved.
+ *
+ ******************************************************************************/
+/*
+ *  THIS SOFTWARE IS PROVIDED BY ELNICO "AS IS" AND ANY EXPRESSED OR
+ *  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ *  OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ *  IN NO EVENT SHALL ELNICO OR ITS CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ *  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ *  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ *  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ *  IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ *  THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************/
+
+#include "esl_crc.h"
+
+//******************************************************************************
+// Globals
+//******************************************************************************
+
+static boolean          g_bInit;                                                //!< TRUE between esl_crc_init() and esl_crc_deinit().
+static uint_32          g_u32Ctrl;                                              //!< Control register flags of the session.
+static uint_32          g_u32Crc;                                               //!< CRC register (a 16-bit CRC in the upper half).
+static uint_32          g_u32TablePoly;                                         //!< Polynomial g_au32Table is computed for (0 if none).
+static uint_32          g_au32Table[256];                                       //!< CRC of each byte value for g_u32TablePoly.
+
+//******************************************************************************
+//******************************************************************************
+//******************************************************************************
+
+uint_8 esl_crc_init (uint_32 u32ctrl, uint_32 u32polynomial, uint_32 u32seed)
+{
+  if (g_bInit) return ESL_CRC_ALREADY_INITIALIZED;
+  return esl_crc_reinit(u32ctrl, u32polynomial, u32seed);
+}
+
+//******************************************************************************
+
+uint_8 esl_crc_reinit (uint_32 u32ctrl, uint_32 u32polynomial, uint_32 u32seed)
+{
+  boolean bWide = (u32ctrl & ESL_CRC_WIDTH_32_BIT) ? TRUE : FALSE;
+  uint_32 u32Poly = bWide ? u32polynomial : (u32polynomial << 16);
+  uint_32 u32Crc;
+  int     i;
+  int     b;
+
+  if (u32Poly != g_u32TablePoly) {
+    for (i = 0; i < 256; ++i) {
+      u32Crc = (uint_32)i << 24;
+      for (b = 0; b < 8; ++b) {
+        u32Crc = (u32Crc & 0x80000000) ? ((u32Crc << 1) ^ u32Poly) : (u32Crc << 1);
+      }
+      g_au32Table[i] = u32Crc;
+    }
+    g_u32TablePoly = u32Poly;
+  }
+
+  g_u32Ctrl = u32ctrl;
+  g_u32Crc  = bWide ? u32seed : (u32seed << 16);
+  g_bInit   = TRUE;
+  return ESL_CRC_OK;
+}
+
+//******************************************************************************
+
+uint_8 esl_crc_deinit (void)
+{
+  if (!g_bInit) return ESL_CRC_NOT_INITIALIZED;
+  g_bInit = FALSE;
+  return ESL_CRC_OK;
+}
+
+//******************************************************************************
+
+uint_32 esl_crc_read (void)
+{
+  uint_32 u32Crc;
+
+  if (!g_bInit) return ESL_CRC_INVALID_VALUE;
+  u32Crc = (g_u32Ctrl & ESL_CRC_FXOR) ? ~g_u32Crc : g_u32Crc;
+  return (g_u32Ctrl & ESL_CRC_WIDTH_32_BIT) ? u32Crc : (u32Crc >> 16);
+}
+
+//******************************************************************************
+
+void esl_crc_write (uint_8 byte)
+{
+  g_u32Crc = (g_u32Crc << 8) ^ g_au32Table[(g_u32Crc >> 24) ^ byte];
+}
+
+//******************************************************************************
+
+void esl_crc_write32 (uint_32 data)
+{
+  esl_crc_write((uint_8)(data >> 24));
+  esl_crc_write((uint_8)(data >> 16));
+  esl_crc_write((uint_8)(data >> 8));
+  esl_crc_write((uint_8)data);
+}
+
+//******************************************************************************
+
+uint_8 esl_crc_calcForBuf (uint_32         u32Ctrl,
+                           uint_32         u32Polynomial,
+                           uint_32         u32Seed,
+                           const uint_8  * pu8Buf,
+                           uint_32         u32BufLen,
+                           uint_32       * pu32Result)
+{
+  uint_32 i;
+
+  esl_crc_reinit(u32Ctrl, u32Polynomial, u32Seed);
+  for (i = 0; i < u32BufLen; ++i) esl_crc_write(pu8Buf[i]);
+  *pu32Result = esl_crc_read();
+  return ESL_CRC_OK;
+}
+
+//******************************************************************************
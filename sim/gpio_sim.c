@@ -0,0 +1,53 @@
+/** ****************************************************************************
+ *
+ *  @file       gpio_sim.c
+ *  @brief      GPIO task interface for the host M4 simulator.
+ *
+ *  There is no LED on the host, its requested state is logged instead.
+ *
+ *  @copyright  Elnico Ltd. All rights reserved.
+ *
+ ******************************************************************************/
+/*
+ *  THIS SOFTWARE IS PROVIDED BY ELNICO "AS IS" AND ANY EXPRESSED OR
+ *  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ *  OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ *  IN NO EVENT SHALL ELNICO OR ITS CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ *  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ *  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ *  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ *  IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ *  THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************/
+
+#include "gpio.h"
+
+#include "esl_log.h"
+
+//******************************************************************************
+//******************************************************************************
+//******************************************************************************
+
+void gpio_setLedOn (void)
+{
+  LOGI_STR("LED: on");
+}
+
+//******************************************************************************
+
+void gpio_setLedOff (void)
+{
+  LOGI_STR("LED: off");
+}
+
+//******************************************************************************
+
+void gpio_setLedAuto (void)
+{
+  LOGI_STR("LED: auto");
+}
+
+//******************************************************************************
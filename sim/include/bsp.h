@@ -0,0 +1,46 @@
+/** ****************************************************************************
+ *
+ *  @file       bsp.h
+ *  @brief      BSP subset for the host M4 simulator.
+ *
+ *  Board settings the EasyDuo M4 tasks rely on.
+ *
+ *  @copyright  Elnico Ltd. All rights reserved.
+ *
+ ******************************************************************************/
+
+#ifndef BSP_H_SIM_71320575023750275023750234
+#define BSP_H_SIM_71320575023750275023750234
+//******************************************************************************
+
+#include <mqx.h>
+
+#define BSP_ALARM_RESOLUTION            (5)                                     //!< Tick length in milliseconds (as on the SQM4-VF6 M4).
+
+// Pins of lwgpio_sim.c wired to the MMA8451Q interrupt outputs (see mma845x_sim.c)
+#define BSP_GPIO_ACCEL_INT1             (0)                                     //!< MMA8451Q INT1.
+#define BSP_GPIO_ACCEL_INT2             (1)                                     //!< MMA8451Q INT2.
+#define BSP_ACCEL_INT_PIN               (BSP_GPIO_ACCEL_INT1)                   //!< Accelerometer interrupt input of the M4.
+#define BSP_ACCEL_INT_MUX_GPIO          (0)                                     //!< GPIO functionality of BSP_ACCEL_INT_PIN.
+
+// CRC_CTRL register fields used by esl_crc.h (see crc_sim.c)
+#define CRC_CTRL_TCRC_SHIFT             (24)
+#define CRC_CTRL_FXOR_MASK              (0x04000000)
+#define CRC_CTRL_TOTR(x)                (((uint_32)(x) & 0x3) << 28)
+#define CRC_CTRL_TOT(x)                 (((uint_32)(x) & 0x3) << 30)
+
+/** @def BSP_SHARED_SNAPSHOT
+ * @brief Region standing in for MCC_SNAPSHOT_ADDRESS (see shm_sim.c). */
+#define BSP_SHARED_SNAPSHOT             _bsp_shared_snapshot()
+
+/** Maps the POSIX shared memory object MCC_SIM_SNAPSHOT_NAME (created if it
+ *  does not exist), once per process.
+ * @return      Region of MCC_SNAPSHOT_SIZE bytes, NULL on failure. */
+void * _bsp_shared_snapshot (void);
+
+/** Invalidates the region mapped by _bsp_shared_snapshot(), so that the A5
+ *  readers do not take the last sample for a current one. */
+void _bsp_shared_snapshot_release (void);
+
+//******************************************************************************
+#endif // BSP_H_SIM_71320575023750275023750234 //
@@ -0,0 +1,27 @@
+/** ****************************************************************************
+ *
+ *  @file       esl_appctrl.h
+ *  @brief      ESL application control replacement for the host M4 simulator.
+ *
+ *  The simulator starts the tasks itself (see m4sim.c), only the
+ *  initialization handshake is provided.
+ *
+ *  @copyright  Elnico Ltd. All rights reserved.
+ *
+ ******************************************************************************/
+
+#ifndef ESL_APPCTRL_H_SIM_5720357203572035702
+#define ESL_APPCTRL_H_SIM_5720357203572035702
+//******************************************************************************
+
+#include "esl_log.h"
+#include "esl_utils.h"
+
+void m4sim_initDone (uint_32 u32InitialData, uint_32 u32Result);
+
+/** @def ESL_APPCTRL_INITDONE
+ * @brief Reports the task initialization result. Does not return on failure. */
+#define ESL_APPCTRL_INITDONE(initData, result)  m4sim_initDone((initData), (result))
+
+//******************************************************************************
+#endif // ESL_APPCTRL_H_SIM_5720357203572035702 //
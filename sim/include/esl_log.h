@@ -0,0 +1,30 @@
+/** ****************************************************************************
+ *
+ *  @file       esl_log.h
+ *  @brief      ESL log replacement for the host M4 simulator.
+ *
+ *  All messages are printed to stderr immediately (see m4sim.c).
+ *
+ *  @copyright  Elnico Ltd. All rights reserved.
+ *
+ ******************************************************************************/
+
+#ifndef ESL_LOG_H_SIM_10357203572035720357023
+#define ESL_LOG_H_SIM_10357203572035720357023
+//******************************************************************************
+
+void m4sim_log (char cSeverity, const char * sFile, int iLine, const char * sFmt, ...)
+  __attribute__ ((format (printf, 4, 5)));
+
+#define LOGE_STR(str)                   m4sim_log('E', __FILE__, __LINE__, "%s", str)
+#define LOGW_STR(str)                   m4sim_log('W', __FILE__, __LINE__, "%s", str)
+#define LOGI_STR(str)                   m4sim_log('I', __FILE__, __LINE__, "%s", str)
+#define LOGD_STR(str)                   m4sim_log('D', __FILE__, __LINE__, "%s", str)
+
+#define LOGE_FORMATTED(fmt,...)         m4sim_log('E', __FILE__, __LINE__, fmt, ##__VA_ARGS__)
+#define LOGW_FORMATTED(fmt,...)         m4sim_log('W', __FILE__, __LINE__, fmt, ##__VA_ARGS__)
+#define LOGI_FORMATTED(fmt,...)         m4sim_log('I', __FILE__, __LINE__, fmt, ##__VA_ARGS__)
+#define LOGD_FORMATTED(fmt,...)         m4sim_log('D', __FILE__, __LINE__, fmt, ##__VA_ARGS__)
+
+//******************************************************************************
+#endif // ESL_LOG_H_SIM_10357203572035720357023 //
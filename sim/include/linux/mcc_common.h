@@ -0,0 +1,3 @@
+/* Host builds of the Linux application take the MCC definitions of the
+ * M4 simulator instead of the kernel headers. */
+#include "../mcc_common.h"
@@ -0,0 +1,36 @@
+/** ****************************************************************************
+ *
+ *  @file       lwevent.h
+ *  @brief      MQX light-weight events for the host M4 simulator.
+ *
+ *  Implemented in mqx_sim.c on top of POSIX threads.
+ *
+ *  @copyright  Elnico Ltd. All rights reserved.
+ *
+ ******************************************************************************/
+
+#ifndef LWEVENT_H_SIM_65203752037520375023752
+#define LWEVENT_H_SIM_65203752037520375023752
+//******************************************************************************
+
+#include <mqx.h>
+
+#define LWEVENT_AUTO_CLEAR              (0x00000001)
+#define LWEVENT_WAIT_TIMEOUT            (0x51)
+
+typedef struct lwevent_struct {
+  pthread_mutex_t   mtx;
+  pthread_cond_t    cond;
+  _mqx_uint         VALUE;
+  _mqx_uint         FLAGS;
+} LWEVENT_STRUCT;
+
+_mqx_uint _lwevent_create     (LWEVENT_STRUCT * poEvent, _mqx_uint uFlags);
+_mqx_uint _lwevent_destroy    (LWEVENT_STRUCT * poEvent);
+_mqx_uint _lwevent_set        (LWEVENT_STRUCT * poEvent, _mqx_uint uMask);
+_mqx_uint _lwevent_clear      (LWEVENT_STRUCT * poEvent, _mqx_uint uMask);
+_mqx_uint _lwevent_wait_ticks (LWEVENT_STRUCT * poEvent, _mqx_uint uMask, boolean bAll, _mqx_uint uTicks);
+_mqx_uint _lwevent_get_signalled (void);
+
+//******************************************************************************
+#endif // LWEVENT_H_SIM_65203752037520375023752 //
@@ -0,0 +1,63 @@
+/** ****************************************************************************
+ *
+ *  @file       lwgpio.h
+ *  @brief      MQX light-weight GPIO for the host M4 simulator.
+ *
+ *  Implemented in lwgpio_sim.c: input pins driven by the simulated devices
+ *  (lwgpio_sim_drive()), with the edge and level interrupts delivered to the
+ *  ISR registered by esl_gpio_isrRegister() from the thread driving the pin.
+ *  Pin multiplexing and attributes are accepted and ignored.
+ *
+ *  @copyright  Elnico Ltd. All rights reserved.
+ *
+ ******************************************************************************/
+
+#ifndef LWGPIO_H_SIM_40572305723057230572305
+#define LWGPIO_H_SIM_40572305723057230572305
+//******************************************************************************
+
+#include <mqx.h>
+
+#define LWGPIO_SIM_PINS                 (8)                                     //!< Number of simulated pins (LWGPIO_PIN_ID 0 to 7).
+
+typedef uint_32 LWGPIO_PIN_ID;
+
+typedef enum {
+  LWGPIO_DIR_INPUT,
+  LWGPIO_DIR_OUTPUT,
+  LWGPIO_DIR_NOCHANGE,
+} LWGPIO_DIR;
+
+typedef enum {
+  LWGPIO_VALUE_LOW,
+  LWGPIO_VALUE_HIGH,
+  LWGPIO_VALUE_NOCHANGE,
+} LWGPIO_VALUE;
+
+typedef enum {
+  LWGPIO_INT_MODE_NONE    = 0x00,
+  LWGPIO_INT_MODE_RISING  = 0x01,
+  LWGPIO_INT_MODE_FALLING = 0x02,
+  LWGPIO_INT_MODE_HIGH    = 0x04,
+  LWGPIO_INT_MODE_LOW     = 0x08,
+} LWGPIO_INT_MODE;
+
+typedef struct lwgpio_struct {
+  LWGPIO_PIN_ID     uPin;                                                       //!< Pin of the handle.
+} LWGPIO_STRUCT, * LWGPIO_STRUCT_PTR;
+
+boolean       lwgpio_init               (LWGPIO_STRUCT_PTR poHandle, LWGPIO_PIN_ID uPin, LWGPIO_DIR eDir, LWGPIO_VALUE eValue);
+boolean       lwgpio_set_functionality  (LWGPIO_STRUCT_PTR poHandle, uint_32 u32Functionality);
+boolean       lwgpio_set_attribute      (LWGPIO_STRUCT_PTR poHandle, uint_32 u32Attribute, uint_32 u32Value);
+LWGPIO_VALUE  lwgpio_get_value          (LWGPIO_STRUCT_PTR poHandle);
+boolean       lwgpio_int_init           (LWGPIO_STRUCT_PTR poHandle, LWGPIO_INT_MODE eMode);
+void          lwgpio_int_enable         (LWGPIO_STRUCT_PTR poHandle, boolean bEnable);
+void          lwgpio_int_clear_flag     (LWGPIO_STRUCT_PTR poHandle);
+boolean       lwgpio_int_get_flag       (LWGPIO_STRUCT_PTR poHandle);
+
+/** Sets the level of a simulated input pin, as the device wired to it
+ *  does, and calls its ISR if the change (or the level) triggers it. */
+void          lwgpio_sim_drive          (LWGPIO_PIN_ID uPin, boolean bHigh);
+
+//******************************************************************************
+#endif // LWGPIO_H_SIM_40572305723057230572305 //
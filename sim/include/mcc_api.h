@@ -0,0 +1,34 @@
+/** ****************************************************************************
+ *
+ *  @file       mcc_api.h
+ *  @brief      MCC API for the host M4 simulator.
+ *
+ *  Implemented in mcc_sim.c over UNIX datagram sockets, one datagram per
+ *  message, bound to MCC_SIM_SOCKET_PATH. Also provides the MCC 2.x zero-copy
+ *  send functions mcc_get_buffer() and mcc_send_nocopy(). mcc_msgs_available()
+ *  only tells whether a message is waiting (1) or not (0).
+ *
+ *  @copyright  Elnico Ltd. All rights reserved.
+ *
+ ******************************************************************************/
+
+#ifndef MCC_API_H_SIM_20375023750237502375023
+#define MCC_API_H_SIM_20375023750237502375023
+//******************************************************************************
+
+#include "mcc_common.h"
+
+int mcc_initialize        (MCC_NODE node);
+int mcc_destroy           (MCC_NODE node);
+int mcc_create_endpoint   (MCC_ENDPOINT * endpoint, MCC_PORT port);
+int mcc_destroy_endpoint  (MCC_ENDPOINT * endpoint);
+int mcc_send              (MCC_ENDPOINT * endpoint, void * msg, MCC_MEM_SIZE msg_size, unsigned int timeout_us);
+int mcc_recv_nocopy       (MCC_ENDPOINT * endpoint, void ** buffer_p, MCC_MEM_SIZE * recv_size, unsigned int timeout_us);
+int mcc_get_buffer        (void ** buffer, MCC_MEM_SIZE * buf_size, unsigned int timeout_us);
+int mcc_send_nocopy       (MCC_ENDPOINT * src_endpoint, MCC_ENDPOINT * dest_endpoint, void * buffer, MCC_MEM_SIZE buf_size);
+int mcc_free_buffer       (void * buffer);
+int mcc_msgs_available    (MCC_ENDPOINT * endpoint, unsigned int * num_msgs);
+int mcc_get_info          (MCC_NODE node, MCC_INFO_STRUCT * info_data);
+
+//******************************************************************************
+#endif // MCC_API_H_SIM_20375023750237502375023 //
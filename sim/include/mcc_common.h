@@ -0,0 +1,49 @@
+/** ****************************************************************************
+ *
+ *  @file       mcc_common.h
+ *  @brief      MCC common types for the host M4 simulator.
+ *
+ *  Same types and return values as the Vybrid MCC library.
+ *
+ *  @copyright  Elnico Ltd. All rights reserved.
+ *
+ ******************************************************************************/
+
+#ifndef MCC_COMMON_H_SIM_75023750237502375023
+#define MCC_COMMON_H_SIM_75023750237502375023
+//******************************************************************************
+
+#include "mcc_config.h"
+
+#define MCC_VERSION_STRING              "001.002"
+
+typedef unsigned int    MCC_BOOLEAN;
+typedef unsigned int    MCC_MEM_SIZE;
+typedef unsigned int    MCC_CORE;
+typedef unsigned int    MCC_NODE;
+typedef unsigned int    MCC_PORT;
+
+typedef struct mcc_endpoint {
+  MCC_CORE          core;
+  MCC_NODE          node;
+  MCC_PORT          port;
+} MCC_ENDPOINT;
+
+typedef struct mcc_info_struct {
+  char              version_string[sizeof(MCC_VERSION_STRING)];
+} MCC_INFO_STRUCT;
+
+#define MCC_RESERVED_PORT_NUMBER        (0)
+#define MCC_WAIT_INF                    (0xFFFFFFFF)
+
+#define MCC_SUCCESS                     (0)
+#define MCC_ERR_TIMEOUT                 (1)
+#define MCC_ERR_INVAL                   (2)
+#define MCC_ERR_NOMEM                   (3)
+#define MCC_ERR_ENDPOINT                (4)
+#define MCC_ERR_SEMAPHORE               (5)
+#define MCC_ERR_DEV                     (6)
+#define MCC_ERR_INT                     (7)
+
+//******************************************************************************
+#endif // MCC_COMMON_H_SIM_75023750237502375023 //
@@ -0,0 +1,21 @@
+/** ****************************************************************************
+ *
+ *  @file       mcc_config.h
+ *  @brief      MCC configuration for the host M4 simulator.
+ *
+ *  Mirrors the limits of the Vybrid MCC library.
+ *
+ *  @copyright  Elnico Ltd. All rights reserved.
+ *
+ ******************************************************************************/
+
+#ifndef MCC_CONFIG_H_SIM_30275023750237502375
+#define MCC_CONFIG_H_SIM_30275023750237502375
+//******************************************************************************
+
+#define MCC_ATTR_BUFFER_SIZE_IN_BYTES   (1024)                                  //!< Size of one message buffer.
+#define MCC_ATTR_NUM_RECEIVE_BUFFERS    (10)                                    //!< Number of receive buffers.
+#define MCC_ATTR_MAX_RECEIVE_ENDPOINTS  (5)                                     //!< Number of endpoints per node.
+
+//******************************************************************************
+#endif // MCC_CONFIG_H_SIM_30275023750237502375 //
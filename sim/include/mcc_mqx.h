@@ -0,0 +1,14 @@
+/** ****************************************************************************
+ *
+ *  @file       mcc_mqx.h
+ *  @brief      MCC MQX port header for the host M4 simulator.
+ *
+ *  Nothing MQX specific is needed by the simulated MCC.
+ *
+ *  @copyright  Elnico Ltd. All rights reserved.
+ *
+ ******************************************************************************/
+
+#ifndef MCC_MQX_H_SIM_67502375023750237502375
+#define MCC_MQX_H_SIM_67502375023750237502375
+#endif // MCC_MQX_H_SIM_67502375023750237502375 //
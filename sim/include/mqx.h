@@ -0,0 +1,112 @@
+/** ****************************************************************************
+ *
+ *  @file       mqx.h
+ *  @brief      MQX subset for the host M4 simulator.
+ *
+ *  Provides the MQX types and kernel services used by the EasyDuo M4 tasks,
+ *  implemented on top of POSIX threads (see mqx_sim.c). One tick lasts
+ *  BSP_ALARM_RESOLUTION milliseconds as on the board.
+ *
+ *  @copyright  Elnico Ltd. All rights reserved.
+ *
+ ******************************************************************************/
+
+#ifndef MQX_H_SIM_40651305742075720357203752
+#define MQX_H_SIM_40651305742075720357203752
+//******************************************************************************
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//******************************************************************************
+// Types
+//******************************************************************************
+
+#define MQX_VERSION                     (400)                                   //!< No psptypes_legacy.h needed.
+
+typedef uint8_t         uint_8;
+typedef int8_t          int_8;
+typedef uint16_t        uint_16;
+typedef int16_t         int_16;
+typedef uint32_t        uint_32;
+typedef int32_t         int_32;
+typedef uint64_t        uint_64;
+typedef int64_t         int_64;
+typedef uint32_t        _mqx_uint;
+typedef int32_t         _mqx_int;
+typedef uint32_t        _mem_size;
+typedef void *          _mem_pool_id;
+typedef uint32_t        _task_id;
+typedef int             boolean;
+typedef void *          pointer;
+typedef char *          char_ptr;
+typedef void *          MQX_FILE_PTR;
+
+#define TRUE                            (1)
+#define FALSE                           (0)
+
+#define MQX_OK                          (0)
+#define MQX_INVALID_PARAMETER           (0x0C)
+#define MQX_LWSEM_WAIT_TIMEOUT          (0x70)
+
+//******************************************************************************
+// Time
+//******************************************************************************
+
+/** Tick structure. Keeps the host monotonic time in microseconds. */
+typedef struct mqx_tick_struct {
+  uint_64           USECS;
+} MQX_TICK_STRUCT;
+
+typedef struct time_struct {
+  uint_32           SECONDS;
+  uint_32           MILLISECONDS;
+} TIME_STRUCT;
+
+typedef struct date_struct {
+  int_16            YEAR;
+  int_16            MONTH;
+  int_16            DAY;
+  int_16            HOUR;
+  int_16            MINUTE;
+  int_16            SECOND;
+  int_16            MILLISEC;
+  int_16            WDAY;
+  int_16            YDAY;
+} DATE_STRUCT, * DATE_STRUCT_PTR;
+
+void              _time_get_elapsed_ticks   (MQX_TICK_STRUCT * poTicks);
+void              _time_get_elapsed         (TIME_STRUCT * poTime);
+MQX_TICK_STRUCT * _time_add_msec_to_ticks   (MQX_TICK_STRUCT * poTicks, _mqx_uint uMsecs);
+int_32            _time_diff_microseconds   (MQX_TICK_STRUCT * poEnd, MQX_TICK_STRUCT * poStart, boolean * pbOverflow);
+int_32            _time_diff_milliseconds   (MQX_TICK_STRUCT * poEnd, MQX_TICK_STRUCT * poStart, boolean * pbOverflow);
+void              _time_delay               (uint_32 u32Msecs);
+void              _time_delay_ticks         (uint_32 u32Ticks);
+
+//******************************************************************************
+// Tasks
+//******************************************************************************
+
+void              _task_block               (void);
+
+//******************************************************************************
+// Light-weight semaphores
+//******************************************************************************
+
+typedef struct lwsem_struct {
+  pthread_mutex_t   mtx;
+  pthread_cond_t    cond;
+  _mqx_int          VALUE;
+} LWSEM_STRUCT;
+
+_mqx_uint         _lwsem_create             (LWSEM_STRUCT * poSem, _mqx_int iInitial);
+_mqx_uint         _lwsem_destroy            (LWSEM_STRUCT * poSem);
+_mqx_uint         _lwsem_wait_ticks         (LWSEM_STRUCT * poSem, _mqx_uint uTicks);
+_mqx_uint         _lwsem_post               (LWSEM_STRUCT * poSem);
+
+//******************************************************************************
+#endif // MQX_H_SIM_40651305742075720357203752 //
@@ -0,0 +1,213 @@
+/** ****************************************************************************
+ *
+ *  @file       lwgpio_sim.c
+ *  @brief      Light-weight GPIO and ESL GPIO interrupts for the host M4
+ *              simulator.
+ *
+ *  The pins are inputs driven by the simulated devices (lwgpio_sim_drive(),
+ *  the MMA8451Q INT1 and INT2 outputs in mma845x_sim.c), idle high as with
+ *  the pull-ups of open drain outputs. An edge or level matching the
+ *  interrupt mode of an enabled pin latches its flag and calls its ISR in
+ *  the thread driving the pin, which stands in for the interrupt context.
+ *
+ *  @copyright  Elnico Ltd. All rights reserved.
+ *
+ ******************************************************************************/
+/*
+ *  THIS SOFTWARE IS PROVIDED BY ELNICO "AS IS" AND ANY EXPRESSED OR
+ *  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ *  OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ *  IN NO EVENT SHALL ELNICO OR ITS CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ *  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ *  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ *  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ *  IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ *  THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************/
+
+#include "esl_gpio.h"
+
+#include <lwgpio.h>
+#include <pthread.h>
+
+//******************************************************************************
+// Private types
+//******************************************************************************
+
+/** State of a simulated pin. */
+typedef struct t_lwgpiosim_pin_struct {
+  boolean           bLow;                                                       //!< Level driven by the device (idle high).
+  LWGPIO_INT_MODE   eMode;                                                      //!< Interrupt mode, LWGPIO_INT_MODE_NONE if not initialized.
+  boolean           bEnabled;                                                   //!< Interrupt enabled.
+  boolean           bFlag;                                                      //!< Interrupt flag.
+  void           (* pfIsr) (void *);                                            //!< ISR registered by esl_gpio_isrRegister().
+  void            * pvArg;                                                      //!< Argument of pfIsr.
+} TLwgpioSimPin;
+
+//******************************************************************************
+// Globals
+//******************************************************************************
+
+static pthread_mutex_t  g_mtx = PTHREAD_MUTEX_INITIALIZER;                      //!< Guards g_aoPins.
+static TLwgpioSimPin    g_aoPins[LWGPIO_SIM_PINS];                              //!< Simulated pins.
+
+//******************************************************************************
+// Functions declarations
+//******************************************************************************
+
+/** Checks whether the interrupt of a pin fires, to be called with g_mtx
+ *  locked.
+ * @param[in]   poPin         Pin.
+ * @param[in]   bWasLow       Level before the change (the current one if
+ *                            none, only a level then triggers).
+ * @return      ISR to call after unlocking g_mtx, NULL for none. */
+static void (* lwgpiosim_trigger (TLwgpioSimPin * poPin, boolean bWasLow)) (void *);
+
+//******************************************************************************
+//******************************************************************************
+//******************************************************************************
+
+boolean lwgpio_init (LWGPIO_STRUCT_PTR poHandle, LWGPIO_PIN_ID uPin, LWGPIO_DIR eDir, LWGPIO_VALUE eValue)
+{
+  if (!poHandle || (uPin >= LWGPIO_SIM_PINS) || (LWGPIO_DIR_OUTPUT == eDir)) return FALSE;
+  (void)eValue;
+  poHandle->uPin = uPin;
+  return TRUE;
+}
+
+//******************************************************************************
+
+boolean lwgpio_set_functionality (LWGPIO_STRUCT_PTR poHandle, uint_32 u32Functionality)
+{
+  (void)u32Functionality;
+  return poHandle ? TRUE : FALSE;
+}
+
+//******************************************************************************
+
+boolean lwgpio_set_attribute (LWGPIO_STRUCT_PTR poHandle, uint_32 u32Attribute, uint_32 u32Value)
+{
+  (void)u32Attribute; (void)u32Value;
+  return poHandle ? TRUE : FALSE;
+}
+
+//******************************************************************************
+
+LWGPIO_VALUE lwgpio_get_value (LWGPIO_STRUCT_PTR poHandle)
+{
+  LWGPIO_VALUE eValue;
+
+  pthread_mutex_lock(&g_mtx);
+  eValue = g_aoPins[poHandle->uPin].bLow ? LWGPIO_VALUE_LOW : LWGPIO_VALUE_HIGH;
+  pthread_mutex_unlock(&g_mtx);
+  return eValue;
+}
+
+//******************************************************************************
+
+boolean lwgpio_int_init (LWGPIO_STRUCT_PTR poHandle, LWGPIO_INT_MODE eMode)
+{
+  pthread_mutex_lock(&g_mtx);
+  g_aoPins[poHandle->uPin].eMode    = eMode;
+  g_aoPins[poHandle->uPin].bEnabled = FALSE;
+  g_aoPins[poHandle->uPin].bFlag    = FALSE;
+  pthread_mutex_unlock(&g_mtx);
+  return TRUE;
+}
+
+//******************************************************************************
+
+void lwgpio_int_enable (LWGPIO_STRUCT_PTR poHandle, boolean bEnable)
+{
+  TLwgpioSimPin * poPin = &g_aoPins[poHandle->uPin];
+  void         (* pfIsr) (void *) = NULL;
+  void          * pvArg;
+
+  pthread_mutex_lock(&g_mtx);
+  poPin->bEnabled = bEnable;
+  if (bEnable) pfIsr = lwgpiosim_trigger(poPin, poPin->bLow);                   // an active level fires at once
+  pvArg = poPin->pvArg;
+  pthread_mutex_unlock(&g_mtx);
+  if (pfIsr) pfIsr(pvArg);
+}
+
+//******************************************************************************
+
+void lwgpio_int_clear_flag (LWGPIO_STRUCT_PTR poHandle)
+{
+  pthread_mutex_lock(&g_mtx);
+  g_aoPins[poHandle->uPin].bFlag = FALSE;
+  pthread_mutex_unlock(&g_mtx);
+}
+
+//******************************************************************************
+
+boolean lwgpio_int_get_flag (LWGPIO_STRUCT_PTR poHandle)
+{
+  boolean bFlag;
+
+  pthread_mutex_lock(&g_mtx);
+  bFlag = g_aoPins[poHandle->uPin].bFlag;
+  pthread_mutex_unlock(&g_mtx);
+  return bFlag;
+}
+
+//******************************************************************************
+
+uint_8 esl_gpio_isrRegister (LWGPIO_STRUCT  * pHandle,
+                             void          (* isr) (void *),
+                             void           * arg)
+{
+  if (!pHandle) return ESL_GPIO_NULL_PTR;
+  if (pHandle->uPin >= LWGPIO_SIM_PINS) return ESL_GPIO_INVALID_PORT_NUMBER;
+
+  pthread_mutex_lock(&g_mtx);
+  g_aoPins[pHandle->uPin].pfIsr = isr;
+  g_aoPins[pHandle->uPin].pvArg = arg;
+  pthread_mutex_unlock(&g_mtx);
+  return ESL_GPIO_OK;
+}
+
+//******************************************************************************
+
+void lwgpio_sim_drive (LWGPIO_PIN_ID uPin, boolean bHigh)
+{
+  TLwgpioSimPin * poPin;
+  void         (* pfIsr) (void *);
+  void          * pvArg;
+  boolean         bWasLow;
+
+  if (uPin >= LWGPIO_SIM_PINS) return;
+  poPin = &g_aoPins[uPin];
+
+  pthread_mutex_lock(&g_mtx);
+  bWasLow     = poPin->bLow;
+  poPin->bLow = !bHigh;
+  pfIsr = lwgpiosim_trigger(poPin, bWasLow);
+  pvArg = poPin->pvArg;
+  pthread_mutex_unlock(&g_mtx);
+  if (pfIsr) pfIsr(pvArg);
+}
+
+//******************************************************************************
+// Private functions
+//******************************************************************************
+
+static void (* lwgpiosim_trigger (TLwgpioSimPin * poPin, boolean bWasLow)) (void *)
+{
+  boolean bFire;
+
+  if (!poPin->bEnabled) return NULL;
+  bFire = ((poPin->eMode & LWGPIO_INT_MODE_FALLING) && !bWasLow && poPin->bLow)
+          || ((poPin->eMode & LWGPIO_INT_MODE_RISING) && bWasLow && !poPin->bLow)
+          || ((poPin->eMode & LWGPIO_INT_MODE_LOW) && poPin->bLow)
+          || ((poPin->eMode & LWGPIO_INT_MODE_HIGH) && !poPin->bLow);
+  if (!bFire) return NULL;
+  poPin->bFlag = TRUE;
+  return poPin->pfIsr;
+}
+
+//******************************************************************************
@@ -0,0 +1,286 @@
+/** ****************************************************************************
+ *
+ *  @file       m4sim.c
+ *  @brief      Host M4 simulator entry point.
+ *
+ *  Runs the unmodified EasyDuo accelerometer and MCC tasks as POSIX threads on
+ *  a Linux host, so that the A5 application can be developed and tested
+ *  without the board. Start this program, then the A5 application with the
+ *  EASYDUO_MCC_SIM environment variable set (or built with CONFIG+=mccsim).
+ *  With -f, it also writes a file through mcfsd (mqx/mcfs.c), reads it back
+ *  and logs the throughput.
+ *
+ *  @copyright  Elnico Ltd. All rights reserved.
+ *
+ ******************************************************************************/
+/*
+ *  THIS SOFTWARE IS PROVIDED BY ELNICO "AS IS" AND ANY EXPRESSED OR
+ *  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ *  OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ *  IN NO EVENT SHALL ELNICO OR ITS CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ *  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ *  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ *  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ *  IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ *  THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************/
+
+#include "accelerometer.h"
+#include "mcc.h"
+#include "mcfs.h"
+#include "easyduo_mcc_common.h"
+
+#include "esl_appctrl.h"
+#include "esl_utils.h"
+#include "esl_log.h"
+
+#include "mcc_api.h"
+
+#include <mqx.h>
+#include <bsp.h>
+
+#include <signal.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+//******************************************************************************
+// General Definitions
+//******************************************************************************
+
+/** Simulated task. */
+typedef struct m4sim_task_struct {
+  const char      * sName;                                                      //!< Task name.
+  void           (* pfnTask)(uint_32);                                          //!< Task entry point.
+} TM4SimTask;
+
+#define M4SIM_MCFS_SIZE                 (4096)                                  //!< Default size of the -f file in KB.
+#define M4SIM_MCFS_CHUNK                (16 * 1024)                             //!< Bytes per mcfs_write()/mcfs_read() call.
+#define M4SIM_MCFS_RETRIES              (10)                                    //!< mcfs_init() attempts, one per second, for mcfsd to start.
+
+//******************************************************************************
+// Globals
+//******************************************************************************
+
+static const TM4SimTask g_aoTasks[] = {                                         //!< Tasks started in this order, each after the previous one is initialized.
+  { ACCEL_TASKNAME,    accel_task    },
+  { MCC_TASKNAME,      mcc_task      },
+  { MCC_BULK_TASKNAME, mcc_bulk_task },
+};
+
+static LWSEM_STRUCT     g_lwsemInit;                                            //!< Posted by m4sim_initDone().
+static pthread_mutex_t  g_mtxLog = PTHREAD_MUTEX_INITIALIZER;                   //!< Keeps the log lines whole.
+static const char     * g_sMcfsPath = NULL;                                     //!< File of the -f check, NULL if not requested.
+static uint32_t         g_u32McfsSize = M4SIM_MCFS_SIZE;                        //!< Its size in KB.
+
+//******************************************************************************
+// Functions declarations
+//******************************************************************************
+
+/** pthread entry point running one of g_aoTasks.
+ * @param[in]   pvIdx   Index to g_aoTasks. */
+static void * m4sim_taskMain (void * pvIdx);
+
+/** pthread entry point of the -f check: writes g_sMcfsPath through mcfsd,
+ *  reads it back, compares it and logs the throughput of both.
+ * @param[in]   pvUnused      Not used. */
+static void * m4sim_mcfsCheck (void * pvUnused);
+
+/** Fills a chunk of the -f file, its bytes derived from their offset.
+ * @param[out]  pu8Dst        Chunk.
+ * @param[in]   u32Offset     File offset of the chunk.
+ * @param[in]   u32Len        Chunk length. */
+static void m4sim_mcfsPattern (uint8_t * pu8Dst, uint32_t u32Offset, uint32_t u32Len);
+
+//******************************************************************************
+//******************************************************************************
+//******************************************************************************
+
+int main (int argc, char * argv[])
+{
+  pthread_t     oThread;
+  sigset_t      oSignals;
+  int           iSignal;
+  int           iOpt;
+  unsigned int  i;
+
+  while ((iOpt = getopt(argc, argv, "f:k:h")) != -1) {
+    switch (iOpt) {
+    case 'f': g_sMcfsPath = optarg;                                 break;
+    case 'k': g_u32McfsSize = (uint32_t)strtoul(optarg, NULL, 0);   break;
+    default:
+      fprintf(stderr, "usage: %s [-f <file> [-k <KB>]]\n"
+                      "  -f  write <file> through mcfsd, read it back and log the throughput\n"
+                      "  -k  size of the file in KB (default %u)\n", argv[0], M4SIM_MCFS_SIZE);
+      return 1;
+    }
+  }
+
+  // termination signals are handled by sigwait() below, not by the tasks
+  sigemptyset(&oSignals);
+  sigaddset(&oSignals, SIGINT);
+  sigaddset(&oSignals, SIGTERM);
+  pthread_sigmask(SIG_BLOCK, &oSignals, NULL);
+
+  if (MQX_OK != _lwsem_create(&g_lwsemInit, 0)) return 1;
+
+  for (i = 0; i < ARRAY_SIZE(g_aoTasks); ++i) {
+    if (pthread_create(&oThread, NULL, m4sim_taskMain, (void*)(uintptr_t)i)) {
+      LOGE_FORMATTED("pthread_create %s failed", g_aoTasks[i].sName);
+      return 1;
+    }
+    pthread_detach(oThread);
+    _lwsem_wait_ticks(&g_lwsemInit, 0);
+  }
+  LOGI_STR("M4 simulator running, Ctrl+C to quit");
+  if (g_sMcfsPath) {
+    if (pthread_create(&oThread, NULL, m4sim_mcfsCheck, NULL)) {
+      LOGE_STR("pthread_create mcfs check failed");
+    } else {
+      pthread_detach(oThread);
+    }
+  }
+
+  sigwait(&oSignals, &iSignal);
+  mcc_destroy(MCC_ENDPOINT_M4_NODE);                                            // removes the endpoint sockets
+  _bsp_shared_snapshot_release();
+  LOGI_STR("M4 simulator stopped");
+  return 0;
+}
+
+//******************************************************************************
+
+void m4sim_initDone (uint_32 u32InitialData, uint_32 u32Result)
+{
+  const char * sName = g_aoTasks[u32InitialData].sName;
+
+  if (MQX_OK != u32Result) {
+    LOGE_FORMATTED("%s task initialization failed: %u", sName, (unsigned)u32Result);
+    mcc_destroy(MCC_ENDPOINT_M4_NODE);
+    exit(1);
+  }
+  LOGI_FORMATTED("%s task ready", sName);
+  _lwsem_post(&g_lwsemInit);
+}
+
+//******************************************************************************
+
+void m4sim_log (char cSeverity, const char * sFile, int iLine, const char * sFmt, ...)
+{
+  MQX_TICK_STRUCT oNow;
+  const char    * sBase = strrchr(sFile, '/');
+  va_list         args;
+
+  _time_get_elapsed_ticks(&oNow);
+  pthread_mutex_lock(&g_mtxLog);
+  fprintf(stderr, "%llu.%03u %c %s:%d: ", (unsigned long long)(oNow.USECS / 1000000u),
+          (unsigned)(oNow.USECS % 1000000u / 1000u), cSeverity, sBase ? sBase + 1 : sFile, iLine);
+  va_start(args, sFmt);
+  vfprintf(stderr, sFmt, args);
+  va_end(args);
+  fputc('\n', stderr);
+  pthread_mutex_unlock(&g_mtxLog);
+}
+
+//******************************************************************************
+// Private functions
+//******************************************************************************
+
+static void * m4sim_taskMain (void * pvIdx)
+{
+  uint_32 u32Idx = (uint_32)(uintptr_t)pvIdx;
+
+  g_aoTasks[u32Idx].pfnTask(u32Idx);
+  LOGW_FORMATTED("%s task returned", g_aoTasks[u32Idx].sName);
+  return NULL;
+}
+
+//******************************************************************************
+
+static void * m4sim_mcfsCheck (void * pvUnused)
+{
+  static uint8_t    au8Chunk[M4SIM_MCFS_CHUNK];
+  static uint8_t    au8Expected[M4SIM_MCFS_CHUNK];
+  MQX_TICK_STRUCT   oStart, oWritten, oRead;
+  uint32_t          u32Size = g_u32McfsSize * 1024u;
+  uint32_t          u32Done, u32Len;
+  uint_32           ret = MCFS_ERR_NOT_INITIALIZED;
+  int_32            iHandle, iRet = MCFS_OK;
+  unsigned int      i;
+
+  (void)pvUnused;
+  for (i = 0; (i < M4SIM_MCFS_RETRIES) && (MCFS_OK != ret); ++i) {              // mcfsd may be started after us
+    if (i) _time_delay(1000);
+    ret = mcfs_init();
+  }
+  if (MCFS_OK != ret) {
+    LOGE_FORMATTED("mcfs check: mcfsd not answering: %u", (unsigned)ret);
+    return NULL;
+  }
+
+  _time_get_elapsed_ticks(&oStart);
+  iHandle = mcfs_open(g_sMcfsPath, MCFS_OPEN_WRITE | MCFS_OPEN_CREATE | MCFS_OPEN_TRUNCATE);
+  if (iHandle < 0) {
+    LOGE_FORMATTED("mcfs check: open %s for writing failed: %d", g_sMcfsPath, (int)-iHandle);
+    return NULL;
+  }
+  for (u32Done = 0; (u32Done < u32Size) && (iRet >= 0); u32Done += u32Len) {
+    u32Len = MIN(u32Size - u32Done, M4SIM_MCFS_CHUNK);
+    m4sim_mcfsPattern(au8Chunk, u32Done, u32Len);
+    iRet = mcfs_write(iHandle, au8Chunk, u32Len);
+  }
+  if (iRet >= 0) iRet = mcfs_close(iHandle);                                    // waits for the writes, flushed by mcfsd
+  else           mcfs_close(iHandle);
+  if (iRet < 0) {
+    LOGE_FORMATTED("mcfs check: write of %s failed: %d", g_sMcfsPath, (int)-iRet);
+    return NULL;
+  }
+  _time_get_elapsed_ticks(&oWritten);
+
+  iHandle = mcfs_open(g_sMcfsPath, MCFS_OPEN_READ);
+  if (iHandle < 0) {
+    LOGE_FORMATTED("mcfs check: open %s for reading failed: %d", g_sMcfsPath, (int)-iHandle);
+    return NULL;
+  }
+  for (u32Done = 0; u32Done < u32Size; u32Done += u32Len) {
+    u32Len = MIN(u32Size - u32Done, M4SIM_MCFS_CHUNK);
+    iRet   = mcfs_read(iHandle, au8Chunk, u32Len);
+    if (iRet != (int_32)u32Len) break;
+    m4sim_mcfsPattern(au8Expected, u32Done, u32Len);
+    if (memcmp(au8Chunk, au8Expected, u32Len)) {
+      iRet = -MCFS_ERR_IO;
+      break;
+    }
+  }
+  mcfs_close(iHandle);
+  _time_get_elapsed_ticks(&oRead);
+  if (u32Done < u32Size) {
+    LOGE_FORMATTED("mcfs check: read back of %s failed at %u: %d", g_sMcfsPath, (unsigned)u32Done, (int)iRet);
+    return NULL;
+  }
+
+  LOGI_FORMATTED("mcfs check: %u KB written in %u ms (%.1f MB/s), read back and verified in %u ms (%.1f MB/s)",
+                 (unsigned)g_u32McfsSize,
+                 (unsigned)((oWritten.USECS - oStart.USECS) / 1000u), u32Size / (double)MAX(oWritten.USECS - oStart.USECS, 1),
+                 (unsigned)((oRead.USECS - oWritten.USECS) / 1000u), u32Size / (double)MAX(oRead.USECS - oWritten.USECS, 1));
+  return NULL;
+}
+
+//******************************************************************************
+
+static void m4sim_mcfsPattern (uint8_t * pu8Dst, uint32_t u32Offset, uint32_t u32Len)
+{
+  uint32_t i;
+
+  for (i = 0; i < u32Len; ++i) {
+    uint32_t u32Pos = u32Offset + i;
+
+    pu8Dst[i] = (uint8_t)(u32Pos ^ (u32Pos >> 8) ^ (u32Pos >> 16));             // differs between the blocks too
+  }
+}
+
+//******************************************************************************
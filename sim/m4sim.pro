@@ -0,0 +1,43 @@
+# Host M4 simulator: the EasyDuo MQX tasks running on Linux (see m4sim.c)
+TEMPLATE = app
+TARGET = m4sim
+CONFIG += console
+CONFIG -= qt \
+    app_bundle
+QMAKE_CFLAGS += -std=gnu99
+DEFINES += MCC_SEND_NOCOPY=1
+INCLUDEPATH += include \
+    ../mqx \
+    ../mqx/libesl \
+    ../common
+HEADERS += include/mqx.h \
+    include/bsp.h \
+    include/lwevent.h \
+    include/lwgpio.h \
+    include/esl_appctrl.h \
+    include/esl_log.h \
+    include/mcc_api.h \
+    include/mcc_common.h \
+    include/mcc_config.h \
+    include/mcc_mqx.h
+SOURCES += ../mqx/accelerometer.c \
+    ../mqx/mcc.c \
+    ../mqx/eventlog.c \
+    ../mqx/filter.c \
+    ../mqx/history.c \
+    ../mqx/mcfs.c \
+    ../mqx/mma845x_events.c \
+    ../mqx/mma845x_fifo.c \
+    ../mqx/timebase.c \
+    ../mqx/vibration.c \
+    m4sim.c \
+    mqx_sim.c \
+    mcc_sim.c \
+    mma845x_sim.c \
+    gpio_sim.c \
+    lwgpio_sim.c \
+    shm_sim.c \
+    crc_sim.c
+LIBS += -lpthread \
+    -lrt \
+    -lm
@@ -0,0 +1,327 @@
+/** ****************************************************************************
+ *
+ *  @file       mcc_sim.c
+ *  @brief      MCC library for the host M4 simulator.
+ *
+ *  Each endpoint is a UNIX datagram socket bound to MCC_SIM_SOCKET_PATH, one
+ *  datagram carries one message. The Linux side talks to it through
+ *  CMccTransportSocket (see linux/CMccTransport.h).
+ *
+ *  @copyright  Elnico Ltd. All rights reserved.
+ *
+ ******************************************************************************/
+/*
+ *  THIS SOFTWARE IS PROVIDED BY ELNICO "AS IS" AND ANY EXPRESSED OR
+ *  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ *  OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ *  IN NO EVENT SHALL ELNICO OR ITS CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ *  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ *  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ *  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ *  IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ *  THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************/
+
+#include "easyduo_mcc_common.h"
+
+#include "mcc_config.h"
+#include "mcc_common.h"
+#include "mcc_api.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+//******************************************************************************
+// Globals
+//******************************************************************************
+
+/** Endpoint created by mcc_create_endpoint(). */
+typedef struct mccsim_endpoint_struct {
+  MCC_PORT            port;                                                     //!< Endpoint port, MCC_RESERVED_PORT_NUMBER if the slot is free.
+  int                 iSocket;                                                  //!< Bound socket.
+  struct sockaddr_un  oAddr;                                                    //!< Bound address.
+} TMccSimEndpoint;
+
+static pthread_mutex_t  g_mtx = PTHREAD_MUTEX_INITIALIZER;                      //!< Guards the globals below.
+static MCC_NODE         g_node;                                                 //!< Node given to mcc_initialize().
+static int              g_iSendSocket = -1;                                     //!< Unbound socket used by mcc_send(), -1 if not initialized.
+static TMccSimEndpoint  g_aoEndpoints[MCC_ATTR_MAX_RECEIVE_ENDPOINTS];          //!< Local endpoints.
+
+//******************************************************************************
+// Functions declarations
+//******************************************************************************
+
+/** Fills in the socket address of given endpoint. */
+static void mccsim_addr (struct sockaddr_un * poAddr, MCC_NODE node, MCC_PORT port);
+
+/** Looks up the bound socket of a local endpoint.
+ * @return      Socket descriptor, or -1 if the endpoint does not exist. */
+static int mccsim_socket (const MCC_ENDPOINT * endpoint);
+
+//******************************************************************************
+//******************************************************************************
+//******************************************************************************
+
+int mcc_initialize (MCC_NODE node)
+{
+  int ret = MCC_SUCCESS;
+
+  pthread_mutex_lock(&g_mtx);
+  if (g_iSendSocket < 0) {
+    g_node        = node;
+    g_iSendSocket = socket(AF_UNIX, SOCK_DGRAM, 0);
+    if (g_iSendSocket < 0) ret = MCC_ERR_DEV;
+  }
+  pthread_mutex_unlock(&g_mtx);
+
+  return ret;
+}
+
+//******************************************************************************
+
+int mcc_destroy (MCC_NODE node)
+{
+  unsigned int i;
+
+  pthread_mutex_lock(&g_mtx);
+  for (i = 0; i < MCC_ATTR_MAX_RECEIVE_ENDPOINTS; ++i) {
+    if (MCC_RESERVED_PORT_NUMBER != g_aoEndpoints[i].port) {
+      close(g_aoEndpoints[i].iSocket);
+      unlink(g_aoEndpoints[i].oAddr.sun_path);
+      g_aoEndpoints[i].port = MCC_RESERVED_PORT_NUMBER;
+    }
+  }
+  if (g_iSendSocket >= 0) {
+    close(g_iSendSocket);
+    g_iSendSocket = -1;
+  }
+  pthread_mutex_unlock(&g_mtx);
+
+  (void)node;
+  return MCC_SUCCESS;
+}
+
+//******************************************************************************
+
+int mcc_create_endpoint (MCC_ENDPOINT * endpoint, MCC_PORT port)
+{
+  TMccSimEndpoint * poFree = NULL;
+  unsigned int      i;
+  int               ret    = MCC_SUCCESS;
+
+  if (!endpoint || (MCC_RESERVED_PORT_NUMBER == port)) return MCC_ERR_INVAL;
+
+  pthread_mutex_lock(&g_mtx);
+  for (i = 0; i < MCC_ATTR_MAX_RECEIVE_ENDPOINTS; ++i) {
+    if (port == g_aoEndpoints[i].port) {
+      ret = MCC_ERR_ENDPOINT;                                                   // already exists
+      break;
+    } else if (!poFree && (MCC_RESERVED_PORT_NUMBER == g_aoEndpoints[i].port)) {
+      poFree = &g_aoEndpoints[i];
+    }
+  }
+  if ((MCC_SUCCESS == ret) && !poFree) ret = MCC_ERR_NOMEM;
+
+  if (MCC_SUCCESS == ret) {
+    mccsim_addr(&poFree->oAddr, g_node, port);
+    poFree->iSocket = socket(AF_UNIX, SOCK_DGRAM, 0);
+    if (poFree->iSocket < 0) {
+      ret = MCC_ERR_DEV;
+    } else {
+      unlink(poFree->oAddr.sun_path);                                           // left over by a crashed instance
+      if (bind(poFree->iSocket, (struct sockaddr*)&poFree->oAddr, sizeof(poFree->oAddr)) < 0) {
+        close(poFree->iSocket);
+        ret = MCC_ERR_ENDPOINT;
+      } else {
+        poFree->port   = port;
+        endpoint->core = MCC_ENDPOINT_M4_CORE;
+        endpoint->node = g_node;
+        endpoint->port = port;
+      }
+    }
+  }
+  pthread_mutex_unlock(&g_mtx);
+
+  return ret;
+}
+
+//******************************************************************************
+
+int mcc_destroy_endpoint (MCC_ENDPOINT * endpoint)
+{
+  unsigned int i;
+  int          ret = MCC_ERR_ENDPOINT;
+
+  pthread_mutex_lock(&g_mtx);
+  for (i = 0; i < MCC_ATTR_MAX_RECEIVE_ENDPOINTS; ++i) {
+    if (endpoint->port == g_aoEndpoints[i].port) {
+      close(g_aoEndpoints[i].iSocket);
+      unlink(g_aoEndpoints[i].oAddr.sun_path);
+      g_aoEndpoints[i].port = MCC_RESERVED_PORT_NUMBER;
+      ret = MCC_SUCCESS;
+      break;
+    }
+  }
+  pthread_mutex_unlock(&g_mtx);
+
+  return ret;
+}
+
+//******************************************************************************
+
+int mcc_send (MCC_ENDPOINT * endpoint, void * msg, MCC_MEM_SIZE msg_size, unsigned int timeout_us)
+{
+  struct sockaddr_un oAddr;
+
+  if (!endpoint || !msg || (msg_size > MCC_ATTR_BUFFER_SIZE_IN_BYTES)) return MCC_ERR_INVAL;
+  if (g_iSendSocket < 0) return MCC_ERR_DEV;
+
+  mccsim_addr(&oAddr, endpoint->node, endpoint->port);
+  if (sendto(g_iSendSocket, msg, msg_size, MSG_DONTWAIT,
+             (struct sockaddr*)&oAddr, sizeof(oAddr)) < 0) {
+    switch (errno) {
+    case EAGAIN:        return MCC_ERR_NOMEM;                                   // receiver's queue full, as if out of MCC buffers
+    case ENOENT:
+    case ECONNREFUSED:  return MCC_ERR_ENDPOINT;                                // receiver not running
+    default:            return MCC_ERR_DEV;
+    }
+  }
+
+  (void)timeout_us;
+  return MCC_SUCCESS;
+}
+
+//******************************************************************************
+
+int mcc_get_buffer (void ** buffer, MCC_MEM_SIZE * buf_size, unsigned int timeout_us)
+{
+  if (!buffer || !buf_size) return MCC_ERR_INVAL;
+  *buffer = malloc(MCC_ATTR_BUFFER_SIZE_IN_BYTES);
+  if (!*buffer) return MCC_ERR_NOMEM;
+  *buf_size = MCC_ATTR_BUFFER_SIZE_IN_BYTES;
+
+  (void)timeout_us;
+  return MCC_SUCCESS;
+}
+
+//******************************************************************************
+
+int mcc_send_nocopy (MCC_ENDPOINT * src_endpoint, MCC_ENDPOINT * dest_endpoint, void * buffer, MCC_MEM_SIZE buf_size)
+{
+  int ret;
+
+  ret = mcc_send(dest_endpoint, buffer, buf_size, 0);
+  if (MCC_SUCCESS == ret) free(buffer);                                         // the caller keeps the buffer on failure
+
+  (void)src_endpoint;
+  return ret;
+}
+
+//******************************************************************************
+
+int mcc_recv_nocopy (MCC_ENDPOINT * endpoint, void ** buffer_p, MCC_MEM_SIZE * recv_size, unsigned int timeout_us)
+{
+  struct pollfd oPoll;
+  void        * pvBuf;
+  ssize_t       len;
+  int           ret;
+
+  if (!endpoint || !buffer_p || !recv_size) return MCC_ERR_INVAL;
+  oPoll.fd     = mccsim_socket(endpoint);
+  oPoll.events = POLLIN;
+  if (oPoll.fd < 0) return MCC_ERR_ENDPOINT;
+
+  do {
+    ret = poll(&oPoll, 1, (MCC_WAIT_INF == timeout_us) ? -1 : (int)((timeout_us + 999) / 1000));
+  } while ((ret < 0) && (EINTR == errno));
+  if (0 == ret) return MCC_ERR_TIMEOUT;
+  if (ret < 0)  return MCC_ERR_DEV;
+
+  pvBuf = malloc(MCC_ATTR_BUFFER_SIZE_IN_BYTES);
+  if (!pvBuf) return MCC_ERR_NOMEM;
+  len = recv(oPoll.fd, pvBuf, MCC_ATTR_BUFFER_SIZE_IN_BYTES, 0);
+  if (len < 0) {
+    free(pvBuf);
+    return MCC_ERR_DEV;
+  }
+
+  *buffer_p  = pvBuf;
+  *recv_size = (MCC_MEM_SIZE)len;
+  return MCC_SUCCESS;
+}
+
+//******************************************************************************
+
+int mcc_free_buffer (void * buffer)
+{
+  free(buffer);
+  return MCC_SUCCESS;
+}
+
+//******************************************************************************
+
+int mcc_msgs_available (MCC_ENDPOINT * endpoint, unsigned int * num_msgs)
+{
+  struct pollfd oPoll;
+
+  if (!endpoint || !num_msgs) return MCC_ERR_INVAL;
+  oPoll.fd     = mccsim_socket(endpoint);
+  oPoll.events = POLLIN;
+  if (oPoll.fd < 0) return MCC_ERR_ENDPOINT;
+
+  *num_msgs = (poll(&oPoll, 1, 0) > 0) ? 1 : 0;                                 // a datagram socket cannot tell more
+  return MCC_SUCCESS;
+}
+
+//******************************************************************************
+
+int mcc_get_info (MCC_NODE node, MCC_INFO_STRUCT * info_data)
+{
+  if (!info_data) return MCC_ERR_INVAL;
+  strcpy(info_data->version_string, MCC_VERSION_STRING);
+  (void)node;
+  return MCC_SUCCESS;
+}
+
+//******************************************************************************
+// Private functions
+//******************************************************************************
+
+static void mccsim_addr (struct sockaddr_un * poAddr, MCC_NODE node, MCC_PORT port)
+{
+  memset(poAddr, 0, sizeof(*poAddr));
+  poAddr->sun_family = AF_UNIX;
+  snprintf(poAddr->sun_path, sizeof(poAddr->sun_path), MCC_SIM_SOCKET_PATH,
+           (unsigned)node, (unsigned)port);
+}
+
+//******************************************************************************
+
+static int mccsim_socket (const MCC_ENDPOINT * endpoint)
+{
+  unsigned int i;
+  int          iSocket = -1;
+
+  pthread_mutex_lock(&g_mtx);
+  for (i = 0; i < MCC_ATTR_MAX_RECEIVE_ENDPOINTS; ++i) {
+    if (endpoint->port == g_aoEndpoints[i].port) {
+      iSocket = g_aoEndpoints[i].iSocket;
+      break;
+    }
+  }
+  pthread_mutex_unlock(&g_mtx);
+
+  return iSocket;
+}
+
+//******************************************************************************
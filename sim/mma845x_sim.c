@@ -0,0 +1,1015 @@
+/** ****************************************************************************
+ *
+ *  @file       mma845x_sim.c
+ *  @brief      MMA845xQ accelerometer and its driver for the host M4 simulator.
+ *
+ *  Simulates an MMA8451Q at the register level: esl_i2c_read() and
+ *  esl_i2c_write() access its register map, and the esl_i2c_MMA845xQ
+ *  interface is implemented on top of them the way the ESL driver does over
+ *  the I2C bus. The device produces a synthetic signal (small sine waves on X
+ *  and Y, 1 g with a slight wobble on Z, plus noise) at the output data rate
+ *  of CTRL_REG1, to the OUT_* registers or to the 32 sample FIFO (F_SETUP,
+ *  F_STATUS with the overflow and watermark flags, the burst read wrapping
+ *  from OUT_Z_LSB to OUT_X_MSB). Registers other than CTRL_REG1 are written
+ *  in the STANDBY mode only, as on the device. The data ready and FIFO
+ *  interrupt sources enabled by CTRL_REG4 drive the INT1 or INT2 pin chosen
+ *  by CTRL_REG5 (BSP_GPIO_ACCEL_INT1 and BSP_GPIO_ACCEL_INT2 of lwgpio_sim.c)
+ *  with the CTRL_REG3 polarity, from a thread producing the samples on time
+ *  while an interrupt is enabled. The freefall/motion, transient and pulse
+ *  functions check every sample (the transient and pulse ones against the
+ *  rest of a slow low-pass instead of the HPF_CUTOFF filter, their counters
+ *  advancing by the time steps of an output data period), latch
+ *  their source registers until read and raise their INT_SOURCE bits; a tap
+ *  on X every MMA845XQ_SIM_EVENT_US, doubled every other time, and a short
+ *  freefall every fourth time give them something to detect. Not
+ *  simulated: the fast read mode (F_READ), the FIFO trigger mode (behaves
+ *  as circular), the orientation function and the sleep modes.
+ *
+ *  @copyright  Elnico Ltd. All rights reserved.
+ *
+ ******************************************************************************/
+/*
+ *  THIS SOFTWARE IS PROVIDED BY ELNICO "AS IS" AND ANY EXPRESSED OR
+ *  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ *  OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ *  IN NO EVENT SHALL ELNICO OR ITS CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ *  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ *  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ *  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ *  IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ *  THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************/
+
+#include "esl_i2c_MMA845xQ.h"
+#include "esl_utils.h"
+#include "mma845x_events.h"
+#include "mma845x_fifo.h"
+
+#include <mqx.h>
+#include <bsp.h>
+#include <lwgpio.h>
+#include <math.h>
+#include <pthread.h>
+#include <time.h>
+
+//******************************************************************************
+// General Definitions
+//******************************************************************************
+
+#define MMA845XQ_SIM_TYPE               (1)                                     //!< Simulated IC type specifier (MMA8451Q, see ESL_I2C_MMA845XQ_DATA_RESOLUTION).
+#define MMA845XQ_SIM_NOISE              (0.004f)                                //!< Peak noise amplitude in g.
+#define MMA845XQ_SIM_REGS               (0x32)                                  //!< Size of the register map (STATUS to OFF_Z).
+#define MMA845XQ_SIM_DRDY_MASK          (0x0F)                                  //!< ZYXDR, ZDR, YDR and XDR bits of STATUS.
+#define MMA845XQ_SIM_OW_MASK            (0xF0)                                  //!< ZYXOW, ZOW, YOW and XOW bits of STATUS.
+#define MMA845XQ_SIM_PIN_SRC_MASK       (0x6D)                                  //!< FIFO, transient, pulse, FF_MT and DRDY interrupt sources, the ones driving the pins.
+#define MMA845XQ_SIM_THS_G              (0.063f)                                //!< Threshold step of the embedded functions in g.
+#define MMA845XQ_SIM_HP_DIV             (32)                                    //!< Low-pass divider (samples) the high-pass of the embedded functions is the rest of.
+#define MMA845XQ_SIM_PULSE_IDLE         (0)                                     //!< Pulse function waiting for a pulse.
+#define MMA845XQ_SIM_PULSE_HIGH         (1)                                     //!< Pulse in progress, a tap if over within PULSE_TMLT.
+#define MMA845XQ_SIM_PULSE_LONG         (2)                                     //!< Pulse too long for a tap, waiting for its end.
+#define MMA845XQ_SIM_PULSE_LATENCY      (3)                                     //!< Pulses ignored for PULSE_LTCY after a tap.
+#define MMA845XQ_SIM_PULSE_WINDOW       (4)                                     //!< A pulse within PULSE_WIND is the second tap.
+
+/** @def MMA845XQ_SIM_EVENTS
+ * @brief 1 to add the taps and freefalls to the synthetic signal. */
+#ifndef MMA845XQ_SIM_EVENTS
+# define MMA845XQ_SIM_EVENTS            (1)
+#endif
+#define MMA845XQ_SIM_EVENT_US           (5000000)                               //!< Period of the simulated taps.
+#define MMA845XQ_SIM_TAP_US             (10000)                                 //!< Duration of a simulated tap.
+#define MMA845XQ_SIM_TAP_G              (1.0f)                                  //!< Amplitude of a simulated tap on X in g.
+#define MMA845XQ_SIM_TAP2_US            (240000)                                //!< Start of the second tap of a double tap (a multiple of the periods up to 80 ms).
+#define MMA845XQ_SIM_FALL_AT_US         (2500000)                               //!< Start of a simulated freefall in its period.
+#define MMA845XQ_SIM_FALL_US            (150000)                                //!< Duration of a simulated freefall.
+
+//******************************************************************************
+// Globals
+//******************************************************************************
+
+static pthread_mutex_t  g_mtx = PTHREAD_MUTEX_INITIALIZER;                      //!< Guards the device state below (the I2C bus lock of the device).
+static uint_8           g_au8Reg[MMA845XQ_SIM_REGS];                            //!< Register map, STATUS, OUT_* and F_STATUS are kept separately.
+static uint_8           g_u8Status;                                             //!< STATUS with the FIFO disabled.
+static uint_8           g_au8Out[MMA845X_SAMPLE_BYTES];                         //!< OUT_X_MSB to OUT_Z_LSB with the FIFO disabled.
+static uint_8           g_aau8Fifo[MMA845X_FIFO_SIZE][MMA845X_SAMPLE_BYTES];    //!< FIFO samples.
+static uint_32          g_u32FifoHead;                                          //!< Index of the oldest sample in g_aau8Fifo.
+static uint_32          g_u32FifoCnt;                                           //!< Number of samples in g_aau8Fifo.
+static boolean          g_bFifoOverflow;                                        //!< F_OVF, cleared by reading F_STATUS.
+static MQX_TICK_STRUCT  g_oStart;                                               //!< Time of the activation (signal phase origin).
+static uint_64          g_u64Produced;                                          //!< Samples produced since the activation.
+static pthread_cond_t   g_oPinCond;                                             //!< Wakes the pin thread up on a change of CTRL_REG1 or CTRL_REG4.
+static boolean          g_bPinThread;                                           //!< Pin thread started.
+static float            g_afLow[3];                                             //!< Low-pass of the samples, the transient and pulse functions take the rest.
+static uint_32          g_u32FfMtCnt;                                           //!< FF_MT debounce counter.
+static uint_32          g_u32TransientCnt;                                      //!< Transient debounce counter.
+static uint_8           g_u8PulseState;                                         //!< MMA845XQ_SIM_PULSE_* state of the pulse function.
+static uint_32          g_u32PulseCnt;                                          //!< Time steps in g_u8PulseState.
+static uint_8           g_u8PulseAxes;                                          //!< MCC_ACCEL_AXIS_* bits of the pulse in progress.
+static uint_8           g_u8PulseNegative;                                      //!< Negative axes of the pulse in progress.
+static boolean          g_bPulseSecond;                                         //!< The pulse in progress started within PULSE_WIND.
+static uint_8           g_u8FfMtSrc;                                            //!< Latched FF_MT_SRC, cleared by reading it.
+static uint_8           g_u8TransientSrc;                                       //!< Latched TRANSIENT_SRC, cleared by reading it.
+static uint_8           g_u8PulseSrc;                                           //!< Latched PULSE_SRC, cleared by reading it.
+
+//******************************************************************************
+// Functions declarations
+//******************************************************************************
+
+/** Produces the samples due since the last call, to be called with g_mtx
+ *  locked before every register access. */
+static void mma845xsim_update (void);
+
+/** Produces the sample of given index (time since the activation).
+ * @param[out]  pu8Dst        Destination of the OUT_* register values.
+ * @param[out]  pfG           Destination of the X, Y, Z acceleration in g.
+ * @param[in]   u64Index      Sample index. */
+static void mma845xsim_sample (uint_8 * pu8Dst, float * pfG, uint_64 u64Index);
+
+/** Runs the freefall/motion, transient and pulse functions on a sample. */
+static void mma845xsim_detect (const float * pfG);
+
+/** Counts a debounced condition.
+ * @param[in,out] pu32Cnt     Time steps of the consecutive samples meeting it.
+ * @param[in]   bCond         Condition of the sample.
+ * @param[in]   u8Count       Debounce count register.
+ * @param[in]   u32Steps      Time steps of an output data period.
+ * @return      TRUE at the sample the event is raised at. */
+static boolean mma845xsim_debounce (uint_32 * pu32Cnt, boolean bCond, uint_8 u8Count, uint_32 u32Steps);
+
+/** Finds the axes above their threshold.
+ * @param[in]   pfG           X, Y, Z values in g.
+ * @param[in]   pu8Ths        X, Y, Z thresholds in MMA845XQ_SIM_THS_G steps
+ *                            (bit 7 ignored).
+ * @param[in]   u8Axes        MCC_ACCEL_AXIS_* bits of the axes checked.
+ * @param[out]  pu8Negative   MCC_ACCEL_AXIS_* bits of the ones found below
+ *                            the negative threshold.
+ * @return      MCC_ACCEL_AXIS_* bits of the axes found. */
+static uint_8 mma845xsim_above (const float * pfG, const uint_8 * pu8Ths, uint_8 u8Axes, uint_8 * pu8Negative);
+
+/** Returns the FF_MT_SRC or TRANSIENT_SRC axis bits (event flag and
+ *  polarity of every axis) of MCC_ACCEL_AXIS_* bits. */
+static uint_8 mma845xsim_srcAxes (uint_8 u8Axes, uint_8 u8Negative);
+
+/** Ends a pulse of the pulse function, a tap if within PULSE_TMLT. */
+static void mma845xsim_endPulse (void);
+
+/** Puts the embedded functions to their initial state. */
+static void mma845xsim_resetEvents (void);
+
+/** Reads one register, with the side effects of a read on the device. */
+static uint_8 mma845xsim_readReg (uint_8 u8Addr);
+
+/** Writes one register, with the side effects of a write on the device. */
+static void mma845xsim_writeReg (uint_8 u8Addr, uint_8 u8Value);
+
+/** Returns the register address following given one in a burst transfer. */
+static uint_8 mma845xsim_nextAddr (uint_8 u8Addr);
+
+/** Puts the device to the state after the power up or CTRL_REG2 RST. */
+static void mma845xsim_resetRegs (void);
+
+/** Drives the INT1 and INT2 pins by the pending interrupt sources, to be
+ *  called with g_mtx locked after every register access. */
+static void mma845xsim_updatePins (void);
+
+/** Starts the pin thread unless running, to be called with g_mtx locked. */
+static void mma845xsim_startPinThread (void);
+
+/** Pin thread: while ACTIVE with an interrupt enabled, produces every sample
+ *  at its time and drives the pins, as the device does on its own. */
+static void * mma845xsim_pinThread (void * pvArg);
+
+/** Computes the output data period in microseconds from CTRL_REG1. */
+static uint_32 mma845xsim_period (void);
+
+/** Computes the time steps of the debounce counters and the pulse timers in
+ *  an output data period from CTRL_REG1 and the CTRL_REG2 oversampling mode
+ *  (AN4070), at least 1. */
+static uint_32 mma845xsim_steps (void);
+
+/** Computes the full scale (2, 4 or 8 g) from XYZ_DATA_CFG. */
+static int mma845xsim_scale (void);
+
+/** Converts acceleration in g to the left-justified raw register value. */
+static int_16 mma845xsim_g2raw (float fG, int iScale);
+
+/** Checks that the I2C device addresses the simulated accelerometer. */
+static boolean mma845xsim_isDevice (const ESL_I2C_TDevice * poDevice);
+
+/** Reads a register of the accelerometer by the general I2C interface. */
+static uint_8 mma845xsim_read (ESL_I2C_MMA845XQ_TDevice * hAccelDevice, uint_8 u8Addr, uint_8 * pu8Data, uint_8 u8Len);
+
+/** Writes a register of the accelerometer by the general I2C interface. */
+static uint_8 mma845xsim_write (ESL_I2C_MMA845XQ_TDevice * hAccelDevice, uint_8 u8Addr, uint_8 u8Value);
+
+//******************************************************************************
+//******************************************************************************
+//******************************************************************************
+
+int esl_i2c_read (const ESL_I2C_TDevice  * hDevice,
+                  uint_32                  u32Addr,
+                  uint_8                 * au8Data,
+                  uint_8                   u8Len,
+                  uint_32                  u32WaitTicks)
+{
+  uint_8 u8Addr = (uint_8)u32Addr;
+  uint_8 i;
+
+  if (!hDevice || !au8Data || (u32Addr >= MMA845XQ_SIM_REGS)) return ESL_I2C_INVALID_ARGUMENT;
+  if (!mma845xsim_isDevice(hDevice)) return ESL_I2C_ACK_FAILURE;
+
+  (void)u32WaitTicks;
+  pthread_mutex_lock(&g_mtx);
+  mma845xsim_update();
+  for (i = 0; i < u8Len; ++i) {
+    au8Data[i] = mma845xsim_readReg(u8Addr);
+    u8Addr = mma845xsim_nextAddr(u8Addr);
+  }
+  mma845xsim_updatePins();                                                      // reading clears sources
+  pthread_mutex_unlock(&g_mtx);
+  return ESL_I2C_OK;
+}
+
+//******************************************************************************
+
+int esl_i2c_write (const ESL_I2C_TDevice   * poDevice,
+                   uint_32                   u32Addr,
+                   const uint_8            * au8Data,
+                   uint_8                    u8Len,
+                   uint_32                   u32WaitTicks)
+{
+  uint_8 u8Addr = (uint_8)u32Addr;
+  uint_8 i;
+
+  if (!poDevice || !au8Data || (u32Addr >= MMA845XQ_SIM_REGS)) return ESL_I2C_INVALID_ARGUMENT;
+  if (!mma845xsim_isDevice(poDevice)) return ESL_I2C_ACK_FAILURE;
+
+  (void)u32WaitTicks;
+  pthread_mutex_lock(&g_mtx);
+  mma845xsim_update();
+  for (i = 0; i < u8Len; ++i) {
+    mma845xsim_writeReg(u8Addr, au8Data[i]);
+    u8Addr = mma845xsim_nextAddr(u8Addr);
+  }
+  mma845xsim_updatePins();
+  pthread_mutex_unlock(&g_mtx);
+  return ESL_I2C_OK;
+}
+
+//******************************************************************************
+
+uint_8 esl_i2c_MMA845xQ_open (ESL_I2C_MMA845XQ_TDevice        * hAccelDevice,
+                              uint_8                            u8ChannelNo,
+                              uint_8                            u8DriverMode,
+                              uint_32                           u32BaudRate,
+                              uint_8                            u8SA0,
+                              const ESL_I2C_MMA845XQ_TConfig  * poConfig)
+{
+  ESL_I2C_MMA845XQ_TConfig oConfig;
+  uint_8                   ret;
+
+  if (!hAccelDevice) return ESL_I2C_INVALID_ARGUMENT;
+
+  memset(hAccelDevice, 0, sizeof(*hAccelDevice));
+  hAccelDevice->hI2CDevice.u8Addr         = ESL_I2C_MMA845XQ_SLAVE_ADDRESS(u8SA0);
+  hAccelDevice->hI2CDevice.u8RegAddrBytes = ESL_I2C_MMA845XQ_REG_ADDR_SIZE;
+  (void)u8ChannelNo; (void)u8DriverMode; (void)u32BaudRate;
+
+  ret = esl_i2c_MMA845xQ_reset(hAccelDevice);
+  if (ESL_I2C_OK != ret) return ret;
+  ret = mma845xsim_read(hAccelDevice, ESL_I2C_MMA845XQ_WHO_AM_I, &hAccelDevice->u8DeviceId, 1);
+  if (ESL_I2C_OK != ret) return ret;
+  if (!poConfig) {
+    esl_i2c_MMA845xQ_getDefaultConfig(&oConfig);
+    poConfig = &oConfig;
+  }
+  return esl_i2c_MMA845xQ_configure(hAccelDevice, poConfig);
+}
+
+//******************************************************************************
+
+uint_8 esl_i2c_MMA845xQ_close (ESL_I2C_MMA845XQ_TDevice * hAccelDevice)
+{
+  if (!hAccelDevice) return ESL_I2C_INVALID_ARGUMENT;
+  return esl_i2c_MMA845xQ_standby(hAccelDevice);
+}
+
+//******************************************************************************
+
+uint_8 esl_i2c_MMA845xQ_getDefaultConfig (ESL_I2C_MMA845XQ_TConfig * poConfig)
+{
+  if (!poConfig) return ESL_I2C_INVALID_ARGUMENT;
+
+  memset(poConfig, 0, sizeof(*poConfig));
+  poConfig->u8XyzDataCfg = ESL_I2C_MMA845XQ_XYZ_DATA_CFG_FS_VAL_2;
+  poConfig->u8CtrlReg1   = ESL_I2C_MMA845XQ_CTRL_REG1_DR_VAL_800;
+  poConfig->u8CtrlReg2   = ESL_I2C_MMA845XQ_CTRL_REG2_MODS_VAL_NORMAL;
+  return ESL_I2C_OK;
+}
+
+//******************************************************************************
+
+uint_8 esl_i2c_MMA845xQ_getConfig (ESL_I2C_MMA845XQ_TConfig       * poConfig,
+                                   const ESL_I2C_MMA845XQ_TDevice * hAccelDevice)
+{
+  if (!poConfig || !hAccelDevice) return ESL_I2C_INVALID_ARGUMENT;
+  *poConfig = hAccelDevice->oConfig;
+  return ESL_I2C_OK;
+}
+
+//******************************************************************************
+
+uint_8 esl_i2c_MMA845xQ_configure (ESL_I2C_MMA845XQ_TDevice       * hAccelDevice,
+                                   const ESL_I2C_MMA845XQ_TConfig * poConfig)
+{
+  static const uint_8 au8Regs[] = {
+    ESL_I2C_MMA845XQ_XYZ_DATA_CFG, ESL_I2C_MMA845XQ_PL_CFG,
+    ESL_I2C_MMA845XQ_CTRL_REG2,    ESL_I2C_MMA845XQ_CTRL_REG3,
+    ESL_I2C_MMA845XQ_CTRL_REG4,    ESL_I2C_MMA845XQ_CTRL_REG5,
+    ESL_I2C_MMA845XQ_CTRL_REG1,                                                 // last, it may activate the device
+  };
+  uint_8  au8Values[sizeof(au8Regs)];
+  uint_8  u8CtrlReg1;
+  uint_8  ret;
+  uint_32 i;
+
+  if (!hAccelDevice || !poConfig) return ESL_I2C_INVALID_ARGUMENT;
+
+  // the registers are written in the STANDBY mode, the mode is kept
+  ret = mma845xsim_read(hAccelDevice, ESL_I2C_MMA845XQ_CTRL_REG1, &u8CtrlReg1, 1);
+  if (ESL_I2C_OK != ret) return ret;
+  ret = esl_i2c_MMA845xQ_standby(hAccelDevice);
+  if (ESL_I2C_OK != ret) return ret;
+
+  au8Values[0] = poConfig->u8XyzDataCfg;
+  au8Values[1] = poConfig->u8PlCfg;
+  au8Values[2] = poConfig->u8CtrlReg2 & ~ESL_I2C_MMA845XQ_CTRL_REG2_RST_MASK;
+  au8Values[3] = poConfig->u8CtrlReg3;
+  au8Values[4] = poConfig->u8CtrlReg4;
+  au8Values[5] = poConfig->u8CtrlReg5;
+  au8Values[6] = (poConfig->u8CtrlReg1 & ~ESL_I2C_MMA845XQ_CTRL_REG1_ACTIVE_MASK)
+                 | (u8CtrlReg1 & ESL_I2C_MMA845XQ_CTRL_REG1_ACTIVE_MASK);
+  for (i = 0; i < sizeof(au8Regs); ++i) {
+    ret = mma845xsim_write(hAccelDevice, au8Regs[i], au8Values[i]);
+    if (ESL_I2C_OK != ret) return ret;
+  }
+
+  hAccelDevice->oConfig = *poConfig;
+  hAccelDevice->oConfig.u8CtrlReg1 &= ~ESL_I2C_MMA845XQ_CTRL_REG1_ACTIVE_MASK;
+  hAccelDevice->oConfig.u8CtrlReg2 &= ~ESL_I2C_MMA845XQ_CTRL_REG2_RST_MASK;
+  return ESL_I2C_OK;
+}
+
+//******************************************************************************
+
+uint_8 esl_i2c_MMA845xQ_activate (ESL_I2C_MMA845XQ_TDevice * hAccelDevice)
+{
+  uint_8 u8CtrlReg1;
+  uint_8 ret;
+
+  if (!hAccelDevice) return ESL_I2C_INVALID_ARGUMENT;
+  ret = mma845xsim_read(hAccelDevice, ESL_I2C_MMA845XQ_CTRL_REG1, &u8CtrlReg1, 1);
+  if (ESL_I2C_OK != ret) return ret;
+  return mma845xsim_write(hAccelDevice, ESL_I2C_MMA845XQ_CTRL_REG1,
+                          u8CtrlReg1 | ESL_I2C_MMA845XQ_CTRL_REG1_ACTIVE_MASK);
+}
+
+//******************************************************************************
+
+uint_8 esl_i2c_MMA845xQ_standby (ESL_I2C_MMA845XQ_TDevice * hAccelDevice)
+{
+  uint_8 u8CtrlReg1;
+  uint_8 ret;
+
+  if (!hAccelDevice) return ESL_I2C_INVALID_ARGUMENT;
+  ret = mma845xsim_read(hAccelDevice, ESL_I2C_MMA845XQ_CTRL_REG1, &u8CtrlReg1, 1);
+  if (ESL_I2C_OK != ret) return ret;
+  return mma845xsim_write(hAccelDevice, ESL_I2C_MMA845XQ_CTRL_REG1,
+                          u8CtrlReg1 & ~ESL_I2C_MMA845XQ_CTRL_REG1_ACTIVE_MASK);
+}
+
+//******************************************************************************
+
+uint_8 esl_i2c_MMA845xQ_reset (ESL_I2C_MMA845XQ_TDevice * hAccelDevice)
+{
+  uint_8 ret;
+
+  if (!hAccelDevice) return ESL_I2C_INVALID_ARGUMENT;
+  ret = mma845xsim_write(hAccelDevice, ESL_I2C_MMA845XQ_CTRL_REG2, ESL_I2C_MMA845XQ_CTRL_REG2_RST_MASK);
+  if (ESL_I2C_OK != ret) return ret;
+  return esl_i2c_MMA845xQ_getDefaultConfig(&hAccelDevice->oConfig);
+}
+
+//******************************************************************************
+
+uint_8 esl_i2c_MMA845xQ_getDeviceId (uint_8                   * pu8DeviceId,
+                                     ESL_I2C_MMA845XQ_TDevice * hAccelDevice)
+{
+  if (!pu8DeviceId || !hAccelDevice) return ESL_I2C_INVALID_ARGUMENT;
+  return mma845xsim_read(hAccelDevice, ESL_I2C_MMA845XQ_WHO_AM_I, pu8DeviceId, 1);
+}
+
+//******************************************************************************
+
+uint_8 esl_i2c_MMA845xQ_getRawData (int_16                    * pi16Data,
+                                    ESL_I2C_MMA845XQ_TDevice  * hAccelDevice)
+{
+  uint_8 au8Data[1 + MMA845X_SAMPLE_BYTES];
+  uint_8 ret;
+
+  if (!pi16Data || !hAccelDevice) return ESL_I2C_INVALID_ARGUMENT;
+
+  // STATUS and the data in one transfer
+  ret = mma845xsim_read(hAccelDevice, ESL_I2C_MMA845XQ_STATUS, au8Data, sizeof(au8Data));
+  if (ESL_I2C_OK != ret) return ret;
+  if (!(au8Data[0] & ESL_I2C_MMA845XQ_STATUS_ZYXDR_MASK)) return ESL_I2C_MMA845XQ_DATA_NOT_READY;
+
+  pi16Data[0] = (int_16)((au8Data[1] << 8) | au8Data[2]);
+  pi16Data[1] = (int_16)((au8Data[3] << 8) | au8Data[4]);
+  pi16Data[2] = (int_16)((au8Data[5] << 8) | au8Data[6]);
+  return ESL_I2C_OK;
+}
+
+//******************************************************************************
+
+uint_8 esl_i2c_MMA845xQ_raw2int (int_16                     * pi16IntData,
+                                 const int_16               * pi16RawData,
+                                 ESL_I2C_MMA845XQ_TDevice   * hAccelDevice)
+{
+  int i;
+
+  if (!pi16IntData || !pi16RawData || !hAccelDevice) return ESL_I2C_INVALID_ARGUMENT;
+  for (i = 0; i < 3; ++i) {
+    pi16IntData[i] = ESL_I2C_MMA845XQ_RAW2INT(pi16RawData[i], MMA845XQ_SIM_TYPE);
+  }
+  return ESL_I2C_OK;
+}
+
+//******************************************************************************
+
+uint_8 esl_i2c_MMA845xQ_raw2g (float                      * pfGData,
+                               const int_16               * pi16RawData,
+                               ESL_I2C_MMA845XQ_TDevice   * hAccelDevice)
+{
+  int iFs;
+  int iScale;
+  int i;
+
+  if (!pfGData || !pi16RawData || !hAccelDevice) return ESL_I2C_INVALID_ARGUMENT;
+  iFs    = (hAccelDevice->oConfig.u8XyzDataCfg & ESL_I2C_MMA845XQ_XYZ_DATA_CFG_FS_MASK)
+           >> ESL_I2C_MMA845XQ_XYZ_DATA_CFG_FS_SHIFT;
+  iScale = 2 << MIN(iFs, 2);
+  for (i = 0; i < 3; ++i) {
+    pfGData[i] = ESL_I2C_MMA845XQ_RAW2G((float)pi16RawData[i], iScale);
+  }
+  return ESL_I2C_OK;
+}
+
+//******************************************************************************
+// Private functions
+//******************************************************************************
+
+static void mma845xsim_update (void)
+{
+  MQX_TICK_STRUCT oNow;
+  uint_64         u64Due;
+  uint_8          u8FMode = g_au8Reg[MMA845X_F_SETUP] & MMA845X_F_SETUP_F_MODE_MASK;
+  uint_8        * pu8Dst;
+  float           afG[3];
+
+  if (!(g_au8Reg[ESL_I2C_MMA845XQ_CTRL_REG1] & ESL_I2C_MMA845XQ_CTRL_REG1_ACTIVE_MASK)) return;
+
+  _time_get_elapsed_ticks(&oNow);
+  u64Due = (oNow.USECS - g_oStart.USECS) / mma845xsim_period();
+  if ((u64Due > g_u64Produced + MMA845X_FIFO_SIZE)
+      && (MMA845X_F_SETUP_F_MODE_FILL != u8FMode)) {                            // the older ones would be overwritten
+    g_u64Produced = u64Due - MMA845X_FIFO_SIZE;
+    if (MMA845X_F_SETUP_F_MODE_OFF != u8FMode) g_bFifoOverflow = TRUE;
+  }
+
+  for (; g_u64Produced < u64Due; ++g_u64Produced) {
+    if (MMA845X_F_SETUP_F_MODE_OFF == u8FMode) {
+      pu8Dst = g_au8Out;
+      if (g_u8Status & MMA845XQ_SIM_DRDY_MASK) g_u8Status |= MMA845XQ_SIM_OW_MASK;
+      g_u8Status |= MMA845XQ_SIM_DRDY_MASK;
+    } else if (g_u32FifoCnt < MMA845X_FIFO_SIZE) {
+      pu8Dst = g_aau8Fifo[(g_u32FifoHead + g_u32FifoCnt++) % MMA845X_FIFO_SIZE];
+    } else if (MMA845X_F_SETUP_F_MODE_FILL == u8FMode) {                        // full, the new samples are dropped
+      g_bFifoOverflow = TRUE;
+      g_u64Produced = u64Due;
+      break;
+    } else {                                                                    // full, the oldest sample is dropped
+      g_bFifoOverflow = TRUE;
+      pu8Dst = g_aau8Fifo[g_u32FifoHead];
+      g_u32FifoHead = (g_u32FifoHead + 1) % MMA845X_FIFO_SIZE;
+    }
+    mma845xsim_sample(pu8Dst, afG, g_u64Produced);
+    mma845xsim_detect(afG);
+  }
+}
+
+//******************************************************************************
+
+static void mma845xsim_sample (uint_8 * pu8Dst, float * pfG, uint_64 u64Index)
+{
+  uint_64 u64Us = u64Index * mma845xsim_period();
+  float   fT    = (float)((double)u64Us / 1000000.0);
+  int_16  i16Raw;
+  int     iScale;
+  int     i;
+
+  pfG[0] = 0.05f * sinf(2.0f * (float)M_PI * 1.3f * fT);
+  pfG[1] = 0.03f * sinf(2.0f * (float)M_PI * 2.1f * fT + 1.0f);
+  pfG[2] = 1.0f + 0.02f * sinf(2.0f * (float)M_PI * 0.5f * fT);
+#if MMA845XQ_SIM_EVENTS
+  {
+    uint_64 u64Period = u64Us / MMA845XQ_SIM_EVENT_US;
+    uint_32 u32Phase  = (uint_32)(u64Us % MMA845XQ_SIM_EVENT_US);
+
+    if (   (u32Phase < MMA845XQ_SIM_TAP_US)
+        || ((u64Period & 1) && (u32Phase - MMA845XQ_SIM_TAP2_US < MMA845XQ_SIM_TAP_US))) {
+      pfG[0] += MMA845XQ_SIM_TAP_G;
+    }
+    if (((u64Period & 3) == 3) && (u32Phase - MMA845XQ_SIM_FALL_AT_US < MMA845XQ_SIM_FALL_US)) {
+      pfG[0] = pfG[1] = pfG[2] = 0.0f;
+    }
+  }
+#endif
+  iScale = mma845xsim_scale();
+  for (i = 0; i < 3; ++i) {
+    pfG[i] += MMA845XQ_SIM_NOISE * (2.0f * (float)rand() / (float)RAND_MAX - 1.0f);
+    i16Raw = mma845xsim_g2raw(pfG[i], iScale);
+    pu8Dst[2*i]     = (uint_8)((uint_16)i16Raw >> 8);
+    pu8Dst[2*i + 1] = (uint_8)i16Raw;
+  }
+}
+
+//******************************************************************************
+
+static void mma845xsim_detect (const float * pfG)
+{
+  uint_8  u8FfMtCfg     = g_au8Reg[ESL_I2C_MMA845XQ_FF_MT_CFG];
+  uint_8  u8TransCfg    = g_au8Reg[MMA845X_TRANSIENT_CFG];
+  uint_8  u8PulseCfg    = g_au8Reg[MMA845X_PULSE_CFG];
+  uint_8  u8Axes;
+  uint_8  u8Found;
+  uint_8  u8Negative;
+  uint_8  au8Ths[3];
+  float   afHigh[3];
+  uint_32 u32Steps      = mma845xsim_steps();
+  int     i;
+
+  for (i = 0; i < 3; ++i) {
+    afHigh[i]   = pfG[i] - g_afLow[i];
+    g_afLow[i] += afHigh[i] / MMA845XQ_SIM_HP_DIV;
+  }
+
+  // freefall (none of the axes above) or motion (any of them above)
+  u8Axes = (u8FfMtCfg >> MMA845X_FF_MT_CFG_EFE_SHIFT) & MCC_ACCEL_AXIS_ALL;
+  if (u8Axes) {
+    au8Ths[0] = au8Ths[1] = au8Ths[2] = g_au8Reg[MMA845X_FF_MT_THS];
+    u8Found = mma845xsim_above(pfG, au8Ths, u8Axes, &u8Negative);
+    if (u8FfMtCfg & MMA845X_FF_MT_CFG_OAE_MASK) {
+      if (mma845xsim_debounce(&g_u32FfMtCnt, u8Found ? TRUE : FALSE, g_au8Reg[MMA845X_FF_MT_COUNT], u32Steps)) {
+        g_u8FfMtSrc = MMA845X_FF_MT_SRC_EA_MASK | mma845xsim_srcAxes(u8Found, u8Negative);
+      }
+    } else if (mma845xsim_debounce(&g_u32FfMtCnt, u8Found ? FALSE : TRUE, g_au8Reg[MMA845X_FF_MT_COUNT], u32Steps)) {
+      g_u8FfMtSrc = MMA845X_FF_MT_SRC_EA_MASK;
+    }
+  }
+
+  // transient: the high-passed acceleration above
+  u8Axes = (u8TransCfg >> MMA845X_TRANSIENT_CFG_EFE_SHIFT) & MCC_ACCEL_AXIS_ALL;
+  if (u8Axes) {
+    au8Ths[0] = au8Ths[1] = au8Ths[2] = g_au8Reg[MMA845X_TRANSIENT_THS];
+    u8Found = mma845xsim_above((u8TransCfg & MMA845X_TRANSIENT_CFG_HPF_BYP_MASK) ? pfG : afHigh,
+                               au8Ths, u8Axes, &u8Negative);
+    if (mma845xsim_debounce(&g_u32TransientCnt, u8Found ? TRUE : FALSE, g_au8Reg[MMA845X_TRANSIENT_COUNT], u32Steps)) {
+      g_u8TransientSrc = MMA845X_TRANSIENT_SRC_EA_MASK | mma845xsim_srcAxes(u8Found, u8Negative);
+    }
+  }
+
+  // pulse: a short high-passed pulse, a second one within the window
+  u8Axes = (((u8PulseCfg >> 0) & 0x03) ? MCC_ACCEL_AXIS_X : 0)
+           | (((u8PulseCfg >> 2) & 0x03) ? MCC_ACCEL_AXIS_Y : 0)
+           | (((u8PulseCfg >> 4) & 0x03) ? MCC_ACCEL_AXIS_Z : 0);
+  if (!u8Axes) return;
+  u8Found = mma845xsim_above(afHigh, &g_au8Reg[MMA845X_PULSE_THSX], u8Axes, &u8Negative);
+  g_u32PulseCnt += u32Steps;
+  switch (g_u8PulseState) {
+  case MMA845XQ_SIM_PULSE_HIGH:
+    g_u8PulseAxes     |= u8Found;
+    g_u8PulseNegative |= u8Negative;
+    if (!u8Found) {
+      mma845xsim_endPulse();
+    } else if (2 * g_u32PulseCnt > g_au8Reg[MMA845X_PULSE_THSX + 3]) {          // PULSE_TMLT, in half steps
+      g_u8PulseState = MMA845XQ_SIM_PULSE_LONG;
+    }
+    break;
+
+  case MMA845XQ_SIM_PULSE_LONG:
+    if (!u8Found) g_u8PulseState = MMA845XQ_SIM_PULSE_IDLE;
+    break;
+
+  case MMA845XQ_SIM_PULSE_LATENCY:
+    if (g_u32PulseCnt >= g_au8Reg[MMA845X_PULSE_THSX + 4]) {                    // PULSE_LTCY
+      g_u8PulseState = MMA845XQ_SIM_PULSE_WINDOW;
+      g_u32PulseCnt  = 0;
+    }
+    break;
+
+  default:
+    if ((MMA845XQ_SIM_PULSE_WINDOW == g_u8PulseState)
+        && (g_u32PulseCnt > g_au8Reg[MMA845X_PULSE_THSX + 5])) {                // PULSE_WIND
+      g_u8PulseState = MMA845XQ_SIM_PULSE_IDLE;
+    }
+    if (u8Found) {
+      g_bPulseSecond    = (MMA845XQ_SIM_PULSE_WINDOW == g_u8PulseState) ? TRUE : FALSE;
+      g_u8PulseState    = MMA845XQ_SIM_PULSE_HIGH;
+      g_u32PulseCnt     = 0;
+      g_u8PulseAxes     = u8Found;
+      g_u8PulseNegative = u8Negative;
+    }
+    break;
+  }
+}
+
+//******************************************************************************
+
+static boolean mma845xsim_debounce (uint_32 * pu32Cnt, boolean bCond, uint_8 u8Count, uint_32 u32Steps)
+{
+  if (!bCond) {                                                                 // DBCNTM set, the counter clears
+    *pu32Cnt = 0;
+    return FALSE;
+  }
+  if (*pu32Cnt > u8Count) return FALSE;                                         // raised already
+  *pu32Cnt += u32Steps;
+  return (*pu32Cnt > u8Count) ? TRUE : FALSE;
+}
+
+//******************************************************************************
+
+static uint_8 mma845xsim_above (const float * pfG, const uint_8 * pu8Ths, uint_8 u8Axes, uint_8 * pu8Negative)
+{
+  uint_8  u8Found = 0;
+  int     i;
+
+  *pu8Negative = 0;
+  for (i = 0; i < 3; ++i) {
+    float fThs = (pu8Ths[i] & 0x7F) * MMA845XQ_SIM_THS_G;
+
+    if (!(u8Axes & (1 << i))) continue;
+    if (pfG[i] > fThs) {
+      u8Found |= (uint_8)(1 << i);
+    } else if (pfG[i] < -fThs) {
+      u8Found      |= (uint_8)(1 << i);
+      *pu8Negative |= (uint_8)(1 << i);
+    }
+  }
+  return u8Found;
+}
+
+//******************************************************************************
+
+static uint_8 mma845xsim_srcAxes (uint_8 u8Axes, uint_8 u8Negative)
+{
+  uint_8  u8Src = 0;
+  int     i;
+
+  for (i = 0; i < 3; ++i) {                                                     // XHP, XHE, YHP, YHE, ZHP, ZHE
+    if (u8Axes & (1 << i))     u8Src |= (uint_8)(2 << (2 * i));
+    if (u8Negative & (1 << i)) u8Src |= (uint_8)(1 << (2 * i));
+  }
+  return u8Src;
+}
+
+//******************************************************************************
+
+static void mma845xsim_endPulse (void)
+{
+  uint_8  u8PulseCfg = g_au8Reg[MMA845X_PULSE_CFG];
+  uint_8  u8Single   = 0;
+  uint_8  u8Double   = 0;
+  uint_8  u8Src;
+  int     i;
+
+  for (i = 0; i < 3; ++i) {                                                     // XSPEFE, XDPEFE, YSPEFE, ...
+    if (u8PulseCfg & (1 << (2 * i)))     u8Single |= (uint_8)(1 << i);
+    if (u8PulseCfg & (2 << (2 * i)))     u8Double |= (uint_8)(1 << i);
+  }
+  u8Src = (uint_8)(MMA845X_PULSE_SRC_EA_MASK | (g_u8PulseAxes << MMA845X_PULSE_SRC_AX_SHIFT)
+                   | (g_u8PulseNegative << MMA845X_PULSE_SRC_POL_SHIFT));
+  if (g_bPulseSecond && (g_u8PulseAxes & u8Double)) {                           // the sequence is complete
+    g_u8PulseSrc   = u8Src | MMA845X_PULSE_SRC_DPE_MASK;
+    g_u8PulseState = MMA845XQ_SIM_PULSE_IDLE;
+    return;
+  }
+  if (g_u8PulseAxes & u8Single) g_u8PulseSrc = u8Src;
+  g_u8PulseState = (g_u8PulseAxes & u8Double) ? MMA845XQ_SIM_PULSE_LATENCY : MMA845XQ_SIM_PULSE_IDLE;
+  g_u32PulseCnt  = 0;
+}
+
+//******************************************************************************
+
+static void mma845xsim_resetEvents (void)
+{
+  memset(g_afLow, 0, sizeof(g_afLow));
+  g_afLow[2]        = 1.0f;                                                     // at rest
+  g_u32FfMtCnt      = 0;
+  g_u32TransientCnt = 0;
+  g_u8PulseState    = MMA845XQ_SIM_PULSE_IDLE;
+  g_u32PulseCnt     = 0;
+  g_u8FfMtSrc       = 0;
+  g_u8TransientSrc  = 0;
+  g_u8PulseSrc      = 0;
+}
+
+//******************************************************************************
+
+static uint_8 mma845xsim_readReg (uint_8 u8Addr)
+{
+  uint_8 u8FSetup = g_au8Reg[MMA845X_F_SETUP];
+  uint_8 u8Wmrk   = u8FSetup & MMA845X_F_SETUP_F_WMRK_MASK;
+  uint_8 u8Value;
+
+  switch (u8Addr) {
+  case ESL_I2C_MMA845XQ_STATUS:
+    if (MMA845X_F_SETUP_F_MODE_OFF == (u8FSetup & MMA845X_F_SETUP_F_MODE_MASK)) return g_u8Status;
+    u8Value = (uint_8)g_u32FifoCnt;
+    if (g_bFifoOverflow) u8Value |= MMA845X_F_STATUS_F_OVF_MASK;
+    if (u8Wmrk && (g_u32FifoCnt >= u8Wmrk)) u8Value |= MMA845X_F_STATUS_F_WMRK_MASK;
+    g_bFifoOverflow = FALSE;
+    return u8Value;
+
+  case ESL_I2C_MMA845XQ_OUT_X_MSB: case ESL_I2C_MMA845XQ_OUT_X_LSB:
+  case ESL_I2C_MMA845XQ_OUT_Y_MSB: case ESL_I2C_MMA845XQ_OUT_Y_LSB:
+  case ESL_I2C_MMA845XQ_OUT_Z_MSB: case ESL_I2C_MMA845XQ_OUT_Z_LSB:
+    if (MMA845X_F_SETUP_F_MODE_OFF == (u8FSetup & MMA845X_F_SETUP_F_MODE_MASK)) {
+      if (ESL_I2C_MMA845XQ_OUT_Z_LSB == u8Addr) g_u8Status = 0;                 // the sample has been read
+      return g_au8Out[u8Addr - ESL_I2C_MMA845XQ_OUT_X_MSB];
+    }
+    if (!g_u32FifoCnt) return 0;
+    u8Value = g_aau8Fifo[g_u32FifoHead][u8Addr - ESL_I2C_MMA845XQ_OUT_X_MSB];
+    if (ESL_I2C_MMA845XQ_OUT_Z_LSB == u8Addr) {                                 // pop the sample read
+      g_u32FifoHead = (g_u32FifoHead + 1) % MMA845X_FIFO_SIZE;
+      --g_u32FifoCnt;
+    }
+    return u8Value;
+
+  case ESL_I2C_MMA845XQ_SYSMOD:
+    return (g_au8Reg[ESL_I2C_MMA845XQ_CTRL_REG1] & ESL_I2C_MMA845XQ_CTRL_REG1_ACTIVE_MASK) ? 0x01 : 0x00;
+
+  case ESL_I2C_MMA845XQ_INT_SOURCE:
+    u8Value = 0;
+    if (g_u8Status & ESL_I2C_MMA845XQ_STATUS_ZYXDR_MASK) u8Value |= MMA845X_INT_SOURCE_DRDY_MASK;
+    if (g_bFifoOverflow || (u8Wmrk && (g_u32FifoCnt >= u8Wmrk))) u8Value |= MMA845X_INT_SOURCE_FIFO_MASK;
+    if (g_u8FfMtSrc)      u8Value |= MMA845X_INT_SOURCE_FF_MT_MASK;
+    if (g_u8TransientSrc) u8Value |= MMA845X_INT_SOURCE_TRANS_MASK;
+    if (g_u8PulseSrc)     u8Value |= MMA845X_INT_SOURCE_PULSE_MASK;
+    return u8Value & g_au8Reg[ESL_I2C_MMA845XQ_CTRL_REG4];                      // enabled sources only
+
+  case ESL_I2C_MMA845XQ_FF_MT_SRC:                                              // the latched events clear by reading
+    u8Value = g_u8FfMtSrc;
+    g_u8FfMtSrc = 0;
+    return u8Value;
+
+  case MMA845X_TRANSIENT_SRC:
+    u8Value = g_u8TransientSrc;
+    g_u8TransientSrc = 0;
+    return u8Value;
+
+  case MMA845X_PULSE_SRC:
+    u8Value = g_u8PulseSrc;
+    g_u8PulseSrc = 0;
+    return u8Value;
+
+  default:
+    return g_au8Reg[u8Addr];
+  }
+}
+
+//******************************************************************************
+
+static void mma845xsim_writeReg (uint_8 u8Addr, uint_8 u8Value)
+{
+  boolean bActive = (g_au8Reg[ESL_I2C_MMA845XQ_CTRL_REG1] & ESL_I2C_MMA845XQ_CTRL_REG1_ACTIVE_MASK) ? TRUE : FALSE;
+
+  switch (u8Addr) {
+  case ESL_I2C_MMA845XQ_CTRL_REG1:
+    if (!bActive && (u8Value & ESL_I2C_MMA845XQ_CTRL_REG1_ACTIVE_MASK)) {       // STANDBY -> ACTIVE
+      _time_get_elapsed_ticks(&g_oStart);
+      g_u64Produced   = 0;
+      g_u32FifoCnt    = 0;
+      g_bFifoOverflow = FALSE;
+      g_u8Status      = 0;
+      mma845xsim_resetEvents();
+      mma845xsim_startPinThread();
+    }
+    if (bActive) {                                                              // only ACTIVE may change
+      u8Value = (g_au8Reg[u8Addr] & ~ESL_I2C_MMA845XQ_CTRL_REG1_ACTIVE_MASK)
+                | (u8Value & ESL_I2C_MMA845XQ_CTRL_REG1_ACTIVE_MASK);
+    }
+    g_au8Reg[u8Addr] = u8Value;
+    if (g_bPinThread) pthread_cond_signal(&g_oPinCond);
+    break;
+
+  case ESL_I2C_MMA845XQ_CTRL_REG2:
+    if (u8Value & ESL_I2C_MMA845XQ_CTRL_REG2_RST_MASK) {
+      mma845xsim_resetRegs();
+    } else if (!bActive) {
+      g_au8Reg[u8Addr] = u8Value;
+    }
+    break;
+
+  case MMA845X_F_SETUP:
+    if (bActive) break;
+    if ((u8Value ^ g_au8Reg[u8Addr]) & MMA845X_F_SETUP_F_MODE_MASK) {           // flushed by a mode change
+      g_u32FifoCnt    = 0;
+      g_bFifoOverflow = FALSE;
+    }
+    g_au8Reg[u8Addr] = u8Value;
+    break;
+
+  case ESL_I2C_MMA845XQ_CTRL_REG4:
+    if (bActive) break;
+    g_au8Reg[u8Addr] = u8Value;
+    if (g_bPinThread) pthread_cond_signal(&g_oPinCond);
+    break;
+
+  case ESL_I2C_MMA845XQ_STATUS:
+  case ESL_I2C_MMA845XQ_OUT_X_MSB: case ESL_I2C_MMA845XQ_OUT_X_LSB:
+  case ESL_I2C_MMA845XQ_OUT_Y_MSB: case ESL_I2C_MMA845XQ_OUT_Y_LSB:
+  case ESL_I2C_MMA845XQ_OUT_Z_MSB: case ESL_I2C_MMA845XQ_OUT_Z_LSB:
+  case ESL_I2C_MMA845XQ_SYSMOD:
+  case ESL_I2C_MMA845XQ_INT_SOURCE:
+  case ESL_I2C_MMA845XQ_WHO_AM_I:
+  case ESL_I2C_MMA845XQ_PL_STATUS:
+  case ESL_I2C_MMA845XQ_FF_MT_SRC:
+  case MMA845X_TRANSIENT_SRC:
+  case MMA845X_PULSE_SRC:
+    break;                                                                      // read only
+
+  default:
+    if (!bActive) g_au8Reg[u8Addr] = u8Value;
+    break;
+  }
+}
+
+//******************************************************************************
+
+static uint_8 mma845xsim_nextAddr (uint_8 u8Addr)
+{
+  if ((ESL_I2C_MMA845XQ_OUT_Z_LSB == u8Addr)
+      && (g_au8Reg[MMA845X_F_SETUP] & MMA845X_F_SETUP_F_MODE_MASK)) {
+    return ESL_I2C_MMA845XQ_OUT_X_MSB;                                          // burst read of the FIFO
+  }
+  return (u8Addr + 1 < MMA845XQ_SIM_REGS) ? u8Addr + 1 : 0;
+}
+
+//******************************************************************************
+
+static void mma845xsim_resetRegs (void)
+{
+  memset(g_au8Reg, 0, sizeof(g_au8Reg));
+  g_au8Reg[ESL_I2C_MMA845XQ_WHO_AM_I] = ESL_I2C_MMA845XQ_DEVICE_ID(MMA845XQ_SIM_TYPE);
+  g_au8Reg[ESL_I2C_MMA845XQ_PL_CFG]   = ESL_I2C_MMA845XQ_PL_CFG_DBCNTM_MASK;
+  memset(g_au8Out, 0, sizeof(g_au8Out));
+  g_u8Status      = 0;
+  g_u32FifoHead   = 0;
+  g_u32FifoCnt    = 0;
+  g_bFifoOverflow = FALSE;
+  mma845xsim_resetEvents();
+}
+
+//******************************************************************************
+
+static void mma845xsim_updatePins (void)
+{
+  uint_8  u8Src  = mma845xsim_readReg(ESL_I2C_MMA845XQ_INT_SOURCE) & MMA845XQ_SIM_PIN_SRC_MASK;
+  uint_8  u8Int1 = g_au8Reg[ESL_I2C_MMA845XQ_CTRL_REG5];                        // 1: INT1, 0: INT2
+  boolean bIpol  = (g_au8Reg[ESL_I2C_MMA845XQ_CTRL_REG3] & ESL_I2C_MMA845XQ_CTRL_REG3_IPOL_MASK) ? TRUE : FALSE;
+
+  lwgpio_sim_drive(BSP_GPIO_ACCEL_INT1, (u8Src & u8Int1) ? bIpol : !bIpol);
+  lwgpio_sim_drive(BSP_GPIO_ACCEL_INT2, (u8Src & ~u8Int1) ? bIpol : !bIpol);
+}
+
+//******************************************************************************
+
+static void mma845xsim_startPinThread (void)
+{
+  pthread_condattr_t oAttr;
+  pthread_t          oThread;
+
+  if (g_bPinThread) return;
+  pthread_condattr_init(&oAttr);
+  pthread_condattr_setclock(&oAttr, CLOCK_MONOTONIC);                           // the clock of _time_get_elapsed_ticks()
+  pthread_cond_init(&g_oPinCond, &oAttr);
+  pthread_condattr_destroy(&oAttr);
+  if (pthread_create(&oThread, NULL, mma845xsim_pinThread, NULL)) return;
+  pthread_detach(oThread);
+  g_bPinThread = TRUE;
+}
+
+//******************************************************************************
+
+static void * mma845xsim_pinThread (void * pvArg)
+{
+  struct timespec oDue;
+  uint_64         u64DueUs;
+
+  (void)pvArg;
+  pthread_mutex_lock(&g_mtx);
+  for (;;) {
+    if (!(g_au8Reg[ESL_I2C_MMA845XQ_CTRL_REG1] & ESL_I2C_MMA845XQ_CTRL_REG1_ACTIVE_MASK)
+        || !(g_au8Reg[ESL_I2C_MMA845XQ_CTRL_REG4] & MMA845XQ_SIM_PIN_SRC_MASK)) {
+      pthread_cond_wait(&g_oPinCond, &g_mtx);
+      continue;
+    }
+    u64DueUs = g_oStart.USECS + (g_u64Produced + 1) * mma845xsim_period();
+    oDue.tv_sec  = (time_t)(u64DueUs / 1000000u);
+    oDue.tv_nsec = (long)(u64DueUs % 1000000u) * 1000;
+    pthread_cond_timedwait(&g_oPinCond, &g_mtx, &oDue);
+    mma845xsim_update();
+    mma845xsim_updatePins();
+  }
+  return NULL;
+}
+
+//******************************************************************************
+
+static uint_32 mma845xsim_period (void)
+{
+  static const uint_32 au32Period[8] = {                                        // 800, 400, 200, 100, 50, 12.5, 6.25, 1.56 Hz
+    1250, 2500, 5000, 10000, 20000, 80000, 160000, 640000
+  };
+
+  return au32Period[(g_au8Reg[ESL_I2C_MMA845XQ_CTRL_REG1] & ESL_I2C_MMA845XQ_CTRL_REG1_DR_MASK)
+                    >> ESL_I2C_MMA845XQ_CTRL_REG1_DR_SHIFT];
+}
+
+//******************************************************************************
+
+static uint_32 mma845xsim_steps (void)
+{
+  static const uint_32 aau32Step[4][8] = {                                      // 800, 400, 200, 100, 50, 12.5, 6.25, 1.56 Hz
+    { 1250, 2500, 5000, 10000, 20000, 20000,  20000,  20000 },                  // normal
+    { 1250, 2500, 5000, 10000, 20000, 80000,  80000,  80000 },                  // low noise low power
+    { 1250, 2500, 2500,  2500,  2500,  2500,   2500,   2500 },                  // high resolution
+    { 1250, 2500, 5000, 10000, 20000, 80000, 160000, 640000 },                  // low power
+  };
+  uint_32 u32Step = aau32Step[(g_au8Reg[ESL_I2C_MMA845XQ_CTRL_REG2] & ESL_I2C_MMA845XQ_CTRL_REG2_MODS_MASK)
+                              >> ESL_I2C_MMA845XQ_CTRL_REG2_MODS_SHIFT]
+                             [(g_au8Reg[ESL_I2C_MMA845XQ_CTRL_REG1] & ESL_I2C_MMA845XQ_CTRL_REG1_DR_MASK)
+                              >> ESL_I2C_MMA845XQ_CTRL_REG1_DR_SHIFT];
+
+  return MAX(mma845xsim_period() / u32Step, 1);
+}
+
+//******************************************************************************
+
+static int mma845xsim_scale (void)
+{
+  int iFs = (g_au8Reg[ESL_I2C_MMA845XQ_XYZ_DATA_CFG] & ESL_I2C_MMA845XQ_XYZ_DATA_CFG_FS_MASK)
+            >> ESL_I2C_MMA845XQ_XYZ_DATA_CFG_FS_SHIFT;
+
+  return 2 << MIN(iFs, 2);
+}
+
+//******************************************************************************
+
+static int_16 mma845xsim_g2raw (float fG, int iScale)
+{
+  float fRaw = fG * (float)ESL_I2C_MMA845XQ_RAW2G_DIVIDER(iScale);
+
+  if (fRaw >  32767.0f) fRaw =  32767.0f;
+  if (fRaw < -32768.0f) fRaw = -32768.0f;
+  return (int_16)((int)fRaw & ~((1 << (16 - ESL_I2C_MMA845XQ_DATA_RESOLUTION(MMA845XQ_SIM_TYPE))) - 1));
+}
+
+//******************************************************************************
+
+static boolean mma845xsim_isDevice (const ESL_I2C_TDevice * poDevice)
+{
+  return ((poDevice->u8Addr == ESL_I2C_MMA845XQ_SLAVE_ADDRESS(0))
+          || (poDevice->u8Addr == ESL_I2C_MMA845XQ_SLAVE_ADDRESS(1))) ? TRUE : FALSE;
+}
+
+//******************************************************************************
+
+static uint_8 mma845xsim_read (ESL_I2C_MMA845XQ_TDevice * hAccelDevice, uint_8 u8Addr, uint_8 * pu8Data, uint_8 u8Len)
+{
+  return (uint_8)esl_i2c_read(&hAccelDevice->hI2CDevice, u8Addr, pu8Data, u8Len,
+                              hAccelDevice->oConfig.u32WaitTicks);
+}
+
+//******************************************************************************
+
+static uint_8 mma845xsim_write (ESL_I2C_MMA845XQ_TDevice * hAccelDevice, uint_8 u8Addr, uint_8 u8Value)
+{
+  return (uint_8)esl_i2c_write(&hAccelDevice->hI2CDevice, u8Addr, &u8Value, 1,
+                               hAccelDevice->oConfig.u32WaitTicks);
+}
+
+//******************************************************************************
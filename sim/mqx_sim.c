@@ -0,0 +1,299 @@
+/** ****************************************************************************
+ *
+ *  @file       mqx_sim.c
+ *  @brief      MQX kernel services for the host M4 simulator.
+ *
+ *  Time, light-weight semaphores and light-weight events implemented on top
+ *  of POSIX threads and the monotonic clock.
+ *
+ *  @copyright  Elnico Ltd. All rights reserved.
+ *
+ ******************************************************************************/
+/*
+ *  THIS SOFTWARE IS PROVIDED BY ELNICO "AS IS" AND ANY EXPRESSED OR
+ *  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ *  OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ *  IN NO EVENT SHALL ELNICO OR ITS CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ *  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ *  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ *  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ *  IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ *  THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************/
+
+#include <mqx.h>
+#include <bsp.h>
+#include <lwevent.h>
+
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+
+//******************************************************************************
+// Functions declarations
+//******************************************************************************
+
+/** Computes the absolute CLOCK_MONOTONIC deadline given number of ticks ahead.
+ * @param[out]  poDeadline  Deadline will be stored here.
+ * @param[in]   uTicks      Number of MQX ticks (BSP_ALARM_RESOLUTION ms each). */
+static void mqxsim_deadline (struct timespec * poDeadline, _mqx_uint uTicks);
+
+/** Initializes a mutex and a condition variable using the monotonic clock.
+ * @return      MQX_OK on success, MQX_INVALID_PARAMETER otherwise. */
+static _mqx_uint mqxsim_initSync (pthread_mutex_t * poMtx, pthread_cond_t * poCond);
+
+/** Records the simulator start, the "boot" _time_get_elapsed() counts from. */
+static void mqxsim_boot (void) __attribute__((constructor));
+
+//******************************************************************************
+// Globals
+//******************************************************************************
+static uint_64 g_u64BootUsecs;                                                  //!< _time_get_elapsed_ticks() at the simulator start.
+static __thread _mqx_uint g_uSignalled;                                         //!< Events that ended the last _lwevent_wait_ticks() of the task.
+
+//******************************************************************************
+//******************************************************************************
+//******************************************************************************
+
+void _time_get_elapsed_ticks (MQX_TICK_STRUCT * poTicks)
+{
+  struct timespec oNow;
+
+  clock_gettime(CLOCK_MONOTONIC, &oNow);
+  poTicks->USECS = (uint_64)oNow.tv_sec * 1000000u + (uint_64)oNow.tv_nsec / 1000u;
+}
+
+//******************************************************************************
+
+static void mqxsim_boot (void)
+{
+  MQX_TICK_STRUCT oNow;
+
+  _time_get_elapsed_ticks(&oNow);
+  g_u64BootUsecs = oNow.USECS;
+}
+
+//******************************************************************************
+
+void _time_get_elapsed (TIME_STRUCT * poTime)
+{
+  MQX_TICK_STRUCT oNow;
+
+  _time_get_elapsed_ticks(&oNow);
+  oNow.USECS -= g_u64BootUsecs;                                                 // since the boot, as on the M4
+  poTime->SECONDS      = (uint_32)(oNow.USECS / 1000000u);
+  poTime->MILLISECONDS = (uint_32)(oNow.USECS % 1000000u / 1000u);
+}
+
+//******************************************************************************
+
+MQX_TICK_STRUCT * _time_add_msec_to_ticks (MQX_TICK_STRUCT * poTicks, _mqx_uint uMsecs)
+{
+  poTicks->USECS += (uint_64)uMsecs * 1000u;
+  return poTicks;
+}
+
+//******************************************************************************
+
+int_32 _time_diff_microseconds (MQX_TICK_STRUCT * poEnd, MQX_TICK_STRUCT * poStart, boolean * pbOverflow)
+{
+  int_64 i64Diff = (int_64)(poEnd->USECS - poStart->USECS);
+
+  *pbOverflow = (i64Diff > INT32_MAX) || (i64Diff < INT32_MIN);
+  return (int_32)i64Diff;
+}
+
+//******************************************************************************
+
+int_32 _time_diff_milliseconds (MQX_TICK_STRUCT * poEnd, MQX_TICK_STRUCT * poStart, boolean * pbOverflow)
+{
+  int_64 i64Diff = (int_64)(poEnd->USECS - poStart->USECS) / 1000;
+
+  *pbOverflow = (i64Diff > INT32_MAX) || (i64Diff < INT32_MIN);
+  return (int_32)i64Diff;
+}
+
+//******************************************************************************
+
+void _time_delay (uint_32 u32Msecs)
+{
+  struct timespec oDelay;
+
+  oDelay.tv_sec  = u32Msecs / 1000;
+  oDelay.tv_nsec = (long)(u32Msecs % 1000) * 1000000L;
+  while (nanosleep(&oDelay, &oDelay) < 0 && EINTR == errno) ;
+}
+
+//******************************************************************************
+
+void _time_delay_ticks (uint_32 u32Ticks)
+{
+  _time_delay(u32Ticks * BSP_ALARM_RESOLUTION);
+}
+
+//******************************************************************************
+
+void _task_block (void)
+{
+  while (1) pause();
+}
+
+//******************************************************************************
+
+_mqx_uint _lwsem_create (LWSEM_STRUCT * poSem, _mqx_int iInitial)
+{
+  poSem->VALUE = iInitial;
+  return mqxsim_initSync(&poSem->mtx, &poSem->cond);
+}
+
+//******************************************************************************
+
+_mqx_uint _lwsem_destroy (LWSEM_STRUCT * poSem)
+{
+  pthread_cond_destroy(&poSem->cond);
+  pthread_mutex_destroy(&poSem->mtx);
+  return MQX_OK;
+}
+
+//******************************************************************************
+
+_mqx_uint _lwsem_wait_ticks (LWSEM_STRUCT * poSem, _mqx_uint uTicks)
+{
+  struct timespec oDeadline;
+  _mqx_uint       ret = MQX_OK;
+
+  mqxsim_deadline(&oDeadline, uTicks);
+  pthread_mutex_lock(&poSem->mtx);
+  while (poSem->VALUE <= 0) {
+    if (0 == uTicks) {                                                          // infinite wait
+      pthread_cond_wait(&poSem->cond, &poSem->mtx);
+    } else if (ETIMEDOUT == pthread_cond_timedwait(&poSem->cond, &poSem->mtx, &oDeadline)) {
+      ret = MQX_LWSEM_WAIT_TIMEOUT;
+      break;
+    }
+  }
+  if (MQX_OK == ret) --poSem->VALUE;
+  pthread_mutex_unlock(&poSem->mtx);
+
+  return ret;
+}
+
+//******************************************************************************
+
+_mqx_uint _lwsem_post (LWSEM_STRUCT * poSem)
+{
+  pthread_mutex_lock(&poSem->mtx);
+  ++poSem->VALUE;
+  pthread_cond_signal(&poSem->cond);
+  pthread_mutex_unlock(&poSem->mtx);
+  return MQX_OK;
+}
+
+//******************************************************************************
+
+_mqx_uint _lwevent_create (LWEVENT_STRUCT * poEvent, _mqx_uint uFlags)
+{
+  poEvent->VALUE = 0;
+  poEvent->FLAGS = uFlags;
+  return mqxsim_initSync(&poEvent->mtx, &poEvent->cond);
+}
+
+//******************************************************************************
+
+_mqx_uint _lwevent_destroy (LWEVENT_STRUCT * poEvent)
+{
+  pthread_cond_destroy(&poEvent->cond);
+  pthread_mutex_destroy(&poEvent->mtx);
+  return MQX_OK;
+}
+
+//******************************************************************************
+
+_mqx_uint _lwevent_set (LWEVENT_STRUCT * poEvent, _mqx_uint uMask)
+{
+  pthread_mutex_lock(&poEvent->mtx);
+  poEvent->VALUE |= uMask;
+  pthread_cond_broadcast(&poEvent->cond);
+  pthread_mutex_unlock(&poEvent->mtx);
+  return MQX_OK;
+}
+
+//******************************************************************************
+
+_mqx_uint _lwevent_clear (LWEVENT_STRUCT * poEvent, _mqx_uint uMask)
+{
+  pthread_mutex_lock(&poEvent->mtx);
+  poEvent->VALUE &= ~uMask;
+  pthread_mutex_unlock(&poEvent->mtx);
+  return MQX_OK;
+}
+
+//******************************************************************************
+
+_mqx_uint _lwevent_wait_ticks (LWEVENT_STRUCT * poEvent, _mqx_uint uMask, boolean bAll, _mqx_uint uTicks)
+{
+  struct timespec oDeadline;
+  _mqx_uint       ret = MQX_OK;
+
+  mqxsim_deadline(&oDeadline, uTicks);
+  pthread_mutex_lock(&poEvent->mtx);
+  while (bAll ? ((poEvent->VALUE & uMask) != uMask) : !(poEvent->VALUE & uMask)) {
+    if (0 == uTicks) {                                                          // infinite wait
+      pthread_cond_wait(&poEvent->cond, &poEvent->mtx);
+    } else if (ETIMEDOUT == pthread_cond_timedwait(&poEvent->cond, &poEvent->mtx, &oDeadline)) {
+      ret = LWEVENT_WAIT_TIMEOUT;
+      break;
+    }
+  }
+  g_uSignalled = (MQX_OK == ret) ? (poEvent->VALUE & uMask) : 0;
+  if ((MQX_OK == ret) && (poEvent->FLAGS & LWEVENT_AUTO_CLEAR)) {
+    poEvent->VALUE &= ~uMask;
+  }
+  pthread_mutex_unlock(&poEvent->mtx);
+
+  return ret;
+}
+
+//******************************************************************************
+
+_mqx_uint _lwevent_get_signalled (void)
+{
+  return g_uSignalled;
+}
+
+//******************************************************************************
+// Private functions
+//******************************************************************************
+
+static void mqxsim_deadline (struct timespec * poDeadline, _mqx_uint uTicks)
+{
+  uint_64 u64Nsecs;
+
+  clock_gettime(CLOCK_MONOTONIC, poDeadline);
+  u64Nsecs = (uint_64)poDeadline->tv_nsec + (uint_64)uTicks * BSP_ALARM_RESOLUTION * 1000000u;
+  poDeadline->tv_sec  += (time_t)(u64Nsecs / 1000000000u);
+  poDeadline->tv_nsec  = (long)(u64Nsecs % 1000000000u);
+}
+
+//******************************************************************************
+
+static _mqx_uint mqxsim_initSync (pthread_mutex_t * poMtx, pthread_cond_t * poCond)
+{
+  pthread_condattr_t oAttr;
+
+  if (pthread_mutex_init(poMtx, NULL)) return MQX_INVALID_PARAMETER;
+  pthread_condattr_init(&oAttr);
+  pthread_condattr_setclock(&oAttr, CLOCK_MONOTONIC);
+  if (pthread_cond_init(poCond, &oAttr)) {
+    pthread_condattr_destroy(&oAttr);
+    pthread_mutex_destroy(poMtx);
+    return MQX_INVALID_PARAMETER;
+  }
+  pthread_condattr_destroy(&oAttr);
+  return MQX_OK;
+}
+
+//******************************************************************************
@@ -0,0 +1,92 @@
+/** ****************************************************************************
+ *
+ *  @file       shm_sim.c
+ *  @brief      Shared memory for the host M4 simulator.
+ *
+ *  The on-chip memory shared by the A5 and the M4 at MCC_SNAPSHOT_ADDRESS is
+ *  a POSIX shared memory object named MCC_SIM_SNAPSHOT_NAME on the host. The
+ *  Linux side maps it through CMccTransportSocket (see linux/CMccTransport.h).
+ *
+ *  @copyright  Elnico Ltd. All rights reserved.
+ *
+ ******************************************************************************/
+/*
+ *  THIS SOFTWARE IS PROVIDED BY ELNICO "AS IS" AND ANY EXPRESSED OR
+ *  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ *  OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ *  IN NO EVENT SHALL ELNICO OR ITS CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ *  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ *  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ *  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ *  IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ *  THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************/
+
+#include "easyduo_mcc_common.h"
+
+#include "esl_log.h"
+
+#include <bsp.h>
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+//******************************************************************************
+// Globals
+//******************************************************************************
+
+static pthread_mutex_t  g_mtx = PTHREAD_MUTEX_INITIALIZER;                      //!< Guards g_pvSnapshot.
+static void           * g_pvSnapshot;                                           //!< Mapped region, NULL if not mapped yet.
+
+//******************************************************************************
+//******************************************************************************
+//******************************************************************************
+
+void * _bsp_shared_snapshot (void)
+{
+  void  * pvMap;
+  int     iFd;
+
+  pthread_mutex_lock(&g_mtx);
+  if (!g_pvSnapshot) {
+    iFd = shm_open(MCC_SIM_SNAPSHOT_NAME, O_RDWR | O_CREAT, 0600);
+    if (iFd < 0) {
+      LOGE_FORMATTED("shm_open %s failed", MCC_SIM_SNAPSHOT_NAME);
+    } else if (ftruncate(iFd, MCC_SNAPSHOT_SIZE)) {
+      LOGE_FORMATTED("ftruncate %s failed", MCC_SIM_SNAPSHOT_NAME);
+    } else {
+      pvMap = mmap(NULL, MCC_SNAPSHOT_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, iFd, 0);
+      if (MAP_FAILED == pvMap) {
+        LOGE_FORMATTED("mmap %s failed", MCC_SIM_SNAPSHOT_NAME);
+      } else {
+        g_pvSnapshot = pvMap;
+      }
+    }
+    if (iFd >= 0) close(iFd);
+  }
+  pvMap = g_pvSnapshot;
+  pthread_mutex_unlock(&g_mtx);
+
+  return pvMap;
+}
+
+//******************************************************************************
+
+void _bsp_shared_snapshot_release (void)
+{
+  pthread_mutex_lock(&g_mtx);
+  if (g_pvSnapshot) {
+    ((volatile TMccAccelSnapshot*)g_pvSnapshot)->u32Magic = 0;                  // the object stays, the A5 keeps its mapping
+    munmap(g_pvSnapshot, MCC_SNAPSHOT_SIZE);
+    g_pvSnapshot = NULL;
+  }
+  pthread_mutex_unlock(&g_mtx);
+}
+
+//******************************************************************************
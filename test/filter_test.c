@@ -0,0 +1,418 @@
+/** ****************************************************************************
+ *
+ *  @file       filter_test.c
+ *  @brief      Host unit tests and per-sample cost benchmark of the filter chain.
+ *
+ *  Runs filter_run() against a double precision reference of every stage: the
+ *  Butterworth biquads designed with unquantized coefficients, the moving
+ *  average and the decimation. The average and the decimation are integer
+ *  and must match exactly; the biquads must stay within FILTER_TEST_BOUND
+ *  counts of the reference (the 0.5 count of the output rounding included)
+ *  and the full chain within FILTER_TEST_BOUND + 0.5, its average rounding
+ *  again. Splitting the input in chunks must not change a bit of the output.
+ *  Started with -b, it prints the errors measured and the cost per sample.
+ *
+ *  @copyright  Elnico Ltd. All rights reserved.
+ *
+ ******************************************************************************/
+/*
+ *  THIS SOFTWARE IS PROVIDED BY ELNICO "AS IS" AND ANY EXPRESSED OR
+ *  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ *  OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ *  IN NO EVENT SHALL ELNICO OR ITS CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ *  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ *  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ *  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ *  IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ *  THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************/
+
+#include "filter.h"
+
+#include "esl_utils.h"
+
+#include "test.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+//******************************************************************************
+// General Definitions
+//******************************************************************************
+
+#define FILTER_TEST_SAMPLES             (20000)                                 //!< Input samples of each configuration.
+#define FILTER_TEST_BOUND               (0.75)                                  //!< Largest error of the biquads against the reference [counts].
+#define FILTER_TEST_CHUNK               (32)                                    //!< Samples per filter_run() call, as a full FIFO readout.
+#define FILTER_TEST_BENCH_ROUNDS        (200)                                   //!< Passes over the input of each benchmark configuration.
+#define FILTER_TEST_PI                  (3.14159265358979323846)
+
+/** One configuration under test. */
+typedef struct t_filter_test_case_struct {
+  const char      * sName;                                                      //!< Description.
+  TMccAccelFilter   oSettings;                                                  //!< Stages.
+  uint32_t          u32PeriodUs;                                                //!< Output data period.
+} TFilterTestCase;
+
+/** Double precision biquad of the reference, a0 = 1. */
+typedef struct t_filter_test_biquad_struct {
+  double            adB[3];                                                     //!< b0, b1, b2.
+  double            adA[2];                                                     //!< a1, a2.
+  int               bPassDc;                                                    //!< Low-pass, the state starts at the first input.
+  double            aadState[3][4];                                             //!< x[n-1], x[n-2], y[n-1], y[n-2] per axis.
+} TFilterTestBiquad;
+
+//******************************************************************************
+// Globals
+//******************************************************************************
+
+static const TFilterTestCase g_aoCases[] = {                                    //!< Configurations checked and measured.
+  { "none",                        { 0,    0,    0,  0, { 0, 0 } }, 1250  },
+  { "low-pass 50 Hz @ 800 Hz",     { 0,    500,  0,  0, { 0, 0 } }, 1250  },
+  { "low-pass 5 Hz @ 800 Hz",      { 0,    50,   0,  0, { 0, 0 } }, 1250  },
+  { "low-pass 400 Hz @ 800 Hz",    { 0,    4000, 0,  0, { 0, 0 } }, 1250  },  // limited to FILTER_CUTOFF_MAX
+  { "high-pass 0.5 Hz @ 800 Hz",   { 50,   0,    0,  0, { 0, 0 } }, 1250  },
+  { "high-pass 10 Hz @ 100 Hz",    { 1000, 0,    0,  0, { 0, 0 } }, 10000 },
+  { "band 1-100 Hz @ 800 Hz",      { 100,  1000, 0,  0, { 0, 0 } }, 1250  },
+  { "average 16",                  { 0,    0,    16, 0, { 0, 0 } }, 1250  },
+  { "average 5, decimation 3",     { 0,    0,    5,  3, { 0, 0 } }, 1250  },
+  { "band 1-100 Hz, avg 8, dec 4", { 100,  1000, 8,  4, { 0, 0 } }, 1250  },
+};
+
+static int16_t  g_aai16Input[FILTER_TEST_SAMPLES][3];                           //!< Input of every configuration.
+static uint32_t g_au32TimeUs[FILTER_TEST_SAMPLES];                              //!< Times of g_aai16Input.
+
+//******************************************************************************
+// Functions declarations
+//******************************************************************************
+
+/** Fills g_aai16Input: gravity, two sines, a step and noise per axis. */
+static void filter_test_input (void);
+
+/** Designs a reference biquad as filter_design() does, unquantized.
+ * @param[out]  poBiquad      Stage to design.
+ * @param[in]   dCutoff       Cutoff relative to the sample rate.
+ * @param[in]   bHighPass     TRUE for a high-pass, FALSE for a low-pass. */
+static void filter_test_design (TFilterTestBiquad * poBiquad, double dCutoff, int bHighPass);
+
+/** Runs one input sample of one axis through a reference biquad.
+ * @param[in,out] poBiquad    Stage.
+ * @param[in]   iAxis         Axis (0 to 2).
+ * @param[in]   dX            Input [counts].
+ * @param[in]   bStart        TRUE for the first sample.
+ * @return      Output [counts]. */
+static double filter_test_biquad (TFilterTestBiquad * poBiquad, int iAxis, double dX, int bStart);
+
+/** Runs the reference chain over g_aai16Input.
+ * @param[in]   poCase        Configuration.
+ * @param[out]  paadOut       Outputs kept by the decimation, unrounded.
+ * @param[out]  paai16Out     Outputs kept, rounded as the chain does where
+ *                            only the integer stages are set.
+ * @return      Number of outputs kept. */
+static uint32_t filter_test_reference (const TFilterTestCase * poCase, double (* paadOut)[3], int16_t (* paai16Out)[3]);
+
+/** Runs filter_run() over g_aai16Input.
+ * @param[in]   poCase        Configuration.
+ * @param[out]  paai16Out     Outputs kept, room for FILTER_TEST_SAMPLES.
+ * @param[out]  pau32TimeUs   Their times.
+ * @param[in]   u32Seed       Chunks of 1 to 2 * FILTER_TEST_CHUNK samples,
+ *                            pseudo-random by the seed, 0 for one call.
+ * @return      Number of outputs kept. */
+static uint32_t filter_test_run (const TFilterTestCase * poCase, int16_t (* paai16Out)[3], uint32_t * pau32TimeUs, uint32_t u32Seed);
+
+static void filter_test_reset (void);
+static void filter_test_constant (void);
+static void filter_test_cases (int bPrint);
+static void filter_test_bench (void);
+
+//******************************************************************************
+//******************************************************************************
+//******************************************************************************
+
+int main (int argc, char * argv[])
+{
+  int bBench = test_benchRequested(argc, argv);
+
+  filter_test_input();
+  filter_test_reset();
+  filter_test_constant();
+  filter_test_cases(bBench);
+  if (bBench) filter_test_bench();
+  return test_summary("filter_test");
+}
+
+//******************************************************************************
+
+static void filter_test_input (void)
+{
+  static const double adGravity[3] = { 120.0, -310.0, 4096.0 };                 // the Z axis down, 4096 counts per g at +-2 g
+  uint32_t  u32Rand = 12345;
+  uint32_t  i;
+  int       iAxis;
+
+  for (i = 0; i < FILTER_TEST_SAMPLES; ++i) {
+    for (iAxis = 0; iAxis < 3; ++iAxis) {
+      double dT = i * 1.25e-3;                                                  // at 800 Hz
+      double dX = adGravity[iAxis]
+                + 3000.0 * sin(2.0 * FILTER_TEST_PI * (0.3 + iAxis) * dT)
+                + 1500.0 * sin(2.0 * FILTER_TEST_PI * (37.0 + 61.0 * iAxis) * dT + iAxis)
+                + ((i >= FILTER_TEST_SAMPLES / 2) ? 2500.0 : 0.0);
+
+      u32Rand = u32Rand * 1103515245u + 12345u;
+      dX += (double)((u32Rand >> 16) % 4001) - 2000.0;                          // +-2000 counts of noise
+      g_aai16Input[i][iAxis] = (int16_t)lrint(dX);
+    }
+    g_au32TimeUs[i] = i * 1250u;
+  }
+}
+
+//******************************************************************************
+
+static void filter_test_design (TFilterTestBiquad * poBiquad, double dCutoff, int bHighPass)
+{
+  double dW0    = 2.0 * FILTER_TEST_PI * MIN(dCutoff, FILTER_CUTOFF_MAX);
+  double dCos   = cos(dW0);
+  double dAlpha = sin(dW0) / sqrt(2.0);
+  double dA0    = 1.0 + dAlpha;
+  double dB0    = (bHighPass ? (1.0 + dCos) : (1.0 - dCos)) / 2.0 / dA0;
+
+  memset(poBiquad, 0, sizeof(*poBiquad));
+  poBiquad->adA[0]  = -2.0 * dCos / dA0;
+  poBiquad->adA[1]  = (1.0 - dAlpha) / dA0;
+  poBiquad->adB[0]  = dB0;
+  poBiquad->adB[1]  = bHighPass ? -2.0 * dB0 : 2.0 * dB0;
+  poBiquad->adB[2]  = dB0;
+  poBiquad->bPassDc = !bHighPass;
+}
+
+//******************************************************************************
+
+static double filter_test_biquad (TFilterTestBiquad * poBiquad, int iAxis, double dX, int bStart)
+{
+  double * pdState = poBiquad->aadState[iAxis];
+  double   dY;
+
+  if (bStart) {
+    pdState[0] = pdState[1] = dX;
+    pdState[2] = pdState[3] = poBiquad->bPassDc ? dX : 0.0;
+  }
+  dY = poBiquad->adB[0] * dX + poBiquad->adB[1] * pdState[0] + poBiquad->adB[2] * pdState[1]
+     - poBiquad->adA[0] * pdState[2] - poBiquad->adA[1] * pdState[3];
+  pdState[1] = pdState[0];
+  pdState[0] = dX;
+  pdState[3] = pdState[2];
+  pdState[2] = dY;
+  return dY;
+}
+
+//******************************************************************************
+
+static uint32_t filter_test_reference (const TFilterTestCase * poCase, double (* paadOut)[3], int16_t (* paai16Out)[3])
+{
+  static double     aadAverage[MCC_ACCEL_FILTER_MAX_AVERAGE][3];
+  TFilterTestBiquad oHighPass, oLowPass;
+  double            dRate = 1e6 / poCase->u32PeriodUs;
+  uint32_t          u32Average    = MAX(poCase->oSettings.u8Average, 1);
+  uint32_t          u32Decimation = MAX(poCase->oSettings.u8Decimation, 1);
+  uint32_t          u32Kept = 0;
+  uint32_t          i, j;
+  int               iAxis;
+
+  filter_test_design(&oHighPass, poCase->oSettings.u16HighPassCentiHz / 100.0 / dRate, TRUE);
+  filter_test_design(&oLowPass, poCase->oSettings.u16LowPassDeciHz / 10.0 / dRate, FALSE);
+  for (i = 0; i < FILTER_TEST_SAMPLES; ++i) {
+    for (iAxis = 0; iAxis < 3; ++iAxis) {
+      double dY = g_aai16Input[i][iAxis];
+      double dSum = 0.0;
+
+      if (poCase->oSettings.u16HighPassCentiHz) dY = filter_test_biquad(&oHighPass, iAxis, dY, 0 == i);
+      if (poCase->oSettings.u16LowPassDeciHz)   dY = filter_test_biquad(&oLowPass, iAxis, dY, 0 == i);
+      if (0 == i) {
+        for (j = 0; j < u32Average; ++j) aadAverage[j][iAxis] = dY;
+      }
+      aadAverage[i % u32Average][iAxis] = dY;
+      for (j = 0; j < u32Average; ++j) dSum += aadAverage[j][iAxis];
+
+      if (i % u32Decimation) continue;
+      paadOut[u32Kept][iAxis]   = dSum / u32Average;
+      paai16Out[u32Kept][iAxis] = (int16_t)round(dSum / u32Average);          // half away from zero
+    }
+    if (0 == i % u32Decimation) ++u32Kept;
+  }
+  return u32Kept;
+}
+
+//******************************************************************************
+
+static uint32_t filter_test_run (const TFilterTestCase * poCase, int16_t (* paai16Out)[3], uint32_t * pau32TimeUs, uint32_t u32Seed)
+{
+  TFilter   oFilter;
+  uint32_t  u32Done = 0, u32Kept = 0;
+
+  filter_setup(&oFilter, &poCase->oSettings, poCase->u32PeriodUs);
+  memcpy(paai16Out, g_aai16Input, sizeof(g_aai16Input));
+  memcpy(pau32TimeUs, g_au32TimeUs, sizeof(g_au32TimeUs));
+  while (u32Done < FILTER_TEST_SAMPLES) {
+    uint32_t u32Cnt = FILTER_TEST_SAMPLES - u32Done;
+    uint32_t u32Out, u32First;
+
+    if (u32Seed) {
+      u32Seed = u32Seed * 1103515245u + 12345u;
+      u32Cnt  = MIN(u32Cnt, (u32Seed >> 16) % (2 * FILTER_TEST_CHUNK) + 1);
+    }
+    u32Out = filter_run(&oFilter, &paai16Out[u32Done], &pau32TimeUs[u32Done], u32Cnt, &u32First);
+    memmove(&paai16Out[u32Kept], &paai16Out[u32Done], u32Out * sizeof(*paai16Out));
+    memmove(&pau32TimeUs[u32Kept], &pau32TimeUs[u32Done], u32Out * sizeof(*pau32TimeUs));
+    TEST_CHECK(!u32Out || (g_au32TimeUs[u32Done + u32First] == pau32TimeUs[u32Kept]),
+               "%s: first kept at %u, time %u", poCase->sName, u32Done + u32First, pau32TimeUs[u32Kept]);
+    u32Kept += u32Out;
+    u32Done += u32Cnt;
+  }
+  return u32Kept;
+}
+
+//******************************************************************************
+
+static void filter_test_reset (void)
+{
+  static const TMccAccelFilter oInvalid = { 0, 0, MCC_ACCEL_FILTER_MAX_AVERAGE + 1, 0, { 0, 0 } };
+  static const TMccAccelFilter oSettings = { 0, 0, 4, 3, { 0, 0 } };
+  TFilter   oFilter;
+  int16_t   aai16Data[8][3];
+  uint32_t  u32Out, u32First, i;
+
+  TEST_CHECK(!filter_setup(&oFilter, &oInvalid, 1250), "average above the maximum accepted");
+  TEST_CHECK(!filter_setup(&oFilter, &oSettings, 0), "zero period accepted");
+  TEST_CHECK(filter_setup(&oFilter, &oSettings, 1250) && filter_isActive(&oFilter), "setup failed");
+  TEST_CHECK(filter_maxInput(&oFilter, 2) == 6, "max input %u", filter_maxInput(&oFilter, 2));
+
+  // after 2 samples, 2 more are dropped by the decimation; a reset keeps the next one
+  memset(aai16Data, 0, sizeof(aai16Data));
+  u32Out = filter_run(&oFilter, aai16Data, NULL, 2, &u32First);
+  TEST_CHECK((1 == u32Out) && (0 == u32First), "kept %u from %u", u32Out, u32First);
+  TEST_CHECK(filter_maxInput(&oFilter, 1) == 4, "max input after 2 samples %u", filter_maxInput(&oFilter, 1));
+  filter_reset(&oFilter);
+  for (i = 0; i < 8; ++i) aai16Data[i][0] = aai16Data[i][1] = aai16Data[i][2] = (int16_t)(100 * i - 300);
+  u32Out = filter_run(&oFilter, aai16Data, NULL, 8, &u32First);
+  TEST_CHECK((3 == u32Out) && (0 == u32First), "kept %u from %u after reset", u32Out, u32First);
+  TEST_CHECK((-300 == aai16Data[0][0]) && (-150 == aai16Data[1][1]) && (150 == aai16Data[2][2]),
+             "average after reset %d %d %d", aai16Data[0][0], aai16Data[1][1], aai16Data[2][2]);
+}
+
+//******************************************************************************
+
+static void filter_test_constant (void)
+{
+  static const int16_t ai16Levels[] = { -32768, -4096, -1, 0, 1, 4096, 32767 };
+  uint32_t  i, j, k;
+
+  for (i = 0; i < ARRAY_SIZE(g_aoCases); ++i) {
+    const TFilterTestCase * poCase = &g_aoCases[i];
+    int16_t                 i16Expected;
+    int                     bOk = 1;
+
+    for (j = 0; j < ARRAY_SIZE(ai16Levels); ++j) {
+      TFilter   oFilter;
+      int16_t   aai16Data[200][3];
+      uint32_t  u32Out, u32First;
+
+      filter_setup(&oFilter, &poCase->oSettings, poCase->u32PeriodUs);
+      for (k = 0; k < ARRAY_SIZE(aai16Data); ++k) {
+        aai16Data[k][0] = aai16Data[k][1] = aai16Data[k][2] = ai16Levels[j];
+      }
+      u32Out = filter_run(&oFilter, aai16Data, NULL, ARRAY_SIZE(aai16Data), &u32First);
+      i16Expected = poCase->oSettings.u16HighPassCentiHz ? 0 : ai16Levels[j];
+      for (k = 0; k < u32Out; ++k) {
+        bOk &= (aai16Data[k][0] == i16Expected) && (aai16Data[k][1] == i16Expected) && (aai16Data[k][2] == i16Expected);
+      }
+    }
+    TEST_CHECK(bOk, "%s: constant input not settled from the first sample", poCase->sName);
+  }
+}
+
+//******************************************************************************
+
+static void filter_test_cases (int bPrint)
+{
+  static double   aadReference[FILTER_TEST_SAMPLES][3];
+  static int16_t  aai16Reference[FILTER_TEST_SAMPLES][3];
+  static int16_t  aai16Out[FILTER_TEST_SAMPLES][3];
+  static int16_t  aai16Split[FILTER_TEST_SAMPLES][3];
+  static uint32_t au32TimeUs[FILTER_TEST_SAMPLES];
+  uint32_t        i, j;
+  int             iAxis;
+
+  if (bPrint) printf("%-28s  max error [counts]  rms error [counts]  bound [counts]\n", "configuration");
+  for (i = 0; i < ARRAY_SIZE(g_aoCases); ++i) {
+    const TFilterTestCase * poCase = &g_aoCases[i];
+    int       bBiquad = poCase->oSettings.u16HighPassCentiHz || poCase->oSettings.u16LowPassDeciHz;
+    double    dBound  = !bBiquad ? 0.0 : FILTER_TEST_BOUND + ((poCase->oSettings.u8Average > 1) ? 0.5 : 0.0);
+    double    dMax = 0.0, dSquares = 0.0;
+    uint32_t  u32Ref, u32Out, u32Split;
+    int       bExact = 1, bTimes = 1;
+
+    u32Ref = filter_test_reference(poCase, aadReference, aai16Reference);
+    u32Out = filter_test_run(poCase, aai16Out, au32TimeUs, 0);
+    TEST_CHECK(u32Out == u32Ref, "%s: %u samples kept, %u expected", poCase->sName, u32Out, u32Ref);
+    for (j = 0; j < MIN(u32Out, u32Ref); ++j) {
+      for (iAxis = 0; iAxis < 3; ++iAxis) {
+        double dErr = fabs(aai16Out[j][iAxis] - aadReference[j][iAxis]);
+
+        dMax      = MAX(dMax, dErr);
+        dSquares += dErr * dErr;
+        bExact   &= (aai16Out[j][iAxis] == aai16Reference[j][iAxis]);
+      }
+      bTimes &= (au32TimeUs[j] == g_au32TimeUs[j * MAX(poCase->oSettings.u8Decimation, 1)]);
+    }
+    if (bBiquad) {
+      TEST_CHECK(dMax <= dBound, "%s: error %.3f above %.3f counts", poCase->sName, dMax, dBound);
+    } else {
+      TEST_CHECK(bExact, "%s: not exact", poCase->sName);
+    }
+    TEST_CHECK(bTimes, "%s: times not kept with their samples", poCase->sName);
+
+    u32Split = filter_test_run(poCase, aai16Split, au32TimeUs, 1 + i);
+    TEST_CHECK((u32Split == u32Out) && (0 == memcmp(aai16Split, aai16Out, u32Out * sizeof(*aai16Out))),
+               "%s: the output depends on the chunks", poCase->sName);
+
+    if (bPrint) {
+      printf("%-28s  %18.3f  %18.3f  ", poCase->sName, dMax, sqrt(dSquares / (3.0 * MAX(u32Out, 1))));
+      if (bBiquad) printf("%14.2f\n", dBound); else printf("%14s\n", "exact");
+    }
+  }
+}
+
+//******************************************************************************
+
+static void filter_test_bench (void)
+{
+  static int16_t aai16Work[FILTER_TEST_CHUNK][3];
+  uint32_t       i, j, u32Round;
+
+  printf("\nfilter_run, %u samples of 3 axes per call (host CPU, not the Cortex-M4)\n", FILTER_TEST_CHUNK);
+  printf("%-28s  [ns/sample]  [cycles/sample]\n", "configuration");
+  for (i = 0; i < ARRAY_SIZE(g_aoCases); ++i) {
+    const TFilterTestCase * poCase = &g_aoCases[i];
+    TFilter   oFilter;
+    uint64_t  u64Ns = 0, u64Cycles = 0, u64Samples = 0;
+    uint32_t  u32First;
+
+    filter_setup(&oFilter, &poCase->oSettings, poCase->u32PeriodUs);
+    for (u32Round = 0; u32Round < FILTER_TEST_BENCH_ROUNDS; ++u32Round) {
+      for (j = 0; j + FILTER_TEST_CHUNK <= FILTER_TEST_SAMPLES; j += FILTER_TEST_CHUNK) {
+        uint64_t u64Start, u64StartCycles;
+
+        memcpy(aai16Work, g_aai16Input[j], sizeof(aai16Work));
+        u64Start       = test_nowNs();
+        u64StartCycles = test_cycles();
+        filter_run(&oFilter, aai16Work, NULL, FILTER_TEST_CHUNK, &u32First);
+        u64Cycles += test_cycles() - u64StartCycles;
+        u64Ns     += test_nowNs() - u64Start;
+        u64Samples += FILTER_TEST_CHUNK;
+      }
+    }
+    printf("%-28s  %11.1f  %15.1f\n", poCase->sName, (double)u64Ns / u64Samples, (double)u64Cycles / u64Samples);
+  }
+}
@@ -0,0 +1,15 @@
+# Host unit tests and per-sample cost benchmark of mqx/filter.c (see filter_test.c)
+TEMPLATE = app
+TARGET = filter_test
+CONFIG += console
+CONFIG -= qt \
+    app_bundle
+QMAKE_CFLAGS += -std=gnu99
+INCLUDEPATH += ../sim/include \
+    ../mqx \
+    ../mqx/libesl \
+    ../common
+HEADERS += test.h
+SOURCES += ../mqx/filter.c \
+    filter_test.c
+LIBS += -lm
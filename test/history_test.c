@@ -0,0 +1,378 @@
+/** ****************************************************************************
+ *
+ *  @file       history_test.c
+ *  @brief      Host unit tests and contention benchmark of the sample history.
+ *
+ *  Checks history_window() (loss, restart and the 32-bit timestamp wrap), the
+ *  ring wrap of history_push()/history_get() and, with one writer and several
+ *  reader threads, that no reader ever gets a torn sample and that every
+ *  sample is either read or reported lost. Started with -b, it measures the
+ *  cost of history_push() and history_get() with 0 to 4 readers contending.
+ *
+ *  @copyright  Elnico Ltd. All rights reserved.
+ *
+ ******************************************************************************/
+/*
+ *  THIS SOFTWARE IS PROVIDED BY ELNICO "AS IS" AND ANY EXPRESSED OR
+ *  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ *  OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ *  IN NO EVENT SHALL ELNICO OR ITS CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ *  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ *  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ *  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ *  IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ *  THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************/
+
+#include "history.h"
+
+#include "esl_utils.h"
+
+#include "test.h"
+
+#include <pthread.h>
+#include <unistd.h>
+
+//******************************************************************************
+// General Definitions
+//******************************************************************************
+
+#define HISTORY_TEST_READERS            (3)                                     //!< Readers of the torn sample check.
+#define HISTORY_TEST_SAMPLES            (2000000u)                              //!< Samples pushed by the torn sample check.
+#define HISTORY_TEST_READ_MAX           (64)                                    //!< Samples requested by a reader at once (as MCC_ACCEL_STREAM_MAX).
+#define HISTORY_TEST_READERS_MAX        (4)                                     //!< Most readers of the benchmark.
+#define HISTORY_TEST_BENCH_SAMPLES      (10000000u)                             //!< Samples pushed by each benchmark run.
+
+/** One reader thread of the contention runs. */
+typedef struct t_history_test_reader_struct {
+  pthread_t     oThread;                                                        //!< The thread.
+  uint32_t      u32Read;                                                        //!< Samples read.
+  uint32_t      u32Lost;                                                        //!< Samples reported lost by history_window().
+  uint32_t      u32Failed;                                                      //!< Samples overwritten while being read (history_get() failed).
+  uint32_t      u32Torn;                                                        //!< Samples read inconsistent, must stay 0.
+  uint32_t      u32Disorder;                                                    //!< Samples read out of order, must stay 0.
+  uint64_t      u64Ns;                                                          //!< CPU time spent in history_get().
+} THistoryTestReader;
+
+/** Result of one contention run. */
+typedef struct t_history_test_run_struct {
+  uint32_t            u32Readers;                                               //!< Number of readers.
+  uint32_t            u32Samples;                                               //!< Samples pushed.
+  uint64_t            u64WriterNs;                                              //!< CPU time of the writer.
+  THistoryTestReader  aoReaders[HISTORY_TEST_READERS_MAX];                      //!< The readers.
+} THistoryTestRun;
+
+//******************************************************************************
+// Globals
+//******************************************************************************
+
+static THistory         g_oHistory;                                             //!< History under test.
+static volatile int     g_bWriterDone;                                          //!< Set once the writer pushed its last sample.
+
+//******************************************************************************
+// Functions declarations
+//******************************************************************************
+
+/** Fills a sample whose every field is derived from its timestamp, so that
+ *  a sample mixed from two writes does not pass history_test_valid().
+ * @param[out]  poDst         Sample.
+ * @param[in]   u32Timestamp  Its timestamp. */
+static void history_test_sample (TAccelData * poDst, uint32_t u32Timestamp);
+
+/** Tells whether a sample matches its timestamp (see history_test_sample()).
+ * @param[in]   poSample      Sample read. */
+static int history_test_valid (const TAccelData * poSample);
+
+/** Initializes g_oHistory with the sample of given timestamp.
+ * @param[in]   u32First      Timestamp of the first sample. */
+static void history_test_init (uint32_t u32First);
+
+/** Pushes the samples following the newest one, in chunks of 1 to 32 as the
+ *  FIFO readouts of accel_task.
+ * @param[in]   u32Cnt        Number of samples.
+ * @return      CPU time spent, including making the samples [ns]. */
+static uint64_t history_test_push (uint32_t u32Cnt);
+
+/** Reader thread of the contention runs, reads as the MCC streaming does.
+ * @param[in]   pvReader      THistoryTestReader of the thread. */
+static void * history_test_reader (void * pvReader);
+
+/** Runs one writer against given number of readers.
+ * @param[in,out] poRun       u32Readers and u32Samples set, results. */
+static void history_test_contend (THistoryTestRun * poRun);
+
+static void history_test_window (void);
+static void history_test_ring (void);
+static void history_test_torn (void);
+static void history_test_bench (void);
+
+//******************************************************************************
+//******************************************************************************
+//******************************************************************************
+
+int main (int argc, char * argv[])
+{
+  history_test_window();
+  history_test_ring();
+  history_test_torn();
+  if (test_benchRequested(argc, argv)) history_test_bench();
+  return test_summary("history_test");
+}
+
+//******************************************************************************
+
+static void history_test_sample (TAccelData * poDst, uint32_t u32Timestamp)
+{
+  int i;
+
+  poDst->u32Timestamp = u32Timestamp;
+  for (i = 0; i < 3; ++i) {
+    poDst->afData[i]  = (float)((u32Timestamp + i) & 0xFFFF);                   // exact in a float
+    poDst->ai16Raw[i] = (int16_t)(u32Timestamp * 7 + i);
+  }
+  poDst->u32TimeUs = u32Timestamp * 1250u;
+}
+
+//******************************************************************************
+
+static int history_test_valid (const TAccelData * poSample)
+{
+  TAccelData  oExpected;
+  int         i;
+
+  history_test_sample(&oExpected, poSample->u32Timestamp);
+  for (i = 0; i < 3; ++i) {
+    if (oExpected.afData[i]  != poSample->afData[i])  return 0;
+    if (oExpected.ai16Raw[i] != poSample->ai16Raw[i]) return 0;
+  }
+  return oExpected.u32TimeUs == poSample->u32TimeUs;
+}
+
+//******************************************************************************
+
+static void history_test_init (uint32_t u32First)
+{
+  TAccelData oFirst;
+
+  history_test_sample(&oFirst, u32First);
+  history_init(&g_oHistory, &oFirst);
+}
+
+//******************************************************************************
+
+static uint64_t history_test_push (uint32_t u32Cnt)
+{
+  TAccelData  aoChunk[32];
+  uint32_t    u32Ts = history_newest(&g_oHistory);
+  uint32_t    u32Chunk = 1;
+  uint64_t    u64Start = test_threadNs();
+  uint32_t    i;
+
+  while (u32Cnt) {
+    u32Chunk = MIN(u32Chunk % 32 + 1, u32Cnt);                                  // 2, 3, ... 32, 1, 2, ... in turn
+    for (i = 0; i < u32Chunk; ++i) {
+      history_test_sample(&aoChunk[i], ++u32Ts);
+    }
+    history_push(&g_oHistory, aoChunk, u32Chunk);
+    u32Cnt -= u32Chunk;
+  }
+  return test_threadNs() - u64Start;
+}
+
+//******************************************************************************
+
+static void * history_test_reader (void * pvReader)
+{
+  THistoryTestReader  * poReader = (THistoryTestReader*)pvReader;
+  uint32_t              u32Since = 0;
+  TAccelData            oSample;
+
+  for (;;) {
+    int       bDone = g_bWriterDone;
+    uint32_t  u32Newest, u32First, u32Cnt, u32Lost, i;
+    uint64_t  u64Start;
+
+    __sync_synchronize();
+    u32Newest = history_newest(&g_oHistory);
+    if (bDone && (u32Since == u32Newest)) break;
+    u32First = history_window(u32Newest, HISTORY_TEST_READ_MAX, u32Since, &u32Cnt, &u32Lost);
+    poReader->u32Lost += u32Lost;
+    if (!u32Cnt) continue;
+    u64Start = test_threadNs();
+    for (i = 0; i < u32Cnt; ++i) {
+      if (!history_get(&g_oHistory, u32First + i, &oSample)) {
+        ++poReader->u32Failed;
+        continue;
+      }
+      if (!history_test_valid(&oSample)) ++poReader->u32Torn;
+      if (oSample.u32Timestamp != u32First + i) ++poReader->u32Disorder;
+      ++poReader->u32Read;
+    }
+    poReader->u64Ns += test_threadNs() - u64Start;
+    u32Since = u32First + u32Cnt - 1;
+  }
+  return NULL;
+}
+
+//******************************************************************************
+
+static void history_test_contend (THistoryTestRun * poRun)
+{
+  uint32_t i;
+
+  history_test_init(0);
+  g_bWriterDone = 0;
+  memset(poRun->aoReaders, 0, sizeof(poRun->aoReaders));
+  for (i = 0; i < poRun->u32Readers; ++i) {
+    pthread_create(&poRun->aoReaders[i].oThread, NULL, history_test_reader, &poRun->aoReaders[i]);
+  }
+  poRun->u64WriterNs = history_test_push(poRun->u32Samples);
+  __sync_synchronize();
+  g_bWriterDone = 1;
+  for (i = 0; i < poRun->u32Readers; ++i) {
+    pthread_join(poRun->aoReaders[i].oThread, NULL);
+  }
+}
+
+//******************************************************************************
+
+static void history_test_window (void)
+{
+  uint32_t u32First, u32Cnt, u32Lost;
+
+  // first lap: timestamp 0 is the initial value, never read
+  u32First = history_window(10, 100, 0, &u32Cnt, &u32Lost);
+  TEST_CHECK((1 == u32First) && (10 == u32Cnt) && (0 == u32Lost), "fresh: %u %u %u", u32First, u32Cnt, u32Lost);
+  u32First = history_window(10, 4, 0, &u32Cnt, &u32Lost);
+  TEST_CHECK((1 == u32First) && (4 == u32Cnt) && (0 == u32Lost), "max count: %u %u %u", u32First, u32Cnt, u32Lost);
+  u32First = history_window(HISTORY_SIZE + 10, 1000, 0, &u32Cnt, &u32Lost);
+  TEST_CHECK((11 == u32First) && (HISTORY_SIZE == u32Cnt) && (10 == u32Lost), "first lap loss: %u %u %u", u32First, u32Cnt, u32Lost);
+
+  // up to date
+  u32First = history_window(50, 100, 50, &u32Cnt, &u32Lost);
+  TEST_CHECK((51 == u32First) && (0 == u32Cnt) && (0 == u32Lost), "up to date: %u %u %u", u32First, u32Cnt, u32Lost);
+
+  // loss: only the last HISTORY_SIZE samples are left
+  u32First = history_window(1000, 1000, 100, &u32Cnt, &u32Lost);
+  TEST_CHECK((1000 - HISTORY_SIZE + 1 == u32First) && (HISTORY_SIZE == u32Cnt) && (900 - HISTORY_SIZE == u32Lost),
+             "loss: %u %u %u", u32First, u32Cnt, u32Lost);
+  u32First = history_window(1000, 1000, 1000 - HISTORY_SIZE, &u32Cnt, &u32Lost);
+  TEST_CHECK((1000 - HISTORY_SIZE + 1 == u32First) && (HISTORY_SIZE == u32Cnt) && (0 == u32Lost),
+             "no loss at the edge: %u %u %u", u32First, u32Cnt, u32Lost);
+
+  // restart: the reader is ahead, everything available is sent, nothing lost
+  u32First = history_window(20, 100, 5000, &u32Cnt, &u32Lost);
+  TEST_CHECK((1 == u32First) && (20 == u32Cnt) && (0 == u32Lost), "restart: %u %u %u", u32First, u32Cnt, u32Lost);
+  u32First = history_window(3000, 1000, 5000, &u32Cnt, &u32Lost);
+  TEST_CHECK((3000 - HISTORY_SIZE + 1 == u32First) && (HISTORY_SIZE == u32Cnt) && (0 == u32Lost),
+             "late restart: %u %u %u", u32First, u32Cnt, u32Lost);
+
+  // 32-bit timestamp wrap
+  u32First = history_window(5, 100, 0xFFFFFFF0u, &u32Cnt, &u32Lost);
+  TEST_CHECK((0xFFFFFFF1u == u32First) && (21 == u32Cnt) && (0 == u32Lost), "wrap: %u %u %u", u32First, u32Cnt, u32Lost);
+  u32First = history_window(300, 1000, 0xFFFFFF00u, &u32Cnt, &u32Lost);
+  TEST_CHECK((300 - HISTORY_SIZE + 1 == u32First) && (HISTORY_SIZE == u32Cnt) && (300 == u32Lost),
+             "wrap loss: %u %u %u", u32First, u32Cnt, u32Lost);
+  u32First = history_window(0xFFFFFFFFu, 100, 0xFFFFFFF0u, &u32Cnt, &u32Lost);
+  TEST_CHECK((0xFFFFFFF1u == u32First) && (15 == u32Cnt) && (0 == u32Lost), "before wrap: %u %u %u", u32First, u32Cnt, u32Lost);
+}
+
+//******************************************************************************
+
+static void history_test_ring (void)
+{
+  static const uint32_t au32First[] = { 0, 0xFFFFFF80u };                       // from the boot, across the 32-bit wrap
+  TAccelData  oSample;
+  uint32_t    u32Newest, u32Since, u32First, u32Cnt, u32Lost, i, j;
+  int         bOk;
+
+  for (j = 0; j < ARRAY_SIZE(au32First); ++j) {
+    history_test_init(au32First[j]);
+    u32Since = au32First[j];
+    history_test_push(100);
+    u32Newest = history_newest(&g_oHistory);
+    TEST_CHECK(au32First[j] + 100 == u32Newest, "newest %u", u32Newest);
+
+    history_test_push(3 * HISTORY_SIZE + 17);
+    u32Newest = history_newest(&g_oHistory);
+    TEST_CHECK(au32First[j] + 100 + 3 * HISTORY_SIZE + 17 == u32Newest, "newest %u", u32Newest);
+
+    // the last HISTORY_SIZE samples are there, the older ones are gone
+    bOk = 1;
+    for (i = 0; i < HISTORY_SIZE; ++i) {
+      bOk &= history_get(&g_oHistory, u32Newest - i, &oSample) && history_test_valid(&oSample)
+          && (oSample.u32Timestamp == u32Newest - i);
+    }
+    TEST_CHECK(bOk, "ring from %u: the last samples not read back", au32First[j]);
+    for (i = HISTORY_SIZE; i < 2 * HISTORY_SIZE; ++i) {
+      bOk &= !history_get(&g_oHistory, u32Newest - i, &oSample);
+    }
+    TEST_CHECK(bOk, "ring from %u: overwritten samples read back", au32First[j]);
+    bOk = !history_get(&g_oHistory, u32Newest + 1, &oSample);
+    TEST_CHECK(bOk, "ring from %u: future sample read", au32First[j]);
+    g_oHistory.aoSlots[HISTORY_IDX(u32Newest)].u32Seq = u32Newest - 1;           // as history_push() while writing the slot
+    bOk = !history_get(&g_oHistory, u32Newest, &oSample);
+    g_oHistory.aoSlots[HISTORY_IDX(u32Newest)].u32Seq = u32Newest;
+    TEST_CHECK(bOk, "ring from %u: sample read while written", au32First[j]);
+
+    // a reader at the start lost all but the last HISTORY_SIZE samples
+    u32First = history_window(u32Newest, 1000, u32Since, &u32Cnt, &u32Lost);
+    TEST_CHECK((u32Newest - HISTORY_SIZE + 1 == u32First) && (HISTORY_SIZE == u32Cnt) && (u32Newest - u32Since - HISTORY_SIZE == u32Lost),
+               "ring from %u: window %u %u %u", au32First[j], u32First, u32Cnt, u32Lost);
+  }
+}
+
+//******************************************************************************
+
+static void history_test_torn (void)
+{
+  THistoryTestRun oRun;
+  uint32_t        i;
+
+  oRun.u32Readers = HISTORY_TEST_READERS;
+  oRun.u32Samples = HISTORY_TEST_SAMPLES;
+  history_test_contend(&oRun);
+  for (i = 0; i < oRun.u32Readers; ++i) {
+    const THistoryTestReader * poReader = &oRun.aoReaders[i];
+
+    TEST_CHECK(0 == poReader->u32Torn, "reader %u: %u torn samples", i, poReader->u32Torn);
+    TEST_CHECK(0 == poReader->u32Disorder, "reader %u: %u samples out of order", i, poReader->u32Disorder);
+    TEST_CHECK(poReader->u32Read + poReader->u32Lost + poReader->u32Failed == oRun.u32Samples,
+               "reader %u: %u read + %u lost + %u failed != %u", i,
+               poReader->u32Read, poReader->u32Lost, poReader->u32Failed, oRun.u32Samples);
+  }
+}
+
+//******************************************************************************
+
+static void history_test_bench (void)
+{
+  THistoryTestRun oRun;
+  uint32_t        u32Readers, i;
+
+  printf("history_push/history_get, %u samples per run, %ld CPUs, thread CPU time\n",
+         HISTORY_TEST_BENCH_SAMPLES, sysconf(_SC_NPROCESSORS_ONLN));
+  printf("readers  writer [ns/sample]  get [ns/sample]  read [%%]  lost [%%]  failed [%%]\n");
+  for (u32Readers = 0; u32Readers <= HISTORY_TEST_READERS_MAX; ++u32Readers) {
+    uint64_t u64Read = 0, u64Lost = 0, u64Failed = 0, u64Ns = 0;
+    double   dTotal;
+
+    oRun.u32Readers = u32Readers;
+    oRun.u32Samples = HISTORY_TEST_BENCH_SAMPLES;
+    history_test_contend(&oRun);
+    for (i = 0; i < u32Readers; ++i) {
+      u64Read   += oRun.aoReaders[i].u32Read;
+      u64Lost   += oRun.aoReaders[i].u32Lost;
+      u64Failed += oRun.aoReaders[i].u32Failed;
+      u64Ns     += oRun.aoReaders[i].u64Ns;
+    }
+    dTotal = (double)oRun.u32Samples * (u32Readers ? u32Readers : 1);
+    printf("%7u  %19.1f  %15.1f  %8.1f  %8.1f  %10.2f\n", u32Readers,
+           (double)oRun.u64WriterNs / oRun.u32Samples,
+           u64Read ? (double)u64Ns / u64Read : 0.0,
+           100.0 * u64Read / dTotal, 100.0 * u64Lost / dTotal, 100.0 * u64Failed / dTotal);
+  }
+}
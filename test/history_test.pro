@@ -0,0 +1,15 @@
+# Host unit tests and contention benchmark of mqx/history.c (see history_test.c)
+TEMPLATE = app
+TARGET = history_test
+CONFIG += console
+CONFIG -= qt \
+    app_bundle
+QMAKE_CFLAGS += -std=gnu99
+INCLUDEPATH += ../sim/include \
+    ../mqx \
+    ../mqx/libesl \
+    ../common
+HEADERS += test.h
+SOURCES += ../mqx/history.c \
+    history_test.c
+LIBS += -lpthread
@@ -0,0 +1,118 @@
+/** ****************************************************************************
+ *
+ *  @file       test.h
+ *  @brief      Minimal helpers of the host unit tests and benchmarks.
+ *
+ *  The tests build the portable M4 modules (mqx/history.c, mqx/filter.c) on
+ *  a Linux host against the MQX stubs of the simulator (sim/include). Each
+ *  test program prints the failed checks, returns nonzero if any failed and
+ *  runs its benchmarks when started with -b.
+ *
+ *  @copyright  Elnico Ltd. All rights reserved.
+ *
+ ******************************************************************************/
+/*
+ *  THIS SOFTWARE IS PROVIDED BY ELNICO "AS IS" AND ANY EXPRESSED OR
+ *  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ *  OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ *  IN NO EVENT SHALL ELNICO OR ITS CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ *  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ *  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ *  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ *  IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ *  THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************/
+
+#ifndef TEST_H_582910357204957103957203
+#define TEST_H_582910357204957103957203
+//******************************************************************************
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+//******************************************************************************
+// General Definitions
+//******************************************************************************
+
+/** @def TEST_CHECK
+ * @brief Counts and reports a failed check, the test goes on. */
+#define TEST_CHECK(cond, ...)                                                   \
+  do {                                                                          \
+    ++g_u32TestChecks;                                                          \
+    if (!(cond)) {                                                              \
+      ++g_u32TestFailures;                                                      \
+      printf("FAIL %s:%d: ", __FILE__, __LINE__);                               \
+      printf(__VA_ARGS__);                                                      \
+      printf("\n");                                                             \
+    }                                                                           \
+  } while (0)
+
+//******************************************************************************
+// Globals
+//******************************************************************************
+
+static uint32_t g_u32TestChecks   = 0;                                          //!< Number of TEST_CHECK evaluated.
+static uint32_t g_u32TestFailures = 0;                                          //!< Number of TEST_CHECK failed.
+
+//******************************************************************************
+// Functions
+//******************************************************************************
+
+/** Returns the monotonic time in nanoseconds. */
+static inline uint64_t test_nowNs (void)
+{
+  struct timespec oNow;
+
+  clock_gettime(CLOCK_MONOTONIC, &oNow);
+  return (uint64_t)oNow.tv_sec * 1000000000u + (uint64_t)oNow.tv_nsec;
+}
+
+/** Returns the CPU time of the calling thread in nanoseconds, the time it was
+ *  preempted for is not counted. */
+static inline uint64_t test_threadNs (void)
+{
+  struct timespec oNow;
+
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &oNow);
+  return (uint64_t)oNow.tv_sec * 1000000000u + (uint64_t)oNow.tv_nsec;
+}
+
+/** Returns the CPU time stamp counter, 0 where there is none. */
+static inline uint64_t test_cycles (void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+  uint32_t u32Lo, u32Hi;
+
+  __asm__ __volatile__ ("rdtsc" : "=a" (u32Lo), "=d" (u32Hi));
+  return ((uint64_t)u32Hi << 32) | u32Lo;
+#else
+  return 0;
+#endif
+}
+
+/** Tells whether the program should run its benchmarks (-b given). */
+static inline int test_benchRequested (int argc, char * argv[])
+{
+  int i;
+
+  for (i = 1; i < argc; ++i) {
+    if (0 == strcmp(argv[i], "-b")) return 1;
+  }
+  return 0;
+}
+
+/** Prints the summary of the checks.
+ * @param[in]   sName       Name of the test program.
+ * @return      Exit code of the test program. */
+static inline int test_summary (const char * sName)
+{
+  printf("%s: %u checks, %u failed\n", sName, g_u32TestChecks, g_u32TestFailures);
+  return g_u32TestFailures ? 1 : 0;
+}
+
+//******************************************************************************
+#endif // TEST_H_582910357204957103957203 //